@@ -330,6 +330,8 @@
         'prefs/base_prefs_export.h',
         'prefs/default_pref_store.cc',
         'prefs/default_pref_store.h',
+        'prefs/json_pref_index.cc',
+        'prefs/json_pref_index.h',
         'prefs/json_pref_store.cc',
         'prefs/json_pref_store.h',
         'prefs/overlay_user_pref_store.cc',
@@ -499,6 +501,7 @@
         'ios/crb_protocol_observers_unittest.mm',
         'ios/device_util_unittest.mm',
         'ios/weak_nsobject_unittest.mm',
+        'json/json_document_unittest.cc',
         'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
         'json/json_value_converter_unittest.cc',
@@ -535,6 +538,7 @@
         'memory/singleton_unittest.cc',
         'memory/weak_ptr_unittest.cc',
         'memory/weak_ptr_unittest.nc',
+        'message_loop/incoming_task_queue_unittest.cc',
         'message_loop/message_loop_task_runner_unittest.cc',
         'message_loop/message_loop_unittest.cc',
         'message_loop/message_pump_glib_unittest.cc',
@@ -547,8 +551,11 @@
         'metrics/histogram_macros_unittest.cc',
         'metrics/histogram_snapshot_manager_unittest.cc',
         'metrics/histogram_unittest.cc',
+        'metrics/persistent_histogram_allocator_unittest.cc',
+        'metrics/persistent_memory_allocator_unittest.cc',
         'metrics/sample_map_unittest.cc',
         'metrics/sample_vector_unittest.cc',
+        'metrics/sharded_sample_vector_unittest.cc',
         'metrics/sparse_histogram_unittest.cc',
         'metrics/statistics_recorder_unittest.cc',
         'move_unittest.cc',
@@ -561,6 +568,7 @@
         'posix/unix_domain_socket_linux_unittest.cc',
         'power_monitor/power_monitor_unittest.cc',
         'prefs/default_pref_store_unittest.cc',
+        'prefs/json_pref_index_unittest.cc',
         'prefs/json_pref_store_unittest.cc',
         'prefs/mock_pref_change_callback.h',
         'prefs/overlay_user_pref_store_unittest.cc',
@@ -839,13 +847,19 @@
       'type': '<(gtest_target_type)',
       'dependencies': [
         'base',
+        'base_prefs',
         'test_support_base',
         '../testing/gtest.gyp:gtest',
       ],
       'sources': [
+        'json/json_reader_perftest.cc',
+        'json/json_string_perftest.cc',
         'message_loop/message_pump_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'prefs/json_pref_store_perftest.cc',
         'test/run_all_unittests.cc',
         'threading/thread_perftest.cc',
+        'trace_event/trace_event_perftest.cc',
         '../testing/perf/perf_test.cc'
       ],
       'conditions': [
@@ -959,6 +973,8 @@
         'test/scoped_locale.h',
         'test/scoped_path_override.cc',
         'test/scoped_path_override.h',
+        'test/scoped_peak_memory_delta.cc',
+        'test/scoped_peak_memory_delta.h',
         'test/sequenced_task_runner_test_template.cc',
         'test/sequenced_task_runner_test_template.h',
         'test/sequenced_worker_pool_owner.cc',
@@ -30,6 +30,8 @@ namespace {
 
 const int kDefaultCommitIntervalMs = 10000;
 
+const FilePath::CharType kJournalExtension[] = FILE_PATH_LITERAL("journal");
+
 // This enum is used to define the buckets for an enumerated UMA histogram.
 // Hence,
 //   (a) existing enumerated constants should never be deleted or reordered, and
@@ -57,8 +59,26 @@ bool WriteScopedStringToFileAtomically(const FilePath& path,
   return ImportantFileWriter::WriteFileAtomically(path, *data);
 }
 
+// Same as above in journal mode, where |data| replaces the journal too.
+bool WriteScopedStringToFileAtomicallyAndDeleteJournal(
+    const FilePath& path,
+    scoped_ptr<std::string> data) {
+  return ImportantFileWriter::WriteFileAtomically(path, *data) &&
+         DeleteFile(ImportantFileWriter::GetJournalPath(path), false);
+}
+
+// Helper function to call AppendToJournal() with a scoped_ptr<std::string>.
+bool AppendScopedStringToJournal(const FilePath& path,
+                                 scoped_ptr<std::string> record) {
+  return ImportantFileWriter::AppendToJournal(path, *record);
+}
+
 }  // namespace
 
+bool ImportantFileWriter::DataSerializer::SerializeDelta(std::string* delta) {
+  return false;
+}
+
 // static
 bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
                                               const std::string& data) {
@@ -120,6 +140,62 @@ bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
   return true;
 }
 
+// static
+FilePath ImportantFileWriter::GetJournalPath(const FilePath& path) {
+  return path.AddExtension(kJournalExtension);
+}
+
+// static
+bool ImportantFileWriter::AppendToJournal(const FilePath& path,
+                                          const std::string& record) {
+  DCHECK_EQ(std::string::npos, record.find('\n'));
+  const FilePath journal_path = GetJournalPath(path);
+  File journal(journal_path, File::FLAG_OPEN_ALWAYS | File::FLAG_APPEND);
+  if (!journal.IsValid()) {
+    DPLOG(WARNING) << "could not open journal: " << journal_path.value();
+    return false;
+  }
+
+  // The record and its newline are written at once, so that an interrupted
+  // write can only leave an incomplete last line.
+  std::string line;
+  line.reserve(record.size() + 1);
+  line.append(record);
+  line.push_back('\n');
+  const int line_length = checked_cast<int32_t>(line.length());
+  if (journal.WriteAtCurrentPos(line.data(), line_length) < line_length ||
+      !journal.Flush()) {
+    DPLOG(WARNING) << "error appending to journal: " << journal_path.value();
+    return false;
+  }
+  return true;
+}
+
+// static
+bool ImportantFileWriter::CompactJournal(
+    const FilePath& path,
+    const MergeJournalCallback& merge_journal) {
+  const FilePath journal_path = GetJournalPath(path);
+  std::string journal;
+  if (!ReadFileToString(journal_path, &journal))
+    return !PathExists(journal_path);
+
+  std::string data;
+  if (PathExists(path) && !ReadFileToString(path, &data))
+    return false;
+
+  std::string merged_data;
+  if (!merge_journal.Run(data, journal, &merged_data)) {
+    DLOG(WARNING) << "failed to merge journal of " << path.value();
+    return false;
+  }
+
+  // If the journal can't be deleted, it is merged again later, which doesn't
+  // change the merged data.
+  return WriteFileAtomically(path, merged_data) &&
+         DeleteFile(journal_path, false);
+}
+
 ImportantFileWriter::ImportantFileWriter(
     const FilePath& path,
     const scoped_refptr<SequencedTaskRunner>& task_runner)
@@ -137,6 +213,8 @@ ImportantFileWriter::ImportantFileWriter(
       task_runner_(task_runner),
       serializer_(nullptr),
       commit_interval_(interval),
+      max_journal_size_(0),
+      journal_size_(0),
       weak_factory_(this) {
   DCHECK(CalledOnValidThread());
   DCHECK(task_runner_);
@@ -164,7 +242,14 @@ void ImportantFileWriter::WriteNow(scoped_ptr<std::string> data) {
   if (HasPendingWrite())
     timer_.Stop();
 
-  auto task = Bind(&WriteScopedStringToFileAtomically, path_, Passed(&data));
+  Callback<bool()> task;
+  if (journal_enabled()) {
+    journal_size_ = 0;
+    task = Bind(&WriteScopedStringToFileAtomicallyAndDeleteJournal, path_,
+                Passed(&data));
+  } else {
+    task = Bind(&WriteScopedStringToFileAtomically, path_, Passed(&data));
+  }
   if (!PostWriteTask(task)) {
     // Posting the task to background message loop is not expected
     // to fail, but if it does, avoid losing data and just hit the disk
@@ -189,6 +274,15 @@ void ImportantFileWriter::ScheduleWrite(DataSerializer* serializer) {
 
 void ImportantFileWriter::DoScheduledWrite() {
   DCHECK(serializer_);
+  if (journal_enabled()) {
+    scoped_ptr<std::string> delta(new std::string);
+    if (serializer_->SerializeDelta(delta.get())) {
+      AppendNow(delta.Pass());
+      serializer_ = nullptr;
+      return;
+    }
+  }
+
   scoped_ptr<std::string> data(new std::string);
   if (serializer_->SerializeData(data.get())) {
     WriteNow(data.Pass());
@@ -199,12 +293,49 @@ void ImportantFileWriter::DoScheduledWrite() {
   serializer_ = nullptr;
 }
 
+void ImportantFileWriter::EnableJournal(
+    const MergeJournalCallback& merge_journal,
+    size_t max_journal_size) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(!merge_journal.is_null());
+  merge_journal_ = merge_journal;
+  max_journal_size_ = max_journal_size;
+}
+
 void ImportantFileWriter::RegisterOnNextSuccessfulWriteCallback(
     const Closure& on_next_successful_write) {
   DCHECK(on_next_successful_write_.is_null());
   on_next_successful_write_ = on_next_successful_write;
 }
 
+void ImportantFileWriter::AppendNow(scoped_ptr<std::string> record) {
+  DCHECK(CalledOnValidThread());
+  if (!IsValueInRangeForNumericType<int32_t>(record->length())) {
+    NOTREACHED();
+    return;
+  }
+
+  if (HasPendingWrite())
+    timer_.Stop();
+
+  journal_size_ += record->length() + 1;
+  auto task = Bind(&AppendScopedStringToJournal, path_, Passed(&record));
+  if (!PostWriteTask(task)) {
+    NOTREACHED();
+
+    task.Run();
+  }
+
+  // Merging the journal is only posted after the append, so that it runs
+  // after it on the backend thread.
+  if (journal_size_ > max_journal_size_) {
+    journal_size_ = 0;
+    task_runner_->PostTask(
+        FROM_HERE, MakeCriticalClosure(Bind(IgnoreResult(&CompactJournal),
+                                            path_, merge_journal_)));
+  }
+}
+
 bool ImportantFileWriter::PostWriteTask(const Callback<bool()>& task) {
   // TODO(gab): This code could always use PostTaskAndReplyWithResult and let
   // ForwardSuccessfulWrite() no-op if |on_next_successful_write_| is null, but
@@ -37,6 +37,13 @@ class Thread;
 //
 // If you want to know more about this approach and ext3/ext4 fsync issues, see
 // http://valhenson.livejournal.com/37921.html
+//
+// Rewriting the whole file for every small change is expensive for large
+// files that change often. In journal mode (see EnableJournal()), a scheduled
+// write instead appends a record of the changes to a journal next to the
+// file, and the journal is merged into the file in the background once it has
+// grown large enough. Readers of the file must merge the journal first, see
+// CompactJournal().
 class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
  public:
   // Used by ScheduleSave to lazily provide the data to be saved. Allows us
@@ -48,15 +55,44 @@ class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
     // ImportantFileWriter has been created.
     virtual bool SerializeData(std::string* data) = 0;
 
+    // Only called in journal mode. Should put a record of the changes since
+    // the last call to SerializeData() or SerializeDelta() in |delta|, on a
+    // single line, and return true. If it returns false, SerializeData() is
+    // called instead and all of the data is written.
+    virtual bool SerializeDelta(std::string* delta);
+
    protected:
     virtual ~DataSerializer() {}
   };
 
+  // Merges a journal into the data of its file. Is given the contents of the
+  // file, empty if it doesn't exist, and of the journal, one record per line.
+  // Should put the merged data in |merged_data| and return true. The last
+  // record may be incomplete if a write was interrupted. Since a journal can be
+  // merged again if a merge is interrupted, merging a record more than once
+  // must not change the result.
+  typedef Callback<bool(const std::string& data,
+                        const std::string& journal,
+                        std::string* merged_data)> MergeJournalCallback;
+
   // Save |data| to |path| in an atomic manner (see the class comment above).
   // Blocks and writes data on the current thread.
   static bool WriteFileAtomically(const FilePath& path,
                                   const std::string& data);
 
+  // Returns the path of the journal of |path|.
+  static FilePath GetJournalPath(const FilePath& path);
+
+  // Appends |record| and a newline to the journal of |path|, and flushes the
+  // journal to disk. Blocks and writes data on the current thread.
+  static bool AppendToJournal(const FilePath& path, const std::string& record);
+
+  // Merges the journal of |path| into |path| with |merge_journal|, then
+  // deletes the journal. Returns true if there is no journal. Blocks and
+  // writes data on the current thread.
+  static bool CompactJournal(const FilePath& path,
+                             const MergeJournalCallback& merge_journal);
+
   // Initialize the writer.
   // |path| is the name of file to write.
   // |task_runner| is the SequencedTaskRunner instance where on which we will
@@ -95,6 +131,16 @@ class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
   // Serialize data pending to be saved and execute write on backend thread.
   void DoScheduledWrite();
 
+  // Switches to journal mode, in which DoScheduledWrite() appends the delta of
+  // the serializer to the journal rather than rewriting the file. Once the
+  // journal has grown by more than |max_journal_size| bytes, it is merged into
+  // the file on the backend thread with |merge_journal|, which must be safe to
+  // run there. Writes of all of the data delete the journal.
+  void EnableJournal(const MergeJournalCallback& merge_journal,
+                     size_t max_journal_size);
+
+  bool journal_enabled() const { return !merge_journal_.is_null(); }
+
   // Registers |on_next_successful_write| to be called once, on the next
   // successful write event. Only one callback can be set at once.
   void RegisterOnNextSuccessfulWriteCallback(
@@ -105,7 +151,10 @@ class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
   }
 
  private:
-  // Helper method for WriteNow().
+  // Appends |record| to the journal. Does not block.
+  void AppendNow(scoped_ptr<std::string> record);
+
+  // Helper method for WriteNow() and AppendNow().
   bool PostWriteTask(const Callback<bool()>& task);
 
   // If |result| is true and |on_next_successful_write_| is set, invokes
@@ -130,6 +179,15 @@ class BASE_EXPORT ImportantFileWriter : public NonThreadSafe {
   // Time delta after which scheduled data will be written to disk.
   const TimeDelta commit_interval_;
 
+  // Merges the journal into the file in journal mode, null otherwise.
+  MergeJournalCallback merge_journal_;
+
+  // The size of the journal after which it is merged into the file.
+  size_t max_journal_size_;
+
+  // The number of bytes appended to the journal since it was last merged.
+  size_t journal_size_;
+
   WeakPtrFactory<ImportantFileWriter> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(ImportantFileWriter);
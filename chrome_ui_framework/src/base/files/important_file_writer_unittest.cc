@@ -44,6 +44,47 @@ class DataSerializer : public ImportantFileWriter::DataSerializer {
   const std::string data_;
 };
 
+// Serializes the delta given to it, if any, in journal mode.
+class DeltaSerializer : public ImportantFileWriter::DataSerializer {
+ public:
+  explicit DeltaSerializer(const std::string& data)
+      : data_(data), has_delta_(false) {}
+
+  void set_delta(const std::string& delta) {
+    delta_ = delta;
+    has_delta_ = true;
+  }
+
+  bool SerializeData(std::string* output) override {
+    output->assign(data_);
+    return true;
+  }
+
+  bool SerializeDelta(std::string* output) override {
+    if (!has_delta_)
+      return false;
+    output->assign(delta_);
+    has_delta_ = false;
+    return true;
+  }
+
+ private:
+  const std::string data_;
+  std::string delta_;
+  bool has_delta_;
+};
+
+// Merges a journal by appending its records to the data, each followed by a
+// semicolon.
+bool AppendJournal(const std::string& data,
+                   const std::string& journal,
+                   std::string* merged_data) {
+  merged_data->assign(data);
+  for (char c : journal)
+    merged_data->push_back(c == '\n' ? ';' : c);
+  return true;
+}
+
 class SuccessfulWriteObserver {
  public:
   SuccessfulWriteObserver() : successful_write_observed_(false) {}
@@ -193,4 +234,75 @@ TEST_F(ImportantFileWriterTest, BatchingWrites) {
   EXPECT_EQ("baz", GetFileContent(writer.path()));
 }
 
+TEST_F(ImportantFileWriterTest, AppendToJournalAndCompact) {
+  const FilePath journal = ImportantFileWriter::GetJournalPath(file_);
+  EXPECT_NE(file_.value(), journal.value());
+
+  // Without a journal, there is nothing to merge.
+  EXPECT_TRUE(ImportantFileWriter::CompactJournal(file_,
+                                                  Bind(&AppendJournal)));
+  EXPECT_FALSE(PathExists(file_));
+
+  ASSERT_TRUE(ImportantFileWriter::AppendToJournal(file_, "foo"));
+  ASSERT_TRUE(ImportantFileWriter::AppendToJournal(file_, "bar"));
+  EXPECT_EQ("foo\nbar\n", GetFileContent(journal));
+
+  EXPECT_TRUE(ImportantFileWriter::CompactJournal(file_,
+                                                  Bind(&AppendJournal)));
+  EXPECT_EQ("foo;bar;", GetFileContent(file_));
+  EXPECT_FALSE(PathExists(journal));
+
+  ASSERT_TRUE(ImportantFileWriter::AppendToJournal(file_, "baz"));
+  EXPECT_TRUE(ImportantFileWriter::CompactJournal(file_,
+                                                  Bind(&AppendJournal)));
+  EXPECT_EQ("foo;bar;baz;", GetFileContent(file_));
+  EXPECT_FALSE(PathExists(journal));
+}
+
+TEST_F(ImportantFileWriterTest, JournalMode) {
+  ImportantFileWriter writer(file_, ThreadTaskRunnerHandle::Get());
+  writer.EnableJournal(Bind(&AppendJournal), 10);
+  EXPECT_TRUE(writer.journal_enabled());
+  const FilePath journal = ImportantFileWriter::GetJournalPath(file_);
+
+  // Without a delta, all of the data is written.
+  DeltaSerializer serializer("data;");
+  writer.ScheduleWrite(&serializer);
+  writer.DoScheduledWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ("data;", GetFileContent(file_));
+  EXPECT_FALSE(PathExists(journal));
+
+  // Deltas are appended to the journal.
+  serializer.set_delta("foo");
+  writer.ScheduleWrite(&serializer);
+  writer.DoScheduledWrite();
+  EXPECT_FALSE(writer.HasPendingWrite());
+  serializer.set_delta("bar");
+  writer.ScheduleWrite(&serializer);
+  writer.DoScheduledWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ("data;", GetFileContent(file_));
+  EXPECT_EQ("foo\nbar\n", GetFileContent(journal));
+
+  // The journal is merged once it grows by more than 10 bytes.
+  serializer.set_delta("baz");
+  writer.ScheduleWrite(&serializer);
+  writer.DoScheduledWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ("data;foo;bar;baz;", GetFileContent(file_));
+  EXPECT_FALSE(PathExists(journal));
+
+  // Writing all of the data deletes the journal.
+  serializer.set_delta("qux");
+  writer.ScheduleWrite(&serializer);
+  writer.DoScheduledWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_TRUE(PathExists(journal));
+  writer.WriteNow(make_scoped_ptr(new std::string("new;")));
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ("new;", GetFileContent(file_));
+  EXPECT_FALSE(PathExists(journal));
+}
+
 }  // namespace base
@@ -0,0 +1,313 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// String offsets and lengths are 32-bit, and the unescaped strings are stored
+// after the input, so the input has to fit in half of that.
+const size_t kMaxInputSize = kuint32max / 2;
+
+}  // namespace
+
+// Appends the values reported by JSONReader::ReadWithDelegate() to the entries
+// of a document.
+class JSONDocument::Builder : public JSONReader::Delegate {
+ public:
+  // A list or dictionary being parsed, and the index of its last child so
+  // far, or 0 if it has none.
+  struct OpenContainer {
+    uint32 index;
+    uint32 last_child;
+  };
+
+  explicit Builder(JSONDocument* document) : document_(document) {
+    pending_key_.offset = 0;
+    pending_key_.length = 0;
+  }
+  ~Builder() override {}
+
+  // Stores the unescaped strings after the input. They are only appended once
+  // the parse is over, since the parser points into the input.
+  void Finish() { document_->text_.append(decoded_); }
+
+  // JSONReader::Delegate:
+  bool OnDictionaryBegin() override {
+    return BeginContainer(Value::TYPE_DICTIONARY);
+  }
+
+  bool OnDictionaryKey(const StringPiece& key) override {
+    pending_key_ = AddString(key);
+    return true;
+  }
+
+  bool OnDictionaryEnd() override { return EndContainer(); }
+
+  bool OnListBegin() override { return BeginContainer(Value::TYPE_LIST); }
+
+  bool OnListEnd() override { return EndContainer(); }
+
+  bool OnString(const StringPiece& value) override {
+    StringRef string_value = AddString(value);
+    AddEntry(Value::TYPE_STRING)->string_value = string_value;
+    return true;
+  }
+
+  bool OnInteger(int value) override {
+    AddEntry(Value::TYPE_INTEGER)->integer_value = value;
+    return true;
+  }
+
+  bool OnDouble(double value) override {
+    AddEntry(Value::TYPE_DOUBLE)->double_value = value;
+    return true;
+  }
+
+  bool OnBoolean(bool value) override {
+    AddEntry(Value::TYPE_BOOLEAN)->boolean_value = value;
+    return true;
+  }
+
+  bool OnNull() override {
+    AddEntry(Value::TYPE_NULL);
+    return true;
+  }
+
+ private:
+  // Appends an entry of |type| as the next child of the innermost open
+  // container. The pointer is valid until the next entry is added.
+  Entry* AddEntry(Value::Type type) {
+    std::vector<Entry>& entries = document_->entries_;
+    const uint32 index = static_cast<uint32>(entries.size());
+    Entry entry;
+    entry.type = type;
+    entry.size = 0;
+    entry.next = 0;
+    entry.key.offset = 0;
+    entry.key.length = 0;
+    if (!open_containers_.empty()) {
+      OpenContainer& parent = open_containers_.back();
+      if (entries[parent.index].type == Value::TYPE_DICTIONARY)
+        entry.key = pending_key_;
+      entries[parent.index].size++;
+      if (parent.last_child)
+        entries[parent.last_child].next = index;
+      parent.last_child = index;
+    }
+    entries.push_back(entry);
+    return &entries.back();
+  }
+
+  bool BeginContainer(Value::Type type) {
+    const uint32 index = static_cast<uint32>(document_->entries_.size());
+    AddEntry(type);
+    OpenContainer container = {index, 0};
+    open_containers_.push_back(container);
+    return true;
+  }
+
+  bool EndContainer() {
+    DCHECK(!open_containers_.empty());
+    open_containers_.pop_back();
+    return true;
+  }
+
+  // Returns a reference to |string|, which points into the input unless it
+  // was unescaped by the parser.
+  StringRef AddString(const StringPiece& string) {
+    const std::string& input = document_->text_;
+    StringRef ref;
+    ref.length = static_cast<uint32>(string.length());
+    if (string.data() >= input.data() &&
+        string.data() + string.length() <= input.data() + input.length()) {
+      ref.offset = static_cast<uint32>(string.data() - input.data());
+    } else {
+      ref.offset = static_cast<uint32>(input.length() + decoded_.length());
+      string.AppendToString(&decoded_);
+    }
+    return ref;
+  }
+
+  JSONDocument* document_;
+
+  // The unescaped strings.
+  std::string decoded_;
+
+  // The lists and dictionaries being parsed, innermost last.
+  std::vector<OpenContainer> open_containers_;
+
+  // The key of the next entry of the innermost dictionary.
+  StringRef pending_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(Builder);
+};
+
+JSONDocument::Node::Node() : document_(NULL), index_(0) {}
+
+JSONDocument::Node::Node(const JSONDocument* document, size_t index)
+    : document_(document), index_(index) {}
+
+Value::Type JSONDocument::Node::type() const {
+  DCHECK(is_valid());
+  return document_->entries_[index_].type;
+}
+
+bool JSONDocument::Node::GetAsBoolean(bool* out_value) const {
+  const Entry& entry = document_->entries_[index_];
+  if (entry.type != Value::TYPE_BOOLEAN)
+    return false;
+  if (out_value)
+    *out_value = entry.boolean_value;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsInteger(int* out_value) const {
+  const Entry& entry = document_->entries_[index_];
+  if (entry.type != Value::TYPE_INTEGER)
+    return false;
+  if (out_value)
+    *out_value = entry.integer_value;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsDouble(double* out_value) const {
+  const Entry& entry = document_->entries_[index_];
+  if (entry.type == Value::TYPE_INTEGER) {
+    if (out_value)
+      *out_value = entry.integer_value;
+    return true;
+  }
+  if (entry.type != Value::TYPE_DOUBLE)
+    return false;
+  if (out_value)
+    *out_value = entry.double_value;
+  return true;
+}
+
+bool JSONDocument::Node::GetAsString(StringPiece* out_value) const {
+  const Entry& entry = document_->entries_[index_];
+  if (entry.type != Value::TYPE_STRING)
+    return false;
+  if (out_value)
+    *out_value = document_->GetString(entry.string_value);
+  return true;
+}
+
+size_t JSONDocument::Node::size() const {
+  return document_->entries_[index_].size;
+}
+
+JSONDocument::Node JSONDocument::Node::FirstChild() const {
+  if (size() == 0)
+    return Node();
+  return Node(document_, index_ + 1);
+}
+
+JSONDocument::Node JSONDocument::Node::NextSibling() const {
+  const uint32 next = document_->entries_[index_].next;
+  return next ? Node(document_, next) : Node();
+}
+
+StringPiece JSONDocument::Node::key() const {
+  return document_->GetString(document_->entries_[index_].key);
+}
+
+bool JSONDocument::Node::FindKey(const StringPiece& key,
+                                 Node* out_value) const {
+  if (type() != Value::TYPE_DICTIONARY)
+    return false;
+
+  bool found = false;
+  for (Node child = FirstChild(); child.is_valid();
+       child = child.NextSibling()) {
+    if (child.key() == key) {
+      if (out_value)
+        *out_value = child;
+      found = true;
+    }
+  }
+  return found;
+}
+
+scoped_ptr<Value> JSONDocument::Node::ToValue() const {
+  const Entry& entry = document_->entries_[index_];
+  switch (entry.type) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return make_scoped_ptr(new FundamentalValue(entry.boolean_value));
+    case Value::TYPE_INTEGER:
+      return make_scoped_ptr(new FundamentalValue(entry.integer_value));
+    case Value::TYPE_DOUBLE:
+      return make_scoped_ptr(new FundamentalValue(entry.double_value));
+    case Value::TYPE_STRING:
+      return make_scoped_ptr(new StringValue(
+          document_->GetString(entry.string_value).as_string()));
+    case Value::TYPE_DICTIONARY: {
+      scoped_ptr<DictionaryValue> dictionary(new DictionaryValue);
+      for (Node child = FirstChild(); child.is_valid();
+           child = child.NextSibling()) {
+        dictionary->SetWithoutPathExpansion(child.key().as_string(),
+                                            child.ToValue());
+      }
+      return dictionary.Pass();
+    }
+    case Value::TYPE_LIST: {
+      scoped_ptr<ListValue> list(new ListValue);
+      for (Node child = FirstChild(); child.is_valid();
+           child = child.NextSibling()) {
+        list->Append(child.ToValue());
+      }
+      return list.Pass();
+    }
+    default:
+      NOTREACHED();
+      return nullptr;
+  }
+}
+
+JSONDocument::JSONDocument() {}
+
+JSONDocument::~JSONDocument() {}
+
+// static
+scoped_ptr<JSONDocument> JSONDocument::Parse(const StringPiece& json,
+                                             int options,
+                                             int* error_code_out,
+                                             std::string* error_msg_out) {
+  if (json.length() > kMaxInputSize) {
+    if (error_code_out)
+      *error_code_out = JSONReader::JSON_SYNTAX_ERROR;
+    if (error_msg_out)
+      *error_msg_out =
+          JSONReader::ErrorCodeToString(JSONReader::JSON_SYNTAX_ERROR);
+    return nullptr;
+  }
+
+  scoped_ptr<JSONDocument> document(new JSONDocument);
+  json.CopyToString(&document->text_);
+  // Typical documents have a value every 16 to 20 bytes. Reserving for that
+  // avoids copying the entries as they grow, and the pages of a large
+  // allocation that are not used are never touched.
+  document->entries_.reserve(json.size() / 16);
+  Builder builder(document.get());
+  if (!JSONReader::ReadWithDelegate(document->text_, options, &builder,
+                                    error_code_out, error_msg_out)) {
+    return nullptr;
+  }
+  builder.Finish();
+  return document.Pass();
+}
+
+StringPiece JSONDocument::GetString(const StringRef& ref) const {
+  return StringPiece(text_.data() + ref.offset, ref.length);
+}
+
+}  // namespace base
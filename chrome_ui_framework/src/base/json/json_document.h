@@ -0,0 +1,147 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_DOCUMENT_H_
+#define BASE_JSON_JSON_DOCUMENT_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+// A read-only JSON tree that is parsed in bulk. All nodes live in a single
+// array, and strings point into a copy of the input unless they had to be
+// unescaped, in which case they are packed into one more buffer. Parsing a
+// document therefore makes a handful of allocations however large it is,
+// where JSONReader::Read() makes at least one per value. Meant for large
+// inputs that are mostly read, such as preference files and theme manifests;
+// the parts that need to be modified can be converted with Node::ToValue().
+//
+//   scoped_ptr<JSONDocument> document =
+//       JSONDocument::Parse(json, JSON_PARSE_RFC, NULL, NULL);
+//   JSONDocument::Node colors;
+//   if (document && document->root().FindKey("colors", &colors)) {
+//     for (JSONDocument::Node color = colors.FirstChild(); color.is_valid();
+//          color = color.NextSibling()) {
+//       ...
+//     }
+//   }
+class BASE_EXPORT JSONDocument {
+ public:
+  // A value in the document. Nodes are cheap to copy and are valid as long as
+  // their document is.
+  class BASE_EXPORT Node {
+   public:
+    // Constructs an invalid node.
+    Node();
+
+    bool is_valid() const { return document_ != NULL; }
+
+    Value::Type type() const;
+
+    // These return false if the node is not of a matching type. As with
+    // FundamentalValue, an integer can be read as a double.
+    bool GetAsBoolean(bool* out_value) const;
+    bool GetAsInteger(int* out_value) const;
+    bool GetAsDouble(double* out_value) const;
+    bool GetAsString(StringPiece* out_value) const;
+
+    // Returns the number of items of a list or entries of a dictionary, and 0
+    // for other types.
+    size_t size() const;
+
+    // Returns the first item of a list or entry of a dictionary, or an invalid
+    // node if there is none.
+    Node FirstChild() const;
+
+    // Returns the item or entry that follows this one in its list or
+    // dictionary, or an invalid node after the last one.
+    Node NextSibling() const;
+
+    // Returns the key of an entry of a dictionary, and an empty string for
+    // the items of a list and the root.
+    StringPiece key() const;
+
+    // Finds the entry for |key| in a dictionary, by a linear search. Returns
+    // false if there is none or the node is not a dictionary. As with
+    // JSONReader, the last of several entries with the same key is found.
+    bool FindKey(const StringPiece& key, Node* out_value) const;
+
+    // Returns a deep copy of the node as a Value.
+    scoped_ptr<Value> ToValue() const;
+
+   private:
+    friend class JSONDocument;
+
+    Node(const JSONDocument* document, size_t index);
+
+    const JSONDocument* document_;
+    size_t index_;
+  };
+
+  ~JSONDocument();
+
+  // Parses |json| like JSONReader::ReadAndReturnError(). Returns NULL if
+  // |json| is not properly formed, in which case |error_code_out| and
+  // |error_msg_out| are populated if they are not NULL. Inputs of 2 GB or
+  // more are rejected as syntax errors.
+  static scoped_ptr<JSONDocument> Parse(const StringPiece& json,
+                                        int options,  // JSONParserOptions
+                                        int* error_code_out,
+                                        std::string* error_msg_out);
+
+  Node root() const { return Node(this, 0); }
+
+  // The number of values in the document.
+  size_t node_count() const { return entries_.size(); }
+
+ private:
+  class Builder;
+
+  // A string in |text_|.
+  struct StringRef {
+    uint32 offset;
+    uint32 length;
+  };
+
+  // A node of the tree. Entries are stored in document order, so the first
+  // child of a list or dictionary directly follows it, and the root is the
+  // first entry.
+  struct Entry {
+    Value::Type type;
+    // The number of children of a list or dictionary.
+    uint32 size;
+    // The index of the next child of the same parent, or 0 for the last one.
+    uint32 next;
+    // The key of an entry of a dictionary.
+    StringRef key;
+    union {
+      bool boolean_value;
+      int integer_value;
+      double double_value;
+      StringRef string_value;
+    };
+  };
+
+  JSONDocument();
+
+  StringPiece GetString(const StringRef& ref) const;
+
+  // The input, followed by the strings that had to be unescaped.
+  std::string text_;
+
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONDocument);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_DOCUMENT_H_
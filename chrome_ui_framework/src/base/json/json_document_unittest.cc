@@ -0,0 +1,169 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(JSONDocumentTest, Navigation) {
+  scoped_ptr<JSONDocument> document = JSONDocument::Parse(
+      "{\"name\": \"theme\", \"version\": 3, \"scale\": 1.5, \"enabled\": true,"
+      " \"colors\": [[255, 0, 0], [0, 255, 0]], \"images\": {}, \"x\": null}",
+      JSON_PARSE_RFC, NULL, NULL);
+  ASSERT_TRUE(document);
+  EXPECT_EQ(16u, document->node_count());
+
+  JSONDocument::Node root = document->root();
+  ASSERT_TRUE(root.is_valid());
+  EXPECT_EQ(Value::TYPE_DICTIONARY, root.type());
+  EXPECT_EQ(7u, root.size());
+  EXPECT_EQ("", root.key());
+  EXPECT_FALSE(root.NextSibling().is_valid());
+
+  JSONDocument::Node node;
+  StringPiece string_value;
+  ASSERT_TRUE(root.FindKey("name", &node));
+  EXPECT_EQ("name", node.key());
+  EXPECT_TRUE(node.GetAsString(&string_value));
+  EXPECT_EQ("theme", string_value);
+  EXPECT_FALSE(node.GetAsInteger(NULL));
+
+  int int_value = 0;
+  double double_value = 0;
+  ASSERT_TRUE(root.FindKey("version", &node));
+  EXPECT_TRUE(node.GetAsInteger(&int_value));
+  EXPECT_EQ(3, int_value);
+  EXPECT_TRUE(node.GetAsDouble(&double_value));
+  EXPECT_EQ(3.0, double_value);
+  ASSERT_TRUE(root.FindKey("scale", &node));
+  EXPECT_FALSE(node.GetAsInteger(&int_value));
+  EXPECT_TRUE(node.GetAsDouble(&double_value));
+  EXPECT_EQ(1.5, double_value);
+
+  bool bool_value = false;
+  ASSERT_TRUE(root.FindKey("enabled", &node));
+  EXPECT_TRUE(node.GetAsBoolean(&bool_value));
+  EXPECT_TRUE(bool_value);
+
+  ASSERT_TRUE(root.FindKey("x", &node));
+  EXPECT_EQ(Value::TYPE_NULL, node.type());
+  EXPECT_FALSE(node.NextSibling().is_valid());
+
+  ASSERT_TRUE(root.FindKey("images", &node));
+  EXPECT_EQ(Value::TYPE_DICTIONARY, node.type());
+  EXPECT_EQ(0u, node.size());
+  EXPECT_FALSE(node.FirstChild().is_valid());
+
+  EXPECT_FALSE(root.FindKey("missing", &node));
+  EXPECT_FALSE(root.FindKey("theme", &node));
+
+  // Siblings skip over the children of lists.
+  ASSERT_TRUE(root.FindKey("colors", &node));
+  EXPECT_EQ(Value::TYPE_LIST, node.type());
+  ASSERT_EQ(2u, node.size());
+  EXPECT_EQ("images", node.NextSibling().key());
+  JSONDocument::Node green = node.FirstChild().NextSibling();
+  ASSERT_TRUE(green.is_valid());
+  EXPECT_FALSE(green.NextSibling().is_valid());
+  EXPECT_EQ("", green.key());
+  EXPECT_FALSE(green.FindKey("0", NULL));
+  int components[3] = {-1, -1, -1};
+  int i = 0;
+  for (JSONDocument::Node component = green.FirstChild(); component.is_valid();
+       component = component.NextSibling()) {
+    ASSERT_LT(i, 3);
+    EXPECT_TRUE(component.GetAsInteger(&components[i++]));
+  }
+  EXPECT_EQ(3, i);
+  EXPECT_EQ(0, components[0]);
+  EXPECT_EQ(255, components[1]);
+  EXPECT_EQ(0, components[2]);
+}
+
+TEST(JSONDocumentTest, EscapedStrings) {
+  scoped_ptr<JSONDocument> document = JSONDocument::Parse(
+      "{\"plain\": \"a\", \"esc\\taped\": \"line\\nbreak\","
+      " \"unicode\": \"\\u00e9t\\u00e9\", \"last\": \"z\"}",
+      JSON_PARSE_RFC, NULL, NULL);
+  ASSERT_TRUE(document);
+
+  JSONDocument::Node node;
+  StringPiece value;
+  ASSERT_TRUE(document->root().FindKey("esc\taped", &node));
+  EXPECT_EQ("esc\taped", node.key());
+  EXPECT_TRUE(node.GetAsString(&value));
+  EXPECT_EQ("line\nbreak", value);
+  ASSERT_TRUE(document->root().FindKey("unicode", &node));
+  EXPECT_TRUE(node.GetAsString(&value));
+  EXPECT_EQ("\xC3\xA9t\xC3\xA9", value);
+  ASSERT_TRUE(document->root().FindKey("last", &node));
+  EXPECT_TRUE(node.GetAsString(&value));
+  EXPECT_EQ("z", value);
+}
+
+TEST(JSONDocumentTest, DuplicateKeys) {
+  scoped_ptr<JSONDocument> document =
+      JSONDocument::Parse("{\"a\": 1, \"a\": 2}", JSON_PARSE_RFC, NULL, NULL);
+  ASSERT_TRUE(document);
+  EXPECT_EQ(2u, document->root().size());
+
+  // As with JSONReader, the last entry wins.
+  JSONDocument::Node node;
+  int value = 0;
+  ASSERT_TRUE(document->root().FindKey("a", &node));
+  EXPECT_TRUE(node.GetAsInteger(&value));
+  EXPECT_EQ(2, value);
+  scoped_ptr<Value> converted = document->root().ToValue();
+  ASSERT_TRUE(converted);
+  EXPECT_TRUE(converted->Equals(JSONReader::Read("{\"a\": 2}").get()));
+}
+
+TEST(JSONDocumentTest, ToValueMatchesReader) {
+  const char* const kInputs[] = {
+      "null",
+      "-12",
+      "\"\\\"quoted\\\"\"",
+      "[]",
+      "[1, [2, [3, []]], {\"k\": {\"l\": [true, false]}}, 1e3]",
+      "{\"a\": {\"b\": {\"c\": \"d\"}}, \"e\": [{}, {\"f\": 0.25}],"
+      " \"g\": \"\"}",
+  };
+  for (size_t i = 0; i < arraysize(kInputs); ++i) {
+    SCOPED_TRACE(kInputs[i]);
+    scoped_ptr<JSONDocument> document =
+        JSONDocument::Parse(kInputs[i], JSON_PARSE_RFC, NULL, NULL);
+    ASSERT_TRUE(document);
+    scoped_ptr<Value> expected = JSONReader::Read(kInputs[i]);
+    ASSERT_TRUE(expected);
+    scoped_ptr<Value> actual = document->root().ToValue();
+    ASSERT_TRUE(actual);
+    EXPECT_TRUE(expected->Equals(actual.get()));
+  }
+}
+
+TEST(JSONDocumentTest, Errors) {
+  int error_code = JSONReader::JSON_NO_ERROR;
+  std::string error_message;
+  EXPECT_FALSE(JSONDocument::Parse("{\"a\": [1, 2}", JSON_PARSE_RFC,
+                                   &error_code, &error_message));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, error_code);
+  EXPECT_FALSE(error_message.empty());
+
+  EXPECT_FALSE(
+      JSONDocument::Parse("[1,]", JSON_PARSE_RFC, &error_code, NULL));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, error_code);
+  EXPECT_TRUE(JSONDocument::Parse("[1,]", JSON_ALLOW_TRAILING_COMMAS, NULL,
+                                  NULL));
+
+  EXPECT_FALSE(JSONDocument::Parse("", JSON_PARSE_RFC, &error_code, NULL));
+  EXPECT_FALSE(JSONDocument::Parse("{} []", JSON_PARSE_RFC, &error_code, NULL));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, error_code);
+}
+
+}  // namespace base
@@ -49,6 +49,12 @@ class BASE_EXPORT_PRIVATE JSONParser {
   // result as a Value owned by the caller.
   Value* Parse(const StringPiece& input);
 
+  // Parses the input string according to the set options and reports the
+  // values in it to |delegate| instead of building them. The input is not
+  // copied. Returns false on error or if |delegate| stopped the parse.
+  bool ParseWithDelegate(const StringPiece& input,
+                         JSONReader::Delegate* delegate);
+
   // Returns the error code.
   JSONReader::JsonParseError error_code() const;
 
@@ -96,6 +102,10 @@ class BASE_EXPORT_PRIVATE JSONParser {
     // AppendString below.
     void Append(const char& c);
 
+    // Like Append(), for the |length| basic ASCII characters at |str|, which
+    // must be the next characters of the input.
+    void AppendRun(const char* str, size_t length);
+
     // Appends a string to the std::string. Must be Convert()ed to use.
     void AppendString(const std::string& str);
 
@@ -126,6 +136,14 @@ class BASE_EXPORT_PRIVATE JSONParser {
     std::string* string_;
   };
 
+  // Winds the parser to the start of the |length| bytes at |start|, skipping
+  // a UTF-8 byte-order mark, and clears any error.
+  void StartParsing(const char* start, size_t length);
+
+  // Checks that only whitespace and comments follow the root value. Returns
+  // false with error information set otherwise.
+  bool ConsumeEndOfInput();
+
   // Quick check that the stream has capacity to consume |length| more bytes.
   bool CanConsume(int length);
 
@@ -185,6 +203,10 @@ class BASE_EXPORT_PRIVATE JSONParser {
   // Assuming that the parser is wound to the start of a valid JSON number,
   // this parses and converts it to either an int or double value.
   Value* ConsumeNumber();
+  // Helper for ConsumeNumber() that scans the number and checks that a valid
+  // token follows it. Returns true on success and sets |out| to the text of
+  // the number, and false on failure with error information set.
+  bool ConsumeNumberRaw(StringPiece* out);
   // Helper that reads characters that are ints. Returns true if a number was
   // read and false on error.
   bool ReadInt(bool allow_leading_zeros);
@@ -192,6 +214,21 @@ class BASE_EXPORT_PRIVATE JSONParser {
   // Consumes the literal values of |true|, |false|, and |null|, assuming the
   // parser is wound to the first character of any of those.
   Value* ConsumeLiteral();
+  // Helper for ConsumeLiteral() that consumes |literal|. Returns false with
+  // error information set if the input does not match.
+  bool ConsumeLiteralRaw(const char* literal);
+
+  // The ParseWithDelegate() counterparts of ParseNextToken(), ParseToken()
+  // and the Consume functions for values, which report to |delegate_| rather
+  // than build Values. All return false on error or if |delegate_| stopped
+  // the parse.
+  bool WalkNextToken();
+  bool WalkToken(Token token);
+  bool WalkDictionary();
+  bool WalkList();
+  bool WalkString();
+  bool WalkNumber();
+  bool WalkLiteral();
 
   // Compares two string buffers of a given length.
   static bool StringsAreEqual(const char* left, const char* right, size_t len);
@@ -209,6 +246,9 @@ class BASE_EXPORT_PRIVATE JSONParser {
   // base::JSONParserOptions that control parsing.
   int options_;
 
+  // The delegate of the ParseWithDelegate() call in progress, if any. Weak.
+  JSONReader::Delegate* delegate_;
+
   // Pointer to the start of the input data.
   const char* start_pos_;
 
@@ -241,6 +281,7 @@ class BASE_EXPORT_PRIVATE JSONParser {
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeDictionary);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeList);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeString);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLongString);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLiterals);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeNumbers);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ErrorMessages);
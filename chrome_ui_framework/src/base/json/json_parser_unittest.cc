@@ -55,6 +55,35 @@ TEST_F(JSONParserTest, ConsumeString) {
   EXPECT_EQ("test", str);
 }
 
+TEST_F(JSONParserTest, ConsumeLongString) {
+  // Long runs of plain characters are skipped in blocks, so put escapes and
+  // non-ASCII characters at every offset around the block boundaries.
+  const char* const kSpecials[] = {"\\n", "\\u00e9", "\xC3\xA9", "<", "\x7F"};
+  const char* const kDecoded[] = {"\n", "\xC3\xA9", "\xC3\xA9", "<", "\x7F"};
+  for (size_t i = 0; i < arraysize(kSpecials); ++i) {
+    for (size_t offset = 0; offset < 40; ++offset) {
+      const std::string plain(offset, 'a');
+      const std::string input =
+          "\"" + plain + kSpecials[i] + plain + "bcdefghijklmnopq\",|";
+      scoped_ptr<JSONParser> parser(NewTestParser(input));
+      scoped_ptr<Value> value(parser->ConsumeString());
+      ASSERT_TRUE(value.get()) << i << " " << offset;
+      EXPECT_EQ('"', *parser->pos_);
+      TestLastThree(parser.get());
+
+      std::string str;
+      EXPECT_TRUE(value->GetAsString(&str));
+      EXPECT_EQ(plain + kDecoded[i] + plain + "bcdefghijklmnopq", str);
+    }
+  }
+
+  // The string must still be terminated.
+  std::string unterminated("\"" + std::string(40, 'a'));
+  scoped_ptr<JSONParser> parser(NewTestParser(unterminated));
+  EXPECT_FALSE(parser->ConsumeString());
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, parser->error_code());
+}
+
 TEST_F(JSONParserTest, ConsumeList) {
   std::string input("[true, false],|");
   scoped_ptr<JSONParser> parser(NewTestParser(input));
@@ -84,6 +84,30 @@ class BASE_EXPORT JSONReader {
   static const char kUnsupportedEncoding[];
   static const char kUnquotedDictionaryKey[];
 
+  // Receives the contents of a document from ReadWithDelegate() while it is
+  // parsed, in document order, instead of a Value tree being built. Every
+  // method returns false to stop the parse.
+  class BASE_EXPORT Delegate {
+   public:
+    virtual ~Delegate() {}
+
+    // A dictionary starts. Each entry is reported as OnDictionaryKey()
+    // followed by its value.
+    virtual bool OnDictionaryBegin() = 0;
+    virtual bool OnDictionaryKey(const StringPiece& key) = 0;
+    virtual bool OnDictionaryEnd() = 0;
+
+    virtual bool OnListBegin() = 0;
+    virtual bool OnListEnd() = 0;
+
+    // Strings are decoded and in UTF-8.
+    virtual bool OnString(const StringPiece& value) = 0;
+    virtual bool OnInteger(int value) = 0;
+    virtual bool OnDouble(double value) = 0;
+    virtual bool OnBoolean(bool value) = 0;
+    virtual bool OnNull() = 0;
+  };
+
   // Constructs a reader with the default options, JSON_PARSE_RFC.
   JSONReader();
 
@@ -110,6 +134,20 @@ class BASE_EXPORT JSONReader {
                                               int* error_code_out,
                                               std::string* error_msg_out);
 
+  // Parses |json| according to |options| and reports its contents to
+  // |delegate| without building any Values, so memory use does not grow with
+  // the size of the document. The strings passed to |delegate| are only valid
+  // during the call. Returns true if |json| is properly formed. Since errors
+  // are only found as the parse gets to them, |delegate| may already have
+  // seen part of a malformed document. On error, |error_code_out| and
+  // |error_msg_out| are populated as in ReadAndReturnError(); if |delegate|
+  // stopped the parse, false is returned with JSON_NO_ERROR.
+  static bool ReadWithDelegate(const StringPiece& json,
+                               int options,  // JSONParserOptions
+                               Delegate* delegate,
+                               int* error_code_out,
+                               std::string* error_msg_out);
+
   // Converts a JSON parse error code into a human readable message.
   // Returns an empty string if error_code is JSON_NO_ERROR.
   static std::string ErrorCodeToString(JsonParseError error_code);
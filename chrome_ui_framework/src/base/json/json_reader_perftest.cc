@@ -0,0 +1,169 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_reader.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/json/json_document.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/scoped_peak_memory_delta.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <malloc.h>
+#endif
+
+namespace base {
+
+namespace {
+
+const int kRuns = 5;
+
+// Builds a document shaped like a large preferences file: many dictionaries
+// of short strings, numbers and booleans, with the odd escaped string and
+// list of numbers. |entry_count| entries make about 200 bytes each.
+std::string MakeTestDocument(int entry_count) {
+  std::string json = "{\"profile\": {\"name\": \"Person 1\"}, \"sites\": {";
+  for (int i = 0; i < entry_count; ++i) {
+    if (i)
+      json += ",";
+    StringAppendF(&json,
+                  "\"https://www.example%d.com:443,*\": {"
+                  "\"last_modified\": \"13087%08d\", \"setting\": %d, "
+                  "\"engagement\": %d.%d, \"allowed\": %s, "
+                  "\"title\": \"Example \\\"%d\\\"\\n\", "
+                  "\"visits\": [%d, %d, %d]}",
+                  i, i, i % 3, i % 100, i % 10, i % 2 ? "true" : "false", i,
+                  i, i + 1, i + 2);
+  }
+  json += "}}";
+  return json;
+}
+
+// Returns the number of bytes held by malloc, or 0 where that is unknown.
+size_t GetAllocatedBytes() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  struct mallinfo info = mallinfo();
+  return info.uordblks;
+#else
+  return 0;
+#endif
+}
+
+// Counts the values in a document without storing them.
+class CountingDelegate : public JSONReader::Delegate {
+ public:
+  CountingDelegate() : count_(0) {}
+  ~CountingDelegate() override {}
+
+  int count() const { return count_; }
+
+  bool OnDictionaryBegin() override { return Count(); }
+  bool OnDictionaryKey(const StringPiece& key) override { return true; }
+  bool OnDictionaryEnd() override { return true; }
+  bool OnListBegin() override { return Count(); }
+  bool OnListEnd() override { return true; }
+  bool OnString(const StringPiece& value) override { return Count(); }
+  bool OnInteger(int value) override { return Count(); }
+  bool OnDouble(double value) override { return Count(); }
+  bool OnBoolean(bool value) override { return Count(); }
+  bool OnNull() override { return Count(); }
+
+ private:
+  bool Count() {
+    count_++;
+    return true;
+  }
+
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingDelegate);
+};
+
+class JSONReaderPerfTest : public testing::TestWithParam<int> {
+ public:
+  JSONReaderPerfTest() {}
+
+  void SetUp() override { json_ = MakeTestDocument(GetParam()); }
+
+ protected:
+  // Runs |parse| kRuns times and prints the average time it took, and where
+  // supported, the heap it kept allocated, which is what the result costs
+  // for as long as it is alive, and the growth of the peak resident set size,
+  // which includes the garbage made while parsing. |parse| returns the
+  // result, which is only destroyed once it has been measured.
+  template <typename Result, typename ParseFunction>
+  void TimeParse(const std::string& trace, const ParseFunction& parse) {
+    const std::string size = SizeTToString(json_.size() / 1024) + "KB";
+    TimeDelta total;
+    size_t retained_bytes = 0;
+    size_t peak_delta_bytes = 0;
+    bool memory_supported = false;
+    for (int i = 0; i < kRuns; ++i) {
+      ScopedPeakMemoryDelta memory;
+      const size_t start_bytes = GetAllocatedBytes();
+      const TimeTicks start = TimeTicks::Now();
+      scoped_ptr<Result> result = parse();
+      total += TimeTicks::Now() - start;
+      ASSERT_TRUE(result);
+      const size_t end_bytes = GetAllocatedBytes();
+      retained_bytes =
+          std::max(retained_bytes,
+                   end_bytes > start_bytes ? end_bytes - start_bytes : 0);
+      memory_supported = memory.supported();
+      peak_delta_bytes = std::max(peak_delta_bytes, memory.GetDeltaBytes());
+    }
+
+    perf_test::PrintResult("json_parse_time", size, trace,
+                           total.InMillisecondsF() / kRuns, "ms", true);
+    if (GetAllocatedBytes()) {
+      perf_test::PrintResult("json_parse_retained_heap", size, trace,
+                             retained_bytes / 1024, "KB", true);
+    }
+    if (memory_supported) {
+      perf_test::PrintResult("json_parse_peak_rss", size, trace,
+                             peak_delta_bytes / 1024, "KB", true);
+    }
+  }
+
+  std::string json_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(JSONReaderPerfTest);
+};
+
+}  // namespace
+
+// Compares building a Value tree with JSONReader::Read(), walking the document
+// with a JSONReader::Delegate, and building a JSONDocument.
+TEST_P(JSONReaderPerfTest, Parse) {
+  TimeParse<Value>("value", [this]() { return JSONReader::Read(json_); });
+
+  TimeParse<CountingDelegate>("delegate", [this]() {
+    scoped_ptr<CountingDelegate> delegate(new CountingDelegate);
+    if (!JSONReader::ReadWithDelegate(json_, JSON_PARSE_RFC, delegate.get(),
+                                      NULL, NULL)) {
+      delegate.reset();
+    }
+    return delegate.Pass();
+  });
+
+  TimeParse<JSONDocument>("document", [this]() {
+    return JSONDocument::Parse(json_, JSON_PARSE_RFC, NULL, NULL);
+  });
+}
+
+// About 2, 10 and 50 MB of JSON.
+INSTANTIATE_TEST_CASE_P(JSONReaderPerfTests,
+                        JSONReaderPerfTest,
+                        testing::Values(10000, 50000, 250000));
+
+}  // namespace base
@@ -9,6 +9,7 @@
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/values.h"
@@ -17,6 +18,54 @@
 
 namespace base {
 
+namespace {
+
+// Records the calls made by JSONReader::ReadWithDelegate() as a string, and
+// stops the parse after |stop_after| calls if it is not negative.
+class RecordingDelegate : public JSONReader::Delegate {
+ public:
+  explicit RecordingDelegate(int stop_after) : stop_after_(stop_after) {}
+  ~RecordingDelegate() override {}
+
+  const std::string& events() const { return events_; }
+
+  bool OnDictionaryBegin() override { return Record("{"); }
+  bool OnDictionaryKey(const StringPiece& key) override {
+    return Record(key.as_string() + ":");
+  }
+  bool OnDictionaryEnd() override { return Record("}"); }
+  bool OnListBegin() override { return Record("["); }
+  bool OnListEnd() override { return Record("]"); }
+  bool OnString(const StringPiece& value) override {
+    return Record("'" + value.as_string() + "'");
+  }
+  bool OnInteger(int value) override {
+    return Record("i" + IntToString(value));
+  }
+  bool OnDouble(double value) override {
+    return Record("d" + DoubleToString(value));
+  }
+  bool OnBoolean(bool value) override {
+    return Record(value ? "true" : "false");
+  }
+  bool OnNull() override { return Record("null"); }
+
+ private:
+  bool Record(const std::string& event) {
+    if (!events_.empty())
+      events_ += " ";
+    events_ += event;
+    return stop_after_ < 0 || --stop_after_ > 0;
+  }
+
+  int stop_after_;
+  std::string events_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingDelegate);
+};
+
+}  // namespace
+
 TEST(JSONReaderTest, Reading) {
   // some whitespace checking
   scoped_ptr<Value> root = JSONReader().ReadToValue("   null   ");
@@ -653,4 +702,72 @@ TEST(JSONReaderTest, IllegalTrailingNull) {
   EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, reader.error_code());
 }
 
+TEST(JSONReaderTest, ReadWithDelegate) {
+  RecordingDelegate delegate(-1);
+  int error_code = -1;
+  EXPECT_TRUE(JSONReader::ReadWithDelegate(
+      "{\"a\": [1, 2.5, \"x\\ny\", true, false, null], \"b\": {}, "
+      "\"c\\u0041\": [] /* comment */}",
+      JSON_PARSE_RFC, &delegate, &error_code, NULL));
+  EXPECT_EQ(
+      "{ a: [ i1 d2.5 'x\ny' true false null ] b: { } cA: [ ] }",
+      delegate.events());
+  // |error_code| is only set on failure.
+  EXPECT_EQ(-1, error_code);
+
+  // Scalars can be the root, as with Read().
+  RecordingDelegate scalar_delegate(-1);
+  EXPECT_TRUE(JSONReader::ReadWithDelegate("\xEF\xBB\xBF  \"root\" ",
+                                           JSON_PARSE_RFC, &scalar_delegate,
+                                           NULL, NULL));
+  EXPECT_EQ("'root'", scalar_delegate.events());
+
+  // Trailing commas follow the options.
+  RecordingDelegate strict_delegate(-1);
+  EXPECT_FALSE(JSONReader::ReadWithDelegate("[1,]", JSON_PARSE_RFC,
+                                            &strict_delegate, &error_code,
+                                            NULL));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, error_code);
+  RecordingDelegate lenient_delegate(-1);
+  EXPECT_TRUE(JSONReader::ReadWithDelegate("[1,]", JSON_ALLOW_TRAILING_COMMAS,
+                                           &lenient_delegate, NULL, NULL));
+  EXPECT_EQ("[ i1 ]", lenient_delegate.events());
+}
+
+TEST(JSONReaderTest, ReadWithDelegateErrors) {
+  // The delegate sees the document up to the error.
+  RecordingDelegate delegate(-1);
+  int error_code = JSONReader::JSON_NO_ERROR;
+  std::string error_message;
+  EXPECT_FALSE(JSONReader::ReadWithDelegate("[1, {\"a\": tru}]", JSON_PARSE_RFC,
+                                            &delegate, &error_code,
+                                            &error_message));
+  EXPECT_EQ("[ i1 { a:", delegate.events());
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, error_code);
+  EXPECT_FALSE(error_message.empty());
+
+  RecordingDelegate after_root_delegate(-1);
+  EXPECT_FALSE(JSONReader::ReadWithDelegate("[] []", JSON_PARSE_RFC,
+                                            &after_root_delegate, &error_code,
+                                            NULL));
+  EXPECT_EQ(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, error_code);
+
+  std::string nested(200, '[');
+  RecordingDelegate nested_delegate(-1);
+  EXPECT_FALSE(JSONReader::ReadWithDelegate(nested, JSON_PARSE_RFC,
+                                            &nested_delegate, &error_code,
+                                            NULL));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, error_code);
+}
+
+TEST(JSONReaderTest, ReadWithDelegateStop) {
+  // Stopping is not an error.
+  RecordingDelegate delegate(3);
+  int error_code = -1;
+  EXPECT_FALSE(JSONReader::ReadWithDelegate("[1, 2, 3, 4]", JSON_PARSE_RFC,
+                                            &delegate, &error_code, NULL));
+  EXPECT_EQ("[ i1 i2", delegate.events());
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, error_code);
+}
+
 }  // namespace base
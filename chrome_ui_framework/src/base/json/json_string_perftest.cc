@@ -0,0 +1,125 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/json/string_escape.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kRuns = 20;
+
+// Site settings and extension state, as in a preferences file: many short
+// keys and values, with URLs and the odd escaped character.
+std::string MakePrefsPayload() {
+  std::string json = "{\"profile\": {\"content_settings\": {\"exceptions\": {";
+  for (int i = 0; i < 20000; ++i) {
+    if (i)
+      json += ",";
+    StringAppendF(&json,
+                  "\"https://www.example%d.com:443,*\": {"
+                  "\"last_modified\": \"13087%08d\", \"setting\": %d}",
+                  i, i, i % 3);
+  }
+  json += "}}}, \"extensions\": {\"settings\": {";
+  for (int i = 0; i < 500; ++i) {
+    if (i)
+      json += ",";
+    StringAppendF(&json,
+                  "\"%032d\": {\"path\": \"/opt/extensions/%032d/1.0.%d_0\", "
+                  "\"manifest\": {\"name\": \"Extension \\\"%d\\\"\", "
+                  "\"description\": \"Adds a button to the toolbar that "
+                  "shows the weather for your location.\\nIncludes a "
+                  "five day forecast.\", \"permissions\": "
+                  "[\"tabs\", \"storage\", \"https://*.example.com/*\"]}}",
+                  i, i, i, i);
+  }
+  json += "}}}";
+  return json;
+}
+
+// Theme manifests: colors, tints and image paths, and long inline images in
+// the data URLs that some themes use.
+std::string MakeThemePayload() {
+  std::string json = "[";
+  for (int i = 0; i < 500; ++i) {
+    if (i)
+      json += ",";
+    StringAppendF(&json,
+                  "{\"name\": \"Theme %d\", \"version\": \"2.%d\", "
+                  "\"theme\": {\"images\": {"
+                  "\"theme_frame\": \"images/theme_frame_%d.png\", "
+                  "\"theme_toolbar\": \"images/theme_toolbar_%d.png\", "
+                  "\"theme_ntp_background\": \"data:image/png;base64,",
+                  i, i, i, i);
+    for (int j = 0; j < 64; ++j)
+      json += "iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mNk";
+    StringAppendF(&json,
+                  "\"}, \"colors\": {\"frame\": [%d, %d, %d], "
+                  "\"toolbar\": [%d, %d, %d], \"ntp_text\": [0, 0, 0]}, "
+                  "\"tints\": {\"buttons\": [0.%d, 0.5, 0.5]}}}",
+                  i % 256, (i * 3) % 256, (i * 7) % 256, (i * 11) % 256,
+                  (i * 13) % 256, (i * 17) % 256, i % 10);
+  }
+  json += "]";
+  return json;
+}
+
+// Times parsing |json|, writing it back, and escaping the result as a
+// string, and prints the throughputs in MB/s of JSON.
+void TimePayload(const std::string& trace, const std::string& json) {
+  const double megabytes = kRuns * json.size() / (1024.0 * 1024.0);
+  perf_test::PrintResult("json_payload_size", "", trace, json.size() / 1024,
+                         "KB", false);
+
+  scoped_ptr<Value> value;
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kRuns; ++i) {
+    value = JSONReader::Read(json);
+    ASSERT_TRUE(value);
+  }
+  perf_test::PrintResult("json_read_throughput", "", trace,
+                         megabytes / (TimeTicks::Now() - start).InSecondsF(),
+                         "MB/s", true);
+
+  std::string written;
+  start = TimeTicks::Now();
+  for (int i = 0; i < kRuns; ++i)
+    ASSERT_TRUE(JSONWriter::Write(*value, &written));
+  perf_test::PrintResult("json_write_throughput", "", trace,
+                         megabytes / (TimeTicks::Now() - start).InSecondsF(),
+                         "MB/s", true);
+
+  std::string escaped;
+  start = TimeTicks::Now();
+  for (int i = 0; i < kRuns; ++i) {
+    escaped.clear();
+    EscapeJSONString(json, true, &escaped);
+  }
+  perf_test::PrintResult("json_escape_throughput", "", trace,
+                         megabytes / (TimeTicks::Now() - start).InSecondsF(),
+                         "MB/s", true);
+}
+
+}  // namespace
+
+TEST(JSONStringPerfTest, Prefs) {
+  TimePayload("prefs", MakePrefsPayload());
+}
+
+TEST(JSONStringPerfTest, Themes) {
+  TimePayload("themes", MakeThemePayload());
+}
+
+}  // namespace base
@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "base/json/string_scan.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversion_utils.h"
@@ -73,6 +74,22 @@ bool EscapeSpecialCodePoint(uint32 code_point, std::string* dest) {
   return true;
 }
 
+// Appends the run of characters starting at |index| of |str| that need no
+// escaping to |dest|, and returns its length.
+size_t AppendPlainRun(const StringPiece& str, int32 index, std::string* dest) {
+  const size_t length = internal::CountPlainJSONStringChars(
+      str.data() + index, str.length() - index);
+  dest->append(str.data() + index, length);
+  return length;
+}
+
+// UTF-16 strings are left to the character by character loop.
+size_t AppendPlainRun(const StringPiece16& str,
+                      int32 index,
+                      std::string* dest) {
+  return 0;
+}
+
 template <typename S>
 bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   bool did_replacement = false;
@@ -85,6 +102,10 @@ bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   const int32 length = static_cast<int32>(str.length());
 
   for (int32 i = 0; i < length; ++i) {
+    i += static_cast<int32>(AppendPlainRun(str, i, dest));
+    if (i == length)
+      break;
+
     uint32 code_point;
     if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point)) {
       code_point = kReplacementCodePoint;
@@ -70,6 +70,29 @@ TEST(JSONStringEscapeTest, EscapeUTF8) {
   EXPECT_TRUE(IsStringUTF8(out));
 }
 
+TEST(JSONStringEscapeTest, EscapeLongUTF8) {
+  // Long runs of plain characters are copied in blocks, so put characters
+  // that need escaping at every offset around the block boundaries.
+  const char* const kSpecials[] = {"\n", "\"", "\\", "<", "\x01"};
+  const char* const kEscaped[] = {"\\n", "\\\"", "\\\\", "\\u003C",
+                                  "\\u0001"};
+  for (size_t i = 0; i < arraysize(kSpecials); ++i) {
+    for (size_t offset = 0; offset < 40; ++offset) {
+      const std::string plain(offset, 'a');
+      std::string out;
+      EXPECT_TRUE(EscapeJSONString(plain + kSpecials[i] + plain + "\xC3\xA9z",
+                                   false, &out));
+      EXPECT_EQ(plain + kEscaped[i] + plain + "\xC3\xA9z", out);
+    }
+  }
+
+  // Invalid UTF-8 after a long run is still replaced.
+  std::string out;
+  EXPECT_FALSE(
+      EscapeJSONString(std::string(20, 'a') + "\xFF", false, &out));
+  EXPECT_EQ(std::string(20, 'a') + "\xEF\xBF\xBD", out);
+}
+
 TEST(JSONStringEscapeTest, EscapeUTF16) {
   const struct {
     const wchar_t* to_escape;
@@ -0,0 +1,58 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/string_scan.h"
+
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+inline bool IsPlainJSONStringChar(unsigned char c) {
+  return c >= 0x20 && c < 0x80 && c != '"' && c != '\\' && c != '<';
+}
+
+}  // namespace
+
+size_t CountPlainJSONStringChars(const char* str, size_t length) {
+  size_t i = 0;
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  // Bytes of 0x80 and above are negative as signed 8-bit integers, so one
+  // signed comparison finds them along with the control characters.
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i less_than = _mm_set1_epi8('<');
+  for (; i + 16 <= length; i += 16) {
+    const __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    __m128i special = _mm_cmplt_epi8(chars, space);
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, quote));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, backslash));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, less_than));
+    int mask = _mm_movemask_epi8(special);
+    if (mask) {
+      while (!(mask & 1)) {
+        mask >>= 1;
+        ++i;
+      }
+      return i;
+    }
+  }
+#endif
+
+  while (i < length && IsPlainJSONStringChar(str[i]))
+    ++i;
+  return i;
+}
+
+}  // namespace internal
+}  // namespace base
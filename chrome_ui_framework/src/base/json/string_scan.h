@@ -0,0 +1,26 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_STRING_SCAN_H_
+#define BASE_JSON_STRING_SCAN_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+
+namespace base {
+namespace internal {
+
+// Returns the length of the run of characters at the start of the |length|
+// bytes at |str| that JSON strings hold as they are: printable ASCII other
+// than '"' and '\\'. '<' also ends a run, since the writer escapes it. Most
+// strings in preferences and themes are made of such runs, which both the
+// parser and the writer copy without looking at each character; on x86 they
+// are scanned 16 bytes at a time.
+BASE_EXPORT size_t CountPlainJSONStringChars(const char* str, size_t length);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_JSON_STRING_SCAN_H_
@@ -10,6 +10,7 @@
 #include "base/message_loop/message_loop.h"
 #include "base/metrics/histogram.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 
 namespace base {
@@ -39,13 +40,34 @@ bool AlwaysNotifyPump(MessageLoop::Type type) {
 
 }  // namespace
 
+struct IncomingTaskQueue::TaskNode : public IncomingTaskQueue::Node {
+  explicit TaskNode(const PendingTask& task) : pending_task(task) {}
+
+  PendingTask pending_task;
+};
+
 IncomingTaskQueue::IncomingTaskQueue(MessageLoop* message_loop)
-    : high_res_task_count_(0),
+    : IncomingTaskQueue(message_loop, LOCKED_QUEUE) {
+}
+
+IncomingTaskQueue::IncomingTaskQueue(MessageLoop* message_loop,
+                                     QueueType queue_type)
+    : queue_type_(queue_type),
+      high_res_task_count_(0),
       message_loop_(message_loop),
       next_sequence_num_(0),
       message_loop_scheduled_(false),
       always_schedule_work_(AlwaysNotifyPump(message_loop_->type())),
-      is_ready_for_scheduling_(false) {
+      is_ready_for_scheduling_(false),
+      lock_free_head_(&stub_),
+      lock_free_tail_(reinterpret_cast<subtle::AtomicWord>(&stub_)),
+      lock_free_scheduled_(0),
+      lock_free_ready_for_scheduling_(0),
+      active_posters_(0),
+      shutting_down_(0) {
+  // The first task pushed gets sequence number 0.
+  stub_.sequence_num = -1;
+  subtle::NoBarrier_Store(&stub_.has_sequence_num, 1);
 }
 
 bool IncomingTaskQueue::AddToIncomingQueue(
@@ -58,6 +80,18 @@ bool IncomingTaskQueue::AddToIncomingQueue(
       << "Requesting super-long task delay period of " << delay.InSeconds()
       << " seconds from here: " << from_here.ToString();
 
+  if (queue_type_ == LOCK_FREE_QUEUE) {
+    PendingTask pending_task(
+        from_here, task, CalculateDelayedRuntime(delay), nestable);
+#if defined(OS_WIN)
+    if (delay > TimeDelta() &&
+        delay.InMilliseconds() < (2 * Time::kMinLowResolutionThresholdMs)) {
+      pending_task.is_high_res = true;
+    }
+#endif
+    return PostPendingTaskLockFree(&pending_task);
+  }
+
   AutoLock locked(incoming_queue_lock_);
   PendingTask pending_task(
       from_here, task, CalculateDelayedRuntime(delay), nestable);
@@ -68,7 +102,7 @@ bool IncomingTaskQueue::AddToIncomingQueue(
   // resolution on Windows is between 10 and 15ms.
   if (delay > TimeDelta() &&
       delay.InMilliseconds() < (2 * Time::kMinLowResolutionThresholdMs)) {
-    ++high_res_task_count_;
+    subtle::NoBarrier_AtomicIncrement(&high_res_task_count_, 1);
     pending_task.is_high_res = true;
   }
 #endif
@@ -76,11 +110,15 @@ bool IncomingTaskQueue::AddToIncomingQueue(
 }
 
 bool IncomingTaskQueue::HasHighResolutionTasks() {
+  if (queue_type_ == LOCK_FREE_QUEUE)
+    return subtle::Acquire_Load(&high_res_task_count_) > 0;
   AutoLock lock(incoming_queue_lock_);
   return high_res_task_count_ > 0;
 }
 
 bool IncomingTaskQueue::IsIdleForTesting() {
+  if (queue_type_ == LOCK_FREE_QUEUE)
+    return IsEmptyLockFree();
   AutoLock lock(incoming_queue_lock_);
   return incoming_queue_.empty();
 }
@@ -89,6 +127,9 @@ int IncomingTaskQueue::ReloadWorkQueue(TaskQueue* work_queue) {
   // Make sure no tasks are lost.
   DCHECK(work_queue->empty());
 
+  if (queue_type_ == LOCK_FREE_QUEUE)
+    return ReloadWorkQueueLockFree(work_queue);
+
   // Acquire all we can from the inter-thread queue with one lock acquisition.
   AutoLock lock(incoming_queue_lock_);
   if (incoming_queue_.empty()) {
@@ -106,11 +147,25 @@ int IncomingTaskQueue::ReloadWorkQueue(TaskQueue* work_queue) {
 }
 
 void IncomingTaskQueue::WillDestroyCurrentMessageLoop() {
+  if (queue_type_ == LOCK_FREE_QUEUE) {
+    // Refuse new posts, then wait for the ones that have already checked
+    // |shutting_down_| to finish with |message_loop_|. Posting only takes a
+    // handful of instructions, so spinning is cheaper than a condition
+    // variable here.
+    subtle::NoBarrier_Store(&shutting_down_, 1);
+    subtle::MemoryBarrier();
+    while (subtle::Acquire_Load(&active_posters_) != 0)
+      PlatformThread::YieldCurrentThread();
+  }
   AutoLock lock(incoming_queue_lock_);
   message_loop_ = NULL;
 }
 
 void IncomingTaskQueue::StartScheduling() {
+  if (queue_type_ == LOCK_FREE_QUEUE) {
+    StartSchedulingLockFree();
+    return;
+  }
   AutoLock lock(incoming_queue_lock_);
   DCHECK(!is_ready_for_scheduling_);
   DCHECK(!message_loop_scheduled_);
@@ -122,6 +177,12 @@ void IncomingTaskQueue::StartScheduling() {
 IncomingTaskQueue::~IncomingTaskQueue() {
   // Verify that WillDestroyCurrentMessageLoop() has been called.
   DCHECK(!message_loop_);
+
+  // Tasks left in the lock-free list are destroyed here, just like the ones
+  // left in |incoming_queue_|.
+  while (TaskNode* node = Pop())
+    delete node;
+  DCHECK(IsEmptyLockFree());
 }
 
 TimeTicks IncomingTaskQueue::CalculateDelayedRuntime(TimeDelta delay) {
@@ -178,5 +239,132 @@ void IncomingTaskQueue::ScheduleWork() {
   message_loop_scheduled_ = true;
 }
 
+bool IncomingTaskQueue::PostPendingTaskLockFree(PendingTask* pending_task) {
+  // Announce this poster before looking at |shutting_down_|. Both operations
+  // are full barriers, so either WillDestroyCurrentMessageLoop() sees the
+  // poster and waits for it, or the poster sees the shutdown and bails out.
+  subtle::Barrier_AtomicIncrement(&active_posters_, 1);
+  if (subtle::NoBarrier_Load(&shutting_down_)) {
+    subtle::Barrier_AtomicIncrement(&active_posters_, -1);
+    pending_task->task.Reset();
+    return false;
+  }
+
+  if (pending_task->is_high_res)
+    subtle::Barrier_AtomicIncrement(&high_res_task_count_, 1);
+
+  // The sequence number is only known once the task is in the list. The loop
+  // may run the task from then on, so the annotation uses |pending_task|.
+  pending_task->sequence_num = Push(new TaskNode(*pending_task));
+  message_loop_->task_annotator()->DidQueueTask("MessageLoop::PostTask",
+                                                *pending_task);
+  pending_task->task.Reset();
+
+  // Pairs with the barrier in ReloadWorkQueueLockFree(): either the loop sees
+  // the task pushed above, or this thread sees the loop went idle.
+  subtle::MemoryBarrier();
+  if (subtle::NoBarrier_Load(&lock_free_ready_for_scheduling_) &&
+      (always_schedule_work_ ||
+       !subtle::NoBarrier_AtomicExchange(&lock_free_scheduled_, 1))) {
+    message_loop_->ScheduleWork();
+  }
+
+  subtle::Barrier_AtomicIncrement(&active_posters_, -1);
+  return true;
+}
+
+int IncomingTaskQueue::ReloadWorkQueueLockFree(TaskQueue* work_queue) {
+  PopAll(work_queue);
+  if (work_queue->empty()) {
+    // The loop is about to sleep. Clear the flag, then look once more: a
+    // poster that pushed after PopAll() but still saw the flag set did not
+    // schedule, so its task has to be picked up here.
+    subtle::NoBarrier_Store(&lock_free_scheduled_, 0);
+    subtle::MemoryBarrier();
+    PopAll(work_queue);
+  }
+  return subtle::NoBarrier_AtomicExchange(&high_res_task_count_, 0);
+}
+
+void IncomingTaskQueue::StartSchedulingLockFree() {
+  DCHECK(!subtle::NoBarrier_Load(&lock_free_ready_for_scheduling_));
+  subtle::NoBarrier_Store(&lock_free_ready_for_scheduling_, 1);
+  subtle::MemoryBarrier();
+  // Tasks posted before this point did not schedule work.
+  if (!IsEmptyLockFree() &&
+      !subtle::NoBarrier_AtomicExchange(&lock_free_scheduled_, 1)) {
+    message_loop_->ScheduleWork();
+  }
+}
+
+int IncomingTaskQueue::Push(Node* node) {
+  subtle::NoBarrier_Store(&node->next, 0);
+  subtle::NoBarrier_Store(&node->has_sequence_num, 0);
+  // Claim the tail, then link the previous tail to |node|. Between the two
+  // steps the list is briefly disconnected; the consumer treats that as empty.
+  subtle::MemoryBarrier();
+  Node* prev = reinterpret_cast<Node*>(subtle::NoBarrier_AtomicExchange(
+      &lock_free_tail_, reinterpret_cast<subtle::AtomicWord>(node)));
+
+  // |prev| can't be popped before it is linked to |node|. Its own push may
+  // still be about to number it.
+  while (!subtle::Acquire_Load(&prev->has_sequence_num))
+    PlatformThread::YieldCurrentThread();
+  // The stub is not a task, so it keeps the number of the task before it.
+  // Wraps around like the locked queue does.
+  node->sequence_num =
+      node == &stub_ ? prev->sequence_num
+                     : static_cast<int>(
+                           static_cast<uint32>(prev->sequence_num) + 1);
+  const int sequence_num = node->sequence_num;
+  subtle::Release_Store(&node->has_sequence_num, 1);
+
+  subtle::Release_Store(&prev->next,
+                        reinterpret_cast<subtle::AtomicWord>(node));
+  return sequence_num;
+}
+
+IncomingTaskQueue::TaskNode* IncomingTaskQueue::Pop() {
+  Node* head = lock_free_head_;
+  Node* next = reinterpret_cast<Node*>(subtle::Acquire_Load(&head->next));
+  if (head == &stub_) {
+    if (!next)
+      return NULL;
+    lock_free_head_ = next;
+    head = next;
+    next = reinterpret_cast<Node*>(subtle::Acquire_Load(&next->next));
+  }
+  if (next) {
+    lock_free_head_ = next;
+    return static_cast<TaskNode*>(head);
+  }
+  Node* tail = reinterpret_cast<Node*>(subtle::Acquire_Load(&lock_free_tail_));
+  if (tail != head)
+    return NULL;  // A push is in progress.
+  // |head| is the last node. Put the stub back behind it so that it can be
+  // unlinked without racing with the next push.
+  Push(&stub_);
+  next = reinterpret_cast<Node*>(subtle::Acquire_Load(&head->next));
+  if (next) {
+    lock_free_head_ = next;
+    return static_cast<TaskNode*>(head);
+  }
+  return NULL;
+}
+
+void IncomingTaskQueue::PopAll(TaskQueue* work_queue) {
+  while (TaskNode* node = Pop()) {
+    node->pending_task.sequence_num = node->sequence_num;
+    work_queue->push(node->pending_task);
+    delete node;
+  }
+}
+
+bool IncomingTaskQueue::IsEmptyLockFree() const {
+  return lock_free_head_ == &stub_ &&
+         subtle::Acquire_Load(&lock_free_tail_) ==
+             reinterpret_cast<subtle::AtomicWord>(&stub_);
+}
+
 }  // namespace internal
 }  // namespace base
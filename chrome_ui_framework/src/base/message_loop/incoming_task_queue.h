@@ -5,6 +5,7 @@
 #ifndef BASE_MESSAGE_LOOP_INCOMING_TASK_QUEUE_H_
 #define BASE_MESSAGE_LOOP_INCOMING_TASK_QUEUE_H_
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/memory/ref_counted.h"
 #include "base/pending_task.h"
@@ -24,7 +25,18 @@ namespace internal {
 class BASE_EXPORT IncomingTaskQueue
     : public RefCountedThreadSafe<IncomingTaskQueue> {
  public:
+  // Selects how posting threads hand tasks over to the loop's thread.
+  enum QueueType {
+    // Every post and every reload takes |incoming_queue_lock_|.
+    LOCKED_QUEUE,
+    // Posting threads push onto a lock-free multi-producer, single-consumer
+    // list which the loop's thread drains without taking a lock. This avoids
+    // convoying when many threads post to the same loop.
+    LOCK_FREE_QUEUE,
+  };
+
   explicit IncomingTaskQueue(MessageLoop* message_loop);
+  IncomingTaskQueue(MessageLoop* message_loop, QueueType queue_type);
 
   // Appends a task to the incoming queue. Posting of all tasks is routed though
   // AddToIncomingQueue() or TryAddToIncomingQueue() to make sure that posting
@@ -45,7 +57,7 @@ class BASE_EXPORT IncomingTaskQueue
   // Returns true if the message loop is "idle". Provided for testing.
   bool IsIdleForTesting();
 
-  // Loads tasks from the |incoming_queue_| into |*work_queue|. Must be called
+  // Loads tasks from the incoming queue into |*work_queue|. Must be called
   // from the thread that is running the loop. Returns the number of tasks that
   // require high resolution timers.
   int ReloadWorkQueue(TaskQueue* work_queue);
@@ -57,8 +69,22 @@ class BASE_EXPORT IncomingTaskQueue
   // scheduling work.
   void StartScheduling();
 
+  QueueType queue_type() const { return queue_type_; }
+
  private:
   friend class RefCountedThreadSafe<IncomingTaskQueue>;
+
+  // A link in the lock-free incoming list. |next| holds a Node*. Push() gives
+  // each node the sequence number that follows the one of the node before
+  // it, and sets |has_sequence_num| once |sequence_num| can be read.
+  struct Node {
+    Node() : next(0), sequence_num(0), has_sequence_num(0) {}
+    subtle::AtomicWord next;
+    int sequence_num;
+    subtle::Atomic32 has_sequence_num;
+  };
+  struct TaskNode;
+
   virtual ~IncomingTaskQueue();
 
   // Calculates the time at which a PendingTask should run.
@@ -73,9 +99,30 @@ class BASE_EXPORT IncomingTaskQueue
   // Wakes up the message loop and schedules work.
   void ScheduleWork();
 
+  // LOCK_FREE_QUEUE counterparts of the functions above. Posting takes no lock;
+  // reloading is only ever done by the loop's thread.
+  bool PostPendingTaskLockFree(PendingTask* pending_task);
+  int ReloadWorkQueueLockFree(TaskQueue* work_queue);
+  void StartSchedulingLockFree();
+
+  // Intrusive multi-producer, single-consumer list (D. Vyukov). Push() may be
+  // called from any thread. Pop() and PopAll() may only be called by the
+  // consumer; they return NULL/stop early while a push is half-way done, in
+  // which case the pushing thread is still going to schedule work if needed.
+  // Push() numbers the task nodes in the order of the list, so that the
+  // sequence numbers of the tasks follow the order they run in. A push waits
+  // for the push before it to number its node, which takes a few instructions.
+  // Returns the sequence number of |node|.
+  int Push(Node* node);
+  TaskNode* Pop();
+  void PopAll(TaskQueue* work_queue);
+  bool IsEmptyLockFree() const;
+
+  const QueueType queue_type_;
+
   // Number of tasks that require high resolution timing. This value is kept
   // so that ReloadWorkQueue() completes in constant time.
-  int high_res_task_count_;
+  subtle::Atomic32 high_res_task_count_;
 
   // The lock that protects access to the members of this class.
   base::Lock incoming_queue_lock_;
@@ -88,11 +135,13 @@ class BASE_EXPORT IncomingTaskQueue
   // Points to the message loop that owns |this|.
   MessageLoop* message_loop_;
 
-  // The next sequence number to use for delayed tasks.
+  // The next sequence number to use for delayed tasks. Only used by
+  // LOCKED_QUEUE, where it is read and incremented with the task pushed.
   int next_sequence_num_;
 
   // True if our message loop has already been scheduled and does not need to be
-  // scheduled again until an empty reload occurs.
+  // scheduled again until an empty reload occurs. Only used by LOCKED_QUEUE;
+  // see |lock_free_scheduled_| for LOCK_FREE_QUEUE.
   bool message_loop_scheduled_;
 
   // True if we always need to call ScheduleWork when receiving a new task, even
@@ -102,6 +151,24 @@ class BASE_EXPORT IncomingTaskQueue
   // False until StartScheduling() is called.
   bool is_ready_for_scheduling_;
 
+  // State of the LOCK_FREE_QUEUE. |lock_free_head_| and |stub_| are only
+  // touched by the loop's thread (and by the destructor); |lock_free_tail_|
+  // holds the Node* most recently pushed by any thread.
+  Node* lock_free_head_;
+  subtle::AtomicWord lock_free_tail_;
+  Node stub_;
+
+  // Atomic counterparts of |message_loop_scheduled_| and
+  // |is_ready_for_scheduling_| for LOCK_FREE_QUEUE.
+  subtle::Atomic32 lock_free_scheduled_;
+  subtle::Atomic32 lock_free_ready_for_scheduling_;
+
+  // Number of threads currently inside PostPendingTaskLockFree(), and whether
+  // WillDestroyCurrentMessageLoop() has been called. Together they let the
+  // loop's thread wait out posters that still dereference |message_loop_|.
+  subtle::Atomic32 active_posters_;
+  subtle::Atomic32 shutting_down_;
+
   DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
 };
 
@@ -0,0 +1,115 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/incoming_task_queue.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+const int kThreadCount = 8;
+const int kTasksPerThread = 1000;
+
+class LockFreeIncomingTaskQueueTest : public testing::Test {
+ public:
+  LockFreeIncomingTaskQueueTest() {}
+
+  void SetUp() override { MessageLoop::EnableLockFreeIncomingQueue(true); }
+  void TearDown() override { MessageLoop::EnableLockFreeIncomingQueue(false); }
+
+  // Records that task |index| posted by |thread| ran.
+  void RecordTask(int thread, int index) {
+    AutoLock lock(lock_);
+    runs_.push_back(std::make_pair(thread, index));
+  }
+
+ protected:
+  Lock lock_;
+  std::vector<std::pair<int, int>> runs_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LockFreeIncomingTaskQueueTest);
+};
+
+void AppendToVector(std::vector<int>* order, int value) {
+  order->push_back(value);
+}
+
+}  // namespace
+
+TEST_F(LockFreeIncomingTaskQueueTest, RunsTasksInPostOrder) {
+  MessageLoop loop;
+  std::vector<int> order;
+  for (int i = 0; i < 100; ++i)
+    loop.PostTask(FROM_HERE, Bind(&AppendToVector, &order, i));
+  loop.PostDelayedTask(FROM_HERE, Bind(&AppendToVector, &order, 101),
+                       TimeDelta::FromMilliseconds(1));
+  loop.PostTask(FROM_HERE, Bind(&AppendToVector, &order, 100));
+  RunLoop run_loop;
+  loop.PostDelayedTask(FROM_HERE, run_loop.QuitClosure(),
+                       TimeDelta::FromMilliseconds(10));
+  run_loop.Run();
+
+  ASSERT_EQ(102U, order.size());
+  for (int i = 0; i < 102; ++i)
+    EXPECT_EQ(i, order[i]);
+}
+
+TEST_F(LockFreeIncomingTaskQueueTest, ManyPostingThreads) {
+  MessageLoop loop;
+  scoped_refptr<SingleThreadTaskRunner> task_runner = loop.task_runner();
+  ScopedVector<Thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.push_back(new Thread("poster"));
+    ASSERT_TRUE(threads.back()->Start());
+  }
+
+  for (int t = 0; t < kThreadCount; ++t) {
+    for (int i = 0; i < kTasksPerThread; ++i) {
+      threads[t]->task_runner()->PostTask(
+          FROM_HERE,
+          Bind(IgnoreResult(&SingleThreadTaskRunner::PostTask), task_runner,
+               tracked_objects::Location(),
+               Bind(&LockFreeIncomingTaskQueueTest::RecordTask,
+                    Unretained(this), t, i)));
+    }
+  }
+  // Stopping the threads flushes everything they were asked to post.
+  for (Thread* thread : threads)
+    thread->Stop();
+  RunLoop().RunUntilIdle();
+
+  // Every task ran exactly once, and tasks from the same thread kept their
+  // relative order.
+  ASSERT_EQ(static_cast<size_t>(kThreadCount * kTasksPerThread),
+            runs_.size());
+  std::vector<int> next_index(kThreadCount, 0);
+  for (const auto& run : runs_)
+    EXPECT_EQ(next_index[run.first]++, run.second);
+}
+
+TEST_F(LockFreeIncomingTaskQueueTest, RejectsTasksAfterLoopDestruction) {
+  scoped_refptr<SingleThreadTaskRunner> task_runner;
+  {
+    MessageLoop loop;
+    task_runner = loop.task_runner();
+    EXPECT_TRUE(task_runner->PostTask(FROM_HERE, Bind(&DoNothing)));
+  }
+  EXPECT_FALSE(task_runner->PostTask(FROM_HERE, Bind(&DoNothing)));
+}
+
+}  // namespace internal
+}  // namespace base
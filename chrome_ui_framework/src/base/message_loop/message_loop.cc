@@ -85,6 +85,8 @@ const LinearHistogram::DescriptionPair event_descriptions_[] = {
 
 bool enable_histogrammer_ = false;
 
+bool enable_lock_free_incoming_queue_ = false;
+
 MessageLoop::MessagePumpFactory* message_pump_for_ui_factory_ = NULL;
 
 #if defined(OS_IOS)
@@ -191,6 +193,11 @@ void MessageLoop::EnableHistogrammer(bool enable) {
   enable_histogrammer_ = enable;
 }
 
+// static
+void MessageLoop::EnableLockFreeIncomingQueue(bool enable) {
+  enable_lock_free_incoming_queue_ = enable;
+}
+
 // static
 bool MessageLoop::InitMessagePumpForUIFactory(MessagePumpFactory* factory) {
   if (message_pump_for_ui_factory_)
@@ -388,7 +395,10 @@ MessageLoop::MessageLoop(Type type, MessagePumpFactoryCallback pump_factory)
       pump_factory_(pump_factory),
       message_histogram_(NULL),
       run_loop_(NULL),
-      incoming_task_queue_(new internal::IncomingTaskQueue(this)),
+      incoming_task_queue_(new internal::IncomingTaskQueue(
+          this, enable_lock_free_incoming_queue_
+                    ? internal::IncomingTaskQueue::LOCK_FREE_QUEUE
+                    : internal::IncomingTaskQueue::LOCKED_QUEUE)),
       unbound_task_runner_(
           new internal::MessageLoopTaskRunner(incoming_task_queue_)),
       task_runner_(unbound_task_runner_) {
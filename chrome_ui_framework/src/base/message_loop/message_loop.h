@@ -122,6 +122,10 @@ class BASE_EXPORT MessageLoop : public MessagePump::Delegate {
 
   static void EnableHistogrammer(bool enable_histogrammer);
 
+  // Makes MessageLoops created after this call use a lock-free incoming task
+  // queue, which scales better when many threads post to the same loop.
+  static void EnableLockFreeIncomingQueue(bool enable);
+
   typedef scoped_ptr<MessagePump> (MessagePumpFactory)();
   // Uses the given base::MessagePumpForUIFactory to override the default
   // MessagePump implementation for 'TYPE_UI'. Returns true if the factory
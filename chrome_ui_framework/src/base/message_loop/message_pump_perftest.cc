@@ -297,4 +297,86 @@ TEST_F(PostTaskTest, OneHundredTasksPerReload) {
   Run(1000, 100);
 }
 
+// Measures posting throughput when several threads post to the same incoming
+// queue while the loop's thread keeps draining it.
+class PostTaskContentionTest : public testing::Test {
+ public:
+  void Run(internal::IncomingTaskQueue::QueueType queue_type,
+           int num_threads) {
+    MessageLoop loop(scoped_ptr<MessagePump>(new FakeMessagePump));
+    scoped_refptr<internal::IncomingTaskQueue> queue(
+        new internal::IncomingTaskQueue(&loop, queue_type));
+
+    ScopedVector<Thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(new Thread(StringPrintf("poster_%d", i)));
+      threads.back()->Start();
+    }
+
+    WaitableEvent start_event(true, false);
+    const int tasks_per_thread = kTotalTasks / num_threads;
+    for (Thread* thread : threads) {
+      thread->task_runner()->PostTask(
+          FROM_HERE, Bind(&PostTaskContentionTest::PostTasks, queue,
+                          &start_event, tasks_per_thread));
+    }
+
+    const uint32_t num_posted = tasks_per_thread * num_threads;
+    uint32_t num_run = 0;
+    TimeTicks start = TimeTicks::Now();
+    start_event.Signal();
+    while (num_run < num_posted) {
+      TaskQueue loop_local_queue;
+      queue->ReloadWorkQueue(&loop_local_queue);
+      while (!loop_local_queue.empty()) {
+        PendingTask t = loop_local_queue.front();
+        loop_local_queue.pop();
+        loop.RunTask(t);
+        num_run++;
+      }
+    }
+    TimeTicks end = TimeTicks::Now();
+
+    for (Thread* thread : threads)
+      thread->Stop();
+    queue->WillDestroyCurrentMessageLoop();
+
+    std::string trace = StringPrintf(
+        "%s_%d_threads",
+        queue_type == internal::IncomingTaskQueue::LOCK_FREE_QUEUE ? "lock_free"
+                                                                   : "locked",
+        num_threads);
+    perf_test::PrintResult(
+        "task_contended",
+        "",
+        trace,
+        (end - start).InMicroseconds() / static_cast<double>(num_posted),
+        "us/task",
+        true);
+  }
+
+ private:
+  static void PostTasks(scoped_refptr<internal::IncomingTaskQueue> queue,
+                        WaitableEvent* start_event,
+                        int count) {
+    start_event->Wait();
+    for (int i = 0; i < count; ++i) {
+      queue->AddToIncomingQueue(
+          FROM_HERE, base::Bind(&DoNothing), base::TimeDelta(), false);
+    }
+  }
+
+  static const int kTotalTasks = 1 << 20;
+};
+
+TEST_F(PostTaskContentionTest, Locked) {
+  for (int num_threads = 1; num_threads <= 32; num_threads *= 2)
+    Run(internal::IncomingTaskQueue::LOCKED_QUEUE, num_threads);
+}
+
+TEST_F(PostTaskContentionTest, LockFree) {
+  for (int num_threads = 1; num_threads <= 32; num_threads *= 2)
+    Run(internal::IncomingTaskQueue::LOCK_FREE_QUEUE, num_threads);
+}
+
 }  // namespace base
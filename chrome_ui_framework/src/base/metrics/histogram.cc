@@ -19,6 +19,7 @@
 #include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/sample_vector.h"
+#include "base/metrics/sharded_sample_vector.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/pickle.h"
 #include "base/strings/string_util.h"
@@ -287,7 +288,10 @@ void Histogram::AddCount(int value, int count) {
     NOTREACHED();
     return;
   }
-  samples_->Accumulate(value, count);
+  if (flags() & kShardedSamplesFlag)
+    GetShardedSamples()->Accumulate(value, count);
+  else
+    samples_->Accumulate(value, count);
 
   FindAndRunCallback(value);
 }
@@ -333,12 +337,15 @@ Histogram::Histogram(const std::string& name,
   : HistogramBase(name),
     bucket_ranges_(ranges),
     declared_min_(minimum),
-    declared_max_(maximum) {
+    declared_max_(maximum),
+    sharded_samples_(0) {
   if (ranges)
     samples_.reset(new SampleVector(ranges));
 }
 
 Histogram::~Histogram() {
+  delete reinterpret_cast<ShardedSampleVector*>(
+      subtle::NoBarrier_Load(&sharded_samples_));
 }
 
 bool Histogram::PrintEmptyBucket(size_t index) const {
@@ -394,9 +401,33 @@ HistogramBase* Histogram::DeserializeInfoImpl(PickleIterator* iter) {
 scoped_ptr<SampleVector> Histogram::SnapshotSampleVector() const {
   scoped_ptr<SampleVector> samples(new SampleVector(bucket_ranges()));
   samples->Add(*samples_);
+  const ShardedSampleVector* sharded_samples =
+      reinterpret_cast<ShardedSampleVector*>(
+          subtle::Acquire_Load(&sharded_samples_));
+  if (sharded_samples)
+    sharded_samples->AddTo(samples.get());
   return samples.Pass();
 }
 
+ShardedSampleVector* Histogram::GetShardedSamples() {
+  subtle::AtomicWord sharded_samples = subtle::Acquire_Load(&sharded_samples_);
+  if (!sharded_samples) {
+    // Threads that add the first samples at the same time race to create the
+    // shards, and all but one delete theirs.
+    scoped_ptr<ShardedSampleVector> new_sharded_samples(
+        new ShardedSampleVector(samples_.get()));
+    sharded_samples =
+        reinterpret_cast<subtle::AtomicWord>(new_sharded_samples.get());
+    if (subtle::Release_CompareAndSwap(&sharded_samples_, 0,
+                                       sharded_samples) == 0) {
+      ignore_result(new_sharded_samples.release());
+    } else {
+      sharded_samples = subtle::Acquire_Load(&sharded_samples_);
+    }
+  }
+  return reinterpret_cast<ShardedSampleVector*>(sharded_samples);
+}
+
 void Histogram::WriteAsciiImpl(bool graph_it,
                                const std::string& newline,
                                std::string* output) const {
@@ -92,6 +92,7 @@ class LinearHistogram;
 class Pickle;
 class PickleIterator;
 class SampleVector;
+class ShardedSampleVector;
 
 class BASE_EXPORT Histogram : public HistogramBase {
  public:
@@ -220,7 +221,11 @@ class BASE_EXPORT Histogram : public HistogramBase {
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, CorruptSampleCounts);
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, NameMatchTest);
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, AddCountTest);
+  FRIEND_TEST_ALL_PREFIXES(HistogramTest, ShardedSamplesTest);
+  FRIEND_TEST_ALL_PREFIXES(PersistentHistogramAllocatorTest,
+                           DuplicateNotAllocated);
 
+  friend class PersistentHistogramAllocator;  // To move the samples.
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
   friend class StatisticsRecorderTest;
 
@@ -231,6 +236,10 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // Implementation of SnapshotSamples function.
   scoped_ptr<SampleVector> SnapshotSampleVector() const;
 
+  // Returns the shards that count the samples when kShardedSamplesFlag is
+  // set, creating them on first use.
+  ShardedSampleVector* GetShardedSamples();
+
   //----------------------------------------------------------------------------
   // Helpers for emitting Ascii graphic.  Each method appends data to output.
 
@@ -269,6 +278,10 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // sample.
   scoped_ptr<SampleVector> samples_;
 
+  // The ShardedSampleVector of |samples_|, or 0 until a sample is added with
+  // kShardedSamplesFlag set. Owned.
+  subtle::AtomicWord sharded_samples_;
+
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
 
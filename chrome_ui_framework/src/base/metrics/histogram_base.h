@@ -80,6 +80,17 @@ class BASE_EXPORT HistogramBase {
     // to shortcut looking up the callback if it doesn't exist.
     kCallbackExists = 0x20,
 
+    // Only for Histogram and its sub classes: samples are counted in per-CPU
+    // shards, so that threads that record samples at the same time do not
+    // contend for the same cache lines. This costs memory for each shard, so
+    // it is only worth it for histograms that are hot on many threads.
+    kShardedSamplesFlag = 0x40,
+
+    // Only for Histogram and its sub classes: the samples are kept in the
+    // memory of a PersistentHistogramAllocator, where other processes can
+    // read them.
+    kIsPersistent = 0x80,
+
     // Only for Histogram and its sub classes: fancy bucket-naming support.
     kHexRangePrintingFlag = 0x8000,
   };
@@ -86,6 +86,11 @@ void HistogramDeltaSerialization::RecordDelta(
     const HistogramSamples& snapshot) {
   DCHECK_NE(0, snapshot.TotalCount());
 
+  // The process that maps the segment of a persistent histogram merges its
+  // samples from there.
+  if (histogram.flags() & HistogramBase::kIsPersistent)
+    return;
+
   Pickle pickle;
   histogram.SerializeInfo(&pickle);
   snapshot.Serialize(&pickle);
@@ -0,0 +1,174 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+const int kHistogramCount = 100;
+const int kOperationsPerThread = 200000;
+
+// Waits for |start_event|, then runs |operation| kOperationsPerThread times
+// with the index of the operation.
+class OperationThread : public SimpleThread {
+ public:
+  OperationThread(WaitableEvent* start_event,
+                  const Callback<void(int)>& operation)
+      : SimpleThread("OperationThread"),
+        start_event_(start_event),
+        operation_(operation) {}
+
+  void Run() override {
+    start_event_->Wait();
+    for (int i = 0; i < kOperationsPerThread; ++i)
+      operation_.Run(i);
+  }
+
+ private:
+  WaitableEvent* start_event_;
+  Callback<void(int)> operation_;
+
+  DISALLOW_COPY_AND_ASSIGN(OperationThread);
+};
+
+// The histograms in a map guarded by a lock, as StatisticsRecorder kept them
+// before its lookups stopped taking the lock.
+class LockedHistogramMap {
+ public:
+  LockedHistogramMap() {}
+
+  void Add(HistogramBase* histogram) {
+    AutoLock auto_lock(lock_);
+    histograms_[histogram->histogram_name()] = histogram;
+  }
+
+  HistogramBase* Find(const std::string& name) {
+    AutoLock auto_lock(lock_);
+    std::map<std::string, HistogramBase*>::const_iterator it =
+        histograms_.find(name);
+    return it == histograms_.end() ? NULL : it->second;
+  }
+
+ private:
+  Lock lock_;
+  std::map<std::string, HistogramBase*> histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedHistogramMap);
+};
+
+void FindInLockedMap(LockedHistogramMap* map,
+                     const std::vector<std::string>* names,
+                     int index) {
+  CHECK(map->Find((*names)[index % names->size()]));
+}
+
+void FindInStatisticsRecorder(const std::vector<std::string>* names,
+                              int index) {
+  CHECK(StatisticsRecorder::FindHistogram((*names)[index % names->size()]));
+}
+
+void AddSample(HistogramBase* histogram, int index) {
+  histogram->Add(index & 0xff);
+}
+
+class HistogramPerfTest : public testing::TestWithParam<int> {
+ public:
+  HistogramPerfTest() {}
+
+  void SetUp() override {
+    StatisticsRecorder::Initialize();
+    for (int i = 0; i < kHistogramCount; ++i)
+      names_.push_back("HistogramPerfTest.Histogram" + IntToString(i));
+  }
+
+ protected:
+  // Runs |operation| on GetParam() threads at once, and prints the average
+  // wall time per operation. The time goes down as threads are added on as
+  // many cores, unless the threads contend.
+  void TimeOperation(const std::string& measurement,
+                     const std::string& trace,
+                     const Callback<void(int)>& operation) {
+    const int thread_count = GetParam();
+    WaitableEvent start_event(true, false);
+    ScopedVector<OperationThread> threads;
+    for (int i = 0; i < thread_count; ++i) {
+      threads.push_back(new OperationThread(&start_event, operation));
+      threads.back()->Start();
+    }
+
+    const TimeTicks start = TimeTicks::Now();
+    start_event.Signal();
+    for (int i = 0; i < thread_count; ++i)
+      threads[i]->Join();
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    perf_test::PrintResult(
+        measurement, IntToString(thread_count) + "_threads", trace,
+        elapsed.InSecondsF() * 1e9 / (thread_count * kOperationsPerThread),
+        "ns/op", true);
+  }
+
+  std::vector<std::string> names_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HistogramPerfTest);
+};
+
+}  // namespace
+
+// Compares looking up histograms by name in the StatisticsRecorder with
+// looking them up in a map guarded by a lock.
+TEST_P(HistogramPerfTest, FindHistogram) {
+  LockedHistogramMap locked_map;
+  for (const std::string& name : names_) {
+    locked_map.Add(Histogram::FactoryGet(name, 1, 10000, 50,
+                                         HistogramBase::kNoFlags));
+  }
+
+  TimeOperation("find_histogram", "locked_map",
+                Bind(&FindInLockedMap, &locked_map, &names_));
+  TimeOperation("find_histogram", "statistics_recorder",
+                Bind(&FindInStatisticsRecorder, &names_));
+}
+
+// Compares adding samples to the same histogram from many threads with and
+// without kShardedSamplesFlag.
+TEST_P(HistogramPerfTest, AddSample) {
+  const std::string suffix = IntToString(GetParam());
+  HistogramBase* histogram =
+      Histogram::FactoryGet("HistogramPerfTest.Unsharded" + suffix, 1, 10000,
+                            50, HistogramBase::kNoFlags);
+  HistogramBase* sharded_histogram =
+      Histogram::FactoryGet("HistogramPerfTest.Sharded" + suffix, 1, 10000, 50,
+                            HistogramBase::kShardedSamplesFlag);
+
+  TimeOperation("histogram_add", "sample_vector", Bind(&AddSample, histogram));
+  TimeOperation("histogram_add", "sharded_sample_vector",
+                Bind(&AddSample, sharded_histogram));
+  EXPECT_EQ(GetParam() * kOperationsPerThread,
+            sharded_histogram->SnapshotSamples()->TotalCount());
+}
+
+INSTANTIATE_TEST_CASE_P(HistogramPerfTests,
+                        HistogramPerfTest,
+                        testing::Values(1, 2, 4, 8, 16));
+
+}  // namespace base
@@ -18,7 +18,17 @@ class SampleCountIterator;
 // HistogramSamples is a container storing all samples of a histogram.
 class BASE_EXPORT HistogramSamples {
  public:
+  // The totals of the samples, kept apart from the samples so that they can
+  // live in memory that is not owned by the HistogramSamples, such as the
+  // persistent memory of a PersistentHistogramAllocator.
+  struct Metadata {
+    int64 sum;
+    HistogramBase::AtomicCount redundant_count;
+  };
+
   HistogramSamples();
+  // Keeps the totals in |meta|, which must outlive this object.
+  explicit HistogramSamples(Metadata* meta);
   virtual ~HistogramSamples();
 
   virtual void Accumulate(HistogramBase::Sample value,
@@ -37,9 +47,9 @@ class BASE_EXPORT HistogramSamples {
   virtual bool Serialize(Pickle* pickle) const;
 
   // Accessor fuctions.
-  int64 sum() const { return sum_; }
+  int64 sum() const { return meta_->sum; }
   HistogramBase::Count redundant_count() const {
-    return subtle::NoBarrier_Load(&redundant_count_);
+    return subtle::NoBarrier_Load(&meta_->redundant_count);
   }
 
  protected:
@@ -51,16 +61,17 @@ class BASE_EXPORT HistogramSamples {
   void IncreaseRedundantCount(HistogramBase::Count diff);
 
  private:
-  int64 sum_;
-
-  // |redundant_count_| helps identify memory corruption. It redundantly stores
+  // |redundant_count| helps identify memory corruption. It redundantly stores
   // the total number of samples accumulated in the histogram. We can compare
   // this count to the sum of the counts (TotalCount() function), and detect
   // problems. Note, depending on the implementation of different histogram
   // types, there might be races during histogram accumulation and snapshotting
   // that we choose to accept. In this case, the tallies might mismatch even
   // when no memory corruption has happened.
-  HistogramBase::AtomicCount redundant_count_;
+  Metadata local_meta_;
+
+  // Points to |local_meta_|, unless the totals are kept elsewhere.
+  Metadata* meta_;
 };
 
 class BASE_EXPORT SampleCountIterator {
@@ -255,6 +255,34 @@ TEST_F(HistogramTest, AddCountTest) {
   EXPECT_EQ(38, samples2->GetCount(30));
 }
 
+// Samples of a histogram with kShardedSamplesFlag are counted in shards, and
+// snapshots include them along with the samples added from other snapshots.
+TEST_F(HistogramTest, ShardedSamplesTest) {
+  const size_t kBucketCount = 50;
+  Histogram* histogram = static_cast<Histogram*>(Histogram::FactoryGet(
+      "ShardedHistogram", 10, 100, kBucketCount,
+      HistogramBase::kShardedSamplesFlag));
+
+  histogram->AddCount(20, 15);
+  histogram->Add(30);
+  EXPECT_EQ(0, histogram->samples_->TotalCount());
+
+  scoped_ptr<SampleVector> samples = histogram->SnapshotSampleVector();
+  EXPECT_EQ(16, samples->TotalCount());
+  EXPECT_EQ(15, samples->GetCount(20));
+  EXPECT_EQ(1, samples->GetCount(30));
+  EXPECT_EQ(16, samples->redundant_count());
+  EXPECT_EQ(20 * 15 + 30, samples->sum());
+  EXPECT_EQ(HistogramBase::NO_INCONSISTENCIES,
+            histogram->FindCorruption(*samples));
+
+  histogram->AddSamples(*samples);
+  scoped_ptr<HistogramSamples> samples2 = histogram->SnapshotSamples();
+  EXPECT_EQ(32, samples2->TotalCount());
+  EXPECT_EQ(30, samples2->GetCount(20));
+  EXPECT_EQ(2 * (20 * 15 + 30), samples2->sum());
+}
+
 // Make sure histogram handles out-of-bounds data gracefully.
 TEST_F(HistogramTest, BoundsTest) {
   const size_t kBucketCount = 50;
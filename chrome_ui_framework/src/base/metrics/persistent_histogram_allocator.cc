@@ -0,0 +1,201 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_allocator.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/sample_vector.h"
+#include "base/pickle.h"
+#include "base/process/process_handle.h"
+
+namespace base {
+
+namespace {
+
+// The type of the blocks that hold histograms.
+const uint32 kTypeIdHistogram = 0xF1645910;
+
+// The block of a histogram: this header padded to kHeaderSize, then the
+// |info_size| bytes of the histogram's HistogramBase::SerializeInfo() pickle
+// padded to a multiple of 4 bytes, then the |bucket_count| counts of the
+// samples. The padding keeps the layout the same in 32 and 64-bit processes.
+struct PersistentHistogramData {
+  uint32 info_size;
+  uint32 bucket_count;
+  uint32 process_id;  // Of the process that records the samples.
+  uint32 padding;
+  HistogramSamples::Metadata samples_metadata;
+};
+
+const size_t kHeaderSize = (sizeof(PersistentHistogramData) + 7) & ~7;
+
+size_t PaddedInfoSize(size_t info_size) {
+  return (info_size + 3) & ~static_cast<size_t>(3);
+}
+
+char* GetInfo(PersistentHistogramData* data) {
+  return reinterpret_cast<char*>(data) + kHeaderSize;
+}
+
+PersistentHistogramAllocator* g_allocator = NULL;
+
+}  // namespace
+
+struct PersistentHistogramAllocator::MergedHistogram {
+  // The histogram of this process that the samples are merged into.
+  HistogramBase* histogram;
+  const BucketRanges* ranges;
+
+  // The samples in the segment.
+  scoped_ptr<SampleVector> samples;
+
+  // The samples merged so far.
+  scoped_ptr<SampleVector> merged_samples;
+};
+
+PersistentHistogramAllocator::PersistentHistogramAllocator(
+    scoped_ptr<PersistentMemoryAllocator> memory)
+    : memory_(memory.Pass()), iterator_(memory_.get()) {}
+
+PersistentHistogramAllocator::~PersistentHistogramAllocator() {}
+
+bool PersistentHistogramAllocator::AllocateSamples(Histogram* histogram) {
+  DCHECK_EQ(0, histogram->samples_->redundant_count());
+  if (histogram->flags() & HistogramBase::kShardedSamplesFlag)
+    return false;
+
+  // The reader finds or creates its own version of the histogram with
+  // DeserializeHistogramInfo(), as if the histogram had been sent over IPC.
+  Pickle pickle;
+  const bool is_from_ipc =
+      (histogram->flags() & HistogramBase::kIPCSerializationSourceFlag) != 0;
+  histogram->SetFlags(HistogramBase::kIPCSerializationSourceFlag);
+  const bool serialized = histogram->SerializeInfo(&pickle);
+  if (!is_from_ipc)
+    histogram->ClearFlags(HistogramBase::kIPCSerializationSourceFlag);
+  if (!serialized)
+    return false;
+
+  const BucketRanges* ranges = histogram->bucket_ranges();
+  const size_t bucket_count = ranges->bucket_count();
+  const size_t info_size = PaddedInfoSize(pickle.size());
+  PersistentMemoryAllocator::Reference ref = memory_->Allocate(
+      kHeaderSize + info_size +
+          bucket_count * sizeof(HistogramBase::AtomicCount),
+      kTypeIdHistogram);
+  PersistentHistogramData* data =
+      memory_->GetAsObject<PersistentHistogramData>(ref, kTypeIdHistogram);
+  if (!data)
+    return false;
+
+  data->info_size = static_cast<uint32>(pickle.size());
+  data->bucket_count = static_cast<uint32>(bucket_count);
+  data->process_id = static_cast<uint32>(GetCurrentProcId());
+  char* info = GetInfo(data);
+  memcpy(info, pickle.data(), pickle.size());
+  histogram->samples_.reset(new SampleVector(
+      reinterpret_cast<HistogramBase::AtomicCount*>(info + info_size),
+      bucket_count, &data->samples_metadata, ranges));
+  histogram->SetFlags(HistogramBase::kIsPersistent);
+
+  memory_->MakeIterable(ref);
+  return true;
+}
+
+void PersistentHistogramAllocator::MergeDeltasToStatisticsRecorder() {
+  uint32 type_id;
+  PersistentMemoryAllocator::Reference ref;
+  while ((ref = iterator_.GetNext(&type_id)) != 0) {
+    if (type_id != kTypeIdHistogram)
+      continue;
+    scoped_ptr<MergedHistogram> merged_histogram = ReadHistogram(ref);
+    if (merged_histogram)
+      merged_histograms_.push_back(merged_histogram.release());
+  }
+
+  for (MergedHistogram* merged_histogram : merged_histograms_) {
+    SampleVector delta(merged_histogram->ranges);
+    delta.Add(*merged_histogram->samples);
+    delta.Subtract(*merged_histogram->merged_samples);
+    if (delta.redundant_count() == 0 && delta.TotalCount() == 0)
+      continue;
+    merged_histogram->merged_samples->Add(delta);
+    merged_histogram->histogram->AddSamples(delta);
+  }
+}
+
+scoped_ptr<PersistentHistogramAllocator::MergedHistogram>
+PersistentHistogramAllocator::ReadHistogram(
+    PersistentMemoryAllocator::Reference ref) {
+  PersistentHistogramData* data =
+      memory_->GetAsObject<PersistentHistogramData>(ref, kTypeIdHistogram);
+  if (!data)
+    return scoped_ptr<MergedHistogram>();
+
+  // The samples of this process are already in its histograms.
+  if (data->process_id == static_cast<uint32>(GetCurrentProcId()))
+    return scoped_ptr<MergedHistogram>();
+
+  // The block may have been written by another process, so its sizes are
+  // read once and checked before they are used.
+  const size_t alloc_size = memory_->GetAllocSize(ref);
+  const size_t info_size = data->info_size;
+  const size_t bucket_count = data->bucket_count;
+  if (alloc_size < kHeaderSize || info_size > alloc_size - kHeaderSize ||
+      bucket_count > (alloc_size - kHeaderSize - PaddedInfoSize(info_size)) /
+                         sizeof(HistogramBase::AtomicCount)) {
+    return scoped_ptr<MergedHistogram>();
+  }
+
+  // The pickle is read in place. Its writer could still change it, but a
+  // PickleView keeps the reads within |info_size| bytes regardless.
+  char* info = GetInfo(data);
+  PickleView pickle(info, info_size);
+  PickleIterator iter(pickle);
+  HistogramBase* histogram = DeserializeHistogramInfo(&iter);
+  if (!histogram || histogram->GetHistogramType() == SPARSE_HISTOGRAM)
+    return scoped_ptr<MergedHistogram>();
+
+  const BucketRanges* ranges =
+      static_cast<Histogram*>(histogram)->bucket_ranges();
+  if (ranges->bucket_count() != bucket_count)
+    return scoped_ptr<MergedHistogram>();
+
+  scoped_ptr<MergedHistogram> merged_histogram(new MergedHistogram);
+  merged_histogram->histogram = histogram;
+  merged_histogram->ranges = ranges;
+  merged_histogram->samples.reset(new SampleVector(
+      reinterpret_cast<HistogramBase::AtomicCount*>(
+          info + PaddedInfoSize(info_size)),
+      bucket_count, &data->samples_metadata, ranges));
+  merged_histogram->merged_samples.reset(new SampleVector(ranges));
+  return merged_histogram.Pass();
+}
+
+// static
+void PersistentHistogramAllocator::SetGlobalAllocator(
+    scoped_ptr<PersistentHistogramAllocator> allocator) {
+  DCHECK(!g_allocator);
+  g_allocator = allocator.release();
+}
+
+// static
+PersistentHistogramAllocator*
+PersistentHistogramAllocator::GetGlobalAllocator() {
+  return g_allocator;
+}
+
+// static
+scoped_ptr<PersistentHistogramAllocator>
+PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting() {
+  PersistentHistogramAllocator* allocator = g_allocator;
+  g_allocator = NULL;
+  return make_scoped_ptr(allocator);
+}
+
+}  // namespace base
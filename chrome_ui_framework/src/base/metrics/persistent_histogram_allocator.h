@@ -0,0 +1,89 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
+#define BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/persistent_memory_allocator.h"
+
+namespace base {
+
+class Histogram;
+
+// PersistentHistogramAllocator keeps the samples of histograms in the segment
+// of a PersistentMemoryAllocator, usually shared memory, instead of the heap.
+//
+// A process that records histograms sets a global allocator at startup. From
+// then on, the samples of the histograms that it creates are counted in the
+// segment, along with the information needed to recreate the histograms. A
+// process that maps the same segment, such as the browser for the segment of
+// a renderer, then merges the samples into its own histograms directly from
+// the segment, without the samples being pickled and sent over IPC. The
+// samples stay readable after the process that recorded them has crashed.
+//
+// Sparse histograms, and histograms with kShardedSamplesFlag, keep their
+// samples on the heap.
+class BASE_EXPORT PersistentHistogramAllocator {
+ public:
+  explicit PersistentHistogramAllocator(
+      scoped_ptr<PersistentMemoryAllocator> memory);
+  ~PersistentHistogramAllocator();
+
+  PersistentMemoryAllocator* memory_allocator() { return memory_.get(); }
+
+  // Moves the samples of |histogram| to the segment, and sets its
+  // kIsPersistent flag. |histogram| must not have any samples yet, nor be
+  // visible to other threads. Returns false, leaving the samples on the heap,
+  // if the segment is full or |histogram| can't be kept in it. Called by the
+  // StatisticsRecorder for the global allocator when it registers a new
+  // histogram.
+  bool AllocateSamples(Histogram* histogram);
+
+  // Adds the samples that were added to the histograms in the segment since
+  // the last call, by any process, to the histograms of the same names in the
+  // StatisticsRecorder, which are created as needed. The histograms of the
+  // segment that this process records are left out.
+  void MergeDeltasToStatisticsRecorder();
+
+  // Makes |allocator| the allocator of the histograms created from then on.
+  // Must be called before other threads create histograms, as is the case for
+  // StatisticsRecorder::Initialize(). The allocator is leaked, like the
+  // histograms whose samples it holds.
+  static void SetGlobalAllocator(
+      scoped_ptr<PersistentHistogramAllocator> allocator);
+
+  // Returns the global allocator, or NULL.
+  static PersistentHistogramAllocator* GetGlobalAllocator();
+
+  // Clears the global allocator, and returns it. The histograms created with
+  // it must not be used once it is deleted.
+  static scoped_ptr<PersistentHistogramAllocator>
+  ReleaseGlobalAllocatorForTesting();
+
+ private:
+  // A histogram of the segment, as seen by the reader.
+  struct MergedHistogram;
+
+  // Returns the histogram of the block |ref|, or NULL if it is invalid or
+  // recorded by this process.
+  scoped_ptr<MergedHistogram> ReadHistogram(
+      PersistentMemoryAllocator::Reference ref);
+
+  scoped_ptr<PersistentMemoryAllocator> memory_;
+
+  // Finds the histograms that were added to the segment since the last merge.
+  PersistentMemoryAllocator::Iterator iterator_;
+
+  ScopedVector<MergedHistogram> merged_histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(PersistentHistogramAllocator);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
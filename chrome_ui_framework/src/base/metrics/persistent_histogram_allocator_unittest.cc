@@ -0,0 +1,265 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_allocator.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_delta_serialization.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/sparse_histogram.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/process/process.h"
+#include "base/test/multiprocess_test.h"
+#include "base/test/test_timeouts.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/multiprocess_func_list.h"
+
+namespace base {
+
+namespace {
+
+const size_t kSegmentSize = 64 << 10;
+
+// Returns the number of iterable blocks of |allocator|.
+size_t CountIterableBlocks(PersistentMemoryAllocator* allocator) {
+  PersistentMemoryAllocator::Iterator iter(allocator);
+  uint32 type_id;
+  size_t count = 0;
+  while (iter.GetNext(&type_id) != 0)
+    ++count;
+  return count;
+}
+
+}  // namespace
+
+class PersistentHistogramAllocatorTest : public MultiProcessTest {
+ protected:
+  void SetUp() override {
+    // Each test will have a clean state (no Histogram / BucketRanges
+    // registered).
+    statistics_recorder_ = new StatisticsRecorder();
+  }
+
+  void TearDown() override {
+    // The histograms whose samples are in the segment of the global allocator
+    // are leaked by the StatisticsRecorder, and must not be used after this.
+    PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting();
+    delete statistics_recorder_;
+    statistics_recorder_ = NULL;
+  }
+
+  // Sets a global allocator on a segment of |size| bytes of heap memory, and
+  // returns its memory allocator.
+  PersistentMemoryAllocator* SetLocalGlobalAllocator(size_t size) {
+    scoped_ptr<PersistentMemoryAllocator> memory(
+        new LocalPersistentMemoryAllocator(size));
+    PersistentMemoryAllocator* memory_allocator = memory.get();
+    PersistentHistogramAllocator::SetGlobalAllocator(make_scoped_ptr(
+        new PersistentHistogramAllocator(memory.Pass())));
+    return memory_allocator;
+  }
+
+  StatisticsRecorder* statistics_recorder_;
+};
+
+TEST_F(PersistentHistogramAllocatorTest, AllocatesSamplesInSegment) {
+  PersistentMemoryAllocator* memory_allocator =
+      SetLocalGlobalAllocator(kSegmentSize);
+  const size_t used = memory_allocator->used();
+
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 10, HistogramBase::kNoFlags);
+  HistogramBase* linear_histogram = LinearHistogram::FactoryGet(
+      "TestLinearHistogram", 1, 1000, 10, HistogramBase::kNoFlags);
+  HistogramBase* boolean_histogram = BooleanHistogram::FactoryGet(
+      "TestBooleanHistogram", HistogramBase::kNoFlags);
+  std::vector<HistogramBase::Sample> custom_ranges;
+  custom_ranges.push_back(1);
+  custom_ranges.push_back(5);
+  HistogramBase* custom_histogram = CustomHistogram::FactoryGet(
+      "TestCustomHistogram", custom_ranges, HistogramBase::kNoFlags);
+  EXPECT_TRUE(histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(linear_histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(boolean_histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(custom_histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_GT(memory_allocator->used(), used);
+  EXPECT_EQ(4u, CountIterableBlocks(memory_allocator));
+
+  // Getting a histogram again doesn't allocate.
+  const size_t used_by_histograms = memory_allocator->used();
+  EXPECT_EQ(histogram, Histogram::FactoryGet("TestHistogram", 1, 1000, 10,
+                                             HistogramBase::kNoFlags));
+  EXPECT_EQ(used_by_histograms, memory_allocator->used());
+
+  histogram->Add(1);
+  histogram->Add(1);
+  histogram->Add(500);
+  scoped_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(3, samples->TotalCount());
+  EXPECT_EQ(2, samples->GetCount(1));
+  EXPECT_EQ(502, samples->sum());
+  EXPECT_EQ(3, samples->redundant_count());
+  EXPECT_FALSE(memory_allocator->IsCorrupt());
+}
+
+TEST_F(PersistentHistogramAllocatorTest, DuplicateNotAllocated) {
+  PersistentMemoryAllocator* memory_allocator =
+      SetLocalGlobalAllocator(kSegmentSize);
+  Histogram* histogram = static_cast<Histogram*>(Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 10, HistogramBase::kNoFlags));
+  const size_t used = memory_allocator->used();
+
+  // A histogram that loses the race to register, as when two threads create
+  // the same histogram at once, is deleted without taking space in the
+  // segment.
+  Histogram* duplicate =
+      new Histogram("TestHistogram", 1, 1000, histogram->bucket_ranges());
+  EXPECT_EQ(histogram,
+            StatisticsRecorder::RegisterOrDeleteDuplicate(duplicate));
+  EXPECT_EQ(used, memory_allocator->used());
+  EXPECT_EQ(1u, CountIterableBlocks(memory_allocator));
+  EXPECT_FALSE(memory_allocator->IsCorrupt());
+}
+
+TEST_F(PersistentHistogramAllocatorTest, SamplesOnHeap) {
+  PersistentMemoryAllocator* memory_allocator =
+      SetLocalGlobalAllocator(kSegmentSize);
+
+  // Sparse and sharded histograms keep their samples on the heap.
+  HistogramBase* sparse_histogram =
+      SparseHistogram::FactoryGet("TestSparseHistogram",
+                                  HistogramBase::kNoFlags);
+  HistogramBase* sharded_histogram = Histogram::FactoryGet(
+      "TestShardedHistogram", 1, 1000, 10, HistogramBase::kShardedSamplesFlag);
+  EXPECT_FALSE(sparse_histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_FALSE(sharded_histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_EQ(0u, CountIterableBlocks(memory_allocator));
+}
+
+TEST_F(PersistentHistogramAllocatorTest, FullSegment) {
+  PersistentMemoryAllocator* memory_allocator = SetLocalGlobalAllocator(512);
+
+  // A histogram that doesn't fit in the segment keeps its samples on the heap.
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 100, HistogramBase::kNoFlags);
+  EXPECT_FALSE(histogram->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(memory_allocator->IsFull());
+
+  histogram->Add(10);
+  EXPECT_EQ(1, histogram->SnapshotSamples()->TotalCount());
+}
+
+TEST_F(PersistentHistogramAllocatorTest, NotMergedInRecordingProcess) {
+  SetLocalGlobalAllocator(kSegmentSize);
+  PersistentHistogramAllocator* allocator =
+      PersistentHistogramAllocator::GetGlobalAllocator();
+
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 10, HistogramBase::kNoFlags);
+  histogram->Add(5);
+  allocator->MergeDeltasToStatisticsRecorder();
+  allocator->MergeDeltasToStatisticsRecorder();
+  EXPECT_EQ(1, histogram->SnapshotSamples()->TotalCount());
+}
+
+TEST_F(PersistentHistogramAllocatorTest, NotSerializedAsDeltas) {
+  SetLocalGlobalAllocator(kSegmentSize);
+
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 10, HistogramBase::kNoFlags);
+  histogram->Add(5);
+
+  // The reader of the segment merges the samples instead.
+  HistogramDeltaSerialization serializer("PersistentHistogramAllocatorTest");
+  std::vector<std::string> deltas;
+  serializer.PrepareAndSerializeDeltas(&deltas);
+  EXPECT_TRUE(deltas.empty());
+}
+
+// iOS does not allow multiple processes.
+// Android ashmem does not support named shared memory.
+// Mac SharedMemory does not support named shared memory. crbug.com/345734
+#if !defined(OS_IOS) && !defined(OS_ANDROID) && !defined(OS_MACOSX)
+
+namespace {
+
+const char kSegmentName[] = "PersistentHistogramAllocatorTest";
+const char kChildHistogramName[] = "TestChildHistogram";
+const int kChildSampleCount = 100;
+
+}  // namespace
+
+// The child records samples in a histogram whose samples are in the segment,
+// then waits to be killed before it can report them.
+TEST_F(PersistentHistogramAllocatorTest, MergesSamplesOfCrashedProcess) {
+  SharedMemory cleanup;
+  cleanup.Delete(kSegmentName);
+
+  scoped_ptr<SharedMemory> memory(new SharedMemory);
+  ASSERT_TRUE(memory->CreateNamedDeprecated(kSegmentName, false,
+                                            kSegmentSize));
+  ASSERT_TRUE(memory->Map(kSegmentSize));
+  PersistentHistogramAllocator allocator(make_scoped_ptr(
+      new SharedPersistentMemoryAllocator(memory.Pass(), false)));
+
+  Process child = SpawnChild("PersistentHistogramChildMain");
+  ASSERT_TRUE(child.IsValid());
+
+  // Merge the deltas until all of the samples of the child are seen.
+  HistogramBase* histogram = NULL;
+  int count = 0;
+  const TimeTicks deadline = TimeTicks::Now() + TestTimeouts::action_timeout();
+  while (count < kChildSampleCount && TimeTicks::Now() < deadline) {
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(10));
+    allocator.MergeDeltasToStatisticsRecorder();
+    histogram = StatisticsRecorder::FindHistogram(kChildHistogramName);
+    if (histogram)
+      count = histogram->SnapshotSamples()->TotalCount();
+  }
+
+  EXPECT_TRUE(child.Terminate(1, true));
+  allocator.MergeDeltasToStatisticsRecorder();
+
+  // The samples outlive the child, and are only merged once.
+  ASSERT_TRUE(histogram);
+  EXPECT_FALSE(histogram->flags() & HistogramBase::kIsPersistent);
+  scoped_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(kChildSampleCount, samples->TotalCount());
+  EXPECT_EQ(kChildSampleCount / 2, samples->GetCount(1));
+  EXPECT_EQ(kChildSampleCount / 2, samples->GetCount(2));
+  EXPECT_FALSE(allocator.memory_allocator()->IsCorrupt());
+
+  cleanup.Delete(kSegmentName);
+}
+
+MULTIPROCESS_TEST_MAIN(PersistentHistogramChildMain) {
+  scoped_ptr<SharedMemory> memory(new SharedMemory);
+  if (!memory->Open(kSegmentName, false) || !memory->Map(kSegmentSize))
+    return 1;
+  PersistentHistogramAllocator::SetGlobalAllocator(make_scoped_ptr(
+      new PersistentHistogramAllocator(make_scoped_ptr(
+          new SharedPersistentMemoryAllocator(memory.Pass(), false)))));
+  StatisticsRecorder::Initialize();
+
+  HistogramBase* histogram = LinearHistogram::FactoryGet(
+      kChildHistogramName, 1, 10, 11, HistogramBase::kNoFlags);
+  if (!(histogram->flags() & HistogramBase::kIsPersistent))
+    return 2;
+  for (int i = 0; i < kChildSampleCount; ++i)
+    histogram->Add(i % 2 + 1);
+
+  PlatformThread::Sleep(TestTimeouts::action_max_timeout());
+  return 0;
+}
+
+#endif  // !defined(OS_IOS) && !defined(OS_ANDROID) && !defined(OS_MACOSX)
+
+}  // namespace base
@@ -0,0 +1,350 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_memory_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+#include "base/memory/shared_memory.h"
+
+namespace base {
+
+namespace {
+
+// Marks a segment that an allocator has set up, with the version of the
+// segment layout.
+const uint32 kGlobalCookie = 0x408305DC;
+const uint32 kGlobalVersion = 1;
+
+// Marks the header of an allocated block, and of the head of the queue of
+// iterable blocks.
+const uint32 kBlockCookieAllocated = 0xC8799269;
+const uint32 kBlockCookieQueue = 0x1A6B2E37;
+
+// Values of SharedMetadata::flags.
+const uint32 kFlagCorrupt = 1 << 0;
+const uint32 kFlagFull = 1 << 1;
+
+}  // namespace
+
+// The header of every block. |next| is 0 until the block is made iterable,
+// then the Reference of the next iterable block, or kReferenceQueue for the
+// last one.
+struct PersistentMemoryAllocator::BlockHeader {
+  uint32 size;  // Including this header.
+  uint32 type_id;
+  subtle::Atomic32 cookie;
+  subtle::Atomic32 next;
+};
+
+// The header of the segment.
+struct PersistentMemoryAllocator::SharedMetadata {
+  subtle::Atomic32 cookie;  // Set last, once the rest is initialized.
+  uint32 size;
+  uint32 version;
+  subtle::Atomic32 flags;
+  subtle::Atomic32 freeptr;  // The offset of the next block.
+  subtle::Atomic32 tailptr;  // The last iterable block, or the queue head.
+
+  // The head of the list of iterable blocks.
+  BlockHeader queue;
+};
+
+// static
+const PersistentMemoryAllocator::Reference
+    PersistentMemoryAllocator::kReferenceQueue =
+        offsetof(SharedMetadata, queue);
+
+PersistentMemoryAllocator::Iterator::Iterator(
+    const PersistentMemoryAllocator* allocator)
+    : allocator_(allocator), last_(kReferenceQueue), count_(0) {}
+
+PersistentMemoryAllocator::Reference
+PersistentMemoryAllocator::Iterator::GetNext(uint32* type_id) {
+  const BlockHeader* block = allocator_->GetBlock(last_, 0, 0, true);
+  if (!block)
+    return 0;
+  const Reference next = subtle::Acquire_Load(&block->next);
+  if (next == kReferenceQueue || next == 0)
+    return 0;
+
+  block = allocator_->GetBlock(next, 0, 0, false);
+  // A list that is longer than the number of blocks that fit in the segment
+  // has a loop.
+  if (!block || ++count_ > allocator_->mem_size_ / sizeof(BlockHeader)) {
+    allocator_->SetCorrupt();
+    return 0;
+  }
+  last_ = next;
+  *type_id = block->type_id;
+  return next;
+}
+
+PersistentMemoryAllocator::PersistentMemoryAllocator(void* base,
+                                                     size_t size,
+                                                     bool read_only)
+    : mem_base_(static_cast<char*>(base)),
+      mem_size_(size),
+      read_only_(read_only),
+      corrupt_(false) {
+  CHECK(IsMemoryAcceptable(base, size));
+
+  SharedMetadata* meta = shared_meta();
+  if (subtle::Acquire_Load(&meta->cookie) !=
+      static_cast<int32>(kGlobalCookie)) {
+    if (read_only_ || meta->size || meta->freeptr || meta->queue.cookie) {
+      // Not zeroed memory, nor a segment.
+      SetCorrupt();
+      return;
+    }
+    meta->size = static_cast<uint32>(mem_size_);
+    meta->version = kGlobalVersion;
+    meta->freeptr = sizeof(SharedMetadata);
+    meta->tailptr = kReferenceQueue;
+    meta->queue.size = sizeof(BlockHeader);
+    meta->queue.cookie = kBlockCookieQueue;
+    meta->queue.next = kReferenceQueue;
+    subtle::Release_Store(&meta->cookie, kGlobalCookie);
+    return;
+  }
+
+  if (meta->version != kGlobalVersion || meta->size != mem_size_ ||
+      static_cast<uint32>(subtle::NoBarrier_Load(&meta->freeptr)) >
+          mem_size_ ||
+      meta->queue.cookie != static_cast<int32>(kBlockCookieQueue)) {
+    SetCorrupt();
+  }
+}
+
+PersistentMemoryAllocator::~PersistentMemoryAllocator() {}
+
+// static
+bool PersistentMemoryAllocator::IsMemoryAcceptable(const void* base,
+                                                   size_t size) {
+  return (reinterpret_cast<uintptr_t>(base) % kAllocAlignment) == 0 &&
+         size >= sizeof(SharedMetadata) && size <= kSegmentMaxSize &&
+         size % kAllocAlignment == 0;
+}
+
+PersistentMemoryAllocator::Reference PersistentMemoryAllocator::Allocate(
+    size_t size,
+    uint32 type_id) {
+  DCHECK_NE(0u, type_id);
+  if (read_only_ || IsCorrupt() || size > mem_size_)
+    return 0;
+
+  const uint32 block_size = static_cast<uint32>(
+      (size + sizeof(BlockHeader) + kAllocAlignment - 1) &
+      ~(kAllocAlignment - 1));
+  SharedMetadata* meta = shared_meta();
+  for (;;) {
+    const uint32 freeptr =
+        static_cast<uint32>(subtle::Acquire_Load(&meta->freeptr));
+    if (freeptr > mem_size_) {
+      SetCorrupt();
+      return 0;
+    }
+    if (block_size > mem_size_ - freeptr) {
+      SetFlag(kFlagFull);
+      return 0;
+    }
+    if (subtle::NoBarrier_CompareAndSwap(&meta->freeptr, freeptr,
+                                         freeptr + block_size) != freeptr) {
+      continue;
+    }
+
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(mem_base_ + freeptr);
+    block->size = block_size;
+    block->type_id = type_id;
+    subtle::Release_Store(&block->cookie, kBlockCookieAllocated);
+    return freeptr;
+  }
+}
+
+void PersistentMemoryAllocator::MakeIterable(Reference ref) {
+  if (read_only_)
+    return;
+  BlockHeader* block = GetBlock(ref, 0, 0, false);
+  if (!block)
+    return;
+  // Mark the block as the last one before it is linked, and make sure it
+  // is only linked once.
+  if (subtle::NoBarrier_CompareAndSwap(&block->next, 0, kReferenceQueue) != 0)
+    return;
+
+  SharedMetadata* meta = shared_meta();
+  for (;;) {
+    const Reference tail = subtle::Acquire_Load(&meta->tailptr);
+    BlockHeader* tail_block = GetBlock(tail, 0, 0, true);
+    if (!tail_block) {
+      SetCorrupt();
+      return;
+    }
+    const Reference next =
+        subtle::Release_CompareAndSwap(&tail_block->next, kReferenceQueue, ref);
+    if (next == kReferenceQueue) {
+      // Linked. Move the tail to the block, unless another thread has.
+      subtle::Release_CompareAndSwap(&meta->tailptr, tail, ref);
+      return;
+    }
+    if (next == 0) {
+      SetCorrupt();
+      return;
+    }
+    // Another block was linked after the tail, which is being moved to it.
+    // Help move it, then try again.
+    subtle::Release_CompareAndSwap(&meta->tailptr, tail, next);
+  }
+}
+
+size_t PersistentMemoryAllocator::GetAllocSize(Reference ref) const {
+  const BlockHeader* block = GetBlock(ref, 0, 0, false);
+  if (!block)
+    return 0;
+  return block->size - sizeof(BlockHeader);
+}
+
+uint32 PersistentMemoryAllocator::GetType(Reference ref) const {
+  const BlockHeader* block = GetBlock(ref, 0, 0, false);
+  if (!block)
+    return 0;
+  return block->type_id;
+}
+
+bool PersistentMemoryAllocator::IsFull() const {
+  return CheckFlag(kFlagFull);
+}
+
+bool PersistentMemoryAllocator::IsCorrupt() const {
+  return corrupt_ || CheckFlag(kFlagCorrupt);
+}
+
+size_t PersistentMemoryAllocator::used() const {
+  return std::min(
+      static_cast<size_t>(static_cast<uint32>(
+          subtle::NoBarrier_Load(&shared_meta()->freeptr))),
+      mem_size_);
+}
+
+PersistentMemoryAllocator::SharedMetadata*
+PersistentMemoryAllocator::shared_meta() const {
+  return reinterpret_cast<SharedMetadata*>(mem_base_);
+}
+
+const PersistentMemoryAllocator::BlockHeader*
+PersistentMemoryAllocator::GetBlock(Reference ref,
+                                    uint32 type_id,
+                                    size_t size,
+                                    bool queue_ok) const {
+  if (ref == kReferenceQueue) {
+    return queue_ok ? &shared_meta()->queue : NULL;
+  }
+  // The block must be aligned, after the segment header and before the free
+  // offset, and every field of its header is checked since another process
+  // may have written it.
+  if (ref % kAllocAlignment != 0 || ref < sizeof(SharedMetadata))
+    return NULL;
+  const uint32 freeptr =
+      static_cast<uint32>(subtle::Acquire_Load(&shared_meta()->freeptr));
+  if (ref > mem_size_ || ref + sizeof(BlockHeader) > mem_size_ ||
+      ref + sizeof(BlockHeader) > freeptr) {
+    return NULL;
+  }
+  const BlockHeader* block =
+      reinterpret_cast<const BlockHeader*>(mem_base_ + ref);
+  if (subtle::Acquire_Load(&block->cookie) !=
+      static_cast<int32>(kBlockCookieAllocated)) {
+    return NULL;
+  }
+  const uint32 block_size = block->size;
+  if (block_size < sizeof(BlockHeader) + size ||
+      block_size > mem_size_ - ref) {
+    return NULL;
+  }
+  if (type_id && block->type_id != type_id)
+    return NULL;
+  return block;
+}
+
+PersistentMemoryAllocator::BlockHeader* PersistentMemoryAllocator::GetBlock(
+    Reference ref,
+    uint32 type_id,
+    size_t size,
+    bool queue_ok) {
+  return const_cast<BlockHeader*>(
+      static_cast<const PersistentMemoryAllocator*>(this)->GetBlock(
+          ref, type_id, size, queue_ok));
+}
+
+void* PersistentMemoryAllocator::GetBlockData(Reference ref,
+                                              uint32 type_id,
+                                              size_t size) const {
+  DCHECK_NE(0u, type_id);
+  const BlockHeader* block = GetBlock(ref, type_id, size, false);
+  if (!block)
+    return NULL;
+  return const_cast<char*>(reinterpret_cast<const char*>(block + 1));
+}
+
+void PersistentMemoryAllocator::SetFlag(uint32 flag) const {
+  if (read_only_)
+    return;
+  subtle::Atomic32* flags = &shared_meta()->flags;
+  for (;;) {
+    const subtle::Atomic32 old_flags = subtle::NoBarrier_Load(flags);
+    if (subtle::NoBarrier_CompareAndSwap(flags, old_flags, old_flags | flag) ==
+        old_flags) {
+      return;
+    }
+  }
+}
+
+bool PersistentMemoryAllocator::CheckFlag(uint32 flag) const {
+  return (subtle::NoBarrier_Load(&shared_meta()->flags) & flag) != 0;
+}
+
+void PersistentMemoryAllocator::SetCorrupt() const {
+  DLOG(ERROR) << "Corrupt persistent memory segment";
+  corrupt_ = true;
+  SetFlag(kFlagCorrupt);
+}
+
+//------------------------------------------------------------------------------
+// LocalPersistentMemoryAllocator:
+
+LocalPersistentMemoryAllocator::LocalPersistentMemoryAllocator(size_t size)
+    : PersistentMemoryAllocator(
+          memset(AlignedAlloc(size, kAllocAlignment), 0, size),
+          size,
+          false) {}
+
+LocalPersistentMemoryAllocator::~LocalPersistentMemoryAllocator() {
+  AlignedFree(mem_base());
+}
+
+//------------------------------------------------------------------------------
+// SharedPersistentMemoryAllocator:
+
+SharedPersistentMemoryAllocator::SharedPersistentMemoryAllocator(
+    scoped_ptr<SharedMemory> memory,
+    bool read_only)
+    : PersistentMemoryAllocator(memory->memory(),
+                                memory->mapped_size(),
+                                read_only),
+      shared_memory_(memory.Pass()) {}
+
+SharedPersistentMemoryAllocator::~SharedPersistentMemoryAllocator() {}
+
+// static
+bool SharedPersistentMemoryAllocator::IsSharedMemoryAcceptable(
+    const SharedMemory& memory) {
+  return IsMemoryAcceptable(memory.memory(), memory.mapped_size());
+}
+
+}  // namespace base
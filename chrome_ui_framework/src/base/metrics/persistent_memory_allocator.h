@@ -0,0 +1,177 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_METRICS_PERSISTENT_MEMORY_ALLOCATOR_H_
+#define BASE_METRICS_PERSISTENT_MEMORY_ALLOCATOR_H_
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+
+namespace base {
+
+class SharedMemory;
+
+// PersistentMemoryAllocator allocates blocks out of a segment of memory, such
+// as shared memory, so that the blocks can be found again by anyone who maps
+// the segment: other processes, or this one after a restart if the segment is
+// backed by a file. All its state lives in the segment itself.
+//
+// Blocks are never freed. An allocation is an atomic bump of the free offset
+// at the start of the segment, so any number of threads and processes can
+// allocate from a segment at once without a lock. Blocks are referred to by
+// their offset in the segment, a Reference, since the segment is mapped at
+// different addresses in different processes. A block can be made iterable,
+// which adds it to a list that readers walk with an Iterator.
+//
+// The contents of a segment written by another process can't be trusted, so
+// every Reference is checked before it is used, and a segment that is found
+// to be inconsistent is marked as corrupt.
+class BASE_EXPORT PersistentMemoryAllocator {
+ public:
+  typedef uint32 Reference;
+
+  // The alignment of the segment and of every block.
+  static const size_t kAllocAlignment = 8;
+
+  // The largest segment that an allocator accepts.
+  static const size_t kSegmentMaxSize = 1 << 30;
+
+  // Walks the blocks made iterable, in the order in which they were. Blocks
+  // made iterable after the end of the list was reached are returned by later
+  // calls to GetNext().
+  class BASE_EXPORT Iterator {
+   public:
+    explicit Iterator(const PersistentMemoryAllocator* allocator);
+
+    // Returns the next iterable block and sets |type_id| to its type, or
+    // returns 0 if there is none for now.
+    Reference GetNext(uint32* type_id);
+
+   private:
+    const PersistentMemoryAllocator* allocator_;
+    Reference last_;
+    size_t count_;
+  };
+
+  // Allocates from the |size| bytes at |base|, which must be aligned to
+  // kAllocAlignment and must stay mapped for the lifetime of the allocator.
+  // The memory must be zeroed, unless it holds a segment that another
+  // allocator has set up already. A |read_only| allocator can't allocate or
+  // change the segment.
+  PersistentMemoryAllocator(void* base, size_t size, bool read_only);
+  virtual ~PersistentMemoryAllocator();
+
+  // Returns whether |size| bytes at |base| can hold a segment.
+  static bool IsMemoryAcceptable(const void* base, size_t size);
+
+  // Allocates a block of at least |size| zeroed bytes, of type |type_id|,
+  // which must not be 0. Returns 0 when the segment is full.
+  Reference Allocate(size_t size, uint32 type_id);
+
+  // Adds the block |ref| to the list of iterable blocks. The contents of the
+  // block must be written before, so that iterators see them.
+  void MakeIterable(Reference ref);
+
+  // Returns the contents of the block |ref| as a T, or NULL if |ref| is not a
+  // block of type |type_id| that is large enough for a T.
+  template <typename T>
+  T* GetAsObject(Reference ref, uint32 type_id) const {
+    return static_cast<T*>(GetBlockData(ref, type_id, sizeof(T)));
+  }
+
+  // Returns the number of usable bytes in the block |ref|, or 0 if it is not
+  // a valid block.
+  size_t GetAllocSize(Reference ref) const;
+
+  // Returns the type of the block |ref|, or 0 if it is not a valid block.
+  uint32 GetType(Reference ref) const;
+
+  // Whether an allocation failed for lack of space.
+  bool IsFull() const;
+
+  // Whether the segment was found to be inconsistent, in which case its
+  // blocks should not be trusted.
+  bool IsCorrupt() const;
+
+  size_t size() const { return mem_size_; }
+
+  // The number of bytes allocated so far, including the segment header.
+  size_t used() const;
+
+ protected:
+  char* mem_base() const { return mem_base_; }
+
+ private:
+  struct BlockHeader;
+  struct SharedMetadata;
+
+  // The Reference of the head of the list of iterable blocks, which marks
+  // the end of the list.
+  static const Reference kReferenceQueue;
+
+  SharedMetadata* shared_meta() const;
+  const BlockHeader* GetBlock(Reference ref,
+                              uint32 type_id,
+                              size_t size,
+                              bool queue_ok) const;
+  BlockHeader* GetBlock(Reference ref,
+                        uint32 type_id,
+                        size_t size,
+                        bool queue_ok);
+  void* GetBlockData(Reference ref, uint32 type_id, size_t size) const;
+
+  void SetFlag(uint32 flag) const;
+  bool CheckFlag(uint32 flag) const;
+  void SetCorrupt() const;
+
+  char* const mem_base_;
+  const size_t mem_size_;
+  const bool read_only_;
+
+  // Set when this process finds the segment corrupt, in case the segment is
+  // read-only.
+  mutable bool corrupt_;
+
+  DISALLOW_COPY_AND_ASSIGN(PersistentMemoryAllocator);
+};
+
+// A PersistentMemoryAllocator on zeroed heap memory, for segments that are
+// only used within the process.
+class BASE_EXPORT LocalPersistentMemoryAllocator
+    : public PersistentMemoryAllocator {
+ public:
+  explicit LocalPersistentMemoryAllocator(size_t size);
+  ~LocalPersistentMemoryAllocator() override;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LocalPersistentMemoryAllocator);
+};
+
+// A PersistentMemoryAllocator on the mapped memory of a SharedMemory, which
+// other processes can map as well.
+class BASE_EXPORT SharedPersistentMemoryAllocator
+    : public PersistentMemoryAllocator {
+ public:
+  // |memory| must be mapped. A new shared memory segment is zeroed, so the
+  // first allocator on it sets it up.
+  SharedPersistentMemoryAllocator(scoped_ptr<SharedMemory> memory,
+                                  bool read_only);
+  ~SharedPersistentMemoryAllocator() override;
+
+  SharedMemory* shared_memory() { return shared_memory_.get(); }
+
+  // Returns whether the mapped memory of |memory| can hold a segment.
+  static bool IsSharedMemoryAcceptable(const SharedMemory& memory);
+
+ private:
+  scoped_ptr<SharedMemory> shared_memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedPersistentMemoryAllocator);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_PERSISTENT_MEMORY_ALLOCATOR_H_
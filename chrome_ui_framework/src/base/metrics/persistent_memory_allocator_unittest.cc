@@ -0,0 +1,258 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_memory_allocator.h"
+
+#include <string.h>
+
+#include <set>
+
+#include "base/memory/aligned_memory.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/memory/shared_memory.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const size_t kSegmentSize = 8 << 10;
+const uint32 kTypeIdOne = 1;
+const uint32 kTypeIdTwo = 2;
+
+struct TestObject {
+  int32 values[4];
+};
+
+// Allocates |count| blocks and makes each of them iterable.
+class AllocateThread : public SimpleThread {
+ public:
+  AllocateThread(PersistentMemoryAllocator* allocator, int count)
+      : SimpleThread("AllocateThread"), allocator_(allocator), count_(count) {}
+
+  void Run() override {
+    for (int i = 0; i < count_; ++i) {
+      PersistentMemoryAllocator::Reference ref =
+          allocator_->Allocate(sizeof(TestObject), kTypeIdOne);
+      ASSERT_NE(0u, ref);
+      allocator_->MakeIterable(ref);
+    }
+  }
+
+ private:
+  PersistentMemoryAllocator* allocator_;
+  const int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocateThread);
+};
+
+}  // namespace
+
+TEST(PersistentMemoryAllocatorTest, AllocateAndIterate) {
+  LocalPersistentMemoryAllocator allocator(kSegmentSize);
+  EXPECT_EQ(kSegmentSize, allocator.size());
+  EXPECT_FALSE(allocator.IsCorrupt());
+  EXPECT_FALSE(allocator.IsFull());
+  const size_t used = allocator.used();
+  EXPECT_GT(used, 0u);
+
+  PersistentMemoryAllocator::Reference ref1 =
+      allocator.Allocate(sizeof(TestObject), kTypeIdOne);
+  ASSERT_NE(0u, ref1);
+  EXPECT_EQ(0u, ref1 % PersistentMemoryAllocator::kAllocAlignment);
+  EXPECT_GT(allocator.used(), used + sizeof(TestObject));
+  EXPECT_GE(allocator.GetAllocSize(ref1), sizeof(TestObject));
+  EXPECT_EQ(kTypeIdOne, allocator.GetType(ref1));
+
+  TestObject* object = allocator.GetAsObject<TestObject>(ref1, kTypeIdOne);
+  ASSERT_TRUE(object);
+  for (size_t i = 0; i < arraysize(object->values); ++i)
+    EXPECT_EQ(0, object->values[i]);
+  object->values[0] = 42;
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(ref1, kTypeIdTwo));
+
+  // Blocks are only found by iterators once they are made iterable.
+  PersistentMemoryAllocator::Iterator iter(&allocator);
+  uint32 type_id = 0;
+  EXPECT_EQ(0u, iter.GetNext(&type_id));
+  allocator.MakeIterable(ref1);
+  allocator.MakeIterable(ref1);
+  EXPECT_EQ(ref1, iter.GetNext(&type_id));
+  EXPECT_EQ(kTypeIdOne, type_id);
+  EXPECT_EQ(0u, iter.GetNext(&type_id));
+
+  // An iterator that reached the end finds the blocks added after.
+  PersistentMemoryAllocator::Reference ref2 =
+      allocator.Allocate(sizeof(TestObject), kTypeIdTwo);
+  ASSERT_NE(0u, ref2);
+  EXPECT_NE(ref1, ref2);
+  allocator.MakeIterable(ref2);
+  EXPECT_EQ(ref2, iter.GetNext(&type_id));
+  EXPECT_EQ(kTypeIdTwo, type_id);
+  EXPECT_EQ(0u, iter.GetNext(&type_id));
+
+  PersistentMemoryAllocator::Iterator iter2(&allocator);
+  EXPECT_EQ(ref1, iter2.GetNext(&type_id));
+  EXPECT_EQ(ref2, iter2.GetNext(&type_id));
+  EXPECT_EQ(0u, iter2.GetNext(&type_id));
+
+  EXPECT_EQ(42, allocator.GetAsObject<TestObject>(ref1, kTypeIdOne)->values[0]);
+  EXPECT_FALSE(allocator.IsCorrupt());
+}
+
+TEST(PersistentMemoryAllocatorTest, Full) {
+  LocalPersistentMemoryAllocator allocator(kSegmentSize);
+  EXPECT_EQ(0u, allocator.Allocate(kSegmentSize, kTypeIdOne));
+  EXPECT_TRUE(allocator.IsFull());
+
+  size_t count = 0;
+  while (allocator.Allocate(sizeof(TestObject), kTypeIdOne) != 0)
+    ++count;
+  EXPECT_GT(count, kSegmentSize / (4 * sizeof(TestObject)));
+  EXPECT_LE(allocator.used(), kSegmentSize);
+  EXPECT_FALSE(allocator.IsCorrupt());
+}
+
+TEST(PersistentMemoryAllocatorTest, InvalidReferences) {
+  LocalPersistentMemoryAllocator allocator(kSegmentSize);
+  PersistentMemoryAllocator::Reference ref =
+      allocator.Allocate(sizeof(TestObject), kTypeIdOne);
+  ASSERT_NE(0u, ref);
+
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(0, kTypeIdOne));
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(ref + 1, kTypeIdOne));
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(
+      ref + PersistentMemoryAllocator::kAllocAlignment, kTypeIdOne));
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(
+      static_cast<PersistentMemoryAllocator::Reference>(allocator.used()),
+      kTypeIdOne));
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(
+      static_cast<PersistentMemoryAllocator::Reference>(kSegmentSize),
+      kTypeIdOne));
+  EXPECT_FALSE(allocator.GetAsObject<TestObject>(0xFFFFFFF8, kTypeIdOne));
+  EXPECT_EQ(0u, allocator.GetAllocSize(ref + 1));
+  EXPECT_EQ(0u, allocator.GetType(ref + 1));
+
+  // A block is too small for an object larger than it.
+  struct LargeObject {
+    char data[kSegmentSize / 2];
+  };
+  EXPECT_FALSE(allocator.GetAsObject<LargeObject>(ref, kTypeIdOne));
+  EXPECT_FALSE(allocator.IsCorrupt());
+}
+
+TEST(PersistentMemoryAllocatorTest, AttachToSegment) {
+  void* memory = AlignedAlloc(kSegmentSize,
+                              PersistentMemoryAllocator::kAllocAlignment);
+  memset(memory, 0, kSegmentSize);
+
+  PersistentMemoryAllocator::Reference ref;
+  {
+    PersistentMemoryAllocator allocator(memory, kSegmentSize, false);
+    ref = allocator.Allocate(sizeof(TestObject), kTypeIdOne);
+    ASSERT_NE(0u, ref);
+    allocator.GetAsObject<TestObject>(ref, kTypeIdOne)->values[1] = 7;
+    allocator.MakeIterable(ref);
+  }
+
+  // The segment, and its blocks, outlive the allocator that set it up.
+  PersistentMemoryAllocator reader(memory, kSegmentSize, true);
+  EXPECT_FALSE(reader.IsCorrupt());
+  PersistentMemoryAllocator::Iterator iter(&reader);
+  uint32 type_id;
+  EXPECT_EQ(ref, iter.GetNext(&type_id));
+  EXPECT_EQ(kTypeIdOne, type_id);
+  EXPECT_EQ(7, reader.GetAsObject<TestObject>(ref, kTypeIdOne)->values[1]);
+
+  // A read-only allocator can't allocate.
+  const size_t used = reader.used();
+  EXPECT_EQ(0u, reader.Allocate(sizeof(TestObject), kTypeIdOne));
+  EXPECT_EQ(used, reader.used());
+
+  AlignedFree(memory);
+}
+
+TEST(PersistentMemoryAllocatorTest, CorruptSegment) {
+  void* memory = AlignedAlloc(kSegmentSize,
+                              PersistentMemoryAllocator::kAllocAlignment);
+  memset(memory, 0x5A, kSegmentSize);
+
+  PersistentMemoryAllocator allocator(memory, kSegmentSize, false);
+  EXPECT_TRUE(allocator.IsCorrupt());
+  EXPECT_EQ(0u, allocator.Allocate(sizeof(TestObject), kTypeIdOne));
+  PersistentMemoryAllocator::Iterator iter(&allocator);
+  uint32 type_id;
+  EXPECT_EQ(0u, iter.GetNext(&type_id));
+
+  AlignedFree(memory);
+}
+
+TEST(PersistentMemoryAllocatorTest, IsMemoryAcceptable) {
+  char* memory = static_cast<char*>(AlignedAlloc(
+      kSegmentSize, PersistentMemoryAllocator::kAllocAlignment));
+  EXPECT_TRUE(PersistentMemoryAllocator::IsMemoryAcceptable(memory,
+                                                            kSegmentSize));
+  EXPECT_FALSE(PersistentMemoryAllocator::IsMemoryAcceptable(memory + 1,
+                                                             kSegmentSize - 8));
+  EXPECT_FALSE(PersistentMemoryAllocator::IsMemoryAcceptable(memory,
+                                                             kSegmentSize - 1));
+  EXPECT_FALSE(PersistentMemoryAllocator::IsMemoryAcceptable(memory, 8));
+  AlignedFree(memory);
+}
+
+TEST(PersistentMemoryAllocatorTest, ConcurrentAllocation) {
+  const int kThreadCount = 4;
+  const int kAllocationsPerThread = 50;
+  LocalPersistentMemoryAllocator allocator(64 << 10);
+
+  ScopedVector<AllocateThread> threads;
+  for (int i = 0; i < kThreadCount; ++i)
+    threads.push_back(new AllocateThread(&allocator, kAllocationsPerThread));
+  for (AllocateThread* thread : threads)
+    thread->Start();
+  for (AllocateThread* thread : threads)
+    thread->Join();
+
+  // Every block is found once, and none is lost.
+  std::set<PersistentMemoryAllocator::Reference> refs;
+  PersistentMemoryAllocator::Iterator iter(&allocator);
+  uint32 type_id;
+  PersistentMemoryAllocator::Reference ref;
+  while ((ref = iter.GetNext(&type_id)) != 0) {
+    EXPECT_EQ(kTypeIdOne, type_id);
+    EXPECT_TRUE(refs.insert(ref).second);
+  }
+  EXPECT_EQ(static_cast<size_t>(kThreadCount * kAllocationsPerThread),
+            refs.size());
+  EXPECT_FALSE(allocator.IsCorrupt());
+}
+
+TEST(PersistentMemoryAllocatorTest, SharedMemory) {
+  scoped_ptr<SharedMemory> memory(new SharedMemory);
+  ASSERT_TRUE(memory->CreateAndMapAnonymous(kSegmentSize));
+  ASSERT_TRUE(
+      SharedPersistentMemoryAllocator::IsSharedMemoryAcceptable(*memory));
+  scoped_ptr<SharedMemory> read_only_memory(new SharedMemory(
+      SharedMemory::DuplicateHandle(memory->handle()), true));
+
+  SharedPersistentMemoryAllocator allocator(memory.Pass(), false);
+  PersistentMemoryAllocator::Reference ref =
+      allocator.Allocate(sizeof(TestObject), kTypeIdOne);
+  ASSERT_NE(0u, ref);
+  allocator.GetAsObject<TestObject>(ref, kTypeIdOne)->values[2] = 3;
+  allocator.MakeIterable(ref);
+
+  // Another mapping of the memory finds the block.
+  ASSERT_TRUE(read_only_memory->Map(kSegmentSize));
+  SharedPersistentMemoryAllocator reader(read_only_memory.Pass(), true);
+  EXPECT_FALSE(reader.IsCorrupt());
+  PersistentMemoryAllocator::Iterator iter(&reader);
+  uint32 type_id;
+  EXPECT_EQ(ref, iter.GetNext(&type_id));
+  EXPECT_EQ(3, reader.GetAsObject<TestObject>(ref, kTypeIdOne)->values[2]);
+}
+
+}  // namespace base
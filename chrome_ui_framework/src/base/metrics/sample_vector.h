@@ -23,6 +23,12 @@ class BucketRanges;
 class BASE_EXPORT_PRIVATE SampleVector : public HistogramSamples {
  public:
   explicit SampleVector(const BucketRanges* bucket_ranges);
+  // Keeps the |counts_size| bucket counts in |counts| and the totals in
+  // |meta|, which must outlive the SampleVector.
+  SampleVector(HistogramBase::AtomicCount* counts,
+               size_t counts_size,
+               Metadata* meta,
+               const BucketRanges* bucket_ranges);
   ~SampleVector() override;
 
   // HistogramSamples implementation:
@@ -45,7 +51,13 @@ class BASE_EXPORT_PRIVATE SampleVector : public HistogramSamples {
  private:
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, CorruptSampleCounts);
 
-  std::vector<HistogramBase::AtomicCount> counts_;
+  // To count samples in the buckets, and to add them to snapshots.
+  friend class ShardedSampleVector;
+
+  // The bucket counts, in |local_counts_| unless they are kept elsewhere.
+  HistogramBase::AtomicCount* counts_;
+  size_t counts_size_;
+  std::vector<HistogramBase::AtomicCount> local_counts_;
 
   // Shares the same BucketRanges with Histogram object.
   const BucketRanges* const bucket_ranges_;
@@ -57,6 +69,9 @@ class BASE_EXPORT_PRIVATE SampleVectorIterator : public SampleCountIterator {
  public:
   SampleVectorIterator(const std::vector<HistogramBase::AtomicCount>* counts,
                        const BucketRanges* bucket_ranges);
+  SampleVectorIterator(const HistogramBase::AtomicCount* counts,
+                       size_t counts_size,
+                       const BucketRanges* bucket_ranges);
   ~SampleVectorIterator() override;
 
   // SampleCountIterator implementation:
@@ -72,7 +87,8 @@ class BASE_EXPORT_PRIVATE SampleVectorIterator : public SampleCountIterator {
  private:
   void SkipEmptyBuckets();
 
-  const std::vector<HistogramBase::AtomicCount>* counts_;
+  const HistogramBase::AtomicCount* counts_;
+  size_t counts_size_;
   const BucketRanges* bucket_ranges_;
 
   size_t index_;
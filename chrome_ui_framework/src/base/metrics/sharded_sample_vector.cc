@@ -0,0 +1,121 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_sample_vector.h"
+
+#if defined(OS_LINUX)
+#include <sched.h>
+#endif
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/sample_vector.h"
+#include "base/sys_info.h"
+#include "base/threading/platform_thread.h"
+
+namespace base {
+
+namespace {
+
+const size_t kCacheLineSize = 64;
+
+// More shards than this cost more memory than they save contention, so CPUs
+// share shards beyond it.
+const size_t kMaxShardCount = 32;
+
+size_t GetShardCount() {
+  const size_t processors =
+      std::min(static_cast<size_t>(std::max(SysInfo::NumberOfProcessors(), 1)),
+               kMaxShardCount);
+  size_t shard_count = 1;
+  while (shard_count < processors)
+    shard_count *= 2;
+  return shard_count;
+}
+
+}  // namespace
+
+ShardedSampleVector::ShardedSampleVector(const SampleVector* samples)
+    : samples_(samples),
+      bucket_count_(samples->bucket_ranges_->bucket_count()),
+      shard_mask_(GetShardCount() - 1),
+      shard_size_(0),
+      shards_(NULL) {
+  const size_t size =
+      sizeof(Shard) + bucket_count_ * sizeof(HistogramBase::AtomicCount);
+  shard_size_ = (size + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+  shards_ = static_cast<char*>(
+      AlignedAlloc(shard_count() * shard_size_, kCacheLineSize));
+  memset(shards_, 0, shard_count() * shard_size_);
+}
+
+ShardedSampleVector::~ShardedSampleVector() {
+  AlignedFree(shards_);
+}
+
+void ShardedSampleVector::Accumulate(HistogramBase::Sample value,
+                                     HistogramBase::Count count) {
+  AccumulateInShard(CurrentShardIndex(), value, count);
+}
+
+void ShardedSampleVector::AddTo(SampleVector* samples) const {
+  DCHECK(samples->bucket_ranges_->Equals(samples_->bucket_ranges_));
+  int64 sum = 0;
+  HistogramBase::Count redundant_count = 0;
+  for (size_t i = 0; i < shard_count(); ++i) {
+    Shard* shard = GetShard(i);
+    const HistogramBase::AtomicCount* counts = GetCounts(shard);
+    for (size_t j = 0; j < bucket_count_; ++j) {
+      const HistogramBase::Count count = subtle::NoBarrier_Load(&counts[j]);
+      if (count) {
+        subtle::NoBarrier_Store(
+            &samples->counts_[j],
+            subtle::NoBarrier_Load(&samples->counts_[j]) + count);
+      }
+    }
+    sum += shard->sum;
+    redundant_count += subtle::NoBarrier_Load(&shard->redundant_count);
+  }
+  samples->IncreaseSum(sum);
+  samples->IncreaseRedundantCount(redundant_count);
+}
+
+size_t ShardedSampleVector::CurrentShardIndex() const {
+#if defined(OS_LINUX)
+  const int cpu = sched_getcpu();
+  if (cpu >= 0)
+    return cpu & shard_mask_;
+#endif
+  // Spread the threads over the shards instead. Thread ids tend to be
+  // sequential, or multiples of a power of two.
+  const size_t id = static_cast<size_t>(PlatformThread::CurrentId());
+  return (id ^ (id >> 2) ^ (id >> 7)) & shard_mask_;
+}
+
+void ShardedSampleVector::AccumulateInShard(size_t shard_index,
+                                            HistogramBase::Sample value,
+                                            HistogramBase::Count count) {
+  const size_t bucket_index = samples_->GetBucketIndex(value);
+  Shard* shard = GetShard(shard_index);
+  subtle::NoBarrier_AtomicIncrement(&GetCounts(shard)[bucket_index], count);
+  subtle::NoBarrier_AtomicIncrement(&shard->redundant_count, count);
+  shard->sum += static_cast<int64>(count) * value;
+}
+
+ShardedSampleVector::Shard* ShardedSampleVector::GetShard(
+    size_t shard_index) const {
+  DCHECK_LT(shard_index, shard_count());
+  return reinterpret_cast<Shard*>(shards_ + shard_index * shard_size_);
+}
+
+// static
+HistogramBase::AtomicCount* ShardedSampleVector::GetCounts(Shard* shard) {
+  return reinterpret_cast<HistogramBase::AtomicCount*>(shard + 1);
+}
+
+}  // namespace base
@@ -0,0 +1,80 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ShardedSampleVector counts the samples of a histogram in shards, one per
+// CPU, that are added together when the histogram is snapshotted. It is used
+// by the histograms with HistogramBase::kShardedSamplesFlag.
+//
+// The counts of a SampleVector are shared by all threads, so threads that
+// record samples of the same histogram at the same time keep taking the cache
+// lines of the counts from each other. A thread adds its samples to the shard
+// of the CPU that it runs on instead, with atomic adds which only contend when
+// threads are moved across CPUs. Each shard starts on its own cache line.
+
+#ifndef BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
+#define BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/gtest_prod_util.h"
+#include "base/metrics/histogram_base.h"
+
+namespace base {
+
+class SampleVector;
+
+class BASE_EXPORT_PRIVATE ShardedSampleVector {
+ public:
+  // The shards count the samples of |samples|, which must outlive them, in
+  // the buckets of its BucketRanges.
+  explicit ShardedSampleVector(const SampleVector* samples);
+  ~ShardedSampleVector();
+
+  void Accumulate(HistogramBase::Sample value, HistogramBase::Count count);
+
+  // Adds the samples of all the shards to |samples|, which must have the same
+  // BucketRanges.
+  void AddTo(SampleVector* samples) const;
+
+  size_t shard_count() const { return shard_mask_ + 1; }
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(ShardedSampleVectorTest, AddToMergesShards);
+
+  struct Shard {
+    // Like HistogramSamples::sum_, this is added to without atomics, so it
+    // may miss the samples of threads that add to the shard at the same time.
+    int64 sum;
+    HistogramBase::AtomicCount redundant_count;
+    // Followed by the count of each bucket.
+  };
+
+  // Returns the index of the shard of the current CPU.
+  size_t CurrentShardIndex() const;
+
+  void AccumulateInShard(size_t shard_index,
+                         HistogramBase::Sample value,
+                         HistogramBase::Count count);
+
+  Shard* GetShard(size_t shard_index) const;
+  static HistogramBase::AtomicCount* GetCounts(Shard* shard);
+
+  const SampleVector* const samples_;
+  const size_t bucket_count_;
+
+  // The number of shards is a power of two.
+  size_t shard_mask_;
+
+  // The size of a shard in bytes, a multiple of the cache line size.
+  size_t shard_size_;
+
+  // The shards, aligned to a cache line.
+  char* shards_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedSampleVector);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
@@ -0,0 +1,117 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_sample_vector.h"
+
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/sample_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Custom buckets: [0, 5) [5, 10) [10, INT_MAX)
+void InitializeRanges(BucketRanges* ranges) {
+  ranges->set_range(0, 0);
+  ranges->set_range(1, 5);
+  ranges->set_range(2, 10);
+  ranges->set_range(3, HistogramBase::kSampleType_MAX);
+}
+
+class AccumulateThread : public SimpleThread {
+ public:
+  AccumulateThread(ShardedSampleVector* samples, int iterations)
+      : SimpleThread("AccumulateThread"),
+        samples_(samples),
+        iterations_(iterations) {}
+
+  void Run() override {
+    for (int i = 0; i < iterations_; ++i) {
+      samples_->Accumulate(1, 1);
+      samples_->Accumulate(20, 2);
+    }
+  }
+
+ private:
+  ShardedSampleVector* samples_;
+  const int iterations_;
+
+  DISALLOW_COPY_AND_ASSIGN(AccumulateThread);
+};
+
+}  // namespace
+
+TEST(ShardedSampleVectorTest, AccumulateAndAddTo) {
+  BucketRanges ranges(4);
+  InitializeRanges(&ranges);
+  SampleVector samples(&ranges);
+  ShardedSampleVector sharded_samples(&samples);
+  EXPECT_GE(sharded_samples.shard_count(), 1u);
+
+  sharded_samples.Accumulate(1, 10);
+  sharded_samples.Accumulate(7, 2);
+  sharded_samples.Accumulate(100, 1);
+  // The unsharded samples are not changed.
+  EXPECT_EQ(0, samples.TotalCount());
+
+  SampleVector snapshot(&ranges);
+  snapshot.Accumulate(6, 1);
+  sharded_samples.AddTo(&snapshot);
+  EXPECT_EQ(10, snapshot.GetCountAtIndex(0));
+  EXPECT_EQ(3, snapshot.GetCountAtIndex(1));
+  EXPECT_EQ(1, snapshot.GetCountAtIndex(2));
+  EXPECT_EQ(14, snapshot.TotalCount());
+  EXPECT_EQ(14, snapshot.redundant_count());
+  EXPECT_EQ(10 + 14 + 6 + 100, snapshot.sum());
+}
+
+TEST(ShardedSampleVectorTest, AddToMergesShards) {
+  BucketRanges ranges(4);
+  InitializeRanges(&ranges);
+  SampleVector samples(&ranges);
+  ShardedSampleVector sharded_samples(&samples);
+
+  for (size_t i = 0; i < sharded_samples.shard_count(); ++i) {
+    sharded_samples.AccumulateInShard(i, 3, 1);
+    sharded_samples.AccumulateInShard(i, 12, 2);
+  }
+
+  SampleVector snapshot(&ranges);
+  sharded_samples.AddTo(&snapshot);
+  const int shard_count = static_cast<int>(sharded_samples.shard_count());
+  EXPECT_EQ(shard_count, snapshot.GetCountAtIndex(0));
+  EXPECT_EQ(0, snapshot.GetCountAtIndex(1));
+  EXPECT_EQ(2 * shard_count, snapshot.GetCountAtIndex(2));
+  EXPECT_EQ(3 * shard_count, snapshot.redundant_count());
+  EXPECT_EQ(27 * shard_count, snapshot.sum());
+}
+
+TEST(ShardedSampleVectorTest, AccumulateOnManyThreads) {
+  const int kThreadCount = 8;
+  const int kIterations = 10000;
+  BucketRanges ranges(4);
+  InitializeRanges(&ranges);
+  SampleVector samples(&ranges);
+  ShardedSampleVector sharded_samples(&samples);
+
+  ScopedVector<AccumulateThread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.push_back(new AccumulateThread(&sharded_samples, kIterations));
+    threads.back()->Start();
+  }
+  for (int i = 0; i < kThreadCount; ++i)
+    threads[i]->Join();
+
+  // The counts are added to atomically, so none are lost.
+  SampleVector snapshot(&ranges);
+  sharded_samples.AddTo(&snapshot);
+  EXPECT_EQ(kThreadCount * kIterations, snapshot.GetCountAtIndex(0));
+  EXPECT_EQ(2 * kThreadCount * kIterations, snapshot.GetCountAtIndex(2));
+  EXPECT_EQ(3 * kThreadCount * kIterations, snapshot.redundant_count());
+}
+
+}  // namespace base
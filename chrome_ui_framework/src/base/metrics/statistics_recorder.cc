@@ -6,10 +6,12 @@
 
 #include "base/at_exit.h"
 #include "base/debug/leak_annotations.h"
+#include "base/hash.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
+#include "base/metrics/persistent_histogram_allocator.h"
 #include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
@@ -23,6 +25,108 @@ base::LazyInstance<base::StatisticsRecorder>::Leaky g_statistics_recorder_ =
 
 namespace base {
 
+namespace {
+
+// The capacity of the first lookup table. Each table is at most half full, so
+// that lookups end after a few probes.
+const size_t kInitialLookupTableCapacity = 256;
+
+// Moves the samples of |histogram| to the segment of the global
+// PersistentHistogramAllocator, if there is one. This is only done for a
+// histogram that is being registered, before any other thread can find it, so
+// that duplicates that lose a race to register do not take space in the
+// segment, and the reader of the segment does not see them.
+void AllocatePersistentSamples(HistogramBase* histogram) {
+  PersistentHistogramAllocator* allocator =
+      PersistentHistogramAllocator::GetGlobalAllocator();
+  if (!allocator || histogram->GetHistogramType() == SPARSE_HISTOGRAM)
+    return;
+  allocator->AllocateSamples(static_cast<Histogram*>(histogram));
+}
+
+}  // namespace
+
+// Histograms are only ever added to the lookup table, so a slot that holds a
+// histogram keeps it. A writer stores the hash of a slot before publishing its
+// histogram with a release store, and readers load the histogram with an
+// acquire load before they look at the hash or the histogram. When a table
+// gets too full, its histograms are copied to a table twice as large, which is
+// then published in |lookup_table_|. Readers that still use the old table may
+// miss the histograms added since, and then go through
+// RegisterOrDeleteDuplicate(), which finds them under the lock. Old tables are
+// kept alive until the StatisticsRecorder is destroyed, since a reader may be
+// using any of them.
+class StatisticsRecorder::LookupTable {
+ public:
+  LookupTable(size_t capacity, LookupTable* previous)
+      : slots_(new Slot[capacity]),
+        mask_(capacity - 1),
+        size_(0),
+        previous_(previous) {
+    DCHECK_EQ(0u, capacity & mask_);
+    for (size_t i = 0; i < capacity; ++i) {
+      slots_[i].hash = 0;
+      slots_[i].histogram = 0;
+    }
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+  size_t size() const { return size_; }
+
+  HistogramBase* Find(const std::string& name) const {
+    const subtle::AtomicWord hash = Hash(name);
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      HistogramBase* histogram = reinterpret_cast<HistogramBase*>(
+          subtle::Acquire_Load(&slots_[i].histogram));
+      if (!histogram)
+        return NULL;
+      if (subtle::NoBarrier_Load(&slots_[i].hash) == hash &&
+          histogram->histogram_name() == name) {
+        return histogram;
+      }
+    }
+  }
+
+  // Must not be called with the histogram already in the table, nor when the
+  // table would then be more than half full.
+  void Insert(HistogramBase* histogram) {
+    DCHECK_LE((size_ + 1) * 2, capacity());
+    const subtle::AtomicWord hash = Hash(histogram->histogram_name());
+    size_t i = hash & mask_;
+    while (subtle::NoBarrier_Load(&slots_[i].histogram))
+      i = (i + 1) & mask_;
+    subtle::NoBarrier_Store(&slots_[i].hash, hash);
+    subtle::Release_Store(&slots_[i].histogram,
+                          reinterpret_cast<subtle::AtomicWord>(histogram));
+    ++size_;
+  }
+
+  // Copies the histograms of this table to |table|.
+  void InsertAllInto(LookupTable* table) const {
+    for (size_t i = 0; i < capacity(); ++i) {
+      subtle::AtomicWord histogram = subtle::NoBarrier_Load(
+          &slots_[i].histogram);
+      if (histogram)
+        table->Insert(reinterpret_cast<HistogramBase*>(histogram));
+    }
+  }
+
+ private:
+  struct Slot {
+    subtle::AtomicWord hash;
+    subtle::AtomicWord histogram;
+  };
+
+  scoped_ptr<Slot[]> slots_;
+  const size_t mask_;
+  size_t size_;
+
+  // The table this one replaced, which readers may still be using.
+  scoped_ptr<LookupTable> previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupTable);
+};
+
 // static
 void StatisticsRecorder::Initialize() {
   // Ensure that an instance of the StatisticsRecorder object is created.
@@ -31,10 +135,7 @@ void StatisticsRecorder::Initialize() {
 
 // static
 bool StatisticsRecorder::IsActive() {
-  if (lock_ == NULL)
-    return false;
-  base::AutoLock auto_lock(*lock_);
-  return NULL != histograms_;
+  return subtle::Acquire_Load(&lookup_table_) != 0;
 }
 
 // static
@@ -47,6 +148,7 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
   // twice if (lock_ == NULL) || (!histograms_).
   if (lock_ == NULL) {
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
+    AllocatePersistentSamples(histogram);
     return histogram;
   }
 
@@ -55,13 +157,16 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
   {
     base::AutoLock auto_lock(*lock_);
     if (histograms_ == NULL) {
+      AllocatePersistentSamples(histogram);
       histogram_to_return = histogram;
     } else {
       const std::string& name = histogram->histogram_name();
       HistogramMap::iterator it = histograms_->find(HistogramNameRef(name));
       if (histograms_->end() == it) {
+        AllocatePersistentSamples(histogram);
         (*histograms_)[HistogramNameRef(name)] = histogram;
         ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
+        AddToLookupTable(histogram);
         // If there are callbacks for this histogram, we set the kCallbackExists
         // flag.
         auto callback_iterator = callbacks_->find(name);
@@ -223,16 +328,11 @@ void StatisticsRecorder::GetBucketRanges(
 
 // static
 HistogramBase* StatisticsRecorder::FindHistogram(const std::string& name) {
-  if (lock_ == NULL)
-    return NULL;
-  base::AutoLock auto_lock(*lock_);
-  if (histograms_ == NULL)
+  const LookupTable* table =
+      reinterpret_cast<LookupTable*>(subtle::Acquire_Load(&lookup_table_));
+  if (!table)
     return NULL;
-
-  HistogramMap::iterator it = histograms_->find(HistogramNameRef(name));
-  if (histograms_->end() == it)
-    return NULL;
-  return it->second;
+  return table->Find(name);
 }
 
 // static
@@ -320,6 +420,9 @@ StatisticsRecorder::StatisticsRecorder() {
   histograms_ = new HistogramMap;
   callbacks_ = new CallbackMap;
   ranges_ = new RangesMap;
+  subtle::Release_Store(
+      &lookup_table_, reinterpret_cast<subtle::AtomicWord>(
+                          new LookupTable(kInitialLookupTableCapacity, NULL)));
 
   if (VLOG_IS_ON(1))
     AtExitManager::RegisterCallback(&DumpHistogramsToVlog, this);
@@ -332,6 +435,21 @@ void StatisticsRecorder::DumpHistogramsToVlog(void* instance) {
   VLOG(1) << output;
 }
 
+// static
+void StatisticsRecorder::AddToLookupTable(HistogramBase* histogram) {
+  lock_->AssertAcquired();
+  LookupTable* table =
+      reinterpret_cast<LookupTable*>(subtle::NoBarrier_Load(&lookup_table_));
+  if ((table->size() + 1) * 2 > table->capacity()) {
+    LookupTable* larger_table = new LookupTable(table->capacity() * 2, table);
+    table->InsertAllInto(larger_table);
+    subtle::Release_Store(&lookup_table_,
+                          reinterpret_cast<subtle::AtomicWord>(larger_table));
+    table = larger_table;
+  }
+  table->Insert(histogram);
+}
+
 StatisticsRecorder::~StatisticsRecorder() {
   DCHECK(histograms_ && ranges_ && lock_);
 
@@ -339,6 +457,7 @@ StatisticsRecorder::~StatisticsRecorder() {
   scoped_ptr<HistogramMap> histograms_deleter;
   scoped_ptr<CallbackMap> callbacks_deleter;
   scoped_ptr<RangesMap> ranges_deleter;
+  scoped_ptr<LookupTable> lookup_table_deleter;
   // We don't delete lock_ on purpose to avoid having to properly protect
   // against it going away after we checked for NULL in the static methods.
   {
@@ -346,6 +465,10 @@ StatisticsRecorder::~StatisticsRecorder() {
     histograms_deleter.reset(histograms_);
     callbacks_deleter.reset(callbacks_);
     ranges_deleter.reset(ranges_);
+    // Lookups do not take the lock, so this must not race with them.
+    lookup_table_deleter.reset(
+        reinterpret_cast<LookupTable*>(subtle::NoBarrier_Load(&lookup_table_)));
+    subtle::Release_Store(&lookup_table_, 0);
     histograms_ = NULL;
     callbacks_ = NULL;
     ranges_ = NULL;
@@ -362,5 +485,7 @@ StatisticsRecorder::CallbackMap* StatisticsRecorder::callbacks_ = NULL;
 StatisticsRecorder::RangesMap* StatisticsRecorder::ranges_ = NULL;
 // static
 base::Lock* StatisticsRecorder::lock_ = NULL;
+// static
+subtle::AtomicWord StatisticsRecorder::lookup_table_ = 0;
 
 }  // namespace base
@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/callback.h"
@@ -67,7 +68,8 @@ class BASE_EXPORT StatisticsRecorder {
   static void GetBucketRanges(std::vector<const BucketRanges*>* output);
 
   // Find a histogram by name. It matches the exact name. This method is thread
-  // safe.  It returns NULL if a matching histogram is not found.
+  // safe, and takes no lock.  It returns NULL if a matching histogram is not
+  // found.
   static HistogramBase* FindHistogram(const std::string& name);
 
   // GetSnapshot copies some of the pointers to registered histograms into the
@@ -123,11 +125,16 @@ class BASE_EXPORT StatisticsRecorder {
   // |bucket_ranges_|.
   typedef std::map<uint32, std::list<const BucketRanges*>*> RangesMap;
 
+  // An open addressing hash table of the registered histograms, which
+  // FindHistogram() reads without taking |lock_|. See statistics_recorder.cc.
+  class LookupTable;
+
   friend struct DefaultLazyInstanceTraits<StatisticsRecorder>;
   friend class HistogramBaseTest;
   friend class HistogramSnapshotManagerTest;
   friend class HistogramTest;
   friend class JsonPrefStoreTest;
+  friend class PersistentHistogramAllocatorTest;
   friend class SparseHistogramTest;
   friend class StatisticsRecorderTest;
   FRIEND_TEST_ALL_PREFIXES(HistogramDeltaSerializationTest,
@@ -141,6 +148,10 @@ class BASE_EXPORT StatisticsRecorder {
 
   static void DumpHistogramsToVlog(void* instance);
 
+  // Adds |histogram| to the lookup table, replacing the table with a larger
+  // one when it gets too full. Must be called with |lock_| held.
+  static void AddToLookupTable(HistogramBase* histogram);
+
   static HistogramMap* histograms_;
   static CallbackMap* callbacks_;
   static RangesMap* ranges_;
@@ -148,6 +159,10 @@ class BASE_EXPORT StatisticsRecorder {
   // Lock protects access to above maps.
   static base::Lock* lock_;
 
+  // The LookupTable of |histograms_|, or 0 when |histograms_| is NULL. It is
+  // only replaced with |lock_| held, and is read with an acquire load.
+  static subtle::AtomicWord lookup_table_;
+
   DISALLOW_COPY_AND_ASSIGN(StatisticsRecorder);
 };
 
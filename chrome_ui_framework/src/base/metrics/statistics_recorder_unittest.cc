@@ -7,14 +7,48 @@
 #include "base/bind.h"
 #include "base/json/json_reader.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/sparse_histogram.h"
 #include "base/metrics/statistics_recorder.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace base {
 
+namespace {
+
+// Looks up the histograms named by |names| over and over, until it finds all
+// of them. Each histogram that it finds must have the name it looked up.
+class FindHistogramsThread : public SimpleThread {
+ public:
+  explicit FindHistogramsThread(const std::vector<std::string>* names)
+      : SimpleThread("FindHistogramsThread"), names_(names) {}
+
+  void Run() override {
+    size_t found;
+    do {
+      found = 0;
+      for (const std::string& name : *names_) {
+        HistogramBase* histogram = StatisticsRecorder::FindHistogram(name);
+        if (histogram) {
+          ASSERT_EQ(name, histogram->histogram_name());
+          ++found;
+        }
+      }
+    } while (found < names_->size());
+  }
+
+ private:
+  const std::vector<std::string>* names_;
+
+  DISALLOW_COPY_AND_ASSIGN(FindHistogramsThread);
+};
+
+}  // namespace
+
 class StatisticsRecorderTest : public testing::Test {
  protected:
   void SetUp() override {
@@ -151,6 +185,42 @@ TEST_F(StatisticsRecorderTest, FindHistogram) {
   EXPECT_TRUE(StatisticsRecorder::FindHistogram("TestHistogram") == NULL);
 }
 
+TEST_F(StatisticsRecorderTest, FindHistogramAfterLookupTableGrows) {
+  // Enough histograms to replace the lookup table a few times.
+  const int kHistogramCount = 2000;
+  std::vector<HistogramBase*> histograms;
+  for (int i = 0; i < kHistogramCount; ++i) {
+    histograms.push_back(Histogram::FactoryGet(
+        "TestHistogram" + IntToString(i), 1, 1000, 10,
+        HistogramBase::kNoFlags));
+  }
+
+  for (int i = 0; i < kHistogramCount; ++i) {
+    EXPECT_EQ(histograms[i],
+              StatisticsRecorder::FindHistogram("TestHistogram" +
+                                                IntToString(i)));
+  }
+  EXPECT_TRUE(StatisticsRecorder::FindHistogram("TestHistogram") == NULL);
+}
+
+TEST_F(StatisticsRecorderTest, FindHistogramWhileRegistering) {
+  const int kHistogramCount = 2000;
+  const int kThreadCount = 4;
+  std::vector<std::string> names;
+  for (int i = 0; i < kHistogramCount; ++i)
+    names.push_back("TestHistogram" + IntToString(i));
+
+  ScopedVector<FindHistogramsThread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.push_back(new FindHistogramsThread(&names));
+    threads.back()->Start();
+  }
+  for (const std::string& name : names)
+    Histogram::FactoryGet(name, 1, 1000, 10, HistogramBase::kNoFlags);
+  for (FindHistogramsThread* thread : threads)
+    thread->Join();
+}
+
 TEST_F(StatisticsRecorderTest, GetSnapshot) {
   Histogram::FactoryGet("TestHistogram1", 1, 1000, 10, Histogram::kNoFlags);
   Histogram::FactoryGet("TestHistogram2", 1, 1000, 10, Histogram::kNoFlags);
@@ -19,7 +19,18 @@ const int Pickle::kPayloadUnit = 64;
 
 static const size_t kCapacityReadOnly = static_cast<size_t>(-1);
 
+// Pads the external blobs to 32 bits.
+static const char kPadding[sizeof(uint32)] = {0};
+
 PickleIterator::PickleIterator(const Pickle& pickle)
+    : payload_(pickle.payload()),
+      read_index_(0),
+      end_index_(pickle.has_external_data()
+                     ? pickle.external_data_.front().offset
+                     : pickle.payload_size()) {
+}
+
+PickleIterator::PickleIterator(const PickleView& pickle)
     : payload_(pickle.payload()),
       read_index_(0),
       end_index_(pickle.payload_size()) {
@@ -207,13 +218,32 @@ bool PickleIterator::ReadBytes(const char** data, int length) {
   return true;
 }
 
+PickleView::PickleView(const void* data, size_t data_len)
+    : payload_(NULL), payload_size_(0), header_size_(0) {
+  Pickle::Header header;
+  if (data_len < sizeof(header))
+    return;
+  // The header is copied, so that its size is only read once.
+  memcpy(&header, data, sizeof(header));
+  if (header.payload_size > data_len - sizeof(header))
+    return;
+  const size_t header_size = data_len - header.payload_size;
+  if (header_size != bits::Align(header_size, sizeof(uint32)))
+    return;
+
+  payload_ = static_cast<const char*>(data) + header_size;
+  payload_size_ = header.payload_size;
+  header_size_ = header_size;
+}
+
 // Payload is uint32 aligned.
 
 Pickle::Pickle()
     : header_(NULL),
       header_size_(sizeof(Header)),
       capacity_after_header_(0),
-      write_offset_(0) {
+      write_offset_(0),
+      external_data_size_(0) {
   static_assert((Pickle::kPayloadUnit & (Pickle::kPayloadUnit - 1)) == 0,
                 "Pickle::kPayloadUnit must be a power of two");
   Resize(kPayloadUnit);
@@ -224,7 +254,8 @@ Pickle::Pickle(int header_size)
     : header_(NULL),
       header_size_(bits::Align(header_size, sizeof(uint32))),
       capacity_after_header_(0),
-      write_offset_(0) {
+      write_offset_(0),
+      external_data_size_(0) {
   DCHECK_GE(static_cast<size_t>(header_size), sizeof(Header));
   DCHECK_LE(header_size, kPayloadUnit);
   Resize(kPayloadUnit);
@@ -235,7 +266,8 @@ Pickle::Pickle(const char* data, int data_len)
     : header_(reinterpret_cast<Header*>(const_cast<char*>(data))),
       header_size_(0),
       capacity_after_header_(kCapacityReadOnly),
-      write_offset_(0) {
+      write_offset_(0),
+      external_data_size_(0) {
   if (data_len >= static_cast<int>(sizeof(Header)))
     header_size_ = data_len - header_->payload_size;
 
@@ -254,9 +286,14 @@ Pickle::Pickle(const Pickle& other)
     : header_(NULL),
       header_size_(other.header_size_),
       capacity_after_header_(0),
-      write_offset_(other.write_offset_) {
-  Resize(other.header_->payload_size);
-  memcpy(header_, other.header_, header_size_ + other.header_->payload_size);
+      write_offset_(other.write_offset_),
+      external_data_(other.external_data_),
+      external_data_size_(other.external_data_size_) {
+  // The external blobs are shared rather than copied.
+  const size_t buffered_size =
+      other.header_->payload_size - other.external_data_size_;
+  Resize(buffered_size);
+  memcpy(header_, other.header_, header_size_ + buffered_size);
 }
 
 Pickle::~Pickle() {
@@ -278,10 +315,13 @@ Pickle& Pickle::operator=(const Pickle& other) {
     header_ = NULL;
     header_size_ = other.header_size_;
   }
-  Resize(other.header_->payload_size);
-  memcpy(header_, other.header_,
-         other.header_size_ + other.header_->payload_size);
+  const size_t buffered_size =
+      other.header_->payload_size - other.external_data_size_;
+  Resize(buffered_size);
+  memcpy(header_, other.header_, other.header_size_ + buffered_size);
   write_offset_ = other.write_offset_;
+  external_data_ = other.external_data_;
+  external_data_size_ = other.external_data_size_;
   return *this;
 }
 
@@ -309,13 +349,90 @@ bool Pickle::WriteBytes(const void* data, int length) {
   return true;
 }
 
+bool Pickle::WriteDataExternal(const scoped_refptr<RefCountedMemory>& data) {
+  const size_t length = data->size();
+  if (length > static_cast<size_t>(std::numeric_limits<int>::max()))
+    return false;
+  const size_t data_len = bits::Align(length, sizeof(uint32));
+  if (write_offset_ + external_data_size_ + sizeof(int) >
+      kuint32max - data_len) {
+    return false;
+  }
+
+  WriteInt(static_cast<int>(length));
+  ExternalData external_data = {write_offset_, data};
+  external_data_.push_back(external_data);
+  external_data_size_ += data_len;
+  header_->payload_size += static_cast<uint32>(data_len);
+  return true;
+}
+
+void Pickle::GetSegments(std::vector<StringPiece>* segments) const {
+  const char* buffer = reinterpret_cast<const char*>(header_);
+  size_t buffer_offset = 0;
+  for (const ExternalData& external_data : external_data_) {
+    const size_t buffer_end = header_size_ + external_data.offset;
+    segments->push_back(
+        StringPiece(buffer + buffer_offset, buffer_end - buffer_offset));
+    buffer_offset = buffer_end;
+
+    const size_t length = external_data.data->size();
+    if (length) {
+      segments->push_back(StringPiece(
+          reinterpret_cast<const char*>(external_data.data->front()),
+          length));
+    }
+    const size_t padding = bits::Align(length, sizeof(uint32)) - length;
+    if (padding)
+      segments->push_back(StringPiece(kPadding, padding));
+  }
+  const size_t buffer_end = size() - external_data_size_;
+  if (buffer_end > buffer_offset) {
+    segments->push_back(
+        StringPiece(buffer + buffer_offset, buffer_end - buffer_offset));
+  }
+}
+
+void Pickle::Flatten() {
+  if (external_data_.empty())
+    return;
+
+  const size_t new_size = write_offset_ + external_data_size_;
+  if (new_size > capacity_after_header_)
+    Resize(new_size);
+
+  // Each run of the buffer is moved to where it goes, from the last one, and
+  // the blob before it is copied in front of it.
+  char* payload = mutable_payload();
+  size_t run_end = write_offset_;
+  size_t end = new_size;
+  for (auto it = external_data_.rbegin(); it != external_data_.rend(); ++it) {
+    const size_t run_size = run_end - it->offset;
+    end -= run_size;
+    memmove(payload + end, payload + it->offset, run_size);
+    run_end = it->offset;
+
+    const size_t length = it->data->size();
+    const size_t data_len = bits::Align(length, sizeof(uint32));
+    end -= data_len;
+    if (length)
+      memcpy(payload + end, it->data->front(), length);
+    memset(payload + end + length, 0, data_len - length);
+  }
+  DCHECK_EQ(run_end, end);
+
+  external_data_.clear();
+  external_data_size_ = 0;
+  write_offset_ = new_size;
+}
+
 void Pickle::Reserve(size_t length) {
   size_t data_len = bits::Align(length, sizeof(uint32));
   DCHECK_GE(data_len, length);
 #ifdef ARCH_CPU_64_BITS
   DCHECK_LE(data_len, kuint32max);
 #endif
-  DCHECK_LE(write_offset_, kuint32max - data_len);
+  DCHECK_LE(write_offset_ + external_data_size_, kuint32max - data_len);
   size_t new_size = write_offset_ + data_len;
   if (new_size > capacity_after_header_)
     Resize(capacity_after_header_ * 2 + new_size);
@@ -393,7 +510,7 @@ inline void Pickle::WriteBytesCommon(const void* data, size_t length) {
 #ifdef ARCH_CPU_64_BITS
   DCHECK_LE(data_len, kuint32max);
 #endif
-  DCHECK_LE(write_offset_, kuint32max - data_len);
+  DCHECK_LE(write_offset_ + external_data_size_, kuint32max - data_len);
   size_t new_size = write_offset_ + data_len;
   if (new_size > capacity_after_header_) {
     size_t new_capacity = capacity_after_header_ * 2;
@@ -406,7 +523,7 @@ inline void Pickle::WriteBytesCommon(const void* data, size_t length) {
   char* write = mutable_payload() + write_offset_;
   memcpy(write, data, length);
   memset(write + length, 0, data_len - length);
-  header_->payload_size = static_cast<uint32>(new_size);
+  header_->payload_size = static_cast<uint32>(new_size + external_data_size_);
   write_offset_ = new_size;
 }
 
@@ -6,25 +6,31 @@
 #define BASE_PICKLE_H_
 
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
 #include "base/gtest_prod_util.h"
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/strings/string16.h"
 #include "base/strings/string_piece.h"
 
 namespace base {
 
 class Pickle;
+class PickleView;
 
-// PickleIterator reads data from a Pickle. The Pickle object must remain valid
-// while the PickleIterator object is in use.
+// PickleIterator reads data from a Pickle or a PickleView. The Pickle object,
+// or the memory of the PickleView, must remain valid while the PickleIterator
+// object is in use.
 class BASE_EXPORT PickleIterator {
  public:
   PickleIterator() : payload_(NULL), read_index_(0), end_index_(0) {}
   explicit PickleIterator(const Pickle& pickle);
+  explicit PickleIterator(const PickleView& pickle);
 
   // Methods for reading the payload of the Pickle. To read from the start of
   // the Pickle, create a PickleIterator from a Pickle. If successful, these
@@ -102,6 +108,30 @@ class BASE_EXPORT PickleIterator {
   FRIEND_TEST_ALL_PREFIXES(PickleTest, GetReadPointerAndAdvance);
 };
 
+// PickleView is a read-only view of a pickle in memory that the caller owns,
+// such as a mapped file or shared memory, which must outlive the view and the
+// PickleIterators made from it. Unlike a read-only Pickle, the size of the
+// payload is read from the memory once, when the view is made, so that reads
+// stay within |data_len| bytes even if another process changes the memory
+// while it is read.
+class BASE_EXPORT PickleView {
+ public:
+  // The header padding size is deduced from |data_len|, as for a read-only
+  // Pickle. The view is invalid if the data isn't a whole pickle.
+  PickleView(const void* data, size_t data_len);
+
+  bool IsValid() const { return payload_ != NULL; }
+
+  size_t header_size() const { return header_size_; }
+  const char* payload() const { return payload_; }
+  size_t payload_size() const { return payload_size_; }
+
+ private:
+  const char* payload_;
+  size_t payload_size_;
+  size_t header_size_;
+};
+
 // This class provides facilities for basic binary value packing and unpacking.
 //
 // The Pickle class supports appending primitive values (ints, strings, etc.)
@@ -119,6 +149,12 @@ class BASE_EXPORT PickleIterator {
 // space is controlled by the header_size parameter passed to the Pickle
 // constructor.
 //
+// Large blobs can be written with WriteDataExternal(), which refers to the
+// blob instead of copying it into the Pickle's buffer. The data of such a
+// Pickle is then in several segments, which are either sent as they are with
+// GetSegments(), or copied into the buffer with Flatten() by the code that
+// needs the whole Pickle in data().
+//
 class BASE_EXPORT Pickle {
  public:
   // Initialize a Pickle object using the default header size.
@@ -135,7 +171,8 @@ class BASE_EXPORT Pickle {
   // padding size is deduced from the data length.
   Pickle(const char* data, int data_len);
 
-  // Initializes a Pickle as a deep copy of another Pickle.
+  // Initializes a Pickle as a copy of another Pickle. The buffer is copied,
+  // but the external blobs are shared.
   Pickle(const Pickle& other);
 
   // Note: There are no virtual methods in this class.  This destructor is
@@ -145,13 +182,15 @@ class BASE_EXPORT Pickle {
   // destructor, suggesting at least some need to call more derived destructors.
   virtual ~Pickle();
 
-  // Performs a deep copy.
+  // Copies the buffer of |other|, and shares its external blobs.
   Pickle& operator=(const Pickle& other);
 
-  // Returns the number of bytes written in the Pickle, including the header.
+  // Returns the number of bytes written in the Pickle, including the header
+  // and the external data.
   size_t size() const { return header_size_ + header_->payload_size; }
 
-  // Returns the data for this Pickle.
+  // Returns the data for this Pickle. If the Pickle has external data, this
+  // is only its buffer, which doesn't hold the blobs; see GetSegments().
   const void* data() const { return header_; }
 
   // Returns the effective memory capacity of this Pickle, that is, the total
@@ -211,6 +250,24 @@ class BASE_EXPORT Pickle {
   // when reading and writing. It is normally used to serialize PoD types of a
   // known size. See also WriteData.
   bool WriteBytes(const void* data, int length);
+  // Like WriteData, but the blob is referred to rather than copied, until the
+  // Pickle is flattened. The blob must not change while it is referred to.
+  // It is read like any other "Data".
+  bool WriteDataExternal(const scoped_refptr<RefCountedMemory>& data);
+
+  // Returns true if WriteDataExternal() was called since the Pickle was made
+  // or last flattened. The payload can then only be read up to the first
+  // external blob.
+  bool has_external_data() const { return !external_data_.empty(); }
+
+  // Appends the data of the Pickle to |segments|: the runs of the buffer,
+  // with the external blobs and their padding in between. The segments are
+  // only valid until the Pickle is changed.
+  void GetSegments(std::vector<StringPiece>* segments) const;
+
+  // Copies the external blobs into the buffer, so that data() holds the
+  // whole Pickle.
+  void Flatten();
 
   // Reserves space for upcoming writes when multiple writes will be made and
   // their sizes are computed in advance. It can be significantly faster to call
@@ -246,10 +303,11 @@ class BASE_EXPORT Pickle {
   }
 
   // Returns the address of the byte immediately following the currently valid
-  // header + payload.
+  // header + payload, or the part of the payload in the buffer if the Pickle
+  // has external data.
   const char* end_of_payload() const {
     // This object may be invalid.
-    return header_ ? payload() + payload_size() : NULL;
+    return header_ ? payload() + payload_size() - external_data_size_ : NULL;
   }
 
  protected:
@@ -289,6 +347,13 @@ class BASE_EXPORT Pickle {
  private:
   friend class PickleIterator;
 
+  // A blob written by WriteDataExternal(), which is in the payload after the
+  // first |offset| bytes of the buffer.
+  struct ExternalData {
+    size_t offset;
+    scoped_refptr<RefCountedMemory> data;
+  };
+
   Header* header_;
   size_t header_size_;  // Supports extra data between header and payload.
   // Allocation size of payload (or -1 if allocation is const). Note: this
@@ -297,6 +362,9 @@ class BASE_EXPORT Pickle {
   // The offset at which we will write the next field. Note: this doesn't count
   // the header.
   size_t write_offset_;
+  std::vector<ExternalData> external_data_;
+  // The size of the external blobs, padded to 32 bits each.
+  size_t external_data_size_;
 
   // Just like WriteBytes, but with a compile-time size, for performance.
   template<size_t length> void BASE_EXPORT WriteBytesStatic(const void* data);
@@ -3,8 +3,10 @@
 // found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/pickle.h"
 #include "base/strings/string16.h"
@@ -524,4 +526,103 @@ TEST(PickleTest, DeepCopyResize) {
   EXPECT_EQ(pickle.capacity_after_header(), pickle2.capacity_after_header());
 }
 
+TEST(PickleTest, PickleView) {
+  Pickle pickle(sizeof(Pickle::Header) + sizeof(uint32));
+  EXPECT_TRUE(pickle.WriteInt(testint));
+  EXPECT_TRUE(pickle.WriteString(teststring));
+
+  PickleView view(pickle.data(), pickle.size());
+  ASSERT_TRUE(view.IsValid());
+  EXPECT_EQ(sizeof(Pickle::Header) + sizeof(uint32), view.header_size());
+  EXPECT_EQ(pickle.payload(), view.payload());
+  EXPECT_EQ(pickle.payload_size(), view.payload_size());
+
+  PickleIterator iter(view);
+  int outint;
+  EXPECT_TRUE(iter.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+  std::string outstring;
+  EXPECT_TRUE(iter.ReadString(&outstring));
+  EXPECT_EQ(teststring, outstring);
+  EXPECT_FALSE(iter.ReadInt(&outint));
+
+  // The view is invalid if the data isn't a whole pickle.
+  EXPECT_FALSE(PickleView(pickle.data(), pickle.size() - 1).IsValid());
+  EXPECT_FALSE(PickleView(pickle.data(), pickle.payload_size()).IsValid());
+  EXPECT_FALSE(PickleView(pickle.data(), 2).IsValid());
+  EXPECT_FALSE(PickleView(NULL, 0).IsValid());
+  EXPECT_FALSE(PickleIterator(PickleView(NULL, 0)).ReadInt(&outint));
+}
+
+TEST(PickleTest, ExternalData) {
+  scoped_refptr<RefCountedString> blob1(new RefCountedString);
+  blob1->data().assign(1000, 'a');
+  scoped_refptr<RefCountedString> blob2(new RefCountedString);
+  blob2->data() = teststring;
+
+  Pickle pickle;
+  EXPECT_TRUE(pickle.WriteInt(testint));
+  EXPECT_TRUE(pickle.WriteDataExternal(blob1));
+  EXPECT_TRUE(pickle.WriteDataExternal(blob2));
+  EXPECT_TRUE(pickle.WriteString(teststring));
+  EXPECT_TRUE(pickle.has_external_data());
+  EXPECT_LT(pickle.GetTotalAllocatedSize(), blob1->size());
+
+  // The segments hold the whole pickle, with each blob padded to 32 bits.
+  std::vector<StringPiece> segments;
+  pickle.GetSegments(&segments);
+  std::string data;
+  for (const StringPiece& segment : segments)
+    segment.AppendToString(&data);
+  EXPECT_EQ(pickle.size(), data.size());
+  EXPECT_EQ(0u, data.size() % sizeof(uint32));
+  EXPECT_EQ(blob1->front(), reinterpret_cast<const unsigned char*>(
+                                segments[1].data()));
+
+  // Before it is flattened, the pickle can only be read up to the first blob.
+  PickleIterator iter(pickle);
+  int outint;
+  EXPECT_TRUE(iter.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+  const char* outdata;
+  int outdatalen;
+  EXPECT_FALSE(iter.ReadData(&outdata, &outdatalen));
+
+  // A copy refers to the same blobs.
+  Pickle copy(pickle);
+  EXPECT_TRUE(copy.has_external_data());
+  EXPECT_EQ(pickle.size(), copy.size());
+  Pickle assigned;
+  assigned = pickle;
+  EXPECT_EQ(pickle.size(), assigned.size());
+
+  pickle.Flatten();
+  EXPECT_FALSE(pickle.has_external_data());
+  EXPECT_EQ(data.size(), pickle.size());
+  EXPECT_EQ(data, std::string(static_cast<const char*>(pickle.data()),
+                              pickle.size()));
+
+  PickleIterator flat_iter(pickle);
+  EXPECT_TRUE(flat_iter.ReadInt(&outint));
+  EXPECT_EQ(testint, outint);
+  EXPECT_TRUE(flat_iter.ReadData(&outdata, &outdatalen));
+  EXPECT_EQ(blob1->data(), std::string(outdata, outdatalen));
+  std::string outstring;
+  EXPECT_TRUE(flat_iter.ReadString(&outstring));
+  EXPECT_EQ(teststring, outstring);
+  EXPECT_TRUE(flat_iter.ReadString(&outstring));
+  EXPECT_EQ(teststring, outstring);
+  EXPECT_FALSE(flat_iter.ReadInt(&outint));
+
+  // The copies flatten to the same data, and can be written to after.
+  copy.Flatten();
+  EXPECT_EQ(data, std::string(static_cast<const char*>(copy.data()),
+                              copy.size()));
+  EXPECT_TRUE(assigned.WriteInt(testint));
+  assigned.Flatten();
+  EXPECT_EQ(data.size() + sizeof(int), assigned.size());
+  EXPECT_EQ(0, memcmp(data.data() + sizeof(Pickle::Header), assigned.payload(),
+                      data.size() - sizeof(Pickle::Header)));
+}
+
 }  // namespace base
@@ -0,0 +1,259 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/prefs/json_pref_index.h"
+
+#include "base/json/json_reader.h"
+#include "base/json/string_scan.h"
+#include "base/logging.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace {
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Returns true for the bytes that ScanValue() looks at outside of strings.
+bool IsValueDelimiter(char c) {
+  switch (c) {
+    case '"':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ',':
+      return true;
+    default:
+      return IsWhitespace(c);
+  }
+}
+
+}  // namespace
+
+JsonPrefIndex::JsonPrefIndex()
+    : pos_(0),
+      state_(BEFORE_DICTIONARY),
+      token_begin_(0),
+      key_escaped_(false),
+      depth_(0),
+      in_string_(false),
+      string_escaped_(false) {
+}
+
+JsonPrefIndex::~JsonPrefIndex() {
+}
+
+bool JsonPrefIndex::Append(const char* data, size_t size) {
+  json_.append(data, size);
+  while (pos_ < json_.size() && state_ != INVALID)
+    state_ = Scan();
+  return state_ != INVALID;
+}
+
+bool JsonPrefIndex::IsComplete() const {
+  return state_ == AFTER_DICTIONARY;
+}
+
+std::vector<std::string> JsonPrefIndex::GetKeys() const {
+  std::vector<std::string> keys;
+  keys.reserve(values_.size());
+  for (const auto& it : values_)
+    keys.push_back(it.first);
+  return keys;
+}
+
+scoped_ptr<base::Value> JsonPrefIndex::Take(const std::string& key) {
+  std::map<std::string, Range>::iterator it = values_.find(key);
+  if (it == values_.end())
+    return scoped_ptr<base::Value>();
+
+  const Range range = it->second;
+  values_.erase(it);
+  scoped_ptr<base::Value> value = base::JSONReader::Read(
+      base::StringPiece(json_.data() + range.begin, range.end - range.begin));
+  DLOG_IF(WARNING, !value) << "Dropping pref " << key << " of invalid value";
+
+  if (values_.empty())
+    std::string().swap(json_);
+  return value.Pass();
+}
+
+JsonPrefIndex::State JsonPrefIndex::Scan() {
+  char c = json_[pos_];
+  switch (state_) {
+    case BEFORE_DICTIONARY:
+      ++pos_;
+      if (IsWhitespace(c))
+        return BEFORE_DICTIONARY;
+      return c == '{' ? BEFORE_FIRST_KEY : INVALID;
+
+    case BEFORE_FIRST_KEY:
+    case BEFORE_KEY:
+      ++pos_;
+      if (IsWhitespace(c))
+        return state_;
+      if (c == '"') {
+        token_begin_ = pos_ - 1;
+        key_escaped_ = false;
+        string_escaped_ = false;
+        return IN_KEY;
+      }
+      // A trailing comma is left to JSONReader.
+      return c == '}' && state_ == BEFORE_FIRST_KEY ? AFTER_DICTIONARY
+                                                    : INVALID;
+
+    case IN_KEY:
+      if (!string_escaped_) {
+        pos_ += base::internal::CountPlainJSONStringChars(
+            json_.data() + pos_, json_.size() - pos_);
+        if (pos_ == json_.size())
+          return IN_KEY;
+        c = json_[pos_];
+      }
+      ++pos_;
+      if (string_escaped_) {
+        string_escaped_ = false;
+      } else if (c == '\\') {
+        key_escaped_ = true;
+        string_escaped_ = true;
+      } else if (c == '"') {
+        return EndKey(pos_) ? BEFORE_COLON : INVALID;
+      }
+      return IN_KEY;
+
+    case BEFORE_COLON:
+      ++pos_;
+      if (IsWhitespace(c))
+        return BEFORE_COLON;
+      return c == ':' ? BEFORE_VALUE : INVALID;
+
+    case BEFORE_VALUE:
+      if (IsWhitespace(c)) {
+        ++pos_;
+        return BEFORE_VALUE;
+      }
+      if (c == ',' || c == ':' || c == '}' || c == ']')
+        return INVALID;
+      // |c| is scanned again as the start of the value.
+      token_begin_ = pos_;
+      depth_ = 0;
+      in_string_ = false;
+      string_escaped_ = false;
+      return IN_VALUE;
+
+    case IN_VALUE:
+      return ScanValue();
+
+    case AFTER_VALUE:
+      ++pos_;
+      if (IsWhitespace(c))
+        return AFTER_VALUE;
+      if (c == ',')
+        return BEFORE_KEY;
+      return c == '}' ? AFTER_DICTIONARY : INVALID;
+
+    case AFTER_DICTIONARY:
+      ++pos_;
+      return IsWhitespace(c) ? AFTER_DICTIONARY : INVALID;
+
+    case INVALID:
+      break;
+  }
+  NOTREACHED();
+  return INVALID;
+}
+
+JsonPrefIndex::State JsonPrefIndex::ScanValue() {
+  // Most of the file is in values, which are scanned here in one loop, rather
+  // than a byte at a time by Scan().
+  const char* const data = json_.data();
+  const size_t size = json_.size();
+  size_t pos = pos_;
+  State state = IN_VALUE;
+  while (pos < size && state == IN_VALUE) {
+    if (in_string_) {
+      if (string_escaped_) {
+        string_escaped_ = false;
+        ++pos;
+        continue;
+      }
+      pos += base::internal::CountPlainJSONStringChars(data + pos, size - pos);
+      if (pos == size)
+        break;
+      const char c = data[pos++];
+      if (c == '\\') {
+        string_escaped_ = true;
+      } else if (c == '"') {
+        in_string_ = false;
+        if (depth_ == 0) {
+          EndValue(pos);
+          state = AFTER_VALUE;
+        }
+      }
+      continue;
+    }
+
+    // Skip to the next byte that could start a string or end the value.
+    while (pos < size && !IsValueDelimiter(data[pos]))
+      ++pos;
+    if (pos == size)
+      break;
+
+    // Mismatched brackets are left for JSONReader to find in Take(), since
+    // counting the nesting is enough to find where the value ends.
+    const char c = data[pos];
+    switch (c) {
+      case '"':
+        in_string_ = true;
+        break;
+      case '{':
+      case '[':
+        ++depth_;
+        break;
+      case '}':
+      case ']':
+        if (depth_ == 0) {
+          // |c| ends a number or a literal, and is scanned again after it.
+          EndValue(pos);
+          state = AFTER_VALUE;
+          continue;
+        }
+        if (--depth_ == 0) {
+          EndValue(pos + 1);
+          state = AFTER_VALUE;
+        }
+        break;
+      default:
+        if (depth_ == 0 && (c == ',' || IsWhitespace(c))) {
+          EndValue(pos);
+          state = AFTER_VALUE;
+          continue;
+        }
+        break;
+    }
+    ++pos;
+  }
+  pos_ = pos;
+  return state;
+}
+
+bool JsonPrefIndex::EndKey(size_t end) {
+  // Skip the quotes, unless the key needs JSONReader to unescape it.
+  if (!key_escaped_) {
+    key_.assign(json_, token_begin_ + 1, end - token_begin_ - 2);
+    return true;
+  }
+  scoped_ptr<base::Value> key = base::JSONReader::Read(
+      base::StringPiece(json_.data() + token_begin_, end - token_begin_));
+  return key && key->GetAsString(&key_);
+}
+
+void JsonPrefIndex::EndValue(size_t end) {
+  // Like JSONReader, the last of several values of a key wins.
+  Range& range = values_[key_];
+  range.begin = token_begin_;
+  range.end = end;
+}
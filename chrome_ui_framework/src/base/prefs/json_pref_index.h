@@ -0,0 +1,119 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PREFS_JSON_PREF_INDEX_H_
+#define BASE_PREFS_JSON_PREF_INDEX_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/prefs/base_prefs_export.h"
+
+namespace base {
+class Value;
+}
+
+// JsonPrefIndex finds where the value of each top-level pref of a JSON pref
+// file is, without parsing the values, so that a JsonPrefStore only pays for
+// parsing the prefs that it uses. The file is indexed chunk by chunk as it is
+// read, and a value is parsed by Take() the first time its pref is used.
+//
+// Only the structure of the file is checked while it is indexed: an invalid
+// string or number in a value is found when the value is parsed, and the
+// pref is then dropped as if it wasn't in the file. Anything else that the
+// index doesn't expect, such as comments, makes the file incomplete, and is
+// left to JSONReader to parse or reject.
+class BASE_PREFS_EXPORT JsonPrefIndex {
+ public:
+  JsonPrefIndex();
+  ~JsonPrefIndex();
+
+  // Makes room for a file of |size| bytes.
+  void Reserve(size_t size) { json_.reserve(size); }
+
+  // Indexes the next |size| bytes of the file. Returns false once the file
+  // is known not to be complete; the bytes are kept in json() regardless.
+  bool Append(const char* data, size_t size);
+
+  // Returns true if the bytes appended so far are a whole JSON dictionary.
+  bool IsComplete() const;
+
+  // The bytes appended so far. Released once all of the prefs are taken.
+  const std::string& json() const { return json_; }
+
+  // Returns the number of prefs that haven't been taken.
+  size_t size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+
+  // Returns the keys of the prefs that haven't been taken.
+  std::vector<std::string> GetKeys() const;
+
+  // Removes the top-level pref |key| from the index, and returns its parsed
+  // value, or NULL if it isn't in the index or its value is invalid.
+  scoped_ptr<base::Value> Take(const std::string& key);
+
+ private:
+  enum State {
+    BEFORE_DICTIONARY,
+    BEFORE_FIRST_KEY,
+    BEFORE_KEY,
+    IN_KEY,
+    BEFORE_COLON,
+    BEFORE_VALUE,
+    IN_VALUE,
+    AFTER_VALUE,
+    AFTER_DICTIONARY,
+    INVALID,
+  };
+
+  // The bytes of a value in |json_|.
+  struct Range {
+    size_t begin;
+    size_t end;
+  };
+
+  // Scans the byte at |pos_|, and returns the state that the next byte is
+  // scanned in. Doesn't advance |pos_| if the byte also needs to be scanned
+  // in the new state.
+  State Scan();
+
+  // Scans the value at |pos_| up to its end, or to the end of |json_|.
+  State ScanValue();
+
+  // Ends the key or the value that started at |token_begin_| at |end|.
+  bool EndKey(size_t end);
+  void EndValue(size_t end);
+
+  std::string json_;
+
+  // The next byte to scan.
+  size_t pos_;
+  State state_;
+
+  // The start of the key or the value being scanned.
+  size_t token_begin_;
+
+  // The key being scanned has escape sequences.
+  bool key_escaped_;
+
+  // The containers that the value being scanned is nested in.
+  int depth_;
+
+  // The value being scanned is in a string, right after a backslash for
+  // |string_escaped_|.
+  bool in_string_;
+  bool string_escaped_;
+
+  // The key of the value being scanned.
+  std::string key_;
+
+  std::map<std::string, Range> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonPrefIndex);
+};
+
+#endif  // BASE_PREFS_JSON_PREF_INDEX_H_
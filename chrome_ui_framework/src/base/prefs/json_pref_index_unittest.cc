@@ -0,0 +1,108 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/prefs/json_pref_index.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const char kPrefs[] =
+    " {\"list\": [1, {\"a\": \"]\"}], \"string\" : \"a\\\\\\\"b{\",\n"
+    "\"int\":-12,\"double\":1.5e3 , \"bool\":false,\"null\":null,"
+    "\"es\\u0063aped\":\"\\u00e9\\\"\", \"dict\":{\"b\":{\"c\":[]}},"
+    "\"int\":7}\n";
+
+// Returns true if the value of |key| in |index| is the value of |key| in
+// |prefs|, as parsed by JSONReader.
+bool TakeEquals(JsonPrefIndex* index,
+                const base::DictionaryValue& prefs,
+                const std::string& key) {
+  const base::Value* expected;
+  scoped_ptr<base::Value> value = index->Take(key);
+  return prefs.GetWithoutPathExpansion(key, &expected) && value &&
+         value->Equals(expected);
+}
+
+}  // namespace
+
+TEST(JsonPrefIndexTest, IndexesTopLevelPrefs) {
+  scoped_ptr<base::DictionaryValue> prefs =
+      base::DictionaryValue::From(base::JSONReader::Read(kPrefs));
+  ASSERT_TRUE(prefs);
+
+  // Any split of the file between chunks gives the same index.
+  const size_t length = arraysize(kPrefs) - 1;
+  for (size_t split = 0; split <= length; ++split) {
+    JsonPrefIndex index;
+    EXPECT_TRUE(index.Append(kPrefs, split));
+    EXPECT_TRUE(index.Append(kPrefs + split, length - split));
+    ASSERT_TRUE(index.IsComplete()) << split;
+    EXPECT_EQ(prefs->size(), index.size());
+
+    std::vector<std::string> keys = index.GetKeys();
+    for (const std::string& key : keys)
+      EXPECT_TRUE(TakeEquals(&index, *prefs, key)) << key << " " << split;
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.json().empty());
+  }
+}
+
+TEST(JsonPrefIndexTest, Take) {
+  JsonPrefIndex index;
+  const char kDuplicate[] = "{\"a\":[1,2},\"b\":3,\"b\":4}";
+  EXPECT_TRUE(index.Append(kDuplicate, arraysize(kDuplicate) - 1));
+  ASSERT_TRUE(index.IsComplete());
+  EXPECT_EQ(2u, index.size());
+
+  // The last value of a key wins, and a value is only taken once.
+  scoped_ptr<base::Value> value = index.Take("b");
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(base::FundamentalValue(4).Equals(value.get()));
+  EXPECT_FALSE(index.Take("b"));
+  EXPECT_FALSE(index.Take("c"));
+
+  // A value whose brackets don't match is only found to be invalid when it
+  // is taken.
+  EXPECT_FALSE(index.Take("a"));
+  EXPECT_TRUE(index.empty());
+}
+
+TEST(JsonPrefIndexTest, EmptyDictionary) {
+  JsonPrefIndex index;
+  EXPECT_FALSE(index.IsComplete());
+  EXPECT_TRUE(index.Append("{ }", 3));
+  EXPECT_TRUE(index.IsComplete());
+  EXPECT_TRUE(index.empty());
+}
+
+TEST(JsonPrefIndexTest, Incomplete) {
+  const char* const kIncomplete[] = {
+      "",
+      "[1]",
+      "{\"a\":1",
+      "{\"a\":1}}",
+      "{\"a\":1,}",
+      "{\"a\" 1}",
+      "{\"a\":}",
+      "{\"a\":1 2}",
+      "{a:1}",
+      "{\"a\":1 /* Comment. */}",
+      "\xEF\xBB\xBF{}",
+  };
+  for (const char* json : kIncomplete) {
+    JsonPrefIndex index;
+    index.Append(json, strlen(json));
+    EXPECT_FALSE(index.IsComplete()) << json;
+    EXPECT_EQ(json, index.json());
+  }
+}
@@ -8,12 +8,15 @@
 
 #include "base/bind.h"
 #include "base/callback.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_reader.h"
 #include "base/json/json_string_value_serializer.h"
 #include "base/memory/ref_counted.h"
 #include "base/metrics/histogram.h"
+#include "base/prefs/json_pref_index.h"
 #include "base/prefs/pref_filter.h"
 #include "base/sequenced_task_runner.h"
 #include "base/strings/string_number_conversions.h"
@@ -30,6 +33,8 @@ struct JsonPrefStore::ReadResult {
   ~ReadResult();
 
   scoped_ptr<base::Value> value;
+  // The prefs of the file, if it was lazily loaded. |value| is then empty.
+  scoped_ptr<JsonPrefIndex> lazy_prefs;
   PrefReadError error;
   bool no_dir;
 
@@ -105,26 +110,142 @@ void RecordJsonDataSizeHistogram(const base::FilePath& path, size_t size) {
   histogram->Add(static_cast<int>(size) / 1024);
 }
 
+// Merges the records of the journal of a pref file into the prefs serialized
+// in |data|, for ImportantFileWriter::CompactJournal(). Each record is a list
+// of the prefs that changed, as [key, value] for a pref that was set and [key]
+// for one that was removed. Merging stops at the first invalid record, which
+// can only be the last one, cut short by a crash.
+bool MergeJournal(const std::string& data,
+                  const std::string& journal,
+                  std::string* merged_data) {
+  scoped_ptr<base::DictionaryValue> prefs(new base::DictionaryValue);
+  if (!data.empty()) {
+    JSONStringValueDeserializer deserializer(data);
+    scoped_ptr<base::Value> value = deserializer.Deserialize(nullptr, nullptr);
+    if (!value || !value->IsType(base::Value::TYPE_DICTIONARY))
+      return false;
+    prefs.reset(static_cast<base::DictionaryValue*>(value.release()));
+  }
+
+  size_t start = 0;
+  size_t end;
+  while ((end = journal.find('\n', start)) != std::string::npos) {
+    scoped_ptr<base::Value> record = base::JSONReader::Read(
+        base::StringPiece(journal.data() + start, end - start));
+    const base::ListValue* changes;
+    if (!record || !record->GetAsList(&changes))
+      break;
+    for (const base::Value* change_value : *changes) {
+      const base::ListValue* change;
+      std::string key;
+      if (!change_value->GetAsList(&change) || !change->GetString(0, &key))
+        continue;
+      const base::Value* value;
+      if (change->Get(1, &value))
+        prefs->Set(key, value->CreateDeepCopy());
+      else
+        prefs->RemovePath(key, nullptr);
+    }
+    start = end + 1;
+  }
+
+  JSONStringValueSerializer serializer(merged_data);
+  serializer.set_pretty_print(false);
+  return serializer.Serialize(*prefs);
+}
+
+// Reads the file at |path| into a JsonPrefIndex, indexing each chunk of the
+// file as soon as it is read. Returns NULL and sets |error_code| to one of the
+// errors of JSONFileValueDeserializer if the file can't be read.
+scoped_ptr<JsonPrefIndex> ReadPrefIndex(const base::FilePath& path,
+                                        int* error_code) {
+  const int kChunkSize = 64 << 10;
+
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid()) {
+    switch (file.error_details()) {
+      case base::File::FILE_ERROR_NOT_FOUND:
+        *error_code = JSONFileValueDeserializer::JSON_NO_SUCH_FILE;
+        break;
+      case base::File::FILE_ERROR_ACCESS_DENIED:
+        *error_code = JSONFileValueDeserializer::JSON_ACCESS_DENIED;
+        break;
+      case base::File::FILE_ERROR_IN_USE:
+        *error_code = JSONFileValueDeserializer::JSON_FILE_LOCKED;
+        break;
+      default:
+        *error_code = JSONFileValueDeserializer::JSON_CANNOT_READ_FILE;
+        break;
+    }
+    return scoped_ptr<JsonPrefIndex>();
+  }
+
+  scoped_ptr<JsonPrefIndex> index(new JsonPrefIndex);
+  const int64 length = file.GetLength();
+  if (length > 0)
+    index->Reserve(static_cast<size_t>(length));
+  scoped_ptr<char[]> chunk(new char[kChunkSize]);
+  int bytes_read;
+  while ((bytes_read = file.ReadAtCurrentPos(chunk.get(), kChunkSize)) > 0)
+    index->Append(chunk.get(), bytes_read);
+  if (bytes_read < 0) {
+    *error_code = JSONFileValueDeserializer::JSON_CANNOT_READ_FILE;
+    return scoped_ptr<JsonPrefIndex>();
+  }
+  return index.Pass();
+}
+
 scoped_ptr<JsonPrefStore::ReadResult> ReadPrefsFromDisk(
     const base::FilePath& path,
-    const base::FilePath& alternate_path) {
+    const base::FilePath& alternate_path,
+    bool lazy_load) {
   if (!base::PathExists(path) && !alternate_path.empty() &&
       base::PathExists(alternate_path)) {
     base::Move(alternate_path, path);
   }
 
-  int error_code;
+  // Merge the journal left by a journal mode store into the file, before
+  // anything is appended to it.
+  base::ImportantFileWriter::CompactJournal(path, base::Bind(&MergeJournal));
+
+  int error_code = JSONFileValueDeserializer::JSON_NO_ERROR;
   std::string error_msg;
+  size_t read_size = 0;
   scoped_ptr<JsonPrefStore::ReadResult> read_result(
       new JsonPrefStore::ReadResult);
-  JSONFileValueDeserializer deserializer(path);
-  read_result->value = deserializer.Deserialize(&error_code, &error_msg);
+  if (lazy_load) {
+    scoped_ptr<JsonPrefIndex> index = ReadPrefIndex(path, &error_code);
+    if (!index) {
+      error_msg = JSONFileValueDeserializer::GetErrorMessageForCode(error_code);
+    } else if (index->IsComplete()) {
+      read_size = index->json().size();
+      read_result->value.reset(new base::DictionaryValue);
+      read_result->lazy_prefs = index.Pass();
+    } else {
+      // The file has something that the index doesn't expect, which could
+      // still be valid JSON, such as comments.
+      read_size = index->json().size();
+      JSONStringValueDeserializer deserializer(index->json());
+      read_result->value = deserializer.Deserialize(&error_code, &error_msg);
+    }
+  } else {
+    JSONFileValueDeserializer deserializer(path);
+    read_result->value = deserializer.Deserialize(&error_code, &error_msg);
+    read_size = deserializer.get_last_read_size();
+  }
   read_result->error =
       HandleReadErrors(read_result->value.get(), path, error_code, error_msg);
   read_result->no_dir = !base::PathExists(path.DirName());
 
+  // The journal of a corrupt file has been left out of the file, and only
+  // holds some of the prefs.
+  if (read_result->error == PersistentPrefStore::PREF_READ_ERROR_JSON_PARSE ||
+      read_result->error == PersistentPrefStore::PREF_READ_ERROR_JSON_REPEAT) {
+    base::DeleteFile(base::ImportantFileWriter::GetJournalPath(path), false);
+  }
+
   if (read_result->error == PersistentPrefStore::PREF_READ_ERROR_NONE)
-    RecordJsonDataSizeHistogram(path, deserializer.get_last_read_size());
+    RecordJsonDataSizeHistogram(path, read_size);
 
   return read_result.Pass();
 }
@@ -161,6 +282,7 @@ JsonPrefStore::JsonPrefStore(
       alternate_path_(pref_alternate_filename),
       sequenced_task_runner_(sequenced_task_runner),
       prefs_(new base::DictionaryValue()),
+      lazy_load_(false),
       read_only_(false),
       writer_(pref_filename, sequenced_task_runner),
       pref_filter_(pref_filter.Pass()),
@@ -168,6 +290,7 @@ JsonPrefStore::JsonPrefStore(
       filtering_in_progress_(false),
       pending_lossy_write_(false),
       read_error_(PREF_READ_ERROR_NONE),
+      has_unjournaled_changes_(false),
       write_count_histogram_(writer_.commit_interval(), path_) {
   DCHECK(!path_.empty());
 }
@@ -176,6 +299,7 @@ bool JsonPrefStore::GetValue(const std::string& key,
                              const base::Value** result) const {
   DCHECK(CalledOnValidThread());
 
+  LoadLazyPref(key);
   base::Value* tmp = nullptr;
   if (!prefs_->Get(key, &tmp))
     return false;
@@ -213,6 +337,7 @@ bool JsonPrefStore::GetMutableValue(const std::string& key,
                                     base::Value** result) {
   DCHECK(CalledOnValidThread());
 
+  LoadLazyPref(key);
   return prefs_->Get(key, result);
 }
 
@@ -222,6 +347,7 @@ void JsonPrefStore::SetValue(const std::string& key,
   DCHECK(CalledOnValidThread());
 
   DCHECK(value);
+  LoadLazyPref(key);
   base::Value* old_value = nullptr;
   prefs_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
@@ -236,10 +362,12 @@ void JsonPrefStore::SetValueSilently(const std::string& key,
   DCHECK(CalledOnValidThread());
 
   DCHECK(value);
+  LoadLazyPref(key);
   base::Value* old_value = nullptr;
   prefs_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
     prefs_->Set(key, value.Pass());
+    RecordChangedKey(key);
     ScheduleWrite(flags);
   }
 }
@@ -247,6 +375,7 @@ void JsonPrefStore::SetValueSilently(const std::string& key,
 void JsonPrefStore::RemoveValue(const std::string& key, uint32 flags) {
   DCHECK(CalledOnValidThread());
 
+  LoadLazyPref(key);
   if (prefs_->RemovePath(key, nullptr))
     ReportValueChanged(key, flags);
 }
@@ -254,7 +383,9 @@ void JsonPrefStore::RemoveValue(const std::string& key, uint32 flags) {
 void JsonPrefStore::RemoveValueSilently(const std::string& key, uint32 flags) {
   DCHECK(CalledOnValidThread());
 
+  LoadLazyPref(key);
   prefs_->RemovePath(key, nullptr);
+  RecordChangedKey(key);
   ScheduleWrite(flags);
 }
 
@@ -273,7 +404,8 @@ PersistentPrefStore::PrefReadError JsonPrefStore::GetReadError() const {
 PersistentPrefStore::PrefReadError JsonPrefStore::ReadPrefs() {
   DCHECK(CalledOnValidThread());
 
-  OnFileRead(ReadPrefsFromDisk(path_, alternate_path_));
+  OnFileRead(ReadPrefsFromDisk(path_, alternate_path_,
+                               lazy_load_ && !pref_filter_));
   return filtering_in_progress_ ? PREF_READ_ERROR_ASYNCHRONOUS_TASK_INCOMPLETE
                                 : read_error_;
 }
@@ -288,7 +420,8 @@ void JsonPrefStore::ReadPrefsAsync(ReadErrorDelegate* error_delegate) {
   base::PostTaskAndReplyWithResult(
       sequenced_task_runner_.get(),
       FROM_HERE,
-      base::Bind(&ReadPrefsFromDisk, path_, alternate_path_),
+      base::Bind(&ReadPrefsFromDisk, path_, alternate_path_,
+                 lazy_load_ && !pref_filter_),
       base::Bind(&JsonPrefStore::OnFileRead, AsWeakPtr()));
 }
 
@@ -316,6 +449,7 @@ void JsonPrefStore::ReportValueChanged(const std::string& key, uint32 flags) {
 
   FOR_EACH_OBSERVER(PrefStore::Observer, observers_, OnPrefValueChanged(key));
 
+  RecordChangedKey(key);
   ScheduleWrite(flags);
 }
 
@@ -326,6 +460,20 @@ void JsonPrefStore::RegisterOnNextSuccessfulWriteCallback(
   writer_.RegisterOnNextSuccessfulWriteCallback(on_next_successful_write);
 }
 
+void JsonPrefStore::EnableJournal(size_t max_journal_size) {
+  DCHECK(CalledOnValidThread());
+
+  // The changes that are waiting to be written were not recorded.
+  has_unjournaled_changes_ = writer_.HasPendingWrite() || pending_lossy_write_;
+  writer_.EnableJournal(base::Bind(&MergeJournal), max_journal_size);
+}
+
+void JsonPrefStore::EnableLazyLoad() {
+  DCHECK(CalledOnValidThread());
+
+  lazy_load_ = true;
+}
+
 void JsonPrefStore::OnFileRead(scoped_ptr<ReadResult> read_result) {
   DCHECK(CalledOnValidThread());
 
@@ -334,6 +482,7 @@ void JsonPrefStore::OnFileRead(scoped_ptr<ReadResult> read_result) {
   scoped_ptr<base::DictionaryValue> unfiltered_prefs(new base::DictionaryValue);
 
   read_error_ = read_result->error;
+  lazy_prefs_ = read_result->lazy_prefs.Pass();
 
   bool initialization_successful = !read_result->no_dir;
 
@@ -391,9 +540,12 @@ bool JsonPrefStore::SerializeData(std::string* output) {
   DCHECK(CalledOnValidThread());
 
   pending_lossy_write_ = false;
+  changed_keys_.clear();
+  has_unjournaled_changes_ = false;
 
   write_count_histogram_.RecordWriteOccured();
 
+  LoadAllLazyPrefs();
   if (pref_filter_)
     pref_filter_->FilterSerializeData(prefs_.get());
 
@@ -405,6 +557,34 @@ bool JsonPrefStore::SerializeData(std::string* output) {
   return serializer.Serialize(*prefs_);
 }
 
+bool JsonPrefStore::SerializeDelta(std::string* output) {
+  DCHECK(CalledOnValidThread());
+
+  if (pref_filter_ || has_unjournaled_changes_)
+    return false;
+
+  pending_lossy_write_ = false;
+
+  write_count_histogram_.RecordWriteOccured();
+
+  // See MergeJournal() for the format of the record.
+  base::ListValue changes;
+  for (const std::string& key : changed_keys_) {
+    scoped_ptr<base::ListValue> change(new base::ListValue);
+    change->AppendString(key);
+    LoadLazyPref(key);
+    const base::Value* value;
+    if (prefs_->Get(key, &value))
+      change->Append(value->CreateDeepCopy());
+    changes.Append(change.Pass());
+  }
+  changed_keys_.clear();
+
+  JSONStringValueSerializer serializer(output);
+  serializer.set_pretty_print(false);
+  return serializer.Serialize(changes);
+}
+
 void JsonPrefStore::FinalizeFileRead(bool initialization_successful,
                                      scoped_ptr<base::DictionaryValue> prefs,
                                      bool schedule_write) {
@@ -436,6 +616,37 @@ void JsonPrefStore::FinalizeFileRead(bool initialization_successful,
   return;
 }
 
+void JsonPrefStore::RecordChangedKey(const std::string& key) {
+  if (writer_.journal_enabled())
+    changed_keys_.insert(key);
+}
+
+void JsonPrefStore::LoadLazyPref(const std::string& key) const {
+  if (!lazy_prefs_)
+    return;
+
+  // Only whole top-level prefs are parsed, since a path may go through any of
+  // the dictionaries of one.
+  const std::string top_level_key = key.substr(0, key.find('.'));
+  scoped_ptr<base::Value> value = lazy_prefs_->Take(top_level_key);
+  if (value)
+    prefs_->SetWithoutPathExpansion(top_level_key, value.Pass());
+  if (lazy_prefs_->empty())
+    lazy_prefs_.reset();
+}
+
+void JsonPrefStore::LoadAllLazyPrefs() {
+  if (!lazy_prefs_)
+    return;
+
+  for (const std::string& key : lazy_prefs_->GetKeys()) {
+    scoped_ptr<base::Value> value = lazy_prefs_->Take(key);
+    if (value)
+      prefs_->SetWithoutPathExpansion(key, value.Pass());
+  }
+  lazy_prefs_.reset();
+}
+
 void JsonPrefStore::ScheduleWrite(uint32 flags) {
   if (read_only_)
     return;
@@ -21,6 +21,7 @@
 #include "base/prefs/persistent_pref_store.h"
 #include "base/threading/non_thread_safe.h"
 
+class JsonPrefIndex;
 class PrefFilter;
 
 namespace base {
@@ -109,6 +110,23 @@ class BASE_PREFS_EXPORT JsonPrefStore
   void RegisterOnNextSuccessfulWriteCallback(
       const base::Closure& on_next_successful_write);
 
+  // Makes writes append the prefs that changed since the last write to the
+  // journal of the pref file, rather than rewrite all of the prefs. The journal
+  // is merged into the pref file in the background once it has grown by more
+  // than |max_journal_size| bytes, and when the prefs are read. A store with a
+  // PrefFilter still writes all of the prefs, since the filter may change any
+  // of them when they are serialized. If prefs changed before this is called,
+  // the next write writes all of the prefs.
+  void EnableJournal(size_t max_journal_size);
+
+  // Makes the prefs be read without parsing their values, which are parsed
+  // the first time their top-level pref is used instead, so that the prefs
+  // that are never used don't add to the time it takes to read the file. The
+  // file is indexed as it is read, chunk by chunk. Must be called before the
+  // prefs are read. A store with a PrefFilter still parses all of the prefs,
+  // since the filter needs them when they are loaded.
+  void EnableLazyLoad();
+
  private:
   // Represents a histogram for recording the number of writes to the pref file
   // that occur every kHistogramWriteReportIntervalInMins minutes.
@@ -180,6 +198,7 @@ class BASE_PREFS_EXPORT JsonPrefStore
 
   // ImportantFileWriter::DataSerializer overrides:
   bool SerializeData(std::string* output) override;
+  bool SerializeDelta(std::string* output) override;
 
   // This method is called after the JSON file has been read and the result has
   // potentially been intercepted and modified by |pref_filter_|.
@@ -196,12 +215,28 @@ class BASE_PREFS_EXPORT JsonPrefStore
   // WriteablePrefStore::LOSSY_PREF_WRITE_FLAG.
   void ScheduleWrite(uint32 flags);
 
+  // Records that |key| changed, for the next write to the journal.
+  void RecordChangedKey(const std::string& key);
+
+  // Parses the value of the top-level pref of |key| into |prefs_|, if it was
+  // lazily loaded and hasn't been parsed yet.
+  void LoadLazyPref(const std::string& key) const;
+
+  // Parses the values of all of the lazily loaded prefs into |prefs_|.
+  void LoadAllLazyPrefs();
+
   const base::FilePath path_;
   const base::FilePath alternate_path_;
   const scoped_refptr<base::SequencedTaskRunner> sequenced_task_runner_;
 
   scoped_ptr<base::DictionaryValue> prefs_;
 
+  // The prefs of the file that haven't been parsed yet, in lazy load mode.
+  // Parsing them doesn't change the prefs that the store holds, so they are
+  // parsed by const methods too.
+  mutable scoped_ptr<JsonPrefIndex> lazy_prefs_;
+  bool lazy_load_;
+
   bool read_only_;
 
   // Helper for safely writing pref data.
@@ -219,6 +254,14 @@ class BASE_PREFS_EXPORT JsonPrefStore
 
   std::set<std::string> keys_need_empty_value_;
 
+  // The prefs that changed since the last write, in journal mode.
+  std::set<std::string> changed_keys_;
+
+  // True if prefs changed before the journal was enabled and have not been
+  // written yet. They are not in |changed_keys_|, so the next write has to
+  // write all of the prefs.
+  bool has_unjournaled_changes_;
+
   WriteCountHistogram write_count_histogram_;
 
   DISALLOW_COPY_AND_ASSIGN(JsonPrefStore);
@@ -0,0 +1,228 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/prefs/json_pref_store.h"
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/prefs/pref_filter.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+// About 100 kB of prefs once serialized.
+const int kPrefCount = 2000;
+const int kChangeCount = 1000;
+const size_t kMaxJournalSize = 16 << 10;
+
+// About 7 MB of prefs, in top-level prefs of kLargePrefEntries entries each,
+// of which kStartupPrefCount are used at startup.
+const int kLargePrefCount = 200;
+const int kLargePrefEntries = 500;
+const int kStartupPrefCount = 10;
+
+std::string GetPrefName(int i) {
+  return StringPrintf("profile.content_settings.site%d", i);
+}
+
+int64 GetSize(const FilePath& path) {
+  int64 size = 0;
+  if (!GetFileSize(path, &size))
+    return 0;
+  return size;
+}
+
+}  // namespace
+
+class JsonPrefStorePerfTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    pref_file_ = temp_dir_.path().AppendASCII("Preferences");
+    journal_ = ImportantFileWriter::GetJournalPath(pref_file_);
+
+    scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+    pref_store->ReadPrefs();
+    for (int i = 0; i < kPrefCount; ++i) {
+      pref_store->SetValue(
+          GetPrefName(i),
+          make_scoped_ptr(new StringValue(StringPrintf("value %d", i))),
+          WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+    }
+    pref_store->CommitPendingWrite();
+    RunLoop().RunUntilIdle();
+  }
+
+  scoped_refptr<JsonPrefStore> CreatePrefStore() {
+    return new JsonPrefStore(pref_file_, message_loop_.task_runner(),
+                             scoped_ptr<PrefFilter>());
+  }
+
+  // Changes one pref at a time and commits it, with the pref file written in
+  // whole or through its journal, and reports the time spent serializing the
+  // prefs and the bytes written to disk for each change.
+  void CommitChanges(bool journal) {
+    scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+    if (journal)
+      pref_store->EnableJournal(kMaxJournalSize);
+    ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+              pref_store->ReadPrefs());
+
+    const std::string mode = journal ? "journal" : "snapshot";
+    TimeDelta commit_time;
+    int64 bytes_written = 0;
+    int64 journal_size = 0;
+    for (int i = 0; i < kChangeCount; ++i) {
+      pref_store->SetValue(GetPrefName((i * 7919) % kPrefCount),
+                           make_scoped_ptr(new StringValue(StringPrintf(
+                               "%s value %d", mode.c_str(), i))),
+                           WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+      const TimeTicks start = TimeTicks::Now();
+      pref_store->CommitPendingWrite();
+      commit_time += TimeTicks::Now() - start;
+      RunLoop().RunUntilIdle();
+
+      // A journal that shrank was merged, which rewrote the pref file.
+      const int64 new_journal_size = GetSize(journal_);
+      if (!journal)
+        bytes_written += GetSize(pref_file_);
+      else if (new_journal_size < journal_size)
+        bytes_written += GetSize(pref_file_) + new_journal_size;
+      else
+        bytes_written += new_journal_size - journal_size;
+      journal_size = new_journal_size;
+    }
+
+    perf_test::PrintResult("json_pref_store_commit", "", mode,
+                           commit_time.InMillisecondsF() * 1000 / kChangeCount,
+                           "us/change", true);
+    perf_test::PrintResult("json_pref_store_bytes_written", "", mode,
+                           static_cast<double>(bytes_written) / kChangeCount,
+                           "bytes/change", true);
+  }
+
+  // Reports the time taken to read the prefs, which includes merging the
+  // journal if there is one.
+  void ReadPrefs(const std::string& trace) {
+    const TimeTicks start = TimeTicks::Now();
+    scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+    EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+              pref_store->ReadPrefs());
+    perf_test::PrintResult("json_pref_store_read", "", trace,
+                           (TimeTicks::Now() - start).InMillisecondsF(), "ms",
+                           true);
+  }
+
+  // Writes a large pref file to |path|, as the Preferences file of a profile
+  // with many extensions and site settings.
+  void WriteLargePrefFile(const FilePath& path) {
+    std::string json = "{";
+    for (int i = 0; i < kLargePrefCount; ++i) {
+      StringAppendF(&json, "%s\"pref%d\":{", i ? "," : "", i);
+      for (int j = 0; j < kLargePrefEntries; ++j) {
+        StringAppendF(&json,
+                      "%s\"entry%d\":{\"enabled\":%s,\"count\":%d,"
+                      "\"name\":\"Entry %d of pref %d\"}",
+                      j ? "," : "", j, j % 2 ? "true" : "false", i * j, j, i);
+      }
+      json += "}";
+    }
+    json += "}";
+    ASSERT_EQ(static_cast<int>(json.size()),
+              WriteFile(path, json.data(), static_cast<int>(json.size())));
+  }
+
+  // Reports the time it takes to read the prefs of |path| and get the prefs
+  // used at startup, and then to get all of the other prefs. Returns the
+  // store.
+  scoped_refptr<JsonPrefStore> ReadLargePrefs(const FilePath& path,
+                                              bool lazy_load) {
+    const std::string mode = lazy_load ? "lazy" : "eager";
+    const TimeTicks start = TimeTicks::Now();
+    scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+        path, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+    if (lazy_load)
+      pref_store->EnableLazyLoad();
+    EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+              pref_store->ReadPrefs());
+    for (int i = 0; i < kStartupPrefCount; ++i) {
+      EXPECT_TRUE(pref_store->GetValue(
+          StringPrintf("pref%d.entry%d", i * 13, i), NULL));
+    }
+    const TimeTicks startup_end = TimeTicks::Now();
+    for (int i = 0; i < kLargePrefCount; ++i)
+      EXPECT_TRUE(pref_store->GetValue(StringPrintf("pref%d", i), NULL));
+    const TimeTicks end = TimeTicks::Now();
+
+    perf_test::PrintResult("json_pref_store_startup", "", mode,
+                           (startup_end - start).InMillisecondsF(), "ms",
+                           true);
+    perf_test::PrintResult("json_pref_store_all_prefs", "", mode,
+                           (end - start).InMillisecondsF(), "ms", true);
+    return pref_store;
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath pref_file_;
+  FilePath journal_;
+  MessageLoop message_loop_;
+};
+
+TEST_F(JsonPrefStorePerfTest, Commit) {
+  CommitChanges(false);
+  CommitChanges(true);
+}
+
+TEST_F(JsonPrefStorePerfTest, Recovery) {
+  ReadPrefs("snapshot");
+
+  // Leave a journal of one record per change, as after a crash.
+  scoped_refptr<JsonPrefStore> pref_store = CreatePrefStore();
+  pref_store->EnableJournal(static_cast<size_t>(-1));
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  for (int i = 0; i < kChangeCount; ++i) {
+    pref_store->SetValue(
+        GetPrefName(i % kPrefCount),
+        make_scoped_ptr(new StringValue(StringPrintf("new value %d", i))),
+        WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+    pref_store->CommitPendingWrite();
+  }
+  pref_store = NULL;
+  RunLoop().RunUntilIdle();
+  ASSERT_TRUE(PathExists(journal_));
+
+  ReadPrefs(StringPrintf("snapshot_and_%d_records", kChangeCount));
+}
+
+TEST_F(JsonPrefStorePerfTest, StartupLatency) {
+  const FilePath path = temp_dir_.path().AppendASCII("Large Preferences");
+  WriteLargePrefFile(path);
+  perf_test::PrintResult("json_pref_store_file_size", "", "",
+                         static_cast<double>(GetSize(path)), "bytes", true);
+
+  // Both modes read the file from the disk cache.
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(path, &contents));
+  // The stores are kept until the end, since freeing the prefs of one would
+  // slow down the allocations of the next.
+  scoped_refptr<JsonPrefStore> eager_pref_store = ReadLargePrefs(path, false);
+  scoped_refptr<JsonPrefStore> lazy_pref_store = ReadLargePrefs(path, true);
+}
+
+}  // namespace base
@@ -666,6 +666,264 @@ TEST_F(JsonPrefStoreTest, BasicAsyncWithAlternateFile) {
       pref_store.get(), input_file, data_dir_.AppendASCII("write.golden.json"));
 }
 
+// Tests that a store in journal mode appends the prefs that changed to the
+// journal, and that the journal is merged into the pref file when it is read.
+TEST_F(JsonPrefStoreTest, Journal) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("journal.json");
+  FilePath journal = ImportantFileWriter::GetJournalPath(pref_file);
+  ASSERT_TRUE(WriteFile(pref_file, "{\"a\":1,\"b\":{\"c\":2}}", 19));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableJournal(1 << 20);
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+
+  pref_store->SetValue("a", make_scoped_ptr(new FundamentalValue(3)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->SetValue("d.e", make_scoped_ptr(new StringValue("f")),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->RemoveValue("b.c", WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ("{\"a\":1,\"b\":{\"c\":2}}", contents);
+  ASSERT_TRUE(ReadFileToString(journal, &contents));
+  EXPECT_EQ("[[\"a\",3],[\"b.c\"],[\"d.e\",\"f\"]]\n", contents);
+
+  pref_store->SetValue("a", make_scoped_ptr(new FundamentalValue(4)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  pref_store = NULL;
+  RunLoop().RunUntilIdle();
+
+  // Reading the prefs merges the journal.
+  pref_store = new JsonPrefStore(pref_file, message_loop_.task_runner(),
+                                 scoped_ptr<PrefFilter>());
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  EXPECT_FALSE(PathExists(journal));
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ("{\"a\":4,\"d\":{\"e\":\"f\"}}", contents);
+  const Value* value;
+  EXPECT_TRUE(pref_store->GetValue("a", &value));
+  EXPECT_TRUE(FundamentalValue(4).Equals(value));
+  EXPECT_FALSE(pref_store->GetValue("b", &value));
+}
+
+// Tests that the prefs that changed before the journal was enabled are written
+// with all of the prefs, and that later changes go to the journal.
+TEST_F(JsonPrefStoreTest, JournalEnabledAfterChanges) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("journal.json");
+  FilePath journal = ImportantFileWriter::GetJournalPath(pref_file);
+  ASSERT_TRUE(WriteFile(pref_file, "{\"a\":1}", 7));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+
+  pref_store->SetValue("a", make_scoped_ptr(new FundamentalValue(2)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->EnableJournal(1 << 20);
+  pref_store->SetValue("b", make_scoped_ptr(new FundamentalValue(3)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ("{\"a\":2,\"b\":3}", contents);
+  EXPECT_FALSE(PathExists(journal));
+
+  pref_store->SetValue("a", make_scoped_ptr(new FundamentalValue(4)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ("{\"a\":2,\"b\":3}", contents);
+  ASSERT_TRUE(ReadFileToString(journal, &contents));
+  EXPECT_EQ("[[\"a\",4]]\n", contents);
+}
+
+// Tests that the journal is merged into the pref file in the background once
+// it is large enough.
+TEST_F(JsonPrefStoreTest, JournalCompaction) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("journal.json");
+  FilePath journal = ImportantFileWriter::GetJournalPath(pref_file);
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableJournal(30);
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NO_FILE,
+            pref_store->ReadPrefs());
+
+  pref_store->SetValue("a", make_scoped_ptr(new StringValue("0123456789")),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_FALSE(PathExists(pref_file));
+  EXPECT_TRUE(PathExists(journal));
+
+  pref_store->SetValue("b", make_scoped_ptr(new StringValue("0123456789")),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+  EXPECT_FALSE(PathExists(journal));
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ("{\"a\":\"0123456789\",\"b\":\"0123456789\"}", contents);
+}
+
+// Tests that the records of the journal after an incomplete one, left by a
+// crash, are ignored.
+TEST_F(JsonPrefStoreTest, JournalWithIncompleteRecord) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("journal.json");
+  FilePath journal = ImportantFileWriter::GetJournalPath(pref_file);
+  const char kJournal[] = "[[\"a\",2]]\n[[\"a\",3";
+  ASSERT_TRUE(WriteFile(journal, kJournal, arraysize(kJournal) - 1));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  const Value* value;
+  EXPECT_TRUE(pref_store->GetValue("a", &value));
+  EXPECT_TRUE(FundamentalValue(2).Equals(value));
+  EXPECT_FALSE(PathExists(journal));
+}
+
+// Tests that the journal of a corrupt pref file is deleted.
+TEST_F(JsonPrefStoreTest, JournalWithInvalidFile) {
+  FilePath invalid_file = temp_dir_.path().AppendASCII("invalid.json");
+  FilePath journal = ImportantFileWriter::GetJournalPath(invalid_file);
+  ASSERT_TRUE(CopyFile(data_dir_.AppendASCII("invalid.json"), invalid_file));
+  const char kJournal[] = "[[\"a\",2]]\n";
+  ASSERT_TRUE(WriteFile(journal, kJournal, arraysize(kJournal) - 1));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      invalid_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_JSON_PARSE,
+            pref_store->ReadPrefs());
+  EXPECT_FALSE(PathExists(journal));
+  EXPECT_FALSE(pref_store->GetValue("a", NULL));
+}
+
+// Tests that lazily loaded prefs are parsed when they are first used, and
+// that writes keep the prefs that weren't used.
+TEST_F(JsonPrefStoreTest, LazyLoad) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("lazy.json");
+  const char kPrefs[] =
+      "{\"a\": {\"b\": 1, \"c\": [true, \"}]\\\"\"]},\n"
+      " \"d\": \"e\", \"f\": null, \"g\\u002eh\": 2.5, \"i\": {}}";
+  ASSERT_TRUE(WriteFile(pref_file, kPrefs, arraysize(kPrefs) - 1));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+
+  const Value* value;
+  ASSERT_TRUE(pref_store->GetValue("a.c", &value));
+  const ListValue* list;
+  ASSERT_TRUE(value->GetAsList(&list));
+  std::string string_value;
+  EXPECT_TRUE(list->GetString(1, &string_value));
+  EXPECT_EQ("}]\"", string_value);
+  ASSERT_TRUE(pref_store->GetValue("d", &value));
+  EXPECT_TRUE(StringValue("e").Equals(value));
+  EXPECT_FALSE(pref_store->GetValue("x", &value));
+
+  // Setting a pref in a dictionary keeps the other prefs of the dictionary.
+  pref_store->SetValue("a.b", make_scoped_ptr(new FundamentalValue(2)),
+                       WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->RemoveValue("f", WriteablePrefStore::DEFAULT_PREF_WRITE_FLAGS);
+  pref_store->CommitPendingWrite();
+  RunLoop().RunUntilIdle();
+
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(pref_file, &contents));
+  EXPECT_EQ(
+      "{\"a\":{\"b\":2,\"c\":[true,\"}]\\\"\"]},\"d\":\"e\","
+      "\"g.h\":2.5,\"i\":{}}",
+      contents);
+}
+
+// Tests that prefs are lazily loaded by ReadPrefsAsync() too.
+TEST_F(JsonPrefStoreTest, LazyLoadAsync) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("lazy.json");
+  const char kPrefs[] = "{\"a\":{\"b\":1},\"c\":\"d\"}";
+  ASSERT_TRUE(WriteFile(pref_file, kPrefs, arraysize(kPrefs) - 1));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  MockPrefStoreObserver mock_observer;
+  pref_store->AddObserver(&mock_observer);
+  EXPECT_CALL(mock_observer, OnInitializationCompleted(true)).Times(1);
+  pref_store->ReadPrefsAsync(NULL);
+  RunLoop().RunUntilIdle();
+  pref_store->RemoveObserver(&mock_observer);
+
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->GetReadError());
+  base::Value* value;
+  ASSERT_TRUE(pref_store->GetMutableValue("a.b", &value));
+  EXPECT_TRUE(FundamentalValue(1).Equals(value));
+  EXPECT_TRUE(pref_store->GetValue("c", NULL));
+}
+
+// Tests that a lazily loaded pref of invalid value is dropped, and that a file
+// that the index can't make sense of is still parsed.
+TEST_F(JsonPrefStoreTest, LazyLoadWithInvalidValue) {
+  FilePath pref_file = temp_dir_.path().AppendASCII("lazy.json");
+  const char kPrefs[] = "{\"a\":[1,2},\"b\":tru,\"c\":3}";
+  ASSERT_TRUE(WriteFile(pref_file, kPrefs, arraysize(kPrefs) - 1));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      pref_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  EXPECT_FALSE(pref_store->GetValue("a", NULL));
+  EXPECT_FALSE(pref_store->GetValue("b", NULL));
+  EXPECT_TRUE(pref_store->GetValue("c", NULL));
+
+  const char kPrefsWithComment[] = "{\"a\":1 // Comment.\n}";
+  ASSERT_TRUE(WriteFile(pref_file, kPrefsWithComment,
+                        arraysize(kPrefsWithComment) - 1));
+  pref_store = new JsonPrefStore(pref_file, message_loop_.task_runner(),
+                                 scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  ASSERT_EQ(PersistentPrefStore::PREF_READ_ERROR_NONE,
+            pref_store->ReadPrefs());
+  EXPECT_TRUE(pref_store->GetValue("a", NULL));
+}
+
+// Tests that an invalid file is moved aside in lazy load mode too.
+TEST_F(JsonPrefStoreTest, LazyLoadWithInvalidFile) {
+  FilePath invalid_file = temp_dir_.path().AppendASCII("invalid.json");
+  ASSERT_TRUE(CopyFile(data_dir_.AppendASCII("invalid.json"), invalid_file));
+
+  scoped_refptr<JsonPrefStore> pref_store = new JsonPrefStore(
+      invalid_file, message_loop_.task_runner(), scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_JSON_PARSE,
+            pref_store->ReadPrefs());
+  EXPECT_FALSE(PathExists(invalid_file));
+  EXPECT_TRUE(PathExists(temp_dir_.path().AppendASCII("invalid.bad")));
+
+  pref_store = new JsonPrefStore(invalid_file, message_loop_.task_runner(),
+                                 scoped_ptr<PrefFilter>());
+  pref_store->EnableLazyLoad();
+  EXPECT_EQ(PersistentPrefStore::PREF_READ_ERROR_NO_FILE,
+            pref_store->ReadPrefs());
+}
+
 TEST_F(JsonPrefStoreTest, WriteCountHistogramTestBasic) {
   SimpleTestClock* test_clock = new SimpleTestClock;
   SetCurrentTimeInMinutes(0, test_clock);
@@ -0,0 +1,42 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/scoped_peak_memory_delta.h"
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/process/process_metrics.h"
+
+namespace base {
+namespace {
+
+ProcessMetrics* CreateProcessMetricsForCurrentProcess() {
+#if defined(OS_MACOSX) && !defined(OS_IOS)
+  return ProcessMetrics::CreateProcessMetrics(GetCurrentProcessHandle(), NULL);
+#else
+  return ProcessMetrics::CreateProcessMetrics(GetCurrentProcessHandle());
+#endif
+}
+
+}  // namespace
+
+ScopedPeakMemoryDelta::ScopedPeakMemoryDelta()
+    : metrics_(CreateProcessMetricsForCurrentProcess()),
+      supported_(false),
+      start_bytes_(0) {
+#if defined(OS_LINUX)
+  supported_ = WriteFile(FilePath("/proc/self/clear_refs"), "5", 1) == 1;
+#endif
+  start_bytes_ = metrics_->GetWorkingSetSize();
+}
+
+ScopedPeakMemoryDelta::~ScopedPeakMemoryDelta() {
+}
+
+size_t ScopedPeakMemoryDelta::GetDeltaBytes() const {
+  const size_t peak_bytes = metrics_->GetPeakWorkingSetSize();
+  return peak_bytes > start_bytes_ ? peak_bytes - start_bytes_ : 0;
+}
+
+}  // namespace base
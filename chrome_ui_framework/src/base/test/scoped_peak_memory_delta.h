@@ -0,0 +1,40 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_SCOPED_PEAK_MEMORY_DELTA_H_
+#define BASE_TEST_SCOPED_PEAK_MEMORY_DELTA_H_
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+
+namespace base {
+
+class ProcessMetrics;
+
+// Measures how much the peak resident set size of the process grows during
+// the lifetime of the object. Only supported on Linux, where the peak can be
+// reset on construction.
+class ScopedPeakMemoryDelta {
+ public:
+  ScopedPeakMemoryDelta();
+  ~ScopedPeakMemoryDelta();
+
+  // Returns false if the peak could not be reset, in which case
+  // GetDeltaBytes() is meaningless.
+  bool supported() const { return supported_; }
+
+  // Returns the growth of the peak resident set size since construction.
+  size_t GetDeltaBytes() const;
+
+ private:
+  scoped_ptr<ProcessMetrics> metrics_;
+  bool supported_;
+  size_t start_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedPeakMemoryDelta);
+};
+
+}  // namespace base
+
+#endif  // BASE_TEST_SCOPED_PEAK_MEMORY_DELTA_H_
@@ -0,0 +1,481 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_binary_format.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/json/string_escape.h"
+#include "base/strings/stringprintf.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_log.h"
+
+namespace base {
+namespace trace_event {
+
+const char kTraceBinaryMagic[] = "CTRB";
+
+namespace {
+
+const size_t kTraceBinaryMagicLength = sizeof(kTraceBinaryMagic) - 1;
+
+// The bits of the fields byte of an event record, for the fields that are
+// optional.
+enum EventFields {
+  kHasThreadTimestamp = 1 << 0,
+  kHasDuration = 1 << 1,
+  kHasThreadDuration = 1 << 2,
+  kArgumentsStripped = 1 << 3,
+};
+
+void AppendVarint(uint64 value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// Small negative numbers, like the deltas of timestamps that go back, are
+// written as small varints as well.
+void AppendZigZag(int64 value, std::string* out) {
+  AppendVarint((static_cast<uint64>(value) << 1) ^ (value >> 63), out);
+}
+
+void AppendString(const StringPiece& string, std::string* out) {
+  AppendVarint(string.size(), out);
+  string.AppendToString(out);
+}
+
+// Reads the records of a binary trace, stopping at the first error.
+class TraceBinaryReader {
+ public:
+  explicit TraceBinaryReader(const StringPiece& data)
+      : data_(data), position_(0), error_(false) {}
+
+  bool error() const { return error_; }
+  bool at_end() const { return position_ == data_.size(); }
+
+  unsigned char ReadByte() {
+    if (position_ >= data_.size())
+      return Fail();
+    return static_cast<unsigned char>(data_[position_++]);
+  }
+
+  uint64 ReadVarint() {
+    uint64 value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      unsigned char byte = ReadByte();
+      value |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    return Fail();
+  }
+
+  int64 ReadZigZag() {
+    uint64 value = ReadVarint();
+    return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+  }
+
+  StringPiece ReadString() {
+    uint64 length = ReadVarint();
+    if (length > data_.size() - position_) {
+      Fail();
+      return StringPiece();
+    }
+    StringPiece string = data_.substr(position_, length);
+    position_ += length;
+    return string;
+  }
+
+  double ReadDouble() {
+    uint64 bits = 0;
+    for (int i = 0; i < 8; ++i)
+      bits |= static_cast<uint64>(ReadByte()) << (i * 8);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // Sets the error and returns 0, so that the readers can return its result.
+  int Fail() {
+    error_ = true;
+    position_ = data_.size();
+    return 0;
+  }
+
+ private:
+  StringPiece data_;
+  size_t position_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryReader);
+};
+
+// Reads the string with the number read from |reader|. 0 stands for NULL.
+bool ReadStringId(TraceBinaryReader* reader,
+                  const std::vector<StringPiece>& strings,
+                  StringPiece* string) {
+  uint64 id = reader->ReadVarint();
+  if (id > strings.size())
+    return !reader->Fail();
+  *string = id ? strings[id - 1] : StringPiece();
+  return !reader->error();
+}
+
+// Converts an event record, after the record type, to JSON in the same way as
+// TraceEvent::AppendAsJSON().
+bool AppendEventAsJSON(TraceBinaryReader* reader,
+                       const std::vector<StringPiece>& strings,
+                       int process_id,
+                       int64* timestamp,
+                       int64* thread_timestamp,
+                       std::string* out) {
+  char phase = static_cast<char>(reader->ReadByte());
+  unsigned int flags = static_cast<unsigned int>(reader->ReadVarint());
+  StringPiece category_group_name;
+  StringPiece name;
+  if (!ReadStringId(reader, strings, &category_group_name) ||
+      !ReadStringId(reader, strings, &name)) {
+    return false;
+  }
+  int thread_id = static_cast<int>(reader->ReadZigZag());
+  *timestamp += reader->ReadZigZag();
+  unsigned char fields = reader->ReadByte();
+  if (fields & kHasThreadTimestamp)
+    *thread_timestamp += reader->ReadZigZag();
+  int64 duration = fields & kHasDuration ? reader->ReadZigZag() : 0;
+  int64 thread_duration =
+      fields & kHasThreadDuration ? reader->ReadZigZag() : 0;
+  uint64 id = flags & TRACE_EVENT_FLAG_HAS_ID ? reader->ReadVarint() : 0;
+  uint64 bind_id =
+      flags & (TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT)
+          ? reader->ReadVarint()
+          : 0;
+  uint64 context_id =
+      flags & TRACE_EVENT_FLAG_HAS_CONTEXT_ID ? reader->ReadVarint() : 0;
+  int num_args = reader->ReadByte();
+  if (reader->error() || num_args > kTraceMaxNumArgs)
+    return !reader->Fail();
+
+  StringAppendF(out, "{\"pid\":%i,\"tid\":%i,\"ts\":%" PRId64
+                     ","
+                     "\"ph\":\"%c\",\"cat\":\"",
+                process_id, thread_id, *timestamp, phase);
+  category_group_name.AppendToString(out);
+  *out += "\",\"name\":\"";
+  name.AppendToString(out);
+  *out += "\",\"args\":";
+
+  if (fields & kArgumentsStripped) {
+    *out += "\"__stripped__\"";
+  } else {
+    *out += "{";
+    for (int i = 0; i < num_args; ++i) {
+      if (i > 0)
+        *out += ",";
+      StringPiece arg_name;
+      if (!ReadStringId(reader, strings, &arg_name))
+        return false;
+      *out += "\"";
+      arg_name.AppendToString(out);
+      *out += "\":";
+
+      unsigned char type = reader->ReadByte();
+      TraceEvent::TraceValue value;
+      StringPiece string_value;
+      switch (type) {
+        case TRACE_VALUE_TYPE_BOOL:
+          value.as_bool = !!reader->ReadByte();
+          break;
+        case TRACE_VALUE_TYPE_UINT:
+          value.as_uint = reader->ReadVarint();
+          break;
+        case TRACE_VALUE_TYPE_INT:
+          value.as_int = reader->ReadZigZag();
+          break;
+        case TRACE_VALUE_TYPE_DOUBLE:
+          value.as_double = reader->ReadDouble();
+          break;
+        case TRACE_VALUE_TYPE_POINTER:
+          value.as_pointer =
+              reinterpret_cast<const void*>(reader->ReadVarint());
+          break;
+        case TRACE_VALUE_TYPE_STRING:
+          if (!ReadStringId(reader, strings, &string_value))
+            return false;
+          EscapeJSONString(string_value.data() ? string_value : "NULL", true,
+                           out);
+          continue;
+        case TRACE_VALUE_TYPE_COPY_STRING:
+          EscapeJSONString(reader->ReadString(), true, out);
+          continue;
+        case TRACE_VALUE_TYPE_CONVERTABLE:
+          reader->ReadString().AppendToString(out);
+          continue;
+        default:
+          return !reader->Fail();
+      }
+      if (reader->error())
+        return false;
+      TraceEvent::AppendValueAsJSON(type, value, out);
+    }
+    *out += "}";
+  }
+
+  if (fields & kHasDuration)
+    StringAppendF(out, ",\"dur\":%" PRId64, duration);
+  if (fields & kHasThreadDuration)
+    StringAppendF(out, ",\"tdur\":%" PRId64, thread_duration);
+  if (fields & kHasThreadTimestamp)
+    StringAppendF(out, ",\"tts\":%" PRId64, *thread_timestamp);
+  if (flags & TRACE_EVENT_FLAG_ASYNC_TTS)
+    StringAppendF(out, ", \"use_async_tts\":1");
+  if (flags & TRACE_EVENT_FLAG_HAS_ID)
+    StringAppendF(out, ",\"id\":\"0x%" PRIx64 "\"", id);
+  if (flags & TRACE_EVENT_FLAG_BIND_TO_ENCLOSING)
+    StringAppendF(out, ",\"bp\":\"e\"");
+  if ((flags & TRACE_EVENT_FLAG_FLOW_OUT) ||
+      (flags & TRACE_EVENT_FLAG_FLOW_IN)) {
+    StringAppendF(out, ",\"bind_id\":\"0x%" PRIx64 "\"", bind_id);
+  }
+  if (flags & TRACE_EVENT_FLAG_FLOW_IN)
+    StringAppendF(out, ",\"flow_in\":true");
+  if (flags & TRACE_EVENT_FLAG_FLOW_OUT)
+    StringAppendF(out, ",\"flow_out\":true");
+  if (flags & TRACE_EVENT_FLAG_HAS_CONTEXT_ID)
+    StringAppendF(out, ",\"cid\":\"0x%" PRIx64 "\"", context_id);
+
+  if (phase == TRACE_EVENT_PHASE_INSTANT) {
+    char scope = '?';
+    switch (flags & TRACE_EVENT_FLAG_SCOPE_MASK) {
+      case TRACE_EVENT_SCOPE_GLOBAL:
+        scope = TRACE_EVENT_SCOPE_NAME_GLOBAL;
+        break;
+
+      case TRACE_EVENT_SCOPE_PROCESS:
+        scope = TRACE_EVENT_SCOPE_NAME_PROCESS;
+        break;
+
+      case TRACE_EVENT_SCOPE_THREAD:
+        scope = TRACE_EVENT_SCOPE_NAME_THREAD;
+        break;
+    }
+    StringAppendF(out, ",\"s\":\"%c\"", scope);
+  }
+
+  *out += "}";
+  return true;
+}
+
+}  // namespace
+
+TraceBinaryWriter::TraceBinaryWriter(
+    const ArgumentFilterPredicate& argument_filter_predicate)
+    : argument_filter_predicate_(argument_filter_predicate),
+      next_string_id_(1),
+      process_id_(0),
+      last_timestamp_(0),
+      last_thread_timestamp_(0) {}
+
+TraceBinaryWriter::~TraceBinaryWriter() {}
+
+// static
+void TraceBinaryWriter::AppendHeader(std::string* out) {
+  out->append(kTraceBinaryMagic, kTraceBinaryMagicLength);
+  out->push_back(static_cast<char>(kTraceBinaryVersion));
+}
+
+void TraceBinaryWriter::AppendEvent(const TraceEvent& event,
+                                    std::string* out) {
+  int process_id = TraceLog::GetInstance()->process_id();
+  if (process_id != process_id_) {
+    out->push_back(kTraceBinaryProcessId);
+    AppendZigZag(process_id, out);
+    process_id_ = process_id;
+  }
+
+  const char* category_group_name =
+      TraceLog::GetCategoryGroupName(event.category_group_enabled());
+  const bool copy = !!(event.flags() & TRACE_EVENT_FLAG_COPY);
+  bool strip_args = event.arg_name(0) &&
+                    !argument_filter_predicate_.is_null() &&
+                    !argument_filter_predicate_.Run(category_group_name,
+                                                    event.name());
+
+  // The strings go before the event, as the reader looks them up as it reads
+  // the event.
+  uint32 category_id = InternString(category_group_name, false, out);
+  uint32 name_id = InternString(event.name(), copy, out);
+  uint32 arg_name_ids[kTraceMaxNumArgs];
+  uint32 arg_string_ids[kTraceMaxNumArgs];
+  int num_args = 0;
+  if (!strip_args) {
+    for (; num_args < kTraceMaxNumArgs && event.arg_name(num_args);
+         ++num_args) {
+      arg_name_ids[num_args] =
+          InternString(event.arg_name(num_args), copy, out);
+      if (event.arg_type(num_args) == TRACE_VALUE_TYPE_STRING) {
+        arg_string_ids[num_args] =
+            InternString(event.arg_value(num_args).as_string, false, out);
+      }
+    }
+  }
+
+  out->push_back(kTraceBinaryEvent);
+  out->push_back(event.phase());
+  AppendVarint(event.flags(), out);
+  AppendVarint(category_id, out);
+  AppendVarint(name_id, out);
+  AppendZigZag(event.thread_id(), out);
+  int64 timestamp = event.timestamp().ToInternalValue();
+  AppendZigZag(timestamp - last_timestamp_, out);
+  last_timestamp_ = timestamp;
+
+  // The same fields as in the JSON.
+  unsigned char fields = 0;
+  const bool has_thread_timestamp = !event.thread_timestamp().is_null();
+  if (has_thread_timestamp)
+    fields |= kHasThreadTimestamp;
+  if (event.phase() == TRACE_EVENT_PHASE_COMPLETE) {
+    if (event.duration().ToInternalValue() != -1)
+      fields |= kHasDuration;
+    if (has_thread_timestamp &&
+        event.thread_duration().ToInternalValue() != -1) {
+      fields |= kHasThreadDuration;
+    }
+  }
+  if (strip_args)
+    fields |= kArgumentsStripped;
+  out->push_back(fields);
+  if (has_thread_timestamp) {
+    int64 thread_timestamp = event.thread_timestamp().ToInternalValue();
+    AppendZigZag(thread_timestamp - last_thread_timestamp_, out);
+    last_thread_timestamp_ = thread_timestamp;
+  }
+  if (fields & kHasDuration)
+    AppendZigZag(event.duration().ToInternalValue(), out);
+  if (fields & kHasThreadDuration)
+    AppendZigZag(event.thread_duration().ToInternalValue(), out);
+
+  if (event.flags() & TRACE_EVENT_FLAG_HAS_ID)
+    AppendVarint(event.id(), out);
+  if (event.flags() & (TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT))
+    AppendVarint(event.bind_id(), out);
+  if (event.flags() & TRACE_EVENT_FLAG_HAS_CONTEXT_ID)
+    AppendVarint(event.context_id(), out);
+
+  out->push_back(static_cast<char>(num_args));
+  for (int i = 0; i < num_args; ++i) {
+    AppendVarint(arg_name_ids[i], out);
+    unsigned char type = event.arg_type(i);
+    out->push_back(type);
+    TraceEvent::TraceValue value = event.arg_value(i);
+    switch (type) {
+      case TRACE_VALUE_TYPE_BOOL:
+        out->push_back(value.as_bool ? 1 : 0);
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        AppendVarint(value.as_uint, out);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        AppendZigZag(value.as_int, out);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE: {
+        uint64 bits;
+        memcpy(&bits, &value.as_double, sizeof(bits));
+        for (int byte = 0; byte < 8; ++byte)
+          out->push_back(static_cast<char>(bits >> (byte * 8)));
+        break;
+      }
+      case TRACE_VALUE_TYPE_POINTER:
+        AppendVarint(reinterpret_cast<uintptr_t>(value.as_pointer), out);
+        break;
+      case TRACE_VALUE_TYPE_STRING:
+        AppendVarint(arg_string_ids[i], out);
+        break;
+      case TRACE_VALUE_TYPE_COPY_STRING:
+        AppendString(value.as_string ? value.as_string : "NULL", out);
+        break;
+      case TRACE_VALUE_TYPE_CONVERTABLE:
+        AppendString(event.convertable_value(i)->ToString(), out);
+        break;
+      default:
+        NOTREACHED() << "Don't know how to write this value";
+        break;
+    }
+  }
+}
+
+uint32 TraceBinaryWriter::InternString(const char* string,
+                                       bool is_copy,
+                                       std::string* out) {
+  if (!string)
+    return 0;
+  if (!is_copy) {
+    hash_map<const char*, uint32>::const_iterator it =
+        string_ids_by_address_.find(string);
+    if (it != string_ids_by_address_.end())
+      return it->second;
+  }
+
+  std::pair<hash_map<std::string, uint32>::iterator, bool> inserted =
+      string_ids_.insert(std::make_pair(std::string(string), next_string_id_));
+  if (inserted.second) {
+    out->push_back(kTraceBinaryString);
+    AppendString(string, out);
+    next_string_id_++;
+  }
+  if (!is_copy)
+    string_ids_by_address_[string] = inserted.first->second;
+  return inserted.first->second;
+}
+
+bool ConvertBinaryTraceToJSON(const StringPiece& binary_trace,
+                              std::string* json_events) {
+  const size_t header_length = kTraceBinaryMagicLength + 1;
+  if (binary_trace.size() < header_length ||
+      binary_trace.substr(0, kTraceBinaryMagicLength) != kTraceBinaryMagic ||
+      static_cast<unsigned char>(binary_trace[kTraceBinaryMagicLength]) !=
+          kTraceBinaryVersion) {
+    return false;
+  }
+
+  TraceBinaryReader reader(binary_trace.substr(header_length));
+  std::vector<StringPiece> strings;
+  int process_id = 0;
+  int64 timestamp = 0;
+  int64 thread_timestamp = 0;
+  bool first_event = true;
+  while (!reader.at_end()) {
+    switch (reader.ReadByte()) {
+      case kTraceBinaryString:
+        strings.push_back(reader.ReadString());
+        break;
+      case kTraceBinaryProcessId:
+        process_id = static_cast<int>(reader.ReadZigZag());
+        break;
+      case kTraceBinaryEvent:
+        if (!first_event)
+          json_events->append(",\n");
+        first_event = false;
+        if (!AppendEventAsJSON(&reader, strings, process_id, &timestamp,
+                               &thread_timestamp, json_events)) {
+          return false;
+        }
+        break;
+      default:
+        reader.Fail();
+        break;
+    }
+  }
+  return !reader.error();
+}
+
+}  // namespace trace_event
+}  // namespace base
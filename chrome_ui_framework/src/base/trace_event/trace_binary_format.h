@@ -0,0 +1,95 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
+#define BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/containers/hash_tables.h"
+#include "base/strings/string_piece.h"
+#include "base/trace_event/trace_event_impl.h"
+
+namespace base {
+namespace trace_event {
+
+// A compact binary form of trace events, for traces that are too large to
+// be kept in memory or serialized to JSON in one go. It is several times
+// smaller than the JSON and faster to write, and it can be written as the
+// events are collected (see TraceLog::SetBinaryTraceFile()).
+//
+// A trace is a header, kTraceBinaryMagic followed by a version byte, then a
+// sequence of records, each starting with a TraceBinaryRecordType byte:
+//   - kTraceBinaryString: a varint length and the bytes of a string. The
+//     strings of a trace are numbered from 1 in the order of their records.
+//     Event names, categories, argument names and string argument values are
+//     written once, and then referred to by number.
+//   - kTraceBinaryProcessId: the zigzag varint process id of the events that
+//     follow.
+//   - kTraceBinaryEvent: an event, see TraceBinaryWriter::AppendEvent().
+//     The timestamps are zigzag varint deltas from those of the previous
+//     event, and the other numbers are varints.
+// The strings and timestamps of the events depend on the previous records,
+// so a trace can only be read from the start.
+
+extern BASE_EXPORT const char kTraceBinaryMagic[];
+const unsigned char kTraceBinaryVersion = 1;
+
+enum TraceBinaryRecordType {
+  kTraceBinaryString = 1,
+  kTraceBinaryProcessId = 2,
+  kTraceBinaryEvent = 3,
+};
+
+// Serializes trace events in the binary trace format. A writer interns the
+// strings of the events it has written, so all the events of a trace must go
+// through the same writer.
+class BASE_EXPORT TraceBinaryWriter {
+ public:
+  // The arguments of the events for which |argument_filter_predicate|
+  // returns false are stripped, as they are from the JSON output.
+  explicit TraceBinaryWriter(
+      const ArgumentFilterPredicate& argument_filter_predicate);
+  ~TraceBinaryWriter();
+
+  // Appends the header of a trace to |out|.
+  static void AppendHeader(std::string* out);
+
+  // Appends |event| to |out|, after the records of the strings that it uses
+  // for the first time.
+  void AppendEvent(const TraceEvent& event, std::string* out);
+
+ private:
+  // Returns the number of |string|, and appends its record to |out| when it
+  // is new. |is_copy| is false if |string| stays alive and unchanged for the
+  // whole trace, in which case it is looked up by address first.
+  uint32 InternString(const char* string, bool is_copy, std::string* out);
+
+  ArgumentFilterPredicate argument_filter_predicate_;
+
+  // The numbers of the strings written so far, by address for the strings
+  // that are not copies, and by contents.
+  hash_map<const char*, uint32> string_ids_by_address_;
+  hash_map<std::string, uint32> string_ids_;
+  uint32 next_string_id_;
+
+  int process_id_;
+  int64 last_timestamp_;
+  int64 last_thread_timestamp_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryWriter);
+};
+
+// Converts a binary trace to the JSON that TraceLog::Flush() would have
+// returned for the same events: the events as JSON objects, separated by
+// ",\n". Returns false if |binary_trace| is not a valid binary trace, in
+// which case |json_events| holds the events up to the error.
+BASE_EXPORT bool ConvertBinaryTraceToJSON(const StringPiece& binary_trace,
+                                          std::string* json_events);
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_BINARY_FORMAT_H_
@@ -0,0 +1,239 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_binary_format.h"
+
+#include <string.h>
+
+#include <limits>
+
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_event_argument.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kNotFiltered[] = "not_filtered";
+
+bool IsNotFiltered(const char* category_group_name, const char* event_name) {
+  return strcmp(category_group_name, kNotFiltered) == 0;
+}
+
+class TraceBinaryFormatTest : public testing::Test {
+ public:
+  TraceBinaryFormatTest() {}
+
+ protected:
+  TraceEvent* AddEvent(char phase,
+                       const char* category_group,
+                       const char* name,
+                       int64 timestamp,
+                       int64 thread_timestamp,
+                       unsigned int flags) {
+    TraceEvent* event = new TraceEvent;
+    event->Initialize(42, TraceTicks::FromInternalValue(timestamp),
+                      ThreadTicks::FromInternalValue(thread_timestamp), phase,
+                      TraceLog::GetCategoryGroupEnabled(category_group), name,
+                      0x1234567890ull, 0xabcull, 0xdefull, 0, NULL, NULL, NULL,
+                      NULL, flags);
+    events_.push_back(event);
+    return event;
+  }
+
+  TraceEvent* AddEventWithArgs(const char* name,
+                               int num_args,
+                               const char** arg_names,
+                               const unsigned char* arg_types,
+                               const unsigned long long* arg_values,
+                               unsigned int flags) {
+    scoped_refptr<ConvertableToTraceFormat> convertable_values[2];
+    for (int i = 0; i < num_args; ++i) {
+      if (arg_types[i] == TRACE_VALUE_TYPE_CONVERTABLE) {
+        scoped_refptr<TracedValue> value = new TracedValue;
+        value->SetString("key", "\"value\"");
+        value->SetDouble("double", 0.5);
+        convertable_values[i] = value;
+      }
+    }
+    TraceEvent* event = new TraceEvent;
+    event->Initialize(-7, TraceTicks::FromInternalValue(1000),
+                      ThreadTicks(), TRACE_EVENT_PHASE_INSTANT,
+                      TraceLog::GetCategoryGroupEnabled("args"), name, 0, 0, 0,
+                      num_args, arg_names, arg_types, arg_values,
+                      convertable_values, flags);
+    events_.push_back(event);
+    return event;
+  }
+
+  // Returns the events as TraceLog::Flush() would.
+  std::string GetEventsAsJSON(const ArgumentFilterPredicate& predicate) {
+    std::string json;
+    for (size_t i = 0; i < events_.size(); ++i) {
+      if (i)
+        json += ",\n";
+      events_[i]->AppendAsJSON(&json, predicate);
+    }
+    return json;
+  }
+
+  std::string GetEventsAsBinary(const ArgumentFilterPredicate& predicate) {
+    std::string binary;
+    TraceBinaryWriter::AppendHeader(&binary);
+    TraceBinaryWriter writer(predicate);
+    for (size_t i = 0; i < events_.size(); ++i)
+      writer.AppendEvent(*events_[i], &binary);
+    return binary;
+  }
+
+  ScopedVector<TraceEvent> events_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TraceBinaryFormatTest);
+};
+
+}  // namespace
+
+TEST_F(TraceBinaryFormatTest, EventsConvertToSameJSON) {
+  AddEvent(TRACE_EVENT_PHASE_BEGIN, "cat", "begin", 100, 0, 0);
+  AddEvent(TRACE_EVENT_PHASE_END, "cat", "end", 200, 0, 0);
+  // Timestamps are not in order across threads.
+  AddEvent(TRACE_EVENT_PHASE_COMPLETE, "cat,other", "unfinished", 50, 7, 0);
+  AddEvent(TRACE_EVENT_PHASE_COMPLETE, "cat", "complete", 150, 20, 0)
+      ->UpdateDuration(TraceTicks::FromInternalValue(175),
+                       ThreadTicks::FromInternalValue(30));
+  AddEvent(TRACE_EVENT_PHASE_COMPLETE, "cat", "no thread time", 1000000000, 0,
+           0)
+      ->UpdateDuration(TraceTicks::FromInternalValue(3000000000LL),
+                       ThreadTicks());
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "global", 300, 0,
+           TRACE_EVENT_SCOPE_GLOBAL);
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "process", 301, 0,
+           TRACE_EVENT_SCOPE_PROCESS);
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "thread", 302, 0,
+           TRACE_EVENT_SCOPE_THREAD | TRACE_EVENT_FLAG_COPY);
+  AddEvent(TRACE_EVENT_PHASE_ASYNC_BEGIN, "cat", "async", 400, 40,
+           TRACE_EVENT_FLAG_HAS_ID | TRACE_EVENT_FLAG_ASYNC_TTS);
+  AddEvent(TRACE_EVENT_PHASE_COMPLETE, "cat", "flow", 500, 0,
+           TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT |
+               TRACE_EVENT_FLAG_BIND_TO_ENCLOSING |
+               TRACE_EVENT_FLAG_HAS_CONTEXT_ID);
+
+  const char* arg_names[] = {"first", "second"};
+  const char kCopiedString[] = "copied \"string\"\n";
+  const unsigned char kTypes[][2] = {
+      {TRACE_VALUE_TYPE_BOOL, TRACE_VALUE_TYPE_UINT},
+      {TRACE_VALUE_TYPE_INT, TRACE_VALUE_TYPE_DOUBLE},
+      {TRACE_VALUE_TYPE_POINTER, TRACE_VALUE_TYPE_STRING},
+      {TRACE_VALUE_TYPE_COPY_STRING, TRACE_VALUE_TYPE_CONVERTABLE},
+  };
+  TraceEvent::TraceValue values[arraysize(kTypes)][2];
+  values[0][0].as_bool = true;
+  values[0][1].as_uint = std::numeric_limits<unsigned long long>::max();
+  values[1][0].as_int = std::numeric_limits<long long>::min();
+  values[1][1].as_double = -0.25;
+  values[2][0].as_pointer = &values;
+  values[2][1].as_string = "static string";
+  values[3][0].as_string = kCopiedString;
+  values[3][1].as_uint = 0;
+  for (size_t i = 0; i < arraysize(kTypes); ++i) {
+    unsigned long long arg_values[2] = {values[i][0].as_uint,
+                                        values[i][1].as_uint};
+    AddEventWithArgs("args", 2, arg_names, kTypes[i], arg_values, 0);
+    AddEventWithArgs("copied args", 2, arg_names, kTypes[i], arg_values,
+                     TRACE_EVENT_FLAG_COPY);
+  }
+
+  const unsigned char kDoubleType[] = {TRACE_VALUE_TYPE_DOUBLE};
+  const double kDoubles[] = {std::numeric_limits<double>::quiet_NaN(),
+                             std::numeric_limits<double>::infinity(), 1e100,
+                             3.0};
+  for (size_t i = 0; i < arraysize(kDoubles); ++i) {
+    TraceEvent::TraceValue value;
+    value.as_double = kDoubles[i];
+    unsigned long long arg_value = value.as_uint;
+    AddEventWithArgs("double", 1, arg_names, kDoubleType, &arg_value, 0);
+  }
+  const unsigned char kStringType[] = {TRACE_VALUE_TYPE_STRING};
+  unsigned long long null_string = 0;
+  AddEventWithArgs("null string", 1, arg_names, kStringType, &null_string, 0);
+
+  std::string json;
+  ASSERT_TRUE(ConvertBinaryTraceToJSON(
+      GetEventsAsBinary(ArgumentFilterPredicate()), &json));
+  EXPECT_EQ(GetEventsAsJSON(ArgumentFilterPredicate()), json);
+}
+
+TEST_F(TraceBinaryFormatTest, StringsAreWrittenOnce) {
+  const char* arg_names[] = {"arg"};
+  const unsigned char kStringType[] = {TRACE_VALUE_TYPE_STRING};
+  TraceEvent::TraceValue value;
+  value.as_string = "a long static string argument";
+  unsigned long long arg_value = value.as_uint;
+  for (int i = 0; i < 100; ++i) {
+    AddEventWithArgs("interned", 1, arg_names, kStringType, &arg_value, 0);
+    // Copied names are looked up by contents.
+    AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "copied", i, 0,
+             TRACE_EVENT_FLAG_COPY);
+  }
+
+  const std::string binary = GetEventsAsBinary(ArgumentFilterPredicate());
+  const char* const kStrings[] = {"interned", "copied", "args", "cat",
+                                  value.as_string};
+  for (size_t i = 0; i < arraysize(kStrings); ++i) {
+    SCOPED_TRACE(kStrings[i]);
+    EXPECT_NE(std::string::npos, binary.find(kStrings[i]));
+    EXPECT_EQ(binary.find(kStrings[i]), binary.rfind(kStrings[i]));
+  }
+  EXPECT_LT(binary.size() * 4,
+            GetEventsAsJSON(ArgumentFilterPredicate()).size());
+}
+
+TEST_F(TraceBinaryFormatTest, ArgumentFilter) {
+  const char* arg_names[] = {"arg"};
+  const unsigned char kIntType[] = {TRACE_VALUE_TYPE_INT};
+  unsigned long long arg_value = 1;
+  AddEventWithArgs("filtered", 1, arg_names, kIntType, &arg_value, 0);
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, kNotFiltered, "not filtered", 1, 0, 0);
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "filtered", "no args", 2, 0, 0);
+
+  const ArgumentFilterPredicate predicate = Bind(&IsNotFiltered);
+  std::string json;
+  ASSERT_TRUE(ConvertBinaryTraceToJSON(GetEventsAsBinary(predicate), &json));
+  EXPECT_EQ(GetEventsAsJSON(predicate), json);
+  EXPECT_NE(std::string::npos, json.find("__stripped__"));
+}
+
+TEST_F(TraceBinaryFormatTest, InvalidTraces) {
+  std::string json;
+  EXPECT_FALSE(ConvertBinaryTraceToJSON("", &json));
+  EXPECT_FALSE(ConvertBinaryTraceToJSON("[{\"ph\":\"B\"}]", &json));
+
+  std::string header;
+  TraceBinaryWriter::AppendHeader(&header);
+  EXPECT_TRUE(ConvertBinaryTraceToJSON(header, &json));
+  EXPECT_EQ("", json);
+
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "first", 1, 0, 0);
+  AddEvent(TRACE_EVENT_PHASE_INSTANT, "cat", "second", 2, 0, 0);
+  const std::string binary = GetEventsAsBinary(ArgumentFilterPredicate());
+  for (size_t length = header.size() + 1; length < binary.size(); ++length) {
+    json.clear();
+    EXPECT_FALSE(
+        ConvertBinaryTraceToJSON(StringPiece(binary.data(), length), &json) &&
+        json == GetEventsAsJSON(ArgumentFilterPredicate()));
+  }
+
+  std::string unknown_record = header;
+  unknown_record.push_back(0x7f);
+  EXPECT_FALSE(ConvertBinaryTraceToJSON(unknown_record, &json));
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -4,7 +4,14 @@
 
 #include "base/trace_event/trace_buffer.h"
 
+#include <deque>
+#include <string>
+
 #include "base/memory/scoped_vector.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_binary_format.h"
 #include "base/trace_event/trace_event_impl.h"
 
 namespace base {
@@ -284,6 +291,285 @@ class TraceBufferVector : public TraceBuffer {
   DISALLOW_COPY_AND_ASSIGN(TraceBufferVector);
 };
 
+// Writes the output of TraceBufferStreaming to its file on a thread of its
+// own, since the buffer is used under TraceLog's lock. The thread does not
+// use a MessageLoop, because posting a task adds trace events, which would
+// take that lock again.
+class TraceFileWriter : public PlatformThread::Delegate {
+ public:
+  explicit TraceFileWriter(File file)
+      : file_(file.Pass()),
+        has_output_or_finished_(&lock_),
+        finished_(false),
+        joined_(false) {
+    if (!PlatformThread::Create(0, this, &thread_handle_)) {
+      DLOG(ERROR) << "Failed to create the binary trace writer thread";
+      file_.Close();
+      joined_ = true;
+    }
+  }
+
+  ~TraceFileWriter() override { Finish(); }
+
+  // Queues |output| to be written, leaving it empty.
+  void Write(std::string* output) {
+    if (joined_)
+      return;
+    AutoLock lock(lock_);
+    pending_output_.push_back(std::string());
+    pending_output_.back().swap(*output);
+    has_output_or_finished_.Signal();
+  }
+
+  // Writes the queued output, closes the file and stops the thread.
+  void Finish() {
+    if (joined_)
+      return;
+    {
+      AutoLock lock(lock_);
+      finished_ = true;
+      has_output_or_finished_.Signal();
+    }
+    PlatformThread::Join(thread_handle_);
+    joined_ = true;
+  }
+
+  // PlatformThread::Delegate:
+  void ThreadMain() override {
+    PlatformThread::SetName("TraceFileWriter");
+    AutoLock lock(lock_);
+    while (true) {
+      while (pending_output_.empty() && !finished_)
+        has_output_or_finished_.Wait();
+      if (pending_output_.empty())
+        break;
+      std::string output;
+      output.swap(pending_output_.front());
+      pending_output_.pop_front();
+
+      AutoUnlock unlock(lock_);
+      const int size = static_cast<int>(output.size());
+      if (file_.IsValid() &&
+          file_.WriteAtCurrentPos(output.data(), size) != size) {
+        DLOG(ERROR) << "Failed to write the binary trace";
+        file_.Close();
+      }
+    }
+    file_.Close();
+  }
+
+ private:
+  // Only used on the writer thread once it has started.
+  File file_;
+
+  Lock lock_;
+  ConditionVariable has_output_or_finished_;
+  std::deque<std::string> pending_output_;
+  bool finished_;
+
+  // Only used on the thread that owns the writer.
+  PlatformThreadHandle thread_handle_;
+  bool joined_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceFileWriter);
+};
+
+class TraceBufferStreaming : public TraceBuffer {
+ public:
+  TraceBufferStreaming(size_t max_chunks,
+                       File file,
+                       const ArgumentFilterPredicate& argument_filter_predicate)
+      : max_chunks_(max_chunks),
+        current_chunk_seq_(1),
+        file_writer_(file.Pass()),
+        writer_(argument_filter_predicate),
+        finished_(false) {
+    chunks_.reserve(max_chunks_);
+    written_events_.reserve(max_chunks_);
+    output_.reserve(kOutputBufferSize);
+    TraceBinaryWriter::AppendHeader(&output_);
+  }
+
+  ~TraceBufferStreaming() override {
+    // The events that are left are discarded, but not the ones that were
+    // already serialized.
+    WriteOutput();
+  }
+
+  scoped_ptr<TraceBufferChunk> GetChunk(size_t* index) override {
+    if (free_chunk_indices_.empty() && chunks_.size() >= max_chunks_)
+      WriteChunks(0, false);
+
+    TraceBufferChunk* chunk;
+    if (!free_chunk_indices_.empty()) {
+      *index = free_chunk_indices_.back();
+      free_chunk_indices_.pop_back();
+      chunk = chunks_[*index];
+      chunks_[*index] = NULL;  // Put NULL in the slot of a in-flight chunk.
+      chunk->Reset(current_chunk_seq_++);
+    } else {
+      // All the chunks are in flight or hold unfinished complete events.
+      DCHECK_LE(chunks_.size(), TraceBufferChunk::kMaxChunkIndex);
+      *index = chunks_.size();
+      chunks_.push_back(NULL);
+      written_events_.push_back(0);
+      chunk = new TraceBufferChunk(current_chunk_seq_++);
+    }
+    written_events_[*index] = 0;
+    return scoped_ptr<TraceBufferChunk>(chunk);
+  }
+
+  void ReturnChunk(size_t index, scoped_ptr<TraceBufferChunk> chunk) override {
+    DCHECK_LT(index, chunks_.size());
+    DCHECK(!chunks_[index]);
+    chunks_[index] = chunk.release();
+    returned_chunk_indices_.push_back(index);
+
+    // Keep the latest chunks in memory, so that the durations of the complete
+    // events in them can still be updated, and write the others in batches.
+    if (returned_chunk_indices_.size() > max_chunks_ / 2)
+      WriteChunks(max_chunks_ / 4, false);
+  }
+
+  bool IsFull() const override { return false; }
+
+  size_t Size() const override {
+    // This is approximate because not all of the chunks are full.
+    return chunks_.size() * TraceBufferChunk::kTraceBufferChunkSize;
+  }
+
+  size_t Capacity() const override {
+    return max_chunks_ * TraceBufferChunk::kTraceBufferChunkSize;
+  }
+
+  TraceEvent* GetEventByHandle(TraceEventHandle handle) override {
+    if (handle.chunk_index >= chunks_.size())
+      return NULL;
+    TraceBufferChunk* chunk = chunks_[handle.chunk_index];
+    if (!chunk || chunk->seq() != handle.chunk_seq)
+      return NULL;
+    return chunk->GetEventAt(handle.event_index);
+  }
+
+  const TraceBufferChunk* NextChunk() override {
+    if (!finished_) {
+      // Iterating happens after TraceLog has released its lock, so waiting
+      // for the writes here does not block tracing.
+      WriteChunks(0, true);
+      WriteOutput();
+      file_writer_.Finish();
+      finished_ = true;
+    }
+    return NULL;
+  }
+
+  scoped_ptr<TraceBuffer> CloneForIteration() const override {
+    NOTIMPLEMENTED();
+    return scoped_ptr<TraceBuffer>();
+  }
+
+  void EstimateTraceMemoryOverhead(
+      TraceEventMemoryOverhead* overhead) override {
+    overhead->Add("TraceBufferStreaming", sizeof(*this) + output_.capacity());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      TraceBufferChunk* chunk = chunks_[i];
+      // Skip the in-flight (nullptr) chunks. They will be accounted by the
+      // per-thread-local dumpers, see ThreadLocalEventBuffer::OnMemoryDump.
+      if (chunk)
+        chunk->EstimateTraceMemoryOverhead(overhead);
+    }
+  }
+
+ private:
+  // How much serialized output is buffered before it is written to the file.
+  static const size_t kOutputBufferSize = 256 * 1024;
+
+  static_assert(TraceBufferChunk::kTraceBufferChunkSize <= 64,
+                "The written events of a chunk must fit in a uint64");
+
+  // Serializes the returned chunks except for the |chunks_to_keep| latest
+  // ones, and frees them. The chunks with complete events that have not
+  // ended are only freed once the events end, unless |write_all_events|.
+  void WriteChunks(size_t chunks_to_keep, bool write_all_events) {
+    for (size_t i = 0; i < unfinished_chunk_indices_.size();) {
+      size_t index = unfinished_chunk_indices_[i];
+      if (WriteChunk(index, write_all_events)) {
+        free_chunk_indices_.push_back(index);
+        unfinished_chunk_indices_[i] = unfinished_chunk_indices_.back();
+        unfinished_chunk_indices_.pop_back();
+      } else {
+        ++i;
+      }
+    }
+
+    while (returned_chunk_indices_.size() > chunks_to_keep) {
+      size_t index = returned_chunk_indices_.front();
+      returned_chunk_indices_.pop_front();
+      if (WriteChunk(index, write_all_events))
+        free_chunk_indices_.push_back(index);
+      else
+        unfinished_chunk_indices_.push_back(index);
+    }
+
+    if (output_.size() >= kOutputBufferSize)
+      WriteOutput();
+  }
+
+  // Serializes the events of the chunk at |index| that were not serialized
+  // yet. Returns true if all of them have been.
+  bool WriteChunk(size_t index, bool write_all_events) {
+    const TraceBufferChunk* chunk = chunks_[index];
+    uint64 written_events = written_events_[index];
+    bool all_written = true;
+    for (size_t i = 0; i < chunk->size(); ++i) {
+      const uint64 event_bit = static_cast<uint64>(1) << i;
+      if (written_events & event_bit)
+        continue;
+      const TraceEvent* event = chunk->GetEventAt(i);
+      if (!write_all_events &&
+          event->phase() == TRACE_EVENT_PHASE_COMPLETE &&
+          event->duration().ToInternalValue() == -1) {
+        all_written = false;
+        continue;
+      }
+      writer_.AppendEvent(*event, &output_);
+      written_events |= event_bit;
+    }
+    written_events_[index] = written_events;
+    return all_written;
+  }
+
+  // Hands the serialized output to |file_writer_|.
+  void WriteOutput() {
+    if (output_.empty())
+      return;
+    file_writer_.Write(&output_);
+    output_.reserve(kOutputBufferSize);
+  }
+
+  size_t max_chunks_;
+  ScopedVector<TraceBufferChunk> chunks_;
+  uint32 current_chunk_seq_;
+
+  // For each chunk, a bit for each of its events that has been serialized.
+  std::vector<uint64> written_events_;
+
+  // The chunks that have been returned and not serialized, oldest first.
+  std::deque<size_t> returned_chunk_indices_;
+  // The chunks with complete events that had not ended when the other events
+  // were serialized.
+  std::vector<size_t> unfinished_chunk_indices_;
+  // The serialized chunks, which can be reused.
+  std::vector<size_t> free_chunk_indices_;
+
+  TraceFileWriter file_writer_;
+  TraceBinaryWriter writer_;
+  std::string output_;
+  bool finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBufferStreaming);
+};
+
 }  // namespace
 
 TraceBufferChunk::TraceBufferChunk(uint32 seq) : next_free_(0), seq_(seq) {}
@@ -392,5 +678,13 @@ TraceBuffer* TraceBuffer::CreateTraceBufferVectorOfSize(size_t max_chunks) {
   return new TraceBufferVector(max_chunks);
 }
 
+TraceBuffer* TraceBuffer::CreateTraceBufferStreaming(
+    size_t max_chunks,
+    File file,
+    const ArgumentFilterPredicate& argument_filter_predicate) {
+  return new TraceBufferStreaming(max_chunks, file.Pass(),
+                                  argument_filter_predicate);
+}
+
 }  // namespace trace_event
 }  // namespace base
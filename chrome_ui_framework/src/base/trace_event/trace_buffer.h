@@ -6,6 +6,7 @@
 #define BASE_TRACE_EVENT_TRACE_BUFFER_H_
 
 #include "base/base_export.h"
+#include "base/files/file.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_impl.h"
 
@@ -79,6 +80,15 @@ class BASE_EXPORT TraceBuffer {
 
   static TraceBuffer* CreateTraceBufferRingBuffer(size_t max_chunks);
   static TraceBuffer* CreateTraceBufferVectorOfSize(size_t max_chunks);
+  // Writes the events to |file| in the binary trace format as the buffer
+  // fills up, keeping about |max_chunks| chunks in memory. The arguments of
+  // the events for which |argument_filter_predicate| returns false are
+  // stripped. The buffer is never full. Iterating it writes the rest of the
+  // events and returns no chunks.
+  static TraceBuffer* CreateTraceBufferStreaming(
+      size_t max_chunks,
+      File file,
+      const ArgumentFilterPredicate& argument_filter_predicate);
 };
 
 // TraceResultBuffer collects and converts trace fragments returned by TraceLog
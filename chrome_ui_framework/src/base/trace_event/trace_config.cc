@@ -27,12 +27,14 @@ const char kTraceToConsole[] = "trace-to-console";
 const char kEnableSampling[] = "enable-sampling";
 const char kEnableSystrace[] = "enable-systrace";
 const char kEnableArgumentFilter[] = "enable-argument-filter";
+const char kEnablePerThreadBuffers[] = "enable-per-thread-buffers";
 
 // String parameters that can be used to parse the trace config string.
 const char kRecordModeParam[] = "record_mode";
 const char kEnableSamplingParam[] = "enable_sampling";
 const char kEnableSystraceParam[] = "enable_systrace";
 const char kEnableArgumentFilterParam[] = "enable_argument_filter";
+const char kEnablePerThreadBuffersParam[] = "enable_per_thread_buffers";
 const char kIncludedCategoriesParam[] = "included_categories";
 const char kExcludedCategoriesParam[] = "excluded_categories";
 const char kSyntheticDelaysParam[] = "synthetic_delays";
@@ -99,6 +101,7 @@ TraceConfig::TraceConfig(const TraceConfig& tc)
       enable_sampling_(tc.enable_sampling_),
       enable_systrace_(tc.enable_systrace_),
       enable_argument_filter_(tc.enable_argument_filter_),
+      enable_per_thread_buffers_(tc.enable_per_thread_buffers_),
       memory_dump_config_(tc.memory_dump_config_),
       included_categories_(tc.included_categories_),
       disabled_categories_(tc.disabled_categories_),
@@ -116,6 +119,7 @@ TraceConfig& TraceConfig::operator=(const TraceConfig& rhs) {
   enable_sampling_ = rhs.enable_sampling_;
   enable_systrace_ = rhs.enable_systrace_;
   enable_argument_filter_ = rhs.enable_argument_filter_;
+  enable_per_thread_buffers_ = rhs.enable_per_thread_buffers_;
   memory_dump_config_ = rhs.memory_dump_config_;
   included_categories_ = rhs.included_categories_;
   disabled_categories_ = rhs.disabled_categories_;
@@ -209,7 +213,8 @@ void TraceConfig::Merge(const TraceConfig& config) {
   if (record_mode_ != config.record_mode_
       || enable_sampling_ != config.enable_sampling_
       || enable_systrace_ != config.enable_systrace_
-      || enable_argument_filter_ != config.enable_argument_filter_) {
+      || enable_argument_filter_ != config.enable_argument_filter_
+      || enable_per_thread_buffers_ != config.enable_per_thread_buffers_) {
     DLOG(ERROR) << "Attempting to merge trace config with a different "
                 << "set of options.";
   }
@@ -245,6 +250,7 @@ void TraceConfig::Clear() {
   enable_sampling_ = false;
   enable_systrace_ = false;
   enable_argument_filter_ = false;
+  enable_per_thread_buffers_ = false;
   included_categories_.clear();
   disabled_categories_.clear();
   excluded_categories_.clear();
@@ -257,6 +263,7 @@ void TraceConfig::InitializeDefault() {
   enable_sampling_ = false;
   enable_systrace_ = false;
   enable_argument_filter_ = false;
+  enable_per_thread_buffers_ = false;
   excluded_categories_.push_back("*Debug");
   excluded_categories_.push_back("*Test");
 }
@@ -302,6 +309,13 @@ void TraceConfig::InitializeFromConfigString(const std::string& config_string) {
   else
     enable_argument_filter_ = enable_argument_filter;
 
+  bool enable_per_thread_buffers;
+  if (!dict->GetBoolean(kEnablePerThreadBuffersParam,
+                        &enable_per_thread_buffers))
+    enable_per_thread_buffers_ = false;
+  else
+    enable_per_thread_buffers_ = enable_per_thread_buffers;
+
   base::ListValue* category_list = nullptr;
   if (dict->GetList(kIncludedCategoriesParam, &category_list))
     SetCategoriesFromIncludedList(*category_list);
@@ -363,6 +377,7 @@ void TraceConfig::InitializeFromStrings(
   enable_sampling_ = false;
   enable_systrace_ = false;
   enable_argument_filter_ = false;
+  enable_per_thread_buffers_ = false;
   if(!trace_options_string.empty()) {
     std::vector<std::string> split = base::SplitString(
         trace_options_string, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
@@ -382,6 +397,8 @@ void TraceConfig::InitializeFromStrings(
         enable_systrace_ = true;
       } else if (*iter == kEnableArgumentFilter) {
         enable_argument_filter_ = true;
+      } else if (*iter == kEnablePerThreadBuffers) {
+        enable_per_thread_buffers_ = true;
       }
     }
   }
@@ -518,6 +535,11 @@ void TraceConfig::ToDict(base::DictionaryValue& dict) const {
   else
     dict.SetBoolean(kEnableArgumentFilterParam, false);
 
+  // Only written when set, so that the strings of existing configs do not
+  // change.
+  if (enable_per_thread_buffers_)
+    dict.SetBoolean(kEnablePerThreadBuffersParam, true);
+
   StringList categories(included_categories_);
   categories.insert(categories.end(),
                     disabled_categories_.begin(),
@@ -571,6 +593,8 @@ std::string TraceConfig::ToTraceOptionsString() const {
     ret = ret + "," + kEnableSystrace;
   if (enable_argument_filter_)
     ret = ret + "," + kEnableArgumentFilter;
+  if (enable_per_thread_buffers_)
+    ret = ret + "," + kEnablePerThreadBuffers;
   return ret;
 }
 
@@ -77,6 +77,14 @@ TEST(TraceConfigTest, TraceConfigFromValidLegacyFormat) {
   EXPECT_STREQ("record-as-much-as-possible,enable-argument-filter",
                config.ToTraceOptionsString().c_str());
 
+  config = TraceConfig("", "enable-per-thread-buffers,record-continuously");
+  EXPECT_EQ(RECORD_CONTINUOUSLY, config.GetTraceRecordMode());
+  EXPECT_FALSE(config.IsArgumentFilterEnabled());
+  EXPECT_TRUE(config.ArePerThreadBuffersEnabled());
+  EXPECT_STREQ("record-continuously,enable-per-thread-buffers",
+               config.ToTraceOptionsString().c_str());
+  EXPECT_TRUE(TraceConfig(config.ToString()).ArePerThreadBuffersEnabled());
+
   config = TraceConfig(
     "",
     "enable-systrace,trace-to-console,enable-sampling,enable-argument-filter");
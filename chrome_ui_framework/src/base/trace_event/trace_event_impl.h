@@ -130,8 +130,18 @@ class BASE_EXPORT TraceEvent {
   TimeDelta thread_duration() const { return thread_duration_; }
   unsigned long long id() const { return id_; }
   unsigned long long context_id() const { return context_id_; }
+  unsigned long long bind_id() const { return bind_id_; }
   unsigned int flags() const { return flags_; }
 
+  // The arguments, up to the first NULL name. The names and string values
+  // point into parameter_copy_storage() when they were copied.
+  const char* arg_name(int index) const { return arg_names_[index]; }
+  unsigned char arg_type(int index) const { return arg_types_[index]; }
+  TraceValue arg_value(int index) const { return arg_values_[index]; }
+  const ConvertableToTraceFormat* convertable_value(int index) const {
+    return convertable_values_[index].get();
+  }
+
   // Exposed for unittesting:
 
   const base::RefCountedString* parameter_copy_storage() const {
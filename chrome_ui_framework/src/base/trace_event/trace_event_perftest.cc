@@ -0,0 +1,222 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_binary_format.h"
+#include "base/trace_event/trace_event.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const int kEventsPerThread = 20000;
+const int kSerializedEvents = 200000;
+
+// Waits for |start_event|, then adds kEventsPerThread complete events.
+void AddTraceEvents(WaitableEvent* start_event) {
+  start_event->Wait();
+  for (int i = 0; i < kEventsPerThread; ++i) {
+    TRACE_EVENT1("perftest", "event", "index", i);
+  }
+}
+
+// Adds the events on a thread without a message loop.
+class AddTraceEventsDelegate : public PlatformThread::Delegate {
+ public:
+  explicit AddTraceEventsDelegate(WaitableEvent* start_event)
+      : start_event_(start_event) {}
+  ~AddTraceEventsDelegate() override {}
+
+  void ThreadMain() override { AddTraceEvents(start_event_); }
+
+ private:
+  WaitableEvent* start_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddTraceEventsDelegate);
+};
+
+class TraceEventPerfTest : public testing::TestWithParam<int> {
+ public:
+  TraceEventPerfTest() {}
+
+ protected:
+  // Adds the events on GetParam() threads at once with |trace_options|, and
+  // prints the average wall time per event. The threads have message loops,
+  // and so thread local event buffers, if |with_message_loops|.
+  void TimeAddTraceEvents(const std::string& trace,
+                          const std::string& trace_options,
+                          bool with_message_loops) {
+    const int thread_count = GetParam();
+    WaitableEvent start_event(true, false);
+    ScopedVector<Thread> threads;
+    ScopedVector<AddTraceEventsDelegate> delegates;
+    std::vector<PlatformThreadHandle> handles(thread_count);
+
+    TraceLog::GetInstance()->SetEnabled(TraceConfig("perftest", trace_options),
+                                        TraceLog::RECORDING_MODE);
+    for (int i = 0; i < thread_count; ++i) {
+      if (with_message_loops) {
+        threads.push_back(new Thread("TraceEventPerfTest"));
+        ASSERT_TRUE(threads.back()->Start());
+        threads.back()->task_runner()->PostTask(
+            FROM_HERE, Bind(&AddTraceEvents, &start_event));
+      } else {
+        delegates.push_back(new AddTraceEventsDelegate(&start_event));
+        ASSERT_TRUE(PlatformThread::Create(0, delegates.back(), &handles[i]));
+      }
+    }
+
+    const TimeTicks start = TimeTicks::Now();
+    start_event.Signal();
+    for (int i = 0; i < thread_count; ++i) {
+      if (with_message_loops)
+        threads[i]->Stop();
+      else
+        PlatformThread::Join(handles[i]);
+    }
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    // No thread is left to flush, so this returns at once.
+    TraceLog::GetInstance()->CancelTracing(TraceLog::OutputCallback());
+
+    perf_test::PrintResult(
+        "trace_event_overhead", IntToString(thread_count) + "_threads", trace,
+        elapsed.InSecondsF() * 1e9 / (thread_count * kEventsPerThread),
+        "ns/event", true);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TraceEventPerfTest);
+};
+
+// Fills |events| with a mix of the events that are common in traces: nested
+// complete events with an argument, instant events with a string argument,
+// and counters, on a few threads, with some copied names.
+void MakeTraceEvents(ScopedVector<TraceEvent>* events) {
+  const char* const kNames[] = {"MessageLoop::RunTask", "Layer::Draw",
+                                "ResourceLoader::OnReadCompleted",
+                                "ThreadProxy::BeginMainFrame"};
+  const char* arg_names[] = {"src_file", "src_func"};
+  const unsigned char kIntTypes[] = {TRACE_VALUE_TYPE_INT,
+                                     TRACE_VALUE_TYPE_INT};
+  const unsigned char kStringTypes[] = {TRACE_VALUE_TYPE_STRING};
+  const unsigned char* category =
+      TraceLog::GetCategoryGroupEnabled("toplevel,disabled-by-default-gpu");
+  TraceEvent::TraceValue string_value;
+  string_value.as_string = "../../base/message_loop/message_loop.cc";
+  int64 timestamp = 1000000000;
+  for (int i = 0; i < kSerializedEvents; ++i) {
+    timestamp += 1 + i % 97;
+    TraceEvent* event = new TraceEvent;
+    const char* name = kNames[i % arraysize(kNames)];
+    const int thread_id = 1000 + i % 7;
+    const unsigned int flags = i % 10 ? 0 : TRACE_EVENT_FLAG_COPY;
+    unsigned long long arg_values[] = {static_cast<unsigned long long>(i),
+                                       string_value.as_uint};
+    switch (i % 3) {
+      case 0:
+        event->Initialize(thread_id, TraceTicks::FromInternalValue(timestamp),
+                          ThreadTicks::FromInternalValue(timestamp / 2),
+                          TRACE_EVENT_PHASE_COMPLETE, category, name, 0, 0, 0,
+                          1, arg_names, kIntTypes, arg_values, NULL, flags);
+        event->UpdateDuration(
+            TraceTicks::FromInternalValue(timestamp + 50 + i % 1000),
+            ThreadTicks::FromInternalValue(timestamp / 2 + 10));
+        break;
+      case 1:
+        event->Initialize(thread_id, TraceTicks::FromInternalValue(timestamp),
+                          ThreadTicks(), TRACE_EVENT_PHASE_INSTANT, category,
+                          name, 0, 0, 0, 1, arg_names, kStringTypes,
+                          &arg_values[1], NULL,
+                          flags | TRACE_EVENT_SCOPE_THREAD);
+        break;
+      case 2:
+        event->Initialize(thread_id, TraceTicks::FromInternalValue(timestamp),
+                          ThreadTicks(), TRACE_EVENT_PHASE_COUNTER, category,
+                          name, 0, 0, 0, 2, arg_names, kIntTypes, arg_values,
+                          NULL, flags);
+        break;
+    }
+    events->push_back(event);
+  }
+}
+
+}  // namespace
+
+// Compares the size of a trace and the time it takes to serialize it in JSON
+// and in the binary trace format, and the time it takes to convert the
+// binary trace to JSON.
+TEST(TraceBinaryFormatPerfTest, Serialize) {
+  ScopedVector<TraceEvent> events;
+  MakeTraceEvents(&events);
+
+  std::string json;
+  TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < events.size(); ++i) {
+    if (i)
+      json += ",\n";
+    events[i]->AppendAsJSON(&json, ArgumentFilterPredicate());
+  }
+  const TimeDelta json_time = TimeTicks::Now() - start;
+
+  std::string binary;
+  start = TimeTicks::Now();
+  TraceBinaryWriter::AppendHeader(&binary);
+  TraceBinaryWriter writer((ArgumentFilterPredicate()));
+  for (size_t i = 0; i < events.size(); ++i)
+    writer.AppendEvent(*events[i], &binary);
+  const TimeDelta binary_time = TimeTicks::Now() - start;
+
+  std::string converted;
+  start = TimeTicks::Now();
+  ASSERT_TRUE(ConvertBinaryTraceToJSON(binary, &converted));
+  const TimeDelta convert_time = TimeTicks::Now() - start;
+  EXPECT_EQ(json, converted);
+
+  perf_test::PrintResult("trace_size", "", "json", json.size() / 1024, "KB",
+                         true);
+  perf_test::PrintResult("trace_size", "", "binary", binary.size() / 1024,
+                         "KB", true);
+  perf_test::PrintResult("trace_serialize_time", "", "json",
+                         json_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("trace_serialize_time", "", "binary",
+                         binary_time.InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("trace_binary_to_json_time", "", "binary",
+                         convert_time.InMillisecondsF(), "ms", false);
+}
+
+// Compares the per-event cost of the locked chunk shared by threads without
+// message loops, the thread local event buffers of threads with message
+// loops, and per-thread buffers, as more threads add events at once. The wall
+// time per event goes down as threads are added on as many cores, unless the
+// threads contend.
+TEST_P(TraceEventPerfTest, AddTraceEvent) {
+  TimeAddTraceEvents("shared_chunk", "record-continuously", false);
+  TimeAddTraceEvents("thread_local_buffer", "record-continuously", true);
+  TimeAddTraceEvents("per_thread_buffers",
+                     "record-continuously,enable-per-thread-buffers", false);
+  TimeAddTraceEvents("per_thread_buffers_with_message_loops",
+                     "record-continuously,enable-per-thread-buffers", true);
+}
+
+INSTANTIATE_TEST_CASE_P(TraceEventPerfTests,
+                        TraceEventPerfTest,
+                        testing::Values(1, 2, 4, 8, 16, 32));
+
+}  // namespace trace_event
+}  // namespace base
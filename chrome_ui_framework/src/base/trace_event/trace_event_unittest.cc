@@ -7,6 +7,8 @@
 
 #include "base/bind.h"
 #include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
 #include "base/location.h"
@@ -21,6 +23,7 @@
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
 #include "base/time/time.h"
+#include "base/trace_event/trace_binary_format.h"
 #include "base/trace_event/trace_buffer.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_synthetic_delay.h"
@@ -868,6 +871,76 @@ TEST_F(TraceEventTestFixture, DataCaptured) {
   ValidateAllTraceMacrosCreatedData(trace_parsed_);
 }
 
+// Test that the events written to a binary trace file convert to the same
+// events as a JSON trace.
+TEST_F(TraceEventTestFixture, DataCapturedInBinaryTraceFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.path().AppendASCII("trace");
+  TraceLog::GetInstance()->SetBinaryTraceFile(
+      File(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE));
+  TraceLog::GetInstance()->SetEnabled(TraceConfig(kRecordAllCategoryFilter, ""),
+                                      TraceLog::RECORDING_MODE);
+
+  const int num_events = 50000;
+  {
+    // Many more events than the buffer keeps in memory are added before this
+    // ends.
+    TRACE_EVENT0("all", "long complete event");
+    TraceManyInstantEvents(0, num_events, NULL);
+  }
+  TraceWithAllMacroVariants(NULL);
+
+  EndTraceAndFlush();
+  EXPECT_EQ(0u, trace_parsed_.GetSize());
+
+  std::string binary_trace;
+  ASSERT_TRUE(ReadFileToString(path, &binary_trace));
+  std::string json;
+  ASSERT_TRUE(ConvertBinaryTraceToJSON(binary_trace, &json));
+  EXPECT_LT(binary_trace.size() * 4, json.size());
+  WaitableEvent flush_complete_event(false, false);
+  OnTraceDataCollected(&flush_complete_event,
+                       make_scoped_refptr(RefCountedString::TakeString(&json)),
+                       false);
+
+  ValidateAllTraceMacrosCreatedData(trace_parsed_);
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_, 1, num_events);
+  const DictionaryValue* item = FindNamePhase("long complete event", "X");
+  ASSERT_TRUE(item);
+  EXPECT_TRUE(item->HasKey("dur"));
+
+  // The next trace is kept in memory again.
+  Clear();
+  BeginTrace();
+  TRACE_EVENT_INSTANT0("all", "in memory", TRACE_EVENT_SCOPE_THREAD);
+  EndTraceAndFlush();
+  EXPECT_TRUE(FindNamePhase("in memory", "I"));
+}
+
+// Test that monitoring mode ignores the binary trace file, since it flushes
+// copies of the events that are kept in memory.
+TEST_F(TraceEventTestFixture, BinaryTraceFileNotUsedForMonitoring) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.path().AppendASCII("trace");
+  TraceLog::GetInstance()->SetBinaryTraceFile(
+      File(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE));
+  TraceLog::GetInstance()->SetEnabled(
+    TraceConfig(kRecordAllCategoryFilter, "record-until-full,enable-sampling"),
+    TraceLog::MONITORING_MODE);
+
+  TRACE_EVENT_SET_SAMPLING_STATE_FOR_BUCKET(1, "category", "AAA");
+  TraceLog::GetInstance()->WaitSamplingEventForTesting();
+  FlushMonitoring();
+  EXPECT_TRUE(FindNamePhase("AAA", "P"));
+
+  TraceLog::GetInstance()->SetDisabled();
+  int64 file_size = -1;
+  ASSERT_TRUE(GetFileSize(path, &file_size));
+  EXPECT_EQ(0, file_size);
+}
+
 // Emit some events and validate that only empty strings are received
 // if we tell Flush() to discard events.
 TEST_F(TraceEventTestFixture, DataDiscarded) {
@@ -1480,6 +1553,169 @@ TEST_F(TraceEventTestFixture, DataCapturedManyThreads) {
   }
 }
 
+TEST_F(TraceEventTestFixture, DataCapturedWithPerThreadBuffers) {
+  TraceLog::GetInstance()->SetEnabled(
+      TraceConfig(kRecordAllCategoryFilter, "enable-per-thread-buffers"),
+      TraceLog::RECORDING_MODE);
+
+  TraceWithAllMacroVariants(NULL);
+
+  EndTraceAndFlush();
+
+  ValidateAllTraceMacrosCreatedData(trace_parsed_);
+}
+
+// Adds instant events, inside of a complete event, on a thread without a
+// message loop. Then waits for |exit_event|, if any, before the thread ends.
+class TraceManyInstantEventsDelegate : public PlatformThread::Delegate {
+ public:
+  TraceManyInstantEventsDelegate(int thread_id,
+                                 int num_events,
+                                 WaitableEvent* task_complete_event,
+                                 WaitableEvent* exit_event)
+      : thread_id_(thread_id),
+        num_events_(num_events),
+        task_complete_event_(task_complete_event),
+        exit_event_(exit_event) {}
+  ~TraceManyInstantEventsDelegate() override {}
+
+  void ThreadMain() override {
+    {
+      TRACE_EVENT1("all", "many instant events", "thread", thread_id_);
+      TraceManyInstantEvents(thread_id_, num_events_, NULL);
+    }
+    task_complete_event_->Signal();
+    if (exit_event_)
+      exit_event_->Wait();
+  }
+
+ private:
+  int thread_id_;
+  int num_events_;
+  WaitableEvent* task_complete_event_;
+  WaitableEvent* exit_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceManyInstantEventsDelegate);
+};
+
+// Test that the events of threads without message loops are all collected
+// with per-thread buffers, whether the threads end before the flush or not.
+TEST_F(TraceEventTestFixture, DataCapturedManyThreadsWithPerThreadBuffers) {
+  TraceLog::GetInstance()->SetEnabled(
+      TraceConfig(kRecordAllCategoryFilter,
+                  "record-until-full,enable-per-thread-buffers"),
+      TraceLog::RECORDING_MODE);
+
+  const int num_threads = 4;
+  const int num_events = 4000;
+  WaitableEvent exit_event(true, false);
+  scoped_ptr<TraceManyInstantEventsDelegate> delegates[num_threads];
+  scoped_ptr<WaitableEvent> task_complete_events[num_threads];
+  PlatformThreadHandle handles[num_threads];
+  for (int i = 0; i < num_threads; i++) {
+    task_complete_events[i].reset(new WaitableEvent(false, false));
+    delegates[i].reset(new TraceManyInstantEventsDelegate(
+        i, num_events, task_complete_events[i].get(),
+        i % 2 ? &exit_event : NULL));
+    ASSERT_TRUE(PlatformThread::Create(0, delegates[i].get(), &handles[i]));
+  }
+
+  for (int i = 0; i < num_threads; i++)
+    task_complete_events[i]->Wait();
+
+  // Let half of the threads end before flush.
+  for (int i = 0; i < num_threads; i += 2)
+    PlatformThread::Join(handles[i]);
+
+  EndTraceAndFlush();
+
+  // Let the other half of the threads end after flush.
+  exit_event.Signal();
+  for (int i = 1; i < num_threads; i += 2)
+    PlatformThread::Join(handles[i]);
+
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_,
+                                           num_threads, num_events);
+
+  // The complete events were updated after the chunks they are in were handed
+  // over to the trace buffer.
+  int complete_events_with_duration = 0;
+  for (size_t i = 0; i < trace_parsed_.GetSize(); i++) {
+    const DictionaryValue* dict = NULL;
+    std::string name;
+    if (!trace_parsed_.GetDictionary(i, &dict) ||
+        !dict->GetString("name", &name) || name != "many instant events") {
+      continue;
+    }
+    double duration = 0;
+    EXPECT_TRUE(dict->GetDouble("dur", &duration));
+    complete_events_with_duration++;
+  }
+  EXPECT_EQ(num_threads, complete_events_with_duration);
+}
+
+// Test that a ring buffer keeps chunks to recycle when more threads hold
+// per-thread buffers than it has chunks for.
+TEST_F(TraceEventTestFixture, RingBufferWithManyPerThreadBuffers) {
+  TraceLog::GetInstance()->SetEnabled(
+      TraceConfig(kRecordAllCategoryFilter,
+                  "record-continuously,enable-per-thread-buffers"),
+      TraceLog::RECORDING_MODE);
+
+  // The ring buffer has 1000 chunks, and each buffer would take 8.
+  const int num_threads = 160;
+  const int num_events = 100;
+  WaitableEvent exit_event(true, false);
+  scoped_ptr<TraceManyInstantEventsDelegate> delegates[num_threads];
+  scoped_ptr<WaitableEvent> task_complete_events[num_threads];
+  PlatformThreadHandle handles[num_threads];
+  for (int i = 0; i < num_threads; i++) {
+    task_complete_events[i].reset(new WaitableEvent(false, false));
+    delegates[i].reset(new TraceManyInstantEventsDelegate(
+        i, num_events, task_complete_events[i].get(), &exit_event));
+    ASSERT_TRUE(PlatformThread::Create(0, delegates[i].get(), &handles[i]));
+  }
+
+  // All of the threads still hold their buffers.
+  for (int i = 0; i < num_threads; i++)
+    task_complete_events[i]->Wait();
+
+  EndTraceAndFlush();
+
+  exit_event.Signal();
+  for (int i = 0; i < num_threads; i++)
+    PlatformThread::Join(handles[i]);
+
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_,
+                                           num_threads, num_events);
+}
+
+// Test that per-thread buffers start over with each trace.
+TEST_F(TraceEventTestFixture, PerThreadBuffersAcrossTraces) {
+  for (int trace = 0; trace < 3; trace++) {
+    TraceLog::GetInstance()->SetEnabled(
+        TraceConfig(kRecordAllCategoryFilter, "enable-per-thread-buffers"),
+        TraceLog::RECORDING_MODE);
+    TraceManyInstantEvents(trace, 1000, NULL);
+    EndTraceAndFlush();
+
+    int instant_events = 0;
+    for (size_t i = 0; i < trace_parsed_.GetSize(); i++) {
+      const DictionaryValue* dict = NULL;
+      std::string name;
+      int thread = -1;
+      if (trace_parsed_.GetDictionary(i, &dict) &&
+          dict->GetString("name", &name) && name == "multi thread event") {
+        EXPECT_TRUE(dict->GetInteger("args.thread", &thread));
+        EXPECT_EQ(trace, thread);
+        instant_events++;
+      }
+    }
+    EXPECT_EQ(1000, instant_events);
+    Clear();
+  }
+}
+
 // Test that thread and process names show up in the trace
 TEST_F(TraceEventTestFixture, ThreadNames) {
   // Create threads before we enable tracing to make sure
@@ -2698,6 +2934,13 @@ TEST_F(TraceEventTestFixture, ConvertTraceConfigToInternalOptions) {
       trace_log->GetInternalOptionsFromTraceConfig(
           TraceConfig("*",
                       "trace-to-console,enable-sampling,enable-systrace")));
+
+  EXPECT_EQ(
+      TraceLog::kInternalRecordContinuously |
+          TraceLog::kInternalEnablePerThreadBuffers,
+      trace_log->GetInternalOptionsFromTraceConfig(
+          TraceConfig(kRecordAllCategoryFilter,
+                      "record-continuously,enable-per-thread-buffers")));
 }
 
 void SetBlockingFlagAndBlockUntilStopped(WaitableEvent* task_start_event,
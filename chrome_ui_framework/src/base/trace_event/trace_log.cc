@@ -18,6 +18,7 @@
 #include "base/strings/string_split.h"
 #include "base/strings/string_tokenizer.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/cancellation_flag.h"
 #include "base/sys_info.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 #include "base/thread_task_runner_handle.h"
@@ -78,10 +79,25 @@ const size_t kTraceEventRingBufferChunks = kTraceEventVectorBufferChunks / 4;
 const size_t kMonitorTraceEventBufferChunks = 30000 / kTraceBufferChunkSize;
 // ECHO_TO_CONSOLE needs a small buffer to hold the unfinished COMPLETE events.
 const size_t kEchoToConsoleTraceEventBufferChunks = 256;
+// The chunks kept in memory when the events are written to a binary trace
+// file, so that complete events can usually end before they are written.
+const size_t kTraceEventStreamingBufferChunks = 256;
 
 const size_t kTraceEventBufferSizeInBytes = 100 * 1024;
 const int kThreadFlushTimeoutMs = 3000;
 
+// The chunks of a PerThreadEventBuffer. They are taken out of the trace
+// buffer, where ring buffers can't recycle them, so this is kept small next to
+// the size of the smallest ring buffer.
+const size_t kPerThreadEventBufferChunks = 8;
+// All of the per-thread buffers together hold at most this fraction of the
+// chunks of the trace buffer, so that a ring buffer always has chunks to
+// recycle for the threads that add their events with the lock held.
+const size_t kPerThreadEventBufferMaxChunksDivisor = 2;
+// How often the buffer flush thread returns the filled chunks to the trace
+// buffer when no thread is running out of chunks.
+const int kBufferFlushIntervalMs = 100;
+
 #if !defined(OS_NACL)
 // These categories will cause deadlock when ECHO_TO_CONSOLE. crbug.com/325575.
 const char kEchoToConsoleCategoryFilter[] = "-ipc,-task";
@@ -333,6 +349,300 @@ void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
   // find the generation mismatch and delete this buffer soon.
 }
 
+// Holds the events of one thread when per-thread buffers are enabled. The
+// thread adds events to a small ring of chunks without taking |lock_|: the
+// chunks are taken from the trace buffer ahead of time, and once the thread
+// has filled one, the buffer flush thread returns it to the trace buffer and
+// puts an empty one in its place. The two only share the counts of filled and
+// returned chunks, so neither waits for the other, and the events keep the
+// handles they were given. Unlike ThreadLocalEventBuffer, this works on
+// threads without a message loop: the chunk being filled is collected by
+// Flush() itself, after waiting for an event that is being added.
+class TraceLog::PerThreadEventBuffer {
+ public:
+  explicit PerThreadEventBuffer(TraceLog* trace_log);
+  ~PerThreadEventBuffer();
+
+  TraceLog* trace_log() const { return trace_log_; }
+  int generation() const { return generation_; }
+
+  // Called on the thread around adding or updating an event, which keeps
+  // CloseWhileLocked() from taking the chunks in the meantime. BeginWrite()
+  // returns false if the buffer is closed, in which case the event has to go
+  // elsewhere. |lock_| must not be acquired in between.
+  bool BeginWrite();
+  void EndWrite();
+
+  // These are called between BeginWrite() and EndWrite(). AddTraceEvent()
+  // returns NULL when all the chunks are waiting to be flushed, or the trace
+  // buffer had none left; GetEventByHandle() only finds the events of the
+  // chunk being filled.
+  TraceEvent* AddTraceEvent(TraceEventHandle* handle);
+  TraceEvent* GetEventByHandle(TraceEventHandle handle);
+
+  // The following are called with |lock_| held.
+
+  // Fills the buffer with chunks of the trace buffer. Called on the thread.
+  void OpenWhileLocked();
+
+  // Returns the filled chunks to the trace buffer and replaces them.
+  void FlushWhileLocked();
+
+  // Returns all the chunks, including the one being filled, to the trace
+  // buffer, or deletes them if |discard_events| is true or they belong to a
+  // previous trace buffer. New events can't be added until the buffer is
+  // opened again.
+  void CloseWhileLocked(bool discard_events);
+
+  // Finds an event in any of the chunks. Called on the thread, outside of
+  // BeginWrite() and EndWrite().
+  TraceEvent* GetEventByHandleWhileLocked(TraceEventHandle handle);
+
+  void EstimateTraceMemoryOverheadWhileLocked(
+      TraceEventMemoryOverhead* overhead);
+
+ private:
+  struct Slot {
+    scoped_ptr<TraceBufferChunk> chunk;
+    size_t index;
+  };
+
+  size_t filled_chunks() const {
+    return static_cast<size_t>(subtle::Acquire_Load(&filled_chunks_));
+  }
+  size_t flushed_chunks() const {
+    return static_cast<size_t>(subtle::Acquire_Load(&flushed_chunks_));
+  }
+
+  // Takes a chunk of the trace buffer for |slot|, unless the trace buffer is
+  // full or the per-thread buffers already hold their share of its chunks,
+  // in which case the slot is left empty.
+  void GetChunkWhileLocked(Slot* slot);
+  // Accounts for a chunk of |slot| that was returned or deleted.
+  void ReleaseChunkWhileLocked(Slot* slot);
+
+  // Since TraceLog is a leaky singleton, trace_log_ will always be valid
+  // as long as the thread exists.
+  TraceLog* trace_log_;
+  Slot slots_[kPerThreadEventBufferChunks];
+
+  // The number of chunks the thread has filled, and the flush thread has
+  // returned, since the buffer was opened. The thread fills the chunk in
+  // slot |filled_chunks_| % kPerThreadEventBufferChunks unless all of the
+  // slots hold filled chunks. Each count is only written by one side.
+  subtle::AtomicWord filled_chunks_;
+  subtle::AtomicWord flushed_chunks_;
+
+  // Set between BeginWrite() and EndWrite(), and while the buffer is closed.
+  subtle::Atomic32 writing_;
+  subtle::Atomic32 closed_;
+
+  // The generation of the trace buffer the chunks belong to.
+  int generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerThreadEventBuffer);
+};
+
+TraceLog::PerThreadEventBuffer::PerThreadEventBuffer(TraceLog* trace_log)
+    : trace_log_(trace_log),
+      filled_chunks_(0),
+      flushed_chunks_(0),
+      writing_(0),
+      closed_(1),
+      generation_(-1) {}
+
+TraceLog::PerThreadEventBuffer::~PerThreadEventBuffer() {}
+
+bool TraceLog::PerThreadEventBuffer::BeginWrite() {
+  subtle::NoBarrier_Store(&writing_, 1);
+  // Pairs with the barrier in CloseWhileLocked(): either this sees the buffer
+  // closed, or CloseWhileLocked() sees the write and waits for it.
+  subtle::MemoryBarrier();
+  if (!subtle::NoBarrier_Load(&closed_))
+    return true;
+  subtle::Release_Store(&writing_, 0);
+  return false;
+}
+
+void TraceLog::PerThreadEventBuffer::EndWrite() {
+  subtle::Release_Store(&writing_, 0);
+}
+
+TraceEvent* TraceLog::PerThreadEventBuffer::AddTraceEvent(
+    TraceEventHandle* handle) {
+  size_t filled = filled_chunks();
+  const size_t flushed = flushed_chunks();
+  if (filled - flushed == kPerThreadEventBufferChunks)
+    return NULL;
+
+  Slot* slot = &slots_[filled % kPerThreadEventBufferChunks];
+  if (slot->chunk && slot->chunk->IsFull()) {
+    // A chunk is only handed over once the next event needs a new one, so
+    // that its last event has been initialized.
+    subtle::Release_Store(&filled_chunks_, ++filled);
+    if (filled - flushed >= kPerThreadEventBufferChunks / 2)
+      trace_log_->buffer_flush_event_.Signal();
+    if (filled - flushed == kPerThreadEventBufferChunks)
+      return NULL;
+    slot = &slots_[filled % kPerThreadEventBufferChunks];
+  }
+  if (!slot->chunk)
+    return NULL;
+
+  size_t event_index;
+  TraceEvent* trace_event = slot->chunk->AddTraceEvent(&event_index);
+  if (trace_event && handle)
+    MakeHandle(slot->chunk->seq(), slot->index, event_index, handle);
+  return trace_event;
+}
+
+TraceEvent* TraceLog::PerThreadEventBuffer::GetEventByHandle(
+    TraceEventHandle handle) {
+  const size_t filled = filled_chunks();
+  if (filled - flushed_chunks() == kPerThreadEventBufferChunks)
+    return NULL;
+  const Slot& slot = slots_[filled % kPerThreadEventBufferChunks];
+  if (!slot.chunk || handle.chunk_seq != slot.chunk->seq() ||
+      handle.chunk_index != slot.index)
+    return NULL;
+  return slot.chunk->GetEventAt(handle.event_index);
+}
+
+void TraceLog::PerThreadEventBuffer::OpenWhileLocked() {
+  trace_log_->lock_.AssertAcquired();
+  CloseWhileLocked(true);
+
+  TraceBuffer* logged_events = trace_log_->logged_events_.get();
+  for (size_t i = 0; i < kPerThreadEventBufferChunks; ++i) {
+    DCHECK(!slots_[i].chunk);
+    GetChunkWhileLocked(&slots_[i]);
+  }
+  subtle::NoBarrier_Store(&filled_chunks_, 0);
+  subtle::NoBarrier_Store(&flushed_chunks_, 0);
+  generation_ = trace_log_->generation();
+  subtle::Release_Store(&closed_, 0);
+}
+
+void TraceLog::PerThreadEventBuffer::FlushWhileLocked() {
+  trace_log_->lock_.AssertAcquired();
+  if (subtle::NoBarrier_Load(&closed_) ||
+      !trace_log_->CheckGeneration(generation_))
+    return;
+
+  TraceBuffer* logged_events = trace_log_->logged_events_.get();
+  const size_t filled = filled_chunks();
+  for (size_t flushed = flushed_chunks(); flushed != filled; ++flushed) {
+    Slot& slot = slots_[flushed % kPerThreadEventBufferChunks];
+    ReleaseChunkWhileLocked(&slot);
+    logged_events->ReturnChunk(slot.index, slot.chunk.Pass());
+    GetChunkWhileLocked(&slot);
+    // The thread can use the slot again from here.
+    subtle::Release_Store(&flushed_chunks_,
+                          static_cast<subtle::AtomicWord>(flushed + 1));
+  }
+}
+
+void TraceLog::PerThreadEventBuffer::CloseWhileLocked(bool discard_events) {
+  trace_log_->lock_.AssertAcquired();
+  if (subtle::NoBarrier_Load(&closed_))
+    return;
+
+  subtle::NoBarrier_Store(&closed_, 1);
+  subtle::MemoryBarrier();
+  // The thread may be adding an event to the chunk being filled. It only does
+  // so for a short while, and without taking |lock_|.
+  while (subtle::Acquire_Load(&writing_))
+    PlatformThread::YieldCurrentThread();
+
+  const bool keep_events =
+      !discard_events && trace_log_->CheckGeneration(generation_);
+  // Return the chunks in the order they were filled.
+  const size_t flushed = flushed_chunks();
+  for (size_t i = 0; i < kPerThreadEventBufferChunks; ++i) {
+    Slot& slot = slots_[(flushed + i) % kPerThreadEventBufferChunks];
+    if (!slot.chunk)
+      continue;
+    ReleaseChunkWhileLocked(&slot);
+    if (keep_events)
+      trace_log_->logged_events_->ReturnChunk(slot.index, slot.chunk.Pass());
+    else
+      slot.chunk.reset();
+  }
+}
+
+void TraceLog::PerThreadEventBuffer::GetChunkWhileLocked(Slot* slot) {
+  DCHECK(!slot->chunk);
+  TraceBuffer* logged_events = trace_log_->logged_events_.get();
+  const size_t max_chunks =
+      logged_events->Capacity() / TraceBufferChunk::kTraceBufferChunkSize /
+      kPerThreadEventBufferMaxChunksDivisor;
+  if (logged_events->IsFull() ||
+      trace_log_->per_thread_event_buffer_chunks_ >= max_chunks) {
+    return;
+  }
+  slot->chunk = logged_events->GetChunk(&slot->index);
+  if (slot->chunk)
+    trace_log_->per_thread_event_buffer_chunks_++;
+}
+
+void TraceLog::PerThreadEventBuffer::ReleaseChunkWhileLocked(Slot* slot) {
+  DCHECK(slot->chunk);
+  DCHECK_GT(trace_log_->per_thread_event_buffer_chunks_, 0u);
+  trace_log_->per_thread_event_buffer_chunks_--;
+}
+
+TraceEvent* TraceLog::PerThreadEventBuffer::GetEventByHandleWhileLocked(
+    TraceEventHandle handle) {
+  for (size_t i = 0; i < kPerThreadEventBufferChunks; ++i) {
+    const Slot& slot = slots_[i];
+    if (slot.chunk && handle.chunk_seq == slot.chunk->seq() &&
+        handle.chunk_index == slot.index) {
+      return slot.chunk->GetEventAt(handle.event_index);
+    }
+  }
+  return NULL;
+}
+
+void TraceLog::PerThreadEventBuffer::EstimateTraceMemoryOverheadWhileLocked(
+    TraceEventMemoryOverhead* overhead) {
+  // The events can't be looked at, since the thread may be adding one.
+  overhead->Add("PerThreadEventBuffer", sizeof(*this));
+  for (size_t i = 0; i < kPerThreadEventBufferChunks; ++i) {
+    if (slots_[i].chunk)
+      overhead->Add("TraceBufferChunk", sizeof(TraceBufferChunk));
+  }
+}
+
+// Returns the chunks filled by the threads with per-thread buffers to the
+// trace buffer, when one of them is running out of chunks and at least every
+// kBufferFlushIntervalMs.
+class TraceLog::BufferFlushThread : public PlatformThread::Delegate {
+ public:
+  explicit BufferFlushThread(TraceLog* trace_log) : trace_log_(trace_log) {}
+  ~BufferFlushThread() override {}
+
+  // PlatformThread::Delegate:
+  void ThreadMain() override {
+    PlatformThread::SetName("TraceBufferFlushThread");
+    while (!cancellation_flag_.IsSet()) {
+      trace_log_->buffer_flush_event_.TimedWait(
+          TimeDelta::FromMilliseconds(kBufferFlushIntervalMs));
+      trace_log_->FlushPerThreadEventBuffers();
+    }
+  }
+
+  void Stop() {
+    cancellation_flag_.Set();
+    trace_log_->buffer_flush_event_.Signal();
+  }
+
+ private:
+  TraceLog* trace_log_;
+  CancellationFlag cancellation_flag_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferFlushThread);
+};
+
 TraceLogStatus::TraceLogStatus() : event_capacity(0), event_count(0) {}
 
 TraceLogStatus::~TraceLogStatus() {}
@@ -355,6 +665,10 @@ TraceLog::TraceLog()
       sampling_thread_handle_(0),
       trace_config_(TraceConfig()),
       event_callback_trace_config_(TraceConfig()),
+      per_thread_event_buffer_(&TraceLog::OnPerThreadEventBufferThreadExit),
+      buffer_flush_thread_handle_(0),
+      buffer_flush_event_(false, false),
+      per_thread_event_buffer_chunks_(0),
       thread_shared_chunk_index_(0),
       generation_(0),
       use_worker_thread_(false) {
@@ -398,7 +712,11 @@ TraceLog::TraceLog()
   MemoryDumpManager::GetInstance()->RegisterDumpProvider(this);
 }
 
-TraceLog::~TraceLog() {}
+TraceLog::~TraceLog() {
+  // The buffers are deleted with |per_thread_event_buffers_|, so their threads
+  // must not try to delete them as well.
+  per_thread_event_buffer_.Free();
+}
 
 void TraceLog::InitializeThreadLocalEventBufferIfSupported() {
   // A ThreadLocalEventBuffer needs the message loop
@@ -414,7 +732,8 @@ void TraceLog::InitializeThreadLocalEventBufferIfSupported() {
     delete thread_local_event_buffer;
     thread_local_event_buffer = NULL;
   }
-  if (!thread_local_event_buffer) {
+  if (!thread_local_event_buffer &&
+      !(trace_options() & kInternalEnablePerThreadBuffers)) {
     thread_local_event_buffer = new ThreadLocalEventBuffer(this);
     thread_local_event_buffer_.Set(thread_local_event_buffer);
   }
@@ -430,6 +749,8 @@ bool TraceLog::OnMemoryDump(const MemoryDumpArgs& args,
     AutoLock lock(lock_);
     if (logged_events_)
       logged_events_->EstimateTraceMemoryOverhead(&overhead);
+    for (PerThreadEventBuffer* buffer : per_thread_event_buffers_)
+      buffer->EstimateTraceMemoryOverheadWhileLocked(&overhead);
   }
   overhead.AddSelf();
   overhead.DumpInto("tracing/main_trace_log", pmd);
@@ -615,7 +936,14 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
 
     mode_ = mode;
 
-    if (new_options != old_options) {
+    // Monitoring mode copies the buffer on every flush, which a streaming
+    // buffer cannot do since most of its events are only on disk.
+    if (mode_ == MONITORING_MODE && binary_trace_file_.IsValid()) {
+      DLOG(ERROR) << "Cannot write a binary trace file in monitoring mode.";
+      binary_trace_file_.Close();
+    }
+
+    if (new_options != old_options || binary_trace_file_.IsValid()) {
       subtle::NoBarrier_Store(&trace_options_, new_options);
       UseNextTraceBuffer();
     }
@@ -643,6 +971,14 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
       }
     }
 
+    if (new_options & kInternalEnablePerThreadBuffers) {
+      buffer_flush_thread_.reset(new BufferFlushThread(this));
+      if (!PlatformThread::Create(0, buffer_flush_thread_.get(),
+                                  &buffer_flush_thread_handle_)) {
+        DCHECK(false) << "failed to create thread";
+      }
+    }
+
     dispatching_to_observer_list_ = true;
     observer_list = enabled_state_observer_list_;
   }
@@ -670,6 +1006,8 @@ TraceLog::InternalTraceOptions TraceLog::GetInternalOptionsFromTraceConfig(
       config.IsSamplingEnabled() ? kInternalEnableSampling : kInternalNone;
   if (config.IsArgumentFilterEnabled())
     ret |= kInternalEnableArgumentFilter;
+  if (config.ArePerThreadBuffersEnabled())
+    ret |= kInternalEnablePerThreadBuffers;
   switch (config.GetTraceRecordMode()) {
     case RECORD_UNTIL_FULL:
       return ret | kInternalRecordUntilFull;
@@ -718,6 +1056,17 @@ void TraceLog::SetDisabledWhileLocked() {
     sampling_thread_.reset();
   }
 
+  if (buffer_flush_thread_) {
+    // Stop the buffer flush thread. The last chunks of the per-thread buffers
+    // are collected by Flush().
+    buffer_flush_thread_->Stop();
+    lock_.Release();
+    PlatformThread::Join(buffer_flush_thread_handle_);
+    lock_.Acquire();
+    buffer_flush_thread_handle_ = PlatformThreadHandle();
+    buffer_flush_thread_.reset();
+  }
+
   trace_config_.Clear();
   subtle::NoBarrier_Store(&watch_category_, 0);
   watch_event_name_ = "";
@@ -853,6 +1202,12 @@ void TraceLog::CancelTracing(const OutputCallback& cb) {
   FlushInternal(cb, false, true);
 }
 
+void TraceLog::SetBinaryTraceFile(File file) {
+  AutoLock lock(lock_);
+  DCHECK(!IsEnabled());
+  binary_trace_file_ = file.Pass();
+}
+
 void TraceLog::FlushInternal(const TraceLog::OutputCallback& cb,
                              bool use_worker_thread,
                              bool discard_events) {
@@ -882,6 +1237,9 @@ void TraceLog::FlushInternal(const TraceLog::OutputCallback& cb,
     DCHECK_IMPLIES(thread_message_loops_.size(), flush_task_runner_);
     flush_output_callback_ = cb;
 
+    for (PerThreadEventBuffer* buffer : per_thread_event_buffers_)
+      buffer->CloseWhileLocked(false);
+
     if (thread_shared_chunk_) {
       logged_events_->ReturnChunk(thread_shared_chunk_index_,
                                   thread_shared_chunk_.Pass());
@@ -1038,6 +1396,8 @@ void TraceLog::FlushButLeaveBufferIntact(
   {
     AutoLock lock(lock_);
     AddMetadataEventsWhileLocked();
+    for (PerThreadEventBuffer* buffer : per_thread_event_buffers_)
+      buffer->FlushWhileLocked();
     if (thread_shared_chunk_) {
       // Return the chunk to the main buffer to flush the sampling data.
       logged_events_->ReturnChunk(thread_shared_chunk_index_,
@@ -1057,6 +1417,11 @@ void TraceLog::FlushButLeaveBufferIntact(
 }
 
 void TraceLog::UseNextTraceBuffer() {
+  // The chunks of the per-thread buffers come from |logged_events_|. The
+  // threads open their buffers again with their next events.
+  for (PerThreadEventBuffer* buffer : per_thread_event_buffers_)
+    buffer->CloseWhileLocked(true);
+  DCHECK_EQ(0u, per_thread_event_buffer_chunks_);
   logged_events_.reset(CreateTraceBuffer());
   subtle::NoBarrier_AtomicIncrement(&generation_, 1);
   thread_shared_chunk_.reset();
@@ -1251,10 +1616,22 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
   std::string console_message;
   if (*category_group_enabled &
       (ENABLED_FOR_RECORDING | ENABLED_FOR_MONITORING)) {
+    PerThreadEventBuffer* per_thread_event_buffer = GetPerThreadEventBuffer();
     OptionalAutoLock lock(&lock_);
 
+    // The per-thread buffer is used without the lock when it has room.
     TraceEvent* trace_event = NULL;
-    if (thread_local_event_buffer) {
+    bool writing_per_thread_event_buffer = false;
+    if (per_thread_event_buffer && per_thread_event_buffer->BeginWrite()) {
+      trace_event = per_thread_event_buffer->AddTraceEvent(&handle);
+      if (trace_event)
+        writing_per_thread_event_buffer = true;
+      else
+        per_thread_event_buffer->EndWrite();
+    }
+    if (trace_event) {
+      // Added to the per-thread buffer.
+    } else if (thread_local_event_buffer) {
       trace_event = thread_local_event_buffer->AddTraceEvent(&handle);
     } else {
       lock.EnsureAcquired();
@@ -1288,6 +1665,9 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
           phase == TRACE_EVENT_PHASE_COMPLETE ? TRACE_EVENT_PHASE_BEGIN : phase,
           timestamp, trace_event);
     }
+
+    if (writing_per_thread_event_buffer)
+      per_thread_event_buffer->EndWrite();
   }
 
   if (console_message.size())
@@ -1399,7 +1779,21 @@ void TraceLog::UpdateTraceEventDuration(
   if (*category_group_enabled & ENABLED_FOR_RECORDING) {
     OptionalAutoLock lock(&lock_);
 
-    TraceEvent* trace_event = GetEventByHandleInternal(handle, &lock);
+    // Most events are still in the chunk their thread is filling, which can
+    // be updated without the lock.
+    PerThreadEventBuffer* per_thread_event_buffer =
+        static_cast<PerThreadEventBuffer*>(per_thread_event_buffer_.Get());
+    TraceEvent* trace_event = NULL;
+    bool writing_per_thread_event_buffer = false;
+    if (per_thread_event_buffer && per_thread_event_buffer->BeginWrite()) {
+      trace_event = per_thread_event_buffer->GetEventByHandle(handle);
+      if (trace_event)
+        writing_per_thread_event_buffer = true;
+      else
+        per_thread_event_buffer->EndWrite();
+    }
+    if (!trace_event)
+      trace_event = GetEventByHandleInternal(handle, &lock);
     if (trace_event) {
       DCHECK(trace_event->phase() == TRACE_EVENT_PHASE_COMPLETE);
       trace_event->UpdateDuration(now, thread_now);
@@ -1413,6 +1807,9 @@ void TraceLog::UpdateTraceEventDuration(
           EventToConsoleMessage(TRACE_EVENT_PHASE_END, now, trace_event);
     }
 
+    if (writing_per_thread_event_buffer)
+      per_thread_event_buffer->EndWrite();
+
     if (base::trace_event::AllocationContextTracker::capture_enabled()) {
       // The corresponding push is in |AddTraceEventWithThreadIdAndTimestamp|.
       base::trace_event::AllocationContextTracker::PopPseudoStackFrame(name);
@@ -1550,6 +1947,15 @@ TraceEvent* TraceLog::GetEventByHandleInternal(TraceEventHandle handle,
   if (lock)
     lock->EnsureAcquired();
 
+  PerThreadEventBuffer* per_thread_event_buffer =
+      static_cast<PerThreadEventBuffer*>(per_thread_event_buffer_.Get());
+  if (per_thread_event_buffer) {
+    TraceEvent* trace_event =
+        per_thread_event_buffer->GetEventByHandleWhileLocked(handle);
+    if (trace_event)
+      return trace_event;
+  }
+
   if (thread_shared_chunk_ &&
       handle.chunk_index == thread_shared_chunk_index_) {
     return handle.chunk_seq == thread_shared_chunk_->seq()
@@ -1560,6 +1966,46 @@ TraceEvent* TraceLog::GetEventByHandleInternal(TraceEventHandle handle,
   return logged_events_->GetEventByHandle(handle);
 }
 
+TraceLog::PerThreadEventBuffer* TraceLog::GetPerThreadEventBuffer() {
+  if (!(trace_options() & kInternalEnablePerThreadBuffers))
+    return NULL;
+
+  PerThreadEventBuffer* buffer =
+      static_cast<PerThreadEventBuffer*>(per_thread_event_buffer_.Get());
+  if (buffer && CheckGeneration(buffer->generation()))
+    return buffer;
+
+  // This is the slow path, taken by the first event of each thread in each
+  // trace buffer.
+  AutoLock lock(lock_);
+  if (!buffer) {
+    buffer = new PerThreadEventBuffer(this);
+    per_thread_event_buffers_.push_back(buffer);
+    per_thread_event_buffer_.Set(buffer);
+  }
+  buffer->OpenWhileLocked();
+  return buffer;
+}
+
+void TraceLog::FlushPerThreadEventBuffers() {
+  AutoLock lock(lock_);
+  for (PerThreadEventBuffer* buffer : per_thread_event_buffers_)
+    buffer->FlushWhileLocked();
+}
+
+// static
+void TraceLog::OnPerThreadEventBufferThreadExit(void* value) {
+  PerThreadEventBuffer* buffer = static_cast<PerThreadEventBuffer*>(value);
+  TraceLog* trace_log = buffer->trace_log();
+  AutoLock lock(trace_log->lock_);
+  buffer->CloseWhileLocked(false);
+  ScopedVector<PerThreadEventBuffer>::iterator it =
+      std::find(trace_log->per_thread_event_buffers_.begin(),
+                trace_log->per_thread_event_buffers_.end(), buffer);
+  DCHECK(it != trace_log->per_thread_event_buffers_.end());
+  trace_log->per_thread_event_buffers_.erase(it);
+}
+
 void TraceLog::SetProcessID(int process_id) {
   process_id_ = process_id;
   // Create a FNV hash from the process ID for XORing.
@@ -1622,6 +2068,12 @@ void TraceLog::SetCurrentThreadBlocksMessageLoop() {
 
 TraceBuffer* TraceLog::CreateTraceBuffer() {
   InternalTraceOptions options = trace_options();
+  if (binary_trace_file_.IsValid()) {
+    return TraceBuffer::CreateTraceBufferStreaming(
+        kTraceEventStreamingBufferChunks, binary_trace_file_.Pass(),
+        options & kInternalEnableArgumentFilter ? argument_filter_predicate_
+                                                : ArgumentFilterPredicate());
+  }
   if (options & kInternalRecordContinuously)
     return TraceBuffer::CreateTraceBufferRingBuffer(
         kTraceEventRingBufferChunks);
@@ -5,7 +5,11 @@
 #ifndef BASE_TRACE_EVENT_TRACE_LOG_H_
 #define BASE_TRACE_EVENT_TRACE_LOG_H_
 
+#include "base/files/file.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread_local_storage.h"
 #include "base/trace_event/memory_dump_provider.h"
 #include "base/trace_event/trace_config.h"
 #include "base/trace_event/trace_event_impl.h"
@@ -64,7 +68,8 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   TraceConfig GetCurrentTraceConfig() const;
 
   // Initializes the thread-local event buffer, if not already initialized and
-  // if the current thread supports that (has a message loop).
+  // if the current thread supports that (has a message loop). Does nothing
+  // when per-thread buffers are enabled, since those are used instead.
   void InitializeThreadLocalEventBufferIfSupported();
 
   // Enables normal tracing (recording trace events in the trace buffer).
@@ -162,6 +167,14 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   // Cancels tracing and discards collected data.
   void CancelTracing(const OutputCallback& cb);
 
+  // Writes the events of the next recording to |file| in the binary trace
+  // format (see trace_binary_format.h) as they are collected, instead of
+  // keeping them in memory until Flush(). Must be called while tracing is
+  // disabled. Flush() then writes the rest of the events, closes the file and
+  // returns no events. ConvertBinaryTraceToJSON() converts the file to JSON.
+  // The file is closed unused if the next recording is in MONITORING_MODE.
+  void SetBinaryTraceFile(File file);
+
   // Called by TRACE_EVENT* macros, don't call this directly.
   // The name parameter is a category group for example:
   // TRACE_EVENT0("renderer,webkit", "WebViewImpl::HandleInputEvent")
@@ -329,6 +342,8 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
       const TraceConfig& config);
 
   class ThreadLocalEventBuffer;
+  class PerThreadEventBuffer;
+  class BufferFlushThread;
   class OptionalAutoLock;
 
   TraceLog();
@@ -356,6 +371,16 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   TraceEvent* GetEventByHandleInternal(TraceEventHandle handle,
                                        OptionalAutoLock* lock);
 
+  // Returns the per-thread buffer of the current thread, opening it for the
+  // current trace buffer if needed, or NULL if per-thread buffers are not
+  // enabled.
+  PerThreadEventBuffer* GetPerThreadEventBuffer();
+  // Returns the chunks filled by the threads to the trace buffer. Called by
+  // the buffer flush thread.
+  void FlushPerThreadEventBuffers();
+  // Keeps the events of a thread that exits, and deletes its buffer.
+  static void OnPerThreadEventBufferThreadExit(void* buffer);
+
   void FlushInternal(const OutputCallback& cb,
                      bool use_worker_thread,
                      bool discard_events);
@@ -393,6 +418,7 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   static const InternalTraceOptions kInternalEnableSampling;
   static const InternalTraceOptions kInternalRecordAsMuchAsPossible;
   static const InternalTraceOptions kInternalEnableArgumentFilter;
+  static const InternalTraceOptions kInternalEnablePerThreadBuffers;
 
   // This lock protects TraceLog member accesses (except for members protected
   // by thread_info_lock_) from arbitrary threads.
@@ -444,6 +470,18 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   ThreadLocalBoolean thread_blocks_message_loop_;
   ThreadLocalBoolean thread_is_in_trace_event_;
 
+  // When per-thread buffers are enabled, every thread that adds an event gets
+  // a PerThreadEventBuffer, which is owned by |per_thread_event_buffers_| and
+  // deleted when the thread exits. The buffer flush thread waits on
+  // |buffer_flush_event_| between flushes of the buffers.
+  ThreadLocalStorage::Slot per_thread_event_buffer_;
+  ScopedVector<PerThreadEventBuffer> per_thread_event_buffers_;
+  scoped_ptr<BufferFlushThread> buffer_flush_thread_;
+  PlatformThreadHandle buffer_flush_thread_handle_;
+  WaitableEvent buffer_flush_event_;
+  // The chunks of |logged_events_| held by the per-thread buffers.
+  size_t per_thread_event_buffer_chunks_;
+
   // Contains the message loops of threads that have had at least one event
   // added into the local event buffer. Not using SingleThreadTaskRunner
   // because we need to know the life time of the message loops.
@@ -461,6 +499,10 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   subtle::AtomicWord generation_;
   bool use_worker_thread_;
 
+  // The file given to SetBinaryTraceFile(), until the next trace buffer is
+  // created with it.
+  File binary_trace_file_;
+
   DISALLOW_COPY_AND_ASSIGN(TraceLog);
 };
 
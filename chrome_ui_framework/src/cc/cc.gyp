@@ -413,6 +413,8 @@
         'raster/gpu_rasterizer.h',
         'raster/gpu_tile_task_worker_pool.cc',
         'raster/gpu_tile_task_worker_pool.h',
+        'raster/image_hijack_canvas.cc',
+        'raster/image_hijack_canvas.h',
         'raster/one_copy_tile_task_worker_pool.cc',
         'raster/one_copy_tile_task_worker_pool.h',
         'raster/raster_buffer.cc',
@@ -106,6 +106,7 @@
       'test/layer_tree_json_parser_unittest.cc',
       'test/ordered_simple_task_runner_unittest.cc',
       'test/test_web_graphics_context_3d_unittest.cc',
+      'tiles/image_decode_controller_unittest.cc',
       'tiles/picture_layer_tiling_set_unittest.cc',
       'tiles/picture_layer_tiling_unittest.cc',
       'tiles/tile_manager_unittest.cc',
@@ -349,6 +350,7 @@
         # Note: sources list duplicated in GN build.
         'layers/layer_perftest.cc',
         'layers/picture_layer_impl_perftest.cc',
+        'output/software_renderer_perftest.cc',
         'quads/draw_quad_perftest.cc',
         'raster/task_graph_runner_perftest.cc',
         'raster/texture_compressor_perftest.cc',
@@ -140,6 +140,10 @@ void RasterizeAndRecordBenchmarkImpl::DidCompleteCommit(
                      rasterize_results_.pixels_rasterized_with_non_solid_color);
   result->SetInteger("pixels_rasterized_as_opaque",
                      rasterize_results_.pixels_rasterized_as_opaque);
+  result->SetInteger("display_items_rasterized",
+                     rasterize_results_.display_items_rasterized);
+  result->SetInteger("display_items_rasterized_without_index",
+                     rasterize_results_.display_items_rasterized_without_index);
   result->SetInteger("total_layers", rasterize_results_.total_layers);
   result->SetInteger("total_picture_layers",
                      rasterize_results_.total_picture_layers);
@@ -201,6 +205,12 @@ void RasterizeAndRecordBenchmarkImpl::RunOnLayer(PictureLayerImpl* layer) {
 
     rasterize_results_.pixels_rasterized += tile_size;
     rasterize_results_.total_best_time += min_time;
+
+    rasterize_results_.display_items_rasterized +=
+        raster_source->CountDisplayItemsToRasterInRect(content_rect,
+                                                       contents_scale);
+    rasterize_results_.display_items_rasterized_without_index +=
+        raster_source->GetDisplayItemCount();
   }
 
   const DisplayListRasterSource* layer_raster_source = layer->GetRasterSource();
@@ -212,6 +222,8 @@ RasterizeAndRecordBenchmarkImpl::RasterizeResults::RasterizeResults()
     : pixels_rasterized(0),
       pixels_rasterized_with_non_solid_color(0),
       pixels_rasterized_as_opaque(0),
+      display_items_rasterized(0),
+      display_items_rasterized_without_index(0),
       total_memory_usage(0),
       total_layers(0),
       total_picture_layers(0),
@@ -39,6 +39,10 @@ class RasterizeAndRecordBenchmarkImpl : public MicroBenchmarkImpl {
     int pixels_rasterized;
     int pixels_rasterized_with_non_solid_color;
     int pixels_rasterized_as_opaque;
+    // The display items that are played back for all of the tiles, and that
+    // would be without the spatial index of the display lists.
+    int display_items_rasterized;
+    int display_items_rasterized_without_index;
     base::TimeDelta total_best_time;
     size_t total_memory_usage;
     int total_layers;
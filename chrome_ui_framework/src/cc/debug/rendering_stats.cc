@@ -40,7 +40,9 @@ RenderingStats::RenderingStats()
       approximated_visible_content_area(0),
       checkerboarded_visible_content_area(0),
       checkerboarded_no_recording_content_area(0),
-      checkerboarded_needs_raster_content_area(0) {}
+      checkerboarded_needs_raster_content_area(0),
+      rastered_content_area(0),
+      partial_raster_saved_content_area(0) {}
 
 RenderingStats::~RenderingStats() {
 }
@@ -59,6 +61,9 @@ RenderingStats::AsTraceableData() const {
                           checkerboarded_no_recording_content_area);
   record_data->SetInteger("checkerboarded_needs_raster_content_area",
                           checkerboarded_needs_raster_content_area);
+  record_data->SetInteger("rastered_content_area", rastered_content_area);
+  record_data->SetInteger("partial_raster_saved_content_area",
+                          partial_raster_saved_content_area);
   draw_duration.AddToTracedValue("draw_duration_ms", record_data.get());
 
   draw_duration_estimate.AddToTracedValue("draw_duration_estimate_ms",
@@ -88,6 +93,8 @@ void RenderingStats::Add(const RenderingStats& other) {
       other.checkerboarded_no_recording_content_area;
   checkerboarded_needs_raster_content_area +=
       other.checkerboarded_needs_raster_content_area;
+  rastered_content_area += other.rastered_content_area;
+  partial_raster_saved_content_area += other.partial_raster_saved_content_area;
 
   draw_duration.Add(other.draw_duration);
   draw_duration_estimate.Add(other.draw_duration_estimate);
@@ -47,6 +47,10 @@ struct CC_EXPORT RenderingStats {
   int64 checkerboarded_visible_content_area;
   int64 checkerboarded_no_recording_content_area;
   int64 checkerboarded_needs_raster_content_area;
+  // The content pixels that tiles were rastered with, and those that partial
+  // raster didn't have to raster again as the tile's resource still had them.
+  int64 rastered_content_area;
+  int64 partial_raster_saved_content_area;
 
   TimeDeltaList draw_duration;
   TimeDeltaList draw_duration_estimate;
@@ -89,6 +89,18 @@ void RenderingStatsInstrumentation::AddCheckerboardedNeedsRasterContentArea(
   impl_thread_rendering_stats_.checkerboarded_needs_raster_content_area += area;
 }
 
+void RenderingStatsInstrumentation::AddRasteredContentArea(
+    int64 rastered_area,
+    int64 partial_raster_saved_area) {
+  if (!record_rendering_stats_)
+    return;
+
+  base::AutoLock scoped_lock(lock_);
+  impl_thread_rendering_stats_.rastered_content_area += rastered_area;
+  impl_thread_rendering_stats_.partial_raster_saved_content_area +=
+      partial_raster_saved_area;
+}
+
 void RenderingStatsInstrumentation::AddDrawDuration(
     base::TimeDelta draw_duration,
     base::TimeDelta draw_duration_estimate) {
@@ -43,6 +43,8 @@ class CC_EXPORT RenderingStatsInstrumentation {
   void AddCheckerboardedVisibleContentArea(int64 area);
   void AddCheckerboardedNoRecordingContentArea(int64 area);
   void AddCheckerboardedNeedsRasterContentArea(int64 area);
+  void AddRasteredContentArea(int64 rastered_area,
+                              int64 partial_raster_saved_area);
   void AddDrawDuration(base::TimeDelta draw_duration,
                        base::TimeDelta draw_duration_estimate);
   void AddBeginMainFrameToCommitDuration(
@@ -418,14 +418,16 @@ void CreateTestYUVVideoDrawQuad_Solid(
 typedef ::testing::Types<GLRenderer,
                          SoftwareRenderer,
                          GLRendererWithExpandedViewport,
-                         SoftwareRendererWithExpandedViewport> RendererTypes;
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithBands> RendererTypes;
 TYPED_TEST_CASE(RendererPixelTest, RendererTypes);
 
 template <typename RendererType>
 class SoftwareRendererPixelTest : public RendererPixelTest<RendererType> {};
 
-typedef ::testing::Types<SoftwareRenderer, SoftwareRendererWithExpandedViewport>
-    SoftwareRendererTypes;
+typedef ::testing::Types<SoftwareRenderer,
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithBands> SoftwareRendererTypes;
 TYPED_TEST_CASE(SoftwareRendererPixelTest, SoftwareRendererTypes);
 
 template <typename RendererType>
@@ -457,6 +459,13 @@ bool FuzzyForSoftwareOnlyPixelComparator<
   return fuzzy_.Compare(actual_bmp, expected_bmp);
 }
 
+template <>
+bool FuzzyForSoftwareOnlyPixelComparator<SoftwareRendererWithBands>::Compare(
+    const SkBitmap& actual_bmp,
+    const SkBitmap& expected_bmp) const {
+  return fuzzy_.Compare(actual_bmp, expected_bmp);
+}
+
 template<typename RendererType>
 bool FuzzyForSoftwareOnlyPixelComparator<RendererType>::Compare(
     const SkBitmap& actual_bmp,
@@ -688,8 +697,9 @@ template <typename TypeParam>
 class IntersectingQuadSoftwareTest
     : public IntersectingQuadPixelTest<TypeParam> {};
 
-typedef ::testing::Types<SoftwareRenderer, SoftwareRendererWithExpandedViewport>
-    SoftwareRendererTypes;
+typedef ::testing::Types<SoftwareRenderer,
+                         SoftwareRendererWithExpandedViewport,
+                         SoftwareRendererWithBands> SoftwareRendererTypes;
 typedef ::testing::Types<GLRenderer, GLRendererWithExpandedViewport>
     GLRendererTypes;
 
@@ -1834,7 +1844,9 @@ class RendererPixelTestWithBackgroundFilter
   gfx::Rect filter_pass_layer_rect_;
 };
 
-typedef ::testing::Types<GLRenderer, SoftwareRenderer>
+typedef ::testing::Types<GLRenderer,
+                         SoftwareRenderer,
+                         SoftwareRendererWithBands>
     BackgroundFilterRendererTypes;
 TYPED_TEST_CASE(RendererPixelTestWithBackgroundFilter,
                 BackgroundFilterRendererTypes);
@@ -2329,6 +2341,11 @@ bool IsSoftwareRenderer<SoftwareRendererWithExpandedViewport>() {
   return true;
 }
 
+template<>
+bool IsSoftwareRenderer<SoftwareRendererWithBands>() {
+  return true;
+}
+
 // If we disable image filtering, then a 2x2 bitmap should appear as four
 // huge sharp squares.
 TYPED_TEST(SoftwareRendererPixelTest, PictureDrawQuadDisableImageFiltering) {
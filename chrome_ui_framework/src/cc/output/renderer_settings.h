@@ -26,6 +26,9 @@ class CC_EXPORT RendererSettings {
   int highp_threshold_min;
   bool use_rgba_4444_textures;
   size_t texture_id_allocation_chunk_size;
+  // Number of horizontal bands the software renderer splits each render pass
+  // into so that they can be drawn in parallel. 1 draws serially.
+  int software_renderer_band_count;
 };
 
 }  // namespace cc
@@ -4,6 +4,8 @@
 
 #include "cc/output/software_renderer.h"
 
+#include <algorithm>
+
 #include "base/trace_event/trace_event.h"
 #include "cc/base/math_util.h"
 #include "cc/output/compositor_frame.h"
@@ -35,6 +37,9 @@
 namespace cc {
 namespace {
 
+// Bands shorter than this are not worth the cost of a worker task.
+const int kMinBandHeight = 32;
+
 static inline bool IsScalarNearlyInteger(SkScalar scalar) {
   return SkScalarNearlyZero(scalar - SkScalarRoundToScalar(scalar));
 }
@@ -49,26 +54,81 @@ bool IsScaleAndIntegerTranslate(const SkMatrix& matrix) {
          SkScalarNearlyZero(matrix[SkMatrix::kMPersp2] - 1.0f);
 }
 
+void ClipCanvasToRect(SkCanvas* canvas, const gfx::Rect& rect) {
+  // Skia applies the current matrix to clip rects so we reset it temporary.
+  SkMatrix current_matrix = canvas->getTotalMatrix();
+  canvas->resetMatrix();
+  canvas->clipRect(gfx::RectToSkRect(rect), SkRegion::kReplace_Op);
+  canvas->setMatrix(current_matrix);
+}
+
+void ClearCanvasToColor(SkCanvas* canvas, SkColor color, bool with_scissor) {
+  // SkCanvas::clear doesn't respect the current clipping region
+  // so we SkCanvas::drawColor instead if scissoring is active.
+  if (with_scissor)
+    canvas->drawColor(color, SkXfermode::kSrc_Mode);
+  else
+    canvas->clear(color);
+}
+
 }  // anonymous namespace
 
+class SoftwareRenderer::DrawBandsTask : public Task {
+ public:
+  explicit DrawBandsTask(SoftwareRenderer* renderer) : renderer_(renderer) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override {
+    TRACE_EVENT0("cc", "SoftwareRenderer::DrawBandsTask::RunOnWorkerThread");
+    renderer_->DrawBands();
+  }
+
+ private:
+  ~DrawBandsTask() override {}
+
+  SoftwareRenderer* renderer_;
+
+  DISALLOW_COPY_AND_ASSIGN(DrawBandsTask);
+};
+
+SoftwareRenderer::BandCommand::BandCommand(Type type)
+    : type(type),
+      clear_color(SK_ColorTRANSPARENT),
+      clear_with_scissor(false),
+      quad(nullptr),
+      has_draw_region(false) {}
+
 scoped_ptr<SoftwareRenderer> SoftwareRenderer::Create(
     RendererClient* client,
     const RendererSettings* settings,
     OutputSurface* output_surface,
-    ResourceProvider* resource_provider) {
-  return make_scoped_ptr(new SoftwareRenderer(
-      client, settings, output_surface, resource_provider));
+    ResourceProvider* resource_provider,
+    TaskGraphRunner* task_graph_runner) {
+  return make_scoped_ptr(new SoftwareRenderer(client, settings, output_surface,
+                                              resource_provider,
+                                              task_graph_runner));
 }
 
 SoftwareRenderer::SoftwareRenderer(RendererClient* client,
                                    const RendererSettings* settings,
                                    OutputSurface* output_surface,
-                                   ResourceProvider* resource_provider)
+                                   ResourceProvider* resource_provider,
+                                   TaskGraphRunner* task_graph_runner)
     : DirectRenderer(client, settings, output_surface, resource_provider),
       is_scissor_enabled_(false),
       is_backbuffer_discarded_(false),
       output_device_(output_surface->software_device()),
-      current_canvas_(NULL) {
+      current_canvas_(NULL),
+      task_graph_runner_(task_graph_runner),
+      recording_bands_(false),
+      drawing_bands_(false),
+      band_frame_(nullptr),
+      band_top_(0),
+      band_bottom_(0),
+      band_count_(0),
+      next_band_(0) {
+  if (task_graph_runner_ && settings_->software_renderer_band_count > 1)
+    namespace_token_ = task_graph_runner_->GetNamespaceToken();
   if (resource_provider_) {
     capabilities_.max_texture_size = resource_provider_->max_texture_size();
     capabilities_.best_texture_format =
@@ -96,6 +156,8 @@ void SoftwareRenderer::BeginDrawingFrame(DrawingFrame* frame) {
 
 void SoftwareRenderer::FinishDrawingFrame(DrawingFrame* frame) {
   TRACE_EVENT0("cc", "SoftwareRenderer::FinishDrawingFrame");
+  DCHECK(!recording_bands_);
+  DCHECK(band_commands_.empty());
   current_framebuffer_lock_ = nullptr;
   current_framebuffer_canvas_.clear();
   current_canvas_ = NULL;
@@ -168,22 +230,26 @@ void SoftwareRenderer::SetScissorTestRect(const gfx::Rect& scissor_rect) {
 void SoftwareRenderer::SetClipRect(const gfx::Rect& rect) {
   if (!current_canvas_)
     return;
-  // Skia applies the current matrix to clip rects so we reset it temporary.
-  SkMatrix current_matrix = current_canvas_->getTotalMatrix();
-  current_canvas_->resetMatrix();
-  current_canvas_->clipRect(gfx::RectToSkRect(rect), SkRegion::kReplace_Op);
-  current_canvas_->setMatrix(current_matrix);
+  if (recording_bands_) {
+    BandCommand command(BandCommand::SET_CLIP);
+    command.clip_rect = rect;
+    band_commands_.push_back(command);
+    return;
+  }
+  ClipCanvasToRect(current_canvas_, rect);
 }
 
 void SoftwareRenderer::ClearCanvas(SkColor color) {
   if (!current_canvas_)
     return;
-  // SkCanvas::clear doesn't respect the current clipping region
-  // so we SkCanvas::drawColor instead if scissoring is active.
-  if (is_scissor_enabled_)
-    current_canvas_->drawColor(color, SkXfermode::kSrc_Mode);
-  else
-    current_canvas_->clear(color);
+  if (recording_bands_) {
+    BandCommand command(BandCommand::CLEAR);
+    command.clear_color = color;
+    command.clear_with_scissor = is_scissor_enabled_;
+    band_commands_.push_back(command);
+    return;
+  }
+  ClearCanvasToColor(current_canvas_, color, is_scissor_enabled_);
 }
 
 void SoftwareRenderer::ClearFramebuffer(DrawingFrame* frame) {
@@ -202,6 +268,12 @@ void SoftwareRenderer::PrepareSurfaceForPass(
     DrawingFrame* frame,
     SurfaceInitializationMode initialization_mode,
     const gfx::Rect& render_pass_scissor) {
+  DCHECK(!recording_bands_);
+  if (ShouldDrawInBands(frame, render_pass_scissor)) {
+    band_frame_ = frame;
+    BeginDrawingInBands(render_pass_scissor);
+  }
+
   switch (initialization_mode) {
     case SURFACE_INITIALIZATION_MODE_PRESERVE:
       EnsureScissorTestDisabled();
@@ -218,6 +290,11 @@ void SoftwareRenderer::PrepareSurfaceForPass(
 }
 
 bool SoftwareRenderer::IsSoftwareResource(ResourceId resource_id) const {
+  // Only software resources are locked for bands, and the resource provider
+  // must not be used off the compositor thread.
+  if (drawing_bands_)
+    return band_resource_bitmaps_.count(resource_id) > 0;
+
   switch (resource_provider_->GetResourceType(resource_id)) {
     case ResourceProvider::RESOURCE_TYPE_GL_TEXTURE:
       return false;
@@ -229,13 +306,233 @@ bool SoftwareRenderer::IsSoftwareResource(ResourceId resource_id) const {
   return false;
 }
 
+const SkBitmap* SoftwareRenderer::LockSoftwareResource(
+    ResourceId resource_id,
+    scoped_ptr<ResourceProvider::ScopedReadLockSoftware>* lock) const {
+  if (drawing_bands_) {
+    std::map<ResourceId, const SkBitmap*>::const_iterator it =
+        band_resource_bitmaps_.find(resource_id);
+    return it != band_resource_bitmaps_.end() ? it->second : nullptr;
+  }
+
+  lock->reset(new ResourceProvider::ScopedReadLockSoftware(resource_provider_,
+                                                           resource_id));
+  return (*lock)->valid() ? (*lock)->sk_bitmap() : nullptr;
+}
+
+bool SoftwareRenderer::ShouldDrawInBands(
+    const DrawingFrame* frame,
+    const gfx::Rect& render_pass_scissor) const {
+  if (!namespace_token_.IsValid() || !current_canvas_)
+    return false;
+  if (render_pass_scissor.height() < 2 * kMinBandHeight)
+    return false;
+  // The bands draw straight into the target's pixels with their own canvases,
+  // which requires a raster target without any transform or layers.
+  if (!current_canvas_->getTotalMatrix().isIdentity() ||
+      current_canvas_->getSaveCount() != 1)
+    return false;
+  SkIPoint origin;
+  if (!current_canvas_->accessTopLayerPixels(nullptr, nullptr, &origin) ||
+      !origin.isZero())
+    return false;
+
+  // Background filters read back the target while the pass is being drawn,
+  // which can't be split into bands.
+  for (const DrawQuad* quad : frame->current_render_pass->quad_list) {
+    if (quad->material == DrawQuad::RENDER_PASS &&
+        ShouldApplyBackgroundFilters(RenderPassDrawQuad::MaterialCast(quad)))
+      return false;
+  }
+  return true;
+}
+
+void SoftwareRenderer::BeginDrawingInBands(
+    const gfx::Rect& render_pass_scissor) {
+  // Let the canvas' surface copy its pixels on write before they are modified
+  // behind its back.
+  current_canvas_->save();
+  current_canvas_->clipRect(SkRect::MakeEmpty());
+  current_canvas_->drawPaint(SkPaint());
+  current_canvas_->restore();
+
+  SkImageInfo info;
+  size_t row_bytes = 0;
+  void* pixels = current_canvas_->accessTopLayerPixels(&info, &row_bytes);
+  DCHECK(pixels);
+  band_target_bitmap_.installPixels(info, pixels, row_bytes);
+
+  gfx::Rect target_rect(info.width(), info.height());
+  target_rect.Intersect(render_pass_scissor);
+  band_top_ = target_rect.y();
+  band_bottom_ = target_rect.bottom();
+  band_count_ = std::max(1, std::min(settings_->software_renderer_band_count,
+                                     target_rect.height() / kMinBandHeight));
+  recording_bands_ = true;
+}
+
+void SoftwareRenderer::LockResourceForBands(ResourceId resource_id) {
+  if (!resource_id || band_resource_bitmaps_.count(resource_id))
+    return;
+  if (resource_provider_->GetResourceType(resource_id) !=
+      ResourceProvider::RESOURCE_TYPE_BITMAP)
+    return;
+
+  ResourceProvider::ScopedReadLockSoftware* lock =
+      new ResourceProvider::ScopedReadLockSoftware(resource_provider_,
+                                                   resource_id);
+  band_resource_locks_.push_back(make_scoped_ptr(lock));
+  band_resource_bitmaps_[resource_id] =
+      lock->valid() ? lock->sk_bitmap() : nullptr;
+}
+
+void SoftwareRenderer::LockQuadResourcesForBands(const DrawQuad* quad) {
+  switch (quad->material) {
+    case DrawQuad::TEXTURE_CONTENT:
+      LockResourceForBands(TextureDrawQuad::MaterialCast(quad)->resource_id());
+      break;
+    case DrawQuad::TILED_CONTENT:
+      LockResourceForBands(TileDrawQuad::MaterialCast(quad)->resource_id());
+      break;
+    case DrawQuad::RENDER_PASS: {
+      const RenderPassDrawQuad* render_pass_quad =
+          RenderPassDrawQuad::MaterialCast(quad);
+      ScopedResource* content_texture =
+          render_pass_textures_.get(render_pass_quad->render_pass_id);
+      DCHECK(content_texture);
+      LockResourceForBands(content_texture->id());
+      LockResourceForBands(render_pass_quad->mask_resource_id());
+
+      // Filter the content once here rather than once per band.
+      std::map<ResourceId, const SkBitmap*>::const_iterator it =
+          band_resource_bitmaps_.find(content_texture->id());
+      if (!render_pass_quad->filters.IsEmpty() &&
+          it != band_resource_bitmaps_.end() && it->second &&
+          !band_filter_bitmaps_.count(render_pass_quad)) {
+        band_filter_bitmaps_[render_pass_quad] = ApplyRenderPassFilters(
+            render_pass_quad, content_texture, it->second);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+gfx::Rect SoftwareRenderer::GetBandRect(int band) const {
+  int height = band_bottom_ - band_top_;
+  int top = band_top_ + height * band / band_count_;
+  int bottom = band_top_ + height * (band + 1) / band_count_;
+  return gfx::Rect(0, top, band_target_bitmap_.width(), bottom - top);
+}
+
+void SoftwareRenderer::FinishDrawingQuadList() {
+  if (!recording_bands_)
+    return;
+
+  TRACE_EVENT2("cc", "SoftwareRenderer::FinishDrawingQuadList", "bands",
+               band_count_, "commands", band_commands_.size());
+  recording_bands_ = false;
+  drawing_bands_ = true;
+  base::subtle::NoBarrier_Store(&next_band_, 0);
+
+  // Bands are claimed by whichever thread gets to them first, so this thread
+  // draws bands as well and only one task per other band is needed.
+  TaskGraph graph;
+  Task::Vector tasks;
+  for (int i = 1; i < band_count_; ++i) {
+    scoped_refptr<DrawBandsTask> task(new DrawBandsTask(this));
+    graph.nodes.push_back(TaskGraph::Node(task.get(), 0u, 0u));
+    tasks.push_back(task);
+  }
+  task_graph_runner_->ScheduleTasks(namespace_token_, &graph);
+
+  DrawBands();
+
+  // Every band has been claimed. Cancel the tasks that have not started yet
+  // and wait for the others to finish their bands.
+  TaskGraph empty_graph;
+  task_graph_runner_->ScheduleTasks(namespace_token_, &empty_graph);
+  task_graph_runner_->WaitForTasksToFinishRunning(namespace_token_);
+  Task::Vector completed_tasks;
+  task_graph_runner_->CollectCompletedTasks(namespace_token_,
+                                            &completed_tasks);
+
+  drawing_bands_ = false;
+  band_frame_ = nullptr;
+  band_commands_.clear();
+  band_filter_bitmaps_.clear();
+  band_resource_bitmaps_.clear();
+  band_resource_locks_.clear();
+  band_target_bitmap_.reset();
+}
+
+void SoftwareRenderer::DrawBands() {
+  while (true) {
+    int band = base::subtle::NoBarrier_AtomicIncrement(&next_band_, 1) - 1;
+    if (band >= band_count_)
+      return;
+    DrawBand(band);
+  }
+}
+
+void SoftwareRenderer::DrawBand(int band) {
+  TRACE_EVENT1("cc", "SoftwareRenderer::DrawBand", "band", band);
+  gfx::Rect band_rect = GetBandRect(band);
+
+  // The band's canvas covers the whole target so that every command draws
+  // with the same device coordinates as it would without bands, and is
+  // clipped to the band.
+  SkCanvas canvas(band_target_bitmap_);
+  SkPaint paint;
+  ClipCanvasToRect(&canvas, band_rect);
+
+  for (const BandCommand& command : band_commands_) {
+    switch (command.type) {
+      case BandCommand::SET_CLIP:
+        ClipCanvasToRect(&canvas,
+                         gfx::IntersectRects(command.clip_rect, band_rect));
+        break;
+      case BandCommand::CLEAR:
+        ClearCanvasToColor(&canvas, command.clear_color,
+                           command.clear_with_scissor);
+        break;
+      case BandCommand::DRAW_QUAD:
+        DrawQuadToCanvas(band_frame_, command.quad,
+                         command.has_draw_region ? &command.draw_region
+                                                 : nullptr,
+                         &canvas, &paint);
+        break;
+    }
+  }
+}
+
 void SoftwareRenderer::DoDrawQuad(DrawingFrame* frame,
                                   const DrawQuad* quad,
                                   const gfx::QuadF* draw_region) {
   if (!current_canvas_)
     return;
+  if (recording_bands_) {
+    LockQuadResourcesForBands(quad);
+    BandCommand command(BandCommand::DRAW_QUAD);
+    command.quad = quad;
+    if (draw_region) {
+      command.has_draw_region = true;
+      command.draw_region = *draw_region;
+    }
+    band_commands_.push_back(command);
+    return;
+  }
+  DrawQuadToCanvas(frame, quad, draw_region, current_canvas_, &current_paint_);
+}
+
+void SoftwareRenderer::DrawQuadToCanvas(const DrawingFrame* frame,
+                                        const DrawQuad* quad,
+                                        const gfx::QuadF* draw_region,
+                                        SkCanvas* canvas,
+                                        SkPaint* paint) const {
   if (draw_region) {
-    current_canvas_->save();
+    canvas->save();
   }
 
   TRACE_EVENT0("cc", "SoftwareRenderer::DoDrawQuad");
@@ -249,9 +546,9 @@ void SoftwareRenderer::DoDrawQuad(DrawingFrame* frame,
   SkMatrix sk_device_matrix;
   gfx::TransformToFlattenedSkMatrix(contents_device_transform,
                                     &sk_device_matrix);
-  current_canvas_->setMatrix(sk_device_matrix);
+  canvas->setMatrix(sk_device_matrix);
 
-  current_paint_.reset();
+  paint->reset();
   if (settings_->force_antialiasing ||
       !IsScaleAndIntegerTranslate(sk_device_matrix)) {
     // TODO(danakj): Until we can enable AA only on exterior edges of the
@@ -262,16 +559,16 @@ void SoftwareRenderer::DoDrawQuad(DrawingFrame* frame,
                                        quad->IsRightEdge();
     if (settings_->allow_antialiasing &&
         (settings_->force_antialiasing || all_four_edges_are_exterior))
-      current_paint_.setAntiAlias(true);
-    current_paint_.setFilterQuality(kLow_SkFilterQuality);
+      paint->setAntiAlias(true);
+    paint->setFilterQuality(kLow_SkFilterQuality);
   }
 
   if (quad->ShouldDrawWithBlending() ||
       quad->shared_quad_state->blend_mode != SkXfermode::kSrcOver_Mode) {
-    current_paint_.setAlpha(quad->shared_quad_state->opacity * 255);
-    current_paint_.setXfermodeMode(quad->shared_quad_state->blend_mode);
+    paint->setAlpha(quad->shared_quad_state->opacity * 255);
+    paint->setXfermodeMode(quad->shared_quad_state->blend_mode);
   } else {
-    current_paint_.setXfermodeMode(SkXfermode::kSrc_Mode);
+    paint->setXfermodeMode(SkXfermode::kSrc_Mode);
   }
 
   if (draw_region) {
@@ -287,28 +584,32 @@ void SoftwareRenderer::DoDrawQuad(DrawingFrame* frame,
     QuadFToSkPoints(local_draw_region, clip_points);
     draw_region_clip_path.addPoly(clip_points, 4, true);
 
-    current_canvas_->clipPath(draw_region_clip_path, SkRegion::kIntersect_Op,
-                              false);
+    canvas->clipPath(draw_region_clip_path, SkRegion::kIntersect_Op, false);
   }
 
   switch (quad->material) {
     case DrawQuad::DEBUG_BORDER:
-      DrawDebugBorderQuad(frame, DebugBorderDrawQuad::MaterialCast(quad));
+      DrawDebugBorderQuad(frame, DebugBorderDrawQuad::MaterialCast(quad),
+                          canvas, paint);
       break;
     case DrawQuad::PICTURE_CONTENT:
-      DrawPictureQuad(frame, PictureDrawQuad::MaterialCast(quad));
+      DrawPictureQuad(frame, PictureDrawQuad::MaterialCast(quad), canvas,
+                      paint);
       break;
     case DrawQuad::RENDER_PASS:
-      DrawRenderPassQuad(frame, RenderPassDrawQuad::MaterialCast(quad));
+      DrawRenderPassQuad(frame, RenderPassDrawQuad::MaterialCast(quad), canvas,
+                         paint);
       break;
     case DrawQuad::SOLID_COLOR:
-      DrawSolidColorQuad(frame, SolidColorDrawQuad::MaterialCast(quad));
+      DrawSolidColorQuad(frame, SolidColorDrawQuad::MaterialCast(quad), canvas,
+                         paint);
       break;
     case DrawQuad::TEXTURE_CONTENT:
-      DrawTextureQuad(frame, TextureDrawQuad::MaterialCast(quad));
+      DrawTextureQuad(frame, TextureDrawQuad::MaterialCast(quad), canvas,
+                      paint);
       break;
     case DrawQuad::TILED_CONTENT:
-      DrawTileQuad(frame, TileDrawQuad::MaterialCast(quad));
+      DrawTileQuad(frame, TileDrawQuad::MaterialCast(quad), canvas, paint);
       break;
     case DrawQuad::SURFACE_CONTENT:
       // Surface content should be fully resolved to other quad types before
@@ -319,45 +620,46 @@ void SoftwareRenderer::DoDrawQuad(DrawingFrame* frame,
     case DrawQuad::IO_SURFACE_CONTENT:
     case DrawQuad::YUV_VIDEO_CONTENT:
     case DrawQuad::STREAM_VIDEO_CONTENT:
-      DrawUnsupportedQuad(frame, quad);
+      DrawUnsupportedQuad(frame, quad, canvas, paint);
       NOTREACHED();
       break;
   }
 
-  current_canvas_->resetMatrix();
+  canvas->resetMatrix();
   if (draw_region) {
-    current_canvas_->restore();
+    canvas->restore();
   }
 }
 
 void SoftwareRenderer::DrawDebugBorderQuad(const DrawingFrame* frame,
-                                           const DebugBorderDrawQuad* quad) {
+                                           const DebugBorderDrawQuad* quad,
+                                           SkCanvas* canvas,
+                                           SkPaint* paint) const {
   // We need to apply the matrix manually to have pixel-sized stroke width.
   SkPoint vertices[4];
   gfx::RectFToSkRect(QuadVertexRect()).toQuad(vertices);
   SkPoint transformed_vertices[4];
-  current_canvas_->getTotalMatrix().mapPoints(transformed_vertices,
-                                              vertices,
-                                              4);
-  current_canvas_->resetMatrix();
-
-  current_paint_.setColor(quad->color);
-  current_paint_.setAlpha(quad->shared_quad_state->opacity *
-                          SkColorGetA(quad->color));
-  current_paint_.setStyle(SkPaint::kStroke_Style);
-  current_paint_.setStrokeWidth(quad->width);
-  current_canvas_->drawPoints(SkCanvas::kPolygon_PointMode,
-                              4, transformed_vertices, current_paint_);
+  canvas->getTotalMatrix().mapPoints(transformed_vertices, vertices, 4);
+  canvas->resetMatrix();
+
+  paint->setColor(quad->color);
+  paint->setAlpha(quad->shared_quad_state->opacity * SkColorGetA(quad->color));
+  paint->setStyle(SkPaint::kStroke_Style);
+  paint->setStrokeWidth(quad->width);
+  canvas->drawPoints(SkCanvas::kPolygon_PointMode, 4, transformed_vertices,
+                     *paint);
 }
 
 void SoftwareRenderer::DrawPictureQuad(const DrawingFrame* frame,
-                                       const PictureDrawQuad* quad) {
+                                       const PictureDrawQuad* quad,
+                                       SkCanvas* canvas,
+                                       SkPaint* paint) const {
   SkMatrix content_matrix;
   content_matrix.setRectToRect(
       gfx::RectFToSkRect(quad->tex_coord_rect),
       gfx::RectFToSkRect(QuadVertexRect()),
       SkMatrix::kFill_ScaleToFit);
-  current_canvas_->concat(content_matrix);
+  canvas->concat(content_matrix);
 
   const bool needs_transparency =
       SkScalarRoundToInt(quad->shared_quad_state->opacity * 255) < 255;
@@ -370,41 +672,42 @@ void SoftwareRenderer::DrawPictureQuad(const DrawingFrame* frame,
     // TODO(aelias): This isn't correct in all cases. We should detect these
     // cases and fall back to a persistent bitmap backing
     // (http://crbug.com/280374).
-    skia::OpacityFilterCanvas filtered_canvas(current_canvas_,
+    skia::OpacityFilterCanvas filtered_canvas(canvas,
                                               quad->shared_quad_state->opacity,
                                               disable_image_filtering);
     quad->raster_source->PlaybackToSharedCanvas(
         &filtered_canvas, quad->content_rect, quad->contents_scale);
   } else {
     quad->raster_source->PlaybackToSharedCanvas(
-        current_canvas_, quad->content_rect, quad->contents_scale);
+        canvas, quad->content_rect, quad->contents_scale);
   }
 }
 
 void SoftwareRenderer::DrawSolidColorQuad(const DrawingFrame* frame,
-                                          const SolidColorDrawQuad* quad) {
+                                          const SolidColorDrawQuad* quad,
+                                          SkCanvas* canvas,
+                                          SkPaint* paint) const {
   gfx::RectF visible_quad_vertex_rect = MathUtil::ScaleRectProportional(
       QuadVertexRect(), gfx::RectF(quad->rect), gfx::RectF(quad->visible_rect));
-  current_paint_.setColor(quad->color);
-  current_paint_.setAlpha(quad->shared_quad_state->opacity *
-                          SkColorGetA(quad->color));
-  current_canvas_->drawRect(gfx::RectFToSkRect(visible_quad_vertex_rect),
-                            current_paint_);
+  paint->setColor(quad->color);
+  paint->setAlpha(quad->shared_quad_state->opacity * SkColorGetA(quad->color));
+  canvas->drawRect(gfx::RectFToSkRect(visible_quad_vertex_rect), *paint);
 }
 
 void SoftwareRenderer::DrawTextureQuad(const DrawingFrame* frame,
-                                       const TextureDrawQuad* quad) {
+                                       const TextureDrawQuad* quad,
+                                       SkCanvas* canvas,
+                                       SkPaint* paint) const {
   if (!IsSoftwareResource(quad->resource_id())) {
-    DrawUnsupportedQuad(frame, quad);
+    DrawUnsupportedQuad(frame, quad, canvas, paint);
     return;
   }
 
   // TODO(skaslev): Add support for non-premultiplied alpha.
-  ResourceProvider::ScopedReadLockSoftware lock(resource_provider_,
-                                                quad->resource_id());
-  if (!lock.valid())
+  scoped_ptr<ResourceProvider::ScopedReadLockSoftware> lock;
+  const SkBitmap* bitmap = LockSoftwareResource(quad->resource_id(), &lock);
+  if (!bitmap)
     return;
-  const SkBitmap* bitmap = lock.sk_bitmap();
   gfx::RectF uv_rect = gfx::ScaleRect(gfx::BoundingRect(quad->uv_top_left,
                                                         quad->uv_bottom_right),
                                       bitmap->width(),
@@ -417,38 +720,39 @@ void SoftwareRenderer::DrawTextureQuad(const DrawingFrame* frame,
   SkRect quad_rect = gfx::RectFToSkRect(visible_quad_vertex_rect);
 
   if (quad->y_flipped)
-    current_canvas_->scale(1, -1);
+    canvas->scale(1, -1);
 
   bool blend_background = quad->background_color != SK_ColorTRANSPARENT &&
                           !bitmap->isOpaque();
-  bool needs_layer = blend_background && (current_paint_.getAlpha() != 0xFF);
+  bool needs_layer = blend_background && (paint->getAlpha() != 0xFF);
   if (needs_layer) {
-    current_canvas_->saveLayerAlpha(&quad_rect, current_paint_.getAlpha());
-    current_paint_.setAlpha(0xFF);
+    canvas->saveLayerAlpha(&quad_rect, paint->getAlpha());
+    paint->setAlpha(0xFF);
   }
   if (blend_background) {
     SkPaint background_paint;
     background_paint.setColor(quad->background_color);
-    current_canvas_->drawRect(quad_rect, background_paint);
+    canvas->drawRect(quad_rect, background_paint);
   }
-  current_paint_.setFilterQuality(
+  paint->setFilterQuality(
       quad->nearest_neighbor ? kNone_SkFilterQuality : kLow_SkFilterQuality);
-  current_canvas_->drawBitmapRect(*bitmap, sk_uv_rect, quad_rect,
-                                  &current_paint_);
+  canvas->drawBitmapRect(*bitmap, sk_uv_rect, quad_rect, paint);
   if (needs_layer)
-    current_canvas_->restore();
+    canvas->restore();
 }
 
 void SoftwareRenderer::DrawTileQuad(const DrawingFrame* frame,
-                                    const TileDrawQuad* quad) {
+                                    const TileDrawQuad* quad,
+                                    SkCanvas* canvas,
+                                    SkPaint* paint) const {
   // |resource_provider_| can be NULL in resourceless software draws, which
   // should never produce tile quads in the first place.
   DCHECK(resource_provider_);
   DCHECK(IsSoftwareResource(quad->resource_id()));
 
-  ResourceProvider::ScopedReadLockSoftware lock(resource_provider_,
-                                                quad->resource_id());
-  if (!lock.valid())
+  scoped_ptr<ResourceProvider::ScopedReadLockSoftware> lock;
+  const SkBitmap* bitmap = LockSoftwareResource(quad->resource_id(), &lock);
+  if (!bitmap)
     return;
 
   gfx::RectF visible_tex_coord_rect = MathUtil::ScaleRectProportional(
@@ -458,24 +762,25 @@ void SoftwareRenderer::DrawTileQuad(const DrawingFrame* frame,
       QuadVertexRect(), gfx::RectF(quad->rect), gfx::RectF(quad->visible_rect));
 
   SkRect uv_rect = gfx::RectFToSkRect(visible_tex_coord_rect);
-  current_paint_.setFilterQuality(
+  paint->setFilterQuality(
       quad->nearest_neighbor ? kNone_SkFilterQuality : kLow_SkFilterQuality);
-  current_canvas_->drawBitmapRect(*lock.sk_bitmap(), uv_rect,
-                                  gfx::RectFToSkRect(visible_quad_vertex_rect),
-                                  &current_paint_);
+  canvas->drawBitmapRect(*bitmap, uv_rect,
+                         gfx::RectFToSkRect(visible_quad_vertex_rect), paint);
 }
 
 void SoftwareRenderer::DrawRenderPassQuad(const DrawingFrame* frame,
-                                          const RenderPassDrawQuad* quad) {
+                                          const RenderPassDrawQuad* quad,
+                                          SkCanvas* canvas,
+                                          SkPaint* paint) const {
   ScopedResource* content_texture =
       render_pass_textures_.get(quad->render_pass_id);
   DCHECK(content_texture);
   DCHECK(content_texture->id());
   DCHECK(IsSoftwareResource(content_texture->id()));
 
-  ResourceProvider::ScopedReadLockSoftware lock(resource_provider_,
-                                                content_texture->id());
-  if (!lock.valid())
+  scoped_ptr<ResourceProvider::ScopedReadLockSoftware> lock;
+  const SkBitmap* content = LockSoftwareResource(content_texture->id(), &lock);
+  if (!content)
     return;
 
   SkRect dest_rect = gfx::RectFToSkRect(QuadVertexRect());
@@ -488,15 +793,16 @@ void SoftwareRenderer::DrawRenderPassQuad(const DrawingFrame* frame,
   content_mat.setRectToRect(content_rect, dest_rect,
                             SkMatrix::kFill_ScaleToFit);
 
-  const SkBitmap* content = lock.sk_bitmap();
-
   SkBitmap filter_bitmap;
   if (!quad->filters.IsEmpty()) {
-    skia::RefPtr<SkImageFilter> filter = RenderSurfaceFilters::BuildImageFilter(
-        quad->filters, gfx::SizeF(content_texture->size()));
-    // TODO(ajuma): Apply the filter in the same pass as the content where
-    // possible (e.g. when there's no origin offset). See crbug.com/308201.
-    filter_bitmap = ApplyImageFilter(filter.get(), quad, content);
+    if (drawing_bands_) {
+      std::map<const RenderPassDrawQuad*, SkBitmap>::const_iterator it =
+          band_filter_bitmaps_.find(quad);
+      if (it != band_filter_bitmaps_.end())
+        filter_bitmap = it->second;
+    } else {
+      filter_bitmap = ApplyRenderPassFilters(quad, content_texture, content);
+    }
   }
 
   skia::RefPtr<SkShader> shader;
@@ -512,15 +818,11 @@ void SoftwareRenderer::DrawRenderPassQuad(const DrawingFrame* frame,
 
   scoped_ptr<ResourceProvider::ScopedReadLockSoftware> mask_lock;
   if (quad->mask_resource_id()) {
-    mask_lock = scoped_ptr<ResourceProvider::ScopedReadLockSoftware>(
-        new ResourceProvider::ScopedReadLockSoftware(resource_provider_,
-                                                     quad->mask_resource_id()));
-
-    if (!mask_lock->valid())
+    const SkBitmap* mask =
+        LockSoftwareResource(quad->mask_resource_id(), &mask_lock);
+    if (!mask)
       return;
 
-    const SkBitmap* mask = mask_lock->sk_bitmap();
-
     // Scale normalized uv rect into absolute texel coordinates.
     SkRect mask_rect =
         gfx::RectFToSkRect(gfx::ScaleRect(quad->MaskUVRect(),
@@ -543,32 +845,33 @@ void SoftwareRenderer::DrawRenderPassQuad(const DrawingFrame* frame,
     skia::RefPtr<SkLayerRasterizer> mask_rasterizer =
         skia::AdoptRef(builder.detachRasterizer());
 
-    current_paint_.setRasterizer(mask_rasterizer.get());
+    paint->setRasterizer(mask_rasterizer.get());
   }
 
   // If we have a background filter shader, render its results first.
   skia::RefPtr<SkShader> background_filter_shader =
-      GetBackgroundFilterShader(frame, quad, SkShader::kClamp_TileMode);
+      GetBackgroundFilterShader(frame, quad, SkShader::kClamp_TileMode, canvas);
   if (background_filter_shader) {
-    SkPaint paint;
-    paint.setShader(background_filter_shader.get());
-    paint.setRasterizer(current_paint_.getRasterizer());
-    current_canvas_->drawRect(dest_visible_rect, paint);
+    SkPaint background_paint;
+    background_paint.setShader(background_filter_shader.get());
+    background_paint.setRasterizer(paint->getRasterizer());
+    canvas->drawRect(dest_visible_rect, background_paint);
   }
-  current_paint_.setShader(shader.get());
-  current_canvas_->drawRect(dest_visible_rect, current_paint_);
+  paint->setShader(shader.get());
+  canvas->drawRect(dest_visible_rect, *paint);
 }
 
 void SoftwareRenderer::DrawUnsupportedQuad(const DrawingFrame* frame,
-                                           const DrawQuad* quad) {
+                                           const DrawQuad* quad,
+                                           SkCanvas* canvas,
+                                           SkPaint* paint) const {
 #ifdef NDEBUG
-  current_paint_.setColor(SK_ColorWHITE);
+  paint->setColor(SK_ColorWHITE);
 #else
-  current_paint_.setColor(SK_ColorMAGENTA);
+  paint->setColor(SK_ColorMAGENTA);
 #endif
-  current_paint_.setAlpha(quad->shared_quad_state->opacity * 255);
-  current_canvas_->drawRect(gfx::RectFToSkRect(QuadVertexRect()),
-                            current_paint_);
+  paint->setAlpha(quad->shared_quad_state->opacity * 255);
+  canvas->drawRect(gfx::RectFToSkRect(QuadVertexRect()), *paint);
 }
 
 void SoftwareRenderer::CopyCurrentRenderPassToBitmap(
@@ -647,12 +950,23 @@ SkBitmap SoftwareRenderer::ApplyImageFilter(SkImageFilter* filter,
   return filter_bitmap;
 }
 
-SkBitmap SoftwareRenderer::GetBackdropBitmap(
-    const gfx::Rect& bounding_rect) const {
+SkBitmap SoftwareRenderer::ApplyRenderPassFilters(
+    const RenderPassDrawQuad* quad,
+    const ScopedResource* content_texture,
+    const SkBitmap* content) const {
+  skia::RefPtr<SkImageFilter> filter = RenderSurfaceFilters::BuildImageFilter(
+      quad->filters, gfx::SizeF(content_texture->size()));
+  // TODO(ajuma): Apply the filter in the same pass as the content where
+  // possible (e.g. when there's no origin offset). See crbug.com/308201.
+  return ApplyImageFilter(filter.get(), quad, content);
+}
+
+SkBitmap SoftwareRenderer::GetBackdropBitmap(const gfx::Rect& bounding_rect,
+                                             SkCanvas* canvas) const {
   SkBitmap bitmap;
   bitmap.setInfo(SkImageInfo::MakeN32Premul(bounding_rect.width(),
                                             bounding_rect.height()));
-  current_canvas_->readPixels(&bitmap, bounding_rect.x(), bounding_rect.y());
+  canvas->readPixels(&bitmap, bounding_rect.x(), bounding_rect.y());
   return bitmap;
 }
 
@@ -677,7 +991,8 @@ gfx::Rect SoftwareRenderer::GetBackdropBoundingBoxForRenderPassQuad(
 skia::RefPtr<SkShader> SoftwareRenderer::GetBackgroundFilterShader(
     const DrawingFrame* frame,
     const RenderPassDrawQuad* quad,
-    SkShader::TileMode content_tile_mode) const {
+    SkShader::TileMode content_tile_mode,
+    SkCanvas* canvas) const {
   if (!ShouldApplyBackgroundFilters(quad))
     return skia::RefPtr<SkShader>();
 
@@ -702,7 +1017,7 @@ skia::RefPtr<SkShader> SoftwareRenderer::GetBackgroundFilterShader(
   filter_backdrop_transform.preTranslate(backdrop_rect.x(), backdrop_rect.y());
 
   // Draw what's behind, and apply the filter to it.
-  SkBitmap backdrop_bitmap = GetBackdropBitmap(backdrop_rect);
+  SkBitmap backdrop_bitmap = GetBackdropBitmap(backdrop_rect, canvas);
 
   skia::RefPtr<SkImageFilter> filter = RenderSurfaceFilters::BuildImageFilter(
       quad->background_filters,
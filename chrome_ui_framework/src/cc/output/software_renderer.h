@@ -5,10 +5,18 @@
 #ifndef CC_OUTPUT_SOFTWARE_RENDERER_H_
 #define CC_OUTPUT_SOFTWARE_RENDERER_H_
 
+#include <map>
+#include <vector>
+
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "cc/base/cc_export.h"
+#include "cc/base/scoped_ptr_vector.h"
 #include "cc/output/compositor_frame.h"
 #include "cc/output/direct_renderer.h"
+#include "cc/raster/task_graph_runner.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/geometry/quad_f.h"
 
 namespace cc {
 
@@ -31,7 +39,8 @@ class CC_EXPORT SoftwareRenderer : public DirectRenderer {
       RendererClient* client,
       const RendererSettings* settings,
       OutputSurface* output_surface,
-      ResourceProvider* resource_provider);
+      ResourceProvider* resource_provider,
+      TaskGraphRunner* task_graph_runner);
 
   ~SoftwareRenderer() override;
   const RendererCapabilitiesImpl& Capabilities() const override;
@@ -53,6 +62,7 @@ class CC_EXPORT SoftwareRenderer : public DirectRenderer {
   void DoDrawQuad(DrawingFrame* frame,
                   const DrawQuad* quad,
                   const gfx::QuadF* draw_region) override;
+  void FinishDrawingQuadList() override;
   void BeginDrawingFrame(DrawingFrame* frame) override;
   void FinishDrawingFrame(DrawingFrame* frame) override;
   bool FlippedFramebuffer(const DrawingFrame* frame) const override;
@@ -65,45 +75,104 @@ class CC_EXPORT SoftwareRenderer : public DirectRenderer {
   SoftwareRenderer(RendererClient* client,
                    const RendererSettings* settings,
                    OutputSurface* output_surface,
-                   ResourceProvider* resource_provider);
+                   ResourceProvider* resource_provider,
+                   TaskGraphRunner* task_graph_runner);
 
   void DidChangeVisibility() override;
 
  private:
+  class DrawBandsTask;
+
+  // A canvas operation recorded while a render pass is drawn in bands. The
+  // commands are replayed on every band's canvas once the pass's quad list is
+  // complete.
+  struct BandCommand {
+    enum Type { SET_CLIP, CLEAR, DRAW_QUAD };
+
+    explicit BandCommand(Type type);
+
+    Type type;
+    // SET_CLIP.
+    gfx::Rect clip_rect;
+    // CLEAR.
+    SkColor clear_color;
+    bool clear_with_scissor;
+    // DRAW_QUAD.
+    const DrawQuad* quad;
+    bool has_draw_region;
+    gfx::QuadF draw_region;
+  };
+
   void ClearCanvas(SkColor color);
   void ClearFramebuffer(DrawingFrame* frame);
   void SetClipRect(const gfx::Rect& rect);
   bool IsSoftwareResource(ResourceId resource_id) const;
-
+  const SkBitmap* LockSoftwareResource(
+      ResourceId resource_id,
+      scoped_ptr<ResourceProvider::ScopedReadLockSoftware>* lock) const;
+
+  bool ShouldDrawInBands(const DrawingFrame* frame,
+                         const gfx::Rect& render_pass_scissor) const;
+  void BeginDrawingInBands(const gfx::Rect& render_pass_scissor);
+  void LockResourceForBands(ResourceId resource_id);
+  void LockQuadResourcesForBands(const DrawQuad* quad);
+  gfx::Rect GetBandRect(int band) const;
+  void DrawBands();
+  void DrawBand(int band);
+
+  void DrawQuadToCanvas(const DrawingFrame* frame,
+                        const DrawQuad* quad,
+                        const gfx::QuadF* draw_region,
+                        SkCanvas* canvas,
+                        SkPaint* paint) const;
   void DrawCheckerboardQuad(const DrawingFrame* frame,
                             const CheckerboardDrawQuad* quad);
   void DrawDebugBorderQuad(const DrawingFrame* frame,
-                           const DebugBorderDrawQuad* quad);
+                           const DebugBorderDrawQuad* quad,
+                           SkCanvas* canvas,
+                           SkPaint* paint) const;
   void DrawPictureQuad(const DrawingFrame* frame,
-                       const PictureDrawQuad* quad);
+                       const PictureDrawQuad* quad,
+                       SkCanvas* canvas,
+                       SkPaint* paint) const;
   void DrawRenderPassQuad(const DrawingFrame* frame,
-                          const RenderPassDrawQuad* quad);
+                          const RenderPassDrawQuad* quad,
+                          SkCanvas* canvas,
+                          SkPaint* paint) const;
   void DrawSolidColorQuad(const DrawingFrame* frame,
-                          const SolidColorDrawQuad* quad);
+                          const SolidColorDrawQuad* quad,
+                          SkCanvas* canvas,
+                          SkPaint* paint) const;
   void DrawTextureQuad(const DrawingFrame* frame,
-                       const TextureDrawQuad* quad);
+                       const TextureDrawQuad* quad,
+                       SkCanvas* canvas,
+                       SkPaint* paint) const;
   void DrawTileQuad(const DrawingFrame* frame,
-                    const TileDrawQuad* quad);
+                    const TileDrawQuad* quad,
+                    SkCanvas* canvas,
+                    SkPaint* paint) const;
   void DrawUnsupportedQuad(const DrawingFrame* frame,
-                           const DrawQuad* quad);
+                           const DrawQuad* quad,
+                           SkCanvas* canvas,
+                           SkPaint* paint) const;
   bool ShouldApplyBackgroundFilters(const RenderPassDrawQuad* quad) const;
   SkBitmap ApplyImageFilter(SkImageFilter* filter,
                             const RenderPassDrawQuad* quad,
                             const SkBitmap* to_filter) const;
+  SkBitmap ApplyRenderPassFilters(const RenderPassDrawQuad* quad,
+                                  const ScopedResource* content_texture,
+                                  const SkBitmap* content) const;
   gfx::Rect GetBackdropBoundingBoxForRenderPassQuad(
       const DrawingFrame* frame,
       const RenderPassDrawQuad* quad,
       const gfx::Transform& contents_device_transform) const;
-  SkBitmap GetBackdropBitmap(const gfx::Rect& bounding_rect) const;
+  SkBitmap GetBackdropBitmap(const gfx::Rect& bounding_rect,
+                             SkCanvas* canvas) const;
   skia::RefPtr<SkShader> GetBackgroundFilterShader(
       const DrawingFrame* frame,
       const RenderPassDrawQuad* quad,
-      SkShader::TileMode content_tile_mode) const;
+      SkShader::TileMode content_tile_mode,
+      SkCanvas* canvas) const;
 
   RendererCapabilitiesImpl capabilities_;
   bool is_scissor_enabled_;
@@ -118,6 +187,27 @@ class CC_EXPORT SoftwareRenderer : public DirectRenderer {
       current_framebuffer_lock_;
   skia::RefPtr<SkCanvas> current_framebuffer_canvas_;
 
+  // State for drawing render passes in horizontal bands on worker threads.
+  // While |recording_bands_| is true, canvas operations are appended to
+  // |band_commands_| instead of being performed. While |drawing_bands_| is
+  // true, the bands are being replayed and resources must be read from
+  // |band_resource_bitmaps_|, which were locked on this thread.
+  TaskGraphRunner* task_graph_runner_;
+  NamespaceToken namespace_token_;
+  bool recording_bands_;
+  bool drawing_bands_;
+  const DrawingFrame* band_frame_;
+  SkBitmap band_target_bitmap_;
+  int band_top_;
+  int band_bottom_;
+  int band_count_;
+  base::subtle::Atomic32 next_band_;
+  std::vector<BandCommand> band_commands_;
+  ScopedPtrVector<ResourceProvider::ScopedReadLockSoftware>
+      band_resource_locks_;
+  std::map<ResourceId, const SkBitmap*> band_resource_bitmaps_;
+  std::map<const RenderPassDrawQuad*, SkBitmap> band_filter_bitmaps_;
+
   DISALLOW_COPY_AND_ASSIGN(SoftwareRenderer);
 };
 
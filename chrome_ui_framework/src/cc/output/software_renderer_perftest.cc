@@ -0,0 +1,182 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/output/software_renderer.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "cc/base/scoped_ptr_deque.h"
+#include "cc/debug/lap_timer.h"
+#include "cc/output/software_output_device.h"
+#include "cc/quads/render_pass.h"
+#include "cc/quads/solid_color_draw_quad.h"
+#include "cc/quads/tile_draw_quad.h"
+#include "cc/raster/task_graph_runner.h"
+#include "cc/test/fake_output_surface.h"
+#include "cc/test/fake_output_surface_client.h"
+#include "cc/test/fake_resource_provider.h"
+#include "cc/test/test_shared_bitmap_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace cc {
+namespace {
+
+static const int kTimeLimitMillis = 2000;
+static const int kWarmupRuns = 5;
+static const int kTimeCheckInterval = 1;
+
+static const int kTileSize = 256;
+static const int kNumTileResources = 4;
+
+class SoftwareRendererPerfTest : public testing::Test,
+                                 public RendererClient,
+                                 public base::DelegateSimpleThread::Delegate {
+ public:
+  SoftwareRendererPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+  // Overridden from testing::Test:
+  void SetUp() override {
+    output_surface_ = FakeOutputSurface::CreateSoftware(
+        make_scoped_ptr(new SoftwareOutputDevice));
+    CHECK(output_surface_->BindToClient(&output_surface_client_));
+    shared_bitmap_manager_.reset(new TestSharedBitmapManager());
+    resource_provider_ = FakeResourceProvider::Create(
+        output_surface_.get(), shared_bitmap_manager_.get());
+    task_graph_runner_ = make_scoped_ptr(new TaskGraphRunner);
+    CreateTileResources();
+  }
+  void TearDown() override {
+    renderer_ = nullptr;
+    task_graph_runner_->Shutdown();
+    while (!workers_.empty())
+      workers_.take_front()->Join();
+    tile_resources_.clear();
+    resource_provider_ = nullptr;
+  }
+
+  // Overridden from RendererClient:
+  void SetFullRootLayerDamage() override {}
+
+  // Overridden from base::DelegateSimpleThread::Delegate:
+  void Run() override { task_graph_runner_->Run(); }
+
+  void RunDrawFrameTest(const std::string& test_name,
+                        const gfx::Size& viewport_size,
+                        int band_count) {
+    settings_.software_renderer_band_count = band_count;
+    while (static_cast<int>(workers_.size()) < band_count - 1) {
+      workers_.push_back(
+          make_scoped_ptr(new base::DelegateSimpleThread(this, "PerfWorker")));
+      workers_.back()->Start();
+    }
+    renderer_ =
+        SoftwareRenderer::Create(this, &settings_, output_surface_.get(),
+                                 resource_provider_.get(),
+                                 task_graph_runner_.get());
+
+    gfx::Rect viewport_rect(viewport_size);
+    timer_.Reset();
+    do {
+      RenderPassList list;
+      list.push_back(CreateRenderPass(viewport_rect));
+      renderer_->DrawFrame(&list, 1.f, viewport_rect, viewport_rect, false);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult(
+        "draw_frame", "",
+        base::StringPrintf("%s_%d_bands", test_name.c_str(), band_count),
+        timer_.LapsPerSecond(), "runs/s", true);
+  }
+
+ private:
+  void CreateTileResources() {
+    gfx::Size tile_size(kTileSize, kTileSize);
+    for (int i = 0; i < kNumTileResources; ++i) {
+      ResourceId resource_id = resource_provider_->CreateResource(
+          tile_size, ResourceProvider::TEXTURE_HINT_IMMUTABLE, RGBA_8888);
+
+      SkBitmap bitmap;
+      bitmap.allocN32Pixels(kTileSize, kTileSize);
+      bitmap.eraseColor(SkColorSetARGB(255, 64 * i, 255 - 64 * i, 128));
+      resource_provider_->CopyToResource(
+          resource_id, static_cast<uint8_t*>(bitmap.getPixels()), tile_size);
+      tile_resources_.push_back(resource_id);
+    }
+  }
+
+  // A layer of tiles covering the viewport, with a translucent layer over it
+  // so that the draw needs blending.
+  scoped_ptr<RenderPass> CreateRenderPass(const gfx::Rect& viewport_rect) {
+    scoped_ptr<RenderPass> render_pass = RenderPass::Create();
+    render_pass->SetNew(RenderPassId(1, 1), viewport_rect, viewport_rect,
+                        gfx::Transform());
+
+    SharedQuadState* overlay_state =
+        render_pass->CreateAndAppendSharedQuadState();
+    overlay_state->SetAll(gfx::Transform(), viewport_rect.size(),
+                          viewport_rect, viewport_rect, false, 0.5f,
+                          SkXfermode::kSrcOver_Mode, 0);
+    SolidColorDrawQuad* overlay_quad =
+        render_pass->CreateAndAppendDrawQuad<SolidColorDrawQuad>();
+    overlay_quad->SetNew(overlay_state, viewport_rect, viewport_rect,
+                         SK_ColorWHITE, false);
+
+    SharedQuadState* tile_state =
+        render_pass->CreateAndAppendSharedQuadState();
+    tile_state->SetAll(gfx::Transform(), viewport_rect.size(), viewport_rect,
+                       viewport_rect, false, 1.f, SkXfermode::kSrcOver_Mode,
+                       0);
+    gfx::Size tile_size(kTileSize, kTileSize);
+    size_t resource_index = 0;
+    for (int y = 0; y < viewport_rect.height(); y += kTileSize) {
+      for (int x = 0; x < viewport_rect.width(); x += kTileSize) {
+        gfx::Rect tile_rect =
+            gfx::IntersectRects(gfx::Rect(x, y, kTileSize, kTileSize),
+                                viewport_rect);
+        TileDrawQuad* tile_quad =
+            render_pass->CreateAndAppendDrawQuad<TileDrawQuad>();
+        tile_quad->SetNew(
+            tile_state, tile_rect, tile_rect, tile_rect,
+            tile_resources_[resource_index++ % tile_resources_.size()],
+            gfx::RectF(gfx::SizeF(tile_rect.size())), tile_size, false, false);
+      }
+    }
+    return render_pass.Pass();
+  }
+
+  RendererSettings settings_;
+  FakeOutputSurfaceClient output_surface_client_;
+  scoped_ptr<FakeOutputSurface> output_surface_;
+  scoped_ptr<SharedBitmapManager> shared_bitmap_manager_;
+  scoped_ptr<ResourceProvider> resource_provider_;
+  scoped_ptr<TaskGraphRunner> task_graph_runner_;
+  ScopedPtrDeque<base::DelegateSimpleThread> workers_;
+  scoped_ptr<SoftwareRenderer> renderer_;
+  std::vector<ResourceId> tile_resources_;
+  LapTimer timer_;
+};
+
+TEST_F(SoftwareRendererPerfTest, DrawFrame1080p) {
+  RunDrawFrameTest("1080p", gfx::Size(1920, 1080), 1);
+  RunDrawFrameTest("1080p", gfx::Size(1920, 1080), 2);
+  RunDrawFrameTest("1080p", gfx::Size(1920, 1080), 4);
+}
+
+TEST_F(SoftwareRendererPerfTest, DrawFrame4K) {
+  RunDrawFrameTest("4k", gfx::Size(3840, 2160), 1);
+  RunDrawFrameTest("4k", gfx::Size(3840, 2160), 2);
+  RunDrawFrameTest("4k", gfx::Size(3840, 2160), 4);
+}
+
+}  // namespace
+}  // namespace cc
@@ -8,6 +8,8 @@
 #include "cc/output/compositor_frame_metadata.h"
 #include "cc/output/copy_output_request.h"
 #include "cc/output/copy_output_result.h"
+#include "cc/output/filter_operation.h"
+#include "cc/output/filter_operations.h"
 #include "cc/output/software_output_device.h"
 #include "cc/quads/render_pass.h"
 #include "cc/quads/render_pass_draw_quad.h"
@@ -18,8 +20,10 @@
 #include "cc/test/fake_output_surface_client.h"
 #include "cc/test/fake_resource_provider.h"
 #include "cc/test/geometry_test_utils.h"
+#include "cc/test/pixel_comparator.h"
 #include "cc/test/render_pass_test_utils.h"
 #include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/skia/include/core/SkCanvas.h"
@@ -38,8 +42,12 @@ class SoftwareRendererTest : public testing::Test, public RendererClient {
     shared_bitmap_manager_.reset(new TestSharedBitmapManager());
     resource_provider_ = FakeResourceProvider::Create(
         output_surface_.get(), shared_bitmap_manager_.get());
-    renderer_ = SoftwareRenderer::Create(
-        this, &settings_, output_surface_.get(), resource_provider());
+    if (settings_.software_renderer_band_count > 1 && !task_graph_runner_)
+      task_graph_runner_.reset(new TestTaskGraphRunner);
+    renderer_ = SoftwareRenderer::Create(this, &settings_,
+                                         output_surface_.get(),
+                                         resource_provider(),
+                                         task_graph_runner_.get());
   }
 
   ResourceProvider* resource_provider() const {
@@ -85,10 +93,82 @@ class SoftwareRendererTest : public testing::Test, public RendererClient {
   FakeOutputSurfaceClient output_surface_client_;
   scoped_ptr<FakeOutputSurface> output_surface_;
   scoped_ptr<SharedBitmapManager> shared_bitmap_manager_;
+  scoped_ptr<TestTaskGraphRunner> task_graph_runner_;
   scoped_ptr<ResourceProvider> resource_provider_;
   scoped_ptr<SoftwareRenderer> renderer_;
 };
 
+// Appends a frame to |list| whose quads cross the edges of the bands that
+// |viewport_rect| is split into: anti-aliased quads, and a render pass that is
+// drawn with a mask and a filter.
+void AddFrameCrossingBands(RenderPassList* list,
+                           ResourceProvider* resource_provider,
+                           const gfx::Rect& viewport_rect) {
+  gfx::Size mask_size(120, 120);
+  ResourceId mask_resource_id = resource_provider->CreateResource(
+      mask_size, ResourceProvider::TEXTURE_HINT_IMMUTABLE, RGBA_8888);
+  SkBitmap mask;
+  mask.allocN32Pixels(mask_size.width(), mask_size.height());
+  mask.eraseColor(SK_ColorTRANSPARENT);
+  SkCanvas mask_canvas(mask);
+  SkPaint mask_paint;
+  mask_paint.setAntiAlias(true);
+  mask_paint.setColor(SK_ColorWHITE);
+  mask_canvas.drawCircle(60.f, 60.f, 55.f, mask_paint);
+  resource_provider->CopyToResource(
+      mask_resource_id, static_cast<uint8_t*>(mask.getPixels()), mask_size);
+
+  // A blue pass with a green square rotated in it.
+  gfx::Rect child_rect(mask_size);
+  RenderPass* child_pass =
+      AddRenderPass(list, RenderPassId(2, 1), child_rect, gfx::Transform());
+  gfx::Transform child_quad_transform;
+  child_quad_transform.Translate(60.0, 60.0);
+  child_quad_transform.Rotate(30.0);
+  child_quad_transform.Translate(-40.0, -40.0);
+  AddTransformedQuad(child_pass, gfx::Rect(80, 80), SK_ColorGREEN,
+                     child_quad_transform);
+  AddQuad(child_pass, child_rect, SK_ColorBLUE);
+
+  RenderPass* root_pass = AddRenderPass(list, RenderPassId(1, 1),
+                                        viewport_rect, gfx::Transform());
+
+  // The pass is masked to a circle and blurred, between y = 30 and 150.
+  gfx::Transform pass_transform;
+  pass_transform.Translate(40.0, 30.0);
+  SharedQuadState* pass_state = root_pass->CreateAndAppendSharedQuadState();
+  pass_state->SetAll(pass_transform, child_rect.size(), child_rect,
+                     child_rect, false, 1.f, SkXfermode::kSrcOver_Mode, 0);
+  FilterOperations filters;
+  filters.Append(FilterOperation::CreateBlurFilter(3.f));
+  RenderPassDrawQuad* pass_quad =
+      root_pass->CreateAndAppendDrawQuad<RenderPassDrawQuad>();
+  pass_quad->SetNew(pass_state, child_rect, child_rect, child_pass->id,
+                    mask_resource_id, gfx::Vector2dF(1.f, 1.f), mask_size,
+                    filters, gfx::Vector2dF(1.f, 1.f), FilterOperations());
+
+  // A translucent rotated quad, and a rotated quad that is clipped to a rect
+  // across two band edges.
+  gfx::Transform rotation;
+  rotation.Translate(100.0, 100.0);
+  rotation.Rotate(20.0);
+  rotation.Translate(-60.0, -60.0);
+  AddTransformedQuad(root_pass, gfx::Rect(120, 120),
+                     SkColorSetARGB(160, 255, 0, 0), rotation);
+  gfx::Rect clipped_rect(120, 120);
+  rotation.Rotate(25.0);
+  SharedQuadState* clipped_state = root_pass->CreateAndAppendSharedQuadState();
+  clipped_state->SetAll(rotation, clipped_rect.size(), clipped_rect,
+                        gfx::Rect(0, 45, 200, 60), true, 1.f,
+                        SkXfermode::kSrcOver_Mode, 0);
+  SolidColorDrawQuad* clipped_quad =
+      root_pass->CreateAndAppendDrawQuad<SolidColorDrawQuad>();
+  clipped_quad->SetNew(clipped_state, clipped_rect, clipped_rect,
+                       SK_ColorMAGENTA, false);
+
+  AddQuad(root_pass, viewport_rect, SK_ColorWHITE);
+}
+
 TEST_F(SoftwareRendererTest, SolidColorQuad) {
   gfx::Size outer_size(100, 100);
   gfx::Size inner_size(98, 98);
@@ -395,5 +475,33 @@ TEST_F(SoftwareRendererTest, RenderPassVisibleRect) {
                              interior_visible_rect.bottom() - 1));
 }
 
+TEST_F(SoftwareRendererTest, DrawInBandsMatchesSerial) {
+  float device_scale_factor = 1.f;
+  gfx::Rect device_viewport_rect(0, 0, 200, 200);
+
+  InitializeRenderer(make_scoped_ptr(new SoftwareOutputDevice));
+  RenderPassList list;
+  AddFrameCrossingBands(&list, resource_provider(), device_viewport_rect);
+  renderer()->DecideRenderPassAllocationsForFrame(list);
+  scoped_ptr<SkBitmap> serial_output =
+      DrawAndCopyOutput(&list, device_scale_factor, device_viewport_rect);
+
+  // Each pass is split into four bands, 50 pixels high for the root pass.
+  renderer_ = nullptr;
+  resource_provider_ = nullptr;
+  settings_.software_renderer_band_count = 4;
+  InitializeRenderer(make_scoped_ptr(new SoftwareOutputDevice));
+  list.clear();
+  AddFrameCrossingBands(&list, resource_provider(), device_viewport_rect);
+  renderer()->DecideRenderPassAllocationsForFrame(list);
+  scoped_ptr<SkBitmap> band_output =
+      DrawAndCopyOutput(&list, device_scale_factor, device_viewport_rect);
+
+  ASSERT_TRUE(serial_output);
+  ASSERT_TRUE(band_output);
+  EXPECT_TRUE(
+      ExactPixelComparator(false).Compare(*band_output, *serial_output));
+}
+
 }  // namespace
 }  // namespace cc
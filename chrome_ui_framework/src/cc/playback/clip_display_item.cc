@@ -53,6 +53,13 @@ void ClipDisplayItem::ProcessForBounds(
   calculator->AddStartingDisplayItem();
 }
 
+void ClipDisplayItem::AnalyzeForSolidColor(
+    SolidColorMetadata* metadata) const {
+  metadata->type = rounded_clip_rects_.empty() ? SolidColorMetadata::CLIP
+                                               : SolidColorMetadata::UNKNOWN;
+  metadata->rect = clip_rect_;
+}
+
 void ClipDisplayItem::AsValueInto(base::trace_event::TracedValue* array) const {
   std::string value = base::StringPrintf("ClipDisplayItem rect: [%s]",
                                          clip_rect_.ToString().c_str());
@@ -98,6 +105,11 @@ void EndClipDisplayItem::ProcessForBounds(
   calculator->AddEndingDisplayItem();
 }
 
+void EndClipDisplayItem::AnalyzeForSolidColor(
+    SolidColorMetadata* metadata) const {
+  metadata->type = SolidColorMetadata::NO_OP;
+}
+
 void EndClipDisplayItem::AsValueInto(
     base::trace_event::TracedValue* array) const {
   array->AppendString("EndClipDisplayItem");
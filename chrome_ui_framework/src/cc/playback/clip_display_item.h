@@ -31,6 +31,7 @@ class CC_EXPORT ClipDisplayItem : public DisplayItem {
   void AsValueInto(base::trace_event::TracedValue* array) const override;
   void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const override;
+  void AnalyzeForSolidColor(SolidColorMetadata* metadata) const override;
 
  private:
   gfx::Rect clip_rect_;
@@ -48,6 +49,7 @@ class CC_EXPORT EndClipDisplayItem : public DisplayItem {
   void AsValueInto(base::trace_event::TracedValue* array) const override;
   void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const override;
+  void AnalyzeForSolidColor(SolidColorMetadata* metadata) const override;
 };
 
 }  // namespace cc
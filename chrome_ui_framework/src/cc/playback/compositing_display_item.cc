@@ -49,7 +49,12 @@ void CompositingDisplayItem::Raster(
 
 void CompositingDisplayItem::ProcessForBounds(
     DisplayItemListBoundsCalculator* calculator) const {
-  calculator->AddStartingDisplayItem();
+  // Modes other than source over, and color filters, change the pixels of
+  // the whole layer, including the ones that no item draws to.
+  if (xfermode_ != SkXfermode::kSrcOver_Mode || color_filter_)
+    calculator->AddStartingEffectDisplayItem(has_bounds_ ? &bounds_ : nullptr);
+  else
+    calculator->AddStartingDisplayItem();
   calculator->Save();
 }
 
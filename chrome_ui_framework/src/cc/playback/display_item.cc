@@ -9,4 +9,8 @@ namespace cc {
 DisplayItem::DisplayItem() {
 }
 
+void DisplayItem::AnalyzeForSolidColor(SolidColorMetadata* metadata) const {
+  metadata->type = SolidColorMetadata::UNKNOWN;
+}
+
 }  // namespace cc
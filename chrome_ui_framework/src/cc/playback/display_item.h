@@ -9,8 +9,10 @@
 #include "cc/base/cc_export.h"
 #include "cc/debug/traced_value.h"
 #include "cc/playback/display_item_list_bounds_calculator.h"
+#include "third_party/skia/include/core/SkColor.h"
 #include "third_party/skia/include/core/SkPicture.h"
 #include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/vector2d.h"
 
 class SkCanvas;
 
@@ -18,6 +20,34 @@ namespace cc {
 
 class CC_EXPORT DisplayItem {
  public:
+  // What an item does to the pixels of a rect in layer space that it
+  // intersects, so that rects of a solid color can be found without playing
+  // the items back. |rect| is in the space that the item is drawn in.
+  struct SolidColorMetadata {
+    enum Type {
+      // The item draws nothing.
+      NO_OP,
+      // The items up to the matching end item are clipped to |rect|.
+      CLIP,
+      // The items up to the matching END_TRANSLATE item are drawn moved by
+      // |offset|.
+      TRANSLATE,
+      END_TRANSLATE,
+      // The item fills |rect| with |color|, which is opaque, and draws
+      // nothing outside of it.
+      SOLID_COLOR,
+      // The item has to be played back to know what it draws.
+      UNKNOWN
+    };
+
+    SolidColorMetadata() : type(UNKNOWN), color(SK_ColorTRANSPARENT) {}
+
+    Type type;
+    gfx::Rect rect;
+    SkColor color;
+    gfx::Vector2d offset;
+  };
+
   virtual ~DisplayItem() {}
 
   void SetNew(bool is_suitable_for_gpu_rasterization,
@@ -34,6 +64,8 @@ class CC_EXPORT DisplayItem {
   virtual void AsValueInto(base::trace_event::TracedValue* array) const = 0;
   virtual void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const = 0;
+  // Items are UNKNOWN unless they override this.
+  virtual void AnalyzeForSolidColor(SolidColorMetadata* metadata) const;
 
   bool is_suitable_for_gpu_rasterization() const {
     return is_suitable_for_gpu_rasterization_;
@@ -13,6 +13,7 @@
 #include "cc/debug/picture_debug_util.h"
 #include "cc/debug/traced_display_item_list.h"
 #include "cc/debug/traced_value.h"
+#include "cc/playback/display_item_list_bounds_calculator.h"
 #include "cc/playback/display_item_list_settings.h"
 #include "cc/playback/largest_display_item.h"
 #include "third_party/skia/include/core/SkCanvas.h"
@@ -82,8 +83,16 @@ void DisplayItemList::Raster(SkCanvas* canvas,
   if (!use_cached_picture_) {
     canvas->save();
     canvas->scale(contents_scale, contents_scale);
-    for (auto* item : items_)
-      item->Raster(canvas, canvas_target_playback_rect, callback);
+    // Only the items that intersect the canvas are played back, in order.
+    SkRect clip_bounds;
+    if (canvas->getClipBounds(&clip_bounds)) {
+      std::vector<size_t> indices;
+      rtree_.Search(gfx::SkRectToRectF(clip_bounds), &indices);
+      for (size_t index : indices) {
+        items_.ElementAt(index)->Raster(canvas, canvas_target_playback_rect,
+                                        callback);
+      }
+    }
     canvas->restore();
   } else {
     DCHECK(picture_);
@@ -172,6 +181,11 @@ void DisplayItemList::RemoveLast() {
 void DisplayItemList::Finalize() {
   ProcessAppendedItems();
 
+  if (!use_cached_picture_) {
+    BuildRTree();
+    GenerateSolidColorMetadata();
+  }
+
   if (use_cached_picture_) {
     // Convert to an SkPicture for faster rasterization.
     DCHECK(use_cached_picture_);
@@ -187,6 +201,27 @@ void DisplayItemList::Finalize() {
   }
 }
 
+void DisplayItemList::BuildRTree() {
+  DisplayItemListBoundsCalculator calculator;
+  for (const DisplayItem* item : items_)
+    item->ProcessForBounds(&calculator);
+  calculator.Finalize();
+
+  std::vector<gfx::RectF> bounds;
+  calculator.TakeBounds(&bounds);
+  DCHECK_EQ(items_.size(), bounds.size());
+  // Items with empty bounds draw nothing, and are left out of the tree. The
+  // tree returns the items in the order that they are added in.
+  rtree_.Build(bounds);
+}
+
+void DisplayItemList::GenerateSolidColorMetadata() {
+  solid_color_metadata_.resize(items_.size());
+  size_t index = 0;
+  for (const DisplayItem* item : items_)
+    item->AnalyzeForSolidColor(&solid_color_metadata_[index++]);
+}
+
 bool DisplayItemList::IsSuitableForGpuRasterization() const {
   DCHECK(ProcessAppendedItemsCalled());
   return is_suitable_for_gpu_rasterization_;
@@ -213,6 +248,10 @@ size_t DisplayItemList::ApproximateMemoryUsage() const {
   // Memory outside this class due to |picture|.
   memory_usage += picture_memory_usage_;
 
+  // Memory outside this class due to |solid_color_metadata_|.
+  memory_usage += solid_color_metadata_.capacity() *
+                  sizeof(DisplayItem::SolidColorMetadata);
+
   // TODO(jbroman): Does anything else owned by this class substantially
   // contribute to memory usage?
 
@@ -269,6 +308,62 @@ void DisplayItemList::EmitTraceSnapshot() const {
           DisplayItemsTracingEnabled()));
 }
 
+size_t DisplayItemList::CountItemsToRasterInRect(
+    const gfx::Rect& layer_rect) const {
+  DCHECK(ProcessAppendedItemsCalled());
+  if (use_cached_picture_)
+    return 0;
+  std::vector<size_t> indices;
+  rtree_.Search(gfx::RectF(layer_rect), &indices);
+  return indices.size();
+}
+
+bool DisplayItemList::GetSolidColorInRect(const gfx::Rect& layer_rect,
+                                          SkColor* color) const {
+  DCHECK(ProcessAppendedItemsCalled());
+  if (use_cached_picture_)
+    return false;
+
+  // The items that intersect the rect are visited in the order that they are
+  // drawn in. The rect is a solid color if each of them is either a clip that
+  // contains the whole rect, or draws nothing, or fills all of the rect with
+  // an opaque color. The rects of the items are moved to layer space by the
+  // translations that they are nested in. A translation and its end item have
+  // the same bounds, so the search returns either both or neither of them.
+  std::vector<size_t> indices;
+  rtree_.Search(gfx::RectF(layer_rect), &indices);
+  SkColor solid_color = SK_ColorTRANSPARENT;
+  std::vector<gfx::Vector2d> offsets(1);
+  for (size_t index : indices) {
+    const DisplayItem::SolidColorMetadata& metadata =
+        solid_color_metadata_[index];
+    switch (metadata.type) {
+      case DisplayItem::SolidColorMetadata::NO_OP:
+        break;
+      case DisplayItem::SolidColorMetadata::CLIP:
+        if (!(metadata.rect + offsets.back()).Contains(layer_rect))
+          return false;
+        break;
+      case DisplayItem::SolidColorMetadata::TRANSLATE:
+        offsets.push_back(offsets.back() + metadata.offset);
+        break;
+      case DisplayItem::SolidColorMetadata::END_TRANSLATE:
+        DCHECK_GT(offsets.size(), 1u);
+        offsets.pop_back();
+        break;
+      case DisplayItem::SolidColorMetadata::SOLID_COLOR:
+        if (!(metadata.rect + offsets.back()).Contains(layer_rect))
+          return false;
+        solid_color = metadata.color;
+        break;
+      case DisplayItem::SolidColorMetadata::UNKNOWN:
+        return false;
+    }
+  }
+  *color = solid_color;
+  return true;
+}
+
 void DisplayItemList::GenerateDiscardableImagesMetadata() {
   DCHECK(ProcessAppendedItemsCalled());
   // This should be only called once, and only after CreateAndCacheSkPicture.
@@ -5,12 +5,15 @@
 #ifndef CC_PLAYBACK_DISPLAY_ITEM_LIST_H_
 #define CC_PLAYBACK_DISPLAY_ITEM_LIST_H_
 
+#include <vector>
+
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/trace_event/trace_event.h"
 #include "cc/base/cc_export.h"
 #include "cc/base/list_container.h"
+#include "cc/base/rtree.h"
 #include "cc/playback/discardable_image_map.h"
 #include "cc/playback/display_item.h"
 #include "skia/ext/refptr.h"
@@ -76,6 +79,19 @@ class CC_EXPORT DisplayItemList
 
   void EmitTraceSnapshot() const;
 
+  // Returns the number of items that Raster() plays back into a canvas that
+  // is clipped to |layer_rect|, for benchmarks. Returns 0 if the items are
+  // played back from a cached picture.
+  size_t CountItemsToRasterInRect(const gfx::Rect& layer_rect) const;
+  size_t ItemCount() const { return items_.size(); }
+
+  // Returns true, and sets |color|, if |layer_rect| is known to be a solid
+  // color from the metadata that Finalize() caches for each item. The color
+  // is transparent if no item draws in the rect. Returns false if the items
+  // have to be played back to know, which is always the case for lists that
+  // are played back from a cached picture.
+  bool GetSolidColorInRect(const gfx::Rect& layer_rect, SkColor* color) const;
+
   void GenerateDiscardableImagesMetadata();
   void GetDiscardableImagesInRect(const gfx::Rect& rect,
                                   std::vector<DrawImage>* images);
@@ -90,6 +106,10 @@ class CC_EXPORT DisplayItemList
   // periodically to avoid retaining all the items and processing at the end.
   void ProcessAppendedItemsOnTheFly();
   void ProcessAppendedItems();
+  // Indexes the bounds of the items, so that raster only plays back the items
+  // that intersect the canvas.
+  void BuildRTree();
+  void GenerateSolidColorMetadata();
 #if DCHECK_IS_ON()
   bool ProcessAppendedItemsCalled() const { return !needs_process_; }
   bool needs_process_;
@@ -117,6 +137,14 @@ class CC_EXPORT DisplayItemList
 
   DiscardableImageMap image_map_;
 
+  // The indices of |items_|, by their bounds in layer space. Only built when
+  // the items are played back without a cached picture.
+  RTree rtree_;
+
+  // The solid color metadata of each of |items_|, by index. Only generated
+  // along with |rtree_|.
+  std::vector<DisplayItem::SolidColorMetadata> solid_color_metadata_;
+
   friend class base::RefCountedThreadSafe<DisplayItemList>;
   FRIEND_TEST_ALL_PREFIXES(DisplayItemListTest, ApproximateMemoryUsage);
   DISALLOW_COPY_AND_ASSIGN(DisplayItemList);
@@ -4,10 +4,21 @@
 
 #include "cc/playback/display_item_list_bounds_calculator.h"
 
+#include <limits>
+
 #include "base/logging.h"
 #include "ui/gfx/skia_util.h"
 
 namespace cc {
+namespace {
+
+// The bounds of an effect that can reach any pixel.
+gfx::RectF GetUnboundedRect() {
+  const float max = std::numeric_limits<float>::max() / 4;
+  return gfx::RectF(-max, -max, 2 * max, 2 * max);
+}
+
+}  // namespace
 
 DisplayItemListBoundsCalculator::DisplayItemListBoundsCalculator() {
   matrix_stack_.push_back(SkMatrix::I());
@@ -17,20 +28,40 @@ DisplayItemListBoundsCalculator::~DisplayItemListBoundsCalculator() {}
 
 void DisplayItemListBoundsCalculator::AddStartingDisplayItem() {
   bounds_.push_back(gfx::RectF());
-  started_items_indices_.push_back(bounds_.size() - 1);
+  StartedItem item = {bounds_.size() - 1, false};
+  started_items_.push_back(item);
+}
+
+void DisplayItemListBoundsCalculator::AddStartingEffectDisplayItem(
+    const SkRect* rect) {
+  if (rect) {
+    SkRect target_rect;
+    matrix()->mapRect(&target_rect, *rect);
+    bounds_.push_back(gfx::SkRectToRectF(target_rect));
+  } else {
+    bounds_.push_back(GetUnboundedRect());
+  }
+  StartedItem item = {bounds_.size() - 1, true};
+  started_items_.push_back(item);
 }
 
 void DisplayItemListBoundsCalculator::AddEndingDisplayItem() {
-  size_t last_start_index = started_items_indices_.back();
-  started_items_indices_.pop_back();
+  StartedItem last_started_item = started_items_.back();
+  started_items_.pop_back();
 
   // Ending bounds match the starting bounds.
-  bounds_.push_back(bounds_[last_start_index]);
+  const gfx::RectF block_bounds = bounds_[last_started_item.index];
+  bounds_.push_back(block_bounds);
+
+  if (last_started_item.is_effect) {
+    for (size_t i = last_started_item.index + 1; i < bounds_.size() - 1; ++i)
+      bounds_[i] = block_bounds;
+  }
 
   // The block that ended just now needs to be considered in the bounds of the
   // enclosing block.
-  if (!started_items_indices_.empty())
-    bounds_[started_items_indices_.back()].Union(bounds_.back());
+  if (!started_items_.empty())
+    bounds_[started_items_.back().index].Union(bounds_.back());
 }
 
 void DisplayItemListBoundsCalculator::AddDisplayItemWithBounds(
@@ -38,8 +69,8 @@ void DisplayItemListBoundsCalculator::AddDisplayItemWithBounds(
   SkRect target_rect;
   matrix()->mapRect(&target_rect, rect);
   bounds_.push_back(gfx::SkRectToRectF(target_rect));
-  if (!started_items_indices_.empty())
-    bounds_[started_items_indices_.back()].Union(bounds_.back());
+  if (!started_items_.empty())
+    bounds_[started_items_.back().index].Union(bounds_.back());
 }
 
 void DisplayItemListBoundsCalculator::Save() {
@@ -52,9 +83,9 @@ void DisplayItemListBoundsCalculator::Restore() {
 }
 
 void DisplayItemListBoundsCalculator::Finalize() {
-  while (!started_items_indices_.empty()) {
-    bounds_[started_items_indices_.back()].Union(bounds_.back());
-    started_items_indices_.pop_back();
+  while (!started_items_.empty()) {
+    bounds_[started_items_.back().index].Union(bounds_.back());
+    started_items_.pop_back();
   }
 }
 
@@ -12,12 +12,21 @@
 
 namespace cc {
 
+// Computes the bounds of each item of a display list, in the space of the
+// list. The bounds of an item that starts or ends a block, such as a clip or
+// a transform, are the union of the bounds of the items in the block, so that
+// a block is played back whenever any of its items is.
 class DisplayItemListBoundsCalculator {
  public:
   DisplayItemListBoundsCalculator();
   ~DisplayItemListBoundsCalculator();
 
   void AddStartingDisplayItem();
+  // Starts a block whose effect, like a filter, can reach pixels that its
+  // items don't draw to: up to |rect|, or any pixel if |rect| is null. The
+  // items of the block all get the bounds of the block, since its effect can
+  // depend on all of them.
+  void AddStartingEffectDisplayItem(const SkRect* rect);
   void AddEndingDisplayItem();
   void AddDisplayItemWithBounds(const SkRect& rect);
   void Finalize();
@@ -29,8 +38,13 @@ class DisplayItemListBoundsCalculator {
   void TakeBounds(std::vector<gfx::RectF>* bounds) { bounds->swap(bounds_); }
 
  private:
+  struct StartedItem {
+    size_t index;
+    bool is_effect;
+  };
+
   std::vector<gfx::RectF> bounds_;
-  std::vector<size_t> started_items_indices_;
+  std::vector<StartedItem> started_items_;
   std::vector<SkMatrix> matrix_stack_;
 };
 
@@ -295,6 +295,269 @@ TEST(DisplayItemListTest, CompactingItems) {
   EXPECT_EQ(0, memcmp(pixels, expected_pixels, 4 * 100 * 100));
 }
 
+TEST(DisplayItemListTest, PlaybackCullsItemsOutsideRect) {
+  gfx::Rect layer_rect(100, 100);
+  SkPictureRecorder recorder;
+  skia::RefPtr<SkCanvas> canvas;
+  skia::RefPtr<SkPicture> picture;
+  SkPaint blue_paint;
+  blue_paint.setColor(SK_ColorBLUE);
+  SkPaint red_paint;
+  red_paint.setColor(SK_ColorRED);
+  unsigned char pixels[4 * 100 * 100] = {0};
+  DisplayItemListSettings settings;
+  settings.use_cached_picture = false;
+  scoped_refptr<DisplayItemList> list =
+      DisplayItemList::Create(layer_rect, settings);
+
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(0.f, 0.f, 10.f, 10.f)));
+  canvas->drawRectCoords(0.f, 0.f, 10.f, 10.f, red_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item1 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item1->SetNew(picture);
+
+  gfx::Rect clip_rect(50, 50, 50, 50);
+  auto* item2 = list->CreateAndAppendItem<ClipDisplayItem>();
+  item2->SetNew(clip_rect, std::vector<SkRRect>());
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(50.f, 50.f, 100.f, 100.f)));
+  canvas->drawRectCoords(60.f, 60.f, 90.f, 90.f, blue_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item3 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item3->SetNew(picture);
+  list->CreateAndAppendItem<EndClipDisplayItem>();
+  list->Finalize();
+
+  // Only the items that intersect a rect are played back into it, and clips
+  // are played back together with the items that they clip.
+  EXPECT_EQ(4u, list->ItemCount());
+  EXPECT_EQ(4u, list->CountItemsToRasterInRect(layer_rect));
+  EXPECT_EQ(1u, list->CountItemsToRasterInRect(gfx::Rect(0, 0, 20, 20)));
+  EXPECT_EQ(3u, list->CountItemsToRasterInRect(gfx::Rect(60, 60, 20, 20)));
+  EXPECT_EQ(0u, list->CountItemsToRasterInRect(gfx::Rect(20, 20, 20, 20)));
+
+  // Culling doesn't change the pixels.
+  DrawDisplayList(pixels, layer_rect, list);
+
+  SkBitmap expected_bitmap;
+  unsigned char expected_pixels[4 * 100 * 100] = {0};
+  SkImageInfo info =
+      SkImageInfo::MakeN32Premul(layer_rect.width(), layer_rect.height());
+  expected_bitmap.installPixels(info, expected_pixels, info.minRowBytes());
+  SkCanvas expected_canvas(expected_bitmap);
+  expected_canvas.drawRectCoords(0.f, 0.f, 10.f, 10.f, red_paint);
+  expected_canvas.clipRect(gfx::RectToSkRect(clip_rect));
+  expected_canvas.drawRectCoords(60.f, 60.f, 90.f, 90.f, blue_paint);
+
+  EXPECT_EQ(0, memcmp(pixels, expected_pixels, 4 * 100 * 100));
+}
+
+TEST(DisplayItemListTest, PlaybackCullsTransformedItems) {
+  gfx::Rect layer_rect(100, 100);
+  SkPictureRecorder recorder;
+  skia::RefPtr<SkCanvas> canvas;
+  skia::RefPtr<SkPicture> picture;
+  SkPaint red_paint;
+  red_paint.setColor(SK_ColorRED);
+  DisplayItemListSettings settings;
+  settings.use_cached_picture = false;
+  scoped_refptr<DisplayItemList> list =
+      DisplayItemList::Create(layer_rect, settings);
+
+  // A 10x10 item that is translated and rotated by 90 degrees covers
+  // (40, 50) to (50, 60).
+  gfx::Transform transform;
+  transform.Translate(50.f, 50.f);
+  transform.Rotate(90.f);
+  auto* item1 = list->CreateAndAppendItem<TransformDisplayItem>();
+  item1->SetNew(transform);
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(0.f, 0.f, 10.f, 10.f)));
+  canvas->drawRectCoords(0.f, 0.f, 10.f, 10.f, red_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item2 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item2->SetNew(picture);
+  list->CreateAndAppendItem<EndTransformDisplayItem>();
+  list->Finalize();
+
+  EXPECT_EQ(3u, list->CountItemsToRasterInRect(gfx::Rect(42, 52, 2, 2)));
+  EXPECT_EQ(0u, list->CountItemsToRasterInRect(gfx::Rect(52, 52, 2, 2)));
+  EXPECT_EQ(0u, list->CountItemsToRasterInRect(gfx::Rect(42, 42, 2, 2)));
+}
+
+TEST(DisplayItemListTest, PlaybackDoesNotCullFilteredItems) {
+  gfx::Rect layer_rect(100, 100);
+  SkPictureRecorder recorder;
+  skia::RefPtr<SkCanvas> canvas;
+  skia::RefPtr<SkPicture> picture;
+  SkPaint red_paint;
+  red_paint.setColor(SK_ColorRED);
+  DisplayItemListSettings settings;
+  settings.use_cached_picture = false;
+  scoped_refptr<DisplayItemList> list =
+      DisplayItemList::Create(layer_rect, settings);
+
+  // A filter can move pixels anywhere, so the items that it filters are
+  // played back into any rect.
+  FilterOperations filters;
+  filters.Append(FilterOperation::CreateDropShadowFilter(
+      gfx::Point(80, 80), 0.f, SK_ColorBLACK));
+  auto* item1 = list->CreateAndAppendItem<FilterDisplayItem>();
+  item1->SetNew(filters, gfx::RectF(layer_rect));
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(0.f, 0.f, 10.f, 10.f)));
+  canvas->drawRectCoords(0.f, 0.f, 10.f, 10.f, red_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item2 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item2->SetNew(picture);
+  list->CreateAndAppendItem<EndFilterDisplayItem>();
+  list->Finalize();
+
+  EXPECT_EQ(3u, list->CountItemsToRasterInRect(gfx::Rect(0, 0, 10, 10)));
+  EXPECT_EQ(3u, list->CountItemsToRasterInRect(gfx::Rect(80, 80, 10, 10)));
+}
+
+TEST(DisplayItemListTest, GetSolidColorInRect) {
+  gfx::Rect layer_rect(100, 100);
+  SkPictureRecorder recorder;
+  skia::RefPtr<SkCanvas> canvas;
+  skia::RefPtr<SkPicture> picture;
+  SkPaint blue_paint;
+  blue_paint.setColor(SK_ColorBLUE);
+  SkPaint red_paint;
+  red_paint.setColor(SK_ColorRED);
+  SkPaint translucent_paint;
+  translucent_paint.setColor(SkColorSetARGB(128, 0, 255, 0));
+  DisplayItemListSettings settings;
+  settings.use_cached_picture = false;
+  scoped_refptr<DisplayItemList> list =
+      DisplayItemList::Create(layer_rect, settings);
+
+  // A blue background, a red rect that is clipped, and a translucent rect.
+  canvas = skia::SharePtr(
+      recorder.beginRecording(gfx::RectToSkRect(layer_rect)));
+  canvas->drawRectCoords(0.f, 0.f, 100.f, 100.f, blue_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item1 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item1->SetNew(picture);
+
+  auto* item2 = list->CreateAndAppendItem<ClipDisplayItem>();
+  item2->SetNew(gfx::Rect(0, 50, 50, 50), std::vector<SkRRect>());
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(0.f, 50.f, 50.f, 100.f)));
+  canvas->drawRectCoords(0.f, 50.f, 50.f, 100.f, red_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item3 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item3->SetNew(picture);
+  list->CreateAndAppendItem<EndClipDisplayItem>();
+
+  canvas = skia::SharePtr(recorder.beginRecording(
+      SkRect::MakeLTRB(50.f, 50.f, 100.f, 100.f)));
+  canvas->drawRectCoords(50.f, 50.f, 100.f, 100.f, translucent_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  auto* item4 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item4->SetNew(picture);
+  list->Finalize();
+
+  SkColor color = SK_ColorTRANSPARENT;
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(0, 0, 100, 50), &color));
+  EXPECT_EQ(SK_ColorBLUE, color);
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(10, 60, 20, 20), &color));
+  EXPECT_EQ(SK_ColorRED, color);
+  // Rects that are partly covered by the red rect, or that are drawn
+  // translucent, have to be played back.
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(0, 40, 20, 20), &color));
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(60, 60, 20, 20), &color));
+
+  // Nothing is drawn outside of the layer.
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(200, 0, 50, 50), &color));
+  EXPECT_EQ(SK_ColorTRANSPARENT, color);
+
+  // Lists that are played back from a cached picture are never analyzed.
+  settings.use_cached_picture = true;
+  list = DisplayItemList::Create(layer_rect, settings);
+  item1 = list->CreateAndAppendItem<DrawingDisplayItem>();
+  item1->SetNew(picture);
+  list->Finalize();
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(60, 60, 20, 20), &color));
+}
+
+TEST(DisplayItemListTest, GetSolidColorInRectOfViews) {
+  gfx::Rect layer_rect(100, 100);
+  SkPictureRecorder recorder;
+  skia::RefPtr<SkCanvas> canvas;
+  skia::RefPtr<SkPicture> picture;
+  SkPaint white_paint;
+  white_paint.setColor(SK_ColorWHITE);
+  SkPaint blue_paint;
+  blue_paint.setColor(SK_ColorBLUE);
+  SkPaint red_paint;
+  red_paint.setColor(SK_ColorRED);
+  DisplayItemListSettings settings;
+  settings.use_cached_picture = false;
+  scoped_refptr<DisplayItemList> list =
+      DisplayItemList::Create(layer_rect, settings);
+
+  // A white root view, with a blue child view at (10, 10) that has a red
+  // child view at (5, 5). Each view that isn't the root is clipped to its
+  // bounds in its parent and translated to its origin, as views::View does.
+  canvas = skia::SharePtr(
+      recorder.beginRecording(gfx::RectToSkRect(layer_rect)));
+  canvas->drawRectCoords(0.f, 0.f, 100.f, 100.f, white_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  list->CreateAndAppendItem<DrawingDisplayItem>()->SetNew(picture);
+
+  list->CreateAndAppendItem<ClipDisplayItem>()->SetNew(
+      gfx::Rect(10, 10, 50, 50), std::vector<SkRRect>());
+  gfx::Transform child_transform;
+  child_transform.Translate(10, 10);
+  list->CreateAndAppendItem<TransformDisplayItem>()->SetNew(child_transform);
+  canvas = skia::SharePtr(
+      recorder.beginRecording(SkRect::MakeWH(50.f, 50.f)));
+  canvas->drawRectCoords(0.f, 0.f, 50.f, 50.f, blue_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  list->CreateAndAppendItem<DrawingDisplayItem>()->SetNew(picture);
+
+  list->CreateAndAppendItem<ClipDisplayItem>()->SetNew(
+      gfx::Rect(5, 5, 20, 20), std::vector<SkRRect>());
+  gfx::Transform grandchild_transform;
+  grandchild_transform.Translate(5, 5);
+  list->CreateAndAppendItem<TransformDisplayItem>()->SetNew(
+      grandchild_transform);
+  canvas = skia::SharePtr(
+      recorder.beginRecording(SkRect::MakeWH(20.f, 20.f)));
+  canvas->drawRectCoords(0.f, 0.f, 20.f, 20.f, red_paint);
+  picture = skia::AdoptRef(recorder.endRecordingAsPicture());
+  list->CreateAndAppendItem<DrawingDisplayItem>()->SetNew(picture);
+  list->CreateAndAppendItem<EndTransformDisplayItem>();
+  list->CreateAndAppendItem<EndClipDisplayItem>();
+
+  list->CreateAndAppendItem<EndTransformDisplayItem>();
+  list->CreateAndAppendItem<EndClipDisplayItem>();
+  list->Finalize();
+
+  SkColor color = SK_ColorTRANSPARENT;
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(70, 70, 30, 30), &color));
+  EXPECT_EQ(SK_ColorWHITE, color);
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(40, 40, 20, 20), &color));
+  EXPECT_EQ(SK_ColorBLUE, color);
+  EXPECT_TRUE(list->GetSolidColorInRect(gfx::Rect(15, 15, 20, 20), &color));
+  EXPECT_EQ(SK_ColorRED, color);
+  // Rects that cross the bounds of a view have to be played back.
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(5, 5, 10, 10), &color));
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(30, 30, 10, 10), &color));
+
+  // A view that is translated by a fraction of a pixel isn't analyzed.
+  list = DisplayItemList::Create(layer_rect, settings);
+  child_transform.Translate(0.5f, 0.f);
+  list->CreateAndAppendItem<TransformDisplayItem>()->SetNew(child_transform);
+  list->CreateAndAppendItem<DrawingDisplayItem>()->SetNew(picture);
+  list->CreateAndAppendItem<EndTransformDisplayItem>();
+  list->Finalize();
+  EXPECT_FALSE(list->GetSolidColorInRect(gfx::Rect(15, 15, 5, 5), &color));
+}
+
 TEST(DisplayItemListTest, IsSuitableForGpuRasterizationWithCachedPicture) {
   gfx::Rect layer_rect(1000, 1000);
   SkPictureRecorder recorder;
@@ -217,6 +217,21 @@ size_t DisplayListRasterSource::GetPictureMemoryUsage() const {
          painter_reported_memory_usage_;
 }
 
+size_t DisplayListRasterSource::CountDisplayItemsToRasterInRect(
+    const gfx::Rect& content_rect,
+    float contents_scale) const {
+  if (!display_list_)
+    return 0;
+  return display_list_->CountItemsToRasterInRect(
+      gfx::ScaleToEnclosingRect(content_rect, 1.f / contents_scale));
+}
+
+size_t DisplayListRasterSource::GetDisplayItemCount() const {
+  if (!display_list_)
+    return 0;
+  return display_list_->ItemCount();
+}
+
 void DisplayListRasterSource::PerformSolidColorAnalysis(
     const gfx::Rect& content_rect,
     float contents_scale,
@@ -233,6 +248,28 @@ void DisplayListRasterSource::PerformSolidColorAnalysis(
   analysis->is_solid_color = canvas.GetColorIfSolid(&analysis->solid_color);
 }
 
+bool DisplayListRasterSource::PerformSolidColorAnalysisWithoutPlayback(
+    const gfx::Rect& content_rect,
+    float contents_scale,
+    DisplayListRasterSource::SolidColorAnalysis* analysis) const {
+  DCHECK(analysis);
+  if (!display_list_)
+    return false;
+
+  gfx::Rect layer_rect =
+      gfx::ScaleToEnclosingRect(content_rect, 1.0f / contents_scale);
+  layer_rect.Intersect(gfx::Rect(size_));
+  if (layer_rect.IsEmpty())
+    return false;
+
+  SkColor color;
+  if (!display_list_->GetSolidColorInRect(layer_rect, &color))
+    return false;
+  analysis->is_solid_color = true;
+  analysis->solid_color = color;
+  return true;
+}
+
 void DisplayListRasterSource::GetDiscardableImagesInRect(
     const gfx::Rect& layer_rect,
     std::vector<DrawImage>* images) const {
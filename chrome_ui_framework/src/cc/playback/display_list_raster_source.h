@@ -60,6 +60,15 @@ class CC_EXPORT DisplayListRasterSource
                                  float contents_scale,
                                  SolidColorAnalysis* analysis) const;
 
+  // Like PerformSolidColorAnalysis(), but only from the metadata that the
+  // display list keeps for its items, which is cheap enough to do before a
+  // raster task is scheduled. Returns false if the rect has to be played back
+  // to know whether it is of solid color.
+  bool PerformSolidColorAnalysisWithoutPlayback(
+      const gfx::Rect& content_rect,
+      float contents_scale,
+      SolidColorAnalysis* analysis) const;
+
   // Returns true iff the whole raster source is of solid color.
   bool IsSolidColor() const;
 
@@ -99,6 +108,12 @@ class CC_EXPORT DisplayListRasterSource
   virtual skia::RefPtr<SkPicture> GetFlattenedPicture();
   virtual size_t GetPictureMemoryUsage() const;
 
+  // Benchmarking functionality. Returns the number of display items that are
+  // played back to raster |content_rect|, and the number of display items.
+  size_t CountDisplayItemsToRasterInRect(const gfx::Rect& content_rect,
+                                         float contents_scale) const;
+  size_t GetDisplayItemCount() const;
+
   // Return true if LCD anti-aliasing may be used when rastering text.
   virtual bool CanUseLCDText() const;
 
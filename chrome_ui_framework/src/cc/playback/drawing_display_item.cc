@@ -9,13 +9,22 @@
 #include "base/strings/stringprintf.h"
 #include "base/trace_event/trace_event_argument.h"
 #include "cc/debug/picture_debug_util.h"
+#include "skia/ext/analysis_canvas.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkMatrix.h"
 #include "third_party/skia/include/core/SkPicture.h"
 #include "third_party/skia/include/utils/SkPictureUtils.h"
+#include "ui/gfx/geometry/rect_conversions.h"
 #include "ui/gfx/skia_util.h"
 
 namespace cc {
+namespace {
+
+// Pictures with more ops than this are rarely a solid color, and aren't worth
+// playing back to find out.
+const int kOpCountThatIsOkToAnalyze = 10;
+
+}  // namespace
 
 DrawingDisplayItem::DrawingDisplayItem() {
 }
@@ -56,6 +65,36 @@ void DrawingDisplayItem::ProcessForBounds(
   calculator->AddDisplayItemWithBounds(picture_->cullRect());
 }
 
+void DrawingDisplayItem::AnalyzeForSolidColor(
+    SolidColorMetadata* metadata) const {
+  metadata->type = SolidColorMetadata::UNKNOWN;
+  int op_count = picture_->approximateOpCount();
+  if (op_count == 0) {
+    metadata->type = SolidColorMetadata::NO_OP;
+    return;
+  }
+  if (op_count > kOpCountThatIsOkToAnalyze)
+    return;
+
+  gfx::Rect rect =
+      gfx::ToEnclosingRect(gfx::SkRectToRectF(picture_->cullRect()));
+  if (rect.IsEmpty())
+    return;
+  skia::AnalysisCanvas canvas(rect.width(), rect.height());
+  canvas.translate(-rect.x(), -rect.y());
+  picture_->playback(&canvas, &canvas);
+
+  // A transparent result can also be a clear of what is below the item, so
+  // only opaque colors are kept.
+  SkColor color;
+  if (!canvas.GetColorIfSolid(&color) ||
+      SkColorGetA(color) != SK_AlphaOPAQUE)
+    return;
+  metadata->type = SolidColorMetadata::SOLID_COLOR;
+  metadata->rect = rect;
+  metadata->color = color;
+}
+
 void DrawingDisplayItem::AsValueInto(
     base::trace_event::TracedValue* array) const {
   array->BeginDictionary();
@@ -29,6 +29,7 @@ class CC_EXPORT DrawingDisplayItem : public DisplayItem {
   void AsValueInto(base::trace_event::TracedValue* array) const override;
   void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const override;
+  void AnalyzeForSolidColor(SolidColorMetadata* metadata) const override;
 
   void CloneTo(DrawingDisplayItem* item) const;
 
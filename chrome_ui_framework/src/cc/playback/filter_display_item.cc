@@ -62,7 +62,9 @@ void FilterDisplayItem::Raster(SkCanvas* canvas,
 
 void FilterDisplayItem::ProcessForBounds(
     DisplayItemListBoundsCalculator* calculator) const {
-  calculator->AddStartingDisplayItem();
+  // Filters can move and spread pixels, and draw where none of their items
+  // draw.
+  calculator->AddStartingEffectDisplayItem(nullptr);
   calculator->Save();
 }
 
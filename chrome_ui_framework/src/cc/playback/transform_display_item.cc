@@ -7,6 +7,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/trace_event/trace_event_argument.h"
 #include "third_party/skia/include/core/SkCanvas.h"
+#include "ui/gfx/geometry/vector2d_conversions.h"
 
 namespace cc {
 
@@ -34,9 +35,25 @@ void TransformDisplayItem::Raster(SkCanvas* canvas,
 
 void TransformDisplayItem::ProcessForBounds(
     DisplayItemListBoundsCalculator* calculator) const {
-  calculator->AddStartingDisplayItem();
+  // Bounds mapped through a perspective transform can't be trusted.
+  if (transform_.HasPerspective())
+    calculator->AddStartingEffectDisplayItem(nullptr);
+  else
+    calculator->AddStartingDisplayItem();
   calculator->Save();
-  calculator->matrix()->postConcat(transform_.matrix());
+  calculator->matrix()->preConcat(transform_.matrix());
+}
+
+void TransformDisplayItem::AnalyzeForSolidColor(
+    SolidColorMetadata* metadata) const {
+  // Views translate each of their children by an integer offset, which keeps
+  // the rects of the items below pixel aligned.
+  if (!transform_.IsIdentityOrIntegerTranslation()) {
+    metadata->type = SolidColorMetadata::UNKNOWN;
+    return;
+  }
+  metadata->type = SolidColorMetadata::TRANSLATE;
+  metadata->offset = gfx::ToFlooredVector2d(transform_.To2dTranslation());
 }
 
 void TransformDisplayItem::AsValueInto(
@@ -66,6 +83,11 @@ void EndTransformDisplayItem::ProcessForBounds(
   calculator->AddEndingDisplayItem();
 }
 
+void EndTransformDisplayItem::AnalyzeForSolidColor(
+    SolidColorMetadata* metadata) const {
+  metadata->type = SolidColorMetadata::END_TRANSLATE;
+}
+
 void EndTransformDisplayItem::AsValueInto(
     base::trace_event::TracedValue* array) const {
   array->AppendString("EndTransformDisplayItem");
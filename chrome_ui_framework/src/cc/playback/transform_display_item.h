@@ -27,6 +27,7 @@ class CC_EXPORT TransformDisplayItem : public DisplayItem {
   void AsValueInto(base::trace_event::TracedValue* array) const override;
   void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const override;
+  void AnalyzeForSolidColor(SolidColorMetadata* metadata) const override;
 
  private:
   gfx::Transform transform_;
@@ -47,6 +48,7 @@ class CC_EXPORT EndTransformDisplayItem : public DisplayItem {
   void AsValueInto(base::trace_event::TracedValue* array) const override;
   void ProcessForBounds(
       DisplayItemListBoundsCalculator* calculator) const override;
+  void AnalyzeForSolidColor(SolidColorMetadata* metadata) const override;
 };
 
 }  // namespace cc
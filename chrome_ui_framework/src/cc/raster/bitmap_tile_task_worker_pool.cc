@@ -31,12 +31,13 @@ class RasterBufferImpl : public RasterBuffer {
   }
 
   // Overridden from RasterBuffer:
-  void Playback(const DisplayListRasterSource* raster_source,
-                const gfx::Rect& raster_full_rect,
-                const gfx::Rect& raster_dirty_rect,
-                uint64_t new_content_id,
-                float scale,
-                bool include_images) override {
+  gfx::Rect Playback(const DisplayListRasterSource* raster_source,
+                     const gfx::Rect& raster_full_rect,
+                     const gfx::Rect& raster_dirty_rect,
+                     uint64_t new_content_id,
+                     float scale,
+                     bool include_images,
+                     ImageDecodeController* image_decode_controller) override {
     gfx::Rect playback_rect = raster_full_rect;
     if (resource_has_previous_content_) {
       playback_rect.Intersect(raster_dirty_rect);
@@ -48,7 +49,8 @@ class RasterBufferImpl : public RasterBuffer {
     TileTaskWorkerPool::PlaybackToMemory(
         lock_.sk_bitmap().getPixels(), resource_->format(), resource_->size(),
         stride, raster_source, raster_full_rect, playback_rect, scale,
-        include_images);
+        include_images, image_decode_controller);
+    return playback_rect;
   }
 
  private:
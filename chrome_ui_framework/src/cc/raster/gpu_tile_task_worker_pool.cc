@@ -34,15 +34,19 @@ class RasterBufferImpl : public RasterBuffer {
   }
 
   // Overridden from RasterBuffer:
-  void Playback(const DisplayListRasterSource* raster_source,
-                const gfx::Rect& raster_full_rect,
-                const gfx::Rect& raster_dirty_rect,
-                uint64_t new_content_id,
-                float scale,
-                bool include_images) override {
+  gfx::Rect Playback(const DisplayListRasterSource* raster_source,
+                     const gfx::Rect& raster_full_rect,
+                     const gfx::Rect& raster_dirty_rect,
+                     uint64_t new_content_id,
+                     float scale,
+                     bool include_images,
+                     ImageDecodeController* image_decode_controller) override {
     TRACE_EVENT0("cc", "RasterBufferImpl::Playback");
     // GPU raster doesn't do low res tiles, so should always include images.
     DCHECK(include_images);
+    // The picture it records outlives the locks on the decodes, so it draws
+    // the original images.
+    DCHECK(!image_decode_controller);
     ContextProvider* context_provider = rasterizer_->resource_provider()
                                             ->output_surface()
                                             ->worker_context_provider();
@@ -57,13 +61,13 @@ class RasterBufferImpl : public RasterBuffer {
     DCHECK(!playback_rect.IsEmpty())
         << "Why are we rastering a tile that's not dirty?";
 
-    // TODO(danakj): Implement partial raster with raster_dirty_rect.
     // Rasterize source into resource.
     rasterizer_->RasterizeSource(&lock_, raster_source, raster_full_rect,
                                  playback_rect, scale);
 
     // Barrier to sync worker context output to cc context.
     scoped_context.ContextGL()->OrderingBarrierCHROMIUM();
+    return playback_rect;
   }
 
  private:
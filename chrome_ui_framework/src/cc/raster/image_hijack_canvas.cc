@@ -0,0 +1,110 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/image_hijack_canvas.h"
+
+#include "cc/playback/draw_image.h"
+#include "cc/tiles/image_decode_controller.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkPaint.h"
+
+namespace cc {
+namespace {
+
+SkFilterQuality GetFilterQuality(const SkPaint* paint) {
+  return paint ? paint->getFilterQuality() : kNone_SkFilterQuality;
+}
+
+// Returns a copy of |paint|, or a default paint if it is null, with the
+// filter quality to draw |decoded_image| with.
+SkPaint GetPaintForDecode(
+    const SkPaint* paint,
+    const ImageDecodeController::DecodedDrawImage& decoded_image) {
+  SkPaint decoded_paint;
+  if (paint)
+    decoded_paint = *paint;
+  decoded_paint.setFilterQuality(decoded_image.filter_quality());
+  return decoded_paint;
+}
+
+}  // namespace
+
+ImageHijackCanvas::ImageHijackCanvas(
+    SkCanvas* canvas,
+    ImageDecodeController* image_decode_controller)
+    : SkNWayCanvas(canvas->getBaseLayerSize().width(),
+                   canvas->getBaseLayerSize().height()),
+      canvas_(canvas),
+      image_decode_controller_(image_decode_controller) {
+  addCanvas(canvas);
+}
+
+void ImageHijackCanvas::onDrawPicture(const SkPicture* picture,
+                                      const SkMatrix* matrix,
+                                      const SkPaint* paint) {
+  SkCanvas::onDrawPicture(picture, matrix, paint);
+}
+
+void ImageHijackCanvas::onDrawImage(const SkImage* image,
+                                    SkScalar x,
+                                    SkScalar y,
+                                    const SkPaint* paint) {
+  SkMatrix matrix = getTotalMatrix();
+  matrix.preTranslate(x, y);
+  DrawImage draw_image(image, matrix, GetFilterQuality(paint));
+  ImageDecodeController::DecodedDrawImage decoded_image =
+      image_decode_controller_->GetDecodedImageForDraw(draw_image);
+  if (!decoded_image.image()) {
+    canvas_->drawImage(image, x, y, paint);
+    return;
+  }
+
+  // Draw the decode scaled back up to the size of the image.
+  const SkSize& scale = decoded_image.scale();
+  SkPaint decoded_paint = GetPaintForDecode(paint, decoded_image);
+  canvas_->save();
+  canvas_->translate(x, y);
+  canvas_->scale(1.f / scale.width(), 1.f / scale.height());
+  canvas_->drawImage(decoded_image.image(), 0, 0, &decoded_paint);
+  canvas_->restore();
+  image_decode_controller_->DrawWithImageFinished(draw_image, decoded_image);
+}
+
+void ImageHijackCanvas::onDrawImageRect(const SkImage* image,
+                                        const SkRect* src,
+                                        const SkRect& dst,
+                                        const SkPaint* paint,
+                                        SrcRectConstraint constraint) {
+  SkRect src_storage;
+  if (!src) {
+    src_storage = SkRect::MakeIWH(image->width(), image->height());
+    src = &src_storage;
+  }
+  SkMatrix matrix;
+  matrix.setRectToRect(*src, dst, SkMatrix::kFill_ScaleToFit);
+  matrix.postConcat(getTotalMatrix());
+  DrawImage draw_image(image, matrix, GetFilterQuality(paint));
+  ImageDecodeController::DecodedDrawImage decoded_image =
+      image_decode_controller_->GetDecodedImageForDraw(draw_image);
+  if (!decoded_image.image()) {
+    canvas_->drawImageRect(image, *src, dst, paint, constraint);
+    return;
+  }
+
+  // Map the source rect to the decode.
+  const SkSize& scale = decoded_image.scale();
+  SkRect decoded_src = SkRect::MakeXYWH(
+      src->x() * scale.width(), src->y() * scale.height(),
+      src->width() * scale.width(), src->height() * scale.height());
+  SkPaint decoded_paint = GetPaintForDecode(paint, decoded_image);
+  canvas_->drawImageRect(decoded_image.image(), decoded_src, dst,
+                         &decoded_paint, constraint);
+  image_decode_controller_->DrawWithImageFinished(draw_image, decoded_image);
+}
+
+void ImageHijackCanvas::onDiscard() {
+  canvas_->discard();
+}
+
+}  // namespace cc
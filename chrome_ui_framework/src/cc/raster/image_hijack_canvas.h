@@ -0,0 +1,49 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RASTER_IMAGE_HIJACK_CANVAS_H_
+#define CC_RASTER_IMAGE_HIJACK_CANVAS_H_
+
+#include "base/macros.h"
+#include "cc/base/cc_export.h"
+#include "third_party/skia/include/utils/SkNWayCanvas.h"
+
+namespace cc {
+
+class ImageDecodeController;
+
+// ImageHijackCanvas forwards everything that is drawn on it to |canvas|, but
+// draws the discardable images that |image_decode_controller| has decoded
+// from their decodes, rather than have Skia decode them again at full size.
+class CC_EXPORT ImageHijackCanvas : public SkNWayCanvas {
+ public:
+  ImageHijackCanvas(SkCanvas* canvas,
+                    ImageDecodeController* image_decode_controller);
+
+ private:
+  // Pictures are played back on this canvas, so that their images are
+  // hijacked as well.
+  void onDrawPicture(const SkPicture* picture,
+                     const SkMatrix* matrix,
+                     const SkPaint* paint) override;
+  void onDrawImage(const SkImage* image,
+                   SkScalar x,
+                   SkScalar y,
+                   const SkPaint* paint) override;
+  void onDrawImageRect(const SkImage* image,
+                       const SkRect* src,
+                       const SkRect& dst,
+                       const SkPaint* paint,
+                       SrcRectConstraint constraint) override;
+  void onDiscard() override;
+
+  SkCanvas* canvas_;
+  ImageDecodeController* image_decode_controller_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageHijackCanvas);
+};
+
+}  // namespace cc
+
+#endif  // CC_RASTER_IMAGE_HIJACK_CANVAS_H_
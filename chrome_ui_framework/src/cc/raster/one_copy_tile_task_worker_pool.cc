@@ -33,30 +33,35 @@ class RasterBufferImpl : public RasterBuffer {
                    ResourceProvider* resource_provider,
                    ResourceFormat resource_format,
                    const Resource* resource,
+                   uint64_t resource_content_id,
                    uint64_t previous_content_id)
       : worker_pool_(worker_pool),
         resource_(resource),
         lock_(resource_provider, resource->id()),
+        resource_content_id_(resource_content_id),
         previous_content_id_(previous_content_id) {}
 
   ~RasterBufferImpl() override {}
 
   // Overridden from RasterBuffer:
-  void Playback(const DisplayListRasterSource* raster_source,
-                const gfx::Rect& raster_full_rect,
-                const gfx::Rect& raster_dirty_rect,
-                uint64_t new_content_id,
-                float scale,
-                bool include_images) override {
-    worker_pool_->PlaybackAndCopyOnWorkerThread(
+  gfx::Rect Playback(const DisplayListRasterSource* raster_source,
+                     const gfx::Rect& raster_full_rect,
+                     const gfx::Rect& raster_dirty_rect,
+                     uint64_t new_content_id,
+                     float scale,
+                     bool include_images,
+                     ImageDecodeController* image_decode_controller) override {
+    return worker_pool_->PlaybackAndCopyOnWorkerThread(
         resource_, &lock_, raster_source, raster_full_rect, raster_dirty_rect,
-        scale, include_images, previous_content_id_, new_content_id);
+        scale, include_images, image_decode_controller, resource_content_id_,
+        previous_content_id_, new_content_id);
   }
 
  private:
   OneCopyTileTaskWorkerPool* worker_pool_;
   const Resource* resource_;
   ResourceProvider::ScopedWriteLockGL lock_;
+  uint64_t resource_content_id_;
   uint64_t previous_content_id_;
 
   DISALLOW_COPY_AND_ASSIGN(RasterBufferImpl);
@@ -352,11 +357,9 @@ scoped_ptr<RasterBuffer> OneCopyTileTaskWorkerPool::AcquireBufferForRaster(
     const Resource* resource,
     uint64_t resource_content_id,
     uint64_t previous_content_id) {
-  // TODO(danakj): If resource_content_id != 0, we only need to copy/upload
-  // the dirty rect.
-  return make_scoped_ptr<RasterBuffer>(
-      new RasterBufferImpl(this, resource_provider_, resource->format(),
-                           resource, previous_content_id));
+  return make_scoped_ptr<RasterBuffer>(new RasterBufferImpl(
+      this, resource_provider_, resource->format(), resource,
+      resource_content_id, previous_content_id));
 }
 
 void OneCopyTileTaskWorkerPool::ReleaseBufferForRaster(
@@ -364,7 +367,7 @@ void OneCopyTileTaskWorkerPool::ReleaseBufferForRaster(
   // Nothing to do here. RasterBufferImpl destructor cleans up after itself.
 }
 
-void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
+gfx::Rect OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
     const Resource* resource,
     const ResourceProvider::ScopedWriteLockGL* resource_lock,
     const DisplayListRasterSource* raster_source,
@@ -372,6 +375,8 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
     const gfx::Rect& raster_dirty_rect,
     float scale,
     bool include_images,
+    ImageDecodeController* image_decode_controller,
+    uint64_t resource_content_id,
     uint64_t previous_content_id,
     uint64_t new_content_id) {
   base::AutoLock lock(lock_);
@@ -380,6 +385,14 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
       AcquireStagingBuffer(resource, previous_content_id);
   DCHECK(staging_buffer);
 
+  // If |resource| still has the previous content, only the dirty rect has to
+  // be played back into the staging buffer and copied to |resource|, whatever
+  // the staging buffer holds.
+  bool resource_has_previous_content =
+      use_partial_raster_ && resource_content_id &&
+      resource_content_id == previous_content_id;
+  gfx::Rect playback_rect = raster_full_rect;
+
   {
     base::AutoUnlock unlock(lock_);
 
@@ -397,13 +410,13 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
                 1u);
     }
 
-    gfx::Rect playback_rect = raster_full_rect;
-    if (use_partial_raster_ && previous_content_id) {
-      // Reduce playback rect to dirty region if the content id of the staging
-      // buffer matches the prevous content id.
-      if (previous_content_id == staging_buffer->content_id)
-        playback_rect.Intersect(raster_dirty_rect);
-    }
+    bool staging_buffer_has_previous_content =
+        use_partial_raster_ && previous_content_id &&
+        previous_content_id == staging_buffer->content_id;
+    // Reduce playback rect to dirty region if the content id of the staging
+    // buffer or of the resource matches the prevous content id.
+    if (staging_buffer_has_previous_content || resource_has_previous_content)
+      playback_rect.Intersect(raster_dirty_rect);
 
     if (staging_buffer->gpu_memory_buffer) {
       void* data = nullptr;
@@ -419,9 +432,15 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
       TileTaskWorkerPool::PlaybackToMemory(
           data, resource->format(), staging_buffer->size,
           static_cast<size_t>(stride), raster_source, raster_full_rect,
-          playback_rect, scale, include_images);
+          playback_rect, scale, include_images, image_decode_controller);
       staging_buffer->gpu_memory_buffer->Unmap();
-      staging_buffer->content_id = new_content_id;
+      // A staging buffer that only got the dirty rect of a resource has
+      // partial content.
+      staging_buffer->content_id =
+          playback_rect == raster_full_rect ||
+                  staging_buffer_has_previous_content
+              ? new_content_id
+              : 0;
     }
   }
 
@@ -482,23 +501,31 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
 #endif
     }
 
+    // Only the part of the resource that was played back has to be copied
+    // if the rest of the resource is still valid.
+    gfx::Rect copy_rect(resource->size());
+    if (resource_has_previous_content) {
+      copy_rect = playback_rect - raster_full_rect.OffsetFromOrigin();
+      copy_rect.Intersect(gfx::Rect(resource->size()));
+    }
+
     int bytes_per_row =
-        (BitsPerPixel(resource->format()) * resource->size().width()) / 8;
+        (BitsPerPixel(resource->format()) * copy_rect.width()) / 8;
     int chunk_size_in_rows =
         std::max(1, max_bytes_per_copy_operation_ / bytes_per_row);
     // Align chunk size to 4. Required to support compressed texture formats.
     chunk_size_in_rows = MathUtil::UncheckedRoundUp(chunk_size_in_rows, 4);
-    int y = 0;
-    int height = resource->size().height();
-    while (y < height) {
+    int y = copy_rect.y();
+    int bottom = copy_rect.bottom();
+    while (y < bottom) {
       // Copy at most |chunk_size_in_rows|.
-      int rows_to_copy = std::min(chunk_size_in_rows, height - y);
+      int rows_to_copy = std::min(chunk_size_in_rows, bottom - y);
       DCHECK_GT(rows_to_copy, 0);
 
-      gl->CopySubTextureCHROMIUM(GL_TEXTURE_2D, staging_buffer->texture_id,
-                                 resource_lock->texture_id(), 0, y, 0, y,
-                                 resource->size().width(), rows_to_copy, false,
-                                 false, false);
+      gl->CopySubTextureCHROMIUM(
+          GL_TEXTURE_2D, staging_buffer->texture_id,
+          resource_lock->texture_id(), copy_rect.x(), y, copy_rect.x(), y,
+          copy_rect.width(), rows_to_copy, false, false, false);
       y += rows_to_copy;
 
       // Increment |bytes_scheduled_since_last_flush_| by the amount of memory
@@ -527,6 +554,7 @@ void OneCopyTileTaskWorkerPool::PlaybackAndCopyOnWorkerThread(
   busy_buffers_.push_back(staging_buffer.Pass());
 
   ScheduleReduceMemoryUsage();
+  return playback_rect;
 }
 
 bool OneCopyTileTaskWorkerPool::OnMemoryDump(
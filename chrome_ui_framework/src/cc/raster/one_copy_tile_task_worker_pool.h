@@ -74,8 +74,9 @@ class CC_EXPORT OneCopyTileTaskWorkerPool
   bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
                     base::trace_event::ProcessMemoryDump* pmd) override;
 
-  // Playback raster source and copy result into |resource|.
-  void PlaybackAndCopyOnWorkerThread(
+  // Playback raster source and copy result into |resource|. Returns the part
+  // of |raster_full_rect| that was played back.
+  gfx::Rect PlaybackAndCopyOnWorkerThread(
       const Resource* resource,
       const ResourceProvider::ScopedWriteLockGL* resource_lock,
       const DisplayListRasterSource* raster_source,
@@ -83,8 +84,10 @@ class CC_EXPORT OneCopyTileTaskWorkerPool
       const gfx::Rect& raster_dirty_rect,
       float scale,
       bool include_images,
+      ImageDecodeController* image_decode_controller,
       uint64_t resource_content_id,
-      uint64_t previous_content_id);
+      uint64_t previous_content_id,
+      uint64_t new_content_id);
 
  protected:
   OneCopyTileTaskWorkerPool(base::SequencedTaskRunner* task_runner,
@@ -10,18 +10,26 @@
 
 namespace cc {
 class DisplayListRasterSource;
+class ImageDecodeController;
 
 class CC_EXPORT RasterBuffer {
  public:
   RasterBuffer();
   virtual ~RasterBuffer();
 
-  virtual void Playback(const DisplayListRasterSource* raster_source,
-                        const gfx::Rect& raster_full_rect,
-                        const gfx::Rect& raster_dirty_rect,
-                        uint64_t new_content_id,
-                        float scale,
-                        bool include_images) = 0;
+  // Plays |raster_source| back into the buffer, and returns the part of
+  // |raster_full_rect| that was played back. Only |raster_dirty_rect| needs to
+  // be played back if the buffer already holds the previous content. Software
+  // playback draws the images from the decodes of |image_decode_controller|,
+  // if not null.
+  virtual gfx::Rect Playback(
+      const DisplayListRasterSource* raster_source,
+      const gfx::Rect& raster_full_rect,
+      const gfx::Rect& raster_dirty_rect,
+      uint64_t new_content_id,
+      float scale,
+      bool include_images,
+      ImageDecodeController* image_decode_controller) = 0;
 };
 
 }  // namespace cc
@@ -120,16 +120,36 @@ void TaskGraph::Reset() {
   edges.clear();
 }
 
-TaskGraphRunner::TaskNamespace::TaskNamespace() {}
+TaskGraphRunner::TaskNamespace::TaskNamespace()
+    : worker_queue_task_count(0) {}
 
 TaskGraphRunner::TaskNamespace::~TaskNamespace() {}
 
+TaskGraphRunner::WorkerQueue::WorkerQueue() {}
+
+TaskGraphRunner::WorkerQueue::~WorkerQueue() {}
+
 TaskGraphRunner::TaskGraphRunner()
     : lock_(),
       has_ready_to_run_tasks_cv_(&lock_),
       has_namespaces_with_finished_running_tasks_cv_(&lock_),
       next_namespace_id_(1),
-      shutdown_(false) {}
+      shutdown_(false),
+      next_worker_index_(0),
+      worker_queue_ready_count_(0) {}
+
+TaskGraphRunner::TaskGraphRunner(size_t num_workers)
+    : lock_(),
+      has_ready_to_run_tasks_cv_(&lock_),
+      has_namespaces_with_finished_running_tasks_cv_(&lock_),
+      next_namespace_id_(1),
+      shutdown_(false),
+      next_worker_index_(0),
+      worker_queue_ready_count_(0) {
+  DCHECK_LT(0u, num_workers);
+  for (size_t i = 0; i < num_workers; ++i)
+    worker_queues_.push_back(make_scoped_ptr(new WorkerQueue));
+}
 
 TaskGraphRunner::~TaskGraphRunner() {
   {
@@ -177,6 +197,11 @@ void TaskGraphRunner::ScheduleTasks(NamespaceToken token, TaskGraph* graph) {
       }
     }
 
+    if (uses_work_stealing()) {
+      ScheduleTasksOnWorkerQueues(&task_namespace, graph);
+      return;
+    }
+
     // Build new "ready to run" queue and remove nodes from old graph.
     task_namespace.ready_to_run_tasks.clear();
     for (TaskGraph::Node::Vector::iterator it = graph->nodes.begin();
@@ -345,6 +370,13 @@ void TaskGraphRunner::FlushForTesting() {
 }
 
 void TaskGraphRunner::Run() {
+  if (uses_work_stealing()) {
+    size_t worker_index =
+        base::subtle::NoBarrier_AtomicIncrement(&next_worker_index_, 1) - 1;
+    RunWorker(worker_index % worker_queues_.size());
+    return;
+  }
+
   base::AutoLock lock(lock_);
 
   while (true) {
@@ -367,6 +399,11 @@ void TaskGraphRunner::Run() {
 }
 
 void TaskGraphRunner::RunUntilIdle() {
+  if (uses_work_stealing()) {
+    RunWorkerQueuesUntilIdle();
+    return;
+  }
+
   base::AutoLock lock(lock_);
 
   while (!ready_to_run_namespaces_.empty())
@@ -473,4 +510,244 @@ void TaskGraphRunner::RunTaskWithLockAcquired() {
     has_namespaces_with_finished_running_tasks_cv_.Signal();
 }
 
+void TaskGraphRunner::ScheduleTasksOnWorkerQueues(
+    TaskNamespace* task_namespace,
+    TaskGraph* graph) {
+  lock_.AssertAcquired();
+
+  // Take the queued tasks of this namespace back. Tasks that a worker has
+  // already taken keep running and are reported in |running_tasks|.
+  TaskVector running_tasks;
+  RemoveQueuedTasksWithLockAcquired(task_namespace, &running_tasks);
+
+  // Build new "ready to run" list and remove nodes from old graph.
+  QueuedTask::Vector ready_to_run_tasks;
+  for (const TaskGraph::Node& node : graph->nodes) {
+    TaskGraph::Node::Vector::iterator old_it =
+        std::find_if(task_namespace->graph.nodes.begin(),
+                     task_namespace->graph.nodes.end(),
+                     TaskGraph::Node::TaskComparator(node.task));
+    if (old_it != task_namespace->graph.nodes.end()) {
+      std::swap(*old_it, task_namespace->graph.nodes.back());
+      task_namespace->graph.nodes.pop_back();
+    }
+
+    if (node.dependencies || node.task->HasFinishedRunning())
+      continue;
+
+    if (std::find(running_tasks.begin(), running_tasks.end(), node.task) !=
+        running_tasks.end())
+      continue;
+
+    ready_to_run_tasks.push_back(
+        QueuedTask(node.task, task_namespace, node.priority));
+  }
+
+  // Swap task graph.
+  task_namespace->graph.Swap(graph);
+
+  // Determine what tasks in old graph need to be canceled.
+  for (const TaskGraph::Node& node : graph->nodes) {
+    if (node.task->HasFinishedRunning())
+      continue;
+
+    if (std::find(running_tasks.begin(), running_tasks.end(), node.task) !=
+        running_tasks.end())
+      continue;
+
+    DCHECK(std::find(task_namespace->completed_tasks.begin(),
+                     task_namespace->completed_tasks.end(),
+                     node.task) == task_namespace->completed_tasks.end());
+    task_namespace->completed_tasks.push_back(node.task);
+  }
+
+  if (ready_to_run_tasks.empty())
+    return;
+
+  // Deal the tasks out to the workers in priority order so that every worker
+  // starts with the most favorable work it can get.
+  std::stable_sort(ready_to_run_tasks.begin(), ready_to_run_tasks.end(),
+                   [](const QueuedTask& a, const QueuedTask& b) {
+                     return a.priority < b.priority;
+                   });
+  for (size_t i = 0; i < ready_to_run_tasks.size(); ++i) {
+    QueueTaskWithLockAcquired(worker_queues_[i % worker_queues_.size()],
+                              ready_to_run_tasks[i]);
+  }
+
+  if (ready_to_run_tasks.size() == 1)
+    has_ready_to_run_tasks_cv_.Signal();
+  else
+    has_ready_to_run_tasks_cv_.Broadcast();
+}
+
+void TaskGraphRunner::RunWorker(size_t worker_index) {
+  while (true) {
+    QueuedTask task(nullptr, nullptr, 0u);
+    WorkerQueue* source = nullptr;
+    if (TakeTask(worker_index, &task, &source)) {
+      RunQueuedTask(worker_index, task, source);
+      continue;
+    }
+
+    base::AutoLock lock(lock_);
+    // A task may have been queued after TakeTask() looked at the queues.
+    if (base::subtle::NoBarrier_Load(&worker_queue_ready_count_))
+      continue;
+
+    // Exit when shutdown is set and no more tasks are pending.
+    if (shutdown_)
+      break;
+
+    // Wait for more tasks.
+    has_ready_to_run_tasks_cv_.Wait();
+  }
+
+  // We noticed we should exit. Wake up the next worker so it knows it should
+  // exit as well (because the Shutdown() code only signals once).
+  base::AutoLock lock(lock_);
+  has_ready_to_run_tasks_cv_.Signal();
+}
+
+void TaskGraphRunner::RunWorkerQueuesUntilIdle() {
+  QueuedTask task(nullptr, nullptr, 0u);
+  WorkerQueue* source = nullptr;
+  while (TakeTask(0u, &task, &source))
+    RunQueuedTask(0u, task, source);
+}
+
+void TaskGraphRunner::RemoveQueuedTasksWithLockAcquired(
+    TaskNamespace* task_namespace,
+    TaskVector* running_tasks) {
+  lock_.AssertAcquired();
+
+  for (WorkerQueue* worker_queue : worker_queues_) {
+    base::AutoLock worker_lock(worker_queue->lock);
+
+    QueuedTask::Deque& ready_to_run_tasks = worker_queue->ready_to_run_tasks;
+    QueuedTask::Deque::iterator end = std::remove_if(
+        ready_to_run_tasks.begin(), ready_to_run_tasks.end(),
+        [task_namespace](const QueuedTask& task) {
+          return task.task_namespace == task_namespace;
+        });
+    size_t removed_count = ready_to_run_tasks.end() - end;
+    ready_to_run_tasks.erase(end, ready_to_run_tasks.end());
+    DCHECK_LE(removed_count, task_namespace->worker_queue_task_count);
+    task_namespace->worker_queue_task_count -= removed_count;
+    base::subtle::NoBarrier_AtomicIncrement(
+        &worker_queue_ready_count_, -static_cast<int>(removed_count));
+
+    for (const QueuedTask& task : worker_queue->running_tasks) {
+      if (task.task_namespace == task_namespace)
+        running_tasks->push_back(task.task);
+    }
+  }
+}
+
+void TaskGraphRunner::QueueTaskWithLockAcquired(WorkerQueue* worker_queue,
+                                                const QueuedTask& task) {
+  lock_.AssertAcquired();
+
+  task.task_namespace->worker_queue_task_count++;
+  base::subtle::NoBarrier_AtomicIncrement(&worker_queue_ready_count_, 1);
+
+  // Most favorable task first; tasks with equal priority run in FIFO order.
+  base::AutoLock worker_lock(worker_queue->lock);
+  QueuedTask::Deque& ready_to_run_tasks = worker_queue->ready_to_run_tasks;
+  ready_to_run_tasks.insert(
+      std::upper_bound(ready_to_run_tasks.begin(), ready_to_run_tasks.end(),
+                       task,
+                       [](const QueuedTask& a, const QueuedTask& b) {
+                         return a.priority < b.priority;
+                       }),
+      task);
+}
+
+bool TaskGraphRunner::TakeTask(size_t worker_index,
+                               QueuedTask* task,
+                               WorkerQueue** source) {
+  // Start with our own queue, then try the other workers in turn.
+  for (size_t i = 0; i < worker_queues_.size(); ++i) {
+    WorkerQueue* worker_queue =
+        worker_queues_[(worker_index + i) % worker_queues_.size()];
+    base::AutoLock worker_lock(worker_queue->lock);
+    if (worker_queue->ready_to_run_tasks.empty())
+      continue;
+
+    *task = worker_queue->ready_to_run_tasks.front();
+    worker_queue->ready_to_run_tasks.pop_front();
+    base::subtle::NoBarrier_AtomicIncrement(&worker_queue_ready_count_, -1);
+
+    // The task is visible to ScheduleTasks() as running from here on, so it
+    // will be neither canceled nor queued again. Call WillRun() before
+    // releasing the lock for the same reason.
+    worker_queue->running_tasks.push_back(*task);
+    task->task->WillRun();
+    *source = worker_queue;
+    return true;
+  }
+  return false;
+}
+
+void TaskGraphRunner::RunQueuedTask(size_t worker_index,
+                                    const QueuedTask& queued_task,
+                                    WorkerQueue* source) {
+  TRACE_EVENT0("toplevel", "TaskGraphRunner::RunTask");
+
+  // The origin thread keeps a reference to the task until it has been
+  // collected, which cannot happen before it is marked as finished below.
+  scoped_refptr<Task> task(queued_task.task);
+  task->RunOnWorkerThread();
+
+  base::AutoLock lock(lock_);
+
+  // This will mark task as finished running.
+  task->DidRun();
+
+  {
+    base::AutoLock worker_lock(source->lock);
+    QueuedTask::Vector& running_tasks = source->running_tasks;
+    QueuedTask::Vector::iterator it =
+        std::find_if(running_tasks.begin(), running_tasks.end(),
+                     [&task](const QueuedTask& running_task) {
+                       return running_task.task == task.get();
+                     });
+    DCHECK(it != running_tasks.end());
+    std::swap(*it, running_tasks.back());
+    running_tasks.pop_back();
+  }
+
+  TaskNamespace* task_namespace = queued_task.task_namespace;
+  DCHECK_LT(0u, task_namespace->worker_queue_task_count);
+  task_namespace->worker_queue_task_count--;
+
+  // Queue dependents that became ready on this worker. Other workers will
+  // steal them if this one falls behind.
+  size_t ready_count = 0;
+  for (DependentIterator it(&task_namespace->graph, task.get()); it; ++it) {
+    TaskGraph::Node& dependent_node = *it;
+
+    DCHECK_LT(0u, dependent_node.dependencies);
+    dependent_node.dependencies--;
+    if (!dependent_node.dependencies) {
+      QueueTaskWithLockAcquired(
+          worker_queues_[worker_index],
+          QueuedTask(dependent_node.task, task_namespace,
+                     dependent_node.priority));
+      ++ready_count;
+    }
+  }
+  // This worker takes one of them itself; wake up a worker for each of the
+  // others.
+  for (size_t i = 1; i < ready_count; ++i)
+    has_ready_to_run_tasks_cv_.Signal();
+
+  // Finally add task to |completed_tasks_|.
+  task_namespace->completed_tasks.push_back(task);
+
+  // If namespace has finished running all tasks, wake up origin thread.
+  if (HasFinishedRunningTasksInNamespace(task_namespace))
+    has_namespaces_with_finished_running_tasks_cv_.Signal();
+}
+
 }  // namespace cc
@@ -5,13 +5,16 @@
 #ifndef CC_RASTER_TASK_GRAPH_RUNNER_H_
 #define CC_RASTER_TASK_GRAPH_RUNNER_H_
 
+#include <deque>
 #include <map>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/condition_variable.h"
 #include "cc/base/cc_export.h"
+#include "cc/base/scoped_ptr_vector.h"
 
 namespace cc {
 
@@ -102,9 +105,19 @@ class CC_EXPORT NamespaceToken {
 // A TaskGraphRunner is used to process tasks with dependencies. There can
 // be any number of TaskGraphRunner instances per thread. Tasks can be scheduled
 // from any thread and they can be run on any thread.
+//
+// By default all scheduling goes through a single lock. A runner created with
+// a worker count instead gives each thread that calls Run() its own queue of
+// ready to run tasks. Workers take tasks from their own queue and steal from
+// the others when it runs dry, so taking a task does not touch the shared
+// lock. Finishing a task still takes the shared lock, once per task, to update
+// the dependency counts and completed tasks of its namespace. Tasks that
+// become ready when a dependency finishes are queued on the worker that ran
+// the dependency.
 class CC_EXPORT TaskGraphRunner {
  public:
   TaskGraphRunner();
+  explicit TaskGraphRunner(size_t num_workers);
   virtual ~TaskGraphRunner();
 
   // Returns a unique token that can be used to pass a task graph to
@@ -140,6 +153,8 @@ class CC_EXPORT TaskGraphRunner {
   // Wait for all the tasks to finish running on all the namespaces.
   void FlushForTesting();
 
+  bool uses_work_stealing() const { return !worker_queues_.empty(); }
+
  private:
   struct PrioritizedTask {
     typedef std::vector<PrioritizedTask> Vector;
@@ -170,6 +185,39 @@ class CC_EXPORT TaskGraphRunner {
 
     // This set contains all currently running tasks.
     TaskVector running_tasks;
+
+    // Number of tasks of this namespace that are queued or running on a
+    // WorkerQueue. Only used with work stealing, in which case
+    // |ready_to_run_tasks| and |running_tasks| stay empty.
+    size_t worker_queue_task_count;
+  };
+
+  struct QueuedTask {
+    typedef std::deque<QueuedTask> Deque;
+    typedef std::vector<QueuedTask> Vector;
+
+    QueuedTask(Task* task, TaskNamespace* task_namespace, size_t priority)
+        : task(task), task_namespace(task_namespace), priority(priority) {}
+
+    Task* task;
+    TaskNamespace* task_namespace;
+    size_t priority;
+  };
+
+  // Per-worker state used with work stealing.
+  struct WorkerQueue {
+    WorkerQueue();
+    ~WorkerQueue();
+
+    // Protects |ready_to_run_tasks| and |running_tasks|. When both are needed,
+    // |lock_| must be acquired before this lock.
+    base::Lock lock;
+
+    // Tasks that are ready to run, ordered by priority.
+    QueuedTask::Deque ready_to_run_tasks;
+
+    // Tasks taken from |ready_to_run_tasks| that have not finished running.
+    QueuedTask::Vector running_tasks;
   };
 
   typedef std::map<int, TaskNamespace> TaskNamespaceMap;
@@ -195,13 +243,44 @@ class CC_EXPORT TaskGraphRunner {
   static bool HasFinishedRunningTasksInNamespace(
       const TaskNamespace* task_namespace) {
     return task_namespace->running_tasks.empty() &&
-           task_namespace->ready_to_run_tasks.empty();
+           task_namespace->ready_to_run_tasks.empty() &&
+           !task_namespace->worker_queue_task_count;
   }
 
   // Run next task. Caller must acquire |lock_| prior to calling this function
   // and make sure at least one task is ready to run.
   void RunTaskWithLockAcquired();
 
+  // Work stealing counterparts of ScheduleTasks(), Run() and RunUntilIdle().
+  void ScheduleTasksOnWorkerQueues(TaskNamespace* task_namespace,
+                                   TaskGraph* graph);
+  void RunWorker(size_t worker_index);
+  void RunWorkerQueuesUntilIdle();
+
+  // Removes all queued tasks of |task_namespace| from the worker queues and
+  // appends the ones that are currently running to |running_tasks|. Caller
+  // must acquire |lock_|.
+  void RemoveQueuedTasksWithLockAcquired(TaskNamespace* task_namespace,
+                                         TaskVector* running_tasks);
+
+  // Adds |task| to |worker_queue| in priority order. Caller must acquire
+  // |lock_|.
+  void QueueTaskWithLockAcquired(WorkerQueue* worker_queue,
+                                 const QueuedTask& task);
+
+  // Takes the most favorable task from the queue of |worker_index|, or steals
+  // one from another queue if it is empty. |*source| is set to the queue the
+  // task was taken from. Returns false if all queues are empty.
+  bool TakeTask(size_t worker_index,
+                QueuedTask* task,
+                WorkerQueue** source);
+
+  // Runs a task returned by TakeTask() and queues its dependents that become
+  // ready to run on the queue of |worker_index|.
+  void RunQueuedTask(size_t worker_index,
+                     const QueuedTask& task,
+                     WorkerQueue* source);
+
   // This lock protects all members of this class. Do not read or modify
   // anything without holding this lock. Do not block while holding this lock.
   mutable base::Lock lock_;
@@ -227,6 +306,17 @@ class CC_EXPORT TaskGraphRunner {
   // Set during shutdown. Tells Run() to return when no more tasks are pending.
   bool shutdown_;
 
+  // One queue per worker when work stealing is used, empty otherwise.
+  ScopedPtrVector<WorkerQueue> worker_queues_;
+
+  // Hands out indices into |worker_queues_| to threads entering Run().
+  base::subtle::Atomic32 next_worker_index_;
+
+  // Number of tasks in all |worker_queues_| that have not been taken yet.
+  // Only incremented with |lock_| held, so that workers can check it before
+  // waiting on |has_ready_to_run_tasks_cv_| without missing a wake up.
+  base::subtle::Atomic32 worker_queue_ready_count_;
+
   DISALLOW_COPY_AND_ASSIGN(TaskGraphRunner);
 };
 
@@ -7,8 +7,11 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "cc/base/completion_event.h"
+#include "cc/base/scoped_ptr_deque.h"
 #include "cc/debug/lap_timer.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
@@ -37,7 +40,8 @@ class PerfTaskImpl : public Task {
   DISALLOW_COPY_AND_ASSIGN(PerfTaskImpl);
 };
 
-class TaskGraphRunnerPerfTest : public testing::Test {
+class TaskGraphRunnerPerfTest : public testing::Test,
+                                public base::DelegateSimpleThread::Delegate {
  public:
   TaskGraphRunnerPerfTest()
       : timer_(kWarmupRuns,
@@ -203,6 +207,72 @@ class TaskGraphRunnerPerfTest : public testing::Test {
                            true);
   }
 
+  // Like RunScheduleAndExecuteTasksTest() but the tasks are run by
+  // |num_workers| worker threads, using either the default runner or one
+  // with work stealing. The two only differ in how workers take tasks; both
+  // take the shared lock whenever a task finishes.
+  void RunExecuteTasksOnWorkersTest(const std::string& test_name,
+                                    int num_workers,
+                                    bool work_stealing,
+                                    int num_top_level_tasks,
+                                    int num_tasks,
+                                    int num_leaf_tasks) {
+    if (work_stealing)
+      task_graph_runner_ = make_scoped_ptr(new TaskGraphRunner(num_workers));
+    else
+      task_graph_runner_ = make_scoped_ptr(new TaskGraphRunner);
+    namespace_token_ = task_graph_runner_->GetNamespaceToken();
+
+    ScopedPtrDeque<base::DelegateSimpleThread> workers;
+    for (int i = 0; i < num_workers; ++i) {
+      workers.push_back(
+          make_scoped_ptr(new base::DelegateSimpleThread(this, "PerfWorker")));
+      workers.back()->Start();
+    }
+
+    PerfTaskImpl::Vector top_level_tasks;
+    PerfTaskImpl::Vector tasks;
+    PerfTaskImpl::Vector leaf_tasks;
+    CreateTasks(num_top_level_tasks, &top_level_tasks);
+    CreateTasks(num_tasks, &tasks);
+    CreateTasks(num_leaf_tasks, &leaf_tasks);
+
+    // Avoid unnecessary heap allocations by reusing the same graph and
+    // completed tasks vector.
+    TaskGraph graph;
+    Task::Vector completed_tasks;
+
+    const int num_tasks_per_run =
+        num_top_level_tasks + num_tasks + num_leaf_tasks;
+    timer_.Reset();
+    do {
+      graph.Reset();
+      BuildTaskGraph(top_level_tasks, tasks, leaf_tasks, &graph);
+      task_graph_runner_->ScheduleTasks(namespace_token_, &graph);
+      task_graph_runner_->WaitForTasksToFinishRunning(namespace_token_);
+      CollectCompletedTasks(&completed_tasks);
+      completed_tasks.clear();
+      ResetTasks(&top_level_tasks);
+      ResetTasks(&tasks);
+      ResetTasks(&leaf_tasks);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    task_graph_runner_->Shutdown();
+    while (!workers.empty())
+      workers.take_front()->Join();
+
+    perf_test::PrintResult(
+        "execute_tasks_on_workers",
+        work_stealing ? "_work_stealing_task_graph_runner"
+                      : TestModifierString(),
+        base::StringPrintf("%s_%d_workers", test_name.c_str(), num_workers),
+        timer_.LapsPerSecond() * num_tasks_per_run, "tasks/s", true);
+  }
+
+  // Overridden from base::DelegateSimpleThread::Delegate:
+  void Run() override { task_graph_runner_->Run(); }
+
  private:
   static std::string TestModifierString() {
     return std::string("_task_graph_runner");
@@ -308,5 +378,14 @@ TEST_F(TaskGraphRunnerPerfTest, ScheduleAndExecuteTasks) {
   RunScheduleAndExecuteTasksTest("2_32_1", 2, 32, 1);
 }
 
+TEST_F(TaskGraphRunnerPerfTest, ExecuteTasksOnWorkers) {
+  for (int num_workers = 1; num_workers <= 32; num_workers *= 2) {
+    RunExecuteTasksOnWorkersTest("0_256_0", num_workers, false, 0, 256, 0);
+    RunExecuteTasksOnWorkersTest("0_256_0", num_workers, true, 0, 256, 0);
+    RunExecuteTasksOnWorkersTest("1_256_1", num_workers, false, 1, 256, 1);
+    RunExecuteTasksOnWorkersTest("1_256_1", num_workers, true, 1, 256, 1);
+  }
+}
+
 }  // namespace
 }  // namespace cc
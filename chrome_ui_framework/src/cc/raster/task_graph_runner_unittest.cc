@@ -4,6 +4,7 @@
 
 #include "cc/raster/task_graph_runner.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "base/bind.h"
@@ -162,13 +163,18 @@ class TaskGraphRunnerTestBase {
   std::vector<unsigned> on_task_completed_ids_[kNamespaceCount];
 };
 
-class TaskGraphRunnerTest : public TaskGraphRunnerTestBase,
-                            public testing::TestWithParam<int>,
-                            public base::DelegateSimpleThread::Delegate {
+// Parameters are the number of worker threads and whether the runner uses
+// work stealing.
+class TaskGraphRunnerTest
+    : public TaskGraphRunnerTestBase,
+      public testing::TestWithParam<std::tr1::tuple<int, bool>>,
+      public base::DelegateSimpleThread::Delegate {
  public:
   // Overridden from testing::Test:
   void SetUp() override {
-    const size_t num_threads = GetParam();
+    const size_t num_threads = std::tr1::get<0>(GetParam());
+    if (std::tr1::get<1>(GetParam()))
+      task_graph_runner_.reset(new TaskGraphRunner(num_threads));
     while (workers_.size() < num_threads) {
       scoped_ptr<base::DelegateSimpleThread> worker =
           make_scoped_ptr(new base::DelegateSimpleThread(this, "TestWorker"));
@@ -275,17 +281,50 @@ TEST_P(TaskGraphRunnerTest, Dependencies) {
   }
 }
 
+TEST_P(TaskGraphRunnerTest, ManyDependencies) {
+  // Enough ready tasks for every worker to have some to run and some to lose
+  // to other workers, each with dependents that become ready on the worker
+  // that ran it.
+  const unsigned kTaskCount = 64;
+  for (int i = 0; i < kNamespaceCount; ++i) {
+    std::vector<TaskInfo> tasks;
+    for (unsigned j = 0; j < kTaskCount; ++j)
+      tasks.push_back(TaskInfo(i, j, kTaskCount + j, 2u, j % 4));
+    ScheduleTasks(i, tasks);
+  }
+
+  for (int i = 0; i < kNamespaceCount; ++i) {
+    RunAllTasks(i);
+
+    // Every task and every dependent ran exactly once, and only tasks, not
+    // dependents, are completed on the origin thread.
+    std::vector<unsigned> ids = run_task_ids(i);
+    ASSERT_EQ(3 * kTaskCount, ids.size());
+    std::sort(ids.begin(), ids.end());
+    for (unsigned j = 0; j < kTaskCount; ++j) {
+      EXPECT_EQ(j, ids[j]);
+      EXPECT_EQ(kTaskCount + j, ids[kTaskCount + 2 * j]);
+      EXPECT_EQ(kTaskCount + j, ids[kTaskCount + 2 * j + 1]);
+    }
+    EXPECT_EQ(kTaskCount, on_task_completed_ids(i).size());
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(TaskGraphRunnerTests,
                         TaskGraphRunnerTest,
-                        ::testing::Range(1, 5));
+                        ::testing::Combine(::testing::Range(1, 5),
+                                           ::testing::Bool()));
 
+// The parameter is whether the runner uses work stealing.
 class TaskGraphRunnerSingleThreadTest
     : public TaskGraphRunnerTestBase,
-      public testing::Test,
+      public testing::TestWithParam<bool>,
       public base::DelegateSimpleThread::Delegate {
  public:
   // Overridden from testing::Test:
   void SetUp() override {
+    if (GetParam())
+      task_graph_runner_.reset(new TaskGraphRunner(1u));
     worker_.reset(new base::DelegateSimpleThread(this, "TestWorker"));
     worker_->Start();
 
@@ -304,7 +343,7 @@ class TaskGraphRunnerSingleThreadTest
   scoped_ptr<base::DelegateSimpleThread> worker_;
 };
 
-TEST_F(TaskGraphRunnerSingleThreadTest, Priority) {
+TEST_P(TaskGraphRunnerSingleThreadTest, Priority) {
   for (int i = 0; i < kNamespaceCount; ++i) {
     TaskInfo tasks[] = {TaskInfo(i, 0u, 2u, 1u, 1u),  // Priority 1
                         TaskInfo(i, 1u, 3u, 1u, 0u)   // Priority 0
@@ -327,5 +366,9 @@ TEST_F(TaskGraphRunnerSingleThreadTest, Priority) {
   }
 }
 
+INSTANTIATE_TEST_CASE_P(TaskGraphRunnerSingleThreadTests,
+                        TaskGraphRunnerSingleThreadTest,
+                        ::testing::Bool());
+
 }  // namespace
 }  // namespace cc
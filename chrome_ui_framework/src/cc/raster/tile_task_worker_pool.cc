@@ -8,6 +8,7 @@
 
 #include "base/trace_event/trace_event.h"
 #include "cc/playback/display_list_raster_source.h"
+#include "cc/raster/image_hijack_canvas.h"
 #include "skia/ext/refptr.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkDrawFilter.h"
@@ -164,6 +165,29 @@ class SkipImageFilter : public SkDrawFilter {
   }
 };
 
+namespace {
+
+// Plays |raster_source| back to |canvas|. Images are drawn from the decodes
+// of |image_decode_controller|, if not null.
+void PlaybackToSoftwareCanvas(SkCanvas* canvas,
+                              const DisplayListRasterSource* raster_source,
+                              const gfx::Rect& canvas_bitmap_rect,
+                              const gfx::Rect& canvas_playback_rect,
+                              float scale,
+                              ImageDecodeController* image_decode_controller) {
+  if (!image_decode_controller) {
+    raster_source->PlaybackToCanvas(canvas, canvas_bitmap_rect,
+                                    canvas_playback_rect, scale);
+    return;
+  }
+
+  ImageHijackCanvas hijack_canvas(canvas, image_decode_controller);
+  raster_source->PlaybackToCanvas(&hijack_canvas, canvas_bitmap_rect,
+                                  canvas_playback_rect, scale);
+}
+
+}  // namespace
+
 // static
 void TileTaskWorkerPool::PlaybackToMemory(
     void* memory,
@@ -174,10 +198,13 @@ void TileTaskWorkerPool::PlaybackToMemory(
     const gfx::Rect& canvas_bitmap_rect,
     const gfx::Rect& canvas_playback_rect,
     float scale,
-    bool include_images) {
+    bool include_images,
+    ImageDecodeController* image_decode_controller) {
   TRACE_EVENT0("cc", "TileTaskWorkerPool::PlaybackToMemory");
 
   DCHECK(IsSupportedPlaybackToMemoryFormat(format)) << format;
+  // The images are skipped, so there are no decodes to draw them from.
+  DCHECK(include_images || !image_decode_controller);
 
   // Uses kPremul_SkAlphaType since the result is not known to be opaque.
   SkImageInfo info =
@@ -205,8 +232,9 @@ void TileTaskWorkerPool::PlaybackToMemory(
         SkSurface::NewRasterDirect(info, memory, stride, &surface_props));
     skia::RefPtr<SkCanvas> canvas = skia::SharePtr(surface->getCanvas());
     canvas->setDrawFilter(image_filter.get());
-    raster_source->PlaybackToCanvas(canvas.get(), canvas_bitmap_rect,
-                                    canvas_playback_rect, scale);
+    PlaybackToSoftwareCanvas(canvas.get(), raster_source, canvas_bitmap_rect,
+                             canvas_playback_rect, scale,
+                             image_decode_controller);
     return;
   }
 
@@ -214,14 +242,21 @@ void TileTaskWorkerPool::PlaybackToMemory(
       skia::AdoptRef(SkSurface::NewRaster(info, &surface_props));
   skia::RefPtr<SkCanvas> canvas = skia::SharePtr(surface->getCanvas());
   canvas->setDrawFilter(image_filter.get());
-  // TODO(reveman): Improve partial raster support by reducing the size of
-  // playback rect passed to PlaybackToCanvas. crbug.com/519070
-  raster_source->PlaybackToCanvas(canvas.get(), canvas_bitmap_rect,
-                                  canvas_bitmap_rect, scale);
+  // Only the playback rect is played back and converted, the rest of |memory|
+  // is left as is.
+  PlaybackToSoftwareCanvas(canvas.get(), raster_source, canvas_bitmap_rect,
+                           canvas_playback_rect, scale,
+                           image_decode_controller);
 
   {
     TRACE_EVENT0("cc", "TileTaskWorkerPool::PlaybackToMemory::ConvertPixels");
 
+    gfx::Rect copy_rect =
+        canvas_playback_rect - canvas_bitmap_rect.OffsetFromOrigin();
+    copy_rect.Intersect(gfx::Rect(size));
+    if (copy_rect.IsEmpty())
+      return;
+
     SkImageInfo dst_info =
         SkImageInfo::Make(info.width(), info.height(), buffer_color_type,
                           info.alphaType(), info.profileType());
@@ -230,7 +265,12 @@ void TileTaskWorkerPool::PlaybackToMemory(
     // is fixed.
     const size_t dst_row_bytes = SkAlign4(dst_info.minRowBytes());
     DCHECK_EQ(0u, dst_row_bytes % 4);
-    bool success = canvas->readPixels(dst_info, memory, dst_row_bytes, 0, 0);
+    uint8_t* dst_pixels = static_cast<uint8_t*>(memory) +
+                          copy_rect.y() * dst_row_bytes +
+                          copy_rect.x() * dst_info.bytesPerPixel();
+    bool success = canvas->readPixels(
+        dst_info.makeWH(copy_rect.width(), copy_rect.height()), dst_pixels,
+        dst_row_bytes, copy_rect.x(), copy_rect.y());
     DCHECK_EQ(true, success);
   }
 }
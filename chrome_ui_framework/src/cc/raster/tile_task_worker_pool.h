@@ -15,6 +15,7 @@ class SequencedTaskRunner;
 
 namespace cc {
 class DisplayListRasterSource;
+class ImageDecodeController;
 class RenderingStatsInstrumentation;
 
 class CC_EXPORT TileTaskWorkerPool {
@@ -59,6 +60,8 @@ class CC_EXPORT TileTaskWorkerPool {
   // that will cover the resulting |memory|. The |canvas_playback_rect| can be a
   // smaller contained rect inside the |canvas_bitmap_rect| if the |memory| is
   // already partially complete, and only the subrect needs to be played back.
+  // Images are drawn from the decodes of |image_decode_controller|, if not
+  // null.
   static void PlaybackToMemory(void* memory,
                                ResourceFormat format,
                                const gfx::Size& size,
@@ -67,7 +70,8 @@ class CC_EXPORT TileTaskWorkerPool {
                                const gfx::Rect& canvas_bitmap_rect,
                                const gfx::Rect& canvas_playback_rect,
                                float scale,
-                               bool include_images);
+                               bool include_images,
+                               ImageDecodeController* image_decode_controller);
 
   // Type-checking downcast routine.
   virtual TileTaskRunner* AsTileTaskRunner() = 0;
@@ -41,6 +41,7 @@ const size_t kMaxStagingBuffers = 32U;
 
 enum TileTaskWorkerPoolType {
   TILE_TASK_WORKER_POOL_TYPE_ZERO_COPY,
+  TILE_TASK_WORKER_POOL_TYPE_PARTIAL_ZERO_COPY,
   TILE_TASK_WORKER_POOL_TYPE_ONE_COPY,
   TILE_TASK_WORKER_POOL_TYPE_GPU,
   TILE_TASK_WORKER_POOL_TYPE_BITMAP
@@ -65,7 +66,8 @@ class TestRasterTaskImpl : public RasterTask {
   void RunOnWorkerThread() override {
     uint64_t new_content_id = 0;
     raster_buffer_->Playback(raster_source_.get(), gfx::Rect(1, 1),
-                             gfx::Rect(1, 1), new_content_id, 1.f, true);
+                             gfx::Rect(1, 1), new_content_id, 1.f, true,
+                             nullptr);
   }
 
   // Overridden from TileTask:
@@ -143,10 +145,12 @@ class TileTaskWorkerPoolTest
   void SetUp() override {
     switch (GetParam()) {
       case TILE_TASK_WORKER_POOL_TYPE_ZERO_COPY:
+      case TILE_TASK_WORKER_POOL_TYPE_PARTIAL_ZERO_COPY:
         Create3dOutputSurfaceAndResourceProvider();
         tile_task_worker_pool_ = ZeroCopyTileTaskWorkerPool::Create(
             base::ThreadTaskRunnerHandle::Get().get(), &task_graph_runner_,
-            resource_provider_.get(), false);
+            resource_provider_.get(),
+            GetParam() == TILE_TASK_WORKER_POOL_TYPE_PARTIAL_ZERO_COPY, false);
         break;
       case TILE_TASK_WORKER_POOL_TYPE_ONE_COPY:
         Create3dOutputSurfaceAndResourceProvider();
@@ -406,12 +410,14 @@ TEST_P(TileTaskWorkerPoolTest, ScheduleEmptyStillTriggersCallback) {
   EXPECT_TRUE(completed_task_sets_[ALL]);
 }
 
-INSTANTIATE_TEST_CASE_P(TileTaskWorkerPoolTests,
-                        TileTaskWorkerPoolTest,
-                        ::testing::Values(TILE_TASK_WORKER_POOL_TYPE_ZERO_COPY,
-                                          TILE_TASK_WORKER_POOL_TYPE_ONE_COPY,
-                                          TILE_TASK_WORKER_POOL_TYPE_GPU,
-                                          TILE_TASK_WORKER_POOL_TYPE_BITMAP));
+INSTANTIATE_TEST_CASE_P(
+    TileTaskWorkerPoolTests,
+    TileTaskWorkerPoolTest,
+    ::testing::Values(TILE_TASK_WORKER_POOL_TYPE_ZERO_COPY,
+                      TILE_TASK_WORKER_POOL_TYPE_PARTIAL_ZERO_COPY,
+                      TILE_TASK_WORKER_POOL_TYPE_ONE_COPY,
+                      TILE_TASK_WORKER_POOL_TYPE_GPU,
+                      TILE_TASK_WORKER_POOL_TYPE_BITMAP));
 
 }  // namespace
 }  // namespace cc
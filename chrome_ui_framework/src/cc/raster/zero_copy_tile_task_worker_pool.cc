@@ -22,19 +22,33 @@ namespace {
 class RasterBufferImpl : public RasterBuffer {
  public:
   RasterBufferImpl(ResourceProvider* resource_provider,
-                   const Resource* resource)
-      : lock_(resource_provider, resource->id()), resource_(resource) {}
+                   const Resource* resource,
+                   bool use_partial_raster,
+                   uint64_t resource_content_id,
+                   uint64_t previous_content_id)
+      : lock_(resource_provider, resource->id()),
+        resource_(resource),
+        use_partial_raster_(use_partial_raster),
+        resource_has_previous_content_(
+            use_partial_raster && resource_content_id &&
+            resource_content_id == previous_content_id) {}
 
   // Overridden from RasterBuffer:
-  void Playback(const DisplayListRasterSource* raster_source,
-                const gfx::Rect& raster_full_rect,
-                const gfx::Rect& raster_dirty_rect,
-                uint64_t new_content_id,
-                float scale,
-                bool include_images) override {
-    gfx::GpuMemoryBuffer* gpu_memory_buffer = lock_.GetGpuMemoryBuffer();
+  gfx::Rect Playback(const DisplayListRasterSource* raster_source,
+                     const gfx::Rect& raster_full_rect,
+                     const gfx::Rect& raster_dirty_rect,
+                     uint64_t new_content_id,
+                     float scale,
+                     bool include_images,
+                     ImageDecodeController* image_decode_controller) override {
+    // If using partial raster, the buffer has to keep its pixels between
+    // tasks, which needs a buffer with BufferUsage PERSISTENT_MAP.
+    gfx::GpuMemoryBuffer* gpu_memory_buffer =
+        lock_.GetGpuMemoryBuffer(use_partial_raster_
+                                     ? gfx::BufferUsage::PERSISTENT_MAP
+                                     : gfx::BufferUsage::MAP);
     if (!gpu_memory_buffer)
-      return;
+      return gfx::Rect();
     DCHECK_EQ(
         1u, gfx::NumberOfPlanesForBufferFormat(gpu_memory_buffer->GetFormat()));
     void* data = NULL;
@@ -44,17 +58,26 @@ class RasterBufferImpl : public RasterBuffer {
     gpu_memory_buffer->GetStride(&stride);
     // TileTaskWorkerPool::PlaybackToMemory only supports unsigned strides.
     DCHECK_GE(stride, 0);
-    // TODO(danakj): Implement partial raster with raster_dirty_rect.
+
+    gfx::Rect playback_rect = raster_full_rect;
+    if (resource_has_previous_content_)
+      playback_rect.Intersect(raster_dirty_rect);
+    DCHECK(!playback_rect.IsEmpty())
+        << "Why are we rastering a tile that's not dirty?";
+
     TileTaskWorkerPool::PlaybackToMemory(
         data, resource_->format(), resource_->size(),
         static_cast<size_t>(stride), raster_source, raster_full_rect,
-        raster_full_rect, scale, include_images);
+        playback_rect, scale, include_images, image_decode_controller);
     gpu_memory_buffer->Unmap();
+    return playback_rect;
   }
 
  private:
   ResourceProvider::ScopedWriteLockGpuMemoryBuffer lock_;
   const Resource* resource_;
+  bool use_partial_raster_;
+  bool resource_has_previous_content_;
 
   DISALLOW_COPY_AND_ASSIGN(RasterBufferImpl);
 };
@@ -66,9 +89,10 @@ scoped_ptr<TileTaskWorkerPool> ZeroCopyTileTaskWorkerPool::Create(
     base::SequencedTaskRunner* task_runner,
     TaskGraphRunner* task_graph_runner,
     ResourceProvider* resource_provider,
+    bool use_partial_raster,
     bool use_rgba_4444_texture_format) {
   return make_scoped_ptr<TileTaskWorkerPool>(new ZeroCopyTileTaskWorkerPool(
-      task_runner, task_graph_runner, resource_provider,
+      task_runner, task_graph_runner, resource_provider, use_partial_raster,
       use_rgba_4444_texture_format));
 }
 
@@ -76,11 +100,13 @@ ZeroCopyTileTaskWorkerPool::ZeroCopyTileTaskWorkerPool(
     base::SequencedTaskRunner* task_runner,
     TaskGraphRunner* task_graph_runner,
     ResourceProvider* resource_provider,
+    bool use_partial_raster,
     bool use_rgba_4444_texture_format)
     : task_runner_(task_runner),
       task_graph_runner_(task_graph_runner),
       namespace_token_(task_graph_runner->GetNamespaceToken()),
       resource_provider_(resource_provider),
+      use_partial_raster_(use_partial_raster),
       use_rgba_4444_texture_format_(use_rgba_4444_texture_format),
       task_set_finished_weak_ptr_factory_(this) {}
 
@@ -200,7 +226,8 @@ scoped_ptr<RasterBuffer> ZeroCopyTileTaskWorkerPool::AcquireBufferForRaster(
     uint64_t resource_content_id,
     uint64_t previous_content_id) {
   return make_scoped_ptr<RasterBuffer>(
-      new RasterBufferImpl(resource_provider_, resource));
+      new RasterBufferImpl(resource_provider_, resource, use_partial_raster_,
+                           resource_content_id, previous_content_id));
 }
 
 void ZeroCopyTileTaskWorkerPool::ReleaseBufferForRaster(
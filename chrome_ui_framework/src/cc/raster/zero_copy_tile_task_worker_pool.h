@@ -29,6 +29,7 @@ class CC_EXPORT ZeroCopyTileTaskWorkerPool : public TileTaskWorkerPool,
       base::SequencedTaskRunner* task_runner,
       TaskGraphRunner* task_graph_runner,
       ResourceProvider* resource_provider,
+      bool use_partial_raster,
       bool use_rgba_4444_texture_format);
 
   // Overridden from TileTaskWorkerPool:
@@ -53,6 +54,7 @@ class CC_EXPORT ZeroCopyTileTaskWorkerPool : public TileTaskWorkerPool,
   ZeroCopyTileTaskWorkerPool(base::SequencedTaskRunner* task_runner,
                              TaskGraphRunner* task_graph_runner,
                              ResourceProvider* resource_provider,
+                             bool use_partial_raster,
                              bool use_rgba_4444_texture_format);
 
  private:
@@ -66,6 +68,7 @@ class CC_EXPORT ZeroCopyTileTaskWorkerPool : public TileTaskWorkerPool,
   TileTaskRunnerClient* client_;
   ResourceProvider* resource_provider_;
 
+  const bool use_partial_raster_;
   bool use_rgba_4444_texture_format_;
 
   TaskSetCollection tasks_pending_;
@@ -312,7 +312,9 @@ class CC_EXPORT ResourceProvider
                                    ResourceId resource_id);
     ~ScopedWriteLockGpuMemoryBuffer();
 
+    // Allocates a buffer with |usage| if the resource doesn't have one yet.
     gfx::GpuMemoryBuffer* GetGpuMemoryBuffer();
+    gfx::GpuMemoryBuffer* GetGpuMemoryBuffer(gfx::BufferUsage usage);
 
    private:
     ResourceProvider* resource_provider_;
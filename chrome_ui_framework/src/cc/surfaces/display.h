@@ -38,6 +38,7 @@ class Surface;
 class SurfaceAggregator;
 class SurfaceIdAllocator;
 class SurfaceFactory;
+class TaskGraphRunner;
 class TextureMailboxDeleter;
 
 // A Display produces a surface that can be used to draw to a physical display
@@ -52,7 +53,8 @@ class CC_SURFACES_EXPORT Display : public DisplaySchedulerClient,
           SurfaceManager* manager,
           SharedBitmapManager* bitmap_manager,
           gpu::GpuMemoryBufferManager* gpu_memory_buffer_manager,
-          const RendererSettings& settings);
+          const RendererSettings& settings,
+          TaskGraphRunner* task_graph_runner);
   ~Display() override;
 
   bool Initialize(scoped_ptr<OutputSurface> output_surface,
@@ -103,6 +105,7 @@ class CC_SURFACES_EXPORT Display : public DisplaySchedulerClient,
   SharedBitmapManager* bitmap_manager_;
   gpu::GpuMemoryBufferManager* gpu_memory_buffer_manager_;
   RendererSettings settings_;
+  TaskGraphRunner* task_graph_runner_;
   SurfaceId current_surface_id_;
   gfx::Size current_surface_size_;
   float device_scale_factor_;
@@ -144,7 +144,7 @@ TEST_F(DisplayTest, DisplayDamaged) {
   settings.partial_swap_enabled = true;
   settings.finish_rendering_on_resize = true;
   Display display(&client, &manager_, shared_bitmap_manager_.get(), nullptr,
-                  settings);
+                  settings, nullptr);
 
   TestDisplayScheduler scheduler(&display, &fake_begin_frame_source_,
                                  task_runner_.get());
@@ -377,7 +377,7 @@ TEST_F(DisplayTest, Finish) {
   settings.partial_swap_enabled = true;
   settings.finish_rendering_on_resize = true;
   Display display(&client, &manager_, shared_bitmap_manager_.get(), nullptr,
-                  settings);
+                  settings, nullptr);
 
   TestDisplayScheduler scheduler(&display, &fake_begin_frame_source_,
                                  task_runner_.get());
@@ -20,13 +20,15 @@ OnscreenDisplayClient::OnscreenDisplayClient(
     SharedBitmapManager* bitmap_manager,
     gpu::GpuMemoryBufferManager* gpu_memory_buffer_manager,
     const RendererSettings& settings,
+    TaskGraphRunner* task_graph_runner,
     scoped_refptr<base::SingleThreadTaskRunner> task_runner)
     : output_surface_(output_surface.Pass()),
       display_(new Display(this,
                            manager,
                            bitmap_manager,
                            gpu_memory_buffer_manager,
-                           settings)),
+                           settings,
+                           task_graph_runner)),
       task_runner_(task_runner),
       output_surface_lost_(false),
       disable_display_vsync_(settings.disable_display_vsync) {
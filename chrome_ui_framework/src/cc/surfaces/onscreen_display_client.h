@@ -34,6 +34,7 @@ class CC_SURFACES_EXPORT OnscreenDisplayClient
       SharedBitmapManager* bitmap_manager,
       gpu::GpuMemoryBufferManager* gpu_memory_buffer_manager,
       const RendererSettings& settings,
+      TaskGraphRunner* task_graph_runner,
       scoped_refptr<base::SingleThreadTaskRunner> task_runner);
   ~OnscreenDisplayClient() override;
 
@@ -31,6 +31,7 @@ class FakeOnscreenDisplayClient : public OnscreenDisplayClient {
                               bitmap_manager,
                               gpu_memory_buffer_manager,
                               settings,
+                              nullptr,
                               task_runner) {
     // Ownership is passed to another object later, store a pointer
     // to it now for future reference.
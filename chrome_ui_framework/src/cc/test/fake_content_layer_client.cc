@@ -28,6 +28,7 @@ FakeContentLayerClient::ImageData::~ImageData() {}
 
 FakeContentLayerClient::FakeContentLayerClient()
     : fill_with_nonsolid_color_(false),
+      use_cached_picture_(true),
       last_canvas_(nullptr),
       last_painting_control_(PAINTING_BEHAVIOR_NORMAL),
       reported_memory_usage_(0) {}
@@ -39,10 +40,10 @@ scoped_refptr<DisplayItemList>
 FakeContentLayerClient::PaintContentsToDisplayList(
     const gfx::Rect& clip,
     PaintingControlSetting painting_control) {
-  // Cached picture is used because unit tests expect to be able to
-  // use GatherPixelRefs.
+  // Cached picture is used by default because unit tests expect to be able
+  // to use GatherPixelRefs.
   DisplayItemListSettings settings;
-  settings.use_cached_picture = true;
+  settings.use_cached_picture = use_cached_picture_;
   scoped_refptr<DisplayItemList> display_list =
       DisplayItemList::Create(clip, settings);
   SkPictureRecorder recorder;
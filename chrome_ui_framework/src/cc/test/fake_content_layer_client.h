@@ -48,6 +48,10 @@ class FakeContentLayerClient : public ContentLayerClient {
     fill_with_nonsolid_color_ = nonsolid;
   }
 
+  void set_use_cached_picture(bool use_cached_picture) {
+    use_cached_picture_ = use_cached_picture;
+  }
+
   void add_draw_rect(const gfx::Rect& rect, const SkPaint& paint) {
     draw_rects_.push_back(std::make_pair(gfx::RectF(rect), paint));
   }
@@ -85,6 +89,7 @@ class FakeContentLayerClient : public ContentLayerClient {
   typedef std::vector<ImageData> ImageVector;
 
   bool fill_with_nonsolid_color_;
+  bool use_cached_picture_;
   RectPaintVector draw_rects_;
   ImageVector draw_images_;
   SkCanvas* last_canvas_;
@@ -99,6 +99,10 @@ class FakeDisplayListRecordingSource : public DisplayListRecordingSource {
 
   void set_default_paint(const SkPaint& paint) { default_paint_ = paint; }
 
+  void set_use_cached_picture(bool use_cached_picture) {
+    client_.set_use_cached_picture(use_cached_picture);
+  }
+
   void set_reported_memory_usage(size_t reported_memory_usage) {
     client_.set_reported_memory_usage(reported_memory_usage);
   }
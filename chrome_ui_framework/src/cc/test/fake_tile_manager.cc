@@ -26,6 +26,17 @@ class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
          it != queue->items.end(); ++it) {
       RasterTask* task = it->task;
 
+      // Image decode tasks can be shared by raster tasks, and are completed
+      // once.
+      for (const auto& decode_task : task->dependencies()) {
+        if (decode_task->HasBeenScheduled())
+          continue;
+        decode_task->WillSchedule();
+        decode_task->ScheduleOnOriginThread(this);
+        decode_task->DidSchedule();
+        completed_tasks_.push_back(decode_task);
+      }
+
       task->WillSchedule();
       task->ScheduleOnOriginThread(this);
       task->DidSchedule();
@@ -34,10 +45,10 @@ class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
     }
   }
   void CheckForCompletedTasks() override {
-    for (RasterTask::Vector::iterator it = completed_tasks_.begin();
+    for (TileTask::Vector::iterator it = completed_tasks_.begin();
          it != completed_tasks_.end();
          ++it) {
-      RasterTask* task = it->get();
+      TileTask* task = it->get();
 
       task->WillComplete();
       task->CompleteOnOriginThread(this);
@@ -63,7 +74,7 @@ class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
   void ReleaseBufferForRaster(scoped_ptr<RasterBuffer> buffer) override {}
 
  private:
-  RasterTask::Vector completed_tasks_;
+  TileTask::Vector completed_tasks_;
 };
 base::LazyInstance<FakeTileTaskRunnerImpl> g_fake_tile_task_runner =
     LAZY_INSTANCE_INITIALIZER;
@@ -74,9 +85,11 @@ FakeTileManager::FakeTileManager(TileManagerClient* client)
     : TileManager(client,
                   base::ThreadTaskRunnerHandle::Get(),
                   std::numeric_limits<size_t>::max(),
-                  false /* use_partial_raster */) {
+                  false /* use_partial_raster */,
+                  nullptr /* rendering_stats_instrumentation */) {
   SetResources(nullptr, g_fake_tile_task_runner.Pointer(),
-               std::numeric_limits<size_t>::max());
+               std::numeric_limits<size_t>::max(),
+               false /* use_gpu_rasterization */);
 }
 
 FakeTileManager::FakeTileManager(TileManagerClient* client,
@@ -84,9 +97,11 @@ FakeTileManager::FakeTileManager(TileManagerClient* client,
     : TileManager(client,
                   base::ThreadTaskRunnerHandle::Get(),
                   std::numeric_limits<size_t>::max(),
-                  false /* use_partial_raster */) {
+                  false /* use_partial_raster */,
+                  nullptr /* rendering_stats_instrumentation */) {
   SetResources(resource_pool, g_fake_tile_task_runner.Pointer(),
-               std::numeric_limits<size_t>::max());
+               std::numeric_limits<size_t>::max(),
+               false /* use_gpu_rasterization */);
 }
 
 FakeTileManager::~FakeTileManager() {}
@@ -26,6 +26,7 @@
 #include "cc/test/test_gpu_memory_buffer_manager.h"
 #include "cc/test/test_in_process_context_provider.h"
 #include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
 #include "cc/trees/blocking_task_runner.h"
 #include "gpu/command_buffer/client/gles2_interface.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -178,9 +179,11 @@ void PixelTest::SetUpSoftwareRenderer() {
       output_surface_.get(), shared_bitmap_manager_.get(),
       gpu_memory_buffer_manager_.get(), main_thread_task_runner_.get(), 0, 1,
       settings_.use_image_texture_targets);
-  renderer_ =
-      SoftwareRenderer::Create(this, &settings_.renderer_settings,
-                               output_surface_.get(), resource_provider_.get());
+  if (settings_.renderer_settings.software_renderer_band_count > 1)
+    task_graph_runner_.reset(new TestTaskGraphRunner);
+  renderer_ = SoftwareRenderer::Create(
+      this, &settings_.renderer_settings, output_surface_.get(),
+      resource_provider_.get(), task_graph_runner_.get());
 }
 
 }  // namespace cc
@@ -24,6 +24,7 @@ class ResourceProvider;
 class SoftwareRenderer;
 class TestGpuMemoryBufferManager;
 class TestSharedBitmapManager;
+class TestTaskGraphRunner;
 
 class PixelTest : public testing::Test, RendererClient {
  protected:
@@ -54,6 +55,7 @@ class PixelTest : public testing::Test, RendererClient {
   scoped_ptr<OutputSurface> output_surface_;
   scoped_ptr<TestSharedBitmapManager> shared_bitmap_manager_;
   scoped_ptr<TestGpuMemoryBufferManager> gpu_memory_buffer_manager_;
+  scoped_ptr<TestTaskGraphRunner> task_graph_runner_;
   scoped_ptr<BlockingTaskRunner> main_thread_task_runner_;
   scoped_ptr<ResourceProvider> resource_provider_;
   scoped_ptr<TextureMailboxDeleter> texture_mailbox_deleter_;
@@ -118,7 +120,26 @@ class SoftwareRendererWithExpandedViewport : public SoftwareRenderer {
                                        const RendererSettings* settings,
                                        OutputSurface* output_surface,
                                        ResourceProvider* resource_provider)
-      : SoftwareRenderer(client, settings, output_surface, resource_provider) {}
+      : SoftwareRenderer(client,
+                         settings,
+                         output_surface,
+                         resource_provider,
+                         nullptr) {}
+};
+
+// Wrapper for the software renderer drawing render passes in parallel bands.
+class SoftwareRendererWithBands : public SoftwareRenderer {
+ public:
+  SoftwareRendererWithBands(RendererClient* client,
+                            const RendererSettings* settings,
+                            OutputSurface* output_surface,
+                            ResourceProvider* resource_provider,
+                            TaskGraphRunner* task_graph_runner)
+      : SoftwareRenderer(client,
+                         settings,
+                         output_surface,
+                         resource_provider,
+                         task_graph_runner) {}
 };
 
 class GLRendererWithFlippedSurface : public GLRenderer {
@@ -166,6 +187,12 @@ inline void RendererPixelTest<SoftwareRendererWithExpandedViewport>::SetUp() {
   ForceViewportOffset(gfx::Vector2d(10, 20));
 }
 
+template <>
+inline void RendererPixelTest<SoftwareRendererWithBands>::SetUp() {
+  settings_.renderer_settings.software_renderer_band_count = 4;
+  SetUpSoftwareRenderer();
+}
+
 typedef RendererPixelTest<GLRenderer> GLRendererPixelTest;
 typedef RendererPixelTest<SoftwareRenderer> SoftwareRendererPixelTest;
 
@@ -8,6 +8,7 @@
 #include "skia/ext/refptr.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkImageGenerator.h"
+#include "third_party/skia/include/core/SkUtils.h"
 #include "ui/gfx/geometry/rect.h"
 #include "ui/gfx/skia_util.h"
 
@@ -19,6 +20,24 @@ class TestImageGenerator : public SkImageGenerator {
  public:
   explicit TestImageGenerator(const SkImageInfo& info)
       : SkImageGenerator(info) {}
+
+ protected:
+  // Decodes to opaque blue.
+  bool onGetPixels(const SkImageInfo& info,
+                   void* pixels,
+                   size_t row_bytes,
+                   SkPMColor ctable[],
+                   int* ctable_count) override {
+    if (info.colorType() != kN32_SkColorType)
+      return false;
+    for (int y = 0; y < info.height(); ++y) {
+      sk_memset32(
+          reinterpret_cast<uint32_t*>(static_cast<char*>(pixels) +
+                                      y * row_bytes),
+          SkPreMultiplyColor(SK_ColorBLUE), info.width());
+    }
+    return true;
+  }
 };
 
 }  // anonymous namespace
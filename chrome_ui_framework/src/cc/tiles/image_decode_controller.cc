@@ -4,29 +4,78 @@
 
 #include "cc/tiles/image_decode_controller.h"
 
+#include <algorithm>
+
+#include "base/memory/discardable_memory.h"
+#include "base/memory/discardable_memory_allocator.h"
+#include "base/trace_event/trace_event.h"
 #include "cc/debug/devtools_instrumentation.h"
+#include "skia/ext/image_operations.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkImage.h"
 
 namespace cc {
 namespace {
 
+// The deepest mip level that an image is decoded at.
+const int kMaxMipLevel = 16;
+
 class ImageDecodeTaskImpl : public ImageDecodeTask {
  public:
   ImageDecodeTaskImpl(ImageDecodeController* controller,
-                      const SkImage* image,
-                      int layer_id,
+                      const DrawImage& image,
                       uint64_t source_prepare_tiles_id)
       : controller_(controller),
-        image_(skia::SharePtr(image)),
-        layer_id_(layer_id),
+        image_(image),
+        image_ref_(skia::SharePtr(image.image())),
         source_prepare_tiles_id_(source_prepare_tiles_id) {}
 
   // Overridden from Task:
   void RunOnWorkerThread() override {
     TRACE_EVENT1("cc", "ImageDecodeTaskImpl::RunOnWorkerThread",
                  "source_prepare_tiles_id", source_prepare_tiles_id_);
+    devtools_instrumentation::ScopedImageDecodeTask image_decode_task(
+        image_ref_.get());
+    controller_->DecodeImage(image_, image_ref_.get());
+  }
+
+  // Overridden from TileTask:
+  void ScheduleOnOriginThread(TileTaskClient* client) override {}
+  void CompleteOnOriginThread(TileTaskClient* client) override {
+    controller_->OnImageDecodeTaskCompleted(image_);
+  }
+
+ protected:
+  ~ImageDecodeTaskImpl() override {}
+
+ private:
+  ImageDecodeController* controller_;
+  DrawImage image_;
+  // Keeps the image of |image_| alive until the task completes.
+  skia::RefPtr<const SkImage> image_ref_;
+  uint64_t source_prepare_tiles_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageDecodeTaskImpl);
+};
+
+// Lets Skia decode an image ahead of GPU raster, into its own cache.
+class ImagePrerollTaskImpl : public ImageDecodeTask {
+ public:
+  ImagePrerollTaskImpl(ImageDecodeController* controller,
+                       const SkImage* image,
+                       uint64_t source_prepare_tiles_id)
+      : controller_(controller),
+        image_id_(image->uniqueID()),
+        image_(skia::SharePtr(image)),
+        source_prepare_tiles_id_(source_prepare_tiles_id) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override {
+    TRACE_EVENT1("cc", "ImagePrerollTaskImpl::RunOnWorkerThread",
+                 "source_prepare_tiles_id", source_prepare_tiles_id_);
     devtools_instrumentation::ScopedImageDecodeTask image_decode_task(
         image_.get());
-    controller_->DecodeImage(image_.get());
+    image_->preroll();
 
     // Release the reference after decoding image to ensure that it is not kept
     // alive unless needed.
@@ -36,85 +85,365 @@ class ImageDecodeTaskImpl : public ImageDecodeTask {
   // Overridden from TileTask:
   void ScheduleOnOriginThread(TileTaskClient* client) override {}
   void CompleteOnOriginThread(TileTaskClient* client) override {
-    controller_->OnImageDecodeTaskCompleted(layer_id_, image_.get(),
-                                            !HasFinishedRunning());
+    controller_->OnImagePrerollTaskCompleted(image_id_);
   }
 
  protected:
-  ~ImageDecodeTaskImpl() override {}
+  ~ImagePrerollTaskImpl() override {}
 
  private:
   ImageDecodeController* controller_;
+  uint32_t image_id_;
   skia::RefPtr<const SkImage> image_;
-  int layer_id_;
   uint64_t source_prepare_tiles_id_;
 
-  DISALLOW_COPY_AND_ASSIGN(ImageDecodeTaskImpl);
+  DISALLOW_COPY_AND_ASSIGN(ImagePrerollTaskImpl);
 };
 
+// Returns the scale that |matrix| draws at along the axis that it scales the
+// most.
+float GetMaxScale(const SkMatrix& matrix) {
+  const float x_scale = SkPoint::Length(matrix.getScaleX(), matrix.getSkewY());
+  const float y_scale = SkPoint::Length(matrix.getSkewX(), matrix.getScaleY());
+  return std::max(x_scale, y_scale);
+}
+
 }  // namespace
 
-ImageDecodeController::ImageDecodeController() {}
+// static
+const size_t ImageDecodeController::kDefaultMemoryLimitBytes;
+
+ImageDecodeController::DecodedDrawImage::DecodedDrawImage(
+    const SkImage* image,
+    const SkSize& scale,
+    SkFilterQuality filter_quality)
+    : image_(skia::SharePtr(image)),
+      scale_(scale),
+      filter_quality_(filter_quality) {}
+
+ImageDecodeController::DecodedDrawImage::~DecodedDrawImage() {}
+
+ImageDecodeController::DecodedImage::DecodedImage(
+    const SkImageInfo& info,
+    scoped_ptr<base::DiscardableMemory> memory)
+    : info_(info), memory_(memory.Pass()), locked_(true) {
+  CreateImage();
+}
+
+ImageDecodeController::DecodedImage::~DecodedImage() {
+  if (locked_)
+    memory_->Unlock();
+}
+
+bool ImageDecodeController::DecodedImage::Lock() {
+  DCHECK(!locked_);
+  if (!memory_->Lock())
+    return false;
+  locked_ = true;
+  CreateImage();
+  return true;
+}
+
+void ImageDecodeController::DecodedImage::Unlock() {
+  DCHECK(locked_);
+  image_.clear();
+  memory_->Unlock();
+  locked_ = false;
+}
+
+void ImageDecodeController::DecodedImage::CreateImage() {
+  image_ = skia::AdoptRef(SkImage::NewFromRaster(
+      info_, memory_->data(), info_.minRowBytes(), nullptr, nullptr));
+}
+
+ImageDecodeController::ImageDecodeController()
+    : ImageDecodeController(kDefaultMemoryLimitBytes) {}
+
+ImageDecodeController::ImageDecodeController(size_t memory_limit_bytes)
+    : memory_limit_bytes_(memory_limit_bytes),
+      locked_memory_usage_(0),
+      decoded_images_(DecodedImageCache::NO_AUTO_EVICT),
+      unlocked_memory_usage_(0) {}
 
 ImageDecodeController::~ImageDecodeController() {}
 
-scoped_refptr<ImageDecodeTask> ImageDecodeController::GetTaskForImage(
+bool ImageDecodeController::GetTaskForImageAndRef(
     const DrawImage& image,
-    int layer_id,
-    uint64_t prepare_tiles_id) {
-  uint32_t generation_id = image.image()->uniqueID();
-  scoped_refptr<ImageDecodeTask>& decode_task =
-      image_decode_tasks_[layer_id][generation_id];
-  if (!decode_task)
-    decode_task = CreateTaskForImage(image.image(), layer_id, prepare_tiles_id);
-  return decode_task;
+    uint64_t prepare_tiles_id,
+    scoped_refptr<ImageDecodeTask>* task) {
+  const ImageKey key = GetKey(image);
+  const size_t size =
+      GetSize(GetDecodedImageInfo(image.image(), key.mip_level));
+  *task = nullptr;
+
+  base::AutoLock hold(lock_);
+  auto task_it = pending_image_tasks_.find(key);
+  if (task_it != pending_image_tasks_.end()) {
+    // The task refs the decode, so this can't go over the budget.
+    bool did_ref = RefDecode(key, size);
+    DCHECK(did_ref);
+    *task = task_it->second;
+    return true;
+  }
+
+  if (!RefDecode(key, size))
+    return false;
+  if (decoded_images_.Get(key) != decoded_images_.end())
+    return true;
+
+  // The task also refs the decode, until it completes.
+  RefDecode(key, size);
+  *task = make_scoped_refptr(
+      new ImageDecodeTaskImpl(this, image, prepare_tiles_id));
+  pending_image_tasks_[key] = *task;
+  return true;
 }
 
-scoped_refptr<ImageDecodeTask> ImageDecodeController::CreateTaskForImage(
-    const SkImage* image,
-    int layer_id,
-    uint64_t prepare_tiles_id) {
-  return make_scoped_refptr(
-      new ImageDecodeTaskImpl(this, image, layer_id, prepare_tiles_id));
+void ImageDecodeController::UnrefImage(const DrawImage& image) {
+  const ImageKey key = GetKey(image);
+  const size_t size =
+      GetSize(GetDecodedImageInfo(image.image(), key.mip_level));
+
+  base::AutoLock hold(lock_);
+  UnrefDecode(key, size);
 }
 
-void ImageDecodeController::DecodeImage(const SkImage* image) {
-  image->preroll();
+scoped_refptr<ImageDecodeTask> ImageDecodeController::GetPrerollTaskForImage(
+    const DrawImage& image,
+    uint64_t prepare_tiles_id) {
+  scoped_refptr<ImageDecodeTask>& task =
+      pending_preroll_tasks_[image.image()->uniqueID()];
+  if (!task) {
+    task = make_scoped_refptr(
+        new ImagePrerollTaskImpl(this, image.image(), prepare_tiles_id));
+  }
+  return task;
 }
 
-void ImageDecodeController::AddLayerUsedCount(int layer_id) {
-  ++used_layer_counts_[layer_id];
+ImageDecodeController::DecodedDrawImage
+ImageDecodeController::GetDecodedImageForDraw(const DrawImage& image) {
+  if (!image.image()->isLazyGenerated())
+    return DecodedDrawImage(nullptr, SkSize::Make(1.f, 1.f),
+                            image.filter_quality());
+
+  const ImageKey key = GetKey(image);
+  base::AutoLock hold(lock_);
+  auto ref_it = ref_counts_.find(key);
+  DecodedImageCache::iterator image_it = decoded_images_.Peek(key);
+  if (ref_it == ref_counts_.end() || image_it == decoded_images_.end())
+    return DecodedDrawImage(nullptr, SkSize::Make(1.f, 1.f),
+                            image.filter_quality());
+
+  ++ref_it->second;
+  const DecodedImage* decoded_image = image_it->second;
+  DCHECK(decoded_image->is_locked());
+  const SkImageInfo& info = decoded_image->info();
+  const SkSize scale =
+      SkSize::Make(static_cast<float>(info.width()) / image.image()->width(),
+                   static_cast<float>(info.height()) / image.image()->height());
+  // The decode is already scaled down as medium quality filtering would with
+  // mipmaps, so it only needs bilinear filtering.
+  SkFilterQuality filter_quality = image.filter_quality();
+  if (key.mip_level && filter_quality == kMedium_SkFilterQuality)
+    filter_quality = kLow_SkFilterQuality;
+  return DecodedDrawImage(decoded_image->image(), scale, filter_quality);
 }
 
-void ImageDecodeController::SubtractLayerUsedCount(int layer_id) {
-  if (--used_layer_counts_[layer_id])
+void ImageDecodeController::DrawWithImageFinished(
+    const DrawImage& image,
+    const DecodedDrawImage& decoded_image) {
+  if (!decoded_image.image())
     return;
-
-  // Clean up decode tasks once a layer is no longer used.
-  used_layer_counts_.erase(layer_id);
-  image_decode_tasks_.erase(layer_id);
+  UnrefImage(image);
 }
 
-void ImageDecodeController::OnImageDecodeTaskCompleted(int layer_id,
-                                                       const SkImage* image,
-                                                       bool was_canceled) {
-  // If the task has successfully finished, then keep the task until the layer
-  // is no longer in use. This ensures that we only decode a image once.
-  // TODO(vmpstr): Remove this when decode lifetime is controlled by cc.
-  if (!was_canceled)
+void ImageDecodeController::DecodeImage(const DrawImage& draw_image,
+                                        const SkImage* image) {
+  const ImageKey key = GetKey(draw_image);
+  {
+    base::AutoLock hold(lock_);
+    if (decoded_images_.Peek(key) != decoded_images_.end())
+      return;
+  }
+
+  // Decode without holding the lock, so that raster isn't blocked.
+  scoped_ptr<DecodedImage> decoded_image = Decode(image, key.mip_level);
+  if (!decoded_image)
     return;
 
-  // Otherwise, we have to clean up the task so that a new one can be created if
-  // we need to decode the image again.
-  LayerImageTaskMap::iterator layer_it = image_decode_tasks_.find(layer_id);
-  if (layer_it == image_decode_tasks_.end())
+  base::AutoLock hold(lock_);
+  if (decoded_images_.Peek(key) != decoded_images_.end())
     return;
+  if (ref_counts_.find(key) == ref_counts_.end()) {
+    decoded_image->Unlock();
+    unlocked_memory_usage_ += GetSize(decoded_image->info());
+  }
+  decoded_images_.Put(key, decoded_image.release());
+  ReduceCacheUsage();
+}
+
+void ImageDecodeController::OnImageDecodeTaskCompleted(
+    const DrawImage& image) {
+  const ImageKey key = GetKey(image);
+  const size_t size =
+      GetSize(GetDecodedImageInfo(image.image(), key.mip_level));
+
+  base::AutoLock hold(lock_);
+  pending_image_tasks_.erase(key);
+  UnrefDecode(key, size);
+}
+
+void ImageDecodeController::OnImagePrerollTaskCompleted(uint32_t image_id) {
+  pending_preroll_tasks_.erase(image_id);
+}
+
+size_t ImageDecodeController::GetLockedMemoryUsageForTesting() {
+  base::AutoLock hold(lock_);
+  return locked_memory_usage_;
+}
+
+size_t ImageDecodeController::GetMemoryUsageForTesting() {
+  base::AutoLock hold(lock_);
+  return locked_memory_usage_ + unlocked_memory_usage_;
+}
+
+size_t ImageDecodeController::GetDecodedImageCountForTesting() {
+  base::AutoLock hold(lock_);
+  return decoded_images_.size();
+}
 
-  ImageTaskMap& image_tasks = layer_it->second;
-  ImageTaskMap::iterator task_it = image_tasks.find(image->uniqueID());
-  if (task_it == image_tasks.end())
+// static
+ImageDecodeController::ImageKey ImageDecodeController::GetKey(
+    const DrawImage& image) {
+  ImageKey key;
+  key.image_id = image.image()->uniqueID();
+  key.mip_level = 0;
+
+  // Images drawn without filtering are decoded as is, since sampling a
+  // smaller decode would pick different pixels, and so are images drawn in
+  // perspective, whose scale varies.
+  const SkMatrix& matrix = image.matrix();
+  if (image.filter_quality() == kNone_SkFilterQuality ||
+      matrix.hasPerspective()) {
+    return key;
+  }
+
+  // Go down one mip level for as long as the decode stays at least as large
+  // as the image is drawn.
+  float scale = GetMaxScale(matrix);
+  const int width = image.image()->width();
+  const int height = image.image()->height();
+  while (key.mip_level < kMaxMipLevel && scale <= 0.5f &&
+         (width >> (key.mip_level + 1)) && (height >> (key.mip_level + 1))) {
+    scale *= 2.f;
+    ++key.mip_level;
+  }
+  return key;
+}
+
+// static
+SkImageInfo ImageDecodeController::GetDecodedImageInfo(const SkImage* image,
+                                                       int mip_level) {
+  return SkImageInfo::MakeN32Premul(std::max(1, image->width() >> mip_level),
+                                    std::max(1, image->height() >> mip_level));
+}
+
+// static
+size_t ImageDecodeController::GetSize(const SkImageInfo& info) {
+  return info.getSafeSize(info.minRowBytes());
+}
+
+// static
+scoped_ptr<ImageDecodeController::DecodedImage> ImageDecodeController::Decode(
+    const SkImage* image,
+    int mip_level) {
+  TRACE_EVENT1("cc", "ImageDecodeController::Decode", "mip_level", mip_level);
+  const SkImageInfo info = GetDecodedImageInfo(image, mip_level);
+  scoped_ptr<base::DiscardableMemory> memory =
+      base::DiscardableMemoryAllocator::GetInstance()
+          ->AllocateLockedDiscardableMemory(GetSize(info));
+
+  if (!mip_level) {
+    if (!image->readPixels(info, memory->data(), info.minRowBytes(), 0, 0)) {
+      memory->Unlock();
+      return nullptr;
+    }
+  } else {
+    // Box filtering the whole decode down to the size of the mip level
+    // averages the same pixels as halving it |mip_level| times would.
+    SkBitmap bitmap;
+    SkBitmap scaled_bitmap;
+    if (bitmap.tryAllocPixels(SkImageInfo::MakeN32Premul(image->width(),
+                                                         image->height())) &&
+        image->readPixels(bitmap.info(), bitmap.getPixels(),
+                          bitmap.rowBytes(), 0, 0)) {
+      scaled_bitmap = skia::ImageOperations::Resize(
+          bitmap, skia::ImageOperations::RESIZE_BOX, info.width(),
+          info.height());
+    }
+    if (scaled_bitmap.isNull() ||
+        !scaled_bitmap.readPixels(info, memory->data(), info.minRowBytes(), 0,
+                                  0)) {
+      memory->Unlock();
+      return nullptr;
+    }
+  }
+  return make_scoped_ptr(new DecodedImage(info, memory.Pass()));
+}
+
+bool ImageDecodeController::RefDecode(const ImageKey& key, size_t size) {
+  lock_.AssertAcquired();
+  auto ref_it = ref_counts_.find(key);
+  if (ref_it != ref_counts_.end()) {
+    ++ref_it->second;
+    return true;
+  }
+
+  if (locked_memory_usage_ + size > memory_limit_bytes_)
+    return false;
+  ref_counts_[key] = 1;
+  locked_memory_usage_ += size;
+
+  DecodedImageCache::iterator image_it = decoded_images_.Peek(key);
+  if (image_it != decoded_images_.end()) {
+    unlocked_memory_usage_ -= size;
+    // Purged pixels have to be decoded again.
+    if (!image_it->second->Lock())
+      decoded_images_.Erase(image_it);
+  }
+  ReduceCacheUsage();
+  return true;
+}
+
+void ImageDecodeController::UnrefDecode(const ImageKey& key, size_t size) {
+  lock_.AssertAcquired();
+  auto ref_it = ref_counts_.find(key);
+  DCHECK(ref_it != ref_counts_.end());
+  if (--ref_it->second)
     return;
-  image_tasks.erase(task_it);
+
+  ref_counts_.erase(ref_it);
+  locked_memory_usage_ -= size;
+  DecodedImageCache::iterator image_it = decoded_images_.Peek(key);
+  if (image_it != decoded_images_.end()) {
+    image_it->second->Unlock();
+    unlocked_memory_usage_ += size;
+  }
+  ReduceCacheUsage();
+}
+
+void ImageDecodeController::ReduceCacheUsage() {
+  lock_.AssertAcquired();
+  DecodedImageCache::reverse_iterator it = decoded_images_.rbegin();
+  while (locked_memory_usage_ + unlocked_memory_usage_ > memory_limit_bytes_ &&
+         it != decoded_images_.rend()) {
+    if (it->second->is_locked()) {
+      ++it;
+      continue;
+    }
+    unlocked_memory_usage_ -= GetSize(it->second->info());
+    it = decoded_images_.Erase(it);
+  }
 }
 
 }  // namespace cc
@@ -5,47 +5,175 @@
 #ifndef CC_TILES_IMAGE_DECODE_CONTROLLER_H_
 #define CC_TILES_IMAGE_DECODE_CONTROLLER_H_
 
-#include "base/containers/hash_tables.h"
+#include <map>
+
+#include "base/containers/mru_cache.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
 #include "cc/base/cc_export.h"
-#include "cc/playback/discardable_image_map.h"
+#include "cc/playback/draw_image.h"
 #include "cc/raster/tile_task_runner.h"
 #include "skia/ext/refptr.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
+#include "third_party/skia/include/core/SkSize.h"
+
+class SkImage;
+
+namespace base {
+class DiscardableMemory;
+}
 
 namespace cc {
 
-class ImageDecodeController {
+// ImageDecodeController decodes the discardable images that tiles draw ahead
+// of raster, and keeps the decodes in a cache that is shared by all of the
+// layers and across frames. An image is decoded once for each mip level that
+// it is drawn at: a decode is scaled down by a power of two, to the smallest
+// size that is still at least as large as the image is drawn, so that an
+// image drawn at 10% scale costs about 1/64th of its full decode.
+//
+// A decode is locked, and can't be purged, as long as a raster task that
+// draws it or a decode task that produces it refs it. Unlocked decodes are
+// kept in discardable memory for future frames, in most recently used order.
+// Locked and unlocked decodes together fit in a byte budget: unlocked decodes
+// are deleted to make room, and an image that doesn't fit in the budget with
+// the decodes that are locked is left for Skia to decode at raster.
+class CC_EXPORT ImageDecodeController {
  public:
+  // The decode to draw in place of an image, and the scale from the image to
+  // the decode. |image| is null if the image isn't decoded, and has to be
+  // drawn as is.
+  class CC_EXPORT DecodedDrawImage {
+   public:
+    DecodedDrawImage(const SkImage* image,
+                     const SkSize& scale,
+                     SkFilterQuality filter_quality);
+    ~DecodedDrawImage();
+
+    const SkImage* image() const { return image_.get(); }
+    const SkSize& scale() const { return scale_; }
+    SkFilterQuality filter_quality() const { return filter_quality_; }
+
+   private:
+    skia::RefPtr<const SkImage> image_;
+    SkSize scale_;
+    SkFilterQuality filter_quality_;
+  };
+
+  static const size_t kDefaultMemoryLimitBytes = 128 * 1024 * 1024;
+
   ImageDecodeController();
+  explicit ImageDecodeController(size_t memory_limit_bytes);
   ~ImageDecodeController();
 
-  scoped_refptr<ImageDecodeTask> GetTaskForImage(const DrawImage& image,
-                                                 int layer_id,
-                                                 uint64_t prepare_tiles_id);
+  // Refs the decode of |image| for a raster task, and returns true, if the
+  // decode fits in the budget. Sets |task| to the task that the raster task
+  // has to depend on, or to null if the decode is already done. The caller
+  // has to call UnrefImage() once the raster task completes. Returns false if
+  // the image is to be drawn as is.
+  bool GetTaskForImageAndRef(const DrawImage& image,
+                             uint64_t prepare_tiles_id,
+                             scoped_refptr<ImageDecodeTask>* task);
+  void UnrefImage(const DrawImage& image);
+
+  // Returns the task that prerolls |image| for GPU raster, which draws the
+  // original images and can't use the decodes. The decode that the preroll
+  // does is owned by Skia, and isn't part of the budget.
+  scoped_refptr<ImageDecodeTask> GetPrerollTaskForImage(
+      const DrawImage& image,
+      uint64_t prepare_tiles_id);
+
+  // Returns the decode to draw |image| with at raster, which is kept locked
+  // until DrawWithImageFinished() is called. Only decodes that a raster task
+  // refs are returned. This and the functions below have to remain thread
+  // safe.
+  DecodedDrawImage GetDecodedImageForDraw(const DrawImage& image);
+  void DrawWithImageFinished(const DrawImage& image,
+                             const DecodedDrawImage& decoded_image);
 
-  // Note that this function has to remain thread safe.
-  void DecodeImage(const SkImage* image);
+  // Decodes |image| at the mip level of |draw_image|.
+  void DecodeImage(const DrawImage& draw_image, const SkImage* image);
 
-  // TODO(vmpstr): This should go away once the controller is decoding images
-  // based on priority and memory.
-  void AddLayerUsedCount(int layer_id);
-  void SubtractLayerUsedCount(int layer_id);
+  void OnImageDecodeTaskCompleted(const DrawImage& image);
+  void OnImagePrerollTaskCompleted(uint32_t image_id);
 
-  void OnImageDecodeTaskCompleted(int layer_id,
-                                  const SkImage* image,
-                                  bool was_canceled);
+  size_t memory_limit_bytes() const { return memory_limit_bytes_; }
+  size_t GetLockedMemoryUsageForTesting();
+  size_t GetMemoryUsageForTesting();
+  size_t GetDecodedImageCountForTesting();
 
  private:
-  scoped_refptr<ImageDecodeTask> CreateTaskForImage(const SkImage* image,
-                                                    int layer_id,
-                                                    uint64_t prepare_tiles_id);
+  // Identifies a decode: the image, and the mip level that it is decoded at.
+  struct ImageKey {
+    uint32_t image_id;
+    int mip_level;
+
+    bool operator<(const ImageKey& other) const {
+      return image_id < other.image_id ||
+             (image_id == other.image_id && mip_level < other.mip_level);
+    }
+  };
+
+  // The pixels of a decode, which can only be drawn while they are locked.
+  class DecodedImage {
+   public:
+    DecodedImage(const SkImageInfo& info,
+                 scoped_ptr<base::DiscardableMemory> memory);
+    ~DecodedImage();
+
+    const SkImageInfo& info() const { return info_; }
+    const SkImage* image() const { return image_.get(); }
+    bool is_locked() const { return locked_; }
+
+    // Returns false if the pixels were purged while they were unlocked.
+    bool Lock();
+    void Unlock();
+
+   private:
+    void CreateImage();
+
+    SkImageInfo info_;
+    scoped_ptr<base::DiscardableMemory> memory_;
+    skia::RefPtr<SkImage> image_;
+    bool locked_;
+
+    DISALLOW_COPY_AND_ASSIGN(DecodedImage);
+  };
+
+  using DecodedImageCache = base::OwningMRUCache<ImageKey, DecodedImage*>;
+
+  static ImageKey GetKey(const DrawImage& image);
+  static SkImageInfo GetDecodedImageInfo(const SkImage* image, int mip_level);
+  static size_t GetSize(const SkImageInfo& info);
+  static scoped_ptr<DecodedImage> Decode(const SkImage* image, int mip_level);
+
+  // These have to be called with |lock_| acquired. RefDecode() returns false
+  // if the decode doesn't fit in the budget.
+  bool RefDecode(const ImageKey& key, size_t size);
+  void UnrefDecode(const ImageKey& key, size_t size);
+  void ReduceCacheUsage();
+
+  const size_t memory_limit_bytes_;
+
+  // The pending decode tasks. Only used on the origin thread.
+  std::map<ImageKey, scoped_refptr<ImageDecodeTask>> pending_image_tasks_;
+  // The pending preroll tasks, by image id. Only used on the origin thread.
+  std::map<uint32_t, scoped_refptr<ImageDecodeTask>> pending_preroll_tasks_;
+
+  // Protects the members below, which raster threads use.
+  base::Lock lock_;
+
+  // The number of refs to each decode that is locked, and the bytes of these
+  // decodes, whether they are done or not.
+  std::map<ImageKey, int> ref_counts_;
+  size_t locked_memory_usage_;
 
-  using ImageTaskMap = base::hash_map<uint32_t, scoped_refptr<ImageDecodeTask>>;
-  using LayerImageTaskMap = base::hash_map<int, ImageTaskMap>;
-  LayerImageTaskMap image_decode_tasks_;
+  // The decodes that are done, and the bytes of those that are unlocked.
+  DecodedImageCache decoded_images_;
+  size_t unlocked_memory_usage_;
 
-  using LayerCountMap = base::hash_map<int, int>;
-  LayerCountMap used_layer_counts_;
+  DISALLOW_COPY_AND_ASSIGN(ImageDecodeController);
 };
 
 }  // namespace cc
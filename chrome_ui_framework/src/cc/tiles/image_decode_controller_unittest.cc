@@ -0,0 +1,204 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/image_decode_controller.h"
+
+#include "cc/playback/draw_image.h"
+#include "cc/test/skia_common.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace cc {
+namespace {
+
+const size_t kBytesPerPixel = 4;
+
+DrawImage CreateDrawImage(const SkImage* image,
+                          float scale,
+                          SkFilterQuality filter_quality) {
+  SkMatrix matrix;
+  matrix.setScale(scale, scale);
+  return DrawImage(image, matrix, filter_quality);
+}
+
+// Runs and completes |task| as a tile task worker pool would.
+void RunTask(ImageDecodeTask* task) {
+  task->RunOnWorkerThread();
+  task->WillComplete();
+  task->CompleteOnOriginThread(nullptr);
+  task->DidComplete();
+}
+
+TEST(ImageDecodeControllerTest, MipLevel) {
+  ImageDecodeController controller;
+  skia::RefPtr<SkImage> image = CreateDiscardableImage(gfx::Size(1000, 800));
+
+  // An image drawn at 20% is decoded at a quarter of its size, which is the
+  // smallest power of two that is at least as large as it is drawn.
+  DrawImage draw_image =
+      CreateDrawImage(image.get(), 0.2f, kMedium_SkFilterQuality);
+  scoped_refptr<ImageDecodeTask> task;
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 1u, &task));
+  ASSERT_TRUE(task);
+  EXPECT_EQ(250u * 200u * kBytesPerPixel,
+            controller.GetLockedMemoryUsageForTesting());
+  RunTask(task.get());
+
+  ImageDecodeController::DecodedDrawImage decoded_image =
+      controller.GetDecodedImageForDraw(draw_image);
+  ASSERT_TRUE(decoded_image.image());
+  EXPECT_EQ(250, decoded_image.image()->width());
+  EXPECT_EQ(200, decoded_image.image()->height());
+  EXPECT_FLOAT_EQ(0.25f, decoded_image.scale().width());
+  EXPECT_FLOAT_EQ(0.25f, decoded_image.scale().height());
+  EXPECT_EQ(kLow_SkFilterQuality, decoded_image.filter_quality());
+  controller.DrawWithImageFinished(draw_image, decoded_image);
+  controller.UnrefImage(draw_image);
+  EXPECT_EQ(0u, controller.GetLockedMemoryUsageForTesting());
+
+  // Images drawn without filtering, or upscaled, are decoded at full size.
+  draw_image = CreateDrawImage(image.get(), 0.2f, kNone_SkFilterQuality);
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 1u, &task));
+  ASSERT_TRUE(task);
+  EXPECT_EQ(1000u * 800u * kBytesPerPixel,
+            controller.GetLockedMemoryUsageForTesting());
+  RunTask(task.get());
+  controller.UnrefImage(draw_image);
+
+  draw_image = CreateDrawImage(image.get(), 1.5f, kLow_SkFilterQuality);
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 1u, &task));
+  EXPECT_FALSE(task);
+  controller.UnrefImage(draw_image);
+}
+
+TEST(ImageDecodeControllerTest, DecodeIsShared) {
+  ImageDecodeController controller;
+  skia::RefPtr<SkImage> image = CreateDiscardableImage(gfx::Size(100, 100));
+
+  // Images drawn at the same mip level share a decode task.
+  DrawImage draw_image =
+      CreateDrawImage(image.get(), 0.5f, kLow_SkFilterQuality);
+  DrawImage other_draw_image =
+      CreateDrawImage(image.get(), 0.4f, kLow_SkFilterQuality);
+  scoped_refptr<ImageDecodeTask> task;
+  scoped_refptr<ImageDecodeTask> other_task;
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 1u, &task));
+  EXPECT_TRUE(
+      controller.GetTaskForImageAndRef(other_draw_image, 1u, &other_task));
+  ASSERT_TRUE(task);
+  EXPECT_EQ(task, other_task);
+  EXPECT_EQ(50u * 50u * kBytesPerPixel,
+            controller.GetLockedMemoryUsageForTesting());
+  RunTask(task.get());
+  EXPECT_EQ(1u, controller.GetDecodedImageCountForTesting());
+
+  // Once decoded, the decode is reused without a task, also after it is
+  // unlocked.
+  controller.UnrefImage(draw_image);
+  controller.UnrefImage(other_draw_image);
+  EXPECT_EQ(0u, controller.GetLockedMemoryUsageForTesting());
+  EXPECT_EQ(50u * 50u * kBytesPerPixel, controller.GetMemoryUsageForTesting());
+
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 2u, &task));
+  EXPECT_FALSE(task);
+  ImageDecodeController::DecodedDrawImage decoded_image =
+      controller.GetDecodedImageForDraw(draw_image);
+  EXPECT_TRUE(decoded_image.image());
+  controller.DrawWithImageFinished(draw_image, decoded_image);
+  controller.UnrefImage(draw_image);
+}
+
+TEST(ImageDecodeControllerTest, OnlyRefedDecodesAreDrawn) {
+  ImageDecodeController controller;
+  skia::RefPtr<SkImage> image = CreateDiscardableImage(gfx::Size(100, 100));
+  DrawImage draw_image =
+      CreateDrawImage(image.get(), 1.f, kLow_SkFilterQuality);
+
+  scoped_refptr<ImageDecodeTask> task;
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_image, 1u, &task));
+  ASSERT_TRUE(task);
+
+  // The image isn't decoded yet.
+  ImageDecodeController::DecodedDrawImage decoded_image =
+      controller.GetDecodedImageForDraw(draw_image);
+  EXPECT_FALSE(decoded_image.image());
+  controller.DrawWithImageFinished(draw_image, decoded_image);
+
+  RunTask(task.get());
+  controller.UnrefImage(draw_image);
+
+  // The image is decoded, but no raster task refs it.
+  decoded_image = controller.GetDecodedImageForDraw(draw_image);
+  EXPECT_FALSE(decoded_image.image());
+  controller.DrawWithImageFinished(draw_image, decoded_image);
+}
+
+TEST(ImageDecodeControllerTest, MemoryLimit) {
+  const size_t kImageBytes = 100u * 100u * kBytesPerPixel;
+  ImageDecodeController controller(2 * kImageBytes);
+  skia::RefPtr<SkImage> images[] = {
+      CreateDiscardableImage(gfx::Size(100, 100)),
+      CreateDiscardableImage(gfx::Size(100, 100)),
+      CreateDiscardableImage(gfx::Size(100, 100))};
+  DrawImage draw_images[] = {
+      CreateDrawImage(images[0].get(), 1.f, kLow_SkFilterQuality),
+      CreateDrawImage(images[1].get(), 1.f, kLow_SkFilterQuality),
+      CreateDrawImage(images[2].get(), 1.f, kLow_SkFilterQuality)};
+
+  // Locked decodes that don't fit in the budget are refused.
+  scoped_refptr<ImageDecodeTask> tasks[3];
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_images[0], 1u, &tasks[0]));
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_images[1], 1u, &tasks[1]));
+  EXPECT_FALSE(
+      controller.GetTaskForImageAndRef(draw_images[2], 1u, &tasks[2]));
+  EXPECT_FALSE(tasks[2]);
+  EXPECT_EQ(2 * kImageBytes, controller.GetLockedMemoryUsageForTesting());
+
+  RunTask(tasks[0].get());
+  RunTask(tasks[1].get());
+  controller.UnrefImage(draw_images[0]);
+  controller.UnrefImage(draw_images[1]);
+  EXPECT_EQ(2u, controller.GetDecodedImageCountForTesting());
+
+  // Unlocked decodes are evicted, least recently used first, to make room.
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_images[2], 2u, &tasks[2]));
+  ASSERT_TRUE(tasks[2]);
+  EXPECT_EQ(1u, controller.GetDecodedImageCountForTesting());
+  EXPECT_EQ(2 * kImageBytes, controller.GetMemoryUsageForTesting());
+  EXPECT_TRUE(controller.GetTaskForImageAndRef(draw_images[1], 2u, &tasks[1]));
+  EXPECT_FALSE(tasks[1]);
+
+  RunTask(tasks[2].get());
+  controller.UnrefImage(draw_images[1]);
+  controller.UnrefImage(draw_images[2]);
+  EXPECT_EQ(0u, controller.GetLockedMemoryUsageForTesting());
+  EXPECT_LE(controller.GetMemoryUsageForTesting(),
+            controller.memory_limit_bytes());
+}
+
+TEST(ImageDecodeControllerTest, PrerollForGpuRaster) {
+  ImageDecodeController controller;
+  skia::RefPtr<SkImage> image = CreateDiscardableImage(gfx::Size(100, 100));
+  DrawImage draw_image =
+      CreateDrawImage(image.get(), 0.2f, kMedium_SkFilterQuality);
+
+  // Tiles that draw the same image share a preroll task until it completes.
+  // The preroll doesn't decode into the cache.
+  scoped_refptr<ImageDecodeTask> task =
+      controller.GetPrerollTaskForImage(draw_image, 1u);
+  ASSERT_TRUE(task);
+  EXPECT_EQ(task, controller.GetPrerollTaskForImage(draw_image, 1u));
+  RunTask(task.get());
+  EXPECT_EQ(0u, controller.GetMemoryUsageForTesting());
+  EXPECT_EQ(0u, controller.GetDecodedImageCountForTesting());
+
+  scoped_refptr<ImageDecodeTask> next_task =
+      controller.GetPrerollTaskForImage(draw_image, 2u);
+  ASSERT_TRUE(next_task);
+  EXPECT_NE(task, next_task);
+  RunTask(next_task.get());
+}
+
+}  // namespace
+}  // namespace cc
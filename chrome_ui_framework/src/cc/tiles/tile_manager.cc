@@ -17,6 +17,7 @@
 #include "cc/base/histograms.h"
 #include "cc/debug/devtools_instrumentation.h"
 #include "cc/debug/frame_viewer_instrumentation.h"
+#include "cc/debug/rendering_stats_instrumentation.h"
 #include "cc/debug/traced_value.h"
 #include "cc/layers/picture_layer_impl.h"
 #include "cc/raster/raster_buffer.h"
@@ -52,8 +53,10 @@ class RasterTaskImpl : public RasterTask {
                  uint64_t resource_content_id,
                  int source_frame_number,
                  bool analyze_picture,
+                 ImageDecodeController* image_decode_controller,
                  const base::Callback<
                      void(const DisplayListRasterSource::SolidColorAnalysis&,
+                          const gfx::Rect&,
                           bool)>& reply,
                  ImageDecodeTask::Vector* dependencies)
       : RasterTask(dependencies),
@@ -71,6 +74,7 @@ class RasterTaskImpl : public RasterTask {
         resource_content_id_(resource_content_id),
         source_frame_number_(source_frame_number),
         analyze_picture_(analyze_picture),
+        image_decode_controller_(image_decode_controller),
         reply_(reply) {}
 
   // Overridden from Task:
@@ -98,7 +102,7 @@ class RasterTaskImpl : public RasterTask {
   }
   void CompleteOnOriginThread(TileTaskClient* client) override {
     client->ReleaseBufferForRaster(raster_buffer_.Pass());
-    reply_.Run(analysis_, !HasFinishedRunning());
+    reply_.Run(analysis_, raster_rect_, !HasFinishedRunning());
   }
 
  protected:
@@ -126,13 +130,16 @@ class RasterTaskImpl : public RasterTask {
     DCHECK(raster_source);
 
     bool include_images = tile_resolution_ != LOW_RESOLUTION;
-    raster_buffer_->Playback(raster_source_.get(), content_rect_,
-                             invalid_content_rect_, new_content_id_,
-                             contents_scale_, include_images);
+    raster_rect_ = raster_buffer_->Playback(
+        raster_source_.get(), content_rect_, invalid_content_rect_,
+        new_content_id_, contents_scale_, include_images,
+        image_decode_controller_);
   }
 
   const Resource* resource_;
   DisplayListRasterSource::SolidColorAnalysis analysis_;
+  // The part of |content_rect_| that was rastered.
+  gfx::Rect raster_rect_;
   scoped_refptr<DisplayListRasterSource> raster_source_;
   gfx::Rect content_rect_;
   gfx::Rect invalid_content_rect_;
@@ -146,7 +153,11 @@ class RasterTaskImpl : public RasterTask {
   uint64_t resource_content_id_;
   int source_frame_number_;
   bool analyze_picture_;
+  // The decodes of the images of the tile, which are kept locked until the
+  // task completes. Null if the images are drawn as they are.
+  ImageDecodeController* image_decode_controller_;
   const base::Callback<void(const DisplayListRasterSource::SolidColorAnalysis&,
+                            const gfx::Rect&,
                             bool)> reply_;
   scoped_ptr<RasterBuffer> raster_buffer_;
 
@@ -170,7 +181,9 @@ const char* TaskSetName(TaskSet task_set) {
 }  // namespace
 
 RasterTaskCompletionStats::RasterTaskCompletionStats()
-    : completed_count(0u), canceled_count(0u) {}
+    : completed_count(0u),
+      canceled_count(0u),
+      solid_color_without_raster_count(0u) {}
 
 scoped_refptr<base::trace_event::ConvertableToTraceFormat>
 RasterTaskCompletionStatsAsValue(const RasterTaskCompletionStats& stats) {
@@ -180,6 +193,9 @@ RasterTaskCompletionStatsAsValue(const RasterTaskCompletionStats& stats) {
                     base::saturated_cast<int>(stats.completed_count));
   state->SetInteger("canceled_count",
                     base::saturated_cast<int>(stats.canceled_count));
+  state->SetInteger(
+      "solid_color_without_raster_count",
+      base::saturated_cast<int>(stats.solid_color_without_raster_count));
   return state;
 }
 
@@ -188,22 +204,27 @@ scoped_ptr<TileManager> TileManager::Create(
     TileManagerClient* client,
     base::SequencedTaskRunner* task_runner,
     size_t scheduled_raster_task_limit,
-    bool use_partial_raster) {
+    bool use_partial_raster,
+    RenderingStatsInstrumentation* rendering_stats_instrumentation) {
   return make_scoped_ptr(new TileManager(
-      client, task_runner, scheduled_raster_task_limit, use_partial_raster));
+      client, task_runner, scheduled_raster_task_limit, use_partial_raster,
+      rendering_stats_instrumentation));
 }
 
 TileManager::TileManager(
     TileManagerClient* client,
     const scoped_refptr<base::SequencedTaskRunner>& task_runner,
     size_t scheduled_raster_task_limit,
-    bool use_partial_raster)
+    bool use_partial_raster,
+    RenderingStatsInstrumentation* rendering_stats_instrumentation)
     : client_(client),
       task_runner_(task_runner),
       resource_pool_(nullptr),
       tile_task_runner_(nullptr),
       scheduled_raster_task_limit_(scheduled_raster_task_limit),
+      use_gpu_rasterization_(false),
       use_partial_raster_(use_partial_raster),
+      rendering_stats_instrumentation_(rendering_stats_instrumentation),
       all_tiles_that_need_to_be_rasterized_are_scheduled_(true),
       did_check_for_completed_tasks_since_last_schedule_tasks_(true),
       did_oom_on_last_assign_(false),
@@ -248,11 +269,13 @@ void TileManager::FinishTasksAndCleanUp() {
 
 void TileManager::SetResources(ResourcePool* resource_pool,
                                TileTaskRunner* tile_task_runner,
-                               size_t scheduled_raster_task_limit) {
+                               size_t scheduled_raster_task_limit,
+                               bool use_gpu_rasterization) {
   DCHECK(!tile_task_runner_);
   DCHECK(tile_task_runner);
 
   scheduled_raster_task_limit_ = scheduled_raster_task_limit;
+  use_gpu_rasterization_ = use_gpu_rasterization;
   resource_pool_ = resource_pool;
   tile_task_runner_ = tile_task_runner;
   tile_task_runner_->SetClient(this);
@@ -279,7 +302,6 @@ void TileManager::CleanUpReleasedTiles() {
     DCHECK(tiles_.find(tile->id()) != tiles_.end());
     tiles_.erase(tile->id());
 
-    image_decode_controller_.SubtractLayerUsedCount(tile->layer_id());
     delete tile;
   }
   released_tiles_.swap(tiles_to_retain);
@@ -524,6 +546,20 @@ void TileManager::AssignGpuMemoryToTiles(
     DCHECK_IMPLIES(tile->draw_info().mode() != TileDrawInfo::OOM_MODE,
                    !tile->draw_info().IsReadyToDraw());
 
+    // Tiles that the display list already knows to be of solid color are
+    // ready to draw right away, without memory or a raster task.
+    if (kUseColorEstimator && !tile->raster_task_.get() &&
+        tile->use_picture_analysis()) {
+      DisplayListRasterSource::SolidColorAnalysis analysis;
+      if (prioritized_tile.raster_source()
+              ->PerformSolidColorAnalysisWithoutPlayback(
+                  tile->content_rect(), tile->contents_scale(), &analysis)) {
+        ++flush_stats_.solid_color_without_raster_count;
+        UpdateTileDrawInfo(tile, nullptr, 0, analysis);
+        continue;
+      }
+    }
+
     // If the tile already has a raster_task, then the memory used by it is
     // already accounted for in memory_usage. Otherwise, we'll have to acquire
     // more memory to create a raster task.
@@ -678,14 +714,41 @@ scoped_refptr<RasterTask> TileManager::CreateRasterTask(
                                                DetermineResourceFormat(tile));
   }
 
-  // Create and queue all image decode tasks that this tile depends on.
+  // Low resolution tiles are rastered without images, and don't need to
+  // decode them.
   ImageDecodeTask::Vector decode_tasks;
+  ImageDecodeController* image_decode_controller = nullptr;
   std::vector<DrawImage> images;
-  prioritized_tile.raster_source()->GetDiscardableImagesInRect(
-      tile->enclosing_layer_rect(), &images);
-  for (const auto& image : images) {
-    decode_tasks.push_back(image_decode_controller_.GetTaskForImage(
-        image, tile->layer_id(), prepare_tiles_count_));
+  if (prioritized_tile.priority().resolution != LOW_RESOLUTION) {
+    prioritized_tile.raster_source()->GetDiscardableImagesInRect(
+        tile->enclosing_layer_rect(), &images);
+  }
+  if (use_gpu_rasterization_) {
+    // GPU raster records the original images into a picture that is played
+    // back after the task completes, so the decodes can't be kept locked for
+    // it. Skia decodes the images into its own cache instead.
+    for (const auto& image : images) {
+      decode_tasks.push_back(image_decode_controller_.GetPrerollTaskForImage(
+          image, prepare_tiles_count_));
+    }
+  } else if (!images.empty()) {
+    // Create and queue all image decode tasks that this tile depends on. The
+    // decodes are kept locked until the raster task completes.
+    image_decode_controller = &image_decode_controller_;
+    std::vector<DrawImage>& scheduled_images =
+        scheduled_draw_images_[tile->id()];
+    DCHECK(scheduled_images.empty());
+    for (auto& image : images) {
+      DrawImage scaled_image = image.ApplyScale(tile->contents_scale());
+      scoped_refptr<ImageDecodeTask> task;
+      if (!image_decode_controller_.GetTaskForImageAndRef(
+              scaled_image, prepare_tiles_count_, &task)) {
+        continue;
+      }
+      scheduled_images.push_back(scaled_image);
+      if (task)
+        decode_tasks.push_back(task);
+    }
   }
 
   return make_scoped_refptr(new RasterTaskImpl(
@@ -694,16 +757,18 @@ scoped_refptr<RasterTask> TileManager::CreateRasterTask(
       prioritized_tile.priority().resolution, tile->layer_id(),
       prepare_tiles_count_, static_cast<const void*>(tile), tile->id(),
       tile->invalidated_id(), resource_content_id, tile->source_frame_number(),
-      tile->use_picture_analysis(),
+      tile->use_picture_analysis(), image_decode_controller,
       base::Bind(&TileManager::OnRasterTaskCompleted, base::Unretained(this),
-                 tile->id(), resource),
+                 tile->id(), resource, resource_content_id),
       &decode_tasks));
 }
 
 void TileManager::OnRasterTaskCompleted(
     Tile::Id tile_id,
     Resource* resource,
+    uint64_t resource_content_id,
     const DisplayListRasterSource::SolidColorAnalysis& analysis,
+    const gfx::Rect& raster_rect,
     bool was_canceled) {
   DCHECK(tiles_.find(tile_id) != tiles_.end());
 
@@ -712,35 +777,44 @@ void TileManager::OnRasterTaskCompleted(
   orphan_raster_tasks_.push_back(tile->raster_task_);
   tile->raster_task_ = nullptr;
 
+  auto images_it = scheduled_draw_images_.find(tile_id);
+  if (images_it != scheduled_draw_images_.end()) {
+    for (const auto& image : images_it->second)
+      image_decode_controller_.UnrefImage(image);
+    scheduled_draw_images_.erase(images_it);
+  }
+
   if (was_canceled) {
     ++flush_stats_.canceled_count;
-    // TODO(ericrk): If more partial raster work is done in the future, it may
-    // be worth returning the resource to the pool with its previous ID (not
-    // currently tracked). crrev.com/1370333002/#ps40001 has a possible method
-    // of achieving this.
-    resource_pool_->ReleaseResource(resource, 0 /* content_id */);
+    // The task didn't run, so the resource still has the content that it was
+    // acquired with, if any.
+    resource_pool_->ReleaseResource(resource, resource_content_id);
     return;
   }
 
-  UpdateTileDrawInfo(tile, resource, analysis);
+  if (rendering_stats_instrumentation_ && !raster_rect.IsEmpty()) {
+    int64 rastered_area = raster_rect.size().GetArea();
+    rendering_stats_instrumentation_->AddRasteredContentArea(
+        rastered_area, tile->content_rect().size().GetArea() - rastered_area);
+  }
+
+  ++flush_stats_.completed_count;
+  UpdateTileDrawInfo(tile, resource, resource_content_id, analysis);
 }
 
 void TileManager::UpdateTileDrawInfo(
     Tile* tile,
     Resource* resource,
+    uint64_t resource_content_id,
     const DisplayListRasterSource::SolidColorAnalysis& analysis) {
   TileDrawInfo& draw_info = tile->draw_info();
 
-  ++flush_stats_.completed_count;
-
   if (analysis.is_solid_color) {
     draw_info.set_solid_color(analysis.solid_color);
     if (resource) {
-      // TODO(ericrk): If more partial raster work is done in the future, it may
-      // be worth returning the resource to the pool with its previous ID (not
-      // currently tracked). crrev.com/1370333002/#ps40001 has a possible method
-      // of achieving this.
-      resource_pool_->ReleaseResource(resource, 0 /* content_id */);
+      // The tile wasn't rastered into the resource, which still has the
+      // content that it was acquired with, if any.
+      resource_pool_->ReleaseResource(resource, resource_content_id);
     }
   } else {
     DCHECK(resource);
@@ -766,7 +840,6 @@ ScopedTilePtr TileManager::CreateTile(const Tile::CreateInfo& info,
   DCHECK(tiles_.find(tile->id()) == tiles_.end());
 
   tiles_[tile->id()] = tile.get();
-  image_decode_controller_.AddLayerUsedCount(tile->layer_id());
   return tile;
 }
 
@@ -34,6 +34,7 @@ class TracedValue;
 
 namespace cc {
 class PictureLayerImpl;
+class RenderingStatsInstrumentation;
 class ResourceProvider;
 
 class CC_EXPORT TileManagerClient {
@@ -82,6 +83,8 @@ struct RasterTaskCompletionStats {
 
   size_t completed_count;
   size_t canceled_count;
+  // Tiles found to be of solid color without a raster task.
+  size_t solid_color_without_raster_count;
 };
 scoped_refptr<base::trace_event::ConvertableToTraceFormat>
 RasterTaskCompletionStatsAsValue(const RasterTaskCompletionStats& stats);
@@ -108,7 +111,9 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
   static scoped_ptr<TileManager> Create(TileManagerClient* client,
                                         base::SequencedTaskRunner* task_runner,
                                         size_t scheduled_raster_task_limit,
-                                        bool use_partial_raster);
+                                        bool use_partial_raster,
+                                        RenderingStatsInstrumentation*
+                                            rendering_stats_instrumentation);
   ~TileManager() override;
 
   // Assigns tile memory and schedules work to prepare tiles for drawing.
@@ -123,12 +128,13 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
   // SetResources call.
   void FinishTasksAndCleanUp();
 
-  // Set the new given resource pool and tile task runner. Note that
-  // FinishTasksAndCleanUp must be called in between consecutive calls to
-  // SetResources.
+  // Set the new given resource pool and tile task runner, and whether the
+  // tile task runner rasters on the GPU. Note that FinishTasksAndCleanUp must
+  // be called in between consecutive calls to SetResources.
   void SetResources(ResourcePool* resource_pool,
                     TileTaskRunner* tile_task_runner,
-                    size_t scheduled_raster_task_limit);
+                    size_t scheduled_raster_task_limit,
+                    bool use_gpu_rasterization);
 
   // This causes any completed raster work to finalize, so that tiles get up to
   // date draw information.
@@ -203,11 +209,16 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
     return has_scheduled_tile_tasks_;
   }
 
+  ImageDecodeController* GetImageDecodeControllerForTesting() {
+    return &image_decode_controller_;
+  }
+
  protected:
   TileManager(TileManagerClient* client,
               const scoped_refptr<base::SequencedTaskRunner>& task_runner,
               size_t scheduled_raster_task_limit,
-              bool use_partial_raster);
+              bool use_partial_raster,
+              RenderingStatsInstrumentation* rendering_stats_instrumentation);
 
   void FreeResourcesForReleasedTiles();
   void CleanUpReleasedTiles();
@@ -256,11 +267,14 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
   void OnRasterTaskCompleted(
       Tile::Id tile,
       Resource* resource,
+      uint64_t resource_content_id,
       const DisplayListRasterSource::SolidColorAnalysis& analysis,
+      const gfx::Rect& raster_rect,
       bool was_canceled);
   void UpdateTileDrawInfo(
       Tile* tile,
       Resource* resource,
+      uint64_t resource_content_id,
       const DisplayListRasterSource::SolidColorAnalysis& analysis);
 
   void FreeResourcesForTile(Tile* tile);
@@ -293,7 +307,10 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
   TileTaskRunner* tile_task_runner_;
   GlobalStateThatImpactsTilePriority global_state_;
   size_t scheduled_raster_task_limit_;
+  bool use_gpu_rasterization_;
   const bool use_partial_raster_;
+  // Records the raster work that tiles take, if not null.
+  RenderingStatsInstrumentation* rendering_stats_instrumentation_;
 
   typedef base::hash_map<Tile::Id, Tile*> TileMap;
   TileMap tiles_;
@@ -305,6 +322,9 @@ class CC_EXPORT TileManager : public TileTaskRunnerClient {
   bool did_oom_on_last_assign_;
 
   ImageDecodeController image_decode_controller_;
+  // The images that the scheduled raster task of each tile holds a ref to the
+  // decode of.
+  base::hash_map<Tile::Id, std::vector<DrawImage>> scheduled_draw_images_;
 
   RasterTaskCompletionStats flush_stats_;
 
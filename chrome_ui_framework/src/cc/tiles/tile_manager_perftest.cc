@@ -8,8 +8,11 @@
 #include "base/time/time.h"
 #include "cc/debug/lap_timer.h"
 #include "cc/raster/raster_buffer.h"
+#include "cc/raster/tile_task_worker_pool.h"
+#include "cc/resources/resource.h"
 #include "cc/test/begin_frame_args_test.h"
 #include "cc/test/fake_display_list_raster_source.h"
+#include "cc/test/fake_display_list_recording_source.h"
 #include "cc/test/fake_impl_proxy.h"
 #include "cc/test/fake_layer_tree_host_impl.h"
 #include "cc/test/fake_output_surface.h"
@@ -17,9 +20,11 @@
 #include "cc/test/fake_picture_layer_impl.h"
 #include "cc/test/fake_tile_manager.h"
 #include "cc/test/fake_tile_manager_client.h"
+#include "cc/test/skia_common.h"
 #include "cc/test/test_shared_bitmap_manager.h"
 #include "cc/test/test_task_graph_runner.h"
 #include "cc/test/test_tile_priorities.h"
+#include "cc/tiles/image_decode_controller.h"
 #include "cc/tiles/tile.h"
 #include "cc/tiles/tile_priority.h"
 #include "cc/trees/layer_tree_impl.h"
@@ -34,8 +39,46 @@ static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
 
+// Plays raster sources back into memory, as the software raster does.
+class PerfRasterBufferImpl : public RasterBuffer {
+ public:
+  PerfRasterBufferImpl(const gfx::Size& size, ResourceFormat format)
+      : size_(size),
+        format_(format),
+        pixels_(new uint8_t[size.GetArea() * 4]) {}
+
+  // Overridden from RasterBuffer:
+  gfx::Rect Playback(const DisplayListRasterSource* raster_source,
+                     const gfx::Rect& raster_full_rect,
+                     const gfx::Rect& raster_dirty_rect,
+                     uint64_t new_content_id,
+                     float scale,
+                     bool include_images,
+                     ImageDecodeController* image_decode_controller) override {
+    TileTaskWorkerPool::PlaybackToMemory(
+        pixels_.get(), format_, size_, size_.width() * 4, raster_source,
+        raster_full_rect, raster_full_rect, scale, include_images,
+        image_decode_controller);
+    return raster_full_rect;
+  }
+
+ private:
+  gfx::Size size_;
+  ResourceFormat format_;
+  scoped_ptr<uint8_t[]> pixels_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfRasterBufferImpl);
+};
+
 class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
  public:
+  FakeTileTaskRunnerImpl() : run_raster_tasks_(false) {}
+
+  // Raster tasks are only run, and played back, if this is set.
+  void set_run_raster_tasks(bool run_raster_tasks) {
+    run_raster_tasks_ = run_raster_tasks;
+  }
+
   // Overridden from TileTaskRunner:
   void SetClient(TileTaskRunnerClient* client) override {}
   void Shutdown() override {}
@@ -44,18 +87,32 @@ class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
          it != queue->items.end(); ++it) {
       RasterTask* task = it->task;
 
+      // Image decode tasks are run, as they would be before raster, once for
+      // all of the raster tasks that share them.
+      for (const auto& decode_task : task->dependencies()) {
+        if (decode_task->HasBeenScheduled())
+          continue;
+        decode_task->WillSchedule();
+        decode_task->ScheduleOnOriginThread(this);
+        decode_task->DidSchedule();
+        decode_task->RunOnWorkerThread();
+        completed_tasks_.push_back(decode_task);
+      }
+
       task->WillSchedule();
       task->ScheduleOnOriginThread(this);
       task->DidSchedule();
+      if (run_raster_tasks_)
+        task->RunOnWorkerThread();
 
       completed_tasks_.push_back(task);
     }
   }
   void CheckForCompletedTasks() override {
-    for (RasterTask::Vector::iterator it = completed_tasks_.begin();
+    for (TileTask::Vector::iterator it = completed_tasks_.begin();
          it != completed_tasks_.end();
          ++it) {
-      RasterTask* task = it->get();
+      TileTask* task = it->get();
 
       task->WillComplete();
       task->CompleteOnOriginThread(this);
@@ -76,12 +133,16 @@ class FakeTileTaskRunnerImpl : public TileTaskRunner, public TileTaskClient {
       const Resource* resource,
       uint64_t new_content_id,
       uint64_t previous_content_id) override {
-    return nullptr;
+    if (!run_raster_tasks_)
+      return nullptr;
+    return make_scoped_ptr(
+        new PerfRasterBufferImpl(resource->size(), resource->format()));
   }
   void ReleaseBufferForRaster(scoped_ptr<RasterBuffer> buffer) override {}
 
  private:
-  RasterTask::Vector completed_tasks_;
+  bool run_raster_tasks_;
+  TileTask::Vector completed_tasks_;
 };
 base::LazyInstance<FakeTileTaskRunnerImpl> g_fake_tile_task_runner =
     LAZY_INSTANCE_INITIALIZER;
@@ -92,6 +153,9 @@ class TileManagerPerfTest : public testing::Test {
       : memory_limit_policy_(ALLOW_ANYTHING),
         max_tiles_(10000),
         id_(7),
+        image_scale_(1.f),
+        solid_color_use_cached_picture_(false),
+        solid_color_(false),
         proxy_(base::ThreadTaskRunnerHandle::Get()),
         output_surface_(FakeOutputSurface::Create3d()),
         host_impl_(LayerTreeSettings(),
@@ -132,9 +196,9 @@ class TileManagerPerfTest : public testing::Test {
 
   void SetupDefaultTrees(const gfx::Size& layer_bounds) {
     scoped_refptr<FakeDisplayListRasterSource> pending_raster_source =
-        FakeDisplayListRasterSource::CreateFilled(layer_bounds);
+        CreateRasterSource(layer_bounds);
     scoped_refptr<FakeDisplayListRasterSource> active_raster_source =
-        FakeDisplayListRasterSource::CreateFilled(layer_bounds);
+        CreateRasterSource(layer_bounds);
 
     SetupTrees(pending_raster_source, active_raster_source);
   }
@@ -352,7 +416,7 @@ class TileManagerPerfTest : public testing::Test {
 
     // Create the rest of the layers as children of the root layer.
     scoped_refptr<FakeDisplayListRasterSource> raster_source =
-        FakeDisplayListRasterSource::CreateFilled(layer_bounds);
+        CreateRasterSource(layer_bounds);
     while (static_cast<int>(layers.size()) < layer_count) {
       scoped_ptr<FakePictureLayerImpl> layer =
           FakePictureLayerImpl::CreateWithRasterSource(
@@ -372,6 +436,63 @@ class TileManagerPerfTest : public testing::Test {
     return layers;
   }
 
+  // Creates a raster source that is filled, and that draws |images_|, if
+  // any, over and over in a grid at |image_scale_|. If |solid_color_| is set,
+  // the raster source is instead filled with a single color, and played back
+  // from a cached picture if |solid_color_use_cached_picture_| is set.
+  scoped_refptr<FakeDisplayListRasterSource> CreateRasterSource(
+      const gfx::Size& layer_bounds) {
+    if (solid_color_) {
+      scoped_ptr<FakeDisplayListRecordingSource> recording_source =
+          FakeDisplayListRecordingSource::CreateFilledRecordingSource(
+              layer_bounds);
+      recording_source->set_use_cached_picture(
+          solid_color_use_cached_picture_);
+      SkPaint red_paint;
+      red_paint.setColor(SK_ColorRED);
+      recording_source->add_draw_rect_with_paint(gfx::Rect(layer_bounds),
+                                                 red_paint);
+      recording_source->Rerecord();
+      return FakeDisplayListRasterSource::CreateFromRecordingSource(
+          recording_source.get(), false);
+    }
+
+    if (images_.empty())
+      return FakeDisplayListRasterSource::CreateFilled(layer_bounds);
+
+    scoped_ptr<FakeDisplayListRecordingSource> recording_source =
+        FakeDisplayListRecordingSource::CreateFilledRecordingSource(
+            layer_bounds);
+    SkPaint red_paint;
+    red_paint.setColor(SK_ColorRED);
+    recording_source->add_draw_rect_with_paint(gfx::Rect(layer_bounds),
+                                               red_paint);
+
+    SkPaint image_paint;
+    image_paint.setFilterQuality(kLow_SkFilterQuality);
+    recording_source->set_default_paint(image_paint);
+    const SkImage* first_image = images_[0].get();
+    const int cell_width =
+        std::max(1, static_cast<int>(first_image->width() * image_scale_));
+    const int cell_height =
+        std::max(1, static_cast<int>(first_image->height() * image_scale_));
+    size_t image_index = 0;
+    for (int y = 0; y < layer_bounds.height(); y += cell_height) {
+      for (int x = 0; x < layer_bounds.width(); x += cell_width) {
+        gfx::Transform transform;
+        transform.Translate(x, y);
+        transform.Scale(image_scale_, image_scale_);
+        recording_source->add_draw_image_with_transform(
+            images_[image_index].get(), transform);
+        image_index = (image_index + 1) % images_.size();
+      }
+    }
+    recording_source->SetGenerateDiscardableImagesMetadata(true);
+    recording_source->Rerecord();
+    return FakeDisplayListRasterSource::CreateFromRecordingSource(
+        recording_source.get(), false);
+  }
+
   GlobalStateThatImpactsTilePriority GlobalStateForTest() {
     GlobalStateThatImpactsTilePriority state;
     gfx::Size tile_size = settings_.default_tile_size;
@@ -408,6 +529,101 @@ class TileManagerPerfTest : public testing::Test {
                            timer_.LapsPerSecond(), "runs/s", true);
   }
 
+  // Like RunPrepareTilesTest(), but the layers draw |image_count| images of
+  // |image_size|, scaled by |image_scale|, that they all share. Every tile
+  // is rastered again on each run, which decodes the images or reuses their
+  // decodes.
+  void RunPrepareTilesWithImagesTest(const std::string& test_name,
+                                     int layer_count,
+                                     int approximate_tile_count_per_layer,
+                                     int image_count,
+                                     const gfx::Size& image_size,
+                                     float image_scale) {
+    images_.clear();
+    for (int i = 0; i < image_count; ++i)
+      images_.push_back(CreateDiscardableImage(image_size));
+    image_scale_ = image_scale;
+    std::vector<FakePictureLayerImpl*> layers =
+        CreateLayers(layer_count, approximate_tile_count_per_layer);
+
+    timer_.Reset();
+    bool resourceless_software_draw = false;
+    do {
+      host_impl_.AdvanceToNextFrame(base::TimeDelta::FromMilliseconds(1));
+      for (const auto& layer : layers)
+        layer->UpdateTiles(resourceless_software_draw);
+
+      GlobalStateThatImpactsTilePriority global_state(GlobalStateForTest());
+      tile_manager()->PrepareTiles(global_state);
+      tile_manager()->Flush();
+      tile_manager()->ReleaseTileResourcesForTesting(
+          tile_manager()->AllTilesForTesting());
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("prepare_tiles_with_images", "", test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+
+    ImageDecodeController* image_decode_controller =
+        tile_manager()->GetImageDecodeControllerForTesting();
+    perf_test::PrintResult(
+        "prepare_tiles_with_images_decoded_memory", "", test_name,
+        image_decode_controller->GetMemoryUsageForTesting() / 1024, "kb",
+        true);
+
+    host_impl_.ResetTreesForTesting();
+    tile_manager()->FreeResourcesAndCleanUpReleasedTilesForTesting();
+    images_.clear();
+  }
+
+  // Like RunPrepareTilesTest(), but the layers are filled with a single
+  // color, and every tile is rastered again on each run. Without a cached
+  // picture, the tiles are found to be of solid color when they are
+  // prepared, and need neither memory nor a raster task. With one, they are
+  // only found to be when their raster tasks run.
+  void RunPrepareTilesWithSolidColorTest(const std::string& test_name,
+                                         int layer_count,
+                                         int approximate_tile_count_per_layer,
+                                         bool use_cached_picture) {
+    solid_color_ = true;
+    solid_color_use_cached_picture_ = use_cached_picture;
+    g_fake_tile_task_runner.Get().set_run_raster_tasks(true);
+    std::vector<FakePictureLayerImpl*> layers =
+        CreateLayers(layer_count, approximate_tile_count_per_layer);
+
+    size_t memory_bytes_used = 0;
+    timer_.Reset();
+    bool resourceless_software_draw = false;
+    do {
+      host_impl_.AdvanceToNextFrame(base::TimeDelta::FromMilliseconds(1));
+      for (const auto& layer : layers)
+        layer->UpdateTiles(resourceless_software_draw);
+
+      GlobalStateThatImpactsTilePriority global_state(GlobalStateForTest());
+      tile_manager()->PrepareTiles(global_state);
+      memory_bytes_used = std::max<size_t>(
+          memory_bytes_used,
+          tile_manager()->memory_stats_from_last_assign().total_bytes_used);
+      tile_manager()->Flush();
+
+      std::vector<Tile*> tiles = tile_manager()->AllTilesForTesting();
+      tile_manager()->ReleaseTileResourcesForTesting(tiles);
+      for (Tile* tile : tiles)
+        tile->draw_info() = TileDrawInfo();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("prepare_tiles_with_solid_color", "", test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+    perf_test::PrintResult("prepare_tiles_with_solid_color_memory", "",
+                           test_name, memory_bytes_used / 1024, "kb", true);
+
+    host_impl_.ResetTreesForTesting();
+    tile_manager()->FreeResourcesAndCleanUpReleasedTilesForTesting();
+    g_fake_tile_task_runner.Get().set_run_raster_tasks(false);
+    solid_color_ = false;
+  }
+
   TileManager* tile_manager() { return host_impl_.tile_manager(); }
 
  protected:
@@ -418,6 +634,10 @@ class TileManagerPerfTest : public testing::Test {
   TileMemoryLimitPolicy memory_limit_policy_;
   int max_tiles_;
   int id_;
+  std::vector<skia::RefPtr<SkImage>> images_;
+  float image_scale_;
+  bool solid_color_use_cached_picture_;
+  bool solid_color_;
   FakeImplProxy proxy_;
   scoped_ptr<OutputSurface> output_surface_;
   FakeLayerTreeHostImpl host_impl_;
@@ -439,6 +659,27 @@ TEST_F(TileManagerPerfTest, PrepareTiles) {
   RunPrepareTilesTest("50_1000", 100, 1000);
 }
 
+TEST_F(TileManagerPerfTest, PrepareTilesWithImages) {
+  // Images drawn at full size, and scaled down to 10%.
+  RunPrepareTilesWithImagesTest("2_100_1", 2, 100, 16, gfx::Size(512, 512),
+                                1.f);
+  RunPrepareTilesWithImagesTest("2_100_0.1", 2, 100, 16,
+                                gfx::Size(2048, 2048), 0.1f);
+  RunPrepareTilesWithImagesTest("10_100_1", 10, 100, 16, gfx::Size(512, 512),
+                                1.f);
+  RunPrepareTilesWithImagesTest("10_100_0.1", 10, 100, 16,
+                                gfx::Size(2048, 2048), 0.1f);
+}
+
+TEST_F(TileManagerPerfTest, PrepareTilesWithSolidColor) {
+  // Tiles that are analyzed when they are prepared, and when they are
+  // rastered.
+  RunPrepareTilesWithSolidColorTest("2_100", 2, 100, false);
+  RunPrepareTilesWithSolidColorTest("2_100_cached_picture", 2, 100, true);
+  RunPrepareTilesWithSolidColorTest("10_100", 10, 100, false);
+  RunPrepareTilesWithSolidColorTest("10_100_cached_picture", 10, 100, true);
+}
+
 TEST_F(TileManagerPerfTest, RasterTileQueueConstruct) {
   RunRasterQueueConstructTest("2", 2);
   RunRasterQueueConstructTest("10", 10);
@@ -1644,6 +1644,55 @@ class CancellingTileTaskRunner : public FakeTileTaskRunner {
   }
 };
 
+// Ensures that tiles that the display list knows to be of solid color are
+// ready to draw once they are prepared, without memory or a raster task.
+TEST_F(TileManagerTest, SolidColorTilesAreNotRastered) {
+  // A FakeTileTaskRunner never runs tasks, or acquires buffers for them.
+  FakeTileTaskRunner fake_runner;
+  host_impl_->tile_manager()->SetTileTaskRunnerForTesting(&fake_runner);
+
+  gfx::Size size(100, 100);
+  scoped_ptr<FakeDisplayListRecordingSource> recording_source =
+      FakeDisplayListRecordingSource::CreateFilledRecordingSource(size);
+  recording_source->set_use_cached_picture(false);
+  SkPaint paint;
+  paint.setColor(SK_ColorGREEN);
+  recording_source->add_draw_rect_with_paint(gfx::Rect(size), paint);
+  recording_source->Rerecord();
+  scoped_refptr<DisplayListRasterSource> raster =
+      DisplayListRasterSource::CreateFromDisplayListRecordingSource(
+          recording_source.get(), false);
+
+  FakePictureLayerTilingClient tiling_client;
+  tiling_client.SetTileSize(gfx::Size(50, 50));
+
+  scoped_ptr<PictureLayerImpl> layer =
+      PictureLayerImpl::Create(host_impl_->active_tree(), 1, false, nullptr);
+  PictureLayerTilingSet* tiling_set = layer->picture_layer_tiling_set();
+
+  auto* tiling = tiling_set->AddTiling(1.0f, raster);
+  tiling->set_resolution(HIGH_RESOLUTION);
+  tiling->CreateAllTilesForTesting();
+  tiling->SetTilePriorityRectsForTesting(
+      gfx::Rect(size),   // Visible rect.
+      gfx::Rect(size),   // Skewport rect.
+      gfx::Rect(size),   // Soon rect.
+      gfx::Rect(size));  // Eventually rect.
+
+  host_impl_->tile_manager()->PrepareTiles(host_impl_->global_tile_state());
+
+  std::vector<Tile*> tiles = tiling->AllTilesForTesting();
+  ASSERT_FALSE(tiles.empty());
+  for (Tile* tile : tiles) {
+    EXPECT_EQ(TileDrawInfo::SOLID_COLOR_MODE, tile->draw_info().mode());
+    EXPECT_EQ(SK_ColorGREEN, tile->draw_info().solid_color());
+  }
+  EXPECT_EQ(0u, host_impl_->resource_pool()->resource_count());
+
+  // Tear down the TileManager while the fake runner is still valid.
+  host_impl_.reset();
+}
+
 class PartialRasterTileManagerTest : public TileManagerTest {
  public:
   void CustomizeSettings(LayerTreeSettings* settings) override {
@@ -1802,5 +1851,51 @@ TEST_F(TileManagerTest, PartialRasterSuccessfullyDisabled) {
   RunPartialRasterCheck(host_impl_.Pass(), false /* partial_raster_enabled */);
 }
 
+// Ensures that if a raster task that reuses a resource is cancelled, the
+// resource is returned to the resource pool with the content ID that it still
+// has, so that it can be reused again.
+TEST_F(PartialRasterTileManagerTest, CancelledTasksKeepResourceContentId) {
+  const int kLayerId = 7;
+  const uint64_t kInvalidatedId = 43;
+  const gfx::Size kTileSize(128, 128);
+
+  // Acquires the resource and cancels the task.
+  VerifyResourceContentIdTileTaskRunner verifying_runner(kInvalidatedId);
+  host_impl_->tile_manager()->SetTileTaskRunnerForTesting(&verifying_runner);
+
+  host_impl_->resource_pool()->ReleaseResource(
+      host_impl_->resource_pool()->AcquireResource(kTileSize, RGBA_8888),
+      kInvalidatedId);
+  host_impl_->resource_pool()->CheckBusyResources();
+
+  scoped_refptr<FakeDisplayListRasterSource> pending_raster_source =
+      FakeDisplayListRasterSource::CreateFilled(kTileSize);
+  host_impl_->CreatePendingTree();
+  LayerTreeImpl* pending_tree = host_impl_->pending_tree();
+  scoped_ptr<FakePictureLayerImpl> pending_layer =
+      FakePictureLayerImpl::CreateWithRasterSource(pending_tree, kLayerId,
+                                                   pending_raster_source);
+  pending_layer->SetDrawsContent(true);
+  pending_layer->SetHasRenderSurface(true);
+  pending_layer->SetBounds(pending_layer->raster_source()->GetSize());
+  pending_tree->SetRootLayer(pending_layer.Pass());
+  host_impl_->pending_tree()->UpdateDrawProperties(false /* update_lcd_text */);
+
+  scoped_ptr<RasterTilePriorityQueue> queue(host_impl_->BuildRasterQueue(
+      SAME_PRIORITY_FOR_BOTH_TREES, RasterTilePriorityQueue::Type::ALL));
+  EXPECT_FALSE(queue->IsEmpty());
+  queue->Top().tile()->SetInvalidated(gfx::Rect(), kInvalidatedId);
+
+  host_impl_->tile_manager()->PrepareTiles(host_impl_->global_tile_state());
+
+  host_impl_->resource_pool()->CheckBusyResources();
+  EXPECT_TRUE(host_impl_->resource_pool()->TryAcquireResourceWithContentId(
+      kInvalidatedId));
+
+  // Free our host_impl_ before the verifying_runner we passed it, as it will
+  // use that class in clean up.
+  host_impl_ = nullptr;
+}
+
 }  // namespace
 }  // namespace cc
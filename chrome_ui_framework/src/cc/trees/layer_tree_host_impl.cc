@@ -187,7 +187,8 @@ LayerTreeHostImpl::LayerTreeHostImpl(
                               is_synchronous_single_threaded_
                                   ? std::numeric_limits<size_t>::max()
                                   : settings.scheduled_raster_task_limit,
-                              settings.use_partial_raster)),
+                              settings.use_partial_raster,
+                              rendering_stats_instrumentation)),
       pinch_gesture_active_(false),
       pinch_gesture_end_should_clear_scrolling_layer_(false),
       fps_counter_(FrameRateCounter::Create(proxy_->HasImplThread())),
@@ -1616,7 +1617,7 @@ void LayerTreeHostImpl::DrawLayers(FrameData* frame) {
 
     scoped_ptr<SoftwareRenderer> temp_software_renderer =
         SoftwareRenderer::Create(this, &settings_.renderer_settings,
-                                 output_surface_, NULL);
+                                 output_surface_, NULL, NULL);
     temp_software_renderer->DrawFrame(
         &frame->render_passes, active_tree_->device_scale_factor(),
         DeviceViewport(), DeviceClip(), disable_picture_quad_image_filtering);
@@ -2070,9 +2071,9 @@ void LayerTreeHostImpl::CreateAndSetRenderer() {
         resource_provider_.get(), texture_mailbox_deleter_.get(),
         settings_.renderer_settings.highp_threshold_min);
   } else if (output_surface_->software_device()) {
-    renderer_ =
-        SoftwareRenderer::Create(this, &settings_.renderer_settings,
-                                 output_surface_, resource_provider_.get());
+    renderer_ = SoftwareRenderer::Create(
+        this, &settings_.renderer_settings, output_surface_,
+        resource_provider_.get(), task_graph_runner_);
   }
   DCHECK(renderer_);
 
@@ -2094,7 +2095,8 @@ void LayerTreeHostImpl::CreateTileManagerResources() {
   tile_manager_->SetResources(
       resource_pool_.get(), tile_task_worker_pool_->AsTileTaskRunner(),
       is_synchronous_single_threaded_ ? std::numeric_limits<size_t>::max()
-                                      : settings_.scheduled_raster_task_limit);
+                                      : settings_.scheduled_raster_task_limit,
+      use_gpu_rasterization_);
   UpdateTileManagerMemoryPolicy(ActualManagedMemoryPolicy());
 }
 
@@ -2157,6 +2159,7 @@ void LayerTreeHostImpl::CreateResourceAndTileTaskWorkerPool(
 
     *tile_task_worker_pool = ZeroCopyTileTaskWorkerPool::Create(
         GetTaskRunner(), task_graph_runner, resource_provider_.get(),
+        settings_.use_partial_raster,
         settings_.renderer_settings.use_rgba_4444_textures);
     return;
   }
@@ -21,6 +21,7 @@ namespace {
 enum RasterMode {
   PARTIAL_ONE_COPY,
   FULL_ONE_COPY,
+  PARTIAL_ZERO_COPY,
   PARTIAL_GPU,
   FULL_GPU,
   PARTIAL_BITMAP,
@@ -40,6 +41,10 @@ class LayerTreeHostTilesPixelTest : public LayerTreePixelTest {
         settings->use_zero_copy = false;
         settings->use_partial_raster = false;
         break;
+      case PARTIAL_ZERO_COPY:
+        settings->use_zero_copy = true;
+        settings->use_partial_raster = true;
+        break;
       case PARTIAL_BITMAP:
         settings->use_partial_raster = true;
         break;
@@ -80,6 +85,7 @@ class LayerTreeHostTilesPixelTest : public LayerTreePixelTest {
     switch (mode) {
       case PARTIAL_ONE_COPY:
       case FULL_ONE_COPY:
+      case PARTIAL_ZERO_COPY:
       case PARTIAL_GPU:
       case FULL_GPU:
         test_type = PIXEL_TEST_GL;
@@ -211,6 +217,20 @@ TEST_F(LayerTreeHostTilesTestPartialInvalidation,
       base::FilePath(FILE_PATH_LITERAL("blue_yellow_flipped.png")));
 }
 
+TEST_F(LayerTreeHostTilesTestPartialInvalidation,
+       PartialRaster_SingleThread_ZeroCopy) {
+  RunRasterPixelTest(
+      false, PARTIAL_ZERO_COPY, picture_layer_,
+      base::FilePath(FILE_PATH_LITERAL("blue_yellow_partial_flipped.png")));
+}
+
+TEST_F(LayerTreeHostTilesTestPartialInvalidation,
+       PartialRaster_MultiThread_ZeroCopy) {
+  RunRasterPixelTest(
+      true, PARTIAL_ZERO_COPY, picture_layer_,
+      base::FilePath(FILE_PATH_LITERAL("blue_yellow_partial_flipped.png")));
+}
+
 TEST_F(LayerTreeHostTilesTestPartialInvalidation,
        PartialRaster_SingleThread_Software) {
   RunRasterPixelTest(
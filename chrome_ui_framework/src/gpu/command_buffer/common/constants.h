@@ -66,6 +66,9 @@ const int32_t kCommandBufferSharedMemoryId = 4;
 // The size to set for the program cache.
 const size_t kDefaultMaxProgramCacheMemoryBytes = 6 * 1024 * 1024;
 
+// The size to set for the on-disk program cache.
+const size_t kDefaultMaxProgramCacheDiskBytes = 32 * 1024 * 1024;
+
 // Namespace used to separate various command buffer types.
 enum CommandBufferNamespace {
   INVALID = -1,
@@ -47,6 +47,13 @@ const char kForceGpuMemAvailableMb[]        = "force-gpu-mem-available-mb";
 // Sets the maximum size of the in-memory gpu program cache, in kb
 const char kGpuProgramCacheSizeKb[]         = "gpu-program-cache-size-kb";
 
+// Keeps linked gpu programs in the given directory across restarts, for
+// command buffers that run in-process.
+const char kGpuProgramDiskCacheDir[]        = "gpu-program-disk-cache-dir";
+
+// Sets the maximum size of the on-disk gpu program cache, in kb
+const char kGpuProgramDiskCacheSizeKb[]     = "gpu-program-disk-cache-size-kb";
+
 // Disables the GPU shader on disk cache.
 const char kDisableGpuShaderDiskCache[]     = "disable-gpu-shader-disk-cache";
 
@@ -90,6 +97,8 @@ const char* kGpuSwitches[] = {
     kForceGpuMemAvailableMb,
     kGpuDriverBugWorkarounds,
     kGpuProgramCacheSizeKb,
+    kGpuProgramDiskCacheDir,
+    kGpuProgramDiskCacheSizeKb,
     kDisableGpuShaderDiskCache,
     kEnableShareGroupAsyncTextureUpload,
     kEnableSubscribeUniformExtension,
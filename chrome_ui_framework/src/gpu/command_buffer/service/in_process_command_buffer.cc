@@ -17,8 +17,10 @@
 #include "base/memory/weak_ptr.h"
 #include "base/sequence_checker.h"
 #include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/thread_task_runner_handle.h"
 #include "gpu/command_buffer/client/gpu_memory_buffer_manager.h"
+#include "gpu/command_buffer/common/constants.h"
 #include "gpu/command_buffer/common/sync_token.h"
 #include "gpu/command_buffer/common/value_state.h"
 #include "gpu/command_buffer/service/command_buffer_service.h"
@@ -30,6 +32,7 @@
 #include "gpu/command_buffer/service/image_manager.h"
 #include "gpu/command_buffer/service/mailbox_manager.h"
 #include "gpu/command_buffer/service/memory_program_cache.h"
+#include "gpu/command_buffer/service/program_disk_cache.h"
 #include "gpu/command_buffer/service/memory_tracking.h"
 #include "gpu/command_buffer/service/query_manager.h"
 #include "gpu/command_buffer/service/sync_point_manager.h"
@@ -170,7 +173,31 @@ gpu::gles2::ProgramCache* InProcessCommandBuffer::Service::program_cache() {
        gfx::g_driver_gl.ext.b_GL_OES_get_program_binary) &&
       !base::CommandLine::ForCurrentProcess()->HasSwitch(
           switches::kDisableGpuProgramCache)) {
-    program_cache_.reset(new gpu::gles2::MemoryProgramCache());
+    const base::CommandLine* command_line =
+        base::CommandLine::ForCurrentProcess();
+    base::FilePath disk_cache_path =
+        command_line->GetSwitchValuePath(switches::kGpuProgramDiskCacheDir);
+    if (disk_cache_path.empty()) {
+      program_cache_.reset(new gpu::gles2::MemoryProgramCache());
+      return program_cache_.get();
+    }
+
+    size_t disk_cache_size_bytes = kDefaultMaxProgramCacheDiskBytes;
+    size_t size_kb;
+    if (base::StringToSizeT(command_line->GetSwitchValueASCII(
+                                switches::kGpuProgramDiskCacheSizeKb),
+                            &size_kb)) {
+      disk_cache_size_bytes = size_kb * 1024;
+    }
+    program_cache_thread_.reset(new base::Thread("GpuProgramCacheThread"));
+    program_cache_thread_->Start();
+    scoped_ptr<gpu::gles2::ProgramDiskCache> disk_cache(
+        new gpu::gles2::ProgramDiskCache(disk_cache_path,
+                                         disk_cache_size_bytes,
+                                         program_cache_thread_->task_runner()));
+    disk_cache->Initialize();
+    program_cache_.reset(
+        new gpu::gles2::MemoryProgramCache(disk_cache.Pass()));
   }
   return program_cache_.get();
 }
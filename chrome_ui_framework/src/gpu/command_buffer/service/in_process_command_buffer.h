@@ -169,6 +169,9 @@ class GPU_EXPORT InProcessCommandBuffer : public CommandBuffer,
     scoped_refptr<gles2::MailboxManager> mailbox_manager_;
     scoped_refptr<gles2::SubscriptionRefSet> subscription_ref_set_;
     scoped_refptr<gpu::ValueStateMap> pending_valuebuffer_state_;
+    // Writes back the on-disk program cache, if one is used. Declared before
+    // |program_cache_| so that it outlives it.
+    scoped_ptr<base::Thread> program_cache_thread_;
     scoped_ptr<gpu::gles2::ProgramCache> program_cache_;
   };
 
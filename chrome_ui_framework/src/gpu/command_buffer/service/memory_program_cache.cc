@@ -15,6 +15,7 @@
 #include "gpu/command_buffer/service/gl_utils.h"
 #include "gpu/command_buffer/service/gles2_cmd_decoder.h"
 #include "gpu/command_buffer/service/gpu_switches.h"
+#include "gpu/command_buffer/service/program_disk_cache.h"
 #include "gpu/command_buffer/service/shader_manager.h"
 #include "ui/gl/gl_bindings.h"
 
@@ -163,11 +164,26 @@ MemoryProgramCache::MemoryProgramCache(const size_t max_cache_size_bytes)
       store_(ProgramMRUCache::NO_AUTO_EVICT) {
 }
 
+MemoryProgramCache::MemoryProgramCache(
+    scoped_ptr<ProgramDiskCache> disk_cache)
+    : max_size_bytes_(GetCacheSizeBytes()),
+      curr_size_bytes_(0),
+      disk_cache_(disk_cache.Pass()),
+      store_(ProgramMRUCache::NO_AUTO_EVICT) {
+  // Programs on disk are loaded lazily, but have to be reported as linked so
+  // that the program manager tries to load them instead of linking.
+  std::vector<std::string> keys = disk_cache_->GetKeys();
+  for (const std::string& key : keys)
+    LinkedProgramCacheSuccess(key);
+}
+
 MemoryProgramCache::~MemoryProgramCache() {}
 
 void MemoryProgramCache::ClearBackend() {
   store_.Clear();
   DCHECK_EQ(0U, curr_size_bytes_);
+  if (disk_cache_)
+    disk_cache_->Clear();
 }
 
 ProgramCache::ProgramLoadResult MemoryProgramCache::LoadLinkedProgram(
@@ -197,6 +213,21 @@ ProgramCache::ProgramLoadResult MemoryProgramCache::LoadLinkedProgram(
   const std::string sha_string(sha, kHashLength);
 
   ProgramMRUCache::iterator found = store_.Get(sha_string);
+  if (found == store_.end() && disk_cache_) {
+    std::string program;
+    if (disk_cache_->Load(sha_string, &program)) {
+      // The serialized program is a little larger than the binary it holds,
+      // so this makes enough room.
+      while (!store_.empty() &&
+             curr_size_bytes_ + program.size() > max_size_bytes_) {
+        store_.Erase(store_.rbegin());
+      }
+      LoadProgram(program);
+      found = store_.Get(sha_string);
+    }
+    UMA_HISTOGRAM_BOOLEAN("GPU.ProgramCache.DiskCacheHit",
+                          found != store_.end());
+  }
   if (found == store_.end()) {
     return PROGRAM_LOAD_FAILURE;
   }
@@ -288,9 +319,11 @@ void MemoryProgramCache::SaveLinkedProgram(
     store_.Erase(store_.rbegin());
   }
 
-  if (!shader_callback.is_null() &&
+  const bool use_shader_callback =
+      !shader_callback.is_null() &&
       !base::CommandLine::ForCurrentProcess()->HasSwitch(
-          switches::kDisableGpuShaderDiskCache)) {
+          switches::kDisableGpuShaderDiskCache);
+  if (use_shader_callback || disk_cache_) {
     scoped_ptr<GpuProgramProto> proto(
         GpuProgramProto::default_instance().New());
     proto->set_sha(sha, kHashLength);
@@ -299,7 +332,13 @@ void MemoryProgramCache::SaveLinkedProgram(
 
     FillShaderProto(proto->mutable_vertex_shader(), a_sha, shader_a);
     FillShaderProto(proto->mutable_fragment_shader(), b_sha, shader_b);
-    RunShaderCallback(shader_callback, proto.get(), sha_string);
+    if (use_shader_callback)
+      RunShaderCallback(shader_callback, proto.get(), sha_string);
+    if (disk_cache_) {
+      std::string program;
+      proto->SerializeToString(&program);
+      disk_cache_->Store(sha_string, program);
+    }
   }
 
   store_.Put(sha_string,
@@ -414,7 +453,11 @@ MemoryProgramCache::ProgramCacheValue::ProgramCacheValue(
 
 MemoryProgramCache::ProgramCacheValue::~ProgramCacheValue() {
   program_cache_->curr_size_bytes_ -= length_;
-  program_cache_->Evict(program_hash_);
+  // A program that is still on disk can be loaded again.
+  if (!program_cache_->disk_cache_ ||
+      !program_cache_->disk_cache_->Contains(program_hash_)) {
+    program_cache_->Evict(program_hash_);
+  }
 }
 
 }  // namespace gles2
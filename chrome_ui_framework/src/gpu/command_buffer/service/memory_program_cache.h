@@ -18,11 +18,18 @@
 namespace gpu {
 namespace gles2 {
 
-// Program cache that stores binaries completely in-memory
+class ProgramDiskCache;
+
+// Program cache that stores binaries in-memory, optionally backed by a
+// ProgramDiskCache that keeps them across restarts. Programs missing from
+// memory are looked up on disk, and every saved program is written back to
+// disk asynchronously.
 class GPU_EXPORT MemoryProgramCache : public ProgramCache {
  public:
   MemoryProgramCache();
   explicit MemoryProgramCache(const size_t max_cache_size_bytes);
+  // |disk_cache| must already be initialized.
+  explicit MemoryProgramCache(scoped_ptr<ProgramDiskCache> disk_cache);
   ~MemoryProgramCache() override;
 
   ProgramLoadResult LoadLinkedProgram(
@@ -136,6 +143,8 @@ class GPU_EXPORT MemoryProgramCache : public ProgramCache {
 
   const size_t max_size_bytes_;
   size_t curr_size_bytes_;
+  // Declared before |store_|, since destroying cached values consults it.
+  scoped_ptr<ProgramDiskCache> disk_cache_;
   ProgramMRUCache store_;
 
   DISALLOW_COPY_AND_ASSIGN(MemoryProgramCache);
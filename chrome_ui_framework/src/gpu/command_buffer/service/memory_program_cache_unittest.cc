@@ -5,9 +5,12 @@
 #include "gpu/command_buffer/service/memory_program_cache.h"
 
 #include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/test/test_simple_task_runner.h"
 #include "gpu/command_buffer/common/gles2_cmd_format.h"
 #include "gpu/command_buffer/service/gl_utils.h"
 #include "gpu/command_buffer/service/gpu_service_test.h"
+#include "gpu/command_buffer/service/program_disk_cache.h"
 #include "gpu/command_buffer/service/shader_manager.h"
 #include "gpu/command_buffer/service/shader_translator.h"
 #include "gpu/command_buffer/service/test_helper.h"
@@ -657,5 +660,53 @@ TEST_F(MemoryProgramCacheTest, OverwriteOnNewSave) {
                  base::Unretained(this))));
 }
 
+TEST_F(MemoryProgramCacheTest, LoadFromDiskCacheAfterRestart) {
+  const GLenum kFormat = 1;
+  const int kProgramId = 10;
+  const int kBinaryLength = 20;
+  char test_binary[kBinaryLength];
+  for (int i = 0; i < kBinaryLength; ++i) {
+    test_binary[i] = i;
+  }
+  ProgramBinaryEmulator emulator(kBinaryLength, kFormat, test_binary);
+
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  scoped_ptr<ProgramDiskCache> disk_cache(
+      new ProgramDiskCache(dir.path(), 1024 * 1024, task_runner));
+  disk_cache->Initialize();
+  cache_.reset(new MemoryProgramCache(disk_cache.Pass()));
+
+  SetExpectationsForSaveLinkedProgram(kProgramId, &emulator);
+  cache_->SaveLinkedProgram(kProgramId, vertex_shader_,
+                            fragment_shader_, NULL, varyings_, GL_NONE,
+                            ShaderCacheCallback());
+  task_runner->RunPendingTasks();
+
+  // A new cache on the same directory knows about the program without having
+  // read it, and loads it from disk on demand.
+  disk_cache.reset(new ProgramDiskCache(dir.path(), 1024 * 1024, task_runner));
+  disk_cache->Initialize();
+  cache_.reset(new MemoryProgramCache(disk_cache.Pass()));
+  EXPECT_EQ(ProgramCache::LINK_SUCCEEDED, cache_->GetLinkedProgramStatus(
+      vertex_shader_->last_compiled_signature(),
+      fragment_shader_->last_compiled_signature(),
+      NULL, varyings_, GL_NONE));
+
+  vertex_shader_->set_attrib_map(AttributeMap());
+  SetExpectationsForLoadLinkedProgram(kProgramId, &emulator);
+  EXPECT_EQ(ProgramCache::PROGRAM_LOAD_SUCCESS, cache_->LoadLinkedProgram(
+      kProgramId,
+      vertex_shader_,
+      fragment_shader_,
+      NULL,
+      varyings_,
+      GL_NONE,
+      ShaderCacheCallback()));
+  EXPECT_EQ(1u, vertex_shader_->attrib_map().size());
+}
+
 }  // namespace gles2
 }  // namespace gpu
@@ -0,0 +1,294 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gpu/command_buffer/service/program_disk_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/sequenced_task_runner.h"
+#include "base/sha1.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/time/time.h"
+
+namespace gpu {
+namespace gles2 {
+
+namespace {
+
+// Header written in front of every entry. All fields are in host byte order;
+// an entry written on a machine with a different byte order fails the magic
+// check and is discarded like any other corrupt entry.
+struct EntryHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 payload_size;
+  char payload_sha1[base::kSHA1Length];
+};
+
+const uint32 kEntryMagic = 0x43504750;  // "PGPC"
+const uint32 kEntryVersion = 1;
+
+std::string SerializeEntry(const std::string& value) {
+  EntryHeader header;
+  header.magic = kEntryMagic;
+  header.version = kEntryVersion;
+  header.payload_size = static_cast<uint32>(value.size());
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(value.data()),
+                      value.size(),
+                      reinterpret_cast<unsigned char*>(header.payload_sha1));
+
+  std::string contents;
+  contents.reserve(sizeof(header) + value.size());
+  contents.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  contents.append(value);
+  return contents;
+}
+
+// Returns false if |contents| is not a well formed entry.
+bool ParseEntry(const std::string& contents, std::string* value) {
+  if (contents.size() < sizeof(EntryHeader))
+    return false;
+  EntryHeader header;
+  memcpy(&header, contents.data(), sizeof(header));
+  if (header.magic != kEntryMagic || header.version != kEntryVersion ||
+      header.payload_size != contents.size() - sizeof(header)) {
+    return false;
+  }
+
+  char payload_sha1[base::kSHA1Length];
+  base::SHA1HashBytes(
+      reinterpret_cast<const unsigned char*>(contents.data()) + sizeof(header),
+      header.payload_size, reinterpret_cast<unsigned char*>(payload_sha1));
+  if (memcmp(payload_sha1, header.payload_sha1, base::kSHA1Length))
+    return false;
+
+  value->assign(contents, sizeof(header), header.payload_size);
+  return true;
+}
+
+void DeleteEntry(const base::FilePath& path) {
+  base::DeleteFile(path, false);
+}
+
+// Records a use of the entry at |path|, so that the LRU order survives a
+// restart.
+void TouchEntry(const base::FilePath& path, const base::Time& time) {
+  base::TouchFile(path, time, time);
+}
+
+struct IndexEntry {
+  std::string key;
+  size_t size;
+  base::Time last_used;
+};
+
+bool IndexEntryLessRecentlyUsed(const IndexEntry& a, const IndexEntry& b) {
+  return a.last_used < b.last_used;
+}
+
+}  // namespace
+
+// The serialized contents of an entry whose write has been posted to the task
+// runner. |done| is set on the task runner once the write has run.
+class ProgramDiskCache::PendingWrite
+    : public base::RefCountedThreadSafe<PendingWrite> {
+ public:
+  explicit PendingWrite(const std::string& contents) : contents_(contents) {}
+
+  static void Write(const base::FilePath& path,
+                    const scoped_refptr<PendingWrite>& write) {
+    if (!base::ImportantFileWriter::WriteFileAtomically(path,
+                                                        write->contents_)) {
+      LOG(WARNING) << "Failed to write program cache entry " << path.value();
+    }
+    write->done_.Set();
+  }
+
+  const std::string& contents() const { return contents_; }
+  bool done() const { return done_.IsSet(); }
+
+ private:
+  friend class base::RefCountedThreadSafe<PendingWrite>;
+
+  ~PendingWrite() {}
+
+  const std::string contents_;
+  base::CancellationFlag done_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingWrite);
+};
+
+ProgramDiskCache::ProgramDiskCache(
+    const base::FilePath& path,
+    size_t max_size_bytes,
+    const scoped_refptr<base::SequencedTaskRunner>& task_runner)
+    : path_(path),
+      max_size_bytes_(max_size_bytes),
+      task_runner_(task_runner),
+      size_bytes_(0),
+      entries_(EntryMRUCache::NO_AUTO_EVICT) {
+}
+
+ProgramDiskCache::~ProgramDiskCache() {}
+
+void ProgramDiskCache::Initialize() {
+  DCHECK(entries_.empty());
+  if (!base::CreateDirectory(path_)) {
+    LOG(WARNING) << "Failed to create program cache directory "
+                 << path_.value();
+    return;
+  }
+
+  std::vector<IndexEntry> index;
+  base::FileEnumerator enumerator(path_, false, base::FileEnumerator::FILES);
+  for (base::FilePath file = enumerator.Next(); !file.empty();
+       file = enumerator.Next()) {
+    // Skip anything that is not named like an entry, such as the temporary
+    // files left behind by an interrupted write.
+    std::vector<uint8> key;
+    const std::string name = file.BaseName().MaybeAsASCII();
+    if (name.size() != 2 * base::kSHA1Length ||
+        !base::HexStringToBytes(name, &key)) {
+      continue;
+    }
+    base::FileEnumerator::FileInfo info = enumerator.GetInfo();
+    IndexEntry entry;
+    entry.key.assign(key.begin(), key.end());
+    entry.size = static_cast<size_t>(info.GetSize());
+    entry.last_used = info.GetLastModifiedTime();
+    index.push_back(entry);
+  }
+
+  // Put() makes an entry the most recently used, so insert the oldest first.
+  std::sort(index.begin(), index.end(), IndexEntryLessRecentlyUsed);
+  for (const IndexEntry& entry : index) {
+    entries_.Put(entry.key, entry.size);
+    size_bytes_ += entry.size;
+  }
+  EvictIfNeeded();
+
+  UMA_HISTOGRAM_COUNTS("GPU.ProgramCache.DiskCacheSizeKb", size_bytes_ / 1024);
+}
+
+bool ProgramDiskCache::Load(const std::string& key, std::string* value) {
+  EntryMRUCache::iterator it = entries_.Get(key);
+  if (it == entries_.end())
+    return false;
+
+  // An entry whose write has not run yet is read from memory, since its file
+  // may be missing or still hold an older version.
+  const base::FilePath entry_path = GetEntryPath(key);
+  std::string contents;
+  bool read = false;
+  PendingWriteMap::iterator pending = pending_writes_.find(key);
+  if (pending != pending_writes_.end() && !pending->second->done()) {
+    contents = pending->second->contents();
+    read = true;
+  } else {
+    if (pending != pending_writes_.end())
+      pending_writes_.erase(pending);
+    read = base::ReadFileToString(entry_path, &contents);
+  }
+  const bool valid = read && ParseEntry(contents, value);
+  UMA_HISTOGRAM_BOOLEAN("GPU.ProgramCache.DiskEntryValid", valid);
+  if (!valid) {
+    Remove(key);
+    return false;
+  }
+
+  task_runner_->PostTask(
+      FROM_HERE, base::Bind(&TouchEntry, entry_path, base::Time::Now()));
+  return true;
+}
+
+void ProgramDiskCache::Store(const std::string& key,
+                             const std::string& value) {
+  RemoveFinishedWrites();
+  EntryMRUCache::iterator existing = entries_.Peek(key);
+  if (existing != entries_.end()) {
+    size_bytes_ -= existing->second;
+    entries_.Erase(existing);
+  }
+
+  std::string contents = SerializeEntry(value);
+  if (contents.size() > max_size_bytes_) {
+    pending_writes_.erase(key);
+    task_runner_->PostTask(FROM_HERE,
+                           base::Bind(&DeleteEntry, GetEntryPath(key)));
+    return;
+  }
+
+  entries_.Put(key, contents.size());
+  size_bytes_ += contents.size();
+  scoped_refptr<PendingWrite> write(new PendingWrite(contents));
+  pending_writes_[key] = write;
+  task_runner_->PostTask(
+      FROM_HERE, base::Bind(&PendingWrite::Write, GetEntryPath(key), write));
+  EvictIfNeeded();
+}
+
+bool ProgramDiskCache::Contains(const std::string& key) const {
+  return entries_.Peek(key) != entries_.end();
+}
+
+std::vector<std::string> ProgramDiskCache::GetKeys() const {
+  std::vector<std::string> keys;
+  keys.reserve(entries_.size());
+  for (EntryMRUCache::const_iterator it = entries_.begin();
+       it != entries_.end(); ++it) {
+    keys.push_back(it->first);
+  }
+  return keys;
+}
+
+void ProgramDiskCache::Clear() {
+  while (!entries_.empty())
+    Remove(entries_.begin()->first);
+  DCHECK_EQ(0u, size_bytes_);
+}
+
+base::FilePath ProgramDiskCache::GetEntryPath(const std::string& key) const {
+  return path_.AppendASCII(base::HexEncode(key.data(), key.size()));
+}
+
+void ProgramDiskCache::Remove(const std::string& key) {
+  // |key| may be owned by the entry, so use it before erasing.
+  task_runner_->PostTask(FROM_HERE,
+                         base::Bind(&DeleteEntry, GetEntryPath(key)));
+  pending_writes_.erase(key);
+  EntryMRUCache::iterator it = entries_.Peek(key);
+  DCHECK(it != entries_.end());
+  size_bytes_ -= it->second;
+  entries_.Erase(it);
+}
+
+void ProgramDiskCache::EvictIfNeeded() {
+  while (size_bytes_ > max_size_bytes_) {
+    DCHECK(!entries_.empty());
+    Remove(entries_.rbegin()->first);
+  }
+}
+
+void ProgramDiskCache::RemoveFinishedWrites() {
+  for (PendingWriteMap::iterator it = pending_writes_.begin();
+       it != pending_writes_.end();) {
+    if (it->second->done())
+      pending_writes_.erase(it++);
+    else
+      ++it;
+  }
+}
+
+}  // namespace gles2
+}  // namespace gpu
@@ -0,0 +1,103 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GPU_COMMAND_BUFFER_SERVICE_PROGRAM_DISK_CACHE_H_
+#define GPU_COMMAND_BUFFER_SERVICE_PROGRAM_DISK_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "gpu/gpu_export.h"
+
+namespace base {
+class SequencedTaskRunner;
+}
+
+namespace gpu {
+namespace gles2 {
+
+// Persistent second tier for MemoryProgramCache. Every entry is stored in its
+// own file under |path|, named after the hex encoded program hash, and holds a
+// serialized GpuProgramProto behind a small header with a SHA-1 digest of the
+// payload. Entries that fail the integrity check are treated as misses and
+// deleted.
+//
+// The index of entries is kept in memory and is used on the thread that owns
+// the cache. Reads are synchronous, since a program load cannot wait, but all
+// writes, deletions and LRU timestamp updates are posted to |task_runner|.
+// Entries stay in memory until their write has run, so that a load right
+// after a store does not depend on the write having happened.
+// The on-disk size is capped at |max_size_bytes|; the least recently used
+// entries are evicted first, across restarts too, based on file modification
+// times.
+class GPU_EXPORT ProgramDiskCache {
+ public:
+  ProgramDiskCache(const base::FilePath& path,
+                   size_t max_size_bytes,
+                   const scoped_refptr<base::SequencedTaskRunner>& task_runner);
+  ~ProgramDiskCache();
+
+  // Builds the index from the files under |path|, creating the directory if
+  // needed, and evicts entries over the size cap. Blocks on file I/O; must be
+  // called once before any other method.
+  void Initialize();
+
+  // Reads the entry for |key| into |value|. Returns false if there is no such
+  // entry or it is corrupt.
+  bool Load(const std::string& key, std::string* value);
+
+  // Writes |value| for |key|, replacing any existing entry.
+  void Store(const std::string& key, const std::string& value);
+
+  // Returns true if there is an entry for |key|, without reading it.
+  bool Contains(const std::string& key) const;
+
+  // Returns the keys of all entries, most recently used first.
+  std::vector<std::string> GetKeys() const;
+
+  // Deletes all entries.
+  void Clear();
+
+  size_t size_bytes() const { return size_bytes_; }
+  size_t entry_count() const { return entries_.size(); }
+
+ private:
+  class PendingWrite;
+
+  // Maps keys to entry file sizes.
+  typedef base::MRUCache<std::string, size_t> EntryMRUCache;
+  typedef std::map<std::string, scoped_refptr<PendingWrite>> PendingWriteMap;
+
+  base::FilePath GetEntryPath(const std::string& key) const;
+
+  // Removes |key| from the index and deletes its file.
+  void Remove(const std::string& key);
+
+  // Evicts the least recently used entries until the cache fits in
+  // |max_size_bytes_|.
+  void EvictIfNeeded();
+
+  // Forgets the writes that have finished running.
+  void RemoveFinishedWrites();
+
+  const base::FilePath path_;
+  const size_t max_size_bytes_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  size_t size_bytes_;
+  EntryMRUCache entries_;
+  PendingWriteMap pending_writes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgramDiskCache);
+};
+
+}  // namespace gles2
+}  // namespace gpu
+
+#endif  // GPU_COMMAND_BUFFER_SERVICE_PROGRAM_DISK_CACHE_H_
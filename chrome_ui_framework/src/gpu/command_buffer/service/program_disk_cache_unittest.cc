@@ -0,0 +1,193 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gpu/command_buffer/service/program_disk_cache.h"
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/sha1.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/test/test_simple_task_runner.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace gpu {
+namespace gles2 {
+
+namespace {
+
+// Size of the header in front of every entry.
+const size_t kHeaderSize = 12 + base::kSHA1Length;
+
+std::string CreateKey(char c) {
+  return std::string(base::kSHA1Length, c);
+}
+
+}  // namespace
+
+class ProgramDiskCacheTest : public testing::Test {
+ public:
+  ProgramDiskCacheTest() : task_runner_(new base::TestSimpleTaskRunner) {}
+
+  void SetUp() override { ASSERT_TRUE(dir_.CreateUniqueTempDir()); }
+
+  scoped_ptr<ProgramDiskCache> CreateCache(size_t max_size_bytes) {
+    scoped_ptr<ProgramDiskCache> cache(
+        new ProgramDiskCache(dir_.path(), max_size_bytes, task_runner_));
+    cache->Initialize();
+    return cache.Pass();
+  }
+
+  base::FilePath GetEntryPath(const std::string& key) {
+    return dir_.path().AppendASCII(base::HexEncode(key.data(), key.size()));
+  }
+
+ protected:
+  base::ScopedTempDir dir_;
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ProgramDiskCacheTest);
+};
+
+TEST_F(ProgramDiskCacheTest, StoreAndLoadAcrossRestart) {
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(1024 * 1024);
+  cache->Store(CreateKey('a'), "program a");
+  cache->Store(CreateKey('b'), "program b");
+  EXPECT_TRUE(cache->Contains(CreateKey('a')));
+  EXPECT_EQ(2u, cache->entry_count());
+
+  // Nothing is written until the task runner runs.
+  EXPECT_FALSE(base::PathExists(GetEntryPath(CreateKey('a'))));
+  task_runner_->RunPendingTasks();
+  EXPECT_TRUE(base::PathExists(GetEntryPath(CreateKey('a'))));
+
+  cache = CreateCache(1024 * 1024);
+  EXPECT_EQ(2u, cache->entry_count());
+  EXPECT_EQ(2 * (kHeaderSize + 9), cache->size_bytes());
+  std::string value;
+  EXPECT_TRUE(cache->Load(CreateKey('a'), &value));
+  EXPECT_EQ("program a", value);
+  EXPECT_TRUE(cache->Load(CreateKey('b'), &value));
+  EXPECT_EQ("program b", value);
+  EXPECT_FALSE(cache->Load(CreateKey('c'), &value));
+}
+
+TEST_F(ProgramDiskCacheTest, CorruptEntryIsDeleted) {
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(1024 * 1024);
+  cache->Store(CreateKey('a'), "program a");
+  task_runner_->RunPendingTasks();
+
+  // Flip a byte of the payload.
+  const base::FilePath path = GetEntryPath(CreateKey('a'));
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(path, &contents));
+  contents[contents.size() - 1] ^= 1;
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(path, contents.data(), contents.size()));
+
+  std::string value;
+  EXPECT_FALSE(cache->Load(CreateKey('a'), &value));
+  EXPECT_FALSE(cache->Contains(CreateKey('a')));
+  task_runner_->RunPendingTasks();
+  EXPECT_FALSE(base::PathExists(path));
+
+  // A truncated entry is rejected too.
+  cache->Store(CreateKey('b'), "program b");
+  task_runner_->RunPendingTasks();
+  ASSERT_EQ(4, base::WriteFile(GetEntryPath(CreateKey('b')), "PGPC", 4));
+  EXPECT_FALSE(cache->Load(CreateKey('b'), &value));
+}
+
+TEST_F(ProgramDiskCacheTest, LoadWhileWritePending) {
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(1024 * 1024);
+  cache->Store(CreateKey('a'), "program a");
+
+  // The file does not exist yet, but the entry is still loaded.
+  std::string value;
+  EXPECT_TRUE(cache->Load(CreateKey('a'), &value));
+  EXPECT_EQ("program a", value);
+  EXPECT_TRUE(cache->Contains(CreateKey('a')));
+  task_runner_->RunPendingTasks();
+  EXPECT_TRUE(base::PathExists(GetEntryPath(CreateKey('a'))));
+
+  // A replacement is loaded instead of the older file.
+  cache->Store(CreateKey('a'), "program A");
+  EXPECT_TRUE(cache->Load(CreateKey('a'), &value));
+  EXPECT_EQ("program A", value);
+  task_runner_->RunPendingTasks();
+  EXPECT_TRUE(cache->Load(CreateKey('a'), &value));
+  EXPECT_EQ("program A", value);
+}
+
+TEST_F(ProgramDiskCacheTest, EvictsLeastRecentlyUsed) {
+  const size_t kEntrySize = kHeaderSize + 9;
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(2 * kEntrySize);
+  cache->Store(CreateKey('a'), "program a");
+  cache->Store(CreateKey('b'), "program b");
+  std::string value;
+  EXPECT_TRUE(cache->Load(CreateKey('a'), &value));
+  cache->Store(CreateKey('c'), "program c");
+  task_runner_->RunPendingTasks();
+
+  EXPECT_EQ(2 * kEntrySize, cache->size_bytes());
+  EXPECT_TRUE(cache->Contains(CreateKey('a')));
+  EXPECT_FALSE(cache->Contains(CreateKey('b')));
+  EXPECT_TRUE(cache->Contains(CreateKey('c')));
+  EXPECT_FALSE(base::PathExists(GetEntryPath(CreateKey('b'))));
+
+  // An entry larger than the whole cache is not kept.
+  cache->Store(CreateKey('d'), std::string(2 * kEntrySize, 'x'));
+  EXPECT_FALSE(cache->Contains(CreateKey('d')));
+  EXPECT_EQ(2u, cache->entry_count());
+}
+
+TEST_F(ProgramDiskCacheTest, InitializeTrimsToSizeCap) {
+  const size_t kEntrySize = kHeaderSize + 9;
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(1024 * 1024);
+  cache->Store(CreateKey('a'), "program a");
+  cache->Store(CreateKey('b'), "program b");
+  cache->Store(CreateKey('c'), "program c");
+  task_runner_->RunPendingTasks();
+
+  // Give the entries distinct, increasing modification times.
+  const base::Time now = base::Time::Now();
+  ASSERT_TRUE(base::TouchFile(GetEntryPath(CreateKey('a')),
+                              now - base::TimeDelta::FromHours(1),
+                              now - base::TimeDelta::FromHours(1)));
+  ASSERT_TRUE(base::TouchFile(GetEntryPath(CreateKey('b')),
+                              now - base::TimeDelta::FromHours(3),
+                              now - base::TimeDelta::FromHours(3)));
+  ASSERT_TRUE(base::TouchFile(GetEntryPath(CreateKey('c')),
+                              now - base::TimeDelta::FromHours(2),
+                              now - base::TimeDelta::FromHours(2)));
+  // Files that are not entries are ignored.
+  ASSERT_EQ(3, base::WriteFile(dir_.path().AppendASCII("tmp"), "abc", 3));
+
+  cache = CreateCache(2 * kEntrySize);
+  task_runner_->RunPendingTasks();
+  EXPECT_EQ(2u, cache->entry_count());
+  EXPECT_FALSE(cache->Contains(CreateKey('b')));
+  EXPECT_FALSE(base::PathExists(GetEntryPath(CreateKey('b'))));
+
+  std::vector<std::string> keys = cache->GetKeys();
+  ASSERT_EQ(2u, keys.size());
+  EXPECT_EQ(CreateKey('a'), keys[0]);
+  EXPECT_EQ(CreateKey('c'), keys[1]);
+}
+
+TEST_F(ProgramDiskCacheTest, Clear) {
+  scoped_ptr<ProgramDiskCache> cache = CreateCache(1024 * 1024);
+  cache->Store(CreateKey('a'), "program a");
+  cache->Store(CreateKey('b'), "program b");
+  cache->Clear();
+  task_runner_->RunPendingTasks();
+
+  EXPECT_EQ(0u, cache->entry_count());
+  EXPECT_EQ(0u, cache->size_bytes());
+  EXPECT_TRUE(base::IsDirectoryEmpty(dir_.path()));
+}
+
+}  // namespace gles2
+}  // namespace gpu
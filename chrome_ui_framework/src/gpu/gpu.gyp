@@ -245,6 +245,7 @@
         'command_buffer/service/mocks.cc',
         'command_buffer/service/mocks.h',
         'command_buffer/service/program_cache_unittest.cc',
+        'command_buffer/service/program_disk_cache_unittest.cc',
         'command_buffer/service/program_manager_unittest.cc',
         'command_buffer/service/query_manager_unittest.cc',
         'command_buffer/service/renderbuffer_manager_unittest.cc',
@@ -305,6 +306,7 @@
       ],
       'sources': [
         'perftests/measurements.cc',
+        'perftests/program_cache_perftest.cc',
         'perftests/run_all_tests.cc',
         'perftests/texture_upload_perftest.cc',
       ],
@@ -0,0 +1,223 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/test_simple_task_runner.h"
+#include "base/time/time.h"
+#include "gpu/command_buffer/common/constants.h"
+#include "gpu/command_buffer/service/memory_program_cache.h"
+#include "gpu/command_buffer/service/program_disk_cache.h"
+#include "gpu/command_buffer/service/shader_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gl/gl_bindings.h"
+#include "ui/gl/gl_context.h"
+#include "ui/gl/gl_implementation.h"
+#include "ui/gl/gl_surface.h"
+#include "ui/gl/scoped_make_current.h"
+
+#if defined(USE_OZONE)
+#include "base/message_loop/message_loop.h"
+#endif
+
+namespace gpu {
+namespace {
+
+// Roughly the number of programs the compositor links at startup.
+const int kProgramCount = 40;
+
+#define SHADER(Src) #Src
+
+// clang-format off
+const char kVertexShader[] =
+SHADER(
+  uniform mat4 matrix;
+  attribute vec4 a_position;
+  attribute vec2 a_texCoord;
+  varying vec2 v_texCoord;
+  void main() {
+    gl_Position = matrix * a_position;
+    v_texCoord = a_texCoord;
+  }
+);
+// Every program gets a different constant, so that the driver cannot share
+// compiled shaders between them.
+const char kFragmentShaderFormat[] =
+SHADER(
+  %s
+  uniform sampler2D s_texture;
+  varying vec2 v_texCoord;
+  void main() {
+    vec4 color = texture2D(s_texture, v_texCoord);
+    gl_FragColor = color * vec4(%d.0 / 64.0, 1.0, 1.0, 1.0);
+  }
+);
+// clang-format on
+
+// Times process startup for the compositor's programs through
+// MemoryProgramCache: with an empty cache every program is compiled and
+// linked, then saved; with a warm ProgramDiskCache the index is rebuilt from
+// disk and every program is loaded from its binary, as the program manager
+// does when the cache reports the program as linked.
+class ProgramCachePerfTest : public testing::Test {
+ public:
+  ProgramCachePerfTest()
+      : task_runner_(new base::TestSimpleTaskRunner), next_client_id_(1) {}
+
+  void SetUp() override {
+#if defined(USE_OZONE)
+    // On Ozone, the backend initializes the event system using a UI
+    // thread.
+    base::MessageLoopForUI main_loop;
+#endif
+    static bool gl_initialized = gfx::GLSurface::InitializeOneOff();
+    DCHECK(gl_initialized);
+    surface_ = gfx::GLSurface::CreateOffscreenGLSurface(gfx::Size());
+    gl_context_ = gfx::GLContext::CreateGLContext(NULL,  // share_group
+                                                  surface_.get(),
+                                                  gfx::PreferIntegratedGpu);
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+  }
+
+  void TearDown() override {
+    {
+      ui::ScopedMakeCurrent smc(gl_context_.get(), surface_.get());
+      program_cache_ = nullptr;
+      shader_manager_.Destroy(true);
+    }
+    gl_context_ = nullptr;
+    surface_ = nullptr;
+  }
+
+ protected:
+  // Creates the shaders of program |index| and requests their compilation,
+  // which records the source the program cache hashes. The driver only
+  // compiles them if |compile| is true.
+  void CreateShaders(int index,
+                     bool compile,
+                     gles2::Shader** vertex_shader,
+                     gles2::Shader** fragment_shader) {
+    bool is_gles = gfx::GetGLImplementation() == gfx::kGLImplementationEGLGLES2;
+    *vertex_shader = CreateShader(GL_VERTEX_SHADER, kVertexShader, compile);
+    *fragment_shader = CreateShader(
+        GL_FRAGMENT_SHADER,
+        base::StringPrintf(kFragmentShaderFormat,
+                           is_gles ? "precision mediump float;" : "", index),
+        compile);
+  }
+
+  // Creates an empty program cache backed by a ProgramDiskCache on |dir_|,
+  // which is indexed first.
+  void CreateProgramCache() {
+    program_cache_ = nullptr;
+    scoped_ptr<gles2::ProgramDiskCache> disk_cache(new gles2::ProgramDiskCache(
+        dir_.path(), kDefaultMaxProgramCacheDiskBytes, task_runner_));
+    disk_cache->Initialize();
+    program_cache_.reset(new gles2::MemoryProgramCache(disk_cache.Pass()));
+  }
+
+  scoped_refptr<gfx::GLSurface> surface_;
+  scoped_refptr<gfx::GLContext> gl_context_;
+  base::ScopedTempDir dir_;
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner_;
+  gles2::ShaderManager shader_manager_;
+  scoped_ptr<gles2::MemoryProgramCache> program_cache_;
+  const std::vector<std::string> varyings_;
+
+ private:
+  gles2::Shader* CreateShader(GLenum type,
+                              const std::string& source,
+                              bool compile) {
+    gles2::Shader* shader = shader_manager_.CreateShader(
+        next_client_id_++, glCreateShader(type), type);
+    shader->set_source(source);
+    shader->RequestCompile(NULL, gles2::Shader::kGL);
+    if (compile) {
+      shader->DoCompile();
+      CHECK(shader->valid());
+    }
+    return shader;
+  }
+
+  GLuint next_client_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgramCachePerfTest);
+};
+
+TEST_F(ProgramCachePerfTest, Startup) {
+  ui::ScopedMakeCurrent smc(gl_context_.get(), surface_.get());
+  if (!gl_context_->HasExtension("GL_ARB_get_program_binary") &&
+      !gl_context_->HasExtension("GL_OES_get_program_binary")) {
+    LOG(WARNING) << "Program binaries are not supported, skipping test.";
+    return;
+  }
+
+  // Cold: compile, link and save everything, as on a first run.
+  CreateProgramCache();
+  std::vector<GLuint> programs;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kProgramCount; ++i) {
+    gles2::Shader* vertex_shader = NULL;
+    gles2::Shader* fragment_shader = NULL;
+    CreateShaders(i, true, &vertex_shader, &fragment_shader);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader->service_id());
+    glAttachShader(program, fragment_shader->service_id());
+    glLinkProgram(program);
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    ASSERT_NE(0, linked);
+    program_cache_->SaveLinkedProgram(program, vertex_shader, fragment_shader,
+                                      NULL, varyings_, GL_NONE,
+                                      gles2::ShaderCacheCallback());
+    programs.push_back(program);
+  }
+  glFinish();
+  perf_test::PrintResult("program_cache_startup", "", "cold",
+                         (base::TimeTicks::Now() - start).InMillisecondsF(),
+                         "ms", true);
+
+  // Let the disk cache write everything out.
+  task_runner_->RunPendingTasks();
+  for (GLuint program : programs)
+    glDeleteProgram(program);
+  programs.clear();
+
+  // Warm: rebuild the index and load every program from disk.
+  start = base::TimeTicks::Now();
+  CreateProgramCache();
+  for (int i = 0; i < kProgramCount; ++i) {
+    gles2::Shader* vertex_shader = NULL;
+    gles2::Shader* fragment_shader = NULL;
+    CreateShaders(i, false, &vertex_shader, &fragment_shader);
+    ASSERT_EQ(gles2::ProgramCache::LINK_SUCCEEDED,
+              program_cache_->GetLinkedProgramStatus(
+                  vertex_shader->last_compiled_signature(),
+                  fragment_shader->last_compiled_signature(), NULL, varyings_,
+                  GL_NONE));
+    GLuint program = glCreateProgram();
+    ASSERT_EQ(gles2::ProgramCache::PROGRAM_LOAD_SUCCESS,
+              program_cache_->LoadLinkedProgram(
+                  program, vertex_shader, fragment_shader, NULL, varyings_,
+                  GL_NONE, gles2::ShaderCacheCallback()));
+    programs.push_back(program);
+  }
+  glFinish();
+  perf_test::PrintResult("program_cache_startup", "", "warm",
+                         (base::TimeTicks::Now() - start).InMillisecondsF(),
+                         "ms", true);
+
+  for (GLuint program : programs)
+    glDeleteProgram(program);
+  task_runner_->RunPendingTasks();
+}
+
+}  // namespace
+}  // namespace gpu
@@ -87,7 +87,11 @@ class IPC_EXPORT Channel : public Endpoint {
     // The client will return the message with hops = 1, *after* it
     // has received the message that contains the FD. When we
     // receive it again on the sender side, we close the FD.
-    CLOSE_FD_MESSAGE_TYPE = HELLO_MESSAGE_TYPE - 1
+    CLOSE_FD_MESSAGE_TYPE = HELLO_MESSAGE_TYPE - 1,
+    // The SHARED_MEMORY_RING_MESSAGE_TYPE is sent by a POSIX channel to offer
+    // its peer the shared memory ring that it will send messages through, or
+    // to accept the offer of the peer. See ChannelPosix.
+    SHARED_MEMORY_RING_MESSAGE_TYPE = HELLO_MESSAGE_TYPE - 2
   };
 
   // The maximum message size in bytes. Attempting to receive a message of this
@@ -215,6 +215,8 @@ bool ChannelNacl::Send(Message* message) {
                          "ChannelNacl::Send",
                          message->header()->flags,
                          TRACE_EVENT_FLAG_FLOW_OUT);
+  // The pipe is written from data(), which must hold the whole message.
+  message->Flatten();
   output_queue_.push_back(linked_ptr<Message>(message_ptr.release()));
   if (!waiting_connect_)
     return ProcessOutgoingMessages();
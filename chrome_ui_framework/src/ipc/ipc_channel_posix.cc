@@ -17,6 +17,10 @@
 #include <sys/uio.h>
 #endif
 
+#if defined(OS_LINUX)
+#include <sys/eventfd.h>
+#endif
+
 #if !defined(OS_NACL_NONSFI)
 #include <sys/un.h>
 #endif
@@ -24,6 +28,7 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/command_line.h"
 #include "base/files/file_path.h"
@@ -31,12 +36,14 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
 #include "base/memory/singleton.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/posix/global_descriptors.h"
 #include "base/process/process_handle.h"
 #include "base/rand_util.h"
 #include "base/stl_util.h"
+#include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
 #include "base/synchronization/lock.h"
 #include "ipc/attachment_broker.h"
@@ -46,6 +53,7 @@
 #include "ipc/ipc_message_attachment_set.h"
 #include "ipc/ipc_message_utils.h"
 #include "ipc/ipc_platform_file_attachment_posix.h"
+#include "ipc/ipc_shared_memory_ring.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/unix_domain_socket_util.h"
 
@@ -64,6 +72,17 @@ namespace IPC {
 // A POSIX IPC channel can also be set up as a server for a bound UNIX domain
 // socket, and will handle multiple connect and disconnect sequences.  Currently
 // it is limited to one connection at a time.
+//
+// Once connected, a channel can send its messages through a ring buffer in
+// shared memory instead of the socket, which saves a system call and a copy
+// into the kernel per message. Each end creates the ring that it writes to,
+// and offers it to the peer in a SHARED_MEMORY_RING_MESSAGE, along with an
+// eventfd that the peer signals to wake it up; an end that is offered a ring
+// offers its own in return. Messages with attachments still go through the
+// socket. Before such a message is sent, the writer waits for the peer to
+// drain the ring, and the reader reads the socket before the bytes that it
+// finds in the ring, so that messages are dispatched in the order they were
+// sent.
 
 //------------------------------------------------------------------------------
 namespace {
@@ -166,6 +185,36 @@ bool SocketWriteErrorIsRecoverable() {
 #endif  // OS_MACOSX
 }
 
+// The most segments of a message with external data that are passed to one
+// sendmsg() call.
+const size_t kMaxIOVecs = 64;
+
+// Fills |iov| with up to kMaxIOVecs segments of |message|, from byte |offset|
+// of the message on. Returns the number of segments, and their size in
+// |size|.
+size_t GetMessageIOVecs(const Message& message,
+                        size_t offset,
+                        struct iovec* iov,
+                        size_t* size) {
+  std::vector<base::StringPiece> segments;
+  message.GetSegments(&segments);
+  size_t count = 0;
+  *size = 0;
+  for (const base::StringPiece& segment : segments) {
+    if (offset >= segment.size()) {
+      offset -= segment.size();
+      continue;
+    }
+    iov[count].iov_base = const_cast<char*>(segment.data() + offset);
+    iov[count].iov_len = segment.size() - offset;
+    *size += iov[count].iov_len;
+    offset = 0;
+    if (++count == kMaxIOVecs)
+      break;
+  }
+  return count;
+}
+
 }  // namespace
 
 #if defined(OS_ANDROID)
@@ -192,6 +241,10 @@ ChannelPosix::ChannelPosix(const IPC::ChannelHandle& channel_handle,
       waiting_connect_(true),
       message_send_bytes_written_(0),
       pipe_name_(channel_handle.name),
+      ring_capacity_(0),
+      output_ring_offered_(false),
+      is_writing_to_ring_(false),
+      is_blocked_on_ring_(false),
       in_dtor_(false),
       must_unlink_(false) {
   if (!CreatePipe(channel_handle)) {
@@ -386,7 +439,7 @@ void ChannelPosix::CloseFileDescriptors(Message* msg) {
 bool ChannelPosix::ProcessOutgoingMessages() {
   if (waiting_connect_)
     return true;
-  if (is_blocked_on_write_)
+  if (is_blocked_on_write_ || is_blocked_on_ring_)
     return true;
   if (output_queue_.empty())
     return true;
@@ -397,23 +450,55 @@ bool ChannelPosix::ProcessOutgoingMessages() {
   // more outgoing messages.
   while (!output_queue_.empty()) {
     OutputElement* element = output_queue_.front();
+    Message* msg = element->get_message();
 
-    size_t amt_to_write = element->size() - message_send_bytes_written_;
+    if (CanSendThroughRing(element)) {
+      if (!WriteToOutputRing(element))
+        return false;
+      if (is_blocked_on_ring_)
+        return true;
+      delete output_queue_.front();
+      output_queue_.pop();
+      continue;
+    }
+
+    // The messages written to the ring before this one must be dispatched
+    // first, and the peer reads the ring after the socket.
+    if (message_send_bytes_written_ == 0 && output_ring_offered_ &&
+        !output_ring_->IsDrained()) {
+      output_ring_->WaitForReader();
+      if (!output_ring_->IsDrained()) {
+        is_blocked_on_ring_ = true;
+        return true;
+      }
+    }
+
+    // The external data of a message is sent from where it is, in the
+    // segments between the runs of the message's buffer.
+    struct iovec iov[kMaxIOVecs];
+    size_t iov_count = 1;
+    size_t amt_to_write = 0;
+    if (msg && msg->has_external_data()) {
+      iov_count = GetMessageIOVecs(*msg, message_send_bytes_written_, iov,
+                                   &amt_to_write);
+    } else {
+      amt_to_write = element->size() - message_send_bytes_written_;
+      iov[0].iov_base = const_cast<char*>(
+          reinterpret_cast<const char*>(element->data()) +
+          message_send_bytes_written_);
+      iov[0].iov_len = amt_to_write;
+    }
     DCHECK_NE(0U, amt_to_write);
-    const char* out_bytes = reinterpret_cast<const char*>(element->data()) +
-        message_send_bytes_written_;
 
     struct msghdr msgh = {0};
-    struct iovec iov = {const_cast<char*>(out_bytes), amt_to_write};
-    msgh.msg_iov = &iov;
-    msgh.msg_iovlen = 1;
+    msgh.msg_iov = iov;
+    msgh.msg_iovlen = iov_count;
     char buf[CMSG_SPACE(sizeof(int) *
                         MessageAttachmentSet::kMaxDescriptorsPerMessage)];
 
     ssize_t bytes_written = 1;
     int fd_written = -1;
 
-    Message* msg = element->get_message();
     if (message_send_bytes_written_ == 0 && msg &&
         msg->attachment_set()->num_non_brokerable_attachments()) {
       // This is the first chunk of a message which has descriptors to send
@@ -492,11 +577,18 @@ bool ChannelPosix::ProcessOutgoingMessages() {
           &write_watcher_,
           this);
       return true;
+    } else if (message_send_bytes_written_ + amt_to_write < element->size()) {
+      // Only the first kMaxIOVecs segments of the message were sent.
+      message_send_bytes_written_ += amt_to_write;
     } else {
       message_send_bytes_written_ = 0;
 
       // Message sent OK!
       if (msg) {
+        if (msg->routing_id() == MSG_ROUTING_NONE &&
+            msg->type() == SHARED_MEMORY_RING_MESSAGE_TYPE) {
+          output_ring_offered_ = true;
+        }
         DVLOG(2) << "sent message @" << msg << " on channel @" << this
                  << " with type " << msg->type() << " on fd " << pipe_.get();
       } else {
@@ -547,6 +639,22 @@ base::ScopedFD ChannelPosix::TakeClientFileDescriptor() {
   return client_pipe_.Pass();
 }
 
+bool ChannelPosix::EnableSharedMemoryRing(size_t capacity) {
+#if defined(OS_LINUX)
+  DCHECK(!output_ring_);
+  if (!internal::SharedMemoryRing::IsValidCapacity(capacity))
+    return false;
+  ring_capacity_ = capacity;
+  return true;
+#else
+  return false;
+#endif  // OS_LINUX
+}
+
+bool ChannelPosix::IsSendingThroughSharedMemoryRing() const {
+  return output_ring_offered_ && peer_wakeup_fd_.is_valid();
+}
+
 void ChannelPosix::CloseClientFileDescriptor() {
   base::AutoLock lock(client_pipe_lock_);
   if (!client_pipe_.is_valid())
@@ -588,6 +696,18 @@ void ChannelPosix::ResetToAcceptingConnectionState() {
   // Close any outstanding, received file descriptors.
   ClearInputFDs();
 
+  // Tear down the shared memory rings, which are set up again on the next
+  // connection. |ring_input_buf_| may be in use by a dispatch that closed the
+  // channel, so it is only cleared when a new input ring is opened.
+  wakeup_watcher_.StopWatchingFileDescriptor();
+  output_ring_.reset();
+  input_ring_.reset();
+  wakeup_fd_.reset();
+  peer_wakeup_fd_.reset();
+  output_ring_offered_ = false;
+  is_writing_to_ring_ = false;
+  is_blocked_on_ring_ = false;
+
 #if defined(OS_MACOSX)
   // Clear any outstanding, sent file descriptors.
   for (std::set<int>::iterator i = fds_to_close_.begin();
@@ -669,6 +789,23 @@ void ChannelPosix::OnFileCanReadWithoutBlocking(int fd) {
       ClosePipeOnError();
       return;
     }
+    // The peer may have offered its ring, which has to be read once for the
+    // peer to wake this end up when it writes to it.
+    if (input_ring_ && !ProcessInputRing()) {
+      ClosePipeOnError();
+      return;
+    }
+  } else if (fd == wakeup_fd_.get()) {
+    uint64_t value;
+    if (HANDLE_EINTR(read(wakeup_fd_.get(), &value, sizeof(value))) < 0 &&
+        errno != EAGAIN) {
+      DPLOG(ERROR) << "read";
+    }
+    is_blocked_on_ring_ = false;
+    if (input_ring_ && !ProcessInputRing()) {
+      ClosePipeOnError();
+      return;
+    }
   } else {
     NOTREACHED() << "Unknown pipe " << fd;
   }
@@ -766,6 +903,8 @@ bool ChannelPosix::AcceptConnection() {
       &read_watcher_,
       this);
   QueueHelloMessage();
+  if (ring_capacity_)
+    CreateOutputRing(ring_capacity_);
 
   if (mode_ & MODE_CLIENT_FLAG) {
     // If we are a client we want to send a hello message out immediately.
@@ -989,6 +1128,174 @@ void ChannelPosix::QueueCloseFDMessage(int fd, int hops) {
   }
 }
 
+void ChannelPosix::CreateOutputRing(size_t capacity) {
+#if defined(OS_LINUX)
+  DCHECK(!output_ring_);
+  output_ring_ = internal::SharedMemoryRing::Create(capacity);
+  wakeup_fd_.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+  if (!output_ring_ || !wakeup_fd_.is_valid()) {
+    DLOG(WARNING) << "Unable to create a shared memory ring";
+    output_ring_.reset();
+    wakeup_fd_.reset();
+    return;
+  }
+  base::MessageLoopForIO::current()->WatchFileDescriptor(
+      wakeup_fd_.get(),
+      true,
+      base::MessageLoopForIO::WATCH_READ,
+      &wakeup_watcher_,
+      this);
+
+  // The ring and the eventfd stay open until the channel is reset, after the
+  // message is sent.
+  scoped_ptr<Message> msg(new Message(MSG_ROUTING_NONE,
+                                      SHARED_MEMORY_RING_MESSAGE_TYPE,
+                                      IPC::Message::PRIORITY_NORMAL));
+  msg->WriteUInt32(static_cast<uint32_t>(capacity));
+  WriteParam(msg.get(), base::FileDescriptor(output_ring_->handle().fd, false));
+  WriteParam(msg.get(), base::FileDescriptor(wakeup_fd_.get(), false));
+  output_queue_.push(new OutputElement(msg.release()));
+#endif  // OS_LINUX
+}
+
+bool ChannelPosix::OpenInputRing(const Message& msg) {
+  base::PickleIterator iter(msg);
+  uint32_t capacity = 0;
+  base::FileDescriptor ring_fd;
+  base::FileDescriptor wakeup_fd;
+  const bool valid = iter.ReadUInt32(&capacity) &&
+                     ReadParam(&msg, &iter, &ring_fd) &&
+                     ReadParam(&msg, &iter, &wakeup_fd);
+  base::ScopedFD scoped_ring_fd(ring_fd.fd);
+  base::ScopedFD scoped_wakeup_fd(wakeup_fd.fd);
+#if defined(OS_LINUX)
+  if (!valid || !scoped_ring_fd.is_valid() || !scoped_wakeup_fd.is_valid() ||
+      input_ring_) {
+    return false;
+  }
+
+  // The eventfd is written to from the IO thread, which must not block on
+  // it.
+  if (fcntl(scoped_wakeup_fd.get(), F_SETFL, O_NONBLOCK) == -1)
+    return false;
+  input_ring_ = internal::SharedMemoryRing::Open(
+      base::SharedMemoryHandle(scoped_ring_fd.release(), true), capacity);
+  if (!input_ring_)
+    return false;
+  peer_wakeup_fd_ = scoped_wakeup_fd.Pass();
+  ring_input_buf_.clear();
+
+  // Accept the offer of the peer with a ring of the same capacity.
+  if (!ring_capacity_ && !output_ring_)
+    CreateOutputRing(capacity);
+  return true;
+#else
+  // The offer is declined by never offering a ring in return, so that the
+  // peer keeps sending messages through the socket.
+  return valid;
+#endif  // OS_LINUX
+}
+
+bool ChannelPosix::CanSendThroughRing(OutputElement* element) const {
+  // A message is sent whole through the ring or the socket.
+  if (message_send_bytes_written_ != 0)
+    return is_writing_to_ring_;
+  const Message* msg = element->get_message();
+  return IsSendingThroughSharedMemoryRing() && msg && !msg->HasAttachments();
+}
+
+bool ChannelPosix::WriteToOutputRing(OutputElement* element) {
+  const Message* msg = element->get_message();
+  std::vector<base::StringPiece> segments;
+  if (msg->has_external_data()) {
+    msg->GetSegments(&segments);
+  } else {
+    segments.push_back(base::StringPiece(
+        static_cast<const char*>(msg->data()), msg->size()));
+  }
+
+  is_writing_to_ring_ = true;
+  size_t offset = message_send_bytes_written_;
+  for (const base::StringPiece& segment : segments) {
+    if (offset >= segment.size()) {
+      offset -= segment.size();
+      continue;
+    }
+    const char* data = segment.data() + offset;
+    size_t size = segment.size() - offset;
+    offset = 0;
+    while (size) {
+      int bytes_written = output_ring_->Write(data, size);
+      if (bytes_written == 0) {
+        // The ring is full: let the peer read what was written, and wait for
+        // it to make room.
+        if (output_ring_->TakeReaderWaiting())
+          WakeUpPeer();
+        output_ring_->WaitForReader();
+        bytes_written = output_ring_->Write(data, size);
+        if (bytes_written == 0) {
+          is_blocked_on_ring_ = true;
+          return true;
+        }
+      }
+      if (bytes_written < 0) {
+        LOG(ERROR) << "Shared memory ring corrupted by the peer";
+        return false;
+      }
+      data += bytes_written;
+      size -= bytes_written;
+      message_send_bytes_written_ += bytes_written;
+    }
+  }
+
+  DVLOG(2) << "sent message @" << msg << " on channel @" << this
+           << " with type " << msg->type() << " through the ring";
+  message_send_bytes_written_ = 0;
+  is_writing_to_ring_ = false;
+  if (output_ring_->TakeReaderWaiting())
+    WakeUpPeer();
+  return true;
+}
+
+bool ChannelPosix::ProcessInputRing() {
+  // The ring is gone if a dispatched message closed the channel.
+  while (input_ring_) {
+    size_t size = 0;
+    if (!input_ring_->GetReadableSize(&size))
+      return false;
+    if (size == 0) {
+      input_ring_->WaitForWriter();
+      if (!input_ring_->GetReadableSize(&size))
+        return false;
+      if (size == 0)
+        return true;
+    }
+
+    // The peer sent the messages that are on the socket before it wrote the
+    // |size| bytes to the ring, so they are dispatched first.
+    if (ProcessIncomingMessages() == DISPATCH_ERROR)
+      return false;
+    if (!input_ring_)
+      return true;
+
+    input_ring_->Read(size, &ring_input_buf_);
+    if (input_ring_->TakeWriterWaiting())
+      WakeUpPeer();
+    if (ProcessBufferedMessages(&ring_input_buf_) == DISPATCH_ERROR)
+      return false;
+  }
+  return true;
+}
+
+void ChannelPosix::WakeUpPeer() {
+  const uint64_t value = 1;
+  // EAGAIN means that the counter is full, so the peer is woken up anyway.
+  if (HANDLE_EINTR(write(peer_wakeup_fd_.get(), &value, sizeof(value))) < 0 &&
+      errno != EAGAIN) {
+    DPLOG(ERROR) << "write";
+  }
+}
+
 void ChannelPosix::HandleInternalMessage(const Message& msg) {
   // The Hello message contains only the process id.
   base::PickleIterator iter(msg);
@@ -1010,6 +1317,14 @@ void ChannelPosix::HandleInternalMessage(const Message& msg) {
         ClosePipeOnError();
       break;
 
+    case Channel::SHARED_MEMORY_RING_MESSAGE_TYPE:
+      if (!OpenInputRing(msg)) {
+        LOG(WARNING) << "Invalid shared memory ring offered on channel @"
+                     << this;
+        ClosePipeOnError();
+      }
+      break;
+
 #if defined(OS_MACOSX)
     case Channel::CLOSE_FD_MESSAGE_TYPE:
       int fd, hops;
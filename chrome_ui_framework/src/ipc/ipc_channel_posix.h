@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "base/files/scoped_file.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/message_loop/message_loop.h"
 #include "base/process/process.h"
 #include "ipc/ipc_channel_reader.h"
@@ -22,6 +23,10 @@
 
 namespace IPC {
 
+namespace internal {
+class SharedMemoryRing;
+}
+
 class IPC_EXPORT ChannelPosix : public Channel,
                                 public internal::ChannelReader,
                                 public base::MessageLoopForIO::Watcher {
@@ -59,6 +64,16 @@ class IPC_EXPORT ChannelPosix : public Channel,
 
   void CloseClientFileDescriptor();
 
+  // Offers the peer to send the messages of both directions through shared
+  // memory rings of |capacity| bytes, a power of two, instead of the socket.
+  // The socket is still used for messages with attachments, and for messages
+  // sent before the rings are set up. Must be called before Connect(). Returns
+  // false if shared memory rings aren't supported.
+  bool EnableSharedMemoryRing(size_t capacity);
+
+  // Returns true once messages are sent through a shared memory ring.
+  bool IsSendingThroughSharedMemoryRing() const;
+
   static bool IsNamedServerInitialized(const std::string& channel_id);
 #if defined(OS_LINUX)
   static void SetGlobalPid(int pid);
@@ -83,6 +98,30 @@ class IPC_EXPORT ChannelPosix : public Channel,
   void CloseFileDescriptors(Message* msg);
   void QueueCloseFDMessage(int fd, int hops);
 
+  // Creates the ring of |capacity| bytes that messages are sent through, and
+  // queues the message that offers it to the peer. On failure, messages keep
+  // being sent through the socket.
+  void CreateOutputRing(size_t capacity);
+
+  // Maps the ring that the peer sends messages through, from |msg|. Returns
+  // false on failure.
+  bool OpenInputRing(const Message& msg);
+
+  // Returns true if |element| can be sent through the output ring, now that
+  // |message_send_bytes_written_| bytes of it were sent.
+  bool CanSendThroughRing(OutputElement* element) const;
+
+  // Writes the bytes of |element| that remain to be sent to the output ring.
+  // Returns false on error. Sets |is_blocked_on_ring_| if the ring is full.
+  bool WriteToOutputRing(OutputElement* element);
+
+  // Dispatches the messages in the input ring, after the ones sent through
+  // the socket before them. Returns false on error.
+  bool ProcessInputRing();
+
+  // Wakes up the peer, which waits on the ring of one of the directions.
+  void WakeUpPeer();
+
   // ChannelReader implementation.
   ReadState ReadData(char* buffer, int buffer_len, int* bytes_read) override;
   bool ShouldDispatchInputMessage(Message* msg) override;
@@ -167,6 +206,34 @@ class IPC_EXPORT ChannelPosix : public Channel,
   // Messages to be sent are queued here.
   std::queue<OutputElement*> output_queue_;
 
+  // The capacity of the ring that this end offers to its peer on connection,
+  // or 0 if it only sets up a ring when the peer offers one.
+  size_t ring_capacity_;
+
+  // The ring that messages are sent through, and the one that the peer sends
+  // messages through. The messages of a direction go through its ring once
+  // both ends offered their ring.
+  scoped_ptr<internal::SharedMemoryRing> output_ring_;
+  scoped_ptr<internal::SharedMemoryRing> input_ring_;
+
+  // Whether the message that offers |output_ring_| was sent.
+  bool output_ring_offered_;
+
+  // Whether the element at the front of |output_queue_| is being written to
+  // |output_ring_|, and whether it waits for room in the ring, or for the
+  // ring to be drained before a message is sent on the socket.
+  bool is_writing_to_ring_;
+  bool is_blocked_on_ring_;
+
+  // The eventfd that wakes this end up when the peer wrote to |input_ring_|
+  // or read from |output_ring_|, and the eventfd of the peer.
+  base::ScopedFD wakeup_fd_;
+  base::ScopedFD peer_wakeup_fd_;
+  base::MessageLoopForIO::FileDescriptorWatcher wakeup_watcher_;
+
+  // The bytes read from |input_ring_| that aren't dispatched yet.
+  std::string ring_input_buf_;
+
   // We assume a worst case: kReadBufferSize bytes of messages, where each
   // message has no payload and a full complement of descriptors.
   static const size_t kMaxReadFDs =
@@ -12,10 +12,14 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <string>
+
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
 #include "base/location.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/path_service.h"
 #include "base/posix/eintr_wrapper.h"
 #include "base/process/process.h"
@@ -23,6 +27,8 @@
 #include "base/test/multiprocess_test.h"
 #include "base/test/test_timeouts.h"
 #include "ipc/ipc_listener.h"
+#include "ipc/ipc_message_utils.h"
+#include "ipc/ipc_shared_memory_ring.h"
 #include "ipc/unix_domain_socket_util.h"
 #include "testing/multiprocess_func_list.h"
 
@@ -101,6 +107,37 @@ class IPCChannelPosixTestListener : public IPC::Listener {
   bool quit_only_on_message_;
 };
 
+// Keeps the messages it receives, and quits the run loop once it received
+// the number of messages that it expects.
+class IPCChannelPosixRingTestListener : public IPC::Listener {
+ public:
+  IPCChannelPosixRingTestListener() : expected_count_(0) {}
+  ~IPCChannelPosixRingTestListener() override {}
+
+  void Expect(size_t count) {
+    messages_.clear();
+    expected_count_ = count;
+  }
+
+  const ScopedVector<IPC::Message>& messages() const { return messages_; }
+
+  bool OnMessageReceived(const IPC::Message& message) override {
+    messages_.push_back(new IPC::Message(message));
+    if (messages_.size() == expected_count_)
+      base::MessageLoopForIO::current()->QuitNow();
+    return true;
+  }
+
+  void OnChannelError() override {
+    ADD_FAILURE() << "Unexpected channel error";
+    base::MessageLoopForIO::current()->QuitNow();
+  }
+
+ private:
+  ScopedVector<IPC::Message> messages_;
+  size_t expected_count_;
+};
+
 class IPCChannelPosixTest : public base::MultiProcessTest {
  public:
   static void SetUpSocket(IPC::ChannelHandle *handle,
@@ -463,6 +500,95 @@ TEST_F(IPCChannelPosixTest, IsNamedServerInitialized) {
   unlink(chan_handle.name.c_str());
 }
 
+#if defined(OS_LINUX)
+const uint32_t kRingMessage = 48;
+const size_t kRingCapacity = IPC::internal::SharedMemoryRing::kMinCapacity;
+
+// Sends messages of many sizes, some larger than the ring and some with a
+// file descriptor, and checks that they are received in order.
+void SendRingMessages(IPC::ChannelPosix* sender,
+                      IPCChannelPosixRingTestListener* receiver) {
+  const int kMessageCount = 100;
+  receiver->Expect(kMessageCount);
+  for (int i = 0; i < kMessageCount; ++i) {
+    IPC::Message* message = new IPC::Message(0, kRingMessage,
+                                             IPC::Message::PRIORITY_NORMAL);
+    message->WriteInt(i);
+    message->WriteString(
+        std::string((i * 997) % (3 * kRingCapacity), 'a' + i % 26));
+    if (i % 7 == 0) {
+      int fds[2];
+      ASSERT_EQ(0, pipe(fds));
+      ASSERT_EQ(static_cast<ssize_t>(sizeof(i)),
+                HANDLE_EINTR(write(fds[1], &i, sizeof(i))));
+      ASSERT_EQ(0, IGNORE_EINTR(close(fds[1])));
+      IPC::WriteParam(message, base::FileDescriptor(fds[0], true));
+    }
+    ASSERT_TRUE(sender->Send(message));
+  }
+  IPCChannelPosixTest::SpinRunLoop(TestTimeouts::action_max_timeout());
+
+  ASSERT_EQ(static_cast<size_t>(kMessageCount), receiver->messages().size());
+  for (int i = 0; i < kMessageCount; ++i) {
+    const IPC::Message& message = *receiver->messages()[i];
+    base::PickleIterator iter(message);
+    int index;
+    std::string data;
+    ASSERT_TRUE(iter.ReadInt(&index));
+    EXPECT_EQ(i, index);
+    ASSERT_TRUE(iter.ReadString(&data));
+    EXPECT_EQ(std::string((i * 997) % (3 * kRingCapacity), 'a' + i % 26),
+              data);
+    if (i % 7 == 0) {
+      base::FileDescriptor descriptor;
+      ASSERT_TRUE(IPC::ReadParam(&message, &iter, &descriptor));
+      base::ScopedFD fd(descriptor.fd);
+      int value = -1;
+      ASSERT_EQ(static_cast<ssize_t>(sizeof(value)),
+                HANDLE_EINTR(read(fd.get(), &value, sizeof(value))));
+      EXPECT_EQ(i, value);
+    }
+  }
+}
+
+TEST_F(IPCChannelPosixTest, SharedMemoryRing) {
+  IPCChannelPosixRingTestListener in_listener;
+  IPCChannelPosixRingTestListener out_listener;
+  IPC::ChannelHandle in_handle("IN");
+  scoped_ptr<IPC::ChannelPosix> in_chan(new IPC::ChannelPosix(
+      in_handle, IPC::Channel::MODE_SERVER, &in_listener));
+  ASSERT_FALSE(in_chan->EnableSharedMemoryRing(kRingCapacity + 1));
+  ASSERT_TRUE(in_chan->EnableSharedMemoryRing(kRingCapacity));
+  IPC::ChannelHandle out_handle(
+      "OUT", base::FileDescriptor(in_chan->TakeClientFileDescriptor()));
+  scoped_ptr<IPC::ChannelPosix> out_chan(new IPC::ChannelPosix(
+      out_handle, IPC::Channel::MODE_CLIENT, &out_listener));
+  ASSERT_TRUE(in_chan->Connect());
+  ASSERT_TRUE(out_chan->Connect());
+  EXPECT_FALSE(in_chan->IsSendingThroughSharedMemoryRing());
+  EXPECT_FALSE(out_chan->IsSendingThroughSharedMemoryRing());
+
+  // The client accepts the ring offered by the server, and each end sends
+  // through its ring once it has the ring of the other end. A round trip is
+  // enough for both ends to get there.
+  out_listener.Expect(1);
+  ASSERT_TRUE(in_chan->Send(new IPC::Message(
+      0, kRingMessage, IPC::Message::PRIORITY_NORMAL)));
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+  ASSERT_EQ(1u, out_listener.messages().size());
+  in_listener.Expect(1);
+  ASSERT_TRUE(out_chan->Send(new IPC::Message(
+      0, kRingMessage, IPC::Message::PRIORITY_NORMAL)));
+  SpinRunLoop(TestTimeouts::action_max_timeout());
+  ASSERT_EQ(1u, in_listener.messages().size());
+  EXPECT_TRUE(in_chan->IsSendingThroughSharedMemoryRing());
+  EXPECT_TRUE(out_chan->IsSendingThroughSharedMemoryRing());
+
+  SendRingMessages(out_chan.get(), &in_listener);
+  SendRingMessages(in_chan.get(), &out_listener);
+}
+#endif  // defined(OS_LINUX)
+
 // A long running process that connects to us
 MULTIPROCESS_TEST_MAIN(IPCChannelPosixTestConnectionProc) {
   base::MessageLoopForIO message_loop;
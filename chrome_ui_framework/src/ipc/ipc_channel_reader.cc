@@ -53,7 +53,7 @@ ChannelReader::DispatchState ChannelReader::AsyncReadComplete(int bytes_read) {
 
 bool ChannelReader::IsInternalMessage(const Message& m) {
   return m.routing_id() == MSG_ROUTING_NONE &&
-      m.type() >= Channel::CLOSE_FD_MESSAGE_TYPE &&
+      m.type() >= Channel::SHARED_MEMORY_RING_MESSAGE_TYPE &&
       m.type() <= Channel::HELLO_MESSAGE_TYPE;
 }
 
@@ -95,38 +95,8 @@ bool ChannelReader::TranslateInputData(const char* input_data,
     if (info.message_found) {
       int pickle_len = static_cast<int>(info.pickle_end - p);
       Message translated_message(p, pickle_len);
-
-      UMA_HISTOGRAM_MEMORY_KB(
-          "Memory.IPCChannelReader.ReceivedMessageSize",
-          static_cast<base::HistogramBase::Sample>(translated_message.size()));
-
-      for (const auto& id : info.attachment_ids)
-        translated_message.AddPlaceholderBrokerableAttachmentWithId(id);
-
-      if (!GetNonBrokeredAttachments(&translated_message))
+      if (!HandleTranslatedMessage(&translated_message, info))
         return false;
-
-      // If there are no queued messages, attempt to immediately dispatch the
-      // newly translated message.
-      if (queued_messages_.empty()) {
-        DCHECK(blocked_ids_.empty());
-        AttachmentIdSet blocked_ids =
-            GetBrokeredAttachments(&translated_message);
-
-        if (blocked_ids.empty()) {
-          // Dispatch the message and continue the loop.
-          DispatchMessage(&translated_message);
-          p = info.message_end;
-          continue;
-        }
-
-        blocked_ids_.swap(blocked_ids);
-        StartObservingAttachmentBroker();
-      }
-
-      // Make a deep copy of |translated_message| to add to the queue.
-      scoped_ptr<Message> m(new Message(translated_message));
-      queued_messages_.push_back(m.release());
       p = info.message_end;
     } else {
       // Last message is partial.
@@ -156,6 +126,69 @@ bool ChannelReader::TranslateInputData(const char* input_data,
   return true;
 }
 
+bool ChannelReader::HandleTranslatedMessage(
+    Message* translated_message,
+    const Message::NextMessageInfo& info) {
+  UMA_HISTOGRAM_MEMORY_KB(
+      "Memory.IPCChannelReader.ReceivedMessageSize",
+      static_cast<base::HistogramBase::Sample>(translated_message->size()));
+
+  for (const auto& id : info.attachment_ids)
+    translated_message->AddPlaceholderBrokerableAttachmentWithId(id);
+
+  if (!GetNonBrokeredAttachments(translated_message))
+    return false;
+
+  // If there are no queued messages, attempt to immediately dispatch the
+  // newly translated message.
+  if (queued_messages_.empty()) {
+    DCHECK(blocked_ids_.empty());
+    AttachmentIdSet blocked_ids = GetBrokeredAttachments(translated_message);
+
+    if (blocked_ids.empty()) {
+      DispatchMessage(translated_message);
+      return true;
+    }
+
+    blocked_ids_.swap(blocked_ids);
+    StartObservingAttachmentBroker();
+  }
+
+  // Make a deep copy of |translated_message| to add to the queue.
+  scoped_ptr<Message> m(new Message(*translated_message));
+  queued_messages_.push_back(m.release());
+  return true;
+}
+
+ChannelReader::DispatchState ChannelReader::ProcessBufferedMessages(
+    std::string* buffer) {
+  const char* p = buffer->data();
+  const char* end = p + buffer->size();
+  size_t next_message_size = 0;
+  while (p < end) {
+    Message::NextMessageInfo info;
+    Message::FindNext(p, end, &info);
+    if (!info.message_found) {
+      next_message_size = info.message_size;
+      if (!CheckMessageSize(next_message_size))
+        return DISPATCH_ERROR;
+      break;
+    }
+
+    Message translated_message(p, static_cast<int>(info.pickle_end - p));
+    if (!HandleTranslatedMessage(&translated_message, info))
+      return DISPATCH_ERROR;
+    p = info.message_end;
+  }
+  buffer->erase(0, p - buffer->data());
+
+  // Make room for the rest of the partial message at once.
+  if (next_message_size > buffer->capacity())
+    buffer->reserve(next_message_size);
+
+  return DispatchMessages();
+}
+
 ChannelReader::DispatchState ChannelReader::DispatchMessages() {
   while (!queued_messages_.empty()) {
     if (!blocked_ids_.empty())
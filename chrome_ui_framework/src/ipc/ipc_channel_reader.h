@@ -6,6 +6,7 @@
 #define IPC_IPC_CHANNEL_READER_H_
 
 #include <set>
+#include <string>
 
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
@@ -112,6 +113,12 @@ class IPC_EXPORT ChannelReader : public SupportsAttachmentBrokering,
   // Handles internal messages, like the hello message sent on channel startup.
   virtual void HandleInternalMessage(const Message& msg) = 0;
 
+  // Translates the messages at the start of |buffer|, data of a stream other
+  // than the one read by ReadData(), dispatches them like the messages read by
+  // ReadData(), and erases them from |buffer|. A partial message is left in
+  // |buffer| for the next call to complete.
+  DispatchState ProcessBufferedMessages(std::string* buffer);
+
   // Exposed for testing purposes only.
   ScopedVector<Message>* get_queued_messages() { return &queued_messages_; }
 
@@ -140,6 +147,12 @@ class IPC_EXPORT ChannelReader : public SupportsAttachmentBrokering,
   // queue.
   bool TranslateInputData(const char* input_data, int input_data_len);
 
+  // Dispatches |translated_message|, found by Message::FindNext() with |info|,
+  // or queues it if it's blocked on the broker. Returns false on a channel
+  // error.
+  bool HandleTranslatedMessage(Message* translated_message,
+                               const Message::NextMessageInfo& info);
+
   // Dispatches messages from queued_messages_ to listeners. Successfully
   // dispatched messages are removed from queued_messages_.
   DispatchState DispatchMessages();
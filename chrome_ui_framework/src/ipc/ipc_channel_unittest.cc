@@ -10,6 +10,7 @@
 
 #include <string>
 
+#include "base/memory/ref_counted_memory.h"
 #include "base/pickle.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
@@ -161,6 +162,115 @@ TEST_F(IPCChannelTest, MAYBE_SendMessageInChannelConnected) {
   DestroyChannel();
 }
 
+// The number of blobs of the messages of ExternalDataTest, which is more than
+// are sent by one sendmsg() call on POSIX.
+const int kExternalBlobCount = 100;
+
+// Returns the |i|th blob of the messages of ExternalDataTest, of an odd size
+// so that its padding is sent too.
+std::string GetExternalBlob(int i) {
+  return std::string(1000 * i + 1, static_cast<char>('a' + i % 26));
+}
+
+// Checks that the message reflected by ReflectorClient has the blobs, and
+// quits.
+class ExternalDataListener : public IPC::Listener {
+ public:
+  ExternalDataListener() : received_(false) {}
+  ~ExternalDataListener() override {}
+
+  bool OnMessageReceived(const IPC::Message& message) override {
+    base::PickleIterator iter(message);
+    int count;
+    EXPECT_TRUE(iter.ReadInt(&count));
+    EXPECT_EQ(kExternalBlobCount, count);
+    for (int i = 0; i < count; ++i) {
+      std::string blob;
+      EXPECT_TRUE(iter.ReadString(&blob));
+      EXPECT_EQ(GetExternalBlob(i), blob);
+    }
+    std::string end;
+    EXPECT_TRUE(iter.ReadString(&end));
+    EXPECT_EQ("end", end);
+    received_ = true;
+    base::MessageLoop::current()->QuitWhenIdle();
+    return true;
+  }
+
+  void OnChannelError() override {
+    base::MessageLoop::current()->QuitWhenIdle();
+  }
+
+  bool received() const { return received_; }
+
+ private:
+  bool received_;
+};
+
+// The blobs of a message written with WriteDataExternal() are sent as if they
+// were copied into it.
+TEST_F(IPCChannelTest, ExternalDataTest) {
+  Init("ReflectorClient");
+
+  ExternalDataListener listener;
+  CreateChannel(&listener);
+  ASSERT_TRUE(ConnectChannel());
+  ASSERT_TRUE(StartClient());
+
+  IPC::Message* message =
+      new IPC::Message(0, 2, IPC::Message::PRIORITY_NORMAL);
+  message->WriteInt(kExternalBlobCount);
+  for (int i = 0; i < kExternalBlobCount; ++i) {
+    std::string blob = GetExternalBlob(i);
+    EXPECT_TRUE(
+        message->WriteDataExternal(base::RefCountedString::TakeString(&blob)));
+  }
+  message->WriteString("end");
+  EXPECT_TRUE(message->has_external_data());
+  sender()->Send(message);
+
+  base::MessageLoop::current()->Run();
+  EXPECT_TRUE(listener.received());
+
+  channel()->Close();
+  EXPECT_TRUE(WaitForClientShutdown());
+  DestroyChannel();
+}
+
+// Sends back a copy of each message it receives.
+class ReflectorListener : public IPC::Listener {
+ public:
+  ReflectorListener() : sender_(NULL) {}
+  ~ReflectorListener() override {}
+
+  void Init(IPC::Sender* sender) { sender_ = sender; }
+
+  bool OnMessageReceived(const IPC::Message& message) override {
+    sender_->Send(new IPC::Message(message));
+    return true;
+  }
+
+  void OnChannelError() override {
+    base::MessageLoop::current()->QuitWhenIdle();
+  }
+
+ private:
+  IPC::Sender* sender_;
+};
+
+MULTIPROCESS_IPC_TEST_CLIENT_MAIN(ReflectorClient) {
+  base::MessageLoopForIO main_message_loop;
+  ReflectorListener listener;
+
+  scoped_ptr<IPC::Channel> channel(IPC::Channel::CreateClient(
+      IPCTestBase::GetChannelName("ReflectorClient"), &listener));
+  listener.Init(channel.get());
+  CHECK(channel->Connect());
+
+  base::MessageLoop::current()->Run();
+  return 0;
+}
+
 MULTIPROCESS_IPC_TEST_CLIENT_MAIN(GenericClient) {
   base::MessageLoopForIO main_message_loop;
   IPC::TestChannelListener listener;
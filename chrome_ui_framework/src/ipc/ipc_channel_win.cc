@@ -127,6 +127,9 @@ bool ChannelWin::ProcessMessageForDelivery(Message* message) {
                          message->flags(),
                          TRACE_EVENT_FLAG_FLOW_OUT);
 
+  // The pipe is written from data(), which must hold the whole message.
+  message->Flatten();
+
   // |output_queue_| takes ownership of |message|.
   OutputElement* element = new OutputElement(message);
   output_queue_.push(element);
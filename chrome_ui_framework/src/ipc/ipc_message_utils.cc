@@ -928,6 +928,14 @@ void ParamTraits<Message>::Write(Message* m, const Message& p) {
   // better not be any.
   DCHECK(!p.HasAttachments());
 #endif
+  // The payload is written from the buffer of the nested message, so that
+  // has to hold all of it.
+  if (p.has_external_data()) {
+    Message flattened(p);
+    flattened.Flatten();
+    Write(m, flattened);
+    return;
+  }
 
   // Don't just write out the message. This is used to send messages between
   // NaCl (Posix environment) and the browser (could be on Windows). The message
@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted_memory.h"
 #include "ipc/ipc_message.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -55,6 +56,34 @@ TEST(IPCMessageUtilsTest, NestedMessages) {
                                       &result_content));
 }
 
+// Tests that a nested message with external data is written whole.
+TEST(IPCMessageUtilsTest, NestedMessageWithExternalData) {
+  scoped_refptr<base::RefCountedString> blob(new base::RefCountedString);
+  blob->data().assign(1000, 'a');
+  Message nested_msg(12, 34, Message::PRIORITY_NORMAL);
+  nested_msg.WriteDataExternal(blob);
+  nested_msg.WriteInt(567);
+  ASSERT_TRUE(nested_msg.has_external_data());
+
+  Message outer_msg(91, 88, Message::PRIORITY_NORMAL);
+  ParamTraits<Message>::Write(&outer_msg, nested_msg);
+  EXPECT_TRUE(nested_msg.has_external_data());
+
+  base::PickleIterator iter(outer_msg);
+  IPC::Message result_msg;
+  ASSERT_TRUE(ParamTraits<Message>::Read(&outer_msg, &iter, &result_msg));
+  EXPECT_EQ(nested_msg.size(), result_msg.size());
+
+  base::PickleIterator nested_iter(result_msg);
+  const char* data = NULL;
+  int data_length = 0;
+  ASSERT_TRUE(nested_iter.ReadData(&data, &data_length));
+  EXPECT_EQ(blob->data(), std::string(data, data_length));
+  int result_content = 0;
+  ASSERT_TRUE(nested_iter.ReadInt(&result_content));
+  EXPECT_EQ(567, result_content);
+}
+
 // Tests that detection of various bad parameters is working correctly.
 TEST(IPCMessageUtilsTest, ParameterValidation) {
   base::FilePath::StringType ok_string(FILE_PATH_LITERAL("hello"), 5);
@@ -9,6 +9,7 @@
 
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/pickle.h"
 #include "base/strings/stringprintf.h"
@@ -23,6 +24,10 @@
 #include "ipc/ipc_message_utils.h"
 #include "ipc/ipc_sender.h"
 
+#if defined(OS_LINUX)
+#include "ipc/ipc_channel_posix.h"
+#endif
+
 namespace IPC {
 namespace test {
 
@@ -156,12 +161,15 @@ class PerformanceChannelListener : public Listener {
   }
 
   // Call this before running the message loop.
-  void SetTestParams(int msg_count, size_t msg_size) {
+  void SetTestParams(const PingPongTestParams& params) {
     DCHECK_EQ(0, count_down_);
-    msg_count_ = msg_count;
-    msg_size_ = msg_size;
+    msg_count_ = params.message_count();
+    msg_size_ = params.message_size();
     count_down_ = msg_count_;
     payload_ = std::string(msg_size_, 'a');
+    external_payload_ = NULL;
+    if (params.external_data())
+      external_payload_ = base::RefCountedString::TakeString(&payload_);
   }
 
   bool OnMessageReceived(const Message& message) override {
@@ -183,13 +191,14 @@ class PerformanceChannelListener : public Listener {
       latency_tracker_.Reset();
       DCHECK(!perf_logger_.get());
       std::string test_name =
-          base::StringPrintf("IPC_%s_Perf_%dx_%u",
+          base::StringPrintf("IPC_%s%s_Perf_%dx_%u",
                              label_.c_str(),
+                             external_payload_ ? "_ExternalData" : "",
                              msg_count_,
                              static_cast<unsigned>(msg_size_));
       perf_logger_.reset(new base::PerfTimeLogger(test_name.c_str()));
     } else {
-      DCHECK_EQ(payload_.size(), reflected_payload.size());
+      DCHECK_EQ(msg_size_, reflected_payload.size());
 
       latency_tracker_.AddEvent(
           base::TimeTicks::FromInternalValue(time_internal), now);
@@ -207,7 +216,10 @@ class PerformanceChannelListener : public Listener {
     Message* msg = new Message(0, 2, Message::PRIORITY_NORMAL);
     msg->WriteInt64(base::TimeTicks::Now().ToInternalValue());
     msg->WriteInt(count_down_);
-    msg->WriteString(payload_);
+    if (external_payload_)
+      msg->WriteDataExternal(external_payload_);
+    else
+      msg->WriteString(payload_);
     sender_->Send(msg);
     return true;
   }
@@ -220,6 +232,8 @@ class PerformanceChannelListener : public Listener {
 
   int count_down_;
   std::string payload_;
+  // The payload, when it is sent as external data.
+  scoped_refptr<base::RefCountedString> external_payload_;
   EventTimeTracker latency_tracker_;
   scoped_ptr<base::PerfTimeLogger> perf_logger_;
 };
@@ -237,21 +251,54 @@ IPCChannelPerfTestBase::GetDefaultTestParams() {
   return list;
 }
 
+std::vector<PingPongTestParams>
+IPCChannelPerfTestBase::GetLargeMessageTestParams(bool external_data) {
+  std::vector<PingPongTestParams> list;
+  list.push_back(PingPongTestParams(1 << 10, 20000, external_data));
+  list.push_back(PingPongTestParams(16 << 10, 10000, external_data));
+  list.push_back(PingPongTestParams(256 << 10, 1000, external_data));
+  list.push_back(PingPongTestParams(1 << 20, 250, external_data));
+  list.push_back(PingPongTestParams(4 << 20, 60, external_data));
+  list.push_back(PingPongTestParams(16 << 20, 15, external_data));
+  return list;
+}
+
 void IPCChannelPerfTestBase::RunTestChannelPingPong(
     const std::vector<PingPongTestParams>& params) {
+  RunChannelPingPong(params, "Channel", 0);
+}
+
+#if defined(OS_LINUX)
+void IPCChannelPerfTestBase::RunTestChannelSharedMemoryRingPingPong(
+    const std::vector<PingPongTestParams>& params,
+    size_t ring_capacity) {
+  RunChannelPingPong(params, "ChannelSharedMemoryRing", ring_capacity);
+}
+#endif
+
+void IPCChannelPerfTestBase::RunChannelPingPong(
+    const std::vector<PingPongTestParams>& params,
+    const std::string& label,
+    size_t ring_capacity) {
   Init("PerformanceClient");
 
   // Set up IPC channel and start client.
-  PerformanceChannelListener listener("Channel");
+  PerformanceChannelListener listener(label);
   CreateChannel(&listener);
   listener.Init(channel());
+#if defined(OS_LINUX)
+  // The client accepts the ring that the server offers, and offers its own.
+  if (ring_capacity) {
+    ASSERT_TRUE(static_cast<ChannelPosix*>(channel())
+                    ->EnableSharedMemoryRing(ring_capacity));
+  }
+#endif
   ASSERT_TRUE(ConnectChannel());
   ASSERT_TRUE(StartClient());
 
   LockThreadAffinity thread_locker(kSharedCore);
   for (size_t i = 0; i < params.size(); i++) {
-    listener.SetTestParams(params[i].message_count(),
-                           params[i].message_size());
+    listener.SetTestParams(params[i]);
 
     // This initial message will kick-start the ping-pong of messages.
     Message* message =
@@ -291,8 +338,7 @@ void IPCChannelPerfTestBase::RunTestChannelProxyPingPong(
 
   LockThreadAffinity thread_locker(kSharedCore);
   for (size_t i = 0; i < params.size(); i++) {
-    listener.SetTestParams(params[i].message_count(),
-                           params[i].message_size());
+    listener.SetTestParams(params[i]);
 
     // This initial message will kick-start the ping-pong of messages.
     Message* message =
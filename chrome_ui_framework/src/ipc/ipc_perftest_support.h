@@ -5,6 +5,7 @@
 #ifndef IPC_IPC_PERFTEST_SUPPORT_H_
 #define IPC_IPC_PERFTEST_SUPPORT_H_
 
+#include <string>
 #include <vector>
 
 #include "ipc/ipc_test_base.h"
@@ -17,25 +18,54 @@ class ChannelReflectorListener;
 class PingPongTestParams {
  public:
   PingPongTestParams(size_t size, int count)
-      : message_size_(size), message_count_(count) {
+      : message_size_(size), message_count_(count), external_data_(false) {
+  }
+
+  // With |external_data|, the payload of the messages that the test sends is
+  // written with Pickle::WriteDataExternal() rather than copied.
+  PingPongTestParams(size_t size, int count, bool external_data)
+      : message_size_(size),
+        message_count_(count),
+        external_data_(external_data) {
   }
 
   size_t message_size() const { return message_size_; }
   int message_count() const { return message_count_; }
+  bool external_data() const { return external_data_; }
 
  private:
   size_t message_size_;
   int message_count_;
+  bool external_data_;
 };
 
 class IPCChannelPerfTestBase : public IPCTestBase {
  public:
   static std::vector<PingPongTestParams> GetDefaultTestParams();
+  // Messages of 1 KB to 16 MB, with their payload copied into the messages
+  // or written as external data.
+  static std::vector<PingPongTestParams> GetLargeMessageTestParams(
+      bool external_data);
 
   void RunTestChannelPingPong(
       const std::vector<PingPongTestParams>& params_list);
   void RunTestChannelProxyPingPong(
       const std::vector<PingPongTestParams>& params_list);
+#if defined(OS_LINUX)
+  // Same as RunTestChannelPingPong(), with the messages sent through shared
+  // memory rings of |ring_capacity| bytes rather than the socket.
+  void RunTestChannelSharedMemoryRingPingPong(
+      const std::vector<PingPongTestParams>& params_list,
+      size_t ring_capacity);
+#endif
+
+ private:
+  // Runs the ping-pong over an IPC::Channel. Shared memory rings are used if
+  // |ring_capacity| isn't 0.
+  void RunChannelPingPong(
+      const std::vector<PingPongTestParams>& params_list,
+      const std::string& label,
+      size_t ring_capacity);
 };
 
 class PingPongTestClient {
@@ -21,6 +21,32 @@ TEST_F(IPCChannelPerfTest, ChannelProxyPingPong) {
   RunTestChannelProxyPingPong(GetDefaultTestParams());
 }
 
+// Compares messages of 1 KB to 16 MB with the payload copied into them to the
+// same messages with the payload sent from where it is.
+TEST_F(IPCChannelPerfTest, ChannelPingPongLargeMessages) {
+  RunTestChannelPingPong(GetLargeMessageTestParams(false));
+}
+
+TEST_F(IPCChannelPerfTest, ChannelPingPongLargeMessagesExternalData) {
+  RunTestChannelPingPong(GetLargeMessageTestParams(true));
+}
+
+#if defined(OS_LINUX)
+// The same as ChannelPingPong and ChannelPingPongLargeMessages, with the
+// messages sent through shared memory rings rather than the socket.
+const size_t kRingCapacity = 1 << 20;
+
+TEST_F(IPCChannelPerfTest, ChannelSharedMemoryRingPingPong) {
+  RunTestChannelSharedMemoryRingPingPong(GetDefaultTestParams(),
+                                         kRingCapacity);
+}
+
+TEST_F(IPCChannelPerfTest, ChannelSharedMemoryRingPingPongLargeMessages) {
+  RunTestChannelSharedMemoryRingPingPong(GetLargeMessageTestParams(false),
+                                         kRingCapacity);
+}
+#endif
+
 MULTIPROCESS_IPC_TEST_CLIENT_MAIN(PerformanceClient) {
   IPC::test::PingPongTestClient client;
   return client.RunMain();
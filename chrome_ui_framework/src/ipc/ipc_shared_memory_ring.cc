@@ -0,0 +1,234 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/ipc_shared_memory_ring.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "base/files/scoped_file.h"
+#include "base/posix/eintr_wrapper.h"
+
+// The sealing interface is missing from older system headers.
+#if !defined(F_ADD_SEALS)
+#define F_ADD_SEALS (1024 + 9)
+#define F_GET_SEALS (1024 + 10)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#endif  // OS_LINUX
+
+namespace IPC {
+namespace internal {
+
+// The header is at the start of the memory, before the bytes of the ring.
+// The index of each end is in a cache line of its own, so that the ends
+// don't slow each other down when they update their index.
+struct SharedMemoryRing::Header {
+  // Written by the writer.
+  base::subtle::Atomic32 write_index;
+  // Set by the writer, and reset by the reader.
+  base::subtle::Atomic32 writer_waiting;
+  char padding1[56];
+
+  // Written by the reader.
+  base::subtle::Atomic32 read_index;
+  // Set by the reader, and reset by the writer.
+  base::subtle::Atomic32 reader_waiting;
+  char padding2[56];
+};
+
+namespace {
+
+const size_t kHeaderSize = 128;
+
+#if defined(OS_LINUX)
+// The ring is mapped by both processes, and touching a page that the other
+// process truncated away would crash. The size of the memory is sealed so
+// that neither process can change it once it is shared.
+const int kSizeSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+
+// Returns the memory for a ring of |size| bytes, sealed to that size.
+scoped_ptr<base::SharedMemory> CreateSealedMemory(size_t size) {
+#if defined(__NR_memfd_create)
+  base::ScopedFD fd(static_cast<int>(syscall(
+      __NR_memfd_create, "ipc_ring", MFD_CLOEXEC | MFD_ALLOW_SEALING)));
+  if (!fd.is_valid() ||
+      HANDLE_EINTR(ftruncate(fd.get(), static_cast<off_t>(size))) != 0 ||
+      fcntl(fd.get(), F_ADD_SEALS, kSizeSeals | F_SEAL_SEAL) != 0) {
+    return scoped_ptr<base::SharedMemory>();
+  }
+  return make_scoped_ptr(new base::SharedMemory(
+      base::SharedMemoryHandle(fd.release(), true), false));
+#else
+  return scoped_ptr<base::SharedMemory>();
+#endif
+}
+
+// Returns true if the size of the memory in |handle| can't be changed.
+bool IsSizeSealed(const base::SharedMemoryHandle& handle) {
+  const int seals = fcntl(handle.fd, F_GET_SEALS);
+  return seals != -1 && (seals & kSizeSeals) == kSizeSeals;
+}
+#endif  // OS_LINUX
+
+}  // namespace
+
+SharedMemoryRing::SharedMemoryRing(size_t capacity,
+                                   scoped_ptr<base::SharedMemory> memory)
+    : capacity_(capacity), memory_(memory.Pass()), index_(0) {
+  static_assert(sizeof(Header) == kHeaderSize,
+                "Unexpected SharedMemoryRing header size");
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+}
+
+// static
+scoped_ptr<SharedMemoryRing> SharedMemoryRing::Create(size_t capacity) {
+  if (!IsValidCapacity(capacity))
+    return scoped_ptr<SharedMemoryRing>();
+
+  // New memory starts zeroed, which is an empty ring.
+#if defined(OS_LINUX)
+  scoped_ptr<base::SharedMemory> memory =
+      CreateSealedMemory(kHeaderSize + capacity);
+  if (!memory || !memory->Map(kHeaderSize + capacity))
+    return scoped_ptr<SharedMemoryRing>();
+#else
+  scoped_ptr<base::SharedMemory> memory(new base::SharedMemory);
+  if (!memory->CreateAndMapAnonymous(kHeaderSize + capacity))
+    return scoped_ptr<SharedMemoryRing>();
+#endif
+  return make_scoped_ptr(new SharedMemoryRing(capacity, memory.Pass()));
+}
+
+// static
+scoped_ptr<SharedMemoryRing> SharedMemoryRing::Open(
+    const base::SharedMemoryHandle& handle,
+    size_t capacity) {
+  scoped_ptr<base::SharedMemory> memory(new base::SharedMemory(handle, false));
+  if (!IsValidCapacity(capacity))
+    return scoped_ptr<SharedMemoryRing>();
+
+#if defined(OS_LINUX)
+  // The size checked below must stay the same while the ring is mapped.
+  if (!IsSizeSealed(handle))
+    return scoped_ptr<SharedMemoryRing>();
+#endif
+
+#if defined(OS_POSIX) && !defined(OS_ANDROID) && !defined(OS_NACL)
+  // Memory backed by a file that is too small would be mapped anyway, and
+  // touching the pages past its end would crash.
+  size_t size = 0;
+  if (!base::SharedMemory::GetSizeFromSharedMemoryHandle(handle, &size) ||
+      size < kHeaderSize + capacity) {
+    return scoped_ptr<SharedMemoryRing>();
+  }
+#endif
+
+  if (!memory->Map(kHeaderSize + capacity))
+    return scoped_ptr<SharedMemoryRing>();
+  return make_scoped_ptr(new SharedMemoryRing(capacity, memory.Pass()));
+}
+
+// static
+bool SharedMemoryRing::IsValidCapacity(size_t capacity) {
+  return capacity >= kMinCapacity && capacity <= kMaxCapacity &&
+         (capacity & (capacity - 1)) == 0;
+}
+
+int SharedMemoryRing::Write(const void* data, size_t size) {
+  const uint32_t read_index = static_cast<uint32_t>(
+      base::subtle::Acquire_Load(&header()->read_index));
+  const uint32_t used = index_ - read_index;
+  if (used > capacity_)
+    return -1;
+
+  size = std::min(size, capacity_ - used);
+  const size_t offset = index_ & (capacity_ - 1);
+  const size_t first_size = std::min(size, capacity_ - offset);
+  memcpy(this->data() + offset, data, first_size);
+  memcpy(this->data(), static_cast<const char*>(data) + first_size,
+         size - first_size);
+
+  index_ += static_cast<uint32_t>(size);
+  base::subtle::Release_Store(&header()->write_index,
+                              static_cast<base::subtle::Atomic32>(index_));
+  return static_cast<int>(size);
+}
+
+bool SharedMemoryRing::IsDrained() const {
+  return static_cast<uint32_t>(base::subtle::Acquire_Load(
+             &header()->read_index)) == index_;
+}
+
+void SharedMemoryRing::WaitForReader() {
+  base::subtle::NoBarrier_Store(&header()->writer_waiting, 1);
+  // The flag must be seen by the reader before the writer checks the ring
+  // again, or neither end would wake the other up.
+  base::subtle::MemoryBarrier();
+}
+
+bool SharedMemoryRing::TakeReaderWaiting() {
+  // The new write index must be seen by the reader before the writer checks
+  // the flag. See WaitForWriter().
+  base::subtle::MemoryBarrier();
+  return base::subtle::NoBarrier_Load(&header()->reader_waiting) &&
+         base::subtle::NoBarrier_AtomicExchange(&header()->reader_waiting, 0);
+}
+
+bool SharedMemoryRing::GetReadableSize(size_t* size) const {
+  const uint32_t write_index = static_cast<uint32_t>(
+      base::subtle::Acquire_Load(&header()->write_index));
+  *size = write_index - index_;
+  return *size <= capacity_;
+}
+
+void SharedMemoryRing::Read(size_t size, std::string* data) {
+  DCHECK_LE(size, capacity_);
+  const size_t offset = index_ & (capacity_ - 1);
+  const size_t first_size = std::min(size, capacity_ - offset);
+  data->append(this->data() + offset, first_size);
+  data->append(this->data(), size - first_size);
+
+  index_ += static_cast<uint32_t>(size);
+  base::subtle::Release_Store(&header()->read_index,
+                              static_cast<base::subtle::Atomic32>(index_));
+}
+
+void SharedMemoryRing::WaitForWriter() {
+  base::subtle::NoBarrier_Store(&header()->reader_waiting, 1);
+  base::subtle::MemoryBarrier();
+}
+
+bool SharedMemoryRing::TakeWriterWaiting() {
+  base::subtle::MemoryBarrier();
+  return base::subtle::NoBarrier_Load(&header()->writer_waiting) &&
+         base::subtle::NoBarrier_AtomicExchange(&header()->writer_waiting, 0);
+}
+
+SharedMemoryRing::Header* SharedMemoryRing::header() const {
+  return static_cast<Header*>(memory_->memory());
+}
+
+char* SharedMemoryRing::data() const {
+  return static_cast<char*>(memory_->memory()) + kHeaderSize;
+}
+
+}  // namespace internal
+}  // namespace IPC
@@ -0,0 +1,117 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef IPC_IPC_SHARED_MEMORY_RING_H_
+#define IPC_IPC_SHARED_MEMORY_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "ipc/ipc_export.h"
+
+namespace IPC {
+namespace internal {
+
+// SharedMemoryRing is a ring buffer in shared memory, through which one
+// process streams bytes to another: one end of the ring only writes, and the
+// other only reads. The ends don't wait on each other; they instead flag in
+// the ring that they are about to wait, and the other end wakes them up,
+// through a file descriptor for instance, when it finds the flag set.
+//
+// The memory is shared with a process that isn't trusted, so each end only
+// relies on its own copy of its index into the ring, and checks the index of
+// the other end before using it.
+class IPC_EXPORT SharedMemoryRing {
+ public:
+  // The capacity of a ring is a power of two in this range.
+  static const size_t kMinCapacity = 4 * 1024;
+  static const size_t kMaxCapacity = 64 * 1024 * 1024;
+
+  ~SharedMemoryRing();
+
+  // Creates a ring of |capacity| bytes, for this process to write to. On
+  // Linux the memory is a memfd sealed to its size. Returns null if
+  // |capacity| is invalid or the memory can't be mapped.
+  static scoped_ptr<SharedMemoryRing> Create(size_t capacity);
+
+  // Maps the ring of |capacity| bytes in |handle|, created by another process
+  // with Create(), for this process to read from. Takes ownership of
+  // |handle|. Returns null if the memory is too small for |capacity|, or on
+  // Linux if its size isn't sealed.
+  static scoped_ptr<SharedMemoryRing> Open(
+      const base::SharedMemoryHandle& handle,
+      size_t capacity);
+
+  size_t capacity() const { return capacity_; }
+  base::SharedMemoryHandle handle() const { return memory_->handle(); }
+
+  // Returns true if |capacity| is valid for a ring.
+  static bool IsValidCapacity(size_t capacity);
+
+  // Writer side.
+
+  // Copies as many of the |size| bytes at |data| as there is room for, and
+  // returns how many were copied. Returns 0 when the ring is full, and -1 if
+  // the reader corrupted the ring.
+  int Write(const void* data, size_t size);
+
+  // Returns true if the reader read all of the bytes written so far.
+  bool IsDrained() const;
+
+  // Flags that the writer waits for room in the ring, or for the ring to be
+  // drained. The caller must check the ring again after this, since the
+  // reader could have read from it in the meantime.
+  void WaitForReader();
+
+  // Returns true if the reader waits for more bytes, in which case it has to
+  // be woken up. Resets the flag of the reader.
+  bool TakeReaderWaiting();
+
+  // Reader side.
+
+  // Gets the number of bytes that can be read. Returns false if the writer
+  // corrupted the ring.
+  bool GetReadableSize(size_t* size) const;
+
+  // Appends |size| bytes, no more than GetReadableSize() returned, to |data|,
+  // and frees their room in the ring.
+  void Read(size_t size, std::string* data);
+
+  // Flags that the reader waits for more bytes. The caller must check the
+  // ring again after this, since the writer could have written to it in the
+  // meantime.
+  void WaitForWriter();
+
+  // Returns true if the writer waits on the reader, in which case it has to
+  // be woken up. Resets the flag of the writer.
+  bool TakeWriterWaiting();
+
+ private:
+  struct Header;
+
+  SharedMemoryRing(size_t capacity, scoped_ptr<base::SharedMemory> memory);
+
+  Header* header() const;
+  char* data() const;
+
+  const size_t capacity_;
+  scoped_ptr<base::SharedMemory> memory_;
+
+  // The index of this end into the ring, which only grows, modulo 2^32. The
+  // copy in the header is only written, for the other end to read.
+  uint32_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemoryRing);
+};
+
+}  // namespace internal
+}  // namespace IPC
+
+#endif  // IPC_IPC_SHARED_MEMORY_RING_H_
@@ -0,0 +1,176 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ipc/ipc_shared_memory_ring.h"
+
+#if defined(OS_LINUX)
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace IPC {
+namespace internal {
+
+namespace {
+
+const size_t kCapacity = SharedMemoryRing::kMinCapacity;
+
+// Returns the reading end of the ring that |writer| writes to.
+scoped_ptr<SharedMemoryRing> OpenReader(const SharedMemoryRing& writer) {
+  return SharedMemoryRing::Open(
+      base::SharedMemory::DuplicateHandle(writer.handle()),
+      writer.capacity());
+}
+
+}  // namespace
+
+TEST(SharedMemoryRingTest, Capacity) {
+  EXPECT_TRUE(SharedMemoryRing::IsValidCapacity(kCapacity));
+  EXPECT_TRUE(
+      SharedMemoryRing::IsValidCapacity(SharedMemoryRing::kMaxCapacity));
+  EXPECT_FALSE(SharedMemoryRing::IsValidCapacity(0));
+  EXPECT_FALSE(SharedMemoryRing::IsValidCapacity(kCapacity / 2));
+  EXPECT_FALSE(SharedMemoryRing::IsValidCapacity(kCapacity + 1));
+  EXPECT_FALSE(
+      SharedMemoryRing::IsValidCapacity(SharedMemoryRing::kMaxCapacity * 2));
+  EXPECT_FALSE(SharedMemoryRing::Create(kCapacity * 3));
+}
+
+TEST(SharedMemoryRingTest, WriteAndRead) {
+  scoped_ptr<SharedMemoryRing> writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  scoped_ptr<SharedMemoryRing> reader = OpenReader(*writer);
+  ASSERT_TRUE(reader);
+  EXPECT_TRUE(writer->IsDrained());
+
+  size_t size = 1;
+  ASSERT_TRUE(reader->GetReadableSize(&size));
+  EXPECT_EQ(0u, size);
+
+  // The bytes written wrap around the end of the ring, and are read back in
+  // order.
+  std::string written;
+  std::string read;
+  for (int i = 0; i < 10; ++i) {
+    const std::string data(kCapacity / 3, 'a' + i);
+    EXPECT_EQ(static_cast<int>(data.size()),
+              writer->Write(data.data(), data.size()));
+    written += data;
+    EXPECT_FALSE(writer->IsDrained());
+
+    ASSERT_TRUE(reader->GetReadableSize(&size));
+    EXPECT_EQ(data.size(), size);
+    reader->Read(size, &read);
+    EXPECT_TRUE(writer->IsDrained());
+  }
+  EXPECT_EQ(written, read);
+}
+
+TEST(SharedMemoryRingTest, Full) {
+  scoped_ptr<SharedMemoryRing> writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  scoped_ptr<SharedMemoryRing> reader = OpenReader(*writer);
+  ASSERT_TRUE(reader);
+
+  // Only what fits is written.
+  const std::string data(kCapacity + 100, 'x');
+  EXPECT_EQ(static_cast<int>(kCapacity),
+            writer->Write(data.data(), data.size()));
+  EXPECT_EQ(0, writer->Write(data.data(), data.size()));
+
+  std::string read;
+  reader->Read(100, &read);
+  EXPECT_EQ(100, writer->Write(data.data(), data.size()));
+  size_t size = 0;
+  ASSERT_TRUE(reader->GetReadableSize(&size));
+  EXPECT_EQ(kCapacity, size);
+  reader->Read(size, &read);
+  EXPECT_EQ(data, read);
+}
+
+TEST(SharedMemoryRingTest, Wakeups) {
+  scoped_ptr<SharedMemoryRing> writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  scoped_ptr<SharedMemoryRing> reader = OpenReader(*writer);
+  ASSERT_TRUE(reader);
+
+  // Each end is told once that the other end waits on it.
+  EXPECT_FALSE(writer->TakeReaderWaiting());
+  reader->WaitForWriter();
+  EXPECT_TRUE(writer->TakeReaderWaiting());
+  EXPECT_FALSE(writer->TakeReaderWaiting());
+
+  EXPECT_FALSE(reader->TakeWriterWaiting());
+  writer->WaitForReader();
+  EXPECT_TRUE(reader->TakeWriterWaiting());
+  EXPECT_FALSE(reader->TakeWriterWaiting());
+}
+
+TEST(SharedMemoryRingTest, Corrupt) {
+  scoped_ptr<SharedMemoryRing> writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  scoped_ptr<SharedMemoryRing> reader = OpenReader(*writer);
+  ASSERT_TRUE(reader);
+
+  // A reader that read more than was written corrupts the ring for the
+  // writer.
+  std::string read;
+  reader->Read(10, &read);
+  EXPECT_EQ(-1, writer->Write("data", 4));
+
+  // A writer that wrote more than the capacity past where the reader is
+  // corrupts the ring for the reader. A second reader, which starts at the
+  // beginning of the ring, sees that.
+  writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  reader = OpenReader(*writer);
+  ASSERT_TRUE(reader);
+  const std::string data(kCapacity, 'x');
+  EXPECT_EQ(static_cast<int>(kCapacity), writer->Write(data.data(), kCapacity));
+  reader->Read(kCapacity, &read);
+  EXPECT_EQ(static_cast<int>(kCapacity), writer->Write(data.data(), kCapacity));
+
+  size_t size = 0;
+  EXPECT_TRUE(reader->GetReadableSize(&size));
+  EXPECT_EQ(kCapacity, size);
+  scoped_ptr<SharedMemoryRing> other_reader = OpenReader(*writer);
+  ASSERT_TRUE(other_reader);
+  EXPECT_FALSE(other_reader->GetReadableSize(&size));
+}
+
+#if defined(OS_POSIX) && !defined(OS_ANDROID)
+TEST(SharedMemoryRingTest, MemoryTooSmall) {
+  base::SharedMemory memory;
+  ASSERT_TRUE(memory.CreateAndMapAnonymous(kCapacity));
+  EXPECT_FALSE(SharedMemoryRing::Open(
+      base::SharedMemory::DuplicateHandle(memory.handle()), kCapacity));
+}
+#endif
+
+#if defined(OS_LINUX)
+TEST(SharedMemoryRingTest, SizeSealed) {
+  scoped_ptr<SharedMemoryRing> writer = SharedMemoryRing::Create(kCapacity);
+  ASSERT_TRUE(writer);
+  const int fd = writer->handle().fd;
+  EXPECT_NE(0, ftruncate(fd, 0));
+  EXPECT_NE(0, ftruncate(fd, 1024 * 1024));
+}
+
+TEST(SharedMemoryRingTest, SizeNotSealed) {
+  // Memory that the peer could still truncate is refused, even when it is
+  // big enough.
+  base::SharedMemory memory;
+  ASSERT_TRUE(memory.CreateAndMapAnonymous(2 * kCapacity));
+  EXPECT_FALSE(SharedMemoryRing::Open(
+      base::SharedMemory::DuplicateHandle(memory.handle()), kCapacity));
+}
+#endif
+
+}  // namespace internal
+}  // namespace IPC
@@ -77,6 +77,8 @@ bool MessagePipeReader::Send(scoped_ptr<Message> message) {
   MojoResult result = MOJO_RESULT_OK;
   result = ChannelMojo::ReadFromMessageAttachmentSet(message.get(), &handles);
   if (result == MOJO_RESULT_OK) {
+    // Mojo copies the message from data(), which must hold all of it.
+    message->Flatten();
     result = MojoWriteMessage(handle(),
                               message->data(),
                               static_cast<uint32_t>(message->size()),
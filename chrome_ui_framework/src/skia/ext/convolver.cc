@@ -4,8 +4,16 @@
 
 #include <algorithm>
 
+#include "base/bind.h"
+#include "base/cpu.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/worker_pool.h"
 #include "skia/ext/convolver.h"
+#include "skia/ext/convolver_AVX2.h"
 #include "skia/ext/convolver_SSE2.h"
 #include "skia/ext/convolver_mips_dspr2.h"
 #include "third_party/skia/include/core/SkSize.h"
@@ -363,6 +371,15 @@ struct ConvolveProcs {
 void SetupSIMD(ConvolveProcs *procs) {
 #ifdef SIMD_SSE2
   procs->extra_horizontal_reads = 3;
+#ifdef SIMD_AVX2
+  base::CPU cpu;
+  if (cpu.has_avx2()) {
+    procs->convolve_vertically = &ConvolveVertically_AVX2;
+    procs->convolve_4rows_horizontally = &Convolve4RowsHorizontally_AVX2;
+    procs->convolve_horizontally = &ConvolveHorizontally_AVX2;
+    return;
+  }
+#endif
   procs->convolve_vertically = &ConvolveVertically_SSE2;
   procs->convolve_4rows_horizontally = &Convolve4RowsHorizontally_SSE2;
   procs->convolve_horizontally = &ConvolveHorizontally_SSE2;
@@ -373,33 +390,43 @@ void SetupSIMD(ConvolveProcs *procs) {
 #endif
 }
 
-void BGRAConvolve2D(const unsigned char* source_data,
-                    int source_byte_row_stride,
-                    bool source_has_alpha,
-                    const ConvolutionFilter1D& filter_x,
-                    const ConvolutionFilter1D& filter_y,
-                    int output_byte_row_stride,
-                    unsigned char* output,
-                    bool use_simd_if_possible) {
-  ConvolveProcs simd;
-  simd.extra_horizontal_reads = 0;
-  simd.convolve_vertically = NULL;
-  simd.convolve_4rows_horizontally = NULL;
-  simd.convolve_horizontally = NULL;
+namespace {
+
+void GetConvolveProcs(bool use_simd_if_possible, ConvolveProcs* procs) {
+  procs->extra_horizontal_reads = 0;
+  procs->convolve_vertically = NULL;
+  procs->convolve_4rows_horizontally = NULL;
+  procs->convolve_horizontally = NULL;
   if (use_simd_if_possible) {
-    SetupSIMD(&simd);
+    SetupSIMD(procs);
   }
+}
 
+// Produces the output rows [begin_output_row, end_output_row) of
+// BGRAConvolve2D. Only the source rows these depend on are convolved
+// horizontally.
+void ConvolveRows(const ConvolveProcs& simd,
+                  const unsigned char* source_data,
+                  int source_byte_row_stride,
+                  bool source_has_alpha,
+                  const ConvolutionFilter1D& filter_x,
+                  const ConvolutionFilter1D& filter_y,
+                  int output_byte_row_stride,
+                  unsigned char* output,
+                  int begin_output_row,
+                  int end_output_row) {
   int max_y_filter_size = filter_y.max_filter();
 
   // The next row in the input that we will generate a horizontally
   // convolved row for. If the filter doesn't start at the beginning of the
-  // image (this is the case when we are only resizing a subset), then we
-  // don't want to generate any output rows before that. Compute the starting
-  // row for convolution as the first pixel for the first vertical filter.
+  // image (this is the case when we are only resizing a subset, or only
+  // producing a band of the output), then we don't want to generate any
+  // output rows before that. Compute the starting row for convolution as the
+  // first pixel for the first vertical filter.
   int filter_offset, filter_length;
   const ConvolutionFilter1D::Fixed* filter_values =
-      filter_y.FilterForValue(0, &filter_offset, &filter_length);
+      filter_y.FilterForValue(begin_output_row, &filter_offset,
+                              &filter_length);
   int next_x_row = filter_offset;
 
   // We loop over each row in the input doing a horizontal convolution. This
@@ -428,7 +455,7 @@ void BGRAConvolve2D(const unsigned char* source_data,
   // lines in one iteration.
   int last_filter_offset, last_filter_length;
 
-  // SSE2 can access up to 3 extra pixels past the end of the
+  // SSE2 and AVX2 can access up to 3 extra pixels past the end of the
   // buffer. At the bottom of the image, we have to be careful
   // not to access data past the end of the buffer. Normally
   // we fall back to the C++ implementation for the last row.
@@ -443,7 +470,7 @@ void BGRAConvolve2D(const unsigned char* source_data,
   filter_y.FilterForValue(num_output_rows - 1, &last_filter_offset,
                           &last_filter_length);
 
-  for (int out_y = 0; out_y < num_output_rows; out_y++) {
+  for (int out_y = begin_output_row; out_y < end_output_row; out_y++) {
     filter_values = filter_y.FilterForValue(out_y,
                                             &filter_offset, &filter_length);
 
@@ -510,6 +537,131 @@ void BGRAConvolve2D(const unsigned char* source_data,
   }
 }
 
+
+// The bands of a BGRAConvolve2DInBands() call. Each band is claimed by
+// taking its lock, either by a worker thread or by the calling thread, so the
+// calling thread only ever waits for bands that are being convolved.
+class ConvolveBands : public base::RefCountedThreadSafe<ConvolveBands> {
+ public:
+  ConvolveBands(const ConvolveProcs& simd,
+                const unsigned char* source_data,
+                int source_byte_row_stride,
+                bool source_has_alpha,
+                const ConvolutionFilter1D& filter_x,
+                const ConvolutionFilter1D& filter_y,
+                int output_byte_row_stride,
+                unsigned char* output,
+                int num_bands)
+      : simd_(simd),
+        source_data_(source_data),
+        source_byte_row_stride_(source_byte_row_stride),
+        source_has_alpha_(source_has_alpha),
+        filter_x_(filter_x),
+        filter_y_(filter_y),
+        output_byte_row_stride_(output_byte_row_stride),
+        output_(output) {
+    int num_output_rows = filter_y.num_values();
+    for (int i = 0; i < num_bands; ++i) {
+      Band* band = new Band;
+      band->begin_output_row = num_output_rows * i / num_bands;
+      band->end_output_row = num_output_rows * (i + 1) / num_bands;
+      band->done = false;
+      bands_.push_back(band);
+    }
+  }
+
+  int num_bands() const { return static_cast<int>(bands_.size()); }
+
+  // Convolves band |index| unless it is done already. The arguments of the
+  // convolution are only used while a band is not done, which lets worker
+  // tasks outlive the call that posted them.
+  void ConvolveBand(int index) {
+    Band* band = bands_[index];
+    base::AutoLock lock(band->lock);
+    if (band->done)
+      return;
+    ConvolveRows(simd_, source_data_, source_byte_row_stride_,
+                 source_has_alpha_, filter_x_, filter_y_,
+                 output_byte_row_stride_, output_, band->begin_output_row,
+                 band->end_output_row);
+    band->done = true;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ConvolveBands>;
+
+  struct Band {
+    base::Lock lock;
+    int begin_output_row;
+    int end_output_row;
+    bool done;
+  };
+
+  ~ConvolveBands() {}
+
+  const ConvolveProcs simd_;
+  const unsigned char* const source_data_;
+  const int source_byte_row_stride_;
+  const bool source_has_alpha_;
+  const ConvolutionFilter1D& filter_x_;
+  const ConvolutionFilter1D& filter_y_;
+  const int output_byte_row_stride_;
+  unsigned char* const output_;
+  ScopedVector<Band> bands_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConvolveBands);
+};
+
+}  // namespace
+
+void BGRAConvolve2D(const unsigned char* source_data,
+                    int source_byte_row_stride,
+                    bool source_has_alpha,
+                    const ConvolutionFilter1D& filter_x,
+                    const ConvolutionFilter1D& filter_y,
+                    int output_byte_row_stride,
+                    unsigned char* output,
+                    bool use_simd_if_possible) {
+  ConvolveProcs simd;
+  GetConvolveProcs(use_simd_if_possible, &simd);
+  ConvolveRows(simd, source_data, source_byte_row_stride, source_has_alpha,
+               filter_x, filter_y, output_byte_row_stride, output, 0,
+               filter_y.num_values());
+}
+
+void BGRAConvolve2DInBands(const unsigned char* source_data,
+                           int source_byte_row_stride,
+                           bool source_has_alpha,
+                           const ConvolutionFilter1D& filter_x,
+                           const ConvolutionFilter1D& filter_y,
+                           int output_byte_row_stride,
+                           unsigned char* output,
+                           bool use_simd_if_possible,
+                           int num_bands) {
+  num_bands = std::max(1, std::min(num_bands, filter_y.num_values()));
+  if (num_bands == 1) {
+    BGRAConvolve2D(source_data, source_byte_row_stride, source_has_alpha,
+                   filter_x, filter_y, output_byte_row_stride, output,
+                   use_simd_if_possible);
+    return;
+  }
+
+  ConvolveProcs simd;
+  GetConvolveProcs(use_simd_if_possible, &simd);
+  scoped_refptr<ConvolveBands> bands(new ConvolveBands(
+      simd, source_data, source_byte_row_stride, source_has_alpha, filter_x,
+      filter_y, output_byte_row_stride, output, num_bands));
+
+  // Hand all but the first band to the worker pool, then work through the
+  // bands in order on this thread.
+  for (int i = 1; i < bands->num_bands(); ++i) {
+    base::WorkerPool::PostTask(
+        FROM_HERE, base::Bind(&ConvolveBands::ConvolveBand, bands, i), false);
+  }
+  for (int i = 0; i < bands->num_bands(); ++i)
+    bands->ConvolveBand(i);
+}
+
 void SingleChannelConvolveX1D(const unsigned char* source_data,
                               int source_byte_row_stride,
                               int input_channel_index,
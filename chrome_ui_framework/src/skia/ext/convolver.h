@@ -17,6 +17,8 @@
 #if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_IOS)
 #define SIMD_SSE2 1
 #define SIMD_PADDING 8  // 8 * int16
+// The AVX2 kernels are picked at runtime on CPUs that support them.
+#define SIMD_AVX2 1
 #endif
 
 #if defined (ARCH_CPU_MIPS_FAMILY) && \
@@ -191,6 +193,21 @@ SK_API void BGRAConvolve2D(const unsigned char* source_data,
                            unsigned char* output,
                            bool use_simd_if_possible);
 
+// Same as BGRAConvolve2D, but splits the output rows into |num_bands| bands
+// that are convolved in parallel. The calling thread convolves any band that
+// no worker thread has started yet, and returns once all of them are done.
+// Each band recomputes the horizontal convolution of the few source rows it
+// shares with the previous one, so bands should be many rows tall.
+SK_API void BGRAConvolve2DInBands(const unsigned char* source_data,
+                                  int source_byte_row_stride,
+                                  bool source_has_alpha,
+                                  const ConvolutionFilter1D& xfilter,
+                                  const ConvolutionFilter1D& yfilter,
+                                  int output_byte_row_stride,
+                                  unsigned char* output,
+                                  bool use_simd_if_possible,
+                                  int num_bands);
+
 // Does a 1D convolution of the given source image along the X dimension on
 // a single channel of the bitmap.
 //
@@ -0,0 +1,272 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include "skia/ext/convolver.h"
+#include "skia/ext/convolver_AVX2.h"
+#include "third_party/skia/include/core/SkTypes.h"
+
+#include <immintrin.h>  // ARCH_CPU_X86_FAMILY was defined in build/config.h
+
+namespace skia {
+
+namespace {
+
+// Loads the eight filter coefficients at |filter_values|, zeroing the ones at
+// and past |taps_left|. Reading all eight is safe since the filter values are
+// padded by ConvolutionFilter1D::PaddingForSIMD().
+inline __m128i LoadCoefficients(
+    const ConvolutionFilter1D::Fixed* filter_values,
+    int taps_left) {
+  __m128i coeff =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(filter_values));
+  if (taps_left < 8) {
+    __m128i mask = _mm_cmplt_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7),
+                                   _mm_set1_epi16(taps_left));
+    coeff = _mm_and_si128(coeff, mask);
+  }
+  return coeff;
+}
+
+// Duplicates each of the eight coefficients in |coeff| for all four channels
+// of a pixel, laid out to match the pixels unpacked by AccumulatePixels().
+inline void SpreadCoefficients(__m128i coeff,
+                               __m256i* coeff_lo,
+                               __m256i* coeff_hi) {
+  // [32] c7c7 c6c6 c5c5 c4c4 | c3c3 c2c2 c1c1 c0c0
+  __m256i pairs = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_unpacklo_epi16(coeff, coeff)),
+      _mm_unpackhi_epi16(coeff, coeff), 1);
+  // [16] c3 c3 c3 c3 c2 c2 c2 c2 | c1 c1 c1 c1 c0 c0 c0 c0
+  *coeff_lo = _mm256_permutevar8x32_epi32(
+      pairs, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+  // [16] c7 c7 c7 c7 c6 c6 c6 c6 | c5 c5 c5 c5 c4 c4 c4 c4
+  *coeff_hi = _mm256_permutevar8x32_epi32(
+      pairs, _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7));
+}
+
+// Multiplies the four pixels at |src| with |coeff| and accumulates the
+// products into |accum|, whose two halves are summed by PackPixel().
+inline __m256i AccumulatePixels(const unsigned char* src,
+                                __m256i coeff,
+                                __m256i accum) {
+  // [16] a3 b3 g3 r3 a2 b2 g2 r2 | a1 b1 g1 r1 a0 b0 g0 r0
+  __m256i src16 = _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+  __m256i mul_hi = _mm256_mulhi_epi16(src16, coeff);
+  __m256i mul_lo = _mm256_mullo_epi16(src16, coeff);
+  // [32] a2*c2 b2*c2 g2*c2 r2*c2 | a0*c0 b0*c0 g0*c0 r0*c0
+  accum = _mm256_add_epi32(accum, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+  // [32] a3*c3 b3*c3 g3*c3 r3*c3 | a1*c1 b1*c1 g1*c1 r1*c1
+  return _mm256_add_epi32(accum, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+}
+
+// Accumulates the whole filter for one output pixel of the row at |src|.
+// Eight taps are handled per iteration; the upper four pixels are only
+// loaded when needed, so at most three pixels past the last tap are read,
+// as in the SSE2 version.
+inline __m256i AccumulateFilter(const unsigned char* src,
+                                const ConvolutionFilter1D::Fixed* filter_values,
+                                int filter_length) {
+  __m256i accum = _mm256_setzero_si256();
+  for (int filter_x = 0; filter_x < filter_length; filter_x += 8) {
+    __m256i coeff_lo, coeff_hi;
+    SpreadCoefficients(
+        LoadCoefficients(filter_values + filter_x, filter_length - filter_x),
+        &coeff_lo, &coeff_hi);
+    accum = AccumulatePixels(src, coeff_lo, accum);
+    if (filter_length - filter_x > 4)
+      accum = AccumulatePixels(src + 16, coeff_hi, accum);
+    src += 32;
+  }
+  return accum;
+}
+
+// Sums the halves of |accum| and brings the result back to a 32 bit pixel.
+inline int PackPixel(__m256i accum) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(accum),
+                              _mm256_extracti128_si256(accum, 1));
+  // Shift right for fixed point implementation.
+  sum = _mm_srai_epi32(sum, ConvolutionFilter1D::kShiftBits);
+  // Packing 32 bits to 16 bits per channel (signed saturation).
+  sum = _mm_packs_epi32(sum, zero);
+  // Packing 16 bits to 8 bits per channel (unsigned saturation).
+  sum = _mm_packus_epi16(sum, zero);
+  return _mm_cvtsi128_si32(sum);
+}
+
+// Does vertical convolution to produce one output row, eight pixels at a
+// time. See ConvolveVertically_SSE2 for the details of the algorithm.
+//
+// The rows of the circular buffer are padded to a multiple of 16 pixels, so
+// the last group of pixels is always loaded in full; only the pixels that
+// are part of the row are stored.
+template<bool has_alpha>
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row) {
+  __m256i zero = _mm256_setzero_si256();
+  for (int out_x = 0; out_x < pixel_width; out_x += 8) {
+    // Accumulated result for each pixel. 32 bits per RGBA channel.
+    __m256i accum0 = _mm256_setzero_si256();
+    __m256i accum1 = _mm256_setzero_si256();
+    __m256i accum2 = _mm256_setzero_si256();
+    __m256i accum3 = _mm256_setzero_si256();
+
+    // Convolve with one filter coefficient per iteration.
+    for (int filter_y = 0; filter_y < filter_length; filter_y++) {
+      __m256i coeff16 = _mm256_set1_epi16(filter_values[filter_y]);
+
+      // Load eight pixels (32 bytes) together.
+      __m256i src8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+          &source_data_rows[filter_y][out_x << 2]));
+
+      // Unpacking works within each 128 bit lane.
+      // [16] a5 b5 g5 r5 a4 b4 g4 r4 | a1 b1 g1 r1 a0 b0 g0 r0
+      __m256i src16 = _mm256_unpacklo_epi8(src8, zero);
+      __m256i mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+      __m256i mul_lo = _mm256_mullo_epi16(src16, coeff16);
+      // [32] a4 b4 g4 r4 | a0 b0 g0 r0
+      accum0 = _mm256_add_epi32(accum0, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+      // [32] a5 b5 g5 r5 | a1 b1 g1 r1
+      accum1 = _mm256_add_epi32(accum1, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+
+      // [16] a7 b7 g7 r7 a6 b6 g6 r6 | a3 b3 g3 r3 a2 b2 g2 r2
+      src16 = _mm256_unpackhi_epi8(src8, zero);
+      mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+      mul_lo = _mm256_mullo_epi16(src16, coeff16);
+      // [32] a6 b6 g6 r6 | a2 b2 g2 r2
+      accum2 = _mm256_add_epi32(accum2, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+      // [32] a7 b7 g7 r7 | a3 b3 g3 r3
+      accum3 = _mm256_add_epi32(accum3, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+    }
+
+    // Shift right for fixed point implementation.
+    accum0 = _mm256_srai_epi32(accum0, ConvolutionFilter1D::kShiftBits);
+    accum1 = _mm256_srai_epi32(accum1, ConvolutionFilter1D::kShiftBits);
+    accum2 = _mm256_srai_epi32(accum2, ConvolutionFilter1D::kShiftBits);
+    accum3 = _mm256_srai_epi32(accum3, ConvolutionFilter1D::kShiftBits);
+
+    // Packing works within each lane too, which puts the pixels back in
+    // order.
+    // [16] a5 b5 g5 r5 a4 b4 g4 r4 | a1 b1 g1 r1 a0 b0 g0 r0
+    accum0 = _mm256_packs_epi32(accum0, accum1);
+    // [16] a7 b7 g7 r7 a6 b6 g6 r6 | a3 b3 g3 r3 a2 b2 g2 r2
+    accum2 = _mm256_packs_epi32(accum2, accum3);
+    // [8] a7 ... r4 | a3 ... r0
+    accum0 = _mm256_packus_epi16(accum0, accum2);
+
+    if (has_alpha) {
+      // Make sure the value of alpha channel is always larger than maximum
+      // value of color channels.
+      __m256i a = _mm256_srli_epi32(accum0, 8);
+      __m256i b = _mm256_max_epu8(a, accum0);  // Max of r and g.
+      a = _mm256_srli_epi32(accum0, 16);
+      b = _mm256_max_epu8(a, b);  // Max of r and g and b.
+      b = _mm256_slli_epi32(b, 24);
+      accum0 = _mm256_max_epu8(b, accum0);
+    } else {
+      // Set value of alpha channels to 0xFF.
+      accum0 = _mm256_or_si256(accum0, _mm256_set1_epi32(0xff000000));
+    }
+
+    if (pixel_width - out_x >= 8) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_row), accum0);
+    } else {
+      unsigned char pixels[32];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), accum0);
+      memcpy(out_row, pixels, (pixel_width - out_x) << 2);
+    }
+    out_row += 32;
+  }
+}
+
+}  // namespace
+
+// Convolves horizontally along a single row. The row data is given in
+// |src_data| and continues for the num_values() of the filter.
+void ConvolveHorizontally_AVX2(const unsigned char* src_data,
+                               const ConvolutionFilter1D& filter,
+                               unsigned char* out_row,
+                               bool /*has_alpha*/) {
+  int num_values = filter.num_values();
+  int filter_offset, filter_length;
+
+  // Output one pixel each iteration, calculating all channels (RGBA) together.
+  for (int out_x = 0; out_x < num_values; out_x++) {
+    const ConvolutionFilter1D::Fixed* filter_values =
+        filter.FilterForValue(out_x, &filter_offset, &filter_length);
+    __m256i accum = AccumulateFilter(&src_data[filter_offset << 2],
+                                     filter_values, filter_length);
+    *(reinterpret_cast<int*>(out_row)) = PackPixel(accum);
+    out_row += 4;
+  }
+}
+
+// Convolves horizontally along four rows, sharing the coefficient setup
+// between them.
+void Convolve4RowsHorizontally_AVX2(const unsigned char* src_data[4],
+                                    const ConvolutionFilter1D& filter,
+                                    unsigned char* out_row[4]) {
+  int num_values = filter.num_values();
+  int filter_offset, filter_length;
+
+  for (int out_x = 0; out_x < num_values; out_x++) {
+    const ConvolutionFilter1D::Fixed* filter_values =
+        filter.FilterForValue(out_x, &filter_offset, &filter_length);
+
+    __m256i accum[4];
+    for (int row = 0; row < 4; ++row)
+      accum[row] = _mm256_setzero_si256();
+
+    int start = filter_offset << 2;
+    for (int filter_x = 0; filter_x < filter_length; filter_x += 8) {
+      __m256i coeff_lo, coeff_hi;
+      SpreadCoefficients(
+          LoadCoefficients(filter_values + filter_x, filter_length - filter_x),
+          &coeff_lo, &coeff_hi);
+      for (int row = 0; row < 4; ++row)
+        accum[row] = AccumulatePixels(src_data[row] + start, coeff_lo,
+                                      accum[row]);
+      if (filter_length - filter_x > 4) {
+        for (int row = 0; row < 4; ++row)
+          accum[row] = AccumulatePixels(src_data[row] + start + 16, coeff_hi,
+                                        accum[row]);
+      }
+      start += 32;
+    }
+
+    for (int row = 0; row < 4; ++row) {
+      *(reinterpret_cast<int*>(out_row[row])) = PackPixel(accum[row]);
+      out_row[row] += 4;
+    }
+  }
+}
+
+void ConvolveVertically_AVX2(const ConvolutionFilter1D::Fixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha) {
+  if (has_alpha) {
+    ConvolveVertically_AVX2<true>(filter_values,
+                                  filter_length,
+                                  source_data_rows,
+                                  pixel_width,
+                                  out_row);
+  } else {
+    ConvolveVertically_AVX2<false>(filter_values,
+                                   filter_length,
+                                   source_data_rows,
+                                   pixel_width,
+                                   out_row);
+  }
+}
+
+}  // namespace skia
@@ -329,6 +329,42 @@ TEST(Convolver, VerifySIMDPrecision) {
   }
 }
 
+// Verify that convolving in bands matches convolving in one go, including
+// when there are more bands than output rows.
+TEST(Convolver, BandsMatchSingleThreaded) {
+  const int kSourceSize = 257;
+  const int kDestSizes[] = { 3, 64, 143 };
+  float filter[] = { 0.05f, -0.15f, 0.6f, 0.6f, -0.15f, 0.05f };
+
+  std::vector<unsigned char> source(kSourceSize * kSourceSize * 4);
+  for (size_t i = 0; i < source.size(); ++i)
+    source[i] = static_cast<unsigned char>(i * 7919 % 255);
+
+  for (size_t i = 0; i < arraysize(kDestSizes); ++i) {
+    int dest_size = kDestSizes[i];
+    ConvolutionFilter1D conv_filter;
+    for (int p = 0; p < dest_size; ++p) {
+      int offset = kSourceSize * p / dest_size;
+      conv_filter.AddFilter(offset, filter,
+                            std::min<int>(arraysize(filter),
+                                          kSourceSize - offset));
+    }
+    conv_filter.PaddingForSIMD();
+
+    std::vector<unsigned char> expected(dest_size * dest_size * 4);
+    BGRAConvolve2D(&source[0], kSourceSize * 4, true, conv_filter, conv_filter,
+                   dest_size * 4, &expected[0], true);
+    for (int num_bands = 2; num_bands <= 8; num_bands *= 2) {
+      std::vector<unsigned char> actual(expected.size());
+      BGRAConvolve2DInBands(&source[0], kSourceSize * 4, true, conv_filter,
+                            conv_filter, dest_size * 4, &actual[0], true,
+                            num_bands);
+      EXPECT_EQ(expected, actual) << dest_size << " rows in " << num_bands
+                                  << " bands";
+    }
+  }
+}
+
 TEST(Convolver, SeparableSingleConvolution) {
   static const int kImgWidth = 1024;
   static const int kImgHeight = 1024;
@@ -13,6 +13,7 @@
 #include "base/containers/stack_container.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
+#include "base/sys_info.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 #include "build/build_config.h"
@@ -24,6 +25,15 @@ namespace skia {
 
 namespace {
 
+// Resizes are only split into bands when every band still has this much work
+// to do, counted in horizontally convolved pixels. Smaller resizes are done
+// before a worker thread would even pick up its band.
+const int64 kMinPixelsPerResizeBand = 256 * 1024;
+
+// Bands beyond this do not pay for the rows that neighbouring bands both
+// convolve horizontally.
+const int kMaxResizeBands = 8;
+
 // Returns the ceiling/floor as an integer.
 inline int CeilInt(float val) {
   return static_cast<int>(ceil(val));
@@ -341,6 +351,17 @@ SkBitmap ImageOperations::Resize(const SkBitmap& source,
                                  int dest_width, int dest_height,
                                  const SkIRect& dest_subset,
                                  SkBitmap::Allocator* allocator) {
+  return ResizeInBands(source, method, dest_width, dest_height, dest_subset,
+                       GetDefaultResizeBands(source, dest_subset), allocator);
+}
+
+// static
+SkBitmap ImageOperations::ResizeInBands(const SkBitmap& source,
+                                        ResizeMethod method,
+                                        int dest_width, int dest_height,
+                                        const SkIRect& dest_subset,
+                                        int num_bands,
+                                        SkBitmap::Allocator* allocator) {
   TRACE_EVENT2("disabled-by-default-skia", "ImageOperations::Resize",
                "src_pixels", source.width() * source.height(), "dst_pixels",
                dest_width * dest_height);
@@ -388,11 +409,11 @@ SkBitmap ImageOperations::Resize(const SkBitmap& source,
   if (!result.readyToDraw())
     return SkBitmap();
 
-  BGRAConvolve2D(source_subset, static_cast<int>(source.rowBytes()),
-                 !source.isOpaque(), filter.x_filter(), filter.y_filter(),
-                 static_cast<int>(result.rowBytes()),
-                 static_cast<unsigned char*>(result.getPixels()),
-                 true);
+  BGRAConvolve2DInBands(source_subset, static_cast<int>(source.rowBytes()),
+                        !source.isOpaque(), filter.x_filter(),
+                        filter.y_filter(), static_cast<int>(result.rowBytes()),
+                        static_cast<unsigned char*>(result.getPixels()), true,
+                        num_bands);
 
   base::TimeDelta delta = base::TimeTicks::Now() - resize_start;
   UMA_HISTOGRAM_TIMES("Image.ResampleMS", delta);
@@ -410,4 +431,17 @@ SkBitmap ImageOperations::Resize(const SkBitmap& source,
                 allocator);
 }
 
+// static
+int ImageOperations::GetDefaultResizeBands(const SkBitmap& source,
+                                           const SkIRect& dest_subset) {
+  // The horizontal pass dominates when downscaling, and convolves every
+  // source row into a row of the destination width.
+  int64 work = static_cast<int64>(dest_subset.width()) *
+               std::max(source.height(), dest_subset.height());
+  int64 num_bands = std::min<int64>(work / kMinPixelsPerResizeBand,
+                                    base::SysInfo::NumberOfProcessors());
+  return static_cast<int>(
+      std::max<int64>(1, std::min<int64>(num_bands, kMaxResizeBands)));
+}
+
 }  // namespace skia
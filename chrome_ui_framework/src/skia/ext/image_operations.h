@@ -107,6 +107,22 @@ class SK_API ImageOperations {
                          int dest_width, int dest_height,
                          SkBitmap::Allocator* allocator = NULL);
 
+  // Same as the first version, but splits the rows of |dest_subset| into
+  // |num_bands| bands that are resized in parallel on worker threads. The
+  // versions above pick the number of bands from the amount of work and the
+  // number of processors; a |num_bands| of 1 resizes on the calling thread.
+  static SkBitmap ResizeInBands(const SkBitmap& source,
+                                ResizeMethod method,
+                                int dest_width, int dest_height,
+                                const SkIRect& dest_subset,
+                                int num_bands,
+                                SkBitmap::Allocator* allocator = NULL);
+
+  // Returns the number of bands Resize() splits a resize of |source| into
+  // |dest_subset| into.
+  static int GetDefaultResizeBands(const SkBitmap& source,
+                                   const SkIRect& dest_subset);
+
  private:
   ImageOperations();  // Class for scoping only.
 };
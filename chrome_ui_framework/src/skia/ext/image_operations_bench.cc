@@ -13,9 +13,15 @@
 // source surface + destination surface and dividing by the elapsed time.
 // This number is somewhat reasonable way to measure this, given our current
 // implementation which somewhat scales this way.
+//
+// Without -source and -destination it runs a fixed suite instead, timing
+// every resize method on a set of typical resizes, both on the calling
+// thread only and split into bands across worker threads.
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include "base/basictypes.h"
 #include "base/command_line.h"
 #include "base/format_macros.h"
@@ -99,6 +105,10 @@ class Dimensions {
       : width_(0),
         height_(0) {}
 
+  Dimensions(int w, int h)
+      : width_(w),
+        height_(h) {}
+
   void set(int w, int h) {
     width_ = w;
     height_ = h;
@@ -132,6 +142,72 @@ class Dimensions {
   int height_;
 };
 
+// A resize of the suite run when no dimensions are given.
+struct SuiteResize {
+  const char* name;
+  int source_width;
+  int source_height;
+  int dest_width;
+  int dest_height;
+};
+const SuiteResize kSuiteResizes[] = {
+  { "icon", 128, 128, 32, 32 },
+  { "tab_thumbnail", 1280, 800, 212, 132 },
+  { "photo_thumbnail", 4000, 3000, 400, 300 },
+  { "halve", 1920, 1080, 960, 540 },
+  { "upscale", 400, 300, 1200, 900 },
+};
+
+// Each resize of the suite is repeated until it has processed about this many
+// bytes, so that small and large resizes take comparable time.
+const uint64 kSuiteBytesPerResize = 512 * 1024 * 1024;
+
+// Resizes |source| to |dest| |num_iterations| times, and prints the throughput
+// and the time per resize. A |num_bands| of 0 lets Resize() pick the number of
+// bands.
+void TimeResize(const char* name,
+                const Dimensions& source_dimensions,
+                const Dimensions& dest_dimensions,
+                skia::ImageOperations::ResizeMethod method,
+                int num_bands,
+                int num_iterations) {
+  SkBitmap source;
+  source.allocN32Pixels(source_dimensions.width(), source_dimensions.height());
+  source.eraseARGB(0, 0, 0, 0);
+
+  const SkIRect dest_subset = { 0, 0, dest_dimensions.width(),
+                                dest_dimensions.height() };
+  if (num_bands == 0)
+    num_bands = skia::ImageOperations::GetDefaultResizeBands(source,
+                                                             dest_subset);
+
+  SkBitmap dest;
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+
+  for (int i = 0; i < num_iterations; ++i) {
+    dest = skia::ImageOperations::ResizeInBands(source,
+                                                method,
+                                                dest_dimensions.width(),
+                                                dest_dimensions.height(),
+                                                dest_subset,
+                                                num_bands);
+  }
+
+  const int64 elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
+
+  const uint64 num_bytes = static_cast<uint64>(num_iterations) *
+      (GetBitmapSize(&source) + GetBitmapSize(&dest));
+
+  printf("%-16s %-9s bands=%d\t%" PRIu64 " MB/s,\t%.3f ms/resize,"
+         "\telapsed = %" PRIu64 " source=%d dest=%d\n",
+         name, MethodToString(method), num_bands,
+         static_cast<uint64>(elapsed_us == 0 ? 0 : num_bytes / elapsed_us),
+         elapsed_us / 1000.0 / num_iterations,
+         static_cast<uint64>(elapsed_us),
+         GetBitmapSize(&source), GetBitmapSize(&dest));
+}
+
 // main class used for the benchmarking.
 class Benchmark {
  public:
@@ -140,7 +216,9 @@ class Benchmark {
 
   Benchmark()
       : num_iterations_(kDefaultNumberIterations),
-        method_(kDefaultResizeMethod) {}
+        method_(kDefaultResizeMethod),
+        num_bands_(0),
+        run_suite_(false) {}
 
   // Returns true if command line parsing was successful, false otherwise.
   bool ParseArgs(const base::CommandLine* command_line);
@@ -150,8 +228,13 @@ class Benchmark {
 
   static void Usage();
  private:
+  // Runs every method on each of |kSuiteResizes|.
+  void RunSuite() const;
+
   int num_iterations_;
   skia::ImageOperations::ResizeMethod method_;
+  int num_bands_;
+  bool run_suite_;
   Dimensions source_;
   Dimensions dest_;
 };
@@ -163,11 +246,15 @@ const skia::ImageOperations::ResizeMethod Benchmark::kDefaultResizeMethod =
 
 // argument management
 void Benchmark::Usage() {
-  printf("image_operations_bench -source wxh -destination wxh "
-         "[-iterations i] [-method m] [-help]\n"
+  printf("image_operations_bench [-source wxh -destination wxh] "
+         "[-iterations i] [-method m] [-bands b] [-help]\n"
          "  -source wxh: specify source width and height\n"
          "  -destination wxh: specify destination width and height\n"
+         "     without -source and -destination, runs every method on a\n"
+         "     suite of typical resizes\n"
          "  -iter i: perform i iterations (default:%d)\n"
+         "  -bands b: split each resize into b bands resized in parallel\n"
+         "     (default: picked by ImageOperations::Resize)\n"
          "  -method m: use method m (default:%s), which can be:",
          Benchmark::kDefaultNumberIterations,
          MethodToString(Benchmark::kDefaultResizeMethod));
@@ -197,6 +284,11 @@ bool Benchmark::ParseArgs(const base::CommandLine* command_line) {
       if (base::StringToInt(value, &num_iterations_) == false) {
         fNeedHelp = true;
       }
+    } else if (s == "bands") {
+      if (base::StringToInt(value, &num_bands_) == false || num_bands_ < 1) {
+        printf("Invalid number of bands: %s\n", value.c_str());
+        fNeedHelp = true;
+      }
     } else if (s == "method") {
       if (!StringToMethod(value, &method_)) {
         printf("Invalid method '%s' specified\n", value.c_str());
@@ -211,6 +303,11 @@ bool Benchmark::ParseArgs(const base::CommandLine* command_line) {
     printf("Invalid number of iterations: %d\n", num_iterations_);
     fNeedHelp = true;
   }
+  if (switches.find("source") == switches.end() &&
+      switches.find("destination") == switches.end()) {
+    run_suite_ = true;
+    return !fNeedHelp;
+  }
   if (!source_.IsValid()) {
     printf("Invalid source dimensions specified\n");
     fNeedHelp = true;
@@ -227,33 +324,37 @@ bool Benchmark::ParseArgs(const base::CommandLine* command_line) {
 
 // actual benchmark.
 bool Benchmark::Run() const {
-  SkBitmap source;
-  source.allocN32Pixels(source_.width(), source_.height());
-  source.eraseARGB(0, 0, 0, 0);
-
-  SkBitmap dest;
-
-  const base::TimeTicks start = base::TimeTicks::Now();
-
-  for (int i = 0; i < num_iterations_; ++i) {
-    dest = skia::ImageOperations::Resize(source,
-                                         method_,
-                                         dest_.width(), dest_.height());
+  if (run_suite_) {
+    RunSuite();
+    return true;
   }
 
-  const int64 elapsed_us = (base::TimeTicks::Now() - start).InMicroseconds();
-
-  const uint64 num_bytes = static_cast<uint64>(num_iterations_) *
-      (GetBitmapSize(&source) + GetBitmapSize(&dest));
-
-  printf("%" PRIu64 " MB/s,\telapsed = %" PRIu64 " source=%d dest=%d\n",
-         static_cast<uint64>(elapsed_us == 0 ? 0 : num_bytes / elapsed_us),
-         static_cast<uint64>(elapsed_us),
-         GetBitmapSize(&source), GetBitmapSize(&dest));
-
+  TimeResize("resize", source_, dest_, method_, num_bands_, num_iterations_);
   return true;
 }
 
+void Benchmark::RunSuite() const {
+  for (size_t i = 0; i < arraysize(kSuiteResizes); ++i) {
+    const SuiteResize& resize = kSuiteResizes[i];
+    const Dimensions source(resize.source_width, resize.source_height);
+    const Dimensions dest(resize.dest_width, resize.dest_height);
+    const uint64 bytes_per_resize =
+        4 * (static_cast<uint64>(source.width()) * source.height() +
+             static_cast<uint64>(dest.width()) * dest.height());
+    const int num_iterations = static_cast<int>(
+        std::max<uint64>(1, kSuiteBytesPerResize / bytes_per_resize));
+
+    for (size_t j = 0; j < arraysize(resize_methods); ++j) {
+      // Compare the calling thread alone with the default number of bands,
+      // or with the number of bands given on the command line.
+      TimeResize(resize.name, source, dest, resize_methods[j].method, 1,
+                 num_iterations);
+      TimeResize(resize.name, source, dest, resize_methods[j].method,
+                 num_bands_, num_iterations);
+    }
+  }
+}
+
 // A small class to automatically call Reset on the global command line to
 // avoid nasty valgrind complaints for the leak of the global command line.
 class CommandLineAutoReset {
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
@@ -458,6 +460,42 @@ TEST(ImageOperations, HalveSubset) {
   }
 }
 
+// Resizing in bands on worker threads must give exactly the same result as
+// resizing on the calling thread, whether or not the subset starts at the top.
+TEST(ImageOperations, ResizeInBands) {
+  int src_w = 300, src_h = 211;
+  SkBitmap src;
+  FillDataToBitmap(src_w, src_h, &src);
+
+  const skia::ImageOperations::ResizeMethod kMethods[] = {
+    skia::ImageOperations::RESIZE_BOX,
+    skia::ImageOperations::RESIZE_HAMMING1,
+    skia::ImageOperations::RESIZE_LANCZOS3,
+  };
+  const SkIRect kSubsets[] = {
+    { 0, 0, 97, 61 },
+    { 5, 7, 90, 59 },
+  };
+  for (size_t i = 0; i < arraysize(kMethods); ++i) {
+    for (size_t j = 0; j < arraysize(kSubsets); ++j) {
+      SkBitmap expected = skia::ImageOperations::ResizeInBands(
+          src, kMethods[i], 97, 61, kSubsets[j], 1);
+      SkBitmap actual = skia::ImageOperations::ResizeInBands(
+          src, kMethods[i], 97, 61, kSubsets[j], 4);
+      ASSERT_EQ(expected.width(), actual.width());
+      ASSERT_EQ(expected.height(), actual.height());
+
+      SkAutoLockPixels expected_lock(expected);
+      SkAutoLockPixels actual_lock(actual);
+      for (int y = 0; y < expected.height(); ++y) {
+        EXPECT_EQ(0, memcmp(expected.getAddr32(0, y), actual.getAddr32(0, y),
+                            expected.width() * 4))
+            << "method " << kMethods[i] << ", subset " << j << ", row " << y;
+      }
+    }
+  }
+}
+
 TEST(ImageOperations, InvalidParams) {
   // Make our source bitmap.
   SkBitmap src;
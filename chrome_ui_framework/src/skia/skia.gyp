@@ -106,6 +106,40 @@
 
   # targets that are not dependent upon the component type
   'targets': [
+    # The AVX2 convolver has to be built in a separate target, for the same
+    # reasons as the skia_opts_* targets in skia_library_opts.gyp. It is only
+    # called after checking for AVX2 support at runtime.
+    {
+      'target_name': 'skia_chrome_avx2',
+      'type': 'static_library',
+      'includes': [
+        'skia_common.gypi',
+        '../build/android/increase_size_for_speed.gypi',
+      ],
+      'include_dirs': [
+        '../third_party/skia/include/core',
+      ],
+      'conditions': [
+        [ 'OS != "ios" and (target_arch == "ia32" or target_arch == "x64")', {
+          'sources': [
+            'ext/convolver_AVX2.cc',
+          ],
+        }],
+        [ 'OS in ["linux", "freebsd", "openbsd", "solaris", "android"]', {
+          'cflags': [ '-mavx2' ],
+        }],
+        [ 'OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CFLAGS': [ '-mavx2' ],
+          },
+        }],
+        [ 'OS == "win"', {
+          'msvs_settings': {
+            'VCCLCompilerTool': { 'EnableEnhancedInstructionSet': '5' },
+          },
+        }],
+      ],
+    },
     {
       'target_name': 'image_operations_bench',
       'type': 'executable',
@@ -26,6 +26,18 @@ HEADER_LENGTH = 2 * 4 + 1  # Two uint32s. (file version, number of entries) and
                            # one uint8 (encoding of text resources)
 BINARY, UTF8, UTF16 = range(3)
 
+# Version 5 adds a table that maps resource ids directly to index entries.
+# The header grows by a padding byte, the first id covered by the table (a
+# uint16) and the number of table slots (a uint32). The table of uint16 index
+# positions follows the index; NO_ENTRY marks ids that are not in the pack.
+# Packs without a table are still written as version 4.
+PACK_FILE_VERSION_WITH_LOOKUP_TABLE = 5
+HEADER_LENGTH_WITH_LOOKUP_TABLE = HEADER_LENGTH + 1 + 2 + 4
+NO_ENTRY = 0xFFFF
+# Keep in sync with ui/base/resource/data_pack.cc.
+MIN_ENTRIES_FOR_LOOKUP_TABLE = 16
+MAX_LOOKUP_TABLE_SLOTS_PER_ENTRY = 3
+
 
 class WrongFileVersion(Exception):
   pass
@@ -55,7 +67,11 @@ def ReadDataPack(input_file):
 
   # Read the header.
   version, num_entries, encoding = struct.unpack('<IIB', data[:HEADER_LENGTH])
-  if version != PACK_FILE_VERSION:
+  if version == PACK_FILE_VERSION:
+    header_length = HEADER_LENGTH
+  elif version == PACK_FILE_VERSION_WITH_LOOKUP_TABLE:
+    header_length = HEADER_LENGTH_WITH_LOOKUP_TABLE
+  else:
     print 'Wrong file version in ', input_file
     raise WrongFileVersion
 
@@ -63,8 +79,8 @@ def ReadDataPack(input_file):
   if num_entries == 0:
     return DataPackContents(resources, encoding)
 
-  # Read the index and data.
-  data = data[HEADER_LENGTH:]
+  # Read the index and data. The lookup table is not needed for that.
+  data = data[header_length:]
   kIndexEntrySize = 2 + 4  # Each entry is a uint16 and a uint32.
   for _ in range(num_entries):
     id, offset = struct.unpack('<HI', data[:kIndexEntrySize])
@@ -75,27 +91,51 @@ def ReadDataPack(input_file):
   return DataPackContents(resources, encoding)
 
 
+def _LookupTableSize(ids):
+  """Returns the number of lookup table slots to write for the sorted |ids|,
+  or 0 if they are too few or too sparse for a table to pay off."""
+  if len(ids) < MIN_ENTRIES_FOR_LOOKUP_TABLE or len(ids) >= NO_ENTRY:
+    return 0
+  id_range = ids[-1] - ids[0] + 1
+  if id_range > len(ids) * MAX_LOOKUP_TABLE_SLOTS_PER_ENTRY:
+    return 0
+  return id_range
+
+
 def WriteDataPackToString(resources, encoding):
   """Returns a string with a map of id=>data in the data pack format."""
   ids = sorted(resources.keys())
   ret = []
+  lookup_table_size = _LookupTableSize(ids)
 
   # Write file header.
-  ret.append(struct.pack('<IIB', PACK_FILE_VERSION, len(ids), encoding))
-  HEADER_LENGTH = 2 * 4 + 1            # Two uint32s and one uint8.
+  if lookup_table_size:
+    ret.append(struct.pack('<IIBBHI', PACK_FILE_VERSION_WITH_LOOKUP_TABLE,
+                           len(ids), encoding, 0, ids[0], lookup_table_size))
+    header_length = HEADER_LENGTH_WITH_LOOKUP_TABLE
+  else:
+    ret.append(struct.pack('<IIB', PACK_FILE_VERSION, len(ids), encoding))
+    header_length = HEADER_LENGTH
 
   # Each entry is a uint16 + a uint32s. We have one extra entry for the last
   # item.
   index_length = (len(ids) + 1) * (2 + 4)
 
   # Write index.
-  data_offset = HEADER_LENGTH + index_length
+  data_offset = header_length + index_length + lookup_table_size * 2
   for id in ids:
     ret.append(struct.pack('<HI', id, data_offset))
     data_offset += len(resources[id])
 
   ret.append(struct.pack('<HI', 0, data_offset))
 
+  # Write lookup table.
+  if lookup_table_size:
+    lookup_table = [NO_ENTRY] * lookup_table_size
+    for index, id in enumerate(ids):
+      lookup_table[id - ids[0]] = index
+    ret.append(struct.pack('<%dH' % lookup_table_size, *lookup_table))
+
   # Write data.
   for id in ids:
     ret.append(resources[id])
@@ -11,8 +11,10 @@ import sys
 if __name__ == '__main__':
   sys.path.append(os.path.join(os.path.dirname(__file__), '../..'))
 
+import struct
 import unittest
 
+from grit import util
 from grit.format import data_pack
 
 
@@ -32,6 +34,33 @@ class FormatDataPackUnittest(unittest.TestCase):
     output = data_pack.WriteDataPackToString(input, data_pack.UTF8)
     self.failUnless(output == expected)
 
+  def testWriteDataPackWithLookupTable(self):
+    # Ids 10, 12, ..., 40 are compact enough for a lookup table.
+    input = dict((id, 'id %d' % id) for id in range(10, 41, 2))
+    output = data_pack.WriteDataPackToString(input, data_pack.UTF8)
+
+    header = output[:data_pack.HEADER_LENGTH_WITH_LOOKUP_TABLE]
+    version, num_entries, encoding, _, base_id, table_size = struct.unpack(
+        '<IIBBHI', header)
+    self.assertEqual(data_pack.PACK_FILE_VERSION_WITH_LOOKUP_TABLE, version)
+    self.assertEqual(16, num_entries)
+    self.assertEqual(data_pack.UTF8, encoding)
+    self.assertEqual(10, base_id)
+    self.assertEqual(31, table_size)
+
+    table_offset = data_pack.HEADER_LENGTH_WITH_LOOKUP_TABLE + 17 * 6
+    table = struct.unpack('<31H', output[table_offset:table_offset + 62])
+    for id in range(10, 41):
+      if id % 2:
+        self.assertEqual(data_pack.NO_ENTRY, table[id - 10])
+      else:
+        self.assertEqual((id - 10) / 2, table[id - 10])
+
+    # Both versions read back to the same resources.
+    with util.TempDir({'data.pak': output}) as tmp_dir:
+      contents = data_pack.ReadDataPack(tmp_dir.GetPath('data.pak'))
+    self.assertDictEqual(input, contents.resources)
+
   def testRePackUnittest(self):
     expected_with_whitelist = {
         1: 'Never gonna', 10: 'give you up', 20: 'Never gonna let',
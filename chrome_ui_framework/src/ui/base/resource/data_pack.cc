@@ -6,6 +6,9 @@
 
 #include <errno.h>
 
+#include <limits>
+#include <vector>
+
 #include "base/files/file_util.h"
 #include "base/files/memory_mapped_file.h"
 #include "base/logging.h"
@@ -22,6 +25,21 @@ static const uint32 kFileFormatVersion = 4;
 // Length of file header: version, entry count and text encoding type.
 static const size_t kHeaderLength = 2 * sizeof(uint32) + sizeof(uint8);
 
+// Version 5 extends the version 4 header with a padding byte, the first
+// resource id covered by the lookup table and the number of table slots. The
+// table of uint16 index positions follows the index, and kNoEntry marks ids
+// the pack does not contain. Packs without a table are written as version 4.
+static const uint32 kFileFormatVersionWithLookupTable = 5;
+static const size_t kHeaderLengthWithLookupTable =
+    kHeaderLength + sizeof(uint8) + sizeof(uint16) + sizeof(uint32);
+static const uint16 kNoEntry = 0xFFFF;
+
+// A lookup table is only written for packs with at least this many entries,
+// and only if it has at most kMaxLookupTableSlotsPerEntry slots per entry, so
+// that it is never larger than the index itself.
+static const size_t kMinEntriesForLookupTable = 16;
+static const size_t kMaxLookupTableSlotsPerEntry = 3;
+
 #pragma pack(push,2)
 struct DataPackEntry {
   uint16 resource_id;
@@ -65,6 +83,10 @@ namespace ui {
 
 DataPack::DataPack(ui::ScaleFactor scale_factor)
     : resource_count_(0),
+      header_length_(kHeaderLength),
+      lookup_table_(NULL),
+      lookup_table_base_id_(0),
+      lookup_table_size_(0),
       text_encoding_type_(BINARY),
       scale_factor_(scale_factor),
       has_only_material_design_assets_(false) {
@@ -118,9 +140,11 @@ bool DataPack::LoadImpl() {
   // First uint32: version; second: resource count;
   const uint32* ptr = reinterpret_cast<const uint32*>(mmap_->data());
   uint32 version = ptr[0];
-  if (version != kFileFormatVersion) {
+  if (version != kFileFormatVersion &&
+      version != kFileFormatVersionWithLookupTable) {
     LOG(ERROR) << "Bad data pack version: got " << version << ", expected "
-               << kFileFormatVersion;
+               << kFileFormatVersion << " or "
+               << kFileFormatVersionWithLookupTable;
     UMA_HISTOGRAM_ENUMERATION("DataPack.Load", BAD_VERSION,
                               LOAD_ERRORS_COUNT);
     mmap_.reset();
@@ -141,10 +165,38 @@ bool DataPack::LoadImpl() {
     return false;
   }
 
+  header_length_ = kHeaderLength;
+  lookup_table_ = NULL;
+  lookup_table_base_id_ = 0;
+  lookup_table_size_ = 0;
+  if (version == kFileFormatVersionWithLookupTable) {
+    if (kHeaderLengthWithLookupTable > mmap_->length()) {
+      DLOG(ERROR) << "Data pack file corruption: incomplete file header.";
+      UMA_HISTOGRAM_ENUMERATION("DataPack.Load", HEADER_TRUNCATED,
+                                LOAD_ERRORS_COUNT);
+      mmap_.reset();
+      return false;
+    }
+    header_length_ = kHeaderLengthWithLookupTable;
+    const uint8* ptr_lookup = ptr_encoding + 2 * sizeof(uint8);
+    lookup_table_base_id_ = *reinterpret_cast<const uint16*>(ptr_lookup);
+    lookup_table_size_ =
+        *reinterpret_cast<const uint32*>(ptr_lookup + sizeof(uint16));
+    // There is at most one slot per possible resource id.
+    if (lookup_table_size_ > std::numeric_limits<uint16>::max() + 1u) {
+      LOG(ERROR) << "Data pack file corruption: bad lookup table size.";
+      UMA_HISTOGRAM_ENUMERATION("DataPack.Load", INDEX_TRUNCATED,
+                                LOAD_ERRORS_COUNT);
+      mmap_.reset();
+      return false;
+    }
+  }
+
   // Sanity check the file.
   // 1) Check we have enough entries. There's an extra entry after the last item
-  // which gives the length of the last item.
-  if (kHeaderLength + (resource_count_ + 1) * sizeof(DataPackEntry) >
+  // which gives the length of the last item. The lookup table, if any, follows.
+  const size_t index_length = (resource_count_ + 1) * sizeof(DataPackEntry);
+  if (header_length_ + index_length + lookup_table_size_ * sizeof(uint16) >
       mmap_->length()) {
     LOG(ERROR) << "Data pack file corruption: too short for number of "
                   "entries specified.";
@@ -157,7 +209,7 @@ bool DataPack::LoadImpl() {
   // entry after the last item which gives us the length of the last item.
   for (size_t i = 0; i < resource_count_ + 1; ++i) {
     const DataPackEntry* entry = reinterpret_cast<const DataPackEntry*>(
-        mmap_->data() + kHeaderLength + (i * sizeof(DataPackEntry)));
+        mmap_->data() + header_length_ + (i * sizeof(DataPackEntry)));
     if (entry->file_offset > mmap_->length()) {
       LOG(ERROR) << "Entry #" << i << " in data pack points off end of file. "
                  << "Was the file corrupted?";
@@ -168,12 +220,44 @@ bool DataPack::LoadImpl() {
     }
   }
 
+  // The table is validated lazily: FindEntryIndex() checks that the entry it
+  // points at has the requested id, so that loading stays independent of the
+  // table size.
+  if (lookup_table_size_) {
+    lookup_table_ = reinterpret_cast<const uint16*>(
+        mmap_->data() + header_length_ + index_length);
+  }
+
   return true;
 }
 
+int DataPack::FindEntryIndex(uint16 resource_id) const {
+  const DataPackEntry* entries =
+      reinterpret_cast<const DataPackEntry*>(mmap_->data() + header_length_);
+
+  if (lookup_table_) {
+    size_t slot = static_cast<size_t>(resource_id) - lookup_table_base_id_;
+    if (resource_id < lookup_table_base_id_ || slot >= lookup_table_size_)
+      return -1;
+    uint16 index = lookup_table_[slot];
+    if (index == kNoEntry)
+      return -1;
+    if (index >= resource_count_ || entries[index].resource_id != resource_id) {
+      LOG(ERROR) << "Lookup table entry for resource " << resource_id
+                 << " in data pack is invalid. Was the file corrupted?";
+      return -1;
+    }
+    return index;
+  }
+
+  const DataPackEntry* target = reinterpret_cast<const DataPackEntry*>(
+      bsearch(&resource_id, entries, resource_count_, sizeof(DataPackEntry),
+              DataPackEntry::CompareById));
+  return target ? static_cast<int>(target - entries) : -1;
+}
+
 bool DataPack::HasResource(uint16 resource_id) const {
-  return !!bsearch(&resource_id, mmap_->data() + kHeaderLength, resource_count_,
-                   sizeof(DataPackEntry), DataPackEntry::CompareById);
+  return FindEntryIndex(resource_id) != -1;
 }
 
 bool DataPack::GetStringPiece(uint16 resource_id,
@@ -189,20 +273,18 @@ bool DataPack::GetStringPiece(uint16 resource_id,
   #error DataPack assumes little endian
 #endif
 
-  const DataPackEntry* target = reinterpret_cast<const DataPackEntry*>(
-      bsearch(&resource_id, mmap_->data() + kHeaderLength, resource_count_,
-              sizeof(DataPackEntry), DataPackEntry::CompareById));
-  if (!target) {
+  int entry_index = FindEntryIndex(resource_id);
+  if (entry_index == -1) {
     return false;
   }
 
+  const DataPackEntry* target = reinterpret_cast<const DataPackEntry*>(
+      mmap_->data() + header_length_) + entry_index;
   const DataPackEntry* next_entry = target + 1;
   // If the next entry points beyond the end of the file this data pack's entry
   // table is corrupt. Log an error and return false. See
   // http://crbug.com/371301.
   if (next_entry->file_offset > mmap_->length()) {
-    size_t entry_index = target -
-        reinterpret_cast<const DataPackEntry*>(mmap_->data() + kHeaderLength);
     LOG(ERROR) << "Entry #" << entry_index << " in data pack points off end "
                << "of file. This should have been caught when loading. Was the "
                << "file modified?";
@@ -241,7 +323,7 @@ void DataPack::CheckForDuplicateResources(
     const ScopedVector<ResourceHandle>& packs) {
   for (size_t i = 0; i < resource_count_ + 1; ++i) {
     const DataPackEntry* entry = reinterpret_cast<const DataPackEntry*>(
-        mmap_->data() + kHeaderLength + (i * sizeof(DataPackEntry)));
+        mmap_->data() + header_length_ + (i * sizeof(DataPackEntry)));
     const uint16 resource_id = entry->resource_id;
     const float resource_scale = GetScaleForScaleFactor(scale_factor_);
     for (const ResourceHandle* handle : packs) {
@@ -263,11 +345,26 @@ void DataPack::CheckForDuplicateResources(
 bool DataPack::WritePack(const base::FilePath& path,
                          const std::map<uint16, base::StringPiece>& resources,
                          TextEncodingType textEncodingType) {
+  // Decide whether the ids are compact enough for a lookup table.
+  uint16 lookup_table_base_id = 0;
+  uint32 lookup_table_size = 0;
+  if (resources.size() >= kMinEntriesForLookupTable &&
+      resources.size() < kNoEntry) {
+    lookup_table_base_id = resources.begin()->first;
+    size_t id_range = resources.rbegin()->first - lookup_table_base_id + 1;
+    if (id_range <= resources.size() * kMaxLookupTableSlotsPerEntry)
+      lookup_table_size = id_range;
+  }
+  const uint32 version = lookup_table_size ? kFileFormatVersionWithLookupTable
+                                           : kFileFormatVersion;
+  const size_t header_length =
+      lookup_table_size ? kHeaderLengthWithLookupTable : kHeaderLength;
+
   FILE* file = base::OpenFile(path, "wb");
   if (!file)
     return false;
 
-  if (fwrite(&kFileFormatVersion, sizeof(kFileFormatVersion), 1, file) != 1) {
+  if (fwrite(&version, sizeof(version), 1, file) != 1) {
     LOG(ERROR) << "Failed to write file version";
     base::CloseFile(file);
     return false;
@@ -297,10 +394,24 @@ bool DataPack::WritePack(const base::FilePath& path,
     return false;
   }
 
+  if (lookup_table_size) {
+    // The padding byte keeps the index and the table 2-byte aligned.
+    uint8 padding = 0;
+    if (fwrite(&padding, sizeof(padding), 1, file) != 1 ||
+        fwrite(&lookup_table_base_id, sizeof(lookup_table_base_id), 1,
+               file) != 1 ||
+        fwrite(&lookup_table_size, sizeof(lookup_table_size), 1, file) != 1) {
+      LOG(ERROR) << "Failed to write lookup table header";
+      base::CloseFile(file);
+      return false;
+    }
+  }
+
   // Each entry is a uint16 + a uint32. We have an extra entry after the last
   // item so we can compute the size of the list item.
   uint32 index_length = (entry_count + 1) * sizeof(DataPackEntry);
-  uint32 data_offset = kHeaderLength + index_length;
+  uint32 data_offset = header_length + index_length +
+                       lookup_table_size * sizeof(uint16);
   for (std::map<uint16, base::StringPiece>::const_iterator it =
            resources.begin();
        it != resources.end(); ++it) {
@@ -335,6 +446,19 @@ bool DataPack::WritePack(const base::FilePath& path,
     return false;
   }
 
+  if (lookup_table_size) {
+    std::vector<uint16> lookup_table(lookup_table_size, kNoEntry);
+    uint16 index = 0;
+    for (const auto& resource : resources)
+      lookup_table[resource.first - lookup_table_base_id] = index++;
+    if (fwrite(&lookup_table[0], sizeof(uint16), lookup_table.size(), file) !=
+        lookup_table.size()) {
+      LOG(ERROR) << "Failed to write lookup table.";
+      base::CloseFile(file);
+      return false;
+    }
+  }
+
   for (std::map<uint16, base::StringPiece>::const_iterator it =
            resources.begin();
        it != resources.end(); ++it) {
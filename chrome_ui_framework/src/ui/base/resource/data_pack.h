@@ -50,7 +50,8 @@ class UI_BASE_EXPORT DataPack : public ResourceHandle {
   // Writes a pack file containing |resources| to |path|. If there are any
   // text resources to be written, their encoding must already agree to the
   // |textEncodingType| specified. If no text resources are present, please
-  // indicate BINARY.
+  // indicate BINARY. When the resource ids are compact, the pack includes a
+  // table mapping ids directly to index entries, see LoadImpl().
   static bool WritePack(const base::FilePath& path,
                         const std::map<uint16, base::StringPiece>& resources,
                         TextEncodingType textEncodingType);
@@ -75,12 +76,26 @@ class UI_BASE_EXPORT DataPack : public ResourceHandle {
   // Does the actual loading of a pack file. Called by Load and LoadFromFile.
   bool LoadImpl();
 
+  // Returns the position of |resource_id| in the index, or -1 if the pack
+  // does not contain it. Uses the lookup table when there is one, and a
+  // binary search of the index otherwise.
+  int FindEntryIndex(uint16 resource_id) const;
+
   // The memory-mapped data.
   scoped_ptr<base::MemoryMappedFile> mmap_;
 
   // Number of resources in the data.
   size_t resource_count_;
 
+  // Length of the header, which depends on the file format version.
+  size_t header_length_;
+
+  // Direct-index lookup table, or NULL if the pack has none. Slot i holds the
+  // index entry for resource id |lookup_table_base_id_| + i.
+  const uint16* lookup_table_;
+  uint16 lookup_table_base_id_;
+  size_t lookup_table_size_;
+
   // Type of encoding for text resources.
   TextEncodingType text_encoding_type_;
 
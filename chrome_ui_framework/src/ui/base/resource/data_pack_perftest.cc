@@ -0,0 +1,155 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/base/resource/data_pack.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace ui {
+
+namespace {
+
+// Roughly the size of the larger .pak files loaded at startup.
+const int kResourceCount = 4000;
+const uint16 kFirstResourceId = 100;
+
+// Number of resources looked up after loading a pack in the cold start test.
+const int kColdStartLookups = 1000;
+
+const int kColdStartRuns = 200;
+const int kWarmLookupRuns = 200;
+
+// Writes |resources| in the version 4 format, which has no lookup table and
+// is searched with bsearch().
+bool WritePackWithoutLookupTable(
+    const base::FilePath& path,
+    const std::map<uint16, base::StringPiece>& resources) {
+  std::string contents;
+  const uint32 version = 4;
+  const uint32 entry_count = resources.size();
+  const uint8 encoding = DataPack::BINARY;
+  contents.append(reinterpret_cast<const char*>(&version), sizeof(version));
+  contents.append(reinterpret_cast<const char*>(&entry_count),
+                  sizeof(entry_count));
+  contents.append(reinterpret_cast<const char*>(&encoding), sizeof(encoding));
+
+  uint32 data_offset = contents.size() + (entry_count + 1) * 6;
+  for (const auto& resource : resources) {
+    contents.append(reinterpret_cast<const char*>(&resource.first),
+                    sizeof(resource.first));
+    contents.append(reinterpret_cast<const char*>(&data_offset),
+                    sizeof(data_offset));
+    data_offset += resource.second.length();
+  }
+  const uint16 extra_id = 0;
+  contents.append(reinterpret_cast<const char*>(&extra_id), sizeof(extra_id));
+  contents.append(reinterpret_cast<const char*>(&data_offset),
+                  sizeof(data_offset));
+  for (const auto& resource : resources)
+    resource.second.AppendToString(&contents);
+
+  return base::WriteFile(path, contents.data(), contents.size()) ==
+         static_cast<int>(contents.size());
+}
+
+class DataPackPerfTest : public testing::Test {
+ public:
+  DataPackPerfTest() {}
+
+  void SetUp() override {
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    for (int i = 0; i < kResourceCount; ++i)
+      values_.push_back(base::IntToString(i) + std::string(64, 'x'));
+
+    // Grit assigns ids sequentially, with a few holes.
+    std::map<uint16, base::StringPiece> resources;
+    for (int i = 0; i < kResourceCount; ++i) {
+      uint16 id = kFirstResourceId + i + i / 10;
+      resources[id] = values_[i];
+      ids_.push_back(id);
+    }
+    // Look the ids up in an order unrelated to the index.
+    for (size_t i = 0; i < ids_.size(); ++i)
+      std::swap(ids_[i], ids_[(i * 7919) % ids_.size()]);
+
+    table_path_ = dir_.path().AppendASCII("lookup_table.pak");
+    bsearch_path_ = dir_.path().AppendASCII("bsearch.pak");
+    ASSERT_TRUE(DataPack::WritePack(table_path_, resources, DataPack::BINARY));
+    ASSERT_TRUE(WritePackWithoutLookupTable(bsearch_path_, resources));
+  }
+
+  // Times loading a pack and looking up the first |kColdStartLookups| ids.
+  void RunColdStart(const base::FilePath& path, const std::string& trace) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int run = 0; run < kColdStartRuns; ++run) {
+      DataPack pack(SCALE_FACTOR_100P);
+      ASSERT_TRUE(pack.LoadFromPath(path));
+      base::StringPiece data;
+      for (int i = 0; i < kColdStartLookups; ++i)
+        ASSERT_TRUE(pack.GetStringPiece(ids_[i], &data));
+    }
+    perf_test::PrintResult(
+        "data_pack_cold_start", "", trace,
+        (base::TimeTicks::Now() - start).InMillisecondsF() * 1000 /
+            kColdStartRuns,
+        "us", true);
+  }
+
+  // Times HasResource() and GetStringPiece() on a loaded pack.
+  void RunWarmLookups(const base::FilePath& path, const std::string& trace) {
+    DataPack pack(SCALE_FACTOR_100P);
+    ASSERT_TRUE(pack.LoadFromPath(path));
+    base::StringPiece data;
+    size_t total_length = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int run = 0; run < kWarmLookupRuns; ++run) {
+      for (uint16 id : ids_) {
+        if (pack.HasResource(id) && pack.GetStringPiece(id, &data))
+          total_length += data.length();
+      }
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    EXPECT_LT(0u, total_length);
+    perf_test::PrintResult(
+        "data_pack_lookup", "", trace,
+        elapsed.InMillisecondsF() * 1000000 / (kWarmLookupRuns * ids_.size()),
+        "ns/lookup", true);
+  }
+
+ protected:
+  base::ScopedTempDir dir_;
+  std::vector<std::string> values_;
+  std::vector<uint16> ids_;
+  base::FilePath table_path_;
+  base::FilePath bsearch_path_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DataPackPerfTest);
+};
+
+}  // namespace
+
+TEST_F(DataPackPerfTest, ColdStart) {
+  RunColdStart(bsearch_path_, "bsearch");
+  RunColdStart(table_path_, "lookup_table");
+}
+
+TEST_F(DataPackPerfTest, WarmLookups) {
+  RunWarmLookups(bsearch_path_, "bsearch");
+  RunWarmLookups(table_path_, "lookup_table");
+}
+
+}  // namespace ui
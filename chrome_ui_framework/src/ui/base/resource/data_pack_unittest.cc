@@ -7,6 +7,7 @@
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "ui/base/resource/data_pack.h"
@@ -185,6 +186,96 @@ TEST_P(DataPackTest, Write) {
   EXPECT_EQ(fifteen, data);
 }
 
+TEST_P(DataPackTest, WriteWithLookupTable) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  base::FilePath file = dir.path().Append(FILE_PATH_LITERAL("data.pak"));
+
+  // Every other id in [1000, 1198] is present, which is compact enough for a
+  // lookup table.
+  std::vector<std::string> values;
+  for (int i = 0; i < 100; ++i)
+    values.push_back(base::IntToString(1000 + 2 * i));
+  std::map<uint16, base::StringPiece> resources;
+  for (int i = 0; i < 100; ++i)
+    resources[1000 + 2 * i] = values[i];
+  ASSERT_TRUE(DataPack::WritePack(file, resources, GetParam()));
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(file, &contents));
+  EXPECT_EQ(5, contents[0]);
+
+  DataPack pack(SCALE_FACTOR_100P);
+  ASSERT_TRUE(pack.LoadFromPath(file));
+  EXPECT_EQ(pack.GetTextEncodingType(), GetParam());
+
+  base::StringPiece data;
+  for (int i = 0; i < 100; ++i) {
+    uint16 id = 1000 + 2 * i;
+    ASSERT_TRUE(pack.HasResource(id));
+    ASSERT_TRUE(pack.GetStringPiece(id, &data));
+    EXPECT_EQ(values[i], data);
+    // Ids in the gaps and outside the table are missing.
+    EXPECT_FALSE(pack.HasResource(id + 1));
+    EXPECT_FALSE(pack.GetStringPiece(id + 1, &data));
+  }
+  EXPECT_FALSE(pack.HasResource(0));
+  EXPECT_FALSE(pack.HasResource(999));
+  EXPECT_FALSE(pack.HasResource(1200));
+  EXPECT_FALSE(pack.HasResource(65535));
+}
+
+TEST(DataPackTest, SparseIdsWrittenWithoutLookupTable) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  base::FilePath file = dir.path().Append(FILE_PATH_LITERAL("data.pak"));
+
+  std::string value("value");
+  std::map<uint16, base::StringPiece> resources;
+  for (int i = 0; i < 100; ++i)
+    resources[i * 100] = value;
+  ASSERT_TRUE(DataPack::WritePack(file, resources, DataPack::BINARY));
+
+  // Sparse packs keep the version 4 format that older readers understand.
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(file, &contents));
+  EXPECT_EQ(4, contents[0]);
+
+  DataPack pack(SCALE_FACTOR_100P);
+  ASSERT_TRUE(pack.LoadFromPath(file));
+  base::StringPiece data;
+  ASSERT_TRUE(pack.GetStringPiece(9900, &data));
+  EXPECT_EQ(value, data);
+  EXPECT_FALSE(pack.HasResource(9901));
+}
+
+TEST(DataPackTest, CorruptLookupTable) {
+  base::ScopedTempDir dir;
+  ASSERT_TRUE(dir.CreateUniqueTempDir());
+  base::FilePath file = dir.path().Append(FILE_PATH_LITERAL("data.pak"));
+
+  std::string value("value");
+  std::map<uint16, base::StringPiece> resources;
+  for (int i = 0; i < 20; ++i)
+    resources[i] = value;
+  ASSERT_TRUE(DataPack::WritePack(file, resources, DataPack::BINARY));
+
+  // Point the slot of id 0 at the entry of id 1. The header is 16 bytes and
+  // the index has 21 six-byte entries.
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(file, &contents));
+  const size_t kLookupTableOffset = 16 + 21 * 6;
+  contents[kLookupTableOffset] = 1;
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(file, contents.data(), contents.size()));
+
+  DataPack pack(SCALE_FACTOR_100P);
+  ASSERT_TRUE(pack.LoadFromPath(file));
+  base::StringPiece data;
+  EXPECT_FALSE(pack.GetStringPiece(0, &data));
+  EXPECT_TRUE(pack.GetStringPiece(1, &data));
+}
+
 #if defined(OS_POSIX)
 TEST(DataPackTest, ModifiedWhileUsed) {
   base::ScopedTempDir dir;
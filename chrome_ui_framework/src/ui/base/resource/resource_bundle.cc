@@ -4,13 +4,16 @@
 
 #include "ui/base/resource/resource_bundle.h"
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
 #include "base/big_endian.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/files/file.h"
 #include "base/files/file_util.h"
+#include "base/location.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/metrics/histogram.h"
@@ -19,6 +22,8 @@
 #include "base/strings/string_piece.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/worker_pool.h"
+#include "base/time/time.h"
 #include "build/build_config.h"
 #include "skia/ext/image_operations.h"
 #include "third_party/skia/include/core/SkBitmap.h"
@@ -108,6 +113,79 @@ base::FilePath GetResourcesPakFilePath(const std::string& pak_name) {
 
 }  // namespace
 
+// Bitmaps for one resource, decoded ahead of time by PrefetchImages(). The
+// decode runs on a worker thread, or on the first thread that needs the image
+// if no worker has got to it yet. |lock_| is held for the whole decode so that
+// a lookup racing with the worker waits for this image only.
+class ResourceBundle::PrefetchedImage
+    : public base::RefCountedThreadSafe<PrefetchedImage> {
+ public:
+  PrefetchedImage(int resource_id,
+                  const std::vector<ResourceHandle*>& data_packs,
+                  const std::vector<ScaleFactor>& scale_factors)
+      : resource_id_(resource_id),
+        data_packs_(data_packs),
+        scale_factors_(scale_factors),
+        decoded_(false) {}
+
+  // Decodes the bitmaps if that has not been done yet.
+  void Decode() {
+    base::AutoLock lock(lock_);
+    DecodeWithLockAcquired();
+  }
+
+  // Sets |image_rep| to the bitmap decoded for |scale_factor|, decoding first
+  // if needed. Returns false if |scale_factor| was not prefetched or the
+  // bitmap could not be loaded.
+  bool GetImageRep(ScaleFactor scale_factor, gfx::ImageSkiaRep* image_rep) {
+    base::AutoLock lock(lock_);
+    DecodeWithLockAcquired();
+    std::map<ScaleFactor, gfx::ImageSkiaRep>::const_iterator it =
+        image_reps_.find(scale_factor);
+    if (it == image_reps_.end())
+      return false;
+    *image_rep = it->second;
+    return true;
+  }
+
+  // Drops the data packs, which are about to be deleted, waiting for a decode
+  // in progress to finish first.
+  void Cancel() {
+    base::AutoLock lock(lock_);
+    decoded_ = true;
+    data_packs_.clear();
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<PrefetchedImage>;
+
+  ~PrefetchedImage() {}
+
+  void DecodeWithLockAcquired() {
+    lock_.AssertAcquired();
+    if (decoded_)
+      return;
+    decoded_ = true;
+    for (ScaleFactor scale_factor : scale_factors_) {
+      gfx::ImageSkiaRep image_rep = LoadImageSkiaRep(
+          data_packs_, resource_id_, GetScaleForScaleFactor(scale_factor));
+      if (!image_rep.is_null())
+        image_reps_[scale_factor] = image_rep;
+    }
+    data_packs_.clear();
+  }
+
+  const int resource_id_;
+  std::vector<ResourceHandle*> data_packs_;
+  const std::vector<ScaleFactor> scale_factors_;
+
+  base::Lock lock_;
+  bool decoded_;
+  std::map<ScaleFactor, gfx::ImageSkiaRep> image_reps_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefetchedImage);
+};
+
 // An ImageSkiaSource that loads bitmaps for the requested scale factor from
 // ResourceBundle on demand for a given |resource_id|. If the bitmap for the
 // requested scale factor does not exist, it will return the 1x bitmap scaled
@@ -115,44 +193,34 @@ base::FilePath GetResourcesPakFilePath(const std::string& pak_name) {
 // scaled image is not exactly |scale_factor| * the size of the 1x resource.
 // When --highlight-missing-scaled-resources flag is specified, scaled 1x images
 // are higlighted by blending them with red.
+// Bitmaps already decoded by |prefetched_image|, if any, are used first.
 class ResourceBundle::ResourceBundleImageSource : public gfx::ImageSkiaSource {
  public:
-  ResourceBundleImageSource(ResourceBundle* rb, int resource_id)
-      : rb_(rb), resource_id_(resource_id) {}
+  ResourceBundleImageSource(
+      ResourceBundle* rb,
+      int resource_id,
+      const scoped_refptr<PrefetchedImage>& prefetched_image)
+      : rb_(rb),
+        resource_id_(resource_id),
+        prefetched_image_(prefetched_image) {}
   ~ResourceBundleImageSource() override {}
 
   // gfx::ImageSkiaSource overrides:
   gfx::ImageSkiaRep GetImageForScale(float scale) override {
-    SkBitmap image;
-    bool fell_back_to_1x = false;
+    gfx::ImageSkiaRep image_rep;
     ScaleFactor scale_factor = GetSupportedScaleFactor(scale);
-    bool found = rb_->LoadBitmap(resource_id_, &scale_factor,
-                                 &image, &fell_back_to_1x);
-    if (!found)
-      return gfx::ImageSkiaRep();
-
-    // If the resource is in the package with SCALE_FACTOR_NONE, it
-    // can be used in any scale factor. The image is maked as "unscaled"
-    // so that the ImageSkia do not automatically scale.
-    if (scale_factor == ui::SCALE_FACTOR_NONE)
-      return gfx::ImageSkiaRep(image, 0.0f);
-
-    if (fell_back_to_1x) {
-      // GRIT fell back to the 100% image, so rescale it to the correct size.
-      image = skia::ImageOperations::Resize(
-          image,
-          skia::ImageOperations::RESIZE_LANCZOS3,
-          gfx::ToCeiledInt(image.width() * scale),
-          gfx::ToCeiledInt(image.height() * scale));
-    } else {
-      scale = GetScaleForScaleFactor(scale_factor);
+    if (prefetched_image_.get() &&
+        GetScaleForScaleFactor(scale_factor) == scale &&
+        prefetched_image_->GetImageRep(scale_factor, &image_rep)) {
+      return image_rep;
     }
-    return gfx::ImageSkiaRep(image, scale);
+    return LoadImageSkiaRep(rb_->data_packs_.get(), resource_id_, scale);
   }
 
  private:
   ResourceBundle* rb_;
   const int resource_id_;
+  scoped_refptr<PrefetchedImage> prefetched_image_;
 
   DISALLOW_COPY_AND_ASSIGN(ResourceBundleImageSource);
 };
@@ -373,11 +441,15 @@ gfx::ImageSkia* ResourceBundle::GetImageSkiaNamed(int resource_id) {
 }
 
 gfx::Image& ResourceBundle::GetImageNamed(int resource_id) {
-  // Check to see if the image is already in the cache.
+  // Check to see if the image is already in the cache, or being prefetched.
+  scoped_refptr<PrefetchedImage> prefetched_image;
   {
     base::AutoLock lock_scope(*images_and_fonts_lock_);
     if (images_.count(resource_id))
       return images_[resource_id];
+    PrefetchedImageMap::iterator it = prefetched_images_.find(resource_id);
+    if (it != prefetched_images_.end())
+      prefetched_image = it->second;
   }
 
   gfx::Image image;
@@ -399,10 +471,15 @@ gfx::Image& ResourceBundle::GetImageNamed(int resource_id) {
     // ResourceBundle::GetSharedInstance() is destroyed after the
     // BrowserMainLoop has finished running. |image_skia| is guaranteed to be
     // destroyed before the resource bundle is destroyed.
-    gfx::ImageSkia image_skia(new ResourceBundleImageSource(this, resource_id),
-                              GetScaleForScaleFactor(scale_factor_to_load));
+    gfx::ImageSkia image_skia(
+        new ResourceBundleImageSource(this, resource_id, prefetched_image),
+        GetScaleForScaleFactor(scale_factor_to_load));
     if (image_skia.isNull()) {
       LOG(WARNING) << "Unable to load image with id " << resource_id;
+      {
+        base::AutoLock lock_scope(*images_and_fonts_lock_);
+        prefetched_images_.erase(resource_id);
+      }
       NOTREACHED();  // Want to assert in debug mode.
       // The load failed to retrieve the image; show a debugging red square.
       return GetEmptyImage();
@@ -413,6 +490,7 @@ gfx::Image& ResourceBundle::GetImageNamed(int resource_id) {
 
   // The load was successful, so cache the image.
   base::AutoLock lock_scope(*images_and_fonts_lock_);
+  prefetched_images_.erase(resource_id);
 
   // Another thread raced the load and has already cached the image.
   if (images_.count(resource_id))
@@ -422,6 +500,36 @@ gfx::Image& ResourceBundle::GetImageNamed(int resource_id) {
   return images_[resource_id];
 }
 
+void ResourceBundle::PrefetchImages(const std::vector<int>& resource_ids) {
+  DCHECK(!data_packs_.empty()) <<
+      "Missing call to SetResourcesDataDLL?";
+  const std::vector<ScaleFactor>& scale_factors = GetSupportedScaleFactors();
+
+  base::AutoLock lock_scope(*images_and_fonts_lock_);
+  for (int resource_id : resource_ids) {
+    if (images_.count(resource_id) || prefetched_images_.count(resource_id))
+      continue;
+    // An id that is in none of the packs would never be looked up, and
+    // would stay in |prefetched_images_|.
+    if (!std::any_of(data_packs_.begin(), data_packs_.end(),
+                     [resource_id](const ResourceHandle* data_pack) {
+                       return data_pack->HasResource(
+                           static_cast<uint16>(resource_id));
+                     })) {
+      continue;
+    }
+    // The workers decode from a copy of |data_packs_|, so packs added later
+    // are not searched. The packs themselves are never removed before
+    // FreeImages().
+    scoped_refptr<PrefetchedImage> prefetched_image(
+        new PrefetchedImage(resource_id, data_packs_.get(), scale_factors));
+    prefetched_images_[resource_id] = prefetched_image;
+    base::WorkerPool::PostTask(
+        FROM_HERE, base::Bind(&PrefetchedImage::Decode, prefetched_image),
+        false);
+  }
+}
+
 gfx::Image& ResourceBundle::GetNativeImageNamed(int resource_id) {
   return GetNativeImageNamed(resource_id, RTL_DISABLED);
 }
@@ -654,6 +762,16 @@ void ResourceBundle::InitSharedInstance(Delegate* delegate) {
 }
 
 void ResourceBundle::FreeImages() {
+  // Wait for decodes in progress, since they read from |data_packs_|, and stop
+  // the ones that have not started yet.
+  PrefetchedImageMap prefetched_images;
+  {
+    base::AutoLock lock_scope(*images_and_fonts_lock_);
+    prefetched_images.swap(prefetched_images_);
+  }
+  for (const auto& prefetched_image : prefetched_images)
+    prefetched_image.second->Cancel();
+
   images_.clear();
 }
 
@@ -814,10 +932,11 @@ scoped_ptr<gfx::FontList> ResourceBundle::GetFontListFromDelegate(
   return nullptr;
 }
 
+// static
 bool ResourceBundle::LoadBitmap(const ResourceHandle& data_handle,
                                 int resource_id,
                                 SkBitmap* bitmap,
-                                bool* fell_back_to_1x) const {
+                                bool* fell_back_to_1x) {
   DCHECK(fell_back_to_1x);
   scoped_refptr<base::RefCountedMemory> memory(
       data_handle.GetStaticMemory(static_cast<uint16>(resource_id)));
@@ -843,26 +962,62 @@ bool ResourceBundle::LoadBitmap(const ResourceHandle& data_handle,
   return false;
 }
 
-bool ResourceBundle::LoadBitmap(int resource_id,
+// static
+bool ResourceBundle::LoadBitmap(const std::vector<ResourceHandle*>& data_packs,
+                                int resource_id,
                                 ScaleFactor* scale_factor,
                                 SkBitmap* bitmap,
-                                bool* fell_back_to_1x) const {
+                                bool* fell_back_to_1x) {
   DCHECK(fell_back_to_1x);
-  for (size_t i = 0; i < data_packs_.size(); ++i) {
-    if (data_packs_[i]->GetScaleFactor() == ui::SCALE_FACTOR_NONE &&
-        LoadBitmap(*data_packs_[i], resource_id, bitmap, fell_back_to_1x)) {
+  for (size_t i = 0; i < data_packs.size(); ++i) {
+    if (data_packs[i]->GetScaleFactor() == ui::SCALE_FACTOR_NONE &&
+        LoadBitmap(*data_packs[i], resource_id, bitmap, fell_back_to_1x)) {
       DCHECK(!*fell_back_to_1x);
       *scale_factor = ui::SCALE_FACTOR_NONE;
       return true;
     }
-    if (data_packs_[i]->GetScaleFactor() == *scale_factor &&
-        LoadBitmap(*data_packs_[i], resource_id, bitmap, fell_back_to_1x)) {
+    if (data_packs[i]->GetScaleFactor() == *scale_factor &&
+        LoadBitmap(*data_packs[i], resource_id, bitmap, fell_back_to_1x)) {
       return true;
     }
   }
   return false;
 }
 
+// static
+gfx::ImageSkiaRep ResourceBundle::LoadImageSkiaRep(
+    const std::vector<ResourceHandle*>& data_packs,
+    int resource_id,
+    float scale) {
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  SkBitmap image;
+  bool fell_back_to_1x = false;
+  ScaleFactor scale_factor = GetSupportedScaleFactor(scale);
+  bool found = LoadBitmap(data_packs, resource_id, &scale_factor,
+                          &image, &fell_back_to_1x);
+  if (!found)
+    return gfx::ImageSkiaRep();
+
+  // If the resource is in the package with SCALE_FACTOR_NONE, it
+  // can be used in any scale factor. The image is maked as "unscaled"
+  // so that the ImageSkia do not automatically scale.
+  if (scale_factor == ui::SCALE_FACTOR_NONE) {
+    scale = 0.0f;
+  } else if (fell_back_to_1x) {
+    // GRIT fell back to the 100% image, so rescale it to the correct size.
+    image = skia::ImageOperations::Resize(
+        image,
+        skia::ImageOperations::RESIZE_LANCZOS3,
+        gfx::ToCeiledInt(image.width() * scale),
+        gfx::ToCeiledInt(image.height() * scale));
+  } else {
+    scale = GetScaleForScaleFactor(scale_factor);
+  }
+  UMA_HISTOGRAM_TIMES("ResourceBundle.ImageDecodeTime",
+                      base::TimeTicks::Now() - start_time);
+  return gfx::ImageSkiaRep(image, scale);
+}
+
 gfx::Image& ResourceBundle::GetEmptyImage() {
   base::AutoLock lock(*images_and_fonts_lock_);
 
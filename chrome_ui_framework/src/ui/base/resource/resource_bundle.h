@@ -7,12 +7,14 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/containers/hash_tables.h"
 #include "base/files/file_path.h"
 #include "base/files/memory_mapped_file.h"
 #include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/scoped_vector.h"
 #include "base/strings/string16.h"
@@ -32,6 +34,10 @@ class Lock;
 class RefCountedStaticMemory;
 }
 
+namespace gfx {
+class ImageSkiaRep;
+}
+
 namespace ui {
 
 class DataPack;
@@ -210,6 +216,14 @@ class UI_BASE_EXPORT ResourceBundle {
   // image in Skia format by default. The ResourceBundle owns this.
   gfx::Image& GetImageNamed(int resource_id);
 
+  // Starts decoding the images for |resource_ids| on worker threads, at each
+  // supported scale factor, so that a later GetImageNamed() does not have to.
+  // If GetImageNamed() is called while one of the images is still being
+  // decoded, it waits for that image only. Ids that are already cached, being
+  // prefetched or in none of the data packs are ignored. Images provided by
+  // the delegate are not affected.
+  void PrefetchImages(const std::vector<int>& resource_ids);
+
   // Similar to GetImageNamed, but rather than loading the image in Skia format,
   // it will load in the native platform type. This can avoid conversion from
   // one image type to another. ResourceBundle owns the result.
@@ -302,6 +316,8 @@ class UI_BASE_EXPORT ResourceBundle {
   class ResourceBundleImageSource;
   friend class ResourceBundleImageSource;
 
+  class PrefetchedImage;
+
   typedef base::hash_map<int, base::string16> IdToStringMap;
 
   // Ctor/dtor are private, since we're a singleton.
@@ -311,7 +327,7 @@ class UI_BASE_EXPORT ResourceBundle {
   // Shared initialization.
   static void InitSharedInstance(Delegate* delegate);
 
-  // Free skia_images_.
+  // Free skia_images_, and stop any image prefetches still pending.
   void FreeImages();
 
   // Load the main resources.
@@ -364,19 +380,29 @@ class UI_BASE_EXPORT ResourceBundle {
   //
   // If the call succeeds, |fell_back_to_1x| indicates whether Chrome's custom
   // csCl PNG chunk is present (added by GRIT if it falls back to a 100% image).
-  bool LoadBitmap(const ResourceHandle& data_handle,
-                  int resource_id,
-                  SkBitmap* bitmap,
-                  bool* fell_back_to_1x) const;
-
-  // Fills the |bitmap| given the |resource_id| and |scale_factor|.
-  // Returns false if the resource does not exist. This may fall back to
-  // the data pack with SCALE_FACTOR_NONE, and when this happens,
-  // |scale_factor| will be set to SCALE_FACTOR_100P.
-  bool LoadBitmap(int resource_id,
-                  ScaleFactor* scale_factor,
-                  SkBitmap* bitmap,
-                  bool* fell_back_to_1x) const;
+  static bool LoadBitmap(const ResourceHandle& data_handle,
+                         int resource_id,
+                         SkBitmap* bitmap,
+                         bool* fell_back_to_1x);
+
+  // Fills the |bitmap| given the |resource_id| and |scale_factor|, searching
+  // |data_packs| in order. Returns false if the resource does not exist. This
+  // may fall back to the data pack with SCALE_FACTOR_NONE, and when this
+  // happens, |scale_factor| will be set to SCALE_FACTOR_NONE.
+  static bool LoadBitmap(const std::vector<ResourceHandle*>& data_packs,
+                         int resource_id,
+                         ScaleFactor* scale_factor,
+                         SkBitmap* bitmap,
+                         bool* fell_back_to_1x);
+
+  // Decodes the bitmap for |resource_id| at |scale| from |data_packs|,
+  // rescaling the 1x bitmap if GRIT fell back to it. Returns a null rep if the
+  // resource does not exist. Safe to call on any thread as long as the data
+  // packs outlive the call.
+  static gfx::ImageSkiaRep LoadImageSkiaRep(
+      const std::vector<ResourceHandle*>& data_packs,
+      int resource_id,
+      float scale);
 
   // Returns true if missing scaled resources should be visually indicated when
   // drawing the fallback (e.g., by tinting the image).
@@ -423,6 +449,11 @@ class UI_BASE_EXPORT ResourceBundle {
   typedef std::map<int, gfx::Image> ImageMap;
   ImageMap images_;
 
+  // Images started by PrefetchImages() that have not been moved to |images_|
+  // yet. Protected by |images_and_fonts_lock_|.
+  typedef std::map<int, scoped_refptr<PrefetchedImage>> PrefetchedImageMap;
+  PrefetchedImageMap prefetched_images_;
+
   gfx::Image empty_image_;
 
   // The various font lists used. Cached to avoid repeated GDI
@@ -12,6 +12,7 @@
 #include "base/logging.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/skia/include/core/SkBitmap.h"
@@ -435,6 +436,14 @@ class ResourceBundleImageTest : public ResourceBundleTest {
     return resource_bundle->data_packs_.size();
   }
 
+  // Returns the number of images that |resource_bundle| is prefetching and
+  // has not cached yet.
+  size_t NumPrefetchedImagesInResourceBundle(ResourceBundle* resource_bundle) {
+    DCHECK(resource_bundle);
+    base::AutoLock lock_scope(*resource_bundle->images_and_fonts_lock_);
+    return resource_bundle->prefetched_images_.size();
+  }
+
   // Returns the number of DataPacks managed by |resource_bundle| which are
   // flagged as containing only material design resources.
   size_t NumMaterialDesignDataPacksInResourceBundle(
@@ -571,6 +580,75 @@ TEST_F(ResourceBundleImageTest, GetImageNamed) {
   EXPECT_EQ(1.4f, image_skia->GetRepresentation(1.4f).scale());
 }
 
+// Verifies that PrefetchImages() decodes the image at every supported scale
+// factor and that GetImageNamed() returns the prefetched bitmaps.
+TEST_F(ResourceBundleImageTest, PrefetchImages) {
+  std::vector<ScaleFactor> supported_factors;
+  supported_factors.push_back(SCALE_FACTOR_100P);
+  supported_factors.push_back(SCALE_FACTOR_200P);
+  test::ScopedSetSupportedScaleFactors scoped_supported(supported_factors);
+  base::FilePath data_1x_path = dir_path().AppendASCII("sample_1x.pak");
+  base::FilePath data_2x_path = dir_path().AppendASCII("sample_2x.pak");
+  CreateDataPackWithSingleBitmap(data_1x_path, 10, base::StringPiece());
+  CreateDataPackWithSingleBitmap(data_2x_path, 20, base::StringPiece());
+
+  ResourceBundle* resource_bundle = CreateResourceBundleWithEmptyLocalePak();
+  resource_bundle->AddDataPackFromPath(data_1x_path, SCALE_FACTOR_100P);
+  resource_bundle->AddDataPackFromPath(data_2x_path, SCALE_FACTOR_200P);
+
+  // Resource ID 4 does not exist; prefetching it is harmless.
+  std::vector<int> resource_ids;
+  resource_ids.push_back(3);
+  resource_ids.push_back(4);
+  resource_bundle->PrefetchImages(resource_ids);
+
+  gfx::ImageSkia* image_skia = resource_bundle->GetImageSkiaNamed(3);
+  gfx::ImageSkiaRep image_rep = image_skia->GetRepresentation(1.0f);
+  EXPECT_EQ(1.0f, image_rep.scale());
+  EXPECT_EQ(10, image_rep.pixel_width());
+  image_rep = image_skia->GetRepresentation(2.0f);
+  EXPECT_EQ(2.0f, image_rep.scale());
+  EXPECT_EQ(20, image_rep.pixel_width());
+
+  // Prefetching an image that is already cached does not replace it.
+  resource_bundle->PrefetchImages(resource_ids);
+  EXPECT_EQ(image_skia, resource_bundle->GetImageSkiaNamed(3));
+}
+
+// Verifies that ids missing from the data packs are not kept as prefetched
+// images, and that looking an image up moves it out of the prefetched images.
+TEST_F(ResourceBundleImageTest, PrefetchMissingImages) {
+  base::FilePath data_path = dir_path().AppendASCII("sample.pak");
+  CreateDataPackWithSingleBitmap(data_path, 10, base::StringPiece());
+
+  ResourceBundle* resource_bundle = CreateResourceBundleWithEmptyLocalePak();
+  resource_bundle->AddDataPackFromPath(data_path, SCALE_FACTOR_100P);
+
+  // Resource ID 3 exists, 4 and 5 do not.
+  std::vector<int> resource_ids;
+  resource_ids.push_back(3);
+  resource_ids.push_back(4);
+  resource_ids.push_back(5);
+  resource_bundle->PrefetchImages(resource_ids);
+  EXPECT_EQ(1u, NumPrefetchedImagesInResourceBundle(resource_bundle));
+
+  resource_bundle->GetImageSkiaNamed(3);
+  EXPECT_EQ(0u, NumPrefetchedImagesInResourceBundle(resource_bundle));
+}
+
+// Verifies that the ResourceBundle can be deleted while images are still being
+// prefetched.
+TEST_F(ResourceBundleImageTest, DeleteWithPendingPrefetch) {
+  base::FilePath data_path = dir_path().AppendASCII("sample.pak");
+  CreateDataPackWithSingleBitmap(data_path, 10, base::StringPiece());
+
+  ResourceBundle* resource_bundle = CreateResourceBundleWithEmptyLocalePak();
+  resource_bundle->AddDataPackFromPath(data_path, SCALE_FACTOR_100P);
+  resource_bundle->PrefetchImages(std::vector<int>(1, 3));
+
+  // TearDown() deletes |resource_bundle| without looking up the image.
+}
+
 // Verifies that the correct number of DataPacks managed by ResourceBundle
 // are flagged as containing only material design assets.
 TEST_F(ResourceBundleImageTest, CountMaterialDesignDataPacksInResourceBundle) {
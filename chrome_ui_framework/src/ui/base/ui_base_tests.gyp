@@ -241,6 +241,22 @@
         }],
       ],
     },
+    {
+      # GN version: //ui/base:ui_base_perftests
+      'target_name': 'ui_base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        '../../base/base.gyp:base',
+        '../../base/base.gyp:test_support_base',
+        '../../base/base.gyp:test_support_perf',
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        'ui_base.gyp:ui_base',
+      ],
+      'sources': [
+        'resource/data_pack_perftest.cc',
+      ],
+    },
   ],
   'conditions': [
     # Mac target to build a test Framework bundle to mock out resource loading.
@@ -11,6 +11,7 @@
 #include "base/command_line.h"
 #include "base/message_loop/message_loop.h"
 #include "base/metrics/histogram.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/sys_info.h"
 #include "base/trace_event/trace_event.h"
@@ -140,6 +141,19 @@ Compositor::Compositor(ui::ContextFactory* context_factory,
   settings.renderer_settings.use_rgba_4444_textures =
       command_line->HasSwitch(switches::kUIEnableRGBA4444Textures);
 
+  if (command_line->HasSwitch(switches::kUISoftwareRendererBandCount)) {
+    std::string band_count_string = command_line->GetSwitchValueASCII(
+        switches::kUISoftwareRendererBandCount);
+    int band_count = 0;
+    if (base::StringToInt(band_count_string, &band_count) &&
+        band_count >= 1) {
+      settings.renderer_settings.software_renderer_band_count = band_count;
+    } else {
+      LOG(WARNING) << "Invalid software renderer band count: "
+                   << band_count_string;
+    }
+  }
+
   // UI compositor always uses partial raster if not using zero-copy. Zero copy
   // doesn't currently support partial raster.
   settings.use_partial_raster = !settings.use_zero_copy;
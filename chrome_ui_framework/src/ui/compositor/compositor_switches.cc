@@ -27,6 +27,10 @@ const char kUIEnableZeroCopy[] = "ui-enable-zero-copy";
 
 const char kUIShowPaintRects[] = "ui-show-paint-rects";
 
+// Number of horizontal bands that the software compositor splits each frame
+// into, to draw them in parallel on the raster worker threads.
+const char kUISoftwareRendererBandCount[] = "ui-software-renderer-band-count";
+
 }  // namespace switches
 
 namespace ui {
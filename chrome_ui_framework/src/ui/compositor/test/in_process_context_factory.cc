@@ -150,7 +150,8 @@ void InProcessContextFactory::CreateOutputSurface(
         new cc::OnscreenDisplayClient(
             real_output_surface.Pass(), surface_manager_,
             GetSharedBitmapManager(), GetGpuMemoryBufferManager(),
-            compositor->GetRendererSettings(), compositor->task_runner()));
+            compositor->GetRendererSettings(), GetTaskGraphRunner(),
+            compositor->task_runner()));
     scoped_ptr<cc::SurfaceDisplayOutputSurface> surface_output_surface(
         new cc::SurfaceDisplayOutputSurface(
             surface_manager_, compositor->surface_id_allocator(),
@@ -4,6 +4,9 @@
 
 #include "ui/gfx/codec/png_codec.h"
 
+#include <algorithm>
+
+#include "base/files/file.h"
 #include "base/logging.h"
 #include "base/strings/string_util.h"
 #include "third_party/libpng/png.h"
@@ -83,10 +86,13 @@ class PngDecoderState {
       : output_format(ofmt),
         output_channels(0),
         bitmap(NULL),
+        reuse_bitmap_pixels(false),
+        scale_denominator(1),
         is_opaque(true),
         output(o),
         width(0),
         height(0),
+        interlaced(false),
         done(false) {
   }
 
@@ -95,10 +101,13 @@ class PngDecoderState {
       : output_format(PNGCodec::FORMAT_SkBitmap),
         output_channels(0),
         bitmap(skbitmap),
+        reuse_bitmap_pixels(false),
+        scale_denominator(1),
         is_opaque(true),
         output(NULL),
         width(0),
         height(0),
+        interlaced(false),
         done(false) {
   }
 
@@ -108,6 +117,22 @@ class PngDecoderState {
   // An incoming SkBitmap to write to. If NULL, we write to output instead.
   SkBitmap* bitmap;
 
+  // Whether pixels that |bitmap| already has are decoded into, when they have
+  // the right size and format, instead of allocating new ones.
+  bool reuse_bitmap_pixels;
+
+  // The image is shrunk by this factor in both dimensions while decoding into
+  // |bitmap|.
+  int scale_denominator;
+
+  // Per channel sums of the pixels of the block of rows being shrunk, one
+  // entry per channel of an output row.
+  std::vector<uint32_t> scaled_row_sums;
+
+  // Full size copy of an interlaced image that is being shrunk, as its rows
+  // only become final with the last pass.
+  std::vector<unsigned char> interlaced_rows;
+
   // Used during the reading of an SkBitmap. Defaults to true until we see a
   // pixel with anything other than an alpha of 255.
   bool is_opaque;
@@ -119,6 +144,7 @@ class PngDecoderState {
   // Size of the image, set in the info callback.
   int width;
   int height;
+  bool interlaced;
 
   // Set to true when we've found the end of the data.
   bool done;
@@ -153,6 +179,61 @@ void ConvertRGBARowToSkia(png_structp png_ptr,
   }
 }
 
+// Makes |state->bitmap| ready to receive the decoded image, shrunk by the
+// scale denominator.
+void PrepareOutputBitmap(PngDecoderState* state) {
+  const int scale = state->scale_denominator;
+  const int output_width = (state->width + scale - 1) / scale;
+  const int output_height = (state->height + scale - 1) / scale;
+
+  SkBitmap* bitmap = state->bitmap;
+  if (!state->reuse_bitmap_pixels || !bitmap->getPixels() ||
+      bitmap->width() != output_width || bitmap->height() != output_height ||
+      bitmap->colorType() != kN32_SkColorType) {
+    bitmap->allocN32Pixels(output_width, output_height);
+  }
+
+  if (scale > 1) {
+    state->scaled_row_sums.assign(output_width * 4, 0);
+    if (state->interlaced)
+      state->interlaced_rows.resize(state->width * 4 * state->height);
+  }
+}
+
+// Adds a decoded row of Skia pixels to the sums of the block of rows it is
+// part of, and writes out the averages once the last row of the block is in.
+// Rows must be added in order.
+void AddRowToScaledBitmap(PngDecoderState* state,
+                          const unsigned char* row,
+                          int row_num) {
+  const int scale = state->scale_denominator;
+  uint32_t* sums = &state->scaled_row_sums[0];
+  for (int x = 0; x < state->width; x++) {
+    uint32_t* sum = &sums[(x / scale) * 4];
+    const unsigned char* pixel = &row[x * 4];
+    sum[0] += pixel[0];
+    sum[1] += pixel[1];
+    sum[2] += pixel[2];
+    sum[3] += pixel[3];
+  }
+  if ((row_num + 1) % scale != 0 && row_num + 1 != state->height)
+    return;
+
+  // Averaging premultiplied channels keeps them premultiplied, since no color
+  // sum can exceed the alpha sum.
+  const int output_y = row_num / scale;
+  const int block_height = row_num + 1 - output_y * scale;
+  unsigned char* dest =
+      reinterpret_cast<unsigned char*>(state->bitmap->getAddr32(0, output_y));
+  for (int output_x = 0; output_x < state->bitmap->width(); output_x++) {
+    const int block_width = std::min(scale, state->width - output_x * scale);
+    const uint32_t count = block_width * block_height;
+    for (int i = output_x * 4; i < output_x * 4 + 4; i++)
+      dest[i] = static_cast<unsigned char>((sums[i] + count / 2) / count);
+  }
+  std::fill(state->scaled_row_sums.begin(), state->scaled_row_sums.end(), 0);
+}
+
 // Called when the png header has been read. This code is based on the WebKit
 // PNGImageDecoder
 void DecodeInfoCallback(png_struct* png_ptr, png_info* info_ptr) {
@@ -265,13 +346,15 @@ void DecodeInfoCallback(png_struct* png_ptr, png_info* info_ptr) {
   }
 
   // Tell libpng to send us rows for interlaced pngs.
-  if (interlace_type == PNG_INTERLACE_ADAM7)
+  if (interlace_type == PNG_INTERLACE_ADAM7) {
+    state->interlaced = true;
     png_set_interlace_handling(png_ptr);
+  }
 
   png_read_update_info(png_ptr, info_ptr);
 
   if (state->bitmap) {
-    state->bitmap->allocN32Pixels(state->width, state->height);
+    PrepareOutputBitmap(state);
   } else if (state->output) {
     state->output->resize(
         state->width * state->output_channels * state->height);
@@ -291,13 +374,26 @@ void DecodeRowCallback(png_struct* png_ptr, png_byte* new_row,
     return;
   }
 
-  unsigned char* base = NULL;
-  if (state->bitmap)
-    base = reinterpret_cast<unsigned char*>(state->bitmap->getAddr32(0, 0));
-  else if (state->output)
-    base = &state->output->front();
+  if (state->scale_denominator > 1) {
+    if (state->interlaced) {
+      png_progressive_combine_row(
+          png_ptr, &state->interlaced_rows[state->width * 4 * row_num],
+          new_row);
+    } else {
+      AddRowToScaledBitmap(state, new_row, row_num);
+    }
+    return;
+  }
 
-  unsigned char* dest = &base[state->width * state->output_channels * row_num];
+  // The bitmap may have padded rows when it was supplied by the caller.
+  unsigned char* dest = NULL;
+  if (state->bitmap) {
+    dest = reinterpret_cast<unsigned char*>(
+        state->bitmap->getAddr32(0, row_num));
+  } else if (state->output) {
+    dest = &state->output->front() +
+           state->width * state->output_channels * row_num;
+  }
   png_progressive_combine_row(png_ptr, dest, new_row);
 }
 
@@ -305,6 +401,14 @@ void DecodeEndCallback(png_struct* png_ptr, png_info* info) {
   PngDecoderState* state = static_cast<PngDecoderState*>(
       png_get_progressive_ptr(png_ptr));
 
+  // Interlaced rows that are shrunk are only final now.
+  if (!state->interlaced_rows.empty()) {
+    for (int y = 0; y < state->height; y++)
+      AddRowToScaledBitmap(state, &state->interlaced_rows[state->width * 4 * y],
+                           y);
+    std::vector<unsigned char>().swap(state->interlaced_rows);
+  }
+
   // Mark the image as complete, this will tell the Decode function that we
   // have successfully found the end of the data.
   state->done = true;
@@ -464,6 +568,109 @@ bool PNGCodec::Decode(const unsigned char* input, size_t input_size,
   return true;
 }
 
+// PNGStreamingDecoder --------------------------------------------------------
+
+class PNGStreamingDecoder::State {
+ public:
+  explicit State(SkBitmap* bitmap)
+      : png_ptr(NULL), info_ptr(NULL), decoder_state(bitmap) {}
+  ~State() {
+    if (png_ptr)
+      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+  }
+
+  png_struct* png_ptr;
+  png_info* info_ptr;
+  PngDecoderState decoder_state;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(State);
+};
+
+PNGStreamingDecoder::PNGStreamingDecoder(SkBitmap* bitmap)
+    : state_(new State(bitmap)), failed_(false) {
+  DCHECK(bitmap);
+  state_->decoder_state.reuse_bitmap_pixels = true;
+
+  // Unlike PNGCodec::Decode(), the signature is left for libpng to check,
+  // since it may be split across chunks.
+  state_->png_ptr =
+      png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (state_->png_ptr)
+    state_->info_ptr = png_create_info_struct(state_->png_ptr);
+  if (!state_->info_ptr) {
+    failed_ = true;
+    return;
+  }
+
+  png_set_error_fn(state_->png_ptr, NULL, LogLibPNGDecodeError,
+                   LogLibPNGDecodeWarning);
+  png_set_progressive_read_fn(state_->png_ptr, &state_->decoder_state,
+                              &DecodeInfoCallback, &DecodeRowCallback,
+                              &DecodeEndCallback);
+}
+
+PNGStreamingDecoder::~PNGStreamingDecoder() {}
+
+void PNGStreamingDecoder::set_scale_denominator(int scale_denominator) {
+  DCHECK(scale_denominator == 1 || scale_denominator == 2 ||
+         scale_denominator == 4 || scale_denominator == 8);
+  DCHECK(image_size().IsEmpty()) << "Decoding has started";
+  state_->decoder_state.scale_denominator = scale_denominator;
+}
+
+bool PNGStreamingDecoder::Feed(const unsigned char* data, size_t size) {
+  if (failed_)
+    return false;
+  if (done())
+    return true;  // Anything after the end of the image is ignored.
+
+  if (setjmp(png_jmpbuf(state_->png_ptr))) {
+    // Everything libpng allocated is released by State.
+    failed_ = true;
+    return false;
+  }
+  png_process_data(state_->png_ptr, state_->info_ptr,
+                   const_cast<unsigned char*>(data), size);
+
+  if (state_->decoder_state.done) {
+    state_->decoder_state.bitmap->setAlphaType(
+        state_->decoder_state.is_opaque ? kOpaque_SkAlphaType
+                                        : kPremul_SkAlphaType);
+  }
+  return true;
+}
+
+bool PNGStreamingDecoder::FeedFile(base::File* file, size_t chunk_size) {
+  DCHECK_GT(chunk_size, 0u);
+  scoped_ptr<char[]> buffer(new char[chunk_size]);
+  while (!done()) {
+    int bytes_read =
+        file->ReadAtCurrentPos(buffer.get(), static_cast<int>(chunk_size));
+    if (bytes_read <= 0)
+      return false;  // Read error, or the file is truncated.
+    if (!Feed(reinterpret_cast<const unsigned char*>(buffer.get()),
+              bytes_read)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PNGStreamingDecoder::done() const {
+  return !failed_ && state_->decoder_state.done;
+}
+
+Size PNGStreamingDecoder::image_size() const {
+  return Size(state_->decoder_state.width, state_->decoder_state.height);
+}
+
+Size PNGStreamingDecoder::output_size() const {
+  const int scale = state_->decoder_state.scale_denominator;
+  return Size((state_->decoder_state.width + scale - 1) / scale,
+              (state_->decoder_state.height + scale - 1) / scale);
+}
+
 // Encoder --------------------------------------------------------------------
 //
 // This section of the code is based on nsPNGEncoder.cpp in Mozilla
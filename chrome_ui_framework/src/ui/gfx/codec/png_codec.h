@@ -9,10 +9,15 @@
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
 #include "ui/gfx/gfx_export.h"
 
 class SkBitmap;
 
+namespace base {
+class File;
+}
+
 namespace gfx {
 
 class Size;
@@ -129,6 +134,56 @@ class GFX_EXPORT PNGCodec {
   DISALLOW_COPY_AND_ASSIGN(PNGCodec);
 };
 
+// Decodes a PNG into an SkBitmap from data that arrives in chunks of any size,
+// such as reads from a base::File or slices of a base::MemoryMappedFile, so
+// the encoded image never has to be in memory as a whole. Rows are written
+// into the bitmap as soon as they are decoded.
+//
+// The bitmap may come with pixels already, for instance from installPixels()
+// on a buffer taken from a pool; they are decoded into in place if the bitmap
+// has the output size and is kN32_SkColorType. Otherwise pixels are allocated
+// once the header has been decoded.
+class GFX_EXPORT PNGStreamingDecoder {
+ public:
+  explicit PNGStreamingDecoder(SkBitmap* bitmap);
+  ~PNGStreamingDecoder();
+
+  // Shrinks the image by |scale_denominator| in both dimensions while
+  // decoding, averaging each block of |scale_denominator| by
+  // |scale_denominator| pixels, so that a full size copy of a non-interlaced
+  // image is never stored. Must be 1 (the default), 2, 4 or 8, and must be
+  // set before the first call to Feed().
+  void set_scale_denominator(int scale_denominator);
+
+  // Decodes as much of |data| as possible. Returns false if the data is not a
+  // valid PNG, after which all further calls fail too.
+  bool Feed(const unsigned char* data, size_t size);
+
+  // Feeds the contents of |file| from its current position, reading
+  // |chunk_size| bytes at a time. Returns true if the file held a complete
+  // PNG.
+  bool FeedFile(base::File* file, size_t chunk_size);
+
+  // Returns true once the whole image has been decoded, at which point the
+  // bitmap is complete and its alpha type is set.
+  bool done() const;
+
+  // The size of the encoded image. Empty until the header has been decoded.
+  Size image_size() const;
+
+  // The size of the decoded bitmap, |image_size()| divided by the scale
+  // denominator and rounded up.
+  Size output_size() const;
+
+ private:
+  class State;
+
+  scoped_ptr<State> state_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(PNGStreamingDecoder);
+};
+
 }  // namespace gfx
 
 #endif  // UI_GFX_CODEC_PNG_CODEC_H_
@@ -0,0 +1,155 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/gfx/codec/png_codec.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/test/scoped_peak_memory_delta.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkColorPriv.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace gfx {
+
+namespace {
+
+// Roughly a full screen photo; large enough that the encoded data is several
+// megabytes.
+const int kImageWidth = 2048;
+const int kImageHeight = 1536;
+
+const size_t kChunkSize = 64 * 1024;
+
+const int kRuns = 5;
+
+// Fills |bitmap| with gradients and noise, so that it compresses about as
+// well as a photo.
+void MakeTestImage(SkBitmap* bitmap) {
+  bitmap->allocN32Pixels(kImageWidth, kImageHeight);
+  uint32_t seed = 1;
+  for (int y = 0; y < kImageHeight; y++) {
+    uint32_t* row = bitmap->getAddr32(0, y);
+    for (int x = 0; x < kImageWidth; x++) {
+      seed = seed * 1103515245 + 12345;
+      const uint32_t noise = (seed >> 16) & 0x0f;
+      row[x] = SkPackARGB32(0xff, (x / 8 + noise) & 0xff,
+                            (y / 6 + noise) & 0xff, ((x + y) / 14) & 0xff);
+    }
+  }
+}
+
+class PNGCodecPerfTest : public testing::Test {
+ public:
+  PNGCodecPerfTest() : encoded_size_(0) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(dir_.CreateUniqueTempDir());
+    path_ = dir_.path().AppendASCII("image.png");
+
+    SkBitmap bitmap;
+    MakeTestImage(&bitmap);
+    std::vector<unsigned char> encoded;
+    ASSERT_TRUE(PNGCodec::EncodeBGRASkBitmap(bitmap, false, &encoded));
+    ASSERT_EQ(static_cast<int>(encoded.size()),
+              base::WriteFile(path_, reinterpret_cast<char*>(&encoded[0]),
+                              encoded.size()));
+    encoded_size_ = encoded.size();
+  }
+
+ protected:
+  // Reads the whole file and decodes it with PNGCodec::Decode().
+  bool DecodeOneShot(SkBitmap* bitmap) {
+    std::string encoded;
+    if (!base::ReadFileToString(path_, &encoded))
+      return false;
+    return PNGCodec::Decode(reinterpret_cast<const unsigned char*>(&encoded[0]),
+                            encoded.size(), bitmap);
+  }
+
+  // Decodes the file |kChunkSize| bytes at a time.
+  bool DecodeStreaming(int scale_denominator, SkBitmap* bitmap) {
+    base::File file(path_, base::File::FLAG_OPEN | base::File::FLAG_READ);
+    if (!file.IsValid())
+      return false;
+    PNGStreamingDecoder decoder(bitmap);
+    decoder.set_scale_denominator(scale_denominator);
+    return decoder.FeedFile(&file, kChunkSize);
+  }
+
+  // Runs |decode| kRuns times and prints its throughput in megapixels of the
+  // source image per second and, where supported, the largest growth of the
+  // peak resident set size over a single decode.
+  template <typename DecodeFunction>
+  void TimeDecode(const std::string& trace, const DecodeFunction& decode) {
+    base::TimeDelta total;
+    size_t peak_delta_bytes = 0;
+    bool memory_supported = false;
+    for (int i = 0; i < kRuns; i++) {
+      base::ScopedPeakMemoryDelta memory;
+      const base::TimeTicks start = base::TimeTicks::Now();
+      ASSERT_TRUE(decode());
+      total += base::TimeTicks::Now() - start;
+      memory_supported = memory.supported();
+      peak_delta_bytes = std::max(peak_delta_bytes, memory.GetDeltaBytes());
+    }
+
+    const double megapixels = kRuns * kImageWidth * kImageHeight / 1e6;
+    perf_test::PrintResult("png_decode_throughput", "", trace,
+                           megapixels / total.InSecondsF(), "MP/s", true);
+    if (memory_supported) {
+      perf_test::PrintResult("png_decode_peak_rss", "", trace,
+                             peak_delta_bytes / 1024, "KB", true);
+    }
+  }
+
+  base::ScopedTempDir dir_;
+  base::FilePath path_;
+  size_t encoded_size_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PNGCodecPerfTest);
+};
+
+}  // namespace
+
+// Compares decoding the whole file at once with decoding it as it is read,
+// into a new bitmap, into a pooled bitmap that is reused between decodes, and
+// shrunk to a quarter of the size while decoding.
+TEST_F(PNGCodecPerfTest, StreamingVersusOneShot) {
+  perf_test::PrintResult("png_encoded_size", "", "image", encoded_size_ / 1024,
+                         "KB", false);
+
+  TimeDecode("one_shot", [this]() {
+    SkBitmap bitmap;
+    return DecodeOneShot(&bitmap);
+  });
+
+  TimeDecode("streaming", [this]() {
+    SkBitmap bitmap;
+    return DecodeStreaming(1, &bitmap);
+  });
+
+  SkBitmap pooled;
+  pooled.allocN32Pixels(kImageWidth, kImageHeight);
+  TimeDecode("streaming_pooled",
+             [this, &pooled]() { return DecodeStreaming(1, &pooled); });
+
+  TimeDecode("streaming_scale_4", [this]() {
+    SkBitmap bitmap;
+    return DecodeStreaming(4, &bitmap);
+  });
+}
+
+}  // namespace gfx
@@ -1185,4 +1185,167 @@ TEST(PNGCodec, EncodeDecodeWithVaryingCompressionLevels) {
 }
 
 
+// Returns |bitmap| shrunk by |scale| the way PNGStreamingDecoder does it,
+// averaging each block of pixels with rounding.
+void ScaleBitmapForTest(const SkBitmap& bitmap, int scale, SkBitmap* scaled) {
+  const int w = (bitmap.width() + scale - 1) / scale;
+  const int h = (bitmap.height() + scale - 1) / scale;
+  scaled->allocN32Pixels(w, h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint32_t sums[4] = {0, 0, 0, 0};
+      uint32_t count = 0;
+      for (int sy = y * scale; sy < std::min(bitmap.height(), (y + 1) * scale);
+           sy++) {
+        for (int sx = x * scale;
+             sx < std::min(bitmap.width(), (x + 1) * scale); sx++) {
+          const unsigned char* pixel =
+              reinterpret_cast<const unsigned char*>(bitmap.getAddr32(sx, sy));
+          for (int i = 0; i < 4; i++)
+            sums[i] += pixel[i];
+          count++;
+        }
+      }
+      unsigned char* dest =
+          reinterpret_cast<unsigned char*>(scaled->getAddr32(x, y));
+      for (int i = 0; i < 4; i++)
+        dest[i] = static_cast<unsigned char>((sums[i] + count / 2) / count);
+    }
+  }
+}
+
+// Feeds |encoded| to |decoder| |chunk_size| bytes at a time.
+bool FeedInChunks(const std::vector<unsigned char>& encoded,
+                  size_t chunk_size,
+                  PNGStreamingDecoder* decoder) {
+  for (size_t i = 0; i < encoded.size(); i += chunk_size) {
+    if (!decoder->Feed(&encoded[i], std::min(chunk_size, encoded.size() - i)))
+      return false;
+  }
+  return decoder->done();
+}
+
+TEST(PNGStreamingDecoder, MatchesOneShotDecode) {
+  const int w = 23, h = 17;
+  std::vector<unsigned char> original;
+  MakeRGBAImage(w, h, true, &original);
+
+  const int interlace_types[] = {PNG_INTERLACE_NONE, PNG_INTERLACE_ADAM7};
+  for (int interlace_type : interlace_types) {
+    std::vector<unsigned char> encoded;
+    ASSERT_TRUE(EncodeImage(original, w, h, COLOR_TYPE_RGBA, &encoded,
+                            interlace_type));
+    SkBitmap expected;
+    ASSERT_TRUE(PNGCodec::Decode(&encoded[0], encoded.size(), &expected));
+
+    // Chunk sizes that split the signature, chunk headers and rows.
+    const size_t chunk_sizes[] = {1, 7, 100, encoded.size()};
+    for (size_t chunk_size : chunk_sizes) {
+      SkBitmap decoded;
+      PNGStreamingDecoder decoder(&decoded);
+      EXPECT_FALSE(decoder.done());
+      ASSERT_TRUE(FeedInChunks(encoded, chunk_size, &decoder));
+      EXPECT_EQ(Size(w, h), decoder.image_size());
+      EXPECT_EQ(Size(w, h), decoder.output_size());
+      EXPECT_EQ(kPremul_SkAlphaType, decoded.alphaType());
+      EXPECT_TRUE(BitmapsAreEqual(expected, decoded));
+    }
+  }
+}
+
+TEST(PNGStreamingDecoder, DecodesIntoPreallocatedPixels) {
+  const int w = 20, h = 20;
+  std::vector<unsigned char> original;
+  MakeRGBAImage(w, h, false, &original);
+  std::vector<unsigned char> encoded;
+  ASSERT_TRUE(EncodeImage(original, w, h, COLOR_TYPE_RGBA, &encoded));
+  SkBitmap expected;
+  ASSERT_TRUE(PNGCodec::Decode(&encoded[0], encoded.size(), &expected));
+
+  // Rows are padded, as in a buffer shared by images of different widths.
+  const size_t row_bytes = (w + 3) * 4;
+  std::vector<uint32_t> pixels(row_bytes / 4 * h, 0xdeadbeef);
+  SkBitmap decoded;
+  ASSERT_TRUE(decoded.installPixels(SkImageInfo::MakeN32Premul(w, h),
+                                    &pixels[0], row_bytes));
+  PNGStreamingDecoder decoder(&decoded);
+  ASSERT_TRUE(FeedInChunks(encoded, 64, &decoder));
+
+  EXPECT_EQ(&pixels[0], decoded.getPixels());
+  EXPECT_EQ(kOpaque_SkAlphaType, decoded.alphaType());
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++)
+      EXPECT_EQ(*expected.getAddr32(x, y), *decoded.getAddr32(x, y));
+    // The padding is left alone.
+    EXPECT_EQ(0xdeadbeef, pixels[y * row_bytes / 4 + w]);
+  }
+
+  // Pixels of the wrong size are replaced.
+  SkBitmap small;
+  small.allocN32Pixels(4, 4);
+  PNGStreamingDecoder small_decoder(&small);
+  ASSERT_TRUE(FeedInChunks(encoded, 64, &small_decoder));
+  EXPECT_TRUE(BitmapsAreEqual(expected, small));
+}
+
+TEST(PNGStreamingDecoder, ScaleOnDecode) {
+  const int w = 23, h = 17;
+  std::vector<unsigned char> original;
+  MakeRGBAImage(w, h, true, &original);
+
+  const int interlace_types[] = {PNG_INTERLACE_NONE, PNG_INTERLACE_ADAM7};
+  for (int interlace_type : interlace_types) {
+    std::vector<unsigned char> encoded;
+    ASSERT_TRUE(EncodeImage(original, w, h, COLOR_TYPE_RGBA, &encoded,
+                            interlace_type));
+    SkBitmap full;
+    ASSERT_TRUE(PNGCodec::Decode(&encoded[0], encoded.size(), &full));
+
+    const int scales[] = {2, 4, 8};
+    for (int scale : scales) {
+      SkBitmap expected;
+      ScaleBitmapForTest(full, scale, &expected);
+
+      SkBitmap decoded;
+      PNGStreamingDecoder decoder(&decoded);
+      decoder.set_scale_denominator(scale);
+      ASSERT_TRUE(FeedInChunks(encoded, 50, &decoder));
+      EXPECT_EQ(Size(w, h), decoder.image_size());
+      EXPECT_EQ(Size((w + scale - 1) / scale, (h + scale - 1) / scale),
+                decoder.output_size());
+      EXPECT_TRUE(BitmapsAreEqual(expected, decoded)) << "scale " << scale;
+    }
+  }
+}
+
+TEST(PNGStreamingDecoder, DecodeCorrupted) {
+  const int w = 20, h = 20;
+  std::vector<unsigned char> original;
+  MakeRGBImage(w, h, &original);
+
+  // Not a PNG at all.
+  SkBitmap bitmap;
+  PNGStreamingDecoder not_png_decoder(&bitmap);
+  EXPECT_FALSE(not_png_decoder.Feed(&original[0], original.size()));
+  EXPECT_FALSE(not_png_decoder.Feed(&original[0], original.size()));
+  EXPECT_FALSE(not_png_decoder.done());
+
+  std::vector<unsigned char> compressed;
+  ASSERT_TRUE(PNGCodec::Encode(&original[0], PNGCodec::FORMAT_RGB,
+                               Size(w, h), w * 3, false,
+                               std::vector<PNGCodec::Comment>(),
+                               &compressed));
+
+  // A truncated image is never done.
+  PNGStreamingDecoder truncated_decoder(&bitmap);
+  EXPECT_TRUE(truncated_decoder.Feed(&compressed[0], compressed.size() / 2));
+  EXPECT_FALSE(truncated_decoder.done());
+
+  for (int i = 10; i < 30; i++)
+    compressed[i] = i;
+  PNGStreamingDecoder corrupt_decoder(&bitmap);
+  EXPECT_FALSE(FeedInChunks(compressed, 16, &corrupt_decoder));
+  EXPECT_FALSE(corrupt_decoder.done());
+}
+
 }  // namespace gfx
@@ -183,6 +183,8 @@
         
         'harfbuzz_font_skia.cc',
         'harfbuzz_font_skia.h',
+        'harfbuzz_shape_cache.cc',
+        'harfbuzz_shape_cache.h',
         'hud_font.cc',
         'hud_font.h',
         'image/canvas_image_source.cc',
@@ -422,6 +424,8 @@
           'sources!': [
             'harfbuzz_font_skia.cc',
             'harfbuzz_font_skia.h',
+            'harfbuzz_shape_cache.cc',
+            'harfbuzz_shape_cache.h',
             'render_text.cc',
             'render_text.h',
             'render_text_harfbuzz.cc',
@@ -59,6 +59,7 @@
         'geometry/size_unittest.cc',
         'geometry/vector2d_unittest.cc',
         'geometry/vector3d_unittest.cc',
+        'harfbuzz_shape_cache_unittest.cc',
         'image/image_mac_unittest.mm',
         'image/image_util_unittest.cc',
         'mac/coordinate_conversion_unittest.mm',
@@ -112,6 +113,7 @@
         }],
         ['OS=="android" or OS=="ios"', {
           'sources!': [
+            'harfbuzz_shape_cache_unittest.cc',
             'render_text_unittest.cc',
           ],
         }],
@@ -160,7 +162,25 @@
           'msvs_disabled_warnings': [ 4267, ],
         }],
       ],
-    }
+    },
+    {
+      # GN version: //ui/gfx:gfx_perftests
+      'target_name': 'gfx_perftests',
+      'type': 'executable',
+      'dependencies': [
+        '../../base/base.gyp:base',
+        '../../base/base.gyp:test_support_base',
+        '../../base/base.gyp:test_support_perf',
+        '../../skia/skia.gyp:skia',
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        'gfx.gyp:gfx',
+        'gfx.gyp:gfx_geometry',
+      ],
+      'sources': [
+        'codec/png_codec_perftest.cc',
+      ],
+    },
   ],
   'conditions': [
     ['OS == "android"', {
@@ -0,0 +1,219 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/gfx/harfbuzz_shape_cache.h"
+
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/memory_dump_manager.h"
+#include "base/trace_event/process_memory_dump.h"
+
+namespace gfx {
+namespace internal {
+
+namespace {
+
+// Limits of the process-wide cache. Typical UI strings shape to a few hundred
+// bytes, so this keeps several thousand runs alive in about 2 MB.
+const size_t kDefaultMaxEntries = 4096;
+const size_t kDefaultMaxBytes = 2 * 1024 * 1024;
+
+// Approximate per-entry bookkeeping overhead of the MRU list and index.
+const size_t kEntryOverheadBytes = 96;
+
+}  // namespace
+
+HarfBuzzShapeCacheKey::HarfBuzzShapeCacheKey()
+    : run_offset(0),
+      run_length(0),
+      font_id(0),
+      font_size(0),
+      subpixel_rendering_suppressed(false),
+      script(USCRIPT_INVALID_CODE),
+      is_rtl(false) {}
+
+HarfBuzzShapeCacheKey::~HarfBuzzShapeCacheKey() {}
+
+bool HarfBuzzShapeCacheKey::operator<(
+    const HarfBuzzShapeCacheKey& other) const {
+  // Compare the cheap fields first; the text is compared last.
+  if (font_id != other.font_id)
+    return font_id < other.font_id;
+  if (font_size != other.font_size)
+    return font_size < other.font_size;
+  if (script != other.script)
+    return script < other.script;
+  if (is_rtl != other.is_rtl)
+    return is_rtl < other.is_rtl;
+  if (subpixel_rendering_suppressed != other.subpixel_rendering_suppressed)
+    return subpixel_rendering_suppressed < other.subpixel_rendering_suppressed;
+  const FontRenderParams& a = render_params;
+  const FontRenderParams& b = other.render_params;
+  if (a.antialiasing != b.antialiasing)
+    return a.antialiasing < b.antialiasing;
+  if (a.subpixel_positioning != b.subpixel_positioning)
+    return a.subpixel_positioning < b.subpixel_positioning;
+  if (a.autohinter != b.autohinter)
+    return a.autohinter < b.autohinter;
+  if (a.use_bitmaps != b.use_bitmaps)
+    return a.use_bitmaps < b.use_bitmaps;
+  if (a.hinting != b.hinting)
+    return a.hinting < b.hinting;
+  if (a.subpixel_rendering != b.subpixel_rendering)
+    return a.subpixel_rendering < b.subpixel_rendering;
+  if (run_offset != other.run_offset)
+    return run_offset < other.run_offset;
+  if (run_length != other.run_length)
+    return run_length < other.run_length;
+  return text < other.text;
+}
+
+HarfBuzzShapeResult::HarfBuzzShapeResult() : width(0.0f) {}
+
+HarfBuzzShapeResult::~HarfBuzzShapeResult() {}
+
+size_t HarfBuzzShapeResult::EstimateMemoryUsage() const {
+  return sizeof(*this) + glyphs.capacity() * sizeof(uint16) +
+         positions.capacity() * sizeof(SkPoint) +
+         glyph_to_char.capacity() * sizeof(uint32);
+}
+
+// static
+HarfBuzzShapeCache* HarfBuzzShapeCache::GetInstance() {
+  return base::Singleton<HarfBuzzShapeCache,
+                         base::LeakySingletonTraits<HarfBuzzShapeCache>>::get();
+}
+
+HarfBuzzShapeCache::HarfBuzzShapeCache()
+    : max_entries_(kDefaultMaxEntries),
+      max_bytes_(kDefaultMaxBytes),
+      cache_(Cache::NO_AUTO_EVICT),
+      memory_usage_(0),
+      hit_count_(0),
+      miss_count_(0),
+      eviction_count_(0) {
+  base::trace_event::MemoryDumpManager::GetInstance()->RegisterDumpProvider(
+      this);
+}
+
+HarfBuzzShapeCache::HarfBuzzShapeCache(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries),
+      max_bytes_(max_bytes),
+      cache_(Cache::NO_AUTO_EVICT),
+      memory_usage_(0),
+      hit_count_(0),
+      miss_count_(0),
+      eviction_count_(0) {}
+
+HarfBuzzShapeCache::~HarfBuzzShapeCache() {}
+
+scoped_refptr<HarfBuzzShapeResult> HarfBuzzShapeCache::Get(
+    const HarfBuzzShapeCacheKey& key) {
+  base::AutoLock lock(lock_);
+  Cache::iterator it = cache_.Get(key);
+  if (it == cache_.end()) {
+    ++miss_count_;
+    return nullptr;
+  }
+  ++hit_count_;
+  return it->second;
+}
+
+void HarfBuzzShapeCache::Put(const HarfBuzzShapeCacheKey& key,
+                             const scoped_refptr<HarfBuzzShapeResult>& result) {
+  DCHECK(result);
+  const size_t entry_size = EstimateEntrySize(key, *result);
+  if (entry_size > max_bytes_)
+    return;
+
+  base::AutoLock lock(lock_);
+  Cache::iterator it = cache_.Peek(key);
+  if (it != cache_.end()) {
+    memory_usage_ -= EstimateEntrySize(it->first, *it->second);
+    cache_.Erase(it);
+  }
+  cache_.Put(key, result);
+  memory_usage_ += entry_size;
+  EvictIfNeededLocked();
+}
+
+void HarfBuzzShapeCache::Clear() {
+  base::AutoLock lock(lock_);
+  cache_.Clear();
+  memory_usage_ = 0;
+}
+
+size_t HarfBuzzShapeCache::GetEntryCount() const {
+  base::AutoLock lock(lock_);
+  return cache_.size();
+}
+
+size_t HarfBuzzShapeCache::GetMemoryUsage() const {
+  base::AutoLock lock(lock_);
+  return memory_usage_;
+}
+
+uint64 HarfBuzzShapeCache::hit_count() const {
+  base::AutoLock lock(lock_);
+  return hit_count_;
+}
+
+uint64 HarfBuzzShapeCache::miss_count() const {
+  base::AutoLock lock(lock_);
+  return miss_count_;
+}
+
+bool HarfBuzzShapeCache::OnMemoryDump(
+    const base::trace_event::MemoryDumpArgs& args,
+    base::trace_event::ProcessMemoryDump* pmd) {
+  base::AutoLock lock(lock_);
+  base::trace_event::MemoryAllocatorDump* dump =
+      pmd->CreateAllocatorDump("ui/harfbuzz_shape_cache");
+  dump->AddScalar(base::trace_event::MemoryAllocatorDump::kNameSize,
+                  base::trace_event::MemoryAllocatorDump::kUnitsBytes,
+                  memory_usage_);
+  dump->AddScalar("entry_count",
+                  base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+                  cache_.size());
+  dump->AddScalar("hit_count",
+                  base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+                  hit_count_);
+  dump->AddScalar("miss_count",
+                  base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+                  miss_count_);
+  dump->AddScalar("eviction_count",
+                  base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+                  eviction_count_);
+  const uint64 lookups = hit_count_ + miss_count_;
+  dump->AddScalarF("hit_rate", "ratio",
+                   lookups ? static_cast<double>(hit_count_) / lookups : 0.0);
+
+  const char* system_allocator_name =
+      base::trace_event::MemoryDumpManager::GetInstance()
+          ->system_allocator_pool_name();
+  if (system_allocator_name)
+    pmd->AddSuballocation(dump->guid(), system_allocator_name);
+  return true;
+}
+
+void HarfBuzzShapeCache::EvictIfNeededLocked() {
+  lock_.AssertAcquired();
+  while (!cache_.empty() &&
+         (cache_.size() > max_entries_ || memory_usage_ > max_bytes_)) {
+    Cache::reverse_iterator oldest = cache_.rbegin();
+    memory_usage_ -= EstimateEntrySize(oldest->first, *oldest->second);
+    cache_.Erase(oldest);
+    ++eviction_count_;
+  }
+}
+
+// static
+size_t HarfBuzzShapeCache::EstimateEntrySize(
+    const HarfBuzzShapeCacheKey& key,
+    const HarfBuzzShapeResult& result) {
+  return kEntryOverheadBytes + key.text.size() * sizeof(base::char16) +
+         result.EstimateMemoryUsage();
+}
+
+}  // namespace internal
+}  // namespace gfx
@@ -0,0 +1,135 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef UI_GFX_HARFBUZZ_SHAPE_CACHE_H_
+#define UI_GFX_HARFBUZZ_SHAPE_CACHE_H_
+
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/singleton.h"
+#include "base/strings/string16.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/memory_dump_provider.h"
+#include "third_party/icu/source/common/unicode/uscript.h"
+#include "third_party/skia/include/core/SkPoint.h"
+#include "third_party/skia/include/core/SkTypes.h"
+#include "ui/gfx/font_render_params.h"
+#include "ui/gfx/gfx_export.h"
+
+namespace gfx {
+namespace internal {
+
+// Everything that influences the output of hb_shape() for a single text run.
+// |text| holds the run plus up to HB_BUFFER_MAX_CONTEXT_LENGTH characters of
+// surrounding context on each side, and |run_offset|/|run_length| locate the
+// run within it, so that contextual shaping (e.g. Arabic joining across a run
+// boundary) is part of the key.
+struct GFX_EXPORT HarfBuzzShapeCacheKey {
+  HarfBuzzShapeCacheKey();
+  ~HarfBuzzShapeCacheKey();
+
+  bool operator<(const HarfBuzzShapeCacheKey& other) const;
+
+  base::string16 text;
+  size_t run_offset;
+  size_t run_length;
+  SkFontID font_id;
+  int font_size;
+  FontRenderParams render_params;
+  bool subpixel_rendering_suppressed;
+  UScriptCode script;
+  bool is_rtl;
+};
+
+// The immutable result of shaping one run. Glyph clusters are stored relative
+// to the start of the run so the result can be reused at any text offset.
+class GFX_EXPORT HarfBuzzShapeResult
+    : public base::RefCountedThreadSafe<HarfBuzzShapeResult> {
+ public:
+  HarfBuzzShapeResult();
+
+  // Returns the approximate heap footprint of this result, in bytes.
+  size_t EstimateMemoryUsage() const;
+
+  std::vector<uint16> glyphs;
+  std::vector<SkPoint> positions;
+  std::vector<uint32> glyph_to_char;
+  float width;
+
+ private:
+  friend class base::RefCountedThreadSafe<HarfBuzzShapeResult>;
+  ~HarfBuzzShapeResult();
+
+  DISALLOW_COPY_AND_ASSIGN(HarfBuzzShapeResult);
+};
+
+// A process-wide, thread-safe LRU cache of shaped runs. Labels, textfields and
+// table cells relayout the same strings over and over, and shaping dominates
+// the cost of each layout. The cache is bounded both by entry count and by
+// the estimated size of the stored glyph data.
+class GFX_EXPORT HarfBuzzShapeCache
+    : public base::trace_event::MemoryDumpProvider {
+ public:
+  static HarfBuzzShapeCache* GetInstance();
+
+  // Creates a standalone cache. Production code should use GetInstance();
+  // this is exposed for tests.
+  HarfBuzzShapeCache(size_t max_entries, size_t max_bytes);
+  ~HarfBuzzShapeCache() override;
+
+  // Returns the cached result for |key|, or NULL on a miss. A hit marks the
+  // entry as most recently used.
+  scoped_refptr<HarfBuzzShapeResult> Get(const HarfBuzzShapeCacheKey& key);
+
+  // Stores |result| for |key|, evicting least recently used entries as needed.
+  // Results larger than the whole byte budget are not stored.
+  void Put(const HarfBuzzShapeCacheKey& key,
+           const scoped_refptr<HarfBuzzShapeResult>& result);
+
+  // Drops all entries. Counters are preserved.
+  void Clear();
+
+  size_t GetEntryCount() const;
+  size_t GetMemoryUsage() const;
+  uint64 hit_count() const;
+  uint64 miss_count() const;
+
+  // base::trace_event::MemoryDumpProvider implementation:
+  bool OnMemoryDump(const base::trace_event::MemoryDumpArgs& args,
+                    base::trace_event::ProcessMemoryDump* pmd) override;
+
+ private:
+  friend struct base::DefaultSingletonTraits<HarfBuzzShapeCache>;
+
+  typedef base::MRUCache<HarfBuzzShapeCacheKey,
+                         scoped_refptr<HarfBuzzShapeResult>> Cache;
+
+  HarfBuzzShapeCache();
+
+  // Evicts least recently used entries until both limits are satisfied.
+  // Must be called with |lock_| held.
+  void EvictIfNeededLocked();
+
+  static size_t EstimateEntrySize(const HarfBuzzShapeCacheKey& key,
+                                  const HarfBuzzShapeResult& result);
+
+  const size_t max_entries_;
+  const size_t max_bytes_;
+
+  mutable base::Lock lock_;
+  Cache cache_;
+  size_t memory_usage_;
+  uint64 hit_count_;
+  uint64 miss_count_;
+  uint64 eviction_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(HarfBuzzShapeCache);
+};
+
+}  // namespace internal
+}  // namespace gfx
+
+#endif  // UI_GFX_HARFBUZZ_SHAPE_CACHE_H_
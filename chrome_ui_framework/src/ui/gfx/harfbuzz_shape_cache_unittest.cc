@@ -0,0 +1,114 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/gfx/harfbuzz_shape_cache.h"
+
+#include "base/strings/utf_string_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace gfx {
+namespace internal {
+
+namespace {
+
+HarfBuzzShapeCacheKey CreateKey(const char* text) {
+  HarfBuzzShapeCacheKey key;
+  key.text = base::ASCIIToUTF16(text);
+  key.run_length = key.text.length();
+  key.font_id = 1;
+  key.font_size = 12;
+  key.script = USCRIPT_LATIN;
+  return key;
+}
+
+scoped_refptr<HarfBuzzShapeResult> CreateResult(size_t glyph_count) {
+  scoped_refptr<HarfBuzzShapeResult> result(new HarfBuzzShapeResult);
+  result->glyphs.resize(glyph_count);
+  result->positions.resize(glyph_count);
+  result->glyph_to_char.resize(glyph_count);
+  result->width = glyph_count * 10.0f;
+  return result;
+}
+
+}  // namespace
+
+TEST(HarfBuzzShapeCacheTest, HitAndMiss) {
+  HarfBuzzShapeCache cache(10, 1024 * 1024);
+  EXPECT_FALSE(cache.Get(CreateKey("abc")));
+  EXPECT_EQ(1U, cache.miss_count());
+
+  scoped_refptr<HarfBuzzShapeResult> result = CreateResult(3);
+  cache.Put(CreateKey("abc"), result);
+  EXPECT_EQ(result, cache.Get(CreateKey("abc")));
+  EXPECT_EQ(1U, cache.hit_count());
+  EXPECT_EQ(1U, cache.GetEntryCount());
+}
+
+TEST(HarfBuzzShapeCacheTest, KeyDistinguishesShapingInputs) {
+  HarfBuzzShapeCache cache(10, 1024 * 1024);
+  cache.Put(CreateKey("abc"), CreateResult(3));
+
+  HarfBuzzShapeCacheKey key = CreateKey("abc");
+  key.is_rtl = true;
+  EXPECT_FALSE(cache.Get(key));
+
+  key = CreateKey("abc");
+  key.font_size = 13;
+  EXPECT_FALSE(cache.Get(key));
+
+  key = CreateKey("abc");
+  key.render_params.subpixel_positioning =
+      !key.render_params.subpixel_positioning;
+  EXPECT_FALSE(cache.Get(key));
+
+  key = CreateKey("abc");
+  key.run_offset = 1;
+  key.run_length = 2;
+  EXPECT_FALSE(cache.Get(key));
+
+  EXPECT_TRUE(cache.Get(CreateKey("abc")));
+}
+
+TEST(HarfBuzzShapeCacheTest, EvictsLeastRecentlyUsedEntry) {
+  HarfBuzzShapeCache cache(2, 1024 * 1024);
+  cache.Put(CreateKey("a"), CreateResult(1));
+  cache.Put(CreateKey("b"), CreateResult(1));
+  // Touch "a" so that "b" becomes the least recently used entry.
+  EXPECT_TRUE(cache.Get(CreateKey("a")));
+  cache.Put(CreateKey("c"), CreateResult(1));
+
+  EXPECT_EQ(2U, cache.GetEntryCount());
+  EXPECT_TRUE(cache.Get(CreateKey("a")));
+  EXPECT_FALSE(cache.Get(CreateKey("b")));
+  EXPECT_TRUE(cache.Get(CreateKey("c")));
+}
+
+TEST(HarfBuzzShapeCacheTest, RespectsByteBudget) {
+  const size_t kMaxBytes = 4096;
+  HarfBuzzShapeCache cache(1000, kMaxBytes);
+  for (int i = 0; i < 100; ++i) {
+    cache.Put(CreateKey(std::string(1, 'a' + i % 26).c_str()),
+              CreateResult(16 + i));
+    EXPECT_LE(cache.GetMemoryUsage(), kMaxBytes);
+  }
+
+  // A result larger than the whole budget is never stored.
+  cache.Clear();
+  EXPECT_EQ(0U, cache.GetMemoryUsage());
+  cache.Put(CreateKey("huge"), CreateResult(kMaxBytes));
+  EXPECT_EQ(0U, cache.GetEntryCount());
+  EXPECT_EQ(0U, cache.GetMemoryUsage());
+}
+
+TEST(HarfBuzzShapeCacheTest, ReplacingEntryKeepsAccounting) {
+  HarfBuzzShapeCache cache(10, 1024 * 1024);
+  cache.Put(CreateKey("abc"), CreateResult(3));
+  const size_t usage = cache.GetMemoryUsage();
+  cache.Put(CreateKey("abc"), CreateResult(3));
+  EXPECT_EQ(usage, cache.GetMemoryUsage());
+  EXPECT_EQ(1U, cache.GetEntryCount());
+}
+
+}  // namespace internal
+}  // namespace gfx
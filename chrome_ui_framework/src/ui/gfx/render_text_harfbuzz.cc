@@ -4,6 +4,7 @@
 
 #include "ui/gfx/render_text_harfbuzz.h"
 
+#include <algorithm>
 #include <limits>
 #include <set>
 
@@ -24,6 +25,7 @@
 #include "ui/gfx/font_render_params.h"
 #include "ui/gfx/geometry/safe_integer_conversions.h"
 #include "ui/gfx/harfbuzz_font_skia.h"
+#include "ui/gfx/harfbuzz_shape_cache.h"
 #include "ui/gfx/range/range_f.h"
 #include "ui/gfx/text_utils.h"
 #include "ui/gfx/utf16_indexing.h"
@@ -44,6 +46,11 @@ const size_t kMaxTextLength = 10000;
 // character to belong to more scripts.
 const size_t kMaxScripts = 5;
 
+// The number of characters HarfBuzz looks at on either side of a run for
+// contextual shaping (HB_BUFFER_MAX_CONTEXT_LENGTH). Only this much of the
+// surrounding text needs to be part of a shape cache key.
+const size_t kMaxShapingContextLength = 5;
+
 // Returns true if characters of |block_code| may trigger font fallback.
 bool IsUnusualBlockCode(UBlockCode block_code) {
   return block_code == UBLOCK_GEOMETRIC_SHAPES ||
@@ -555,6 +562,25 @@ struct CaseInsensitiveCompare {
   }
 };
 
+// Copies the glyph data of a shaped |result| into |run|, rebasing the
+// run-relative clusters onto the run's position in the text.
+void ApplyShapeResult(const internal::HarfBuzzShapeResult& result,
+                      internal::TextRunHarfBuzz* run) {
+  run->glyph_count = result.glyphs.size();
+  run->glyphs.reset(new uint16[run->glyph_count]);
+  run->positions.reset(new SkPoint[run->glyph_count]);
+  run->glyph_to_char.resize(run->glyph_count);
+  if (run->glyph_count) {
+    std::copy(result.glyphs.begin(), result.glyphs.end(), run->glyphs.get());
+    std::copy(result.positions.begin(), result.positions.end(),
+              run->positions.get());
+  }
+  const uint32 run_start = static_cast<uint32>(run->range.start());
+  for (size_t i = 0; i < run->glyph_count; ++i)
+    run->glyph_to_char[i] = result.glyph_to_char[i] + run_start;
+  run->width = result.width;
+}
+
 }  // namespace
 
 namespace internal {
@@ -1456,6 +1482,35 @@ bool RenderTextHarfBuzz::ShapeRunWithFont(const base::string16& text,
   run->family = font_family;
   run->render_params = params;
 
+  // Runs shaped with a fixed test glyph width do not reflect the real font
+  // metrics, so they bypass the shared cache.
+  const bool use_cache = glyph_width_for_test_ <= 0;
+  internal::HarfBuzzShapeCache* cache =
+      internal::HarfBuzzShapeCache::GetInstance();
+  internal::HarfBuzzShapeCacheKey key;
+  if (use_cache) {
+    const size_t context_start =
+        run->range.start() -
+        std::min(run->range.start(), kMaxShapingContextLength);
+    const size_t context_end =
+        std::min(text.length(), run->range.end() + kMaxShapingContextLength);
+    key.text = text.substr(context_start, context_end - context_start);
+    key.run_offset = run->range.start() - context_start;
+    key.run_length = run->range.length();
+    key.font_id = run->skia_face->uniqueID();
+    key.font_size = run->font_size;
+    key.render_params = run->render_params;
+    key.subpixel_rendering_suppressed = subpixel_rendering_suppressed();
+    key.script = run->script;
+    key.is_rtl = run->is_rtl;
+
+    scoped_refptr<internal::HarfBuzzShapeResult> cached = cache->Get(key);
+    if (cached) {
+      ApplyShapeResult(*cached, run);
+      return true;
+    }
+  }
+
   hb_font_t* harfbuzz_font = CreateHarfBuzzFont(
       run->skia_face.get(), SkIntToScalar(run->font_size), run->render_params,
       subpixel_rendering_suppressed());
@@ -1482,34 +1537,40 @@ bool RenderTextHarfBuzz::ShapeRunWithFont(const base::string16& text,
     hb_shape(harfbuzz_font, buffer, NULL, 0);
   }
 
-  // Populate the run fields with the resulting glyph data in the buffer.
+  // Collect the resulting glyph data in the buffer. Clusters are stored
+  // relative to the start of the run so that the result can be shared.
   unsigned int glyph_count = 0;
   hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(buffer, &glyph_count);
-  run->glyph_count = glyph_count;
   hb_glyph_position_t* hb_positions =
       hb_buffer_get_glyph_positions(buffer, NULL);
-  run->glyphs.reset(new uint16[run->glyph_count]);
-  run->glyph_to_char.resize(run->glyph_count);
-  run->positions.reset(new SkPoint[run->glyph_count]);
-  run->width = 0.0f;
+  scoped_refptr<internal::HarfBuzzShapeResult> result(
+      new internal::HarfBuzzShapeResult);
+  result->glyphs.resize(glyph_count);
+  result->glyph_to_char.resize(glyph_count);
+  result->positions.resize(glyph_count);
 
-  for (size_t i = 0; i < run->glyph_count; ++i) {
+  for (size_t i = 0; i < glyph_count; ++i) {
     DCHECK_LE(infos[i].codepoint, std::numeric_limits<uint16>::max());
-    run->glyphs[i] = static_cast<uint16>(infos[i].codepoint);
-    run->glyph_to_char[i] = infos[i].cluster;
+    result->glyphs[i] = static_cast<uint16>(infos[i].codepoint);
+    DCHECK_GE(infos[i].cluster, run->range.start());
+    result->glyph_to_char[i] = infos[i].cluster - run->range.start();
     const SkScalar x_offset = SkFixedToScalar(hb_positions[i].x_offset);
     const SkScalar y_offset = SkFixedToScalar(hb_positions[i].y_offset);
-    run->positions[i].set(run->width + x_offset, -y_offset);
-    run->width += (glyph_width_for_test_ > 0)
-                      ? glyph_width_for_test_
-                      : SkFixedToFloat(hb_positions[i].x_advance);
+    result->positions[i].set(result->width + x_offset, -y_offset);
+    result->width += (glyph_width_for_test_ > 0)
+                         ? glyph_width_for_test_
+                         : SkFixedToFloat(hb_positions[i].x_advance);
     // Round run widths if subpixel positioning is off to match native behavior.
     if (!run->render_params.subpixel_positioning)
-      run->width = std::floor(run->width + 0.5f);
+      result->width = std::floor(result->width + 0.5f);
   }
 
   hb_buffer_destroy(buffer);
   hb_font_destroy(harfbuzz_font);
+
+  if (use_cache)
+    cache->Put(key, result);
+  ApplyShapeResult(*result, run);
   return true;
 }
 
@@ -19,6 +19,7 @@
 #include "ui/gfx/canvas.h"
 #include "ui/gfx/color_utils.h"
 #include "ui/gfx/font.h"
+#include "ui/gfx/harfbuzz_shape_cache.h"
 #include "ui/gfx/range/range.h"
 #include "ui/gfx/range/range_f.h"
 #include "ui/gfx/render_text_harfbuzz.h"
@@ -2752,6 +2753,64 @@ TEST_F(RenderTextTest, HarfBuzz_SubglyphGraphemePartition) {
   }
 }
 
+// Ensure that runs shaped from the shared shape cache match freshly shaped
+// runs, including when the same text appears at a different offset.
+TEST_F(RenderTextTest, HarfBuzz_ShapeCache) {
+  internal::HarfBuzzShapeCache* cache =
+      internal::HarfBuzzShapeCache::GetInstance();
+  cache->Clear();
+
+  RenderTextHarfBuzz first;
+  first.SetText(ASCIIToUTF16("cached"));
+  first.EnsureLayout();
+  const uint64 hits_before = cache->hit_count();
+
+  RenderTextHarfBuzz second;
+  second.SetText(ASCIIToUTF16("cached"));
+  second.EnsureLayout();
+  EXPECT_GT(cache->hit_count(), hits_before);
+
+  const internal::TextRunList* first_runs = first.GetRunList();
+  const internal::TextRunList* second_runs = second.GetRunList();
+  ASSERT_EQ(1U, first_runs->size());
+  ASSERT_EQ(1U, second_runs->size());
+  const internal::TextRunHarfBuzz& a = *first_runs->runs()[0];
+  const internal::TextRunHarfBuzz& b = *second_runs->runs()[0];
+  ASSERT_EQ(a.glyph_count, b.glyph_count);
+  EXPECT_EQ(a.width, b.width);
+  EXPECT_EQ(a.glyph_to_char, b.glyph_to_char);
+  for (size_t i = 0; i < a.glyph_count; ++i) {
+    EXPECT_EQ(a.glyphs[i], b.glyphs[i]);
+    EXPECT_EQ(a.positions[i], b.positions[i]);
+  }
+
+  // The same run with the same surrounding context at a later offset hits the
+  // cache, and its clusters are rebased onto the run's position in the text.
+  RenderTextHarfBuzz context;
+  context.SetText(WideToUTF16(L"\x05D0\x05D1\x05D2\x05D3\x05D4cached"));
+  context.EnsureLayout();
+  const internal::TextRunList* context_runs = context.GetRunList();
+  ASSERT_EQ(2U, context_runs->size());
+  const internal::TextRunHarfBuzz& latin = *context_runs->runs()[1];
+  EXPECT_EQ(Range(5, 11), latin.range);
+
+  const uint64 hits_before_offset = cache->hit_count();
+  RenderTextHarfBuzz offset;
+  offset.SetText(
+      WideToUTF16(L"\x05D5\x05D0\x05D1\x05D2\x05D3\x05D4cached"));
+  offset.EnsureLayout();
+  EXPECT_EQ(hits_before_offset + 1, cache->hit_count());
+  const internal::TextRunList* offset_runs = offset.GetRunList();
+  ASSERT_EQ(2U, offset_runs->size());
+  const internal::TextRunHarfBuzz& rebased = *offset_runs->runs()[1];
+  EXPECT_EQ(Range(6, 12), rebased.range);
+  ASSERT_EQ(latin.glyph_count, rebased.glyph_count);
+  for (size_t i = 0; i < rebased.glyph_count; ++i) {
+    EXPECT_EQ(latin.glyphs[i], rebased.glyphs[i]);
+    EXPECT_EQ(latin.glyph_to_char[i] + 1, rebased.glyph_to_char[i]);
+  }
+}
+
 TEST_F(RenderTextTest, HarfBuzz_RunDirection) {
   RenderTextHarfBuzz render_text;
   const base::string16 mixed = WideToUTF16(
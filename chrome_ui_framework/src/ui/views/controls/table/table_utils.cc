@@ -19,13 +19,15 @@ int WidthForContent(const gfx::FontList& header_font_list,
                     int padding,
                     int header_padding,
                     const ui::TableColumn& column,
-                    ui::TableModel* model) {
+                    ui::TableModel* model,
+                    int max_rows) {
   int width = header_padding;
   if (!column.title.empty())
     width = gfx::GetStringWidth(column.title, header_font_list) +
         header_padding;
 
-  for (int i = 0, row_count = model->RowCount(); i < row_count; ++i) {
+  const int row_count = std::min(model->RowCount(), max_rows);
+  for (int i = 0; i < row_count; ++i) {
     const int cell_width =
         gfx::GetStringWidth(model->GetText(i, column.id), content_font_list);
     width = std::max(width, cell_width);
@@ -41,7 +43,8 @@ std::vector<int> CalculateTableColumnSizes(
     int padding,
     int header_padding,
     const std::vector<ui::TableColumn>& columns,
-    ui::TableModel* model) {
+    ui::TableModel* model,
+    int max_rows_to_measure) {
   float total_percent = 0;
   int non_percent_width = 0;
   std::vector<int> content_widths(columns.size(), 0);
@@ -56,7 +59,7 @@ std::vector<int> CalculateTableColumnSizes(
       } else {
         content_widths[i] = WidthForContent(header_font_list, content_font_list,
                                             padding, header_padding, column,
-                                            model);
+                                            model, max_rows_to_measure);
         if (i == 0)
           content_widths[i] += first_column_padding;
       }
@@ -22,19 +22,22 @@ VIEWS_EXPORT extern const int kUnspecifiedColumnWidth;
 
 // Returns the width needed to display the contents of the specified column.
 // This is used internally by CalculateTableColumnSizes() and generally not
-// useful by itself. |header_padding| is padding added to the header.
+// useful by itself. |header_padding| is padding added to the header. Only the
+// first |max_rows| rows of |model| are measured.
 VIEWS_EXPORT int WidthForContent(const gfx::FontList& header_font_list,
                                  const gfx::FontList& content_font_list,
                                  int padding,
                                  int header_padding,
                                  const ui::TableColumn& column,
-                                 ui::TableModel* model);
+                                 ui::TableModel* model,
+                                 int max_rows);
 
 // Determines the width for each of the specified columns. |width| is the width
 // to fit the columns into. |header_font_list| the font list used to draw the
 // header and |content_font_list| the header used to draw the content. |padding|
 // is extra horizontal spaced added to each cell, and |header_padding| added to
-// the width needed for the header.
+// the width needed for the header. Autosized columns are measured against at
+// most |max_rows_to_measure| rows of |model|.
 VIEWS_EXPORT std::vector<int> CalculateTableColumnSizes(
     int width,
     int first_column_padding,
@@ -43,7 +46,8 @@ VIEWS_EXPORT std::vector<int> CalculateTableColumnSizes(
     int padding,
     int header_padding,
     const std::vector<ui::TableColumn>& columns,
-    ui::TableModel* model);
+    ui::TableModel* model,
+    int max_rows_to_measure);
 
 // Converts a TableColumn::Alignment to the alignment for drawing the string.
 int TableColumnAlignmentToCanvasAlignment(ui::TableColumn::Alignment alignment);
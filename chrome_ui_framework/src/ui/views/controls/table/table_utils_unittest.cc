@@ -32,49 +32,57 @@ ui::TableColumn CreateTableColumnWithWidth(int width) {
   return column;
 }
 
+// Number of rows in the models used by the tests.
+const int kRowCount = 4;
+
 }  // namespace
 
 // Verifies columns with a specified width is honored.
 TEST(TableUtilsTest, SetWidthHonored) {
-  TestTableModel model(4);
+  TestTableModel model(kRowCount);
   std::vector<TableColumn> columns;
   columns.push_back(CreateTableColumnWithWidth(20));
   columns.push_back(CreateTableColumnWithWidth(30));
   gfx::FontList font_list;
   std::vector<int> result(CalculateTableColumnSizes(
-      100, 0, font_list, font_list, 0, 0, columns, &model));
+      100, 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount));
   EXPECT_EQ("20,30", IntVectorToString(result));
 
   // Same with some padding, it should be ignored.
   result = CalculateTableColumnSizes(
-      100, 0, font_list, font_list, 2, 0, columns, &model);
+      100, 0, font_list, font_list, 2, 0, columns, &model,
+      kRowCount);
   EXPECT_EQ("20,30", IntVectorToString(result));
 
   // Same with not enough space, it shouldn't matter.
   result = CalculateTableColumnSizes(
-      10, 0, font_list, font_list, 2, 0, columns, &model);
+      10, 0, font_list, font_list, 2, 0, columns, &model,
+      kRowCount);
   EXPECT_EQ("20,30", IntVectorToString(result));
 }
 
 // Verifies if no size is specified the last column gets all the available
 // space.
 TEST(TableUtilsTest, LastColumnGetsAllSpace) {
-  TestTableModel model(4);
+  TestTableModel model(kRowCount);
   std::vector<TableColumn> columns;
   columns.push_back(ui::TableColumn());
   columns.push_back(ui::TableColumn());
   gfx::FontList font_list;
   std::vector<int> result(CalculateTableColumnSizes(
-      500, 0, font_list, font_list, 0, 0, columns, &model));
+      500, 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount));
   EXPECT_NE(0, result[0]);
   EXPECT_GE(result[1],
-            WidthForContent(font_list, font_list, 0, 0, columns[1], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[1], &model,
+                            kRowCount));
   EXPECT_EQ(500, result[0] + result[1]);
 }
 
 // Verifies a single column with a percent=1 is resized correctly.
 TEST(TableUtilsTest, SingleResizableColumn) {
-  TestTableModel model(4);
+  TestTableModel model(kRowCount);
   std::vector<TableColumn> columns;
   columns.push_back(ui::TableColumn());
   columns.push_back(ui::TableColumn());
@@ -82,43 +90,74 @@ TEST(TableUtilsTest, SingleResizableColumn) {
   columns[2].percent = 1.0f;
   gfx::FontList font_list;
   std::vector<int> result(CalculateTableColumnSizes(
-      500, 0, font_list, font_list, 0, 0, columns, &model));
+      500, 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount));
   EXPECT_EQ(result[0],
-            WidthForContent(font_list, font_list, 0, 0, columns[0], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[0], &model,
+                            kRowCount));
   EXPECT_EQ(result[1],
-            WidthForContent(font_list, font_list, 0, 0, columns[1], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[1], &model,
+                            kRowCount));
   EXPECT_EQ(500 - result[0] - result[1], result[2]);
 
   // The same with a slightly larger width passed in.
   result = CalculateTableColumnSizes(
-      1000, 0, font_list, font_list, 0, 0, columns, &model);
+      1000, 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount);
   EXPECT_EQ(result[0],
-            WidthForContent(font_list, font_list, 0, 0, columns[0], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[0], &model,
+                            kRowCount));
   EXPECT_EQ(result[1],
-            WidthForContent(font_list, font_list, 0, 0, columns[1], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[1], &model,
+                            kRowCount));
   EXPECT_EQ(1000 - result[0] - result[1], result[2]);
 
   // Verify padding for the first column is honored.
   result = CalculateTableColumnSizes(
-      1000, 10, font_list, font_list, 0, 0, columns, &model);
+      1000, 10, font_list, font_list, 0, 0, columns, &model,
+      kRowCount);
   EXPECT_EQ(result[0],
-            WidthForContent(font_list, font_list, 0, 0, columns[0], &model)
+            WidthForContent(font_list, font_list, 0, 0, columns[0], &model,
+                            kRowCount)
                 + 10);
   EXPECT_EQ(result[1],
-            WidthForContent(font_list, font_list, 0, 0, columns[1], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[1], &model,
+                            kRowCount));
   EXPECT_EQ(1000 - result[0] - result[1], result[2]);
 
   // Just enough space to show the first two columns. Should force last column
   // to min size.
   result = CalculateTableColumnSizes(
-      1000, 0, font_list, font_list, 0, 0, columns, &model);
+      1000, 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount);
   result = CalculateTableColumnSizes(
-      result[0] + result[1], 0, font_list, font_list, 0, 0, columns, &model);
+      result[0] + result[1], 0, font_list, font_list, 0, 0, columns, &model,
+      kRowCount);
   EXPECT_EQ(result[0],
-            WidthForContent(font_list, font_list, 0, 0, columns[0], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[0], &model,
+                            kRowCount));
   EXPECT_EQ(result[1],
-            WidthForContent(font_list, font_list, 0, 0, columns[1], &model));
+            WidthForContent(font_list, font_list, 0, 0, columns[1], &model,
+                            kRowCount));
   EXPECT_EQ(kUnspecifiedColumnWidth, result[2]);
 }
 
+// Verifies only the requested number of rows is measured for autosized
+// columns.
+TEST(TableUtilsTest, MaxRowsToMeasure) {
+  TestTableModel model(kRowCount);
+  ui::TableColumn column;
+  gfx::FontList font_list;
+  // With no rows measured only the (empty) header and padding contribute.
+  EXPECT_EQ(2, WidthForContent(font_list, font_list, 2, 0, column, &model, 0));
+  EXPECT_LT(WidthForContent(font_list, font_list, 2, 0, column, &model, 0),
+            WidthForContent(font_list, font_list, 2, 0, column, &model,
+                            kRowCount));
+  // Asking for more rows than the model has is the same as all rows.
+  EXPECT_EQ(WidthForContent(font_list, font_list, 2, 0, column, &model,
+                            kRowCount),
+            WidthForContent(font_list, font_list, 2, 0, column, &model,
+                            kRowCount * 2));
+}
+
 }  // namespace views
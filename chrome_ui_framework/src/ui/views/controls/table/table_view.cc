@@ -4,7 +4,7 @@
 
 #include "ui/views/controls/table/table_view.h"
 
-#include <map>
+#include <algorithm>
 
 #include "base/auto_reset.h"
 #include "base/i18n/rtl.h"
@@ -34,6 +34,13 @@ static const int kImageSize = 16;
 
 static const int kGroupingIndicatorSize = 6;
 
+// Maximum number of rows measured for autosized columns in virtualized mode.
+static const int kVirtualizedMaxRowsToMeasure = 1000;
+
+// Maximum number of rows added, removed or changed at once that are merged
+// into the existing sort mapping in virtualized mode. Larger changes resort.
+static const int kMaxIncrementalMappingUpdate = 256;
+
 namespace views {
 
 namespace {
@@ -46,7 +53,8 @@ int SwapCompareResult(int result, bool ascending) {
 // Populates |model_index_to_range_start| based on the |grouper|.
 void GetModelIndexToRangeStart(TableGrouper* grouper,
                                int row_count,
-                               std::map<int, int>* model_index_to_range_start) {
+                               std::vector<int>* model_index_to_range_start) {
+  model_index_to_range_start->resize(row_count);
   for (int model_index = 0; model_index < row_count;) {
     GroupRange range;
     grouper->GetGroupRange(model_index, &range);
@@ -78,7 +86,14 @@ struct TableView::SortHelper {
   explicit SortHelper(TableView* table) : table(table) {}
 
   bool operator()(int model_index1, int model_index2) {
-    return table->CompareRows(model_index1, model_index2) < 0;
+    const int result = table->CompareRows(model_index1, model_index2);
+    if (result != 0)
+      return result < 0;
+    // Rows that compare equal are ordered by model index, in the direction of
+    // the primary sort. This makes the order total, so that reversing it when
+    // the direction flips gives the same result as sorting again.
+    return table->sort_descriptors_[0].ascending ?
+        model_index1 < model_index2 : model_index1 > model_index2;
   }
 
   TableView* table;
@@ -102,7 +117,7 @@ struct TableView::GroupSortHelper {
   }
 
   TableView* table;
-  std::map<int, int> model_index_to_range_start;
+  std::vector<int> model_index_to_range_start;
 };
 
 TableView::VisibleColumn::VisibleColumn() : x(0), width(0) {}
@@ -135,7 +150,8 @@ TableView::TableView(ui::TableModel* model,
       last_parent_width_(0),
       layout_width_(0),
       grouper_(NULL),
-      in_set_visible_column_width_(false) {
+      in_set_visible_column_width_(false),
+      virtualized_(false) {
   for (size_t i = 0; i < columns.size(); ++i) {
     VisibleColumn visible_column;
     visible_column.column = columns[i];
@@ -183,6 +199,10 @@ void TableView::SetGrouper(TableGrouper* grouper) {
   SortItemsAndUpdateMapping();
 }
 
+void TableView::SetVirtualized(bool virtualized) {
+  virtualized_ = virtualized;
+}
+
 int TableView::RowCount() const {
   return model_ ? model_->RowCount() : 0;
 }
@@ -458,12 +478,24 @@ void TableView::OnModelChanged() {
 }
 
 void TableView::OnItemsChanged(int start, int length) {
+  if (CanUpdateMappingIncrementally(length)) {
+    RemoveRowsFromMapping(start, length, false);
+    InsertRowsIntoMapping(start, length, false);
+    SchedulePaint();
+    return;
+  }
   SortItemsAndUpdateMapping();
 }
 
 void TableView::OnItemsAdded(int start, int length) {
   for (int i = 0; i < length; ++i)
     selection_model_.IncrementFrom(start);
+  if (CanUpdateMappingIncrementally(length)) {
+    InsertRowsIntoMapping(start, length, true);
+    PreferredSizeChanged();
+    SchedulePaint();
+    return;
+  }
   NumRowsChanged();
 }
 
@@ -478,7 +510,13 @@ void TableView::OnItemsRemoved(int start, int length) {
         model_to_view_[previously_selected_model_index];
   for (int i = 0; i < length; ++i)
     selection_model_.DecrementFrom(start);
-  NumRowsChanged();
+  if (CanUpdateMappingIncrementally(length)) {
+    RemoveRowsFromMapping(start, length, true);
+    PreferredSizeChanged();
+    SchedulePaint();
+  } else {
+    NumRowsChanged();
+  }
   // If the selection was empty and is no longer empty select the same visual
   // index.
   if (selection_model_.empty() && previously_selected_view_index != -1 &&
@@ -635,8 +673,21 @@ void TableView::NumRowsChanged() {
 }
 
 void TableView::SetSortDescriptors(const SortDescriptors& sort_descriptors) {
+  // Flipping the direction of a single sorted column is a reversal of the
+  // current order, which in virtualized mode avoids comparing any rows.
+  const bool only_direction_changed =
+      sort_descriptors_.size() == 1 && sort_descriptors.size() == 1 &&
+      sort_descriptors_[0].column_id == sort_descriptors[0].column_id &&
+      sort_descriptors_[0].ascending != sort_descriptors[0].ascending;
   sort_descriptors_ = sort_descriptors;
-  SortItemsAndUpdateMapping();
+  if (virtualized_ && !grouper_ && only_direction_changed &&
+      static_cast<int>(view_to_model_.size()) == RowCount()) {
+    std::reverse(view_to_model_.begin(), view_to_model_.end());
+    UpdateModelToViewMapping();
+    SchedulePaint();
+  } else {
+    SortItemsAndUpdateMapping();
+  }
   if (header_)
     header_->SchedulePaint();
 }
@@ -659,13 +710,62 @@ void TableView::SortItemsAndUpdateMapping() {
     } else {
       std::sort(view_to_model_.begin(), view_to_model_.end(), SortHelper(this));
     }
-    for (int i = 0; i < row_count; ++i)
-      model_to_view_[view_to_model_[i]] = i;
+    UpdateModelToViewMapping();
     model_->ClearCollator();
   }
   SchedulePaint();
 }
 
+bool TableView::CanUpdateMappingIncrementally(int length) const {
+  return virtualized_ && is_sorted() && !grouper_ &&
+         length <= kMaxIncrementalMappingUpdate;
+}
+
+void TableView::InsertRowsIntoMapping(int start, int length,
+                                      bool shift_indices) {
+  if (shift_indices) {
+    for (int& model_index : view_to_model_) {
+      if (model_index >= start)
+        model_index += length;
+    }
+  }
+  SortHelper sort_helper(this);
+  for (int model_index = start; model_index < start + length; ++model_index) {
+    // SortHelper orders all rows, so there is exactly one insertion point.
+    view_to_model_.insert(
+        std::upper_bound(view_to_model_.begin(), view_to_model_.end(),
+                         model_index, sort_helper),
+        model_index);
+  }
+  DCHECK_EQ(RowCount(), static_cast<int>(view_to_model_.size()));
+  UpdateModelToViewMapping();
+  model_->ClearCollator();
+}
+
+void TableView::RemoveRowsFromMapping(int start, int length,
+                                      bool shift_indices) {
+  const int end = start + length;
+  view_to_model_.erase(
+      std::remove_if(view_to_model_.begin(), view_to_model_.end(),
+                     [start, end](int model_index) {
+                       return model_index >= start && model_index < end;
+                     }),
+      view_to_model_.end());
+  if (shift_indices) {
+    for (int& model_index : view_to_model_) {
+      if (model_index >= end)
+        model_index -= length;
+    }
+    UpdateModelToViewMapping();
+  }
+}
+
+void TableView::UpdateModelToViewMapping() {
+  model_to_view_.resize(view_to_model_.size());
+  for (size_t i = 0; i < view_to_model_.size(); ++i)
+    model_to_view_[view_to_model_[i]] = static_cast<int>(i);
+}
+
 int TableView::CompareRows(int model_row1, int model_row2) {
   const int sort_result = model_->CompareValues(
       model_row1, model_row2, sort_descriptors_[0].column_id);
@@ -727,10 +827,12 @@ void TableView::UpdateVisibleColumnSizes() {
   if (grouper_)
     first_column_padding += kGroupingIndicatorSize + kTextHorizontalPadding;
 
+  const int rows_to_measure = virtualized_ ?
+      std::min(RowCount(), kVirtualizedMaxRowsToMeasure) : RowCount();
   std::vector<int> sizes = views::CalculateTableColumnSizes(
       layout_width_, first_column_padding, header_->font_list(), font_list_,
       std::max(kTextHorizontalPadding, TableHeader::kHorizontalPadding) * 2,
-      TableHeader::kSortIndicatorWidth, columns, model_);
+      TableHeader::kSortIndicatorWidth, columns, model_, rows_to_measure);
   DCHECK_EQ(visible_columns_.size(), sizes.size());
   int x = 0;
   for (size_t i = 0; i < visible_columns_.size(); ++i) {
@@ -112,6 +112,15 @@ class VIEWS_EXPORT TableView
   // to have TableModel implement TableGrouper).
   void SetGrouper(TableGrouper* grouper);
 
+  // Enables the mode intended for very large models. When virtualized, adding,
+  // removing or changing a few rows of a sorted table updates the existing
+  // view <-> model mapping instead of resorting the whole model, reversing the
+  // sort direction reuses the existing order, and autosized columns are
+  // measured against a bounded number of rows rather than every row. Only the
+  // visible rows are ever painted, regardless of this setting.
+  void SetVirtualized(bool virtualized);
+  bool virtualized() const { return virtualized_; }
+
   // Returns the number of rows in the TableView.
   int RowCount() const;
 
@@ -229,6 +238,23 @@ class VIEWS_EXPORT TableView
   // |model_to_view_|) appropriately.
   void SortItemsAndUpdateMapping();
 
+  // Returns true if a change to |length| rows can be applied to the existing
+  // sorted mapping instead of resorting all rows.
+  bool CanUpdateMappingIncrementally(int length) const;
+
+  // Inserts the model rows [start, start + length) into the sorted mapping.
+  // If |shift_indices| is true the rows are new and the model indices at or
+  // after |start| that are already in the mapping are shifted to make room.
+  void InsertRowsIntoMapping(int start, int length, bool shift_indices);
+
+  // Removes the model rows [start, start + length) from the sorted mapping. If
+  // |shift_indices| is true the rows were removed from the model and the model
+  // indices after them are shifted down.
+  void RemoveRowsFromMapping(int start, int length, bool shift_indices);
+
+  // Rebuilds |model_to_view_| from |view_to_model_|.
+  void UpdateModelToViewMapping();
+
   // Used to sort the two rows. Returns a value < 0, == 0 or > 0 indicating
   // whether the row2 comes before row1, row2 is the same as row1 or row1 comes
   // after row2. This invokes CompareValues on the model with the sorted column.
@@ -346,6 +372,9 @@ class VIEWS_EXPORT TableView
   // True if in SetVisibleColumnWidth().
   bool in_set_visible_column_width_;
 
+  // See SetVirtualized().
+  bool virtualized_;
+
   DISALLOW_COPY_AND_ASSIGN(TableView);
 };
 
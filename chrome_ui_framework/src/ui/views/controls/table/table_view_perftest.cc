@@ -0,0 +1,193 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/views/controls/table/table_view.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/base/models/table_model_observer.h"
+#include "ui/gfx/canvas.h"
+
+namespace views {
+
+namespace {
+
+// Size of the visible area of the table, in pixels.
+const int kViewportWidth = 800;
+const int kViewportHeight = 600;
+
+// Number of scroll positions painted per run.
+const int kScrollSteps = 100;
+
+// Number of single row insertions per run.
+const int kInsertCount = 100;
+
+// A model whose rows are generated on demand so that only the table's own
+// per-row state contributes to memory use. Rows can be inserted, in which case
+// their values are kept in |inserted_|.
+class PerfTableModel : public ui::TableModel {
+ public:
+  explicit PerfTableModel(int row_count)
+      : row_count_(row_count), observer_(NULL) {}
+
+  // Inserts a row at |row| and notifies the observer.
+  void AddRow(int row) {
+    inserted_.insert(inserted_.begin() + InsertedIndexFor(row),
+                     std::make_pair(row, ValueForRow(row_count_ + row)));
+    ++row_count_;
+    if (observer_)
+      observer_->OnItemsAdded(row, 1);
+  }
+
+  // ui::TableModel:
+  int RowCount() override { return row_count_; }
+  base::string16 GetText(int row, int column_id) override {
+    return base::IntToString16(Value(row) + column_id);
+  }
+  void SetObserver(ui::TableModelObserver* observer) override {
+    observer_ = observer;
+  }
+  int CompareValues(int row1, int row2, int column_id) override {
+    const int value1 = Value(row1);
+    const int value2 = Value(row2);
+    return value1 < value2 ? -1 : (value1 == value2 ? 0 : 1);
+  }
+
+ private:
+  // A cheap, deterministic scramble so that sorting has real work to do.
+  static int ValueForRow(int row) {
+    return static_cast<int>((static_cast<uint32>(row) * 2654435761u) >> 8);
+  }
+
+  // Returns the position in |inserted_| for a row inserted at |row|.
+  size_t InsertedIndexFor(int row) {
+    size_t i = 0;
+    while (i < inserted_.size() && inserted_[i].first < row)
+      ++i;
+    // Shift the rows that move down by the insertion.
+    for (size_t j = i; j < inserted_.size(); ++j)
+      inserted_[j].first++;
+    return i;
+  }
+
+  int Value(int row) const {
+    int offset = 0;
+    for (const auto& inserted : inserted_) {
+      if (inserted.first == row)
+        return inserted.second;
+      if (inserted.first < row)
+        ++offset;
+    }
+    return ValueForRow(row - offset);
+  }
+
+  int row_count_;
+  std::vector<std::pair<int, int>> inserted_;
+  ui::TableModelObserver* observer_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfTableModel);
+};
+
+// Exposes OnPaint() so that painting can be timed without a widget.
+class PerfTableView : public TableView {
+ public:
+  PerfTableView(ui::TableModel* model,
+                const std::vector<ui::TableColumn>& columns)
+      : TableView(model, columns, TEXT_ONLY, false) {}
+
+  void PaintViewport(int y) {
+    gfx::Canvas canvas(gfx::Size(kViewportWidth, kViewportHeight), 1.0f,
+                       false);
+    canvas.Translate(gfx::Vector2d(0, -y));
+    canvas.ClipRect(gfx::Rect(0, y, kViewportWidth, kViewportHeight));
+    OnPaint(&canvas);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PerfTableView);
+};
+
+class TableViewPerfTest : public testing::TestWithParam<int> {
+ public:
+  TableViewPerfTest() : table_(NULL) {}
+
+  void SetUp() override {
+    model_.reset(new PerfTableModel(GetParam()));
+    std::vector<ui::TableColumn> columns(2);
+    columns[0].title = base::ASCIIToUTF16("Column 0");
+    columns[0].sortable = true;
+    columns[0].width = kViewportWidth / 2;
+    columns[1].title = base::ASCIIToUTF16("Column 1");
+    columns[1].id = 1;
+    columns[1].sortable = true;
+    columns[1].width = kViewportWidth / 2;
+    table_ = new PerfTableView(model_.get(), columns);
+    table_->SetVirtualized(true);
+    parent_.reset(table_->CreateParentIfNecessary());
+    parent_->SetBounds(0, 0, kViewportWidth, kViewportHeight);
+    parent_->Layout();
+  }
+
+  void TearDown() override {
+    parent_.reset();
+    model_.reset();
+  }
+
+  void PrintResult(const std::string& measurement, base::TimeDelta elapsed,
+                   int iterations) {
+    perf_test::PrintResult(
+        measurement, "", base::StringPrintf("rows_%d", GetParam()),
+        elapsed.InMillisecondsF() / iterations, "ms", true);
+  }
+
+ protected:
+  scoped_ptr<PerfTableModel> model_;
+  PerfTableView* table_;  // Owned by |parent_|.
+  scoped_ptr<View> parent_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TableViewPerfTest);
+};
+
+TEST_P(TableViewPerfTest, Scroll) {
+  table_->ToggleSortOrder(0);
+  const int max_y = std::max(0, table_->height() - kViewportHeight);
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kScrollSteps; ++i)
+    table_->PaintViewport(max_y / kScrollSteps * i);
+  PrintResult("table_view_scroll_paint", base::TimeTicks::Now() - start,
+              kScrollSteps);
+}
+
+TEST_P(TableViewPerfTest, Sort) {
+  base::TimeTicks start = base::TimeTicks::Now();
+  table_->ToggleSortOrder(0);
+  PrintResult("table_view_sort", base::TimeTicks::Now() - start, 1);
+
+  start = base::TimeTicks::Now();
+  table_->ToggleSortOrder(0);
+  PrintResult("table_view_sort_reverse", base::TimeTicks::Now() - start, 1);
+}
+
+TEST_P(TableViewPerfTest, Insert) {
+  table_->ToggleSortOrder(0);
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kInsertCount; ++i)
+    model_->AddRow((i * 7919) % model_->RowCount());
+  PrintResult("table_view_sorted_insert", base::TimeTicks::Now() - start,
+              kInsertCount);
+}
+
+INSTANTIATE_TEST_CASE_P(TableViewPerfTests,
+                        TableViewPerfTest,
+                        testing::Values(10000, 100000, 1000000));
+
+}  // namespace
+
+}  // namespace views
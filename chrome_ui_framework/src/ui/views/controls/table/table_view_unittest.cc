@@ -387,6 +387,85 @@ TEST_F(TableViewTest, Sort) {
   EXPECT_EQ("3 1 2 0", GetModelToViewAsString(table_));
 }
 
+// Verifies a virtualized table, which updates the sort mapping incrementally,
+// ends up with the same mappings as a full sort.
+TEST_F(TableViewTest, VirtualizedSort) {
+  table_->SetVirtualized(true);
+
+  table_->ToggleSortOrder(0);
+  EXPECT_EQ("0 1 2 3", GetViewToModelAsString(table_));
+  EXPECT_EQ("0 1 2 3", GetModelToViewAsString(table_));
+
+  // Inverting the sort reverses the existing order.
+  table_->ToggleSortOrder(0);
+  ASSERT_EQ(1u, table_->sort_descriptors().size());
+  EXPECT_FALSE(table_->sort_descriptors()[0].ascending);
+  EXPECT_EQ("3 2 1 0", GetViewToModelAsString(table_));
+  EXPECT_EQ("3 2 1 0", GetModelToViewAsString(table_));
+
+  // Change cell 0x3 to -1, meaning we have 0, 1, 2, -1 (in the first column).
+  model_->ChangeRow(3, -1, 0);
+  EXPECT_EQ("2 1 0 3", GetViewToModelAsString(table_));
+  EXPECT_EQ("2 1 0 3", GetModelToViewAsString(table_));
+
+  // Invert sort again (first column ascending).
+  table_->ToggleSortOrder(0);
+  EXPECT_TRUE(table_->sort_descriptors()[0].ascending);
+  EXPECT_EQ("3 0 1 2", GetViewToModelAsString(table_));
+  EXPECT_EQ("1 2 3 0", GetModelToViewAsString(table_));
+
+  // Add a row so that model has 0, 3, 1, 2, -1.
+  model_->AddRow(1, 3, 4);
+  EXPECT_EQ("4 0 2 3 1", GetViewToModelAsString(table_));
+  EXPECT_EQ("1 4 2 3 0", GetModelToViewAsString(table_));
+
+  // Delete the first row, ending up with 3, 1, 2, -1.
+  model_->RemoveRow(0);
+  EXPECT_EQ("3 1 2 0", GetViewToModelAsString(table_));
+  EXPECT_EQ("3 1 2 0", GetModelToViewAsString(table_));
+
+  // Sorting by a second column still does a full sort: 4, 1, 2, 0.
+  table_->ToggleSortOrder(1);
+  ASSERT_EQ(2u, table_->sort_descriptors().size());
+  EXPECT_EQ("3 1 2 0", GetViewToModelAsString(table_));
+  EXPECT_EQ("3 1 2 0", GetModelToViewAsString(table_));
+}
+
+// Verifies rows with equal keys end up in the same order whether a virtualized
+// table reverses its mapping or does a full sort.
+TEST_F(TableViewTest, VirtualizedSortWithTies) {
+  table_->SetVirtualized(true);
+
+  // The second column has 1, 1, 2, 0, so rows 0 and 1 tie.
+  table_->ToggleSortOrder(1);
+  EXPECT_EQ("3 0 1 2", GetViewToModelAsString(table_));
+  EXPECT_EQ("1 2 3 0", GetModelToViewAsString(table_));
+
+  // Ties are reversed along with everything else.
+  table_->ToggleSortOrder(1);
+  EXPECT_FALSE(table_->sort_descriptors()[0].ascending);
+  EXPECT_EQ("2 1 0 3", GetViewToModelAsString(table_));
+  EXPECT_EQ("2 1 0 3", GetModelToViewAsString(table_));
+
+  // Add a third tied row at the front, so the second column has 1, 1, 1, 2, 0.
+  model_->AddRow(0, 5, 1);
+  EXPECT_EQ("3 2 1 0 4", GetViewToModelAsString(table_));
+  EXPECT_EQ("3 2 1 0 4", GetModelToViewAsString(table_));
+
+  table_->ToggleSortOrder(1);
+  EXPECT_TRUE(table_->sort_descriptors()[0].ascending);
+  EXPECT_EQ("4 0 1 2 3", GetViewToModelAsString(table_));
+  EXPECT_EQ("1 2 3 4 0", GetModelToViewAsString(table_));
+
+  // Full sorts in both directions produce the same orders.
+  table_->SetVirtualized(false);
+  table_->ToggleSortOrder(1);
+  EXPECT_EQ("3 2 1 0 4", GetViewToModelAsString(table_));
+  table_->ToggleSortOrder(1);
+  EXPECT_EQ("4 0 1 2 3", GetViewToModelAsString(table_));
+  EXPECT_EQ("1 2 3 4 0", GetModelToViewAsString(table_));
+}
+
 // Verfies clicking on the header sorts.
 TEST_F(TableViewTest, SortOnMouse) {
   EXPECT_TRUE(table_->sort_descriptors().empty());
@@ -17,6 +17,7 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/trace_event/trace_event.h"
+#include "cc/base/rtree.h"
 #include "third_party/skia/include/core/SkRect.h"
 #include "ui/accessibility/ax_enums.h"
 #include "ui/base/cursor/cursor.h"
@@ -98,6 +99,7 @@ View::View()
       id_(0),
       group_(-1),
       parent_(NULL),
+      use_child_spatial_index_(false),
       visible_(true),
       enabled_(true),
       notify_enter_exit_on_child_(false),
@@ -176,6 +178,7 @@ void View::AddChildViewAt(View* view, int index) {
   // Let's insert the view.
   view->parent_ = this;
   children_.insert(children_.begin() + index, view);
+  child_spatial_index_.reset();
 
   views::Widget* widget = GetWidget();
   if (widget) {
@@ -233,6 +236,7 @@ void View::ReorderChildView(View* view, int index) {
   // Add it in the specified index now.
   InitFocusSiblings(view, index);
   children_.insert(children_.begin() + index, view);
+  child_spatial_index_.reset();
 
   ReorderLayers();
 }
@@ -260,6 +264,36 @@ int View::GetIndexOf(const View* view) const {
   return i != children_.end() ? static_cast<int>(i - children_.begin()) : -1;
 }
 
+void View::SetUseChildSpatialIndex(bool use_child_spatial_index) {
+  use_child_spatial_index_ = use_child_spatial_index;
+  child_spatial_index_.reset();
+}
+
+bool View::GetChildIndicesInRect(const gfx::Rect& rect,
+                                 std::vector<int>* indices) {
+  if (!use_child_spatial_index_)
+    return false;
+
+  if (!child_spatial_index_) {
+    child_spatial_index_.reset(new cc::RTree);
+    child_spatial_index_->Build(children_, [this](const View* child) {
+      gfx::RectF bounds(child->GetLocalBounds());
+      ConvertRectToTarget(child, this, &bounds);
+      return bounds;
+    });
+  }
+
+  // The query must not be empty to intersect anything.
+  gfx::RectF query(rect);
+  query.set_width(std::max(query.width(), 1.f));
+  query.set_height(std::max(query.height(), 1.f));
+  std::vector<size_t> results;
+  child_spatial_index_->Search(query, &results);
+  std::sort(results.begin(), results.end());
+  indices->assign(results.begin(), results.end());
+  return true;
+}
+
 // Size and disposition --------------------------------------------------------
 
 void View::SetBounds(int x, int y, int width, int height) {
@@ -440,6 +474,9 @@ gfx::Transform View::GetTransform() const {
 }
 
 void View::SetTransform(const gfx::Transform& transform) {
+  if (parent_)
+    parent_->child_spatial_index_.reset();
+
   if (transform.IsIdentity()) {
     if (layer()) {
       layer()->SetTransform(transform);
@@ -867,8 +904,13 @@ View* View::GetTooltipHandlerForPoint(const gfx::Point& point) {
 
   // Walk the child Views recursively looking for the View that most
   // tightly encloses the specified point.
-  for (int i = child_count() - 1; i >= 0; --i) {
-    View* child = child_at(i);
+  std::vector<int> child_indices;
+  const bool use_index = GetChildIndicesInRect(
+      gfx::Rect(point, gfx::Size(1, 1)), &child_indices);
+  const int candidate_count =
+      use_index ? static_cast<int>(child_indices.size()) : child_count();
+  for (int i = candidate_count - 1; i >= 0; --i) {
+    View* child = child_at(use_index ? child_indices[i] : i);
     if (!child->visible())
       continue;
 
@@ -1776,6 +1818,7 @@ void View::DoRemoveChildView(View* view,
       view_to_be_deleted.reset(view);
 
     children_.erase(i);
+    child_spatial_index_.reset();
   }
 
   if (update_tool_tip)
@@ -1859,6 +1902,12 @@ void View::VisibilityChangedImpl(View* starting_from, bool is_visible) {
 }
 
 void View::BoundsChanged(const gfx::Rect& previous_bounds) {
+  if (parent_)
+    parent_->child_spatial_index_.reset();
+  // In RTL mode the children are mirrored against our width.
+  if (bounds_.width() != previous_bounds.width())
+    child_spatial_index_.reset();
+
   if (visible_) {
     // Paint the new bounds.
     SchedulePaintBoundsChanged(
@@ -40,6 +40,10 @@
 
 using ui::OSExchangeData;
 
+namespace cc {
+class RTree;
+}
+
 namespace gfx {
 class Canvas;
 class Insets;
@@ -195,6 +199,22 @@ class VIEWS_EXPORT View : public ui::LayerDelegate,
   // Returns the index of |view|, or -1 if |view| is not a child of this view.
   int GetIndexOf(const View* view) const;
 
+  // Enables a spatial index over the bounds of the children, so that
+  // hit-testing only looks at the children under the event rather than at all
+  // of them. Worth it for views with thousands of children, such as long
+  // lists. The index is rebuilt on the next lookup after a child is added,
+  // removed, reordered, moved or transformed. It assumes that children only
+  // handle events within their bounds and that their transforms are only
+  // changed through SetTransform().
+  void SetUseChildSpatialIndex(bool use_child_spatial_index);
+  bool use_child_spatial_index() const { return use_child_spatial_index_; }
+
+  // If the child spatial index is in use, sets |indices| to the indices of the
+  // children whose bounds intersect |rect|, in increasing order, and returns
+  // true. Returns false otherwise. |rect| is in the local coordinate space of
+  // |this|.
+  bool GetChildIndicesInRect(const gfx::Rect& rect, std::vector<int>* indices);
+
   // Size and disposition ------------------------------------------------------
   // Methods for obtaining and modifying the position and size of the view.
   // Position is in the coordinate system of the view's parent.
@@ -1445,6 +1465,13 @@ class VIEWS_EXPORT View : public ui::LayerDelegate,
   // This view's children.
   Views children_;
 
+  // Whether |child_spatial_index_| is used for hit-testing.
+  bool use_child_spatial_index_;
+
+  // Index over the bounds of the children in this view's coordinates. NULL
+  // when it needs to be rebuilt.
+  scoped_ptr<cc::RTree> child_spatial_index_;
+
   // Size and disposition ------------------------------------------------------
 
   // This View's bounds in the parent coordinate system.
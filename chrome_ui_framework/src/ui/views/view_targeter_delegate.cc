@@ -4,6 +4,8 @@
 
 #include "ui/views/view_targeter_delegate.h"
 
+#include <vector>
+
 #include "ui/gfx/geometry/rect_conversions.h"
 #include "ui/views/rect_based_targeting_utils.h"
 #include "ui/views/view.h"
@@ -40,8 +42,13 @@ View* ViewTargeterDelegate::TargetForRect(View* root, const gfx::Rect& rect) {
   // from this function call if point-based targeting were used.
   View* point_view = NULL;
 
-  for (int i = root->child_count() - 1; i >= 0; --i) {
-    View* child = root->child_at(i);
+  // With a spatial index, only the children under |rect| are candidates.
+  std::vector<int> child_indices;
+  const bool use_index = root->GetChildIndicesInRect(rect, &child_indices);
+  const int candidate_count =
+      use_index ? static_cast<int>(child_indices.size()) : root->child_count();
+  for (int i = candidate_count - 1; i >= 0; --i) {
+    View* child = root->child_at(use_index ? child_indices[i] : i);
 
     if (!child->CanProcessEventsWithinSubtree())
       continue;
@@ -0,0 +1,109 @@
+// Copyright 2015 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ui/views/view_targeter.h"
+
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/views/test/views_test_base.h"
+#include "ui/views/view.h"
+#include "ui/views/widget/widget.h"
+
+namespace views {
+
+namespace {
+
+// Size of each row of the list.
+const int kRowWidth = 400;
+const int kRowHeight = 20;
+
+// Number of hit tests per run, spread over the whole list.
+const int kHitTestCount = 10000;
+
+// Times hit-testing a list of rows, as mouse moves over a long list panel do,
+// with and without the child spatial index. The parameter is the number of
+// rows.
+class ViewTargeterPerfTest : public ViewsTestBase,
+                             public testing::WithParamInterface<int> {
+ public:
+  ViewTargeterPerfTest() : widget_(NULL), list_(NULL) {}
+
+  void SetUp() override {
+    ViewsTestBase::SetUp();
+
+    // Rows are inserted at the front, since appending has to look for the
+    // end of the focus chain.
+    list_ = new View;
+    list_->SetBounds(0, 0, kRowWidth, GetParam() * kRowHeight);
+    for (int i = GetParam() - 1; i >= 0; --i) {
+      View* row = new View;
+      row->SetBounds(0, i * kRowHeight, kRowWidth, kRowHeight);
+      list_->AddChildViewAt(row, 0);
+    }
+
+    widget_ = new Widget;
+    Widget::InitParams params = CreateParams(Widget::InitParams::TYPE_POPUP);
+    params.bounds = gfx::Rect(0, 0, kRowWidth, 600);
+    widget_->Init(params);
+    widget_->GetRootView()->AddChildView(list_);
+  }
+
+  void TearDown() override {
+    widget_->CloseNow();
+    ViewsTestBase::TearDown();
+  }
+
+ protected:
+  // Hit tests points spread over the list and prints the average time.
+  void RunHitTests(const std::string& trace) {
+    const int list_height = list_->height();
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kHitTestCount; ++i) {
+      // A stride coprime with the row count visits rows in scattered order.
+      gfx::Point point(i % kRowWidth,
+                       static_cast<int>((i * 7919LL) % list_height));
+      View* target = list_->GetEventHandlerForPoint(point);
+      ASSERT_EQ(list_->child_at(point.y() / kRowHeight), target);
+    }
+    perf_test::PrintResult(
+        "view_hit_test", base::StringPrintf("children_%d", GetParam()), trace,
+        (base::TimeTicks::Now() - start).InMillisecondsF() * 1000 /
+            kHitTestCount,
+        "us", true);
+  }
+
+  Widget* widget_;
+  View* list_;  // Owned by |widget_|.
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ViewTargeterPerfTest);
+};
+
+TEST_P(ViewTargeterPerfTest, HitTest) {
+  RunHitTests("linear");
+
+  list_->SetUseChildSpatialIndex(true);
+  base::TimeTicks start = base::TimeTicks::Now();
+  std::vector<int> indices;
+  list_->GetChildIndicesInRect(gfx::Rect(0, 0, 1, 1), &indices);
+  perf_test::PrintResult("view_spatial_index_build", "",
+                         base::StringPrintf("children_%d", GetParam()),
+                         (base::TimeTicks::Now() - start).InMillisecondsF(),
+                         "ms", true);
+
+  RunHitTests("spatial_index");
+}
+
+INSTANTIATE_TEST_CASE_P(ViewTargeterPerfTests,
+                        ViewTargeterPerfTest,
+                        testing::Values(1000, 10000, 100000));
+
+}  // namespace
+
+}  // namespace views
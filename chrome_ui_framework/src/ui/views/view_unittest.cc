@@ -3130,6 +3130,87 @@ TEST_F(ViewTest, GetIndexOf) {
   EXPECT_EQ(-1, child2->GetIndexOf(foo1));
 }
 
+// Verifies that hit-testing through the child spatial index finds the same
+// views as the linear walk, and that the index follows changes to the
+// children.
+TEST_F(ViewTest, ChildSpatialIndex) {
+  Widget* widget = new Widget;
+  Widget::InitParams params = CreateParams(Widget::InitParams::TYPE_POPUP);
+  widget->Init(params);
+  View* root_view = widget->GetRootView();
+  root_view->SetBoundsRect(gfx::Rect(0, 0, 500, 500));
+
+  View* list = new View;
+  list->SetBoundsRect(gfx::Rect(0, 0, 200, 200));
+  root_view->AddChildView(list);
+
+  // A 10x10 grid of 20x20 cells, and a view on top straddling four cells.
+  for (int i = 0; i < 100; ++i) {
+    View* cell = new View;
+    cell->SetBounds((i % 10) * 20, (i / 10) * 20, 20, 20);
+    list->AddChildView(cell);
+  }
+  View* overlay = new View;
+  overlay->SetBounds(30, 30, 20, 20);
+  list->AddChildView(overlay);
+
+  std::vector<int> indices;
+  EXPECT_FALSE(list->GetChildIndicesInRect(gfx::Rect(0, 0, 1, 1), &indices));
+
+  const gfx::Point points[] = {gfx::Point(5, 5),     gfx::Point(35, 35),
+                               gfx::Point(45, 25),   gfx::Point(199, 199),
+                               gfx::Point(100, 100), gfx::Point(39, 39)};
+  std::vector<View*> expected;
+  for (const gfx::Point& point : points)
+    expected.push_back(list->GetEventHandlerForPoint(point));
+  EXPECT_EQ(overlay, expected[1]);
+
+  list->SetUseChildSpatialIndex(true);
+  for (size_t i = 0; i < arraysize(points); ++i) {
+    EXPECT_EQ(expected[i], list->GetEventHandlerForPoint(points[i]));
+    EXPECT_EQ(expected[i], list->GetTooltipHandlerForPoint(points[i]));
+  }
+
+  ASSERT_TRUE(list->GetChildIndicesInRect(gfx::Rect(35, 35, 1, 1), &indices));
+  ASSERT_EQ(2u, indices.size());
+  EXPECT_EQ(11, indices[0]);
+  EXPECT_EQ(100, indices[1]);
+  ASSERT_TRUE(list->GetChildIndicesInRect(gfx::Rect(10, 10, 20, 1), &indices));
+  ASSERT_EQ(2u, indices.size());
+  EXPECT_EQ(0, indices[0]);
+  EXPECT_EQ(1, indices[1]);
+
+  // Moving a child is picked up.
+  overlay->SetBounds(150, 150, 20, 20);
+  EXPECT_EQ(list->child_at(11), list->GetEventHandlerForPoint(points[1]));
+  EXPECT_EQ(overlay, list->GetEventHandlerForPoint(gfx::Point(155, 155)));
+
+  // So is reordering, which changes which child is on top.
+  list->ReorderChildView(overlay, 0);
+  EXPECT_EQ(list->child_at(89),
+            list->GetEventHandlerForPoint(gfx::Point(165, 165)));
+
+  // Hidden children are skipped, and removed ones are gone from the index.
+  list->child_at(1)->SetVisible(false);
+  EXPECT_EQ(list, list->GetEventHandlerForPoint(gfx::Point(5, 5)));
+  list->RemoveChildView(overlay);
+  delete overlay;
+  EXPECT_EQ(list->child_at(88),
+            list->GetEventHandlerForPoint(gfx::Point(165, 165)));
+  EXPECT_EQ(list->child_at(1),
+            list->GetEventHandlerForPoint(gfx::Point(25, 5)));
+
+  // Transforms of the children are taken into account.
+  gfx::Transform transform;
+  transform.Translate(300, 0);
+  list->child_at(2)->SetTransform(transform);
+  EXPECT_EQ(list, list->GetEventHandlerForPoint(gfx::Point(45, 5)));
+  EXPECT_EQ(list->child_at(2),
+            list->GetEventHandlerForPoint(gfx::Point(345, 5)));
+
+  widget->CloseNow();
+}
+
 // Verifies that the child views can be reordered correctly.
 TEST_F(ViewTest, ReorderChildren) {
   View root;
@@ -601,6 +601,11 @@
       'view_unittest_aura.cc',
       'widget/native_widget_aura_unittest.cc',
     ],
+    'views_perftests_sources': [
+      'controls/table/table_view_perftest.cc',
+      'run_all_unittests.cc',
+      'view_targeter_perftest.cc',
+    ],
     'views_unittests_desktop_aura_sources': [
       'widget/desktop_aura/desktop_focus_rules_unittest.cc',
       'widget/desktop_aura/desktop_native_widget_aura_unittest.cc',
@@ -620,6 +625,7 @@
         '../../base/base.gyp:base',
         '../../base/base.gyp:base_i18n',
         '../../base/third_party/dynamic_annotations/dynamic_annotations.gyp:dynamic_annotations',
+        '../../cc/cc.gyp:cc',
         '../../skia/skia.gyp:skia',
         '../../third_party/icu/icu.gyp:icui18n',
         '../../third_party/icu/icu.gyp:icuuc',
@@ -925,6 +931,41 @@
         }],
       ],
     },  # target_name: views_unittests
+    {
+      # GN version: //ui/views:views_perftests
+      'target_name': 'views_perftests',
+      'type': 'executable',
+      'dependencies': [
+        '../../base/base.gyp:base',
+        '../../base/base.gyp:test_support_base',
+        '../../skia/skia.gyp:skia',
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        '../base/ui_base.gyp:ui_base',
+        '../base/ui_base.gyp:ui_base_test_support',
+        '../compositor/compositor.gyp:compositor',
+        '../gfx/gfx.gyp:gfx',
+        '../gfx/gfx.gyp:gfx_geometry',
+        '../resources/ui_resources.gyp:ui_resources',
+        '../resources/ui_resources.gyp:ui_test_pak',
+        '../strings/ui_strings.gyp:ui_strings',
+        'views',
+        'views_test_support',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        '<@(views_perftests_sources)',
+      ],
+      'conditions': [
+        ['use_aura==1', {
+          'dependencies': [
+            '../aura/aura.gyp:aura',
+          ],
+        }],
+      ],
+    },  # target_name: views_perftests
   ],  # targets
   'conditions': [
     ['OS=="mac"', {